@@ -12,6 +12,43 @@ namespace irr
 {
 namespace scene
 {
+	//! Decoded attributes of a quantized vertex
+	struct SDecodedQuantizedVertex
+	{
+		core::vector3df Pos;
+		core::vector3df Normal;
+		core::vector2df TCoords;
+	};
+
+	//! A few decoded attributes of quantized vertices
+	/** Quantized vertices have no float values to return references to, so
+	the vertex accessors of mesh buffers decode into these slots, which are
+	reused after Count more calls. The slots are only allocated on first use
+	and not copied with the buffer. */
+	class SDecodedQuantizedValues
+	{
+	public:
+		enum { Count = 16 };
+
+		SDecodedQuantizedValues() : Values(0), Next(0) {}
+		SDecodedQuantizedValues(const SDecodedQuantizedValues&) : Values(0), Next(0) {}
+		~SDecodedQuantizedValues() { delete [] Values; }
+		SDecodedQuantizedValues& operator=(const SDecodedQuantizedValues&) { return *this; }
+
+		//! Returns the slot for the next decoded value
+		SDecodedQuantizedVertex& next()
+		{
+			if (!Values)
+				Values = new SDecodedQuantizedVertex[Count];
+			Next = (Next + 1) % Count;
+			return Values[Next];
+		}
+
+	private:
+		SDecodedQuantizedVertex* Values;
+		u32 Next;
+	};
+
 	//! Template implementation of the IMeshBuffer interface
 	template <class T>
 	class CMeshBuffer : public IMeshBuffer
@@ -140,6 +177,12 @@ namespace scene
 			return T().getType();
 		}
 
+		//! Get the scale and offset of the positions of quantized vertices.
+		virtual video::SVertexQuantization getVertexQuantization() const
+		{
+			return Quantization;
+		}
+
 		//! returns position of vertex i
 		virtual const core::vector3df& getPosition(u32 i) const
 		{
@@ -303,14 +346,100 @@ namespace scene
 		core::aabbox3d<f32> BoundingBox;
 		//! Primitive type used for rendering (triangles, lines, ...)
 		E_PRIMITIVE_TYPE PrimitiveType;
+		//! Scale and offset of the positions, only used by quantized vertices
+		video::SVertexQuantization Quantization;
+
+	private:
+
+		//! Slots for the vertex accessors of quantized vertices
+		mutable SDecodedQuantizedValues DecodedValues;
 	};
 
+	// Quantized vertices have no float values to return references to, so
+	// the accessors of CMeshBuffer decode into a few slots of the buffer.
+	// Quantized vertices can't be changed through these references.
+#define _IRR_QUANTIZED_MESH_BUFFER_(VertexType) \
+	template <> \
+	inline const core::vector3df& CMeshBuffer<VertexType>::getPosition(u32 i) const \
+	{ \
+		return DecodedValues.next().Pos = Vertices[i].getPosition(Quantization); \
+	} \
+	template <> \
+	inline core::vector3df& CMeshBuffer<VertexType>::getPosition(u32 i) \
+	{ \
+		_IRR_DEBUG_BREAK_IF(true) \
+		return DecodedValues.next().Pos = Vertices[i].getPosition(Quantization); \
+	} \
+	template <> \
+	inline const core::vector3df& CMeshBuffer<VertexType>::getNormal(u32 i) const \
+	{ \
+		return DecodedValues.next().Normal = Vertices[i].getNormal(); \
+	} \
+	template <> \
+	inline core::vector3df& CMeshBuffer<VertexType>::getNormal(u32 i) \
+	{ \
+		_IRR_DEBUG_BREAK_IF(true) \
+		return DecodedValues.next().Normal = Vertices[i].getNormal(); \
+	} \
+	template <> \
+	inline const core::vector2df& CMeshBuffer<VertexType>::getTCoords(u32 i) const \
+	{ \
+		return DecodedValues.next().TCoords = Vertices[i].getTCoords(); \
+	} \
+	template <> \
+	inline core::vector2df& CMeshBuffer<VertexType>::getTCoords(u32 i) \
+	{ \
+		_IRR_DEBUG_BREAK_IF(true) \
+		return DecodedValues.next().TCoords = Vertices[i].getTCoords(); \
+	} \
+	template <> \
+	inline void CMeshBuffer<VertexType>::recalculateBoundingBox() \
+	{ \
+		if (!Vertices.empty()) \
+		{ \
+			BoundingBox.reset(Vertices[0].getPosition(Quantization)); \
+			for (u32 i=1; i<Vertices.size(); ++i) \
+				BoundingBox.addInternalPoint(Vertices[i].getPosition(Quantization)); \
+		} \
+		else \
+			BoundingBox.reset(0,0,0); \
+	} \
+	template <> \
+	inline void CMeshBuffer<VertexType>::append(const void* const vertices, u32 numVertices, const u16* const indices, u32 numIndices) \
+	{ \
+		if (vertices == getVertices()) \
+			return; \
+		const u32 vertexCount = getVertexCount(); \
+		u32 i; \
+		Vertices.reallocate(vertexCount+numVertices); \
+		for (i=0; i<numVertices; ++i) \
+		{ \
+			Vertices.push_back(reinterpret_cast<const VertexType*>(vertices)[i]); \
+			BoundingBox.addInternalPoint(Vertices.getLast().getPosition(Quantization)); \
+		} \
+		Indices.reallocate(getIndexCount()+numIndices); \
+		for (i=0; i<numIndices; ++i) \
+			Indices.push_back(indices[i]+vertexCount); \
+	}
+
+	_IRR_QUANTIZED_MESH_BUFFER_(video::S3DVertexQuantized)
+	_IRR_QUANTIZED_MESH_BUFFER_(video::S3DVertexQuantizedTangents)
+#undef _IRR_QUANTIZED_MESH_BUFFER_
+
 	//! Standard meshbuffer
 	typedef CMeshBuffer<video::S3DVertex> SMeshBuffer;
 	//! Meshbuffer with two texture coords per vertex, e.g. for lightmaps
 	typedef CMeshBuffer<video::S3DVertex2TCoords> SMeshBufferLightMap;
 	//! Meshbuffer with vertices having tangents stored, e.g. for normal mapping
 	typedef CMeshBuffer<video::S3DVertexTangents> SMeshBufferTangents;
+	//! Meshbuffer with quantized vertices, which need less memory
+	/** The positions are decoded with the Quantization member, which has
+	to be set before adding vertices. getPosition(), getNormal() and
+	getTCoords() return decoded copies, so only their const versions may
+	be used. Call setDirty() after changing the vertices directly. */
+	typedef CMeshBuffer<video::S3DVertexQuantized> SMeshBufferQuantized;
+	//! Meshbuffer with quantized vertices having tangents stored
+	typedef CMeshBuffer<video::S3DVertexQuantizedTangents> SMeshBufferQuantizedTangents;
 } // end namespace scene
 } // end namespace irr
 
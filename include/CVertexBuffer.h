@@ -116,6 +116,18 @@ namespace scene
 					NewVertices=new CSpecificVertexList<video::S3DVertexTangents>;
 					break;
 				}
+				case video::EVT_QUANTIZED:
+				case video::EVT_QUANTIZED_TANGENTS:
+				{
+					// quantized vertices need a quantization, which this buffer
+					// can't store. Keep the current vertices, or fall back to
+					// standard vertices so that the buffer stays usable.
+					_IRR_DEBUG_BREAK_IF(true);
+					if (Vertices)
+						return;
+					NewVertices=new CSpecificVertexList<video::S3DVertex>;
+					break;
+				}
 			}
 			if (Vertices)
 			{
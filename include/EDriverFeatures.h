@@ -139,6 +139,9 @@ namespace video
 		//! Support for cube map textures.
 		EVDF_TEXTURE_CUBEMAP,
 
+		//! Supports textured points with scene::EPT_POINT_SPRITES
+		EVDF_POINT_SPRITES,
+
 		//! Only used for counting the elements of this enum
 		EVDF_COUNT
 	};
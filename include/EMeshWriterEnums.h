@@ -34,7 +34,10 @@ namespace scene
 		EMWT_PLY          = MAKE_IRR_ID('p','l','y',0),
 		
 		//! B3D mesh writer, for static .b3d files
-		EMWT_B3D          = MAKE_IRR_ID('b', '3', 'd', 0)
+		EMWT_B3D          = MAKE_IRR_ID('b', '3', 'd', 0),
+
+		//! Binary Irrlicht mesh writer, for static and skinned .irrbmesh files
+		EMWT_IRR_BINARY_MESH = MAKE_IRR_ID('i','r','b','m')
 	};
 
 
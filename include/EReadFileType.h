@@ -0,0 +1,38 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#ifndef __E_READ_FILE_TYPES_H_INCLUDED__
+#define __E_READ_FILE_TYPES_H_INCLUDED__
+
+#include "irrTypes.h"
+
+namespace irr
+{
+namespace io
+{
+
+	//! An enumeration for different class types implementing IReadFile
+	enum EREAD_FILE_TYPE
+	{
+		//! CReadFile, a file on disk
+		ERFT_READ_FILE = MAKE_IRR_ID('r','e','a','d'),
+
+		//! CMemoryReadFile, a block of memory used like a file
+		ERFT_MEMORY_READ_FILE = MAKE_IRR_ID('r','m','e','m'),
+
+		//! CLimitReadFile, a part of another file like a file inside an archive
+		ERFT_LIMIT_READ_FILE = MAKE_IRR_ID('r','l','i','m'),
+
+		//! CMappedReadFile, a file on disk mapped into memory
+		ERFT_MAPPED_READ_FILE = MAKE_IRR_ID('r','m','a','p'),
+
+		//! Unknown type
+		EFIT_UNKNOWN = MAKE_IRR_ID('u','n','k','n')
+	};
+
+} // end namespace io
+} // end namespace irr
+
+
+#endif // __E_READ_FILE_TYPES_H_INCLUDED__
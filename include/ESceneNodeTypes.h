@@ -39,6 +39,9 @@ namespace scene
 		//! Terrain Scene Node
 		ESNT_TERRAIN        = MAKE_IRR_ID('t','e','r','r'),
 
+		//! Paged Terrain Scene Node
+		ESNT_PAGED_TERRAIN  = MAKE_IRR_ID('p','t','e','r'),
+
 		//! Sky Box Scene Node
 		ESNT_SKY_BOX        = MAKE_IRR_ID('s','k','y','_'),
 
@@ -54,6 +57,15 @@ namespace scene
 		//! Mesh Scene Node
 		ESNT_MESH           = MAKE_IRR_ID('m','e','s','h'),
 
+		//! Level of Detail Scene Node
+		ESNT_LOD            = MAKE_IRR_ID('l','o','d','_'),
+
+		//! Batched Mesh Scene Node
+		ESNT_BATCHED_MESH   = MAKE_IRR_ID('b','m','s','h'),
+
+		//! Clustered Mesh Scene Node
+		ESNT_CLUSTERED_MESH = MAKE_IRR_ID('c','m','s','h'),
+
 		//! Light Scene Node
 		ESNT_LIGHT          = MAKE_IRR_ID('l','g','h','t'),
 
@@ -78,6 +90,9 @@ namespace scene
 		//! Quake3 Shader Scene Node
 		ESNT_Q3SHADER_SCENE_NODE  = MAKE_IRR_ID('q','3','s','h'),
 
+		//! Quake3 Level Scene Node
+		ESNT_Q3LEVEL_SCENE_NODE  = MAKE_IRR_ID('q','3','l','v'),
+
 		//! Quake3 Model Scene Node ( has tag to link to )
 		ESNT_MD3_SCENE_NODE  = MAKE_IRR_ID('m','d','3','_'),
 
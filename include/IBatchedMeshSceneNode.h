@@ -0,0 +1,59 @@
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#ifndef __I_BATCHED_MESH_SCENE_NODE_H_INCLUDED__
+#define __I_BATCHED_MESH_SCENE_NODE_H_INCLUDED__
+
+#include "ISceneNode.h"
+
+namespace irr
+{
+namespace scene
+{
+	class IMesh;
+
+	//! Scene node which draws the geometry of many static mesh scene nodes with few draw calls.
+	/** The mesh buffers of the batched nodes are transformed into the space
+	of the batch node and merged by material into large mesh buffers, called
+	chunks. Each chunk has its own bounding box and is culled against the view
+	frustum separately, so chunks are built from nodes lying close together.
+	The batched nodes stay in the scene graph, but don't draw their meshes
+	anymore, see IMeshSceneNode::setMeshVisible(). Their children are still
+	rendered. Changes to the batched nodes have no effect on the batch anymore.
+	When the batched nodes have triangle selectors, the batch node gets a
+	selector which reports the original nodes for collisions, so picking with
+	ISceneCollisionManager still returns them.
+	Create it with ISceneManager::addBatchedMeshSceneNode(). */
+	class IBatchedMeshSceneNode : public ISceneNode
+	{
+	public:
+
+		//! Constructor
+		IBatchedMeshSceneNode(ISceneNode* parent, ISceneManager* mgr, s32 id)
+			: ISceneNode(parent, mgr, id) {}
+
+		//! Returns the mesh with one mesh buffer for each chunk
+		virtual IMesh* getMesh() const = 0;
+
+		//! Returns the number of nodes in the batch
+		virtual u32 getSourceNodeCount() const = 0;
+
+		//! Returns a node of the batch
+		virtual ISceneNode* getSourceNode(u32 index) const = 0;
+
+		//! Returns the node a triangle of a chunk was created from
+		/** \param chunk Index of the chunk, which is the index of its mesh
+		buffer in getMesh().
+		\param triangle Index of the triangle in the index list of the chunk.
+		\return The node, or 0 if chunk or triangle are out of range. */
+		virtual ISceneNode* getSourceNode(u32 chunk, u32 triangle) const = 0;
+
+		//! Returns the number of chunks which were inside the view frustum the last time the node was drawn
+		virtual u32 getVisibleChunkCount() const = 0;
+	};
+
+} // end namespace scene
+} // end namespace irr
+
+#endif
+
@@ -0,0 +1,53 @@
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#ifndef __I_CLUSTERED_MESH_SCENE_NODE_H_INCLUDED__
+#define __I_CLUSTERED_MESH_SCENE_NODE_H_INCLUDED__
+
+#include "ISceneNode.h"
+#include "SMeshCluster.h"
+
+namespace irr
+{
+namespace scene
+{
+	class IMesh;
+
+	//! Scene node which culls small clusters of triangles of a static mesh separately.
+	/** The mesh is split into clusters with
+	IMeshManipulator::createClusteredMesh(). Each time the node is drawn, the
+	bounding spheres of the clusters are tested against the view frustum,
+	and clusters whose triangles all face away from the camera are skipped
+	for materials with backface culling. The remaining clusters of a mesh
+	buffer are drawn with one call, so drivers which transform and clip each
+	triangle themselves get far fewer of them.
+	Create it with ISceneManager::addClusteredMeshSceneNode(). */
+	class IClusteredMeshSceneNode : public ISceneNode
+	{
+	public:
+
+		//! Constructor
+		IClusteredMeshSceneNode(ISceneNode* parent, ISceneManager* mgr, s32 id,
+			const core::vector3df& position = core::vector3df(0,0,0),
+			const core::vector3df& rotation = core::vector3df(0,0,0),
+			const core::vector3df& scale = core::vector3df(1.0f, 1.0f, 1.0f))
+			: ISceneNode(parent, mgr, id, position, rotation, scale) {}
+
+		//! Returns the clustered mesh
+		virtual IMesh* getMesh() const = 0;
+
+		//! Returns the clusters of all mesh buffers
+		virtual const core::array<SMeshCluster>& getClusters() const = 0;
+
+		//! Returns the number of clusters which were drawn the last time the node was rendered
+		virtual u32 getVisibleClusterCount() const = 0;
+
+		//! Returns the number of triangles which were drawn the last time the node was rendered
+		/** This includes the triangles of mesh buffers without clusters. */
+		virtual u32 getVisibleTriangleCount() const = 0;
+	};
+
+} // end namespace scene
+} // end namespace irr
+
+#endif
@@ -0,0 +1,70 @@
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#ifndef __I_LOD_SCENE_NODE_H_INCLUDED__
+#define __I_LOD_SCENE_NODE_H_INCLUDED__
+
+#include "ISceneNode.h"
+
+namespace irr
+{
+namespace scene
+{
+	class IMesh;
+
+	//! Scene node which draws one of several meshes depending on its size on the screen.
+	/** Each level of detail is a mesh together with the smallest screen
+	size it is used for. The screen size is the diameter of the bounding
+	sphere of the node divided by the height of the view, so 1 means the
+	node fills the screen vertically. Each frame the first level whose
+	screen size is reached is drawn, and the last level when the node is
+	smaller than all of them.
+	The levels can be created with IMeshManipulator::createMeshSimplified(),
+	ISceneManager::addLODSceneNode() does that automatically.
+	The materials are copied from the mesh buffers of the first level and
+	used for the mesh buffers of all levels, so all levels should have the
+	same mesh buffers. */
+	class ILODSceneNode : public ISceneNode
+	{
+	public:
+
+		//! Constructor
+		ILODSceneNode(ISceneNode* parent, ISceneManager* mgr, s32 id,
+			const core::vector3df& position = core::vector3df(0,0,0),
+			const core::vector3df& rotation = core::vector3df(0,0,0),
+			const core::vector3df& scale = core::vector3df(1,1,1))
+			: ISceneNode(parent, mgr, id, position, rotation, scale) {}
+
+		//! Adds a level of detail.
+		/** The levels are sorted by their screen size, the order in which
+		they are added doesn't matter.
+		\param mesh Mesh drawn for this level. Can be 0 to draw nothing,
+		for example to hide small nodes completely.
+		\param minScreenSize Smallest screen size the level is used for. */
+		virtual void addLevel(IMesh* mesh, f32 minScreenSize) = 0;
+
+		//! Removes all levels
+		virtual void removeLevels() = 0;
+
+		//! Returns the number of levels
+		virtual u32 getLevelCount() const = 0;
+
+		//! Returns the mesh of a level, level 0 has the most detail
+		virtual IMesh* getLevelMesh(u32 level) const = 0;
+
+		//! Returns the smallest screen size a level is used for
+		virtual f32 getLevelScreenSize(u32 level) const = 0;
+
+		//! Returns the level chosen the last time the node was drawn
+		/** \return Index of the level, or -1 if the node has no levels. */
+		virtual s32 getCurrentLevel() const = 0;
+
+		//! Returns the screen size of the node when it was drawn the last time
+		virtual f32 getScreenSize() const = 0;
+	};
+
+} // end namespace scene
+} // end namespace irr
+
+#endif
+
@@ -52,6 +52,15 @@ namespace scene
 		/** \return Vertex type of this buffer. */
 		virtual video::E_VERTEX_TYPE getVertexType() const = 0;
 
+		//! Get the scale and offset of the positions of quantized vertices.
+		/** Only used with video::EVT_QUANTIZED and
+		video::EVT_QUANTIZED_TANGENTS vertices.
+		\return Quantization of the vertex positions of this buffer. */
+		virtual video::SVertexQuantization getVertexQuantization() const
+		{
+			return video::SVertexQuantization();
+		}
+
 		//! Get access to vertex data. The data is an array of vertices.
 		/** Which vertex type is used can be determined by getVertexType().
 		\return Pointer to array of vertices. */
@@ -95,6 +104,15 @@ namespace scene
 		virtual void recalculateBoundingBox() = 0;
 
 		//! returns position of vertex i
+		/** Buffers with quantized vertices decode the value on each call
+		for all of the following accessors. The returned reference points
+		into a few slots of the buffer and is overwritten by the 16th
+		following accessor call on that buffer, so copy values that are
+		needed longer, and don't use these accessors on the same quantized
+		buffer from several threads at once. Quantized vertices can't be
+		changed through the references, the non-const accessors break in
+		debug builds for them. Use the quantized vertex array with its
+		SVertexQuantization to change them. */
 		virtual const core::vector3df& getPosition(u32 i) const = 0;
 
 		//! returns position of vertex i
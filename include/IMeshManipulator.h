@@ -12,6 +12,7 @@
 #include "IAnimatedMesh.h"
 #include "IMeshBuffer.h"
 #include "SVertexManipulator.h"
+#include "SMeshCluster.h"
 
 namespace irr
 {
@@ -20,6 +21,27 @@ namespace scene
 
 	struct SMesh;
 
+	//! Vertex processing statistics of a mesh, see IMeshManipulator::getVertexCacheStatistics()
+	struct SVertexCacheStatistics
+	{
+		//! Number of vertices which have to be transformed with the simulated cache
+		u32 TransformedVertices;
+
+		//! Number of triangles
+		u32 Triangles;
+
+		//! Number of vertices used by the triangles
+		u32 Vertices;
+
+		//! Average cache miss ratio, transformed vertices per triangle.
+		/** Between 3 without any reuse and about 0.5 for large regular grids. */
+		f32 ACMR;
+
+		//! Average transformed vertex ratio, transformed vertices per used vertex.
+		/** 1 means each vertex is transformed only once. */
+		f32 ATVR;
+	};
+
 	//! An interface for easy manipulation of meshes.
 	/** Scale, set alpha value, flip surfaces, and so on. This exists for
 	fixing problems with wrong imported or exported meshes quickly after
@@ -82,6 +104,40 @@ namespace scene
 		virtual void recalculateNormals(IMeshBuffer* buffer,
 				bool smooth = false, bool angleWeighted = false) const=0;
 
+		//! Recalculates smooth normals, also across vertices which only share their position.
+		/** recalculateNormals() only smoothes over triangles sharing a
+		vertex, so meshes with vertices split at texture seams get visible
+		edges there. This method smoothes over all triangles at the same
+		position instead, found with a spatial hash. To keep hard edges,
+		triangles are only smoothed together when their normals differ by
+		at most maxAngle. The triangles sharing a vertex are always
+		smoothed together, as the vertex can't have more than one normal.
+		Tangent mesh buffers also get their tangents and binormals
+		recalculated, smoothed only over triangles sharing a vertex, as
+		texture seams split the tangent space.
+		\param buffer Mesh buffer on which the operation is performed.
+		\param maxAngle Largest angle between two triangle normals in
+		degrees for which the triangles are smoothed together.
+		\param angleWeighted If the triangle normals are weighted by the
+		angle of the triangle at the vertex, otherwise all triangles have
+		the same weight.
+		\param tolerance Largest distance of two positions which are
+		considered equal.
+		\param threadCount Number of threads used for the calculation,
+		0 uses one thread per processor. Only large mesh buffers benefit
+		from more than one thread. */
+		virtual void recalculateNormalsWelded(IMeshBuffer* buffer, f32 maxAngle=180.f,
+				bool angleWeighted=true, f32 tolerance=core::ROUNDING_ERROR_f32,
+				u32 threadCount=1) const=0;
+
+		//! Recalculates smooth normals of all mesh buffers, also across vertices which only share their position.
+		/** Each mesh buffer is smoothed on its own, see
+		recalculateNormalsWelded(IMeshBuffer*,f32,bool,f32,u32) for
+		the parameters. */
+		virtual void recalculateNormalsWelded(IMesh* mesh, f32 maxAngle=180.f,
+				bool angleWeighted=true, f32 tolerance=core::ROUNDING_ERROR_f32,
+				u32 threadCount=1) const=0;
+
 		//! Recalculates tangents, requires a tangent mesh
 		/** \param mesh Mesh on which the operation is performed.
 		\param recalculateNormals If the normals shall be recalculated, otherwise original normals of the mesh are used unchanged.
@@ -203,8 +259,10 @@ namespace scene
 				u8 axis, const core::vector3df& offset) const=0;
 
 		//! Clones a static IMesh into a modifiable SMesh.
-		/** All meshbuffers in the returned SMesh
-		are of type SMeshBuffer or SMeshBufferLightMap.
+		/** All meshbuffers in the returned SMesh are of type
+		SMeshBuffer, SMeshBufferLightMap or SMeshBufferTangents, or
+		CDynamicMeshBuffer with 32 bit indices if they have more than
+		65536 vertices.
 		\param mesh Mesh to copy.
 		\return Cloned mesh. If you no longer need the
 		cloned mesh, you should call SMesh::drop(). See
@@ -224,7 +282,8 @@ namespace scene
 		meshbuffer's faces if this flag is set.
 		\param angleWeighted Improved smoothing calculation used
 		\param recalculateTangents Whether are actually calculated, or just the mesh with proper type is created.
-		\return Mesh consisting only of S3DVertexTangents vertices. If
+		\return Mesh consisting only of S3DVertexTangents vertices.
+		Mesh buffers with more than 65536 vertices get 32 bit indices. If
 		you no longer need the cloned mesh, you should call
 		IMesh::drop(). See IReferenceCounted::drop() for more
 		information. */
@@ -234,7 +293,8 @@ namespace scene
 
 		//! Creates a copy of the mesh, which will only consist of S3DVertex2TCoord vertices.
 		/** \param mesh Input mesh
-		\return Mesh consisting only of S3DVertex2TCoord vertices. If
+		\return Mesh consisting only of S3DVertex2TCoord vertices.
+		Mesh buffers with more than 65536 vertices get 32 bit indices. If
 		you no longer need the cloned mesh, you should call
 		IMesh::drop(). See IReferenceCounted::drop() for more
 		information. */
@@ -242,7 +302,8 @@ namespace scene
 
 		//! Creates a copy of the mesh, which will only consist of S3DVertex vertices.
 		/** \param mesh Input mesh
-		\return Mesh consisting only of S3DVertex vertices. If
+		\return Mesh consisting only of S3DVertex vertices.
+		Mesh buffers with more than 65536 vertices get 32 bit indices. If
 		you no longer need the cloned mesh, you should call
 		IMesh::drop(). See IReferenceCounted::drop() for more
 		information. */
@@ -251,19 +312,46 @@ namespace scene
 		//! Creates a copy of a mesh with all vertices unwelded
 		/** \param mesh Input mesh
 		\return Mesh consisting only of unique faces. All vertices
-		which were previously shared are now duplicated. If you no
+		which were previously shared are now duplicated, mesh buffers
+		with more than 65536 indices get 32 bit indices. If you no
 		longer need the cloned mesh, you should call IMesh::drop(). See
 		IReferenceCounted::drop() for more information. */
 		virtual IMesh* createMeshUniquePrimitives(IMesh* mesh) const = 0;
 
 		//! Creates a copy of a mesh with vertices welded
-		/** \param mesh Input mesh
+		/** Each vertex is replaced by the first vertex of its mesh buffer
+		which has the same attributes, with positions, normals and tangents
+		compared with the tolerance. Degenerated triangles are removed.
+		Mesh buffers with more than 65536 vertices after welding get
+		32 bit indices.
+		\param mesh Input mesh
 		\param tolerance The threshold for vertex comparisons.
 		\return Mesh without redundant vertices. If you no longer need
 		the cloned mesh, you should call IMesh::drop(). See
 		IReferenceCounted::drop() for more information. */
 		virtual IMesh* createMeshWelded(IMesh* mesh, f32 tolerance=core::ROUNDING_ERROR_f32) const = 0;
 
+		//! Creates a copy of a mesh with fewer triangles
+		/** Edges are collapsed in order of the error they introduce,
+		measured with quadric error metrics. Collapsing moves a vertex onto
+		a neighbor, so no new vertices are created and all vertex attributes
+		stay exact. Vertices on UV seams and other attribute borders, on
+		open edges and thus on the borders between mesh buffers are never
+		moved, so the result has no cracks and each mesh buffer keeps its
+		material. Mesh buffers are simplified in proportion to their
+		triangle count, mesh buffers which become empty are kept.
+		\param mesh Input mesh
+		\param targetTriangleCount Number of triangles the simplified
+		mesh should have. Less reduction is done when the error limit is
+		reached or no more edges can be collapsed.
+		\param maxError Largest distance a surface may move, relative to
+		the size of the bounding box of the mesh. 0.01 allows 1% of the
+		mesh size.
+		\return Simplified mesh. If you no longer need the mesh, you
+		should call IMesh::drop(). See IReferenceCounted::drop() for more
+		information. */
+		virtual IMesh* createMeshSimplified(IMesh* mesh, u32 targetTriangleCount, f32 maxError=1.f) const = 0;
+
 		//! Get amount of polygons in mesh.
 		/** \param mesh Input mesh
 		\return Number of polygons in mesh. */
@@ -289,12 +377,84 @@ namespace scene
 		http://home.comcast.net/~tom_forsyth/papers/fast_vert_cache_opt.html
 
 		The function is thread-safe (read: you can optimize several
-		meshes in different threads).
+		meshes in different threads). Mesh buffers with 32 bit indices
+		are optimized like createOptimizedMesh() does without the
+		overdraw step.
 
 		\param mesh Source mesh for the operation.
 		\return A new mesh optimized for the vertex cache. */
 		virtual IMesh* createForsythOptimizedMesh(const IMesh *mesh) const = 0;
 
+		//! Creates a copy of a mesh optimized for vertex processing, overdraw and vertex fetching.
+		/** Each mesh buffer goes through these steps:
+		- The triangles are sorted for the post-transform vertex cache,
+		  like createForsythOptimizedMesh() does.
+		- The sorted triangles are split into clusters which don't lose
+		  much cache efficiency, and the clusters facing away from the
+		  center of the mesh buffer are drawn first. They are likely to
+		  hide the others, so fewer pixels are shaded more than once.
+		- The vertices are renumbered in the order they are used, so the
+		  vertex data is read sequentially. Unused vertices are removed.
+		Mesh buffers with 32 bit indices are supported, and get 16 bit
+		indices if they have few enough vertices. Use
+		getVertexCacheStatistics() to compare the result with the input.
+		\param mesh Source mesh for the operation.
+		\param overdrawThreshold How much the vertex cache efficiency may
+		suffer for the overdraw optimization, 1.05 allows 5% more
+		transformed vertices. Values below 1 disable the overdraw
+		optimization.
+		\return A new mesh. If you no longer need the mesh, you should
+		call IMesh::drop(). See IReferenceCounted::drop() for more
+		information. */
+		virtual IMesh* createOptimizedMesh(const IMesh* mesh, f32 overdrawThreshold=1.05f) const = 0;
+
+		//! Simulates a FIFO post-transform vertex cache for all mesh buffers of a mesh.
+		/** \param mesh Mesh to analyze.
+		\param cacheSize Number of vertices in the simulated cache.
+		\return Statistics of all triangle lists of the mesh. */
+		virtual SVertexCacheStatistics getVertexCacheStatistics(const IMesh* mesh, u32 cacheSize=16) const = 0;
+
+		//! Creates a copy of a mesh with the triangles of each mesh buffer grouped into small clusters.
+		/** Neighboring triangles are collected into clusters of at most
+		maxVertices different vertices and maxTriangles triangles, and the
+		index lists are sorted so each cluster is a range of indices. For
+		each cluster a bounding sphere and a cone around the triangle
+		normals are calculated, which allow to skip clusters outside of the
+		view frustum or facing away from the camera. This is what
+		ISceneManager::addClusteredMeshSceneNode() does each frame.
+		Only triangle lists with S3DVertex, S3DVertex2TCoords or
+		S3DVertexTangents vertices are clustered, the vertices are
+		renumbered in the order they are used. Other mesh buffers are added
+		unchanged, so they are shared with the original mesh, and get no
+		clusters.
+		\param mesh Source mesh for the operation.
+		\param clusters Receives the clusters of all mesh buffers, sorted
+		by mesh buffer and first index.
+		\param maxVertices Largest number of vertices in a cluster.
+		\param maxTriangles Largest number of triangles in a cluster.
+		\return A new mesh. If you no longer need the mesh, you should
+		call IMesh::drop(). See IReferenceCounted::drop() for more
+		information. */
+		virtual IMesh* createClusteredMesh(const IMesh* mesh, core::array<SMeshCluster>& clusters,
+			u32 maxVertices=64, u32 maxTriangles=124) const = 0;
+
+		//! Creates a copy of a mesh with compressed vertices.
+		/** Mesh buffers with S3DVertex vertices get S3DVertexQuantized
+		vertices, and those with S3DVertexTangents vertices get
+		S3DVertexQuantizedTangents vertices, which need little more than half the
+		memory. The positions are stored with 16 bit precision relative to
+		the bounding box of each mesh buffer, normals and tangents with
+		about 15 bit precision per axis and texture coordinates as half
+		floats. Vertices with two texture coordinates and mesh buffers with
+		32 bit indices are added unchanged, so they are shared with the
+		original mesh. createMeshWith1TCoords() and createMeshWithTangents()
+		convert quantized meshes back.
+		\param mesh Source mesh for the operation.
+		\return A new mesh. If you no longer need the mesh, you should
+		call IMesh::drop(). See IReferenceCounted::drop() for more
+		information. */
+		virtual IMesh* createMeshQuantized(const IMesh* mesh) const = 0;
+
 		//! Optimize the mesh with an algorithm tuned for heightmaps.
 		/**
 		This differs from usual simplification methods in two ways:
@@ -375,6 +535,8 @@ protected:
 				return true;
 
 			core::aabbox3df bufferbox;
+			core::vector3df pos;
+			const video::SVertexQuantization quantization = buffer->getVertexQuantization();
 			for (u32 i=0; i<buffer->getVertexCount(); ++i)
 			{
 				switch (buffer->getVertexType())
@@ -383,31 +545,56 @@ protected:
 					{
 						video::S3DVertex* verts = (video::S3DVertex*)buffer->getVertices();
 						func(verts[i]);
+						pos = verts[i].Pos;
 					}
 					break;
 				case video::EVT_2TCOORDS:
 					{
 						video::S3DVertex2TCoords* verts = (video::S3DVertex2TCoords*)buffer->getVertices();
 						func(verts[i]);
+						pos = verts[i].Pos;
 					}
 					break;
 				case video::EVT_TANGENTS:
 					{
 						video::S3DVertexTangents* verts = (video::S3DVertexTangents*)buffer->getVertices();
 						func(verts[i]);
+						pos = verts[i].Pos;
+					}
+					break;
+				// quantized vertices are decoded, positions are clamped to the quantization range
+				case video::EVT_QUANTIZED:
+					{
+						video::S3DVertexQuantized* verts = (video::S3DVertexQuantized*)buffer->getVertices();
+						video::S3DVertex vertex = verts[i].get(quantization);
+						func(vertex);
+						verts[i].set(vertex, quantization);
+						pos = verts[i].getPosition(quantization);
+					}
+					break;
+				case video::EVT_QUANTIZED_TANGENTS:
+					{
+						video::S3DVertexQuantizedTangents* verts = (video::S3DVertexQuantizedTangents*)buffer->getVertices();
+						video::S3DVertexTangents vertex = verts[i].get(quantization);
+						func(vertex);
+						verts[i].set(vertex, quantization);
+						pos = verts[i].getPosition(quantization);
 					}
 					break;
 				}
 				if (boundingBoxUpdate)
 				{
 					if (0==i)
-						bufferbox.reset(buffer->getPosition(0));
+						bufferbox.reset(pos);
 					else
-						bufferbox.addInternalPoint(buffer->getPosition(i));
+						bufferbox.addInternalPoint(pos);
 				}
 			}
 			if (boundingBoxUpdate)
 				buffer->setBoundingBox(bufferbox);
+			// the decoded copies of quantized vertices have to be updated
+			if (video::isQuantizedVertexType(buffer->getVertexType()))
+				buffer->setDirty(EBT_VERTEX);
 			return true;
 		}
 };
@@ -28,7 +28,7 @@ public:
 			const core::vector3df& position = core::vector3df(0,0,0),
 			const core::vector3df& rotation = core::vector3df(0,0,0),
 			const core::vector3df& scale = core::vector3df(1,1,1))
-		: ISceneNode(parent, mgr, id, position, rotation, scale) {}
+		: ISceneNode(parent, mgr, id, position, rotation, scale), MeshVisible(true) {}
 
 	//! Sets a new mesh to display
 	/** \param mesh Mesh to display. */
@@ -69,6 +69,28 @@ public:
 	/** This flag can be set by setReadOnlyMaterials().
 	\return Whether the materials are read-only. */
 	virtual bool isReadOnlyMaterials() const = 0;
+
+	//! Sets if the mesh of this node is drawn
+	/** Unlike setVisible(false), this only skips drawing the mesh, the
+	children of the node are still rendered. Used by
+	IBatchedMeshSceneNode, which draws the mesh instead.
+	\param visible Flag if the mesh shall be drawn. */
+	virtual void setMeshVisible(bool visible)
+	{
+		MeshVisible = visible;
+	}
+
+	//! Check if the mesh of this node is drawn
+	/** \return Whether the mesh is drawn when the node is visible. */
+	virtual bool isMeshVisible() const
+	{
+		return MeshVisible;
+	}
+
+protected:
+
+	//! Is the mesh drawn?
+	bool MeshVisible;
 };
 
 } // end namespace scene
@@ -9,6 +9,12 @@
 
 namespace irr
 {
+namespace io
+{
+	class IReadFile;
+	class IWriteFile;
+} // end namespace io
+
 namespace scene
 {
 
@@ -64,8 +70,6 @@ public:
 		: IMeshSceneNode(parent, mgr, id, position, rotation, scale) {}
 
 	//! Set if/how vertex buffer object are used for the meshbuffers
-	/** NOTE: When there is already a mesh in the node this will rebuild
-	the octree. */
 	virtual void setUseVBO(EOCTREENODE_VBO useVBO) = 0;
 
 	//! Get if/how vertex buffer object are used for the meshbuffers
@@ -76,6 +80,21 @@ public:
 
 	//! Get the kind of tests polygons do for visibility against the camera
 	virtual EOCTREE_POLYGON_CHECKS getPolygonChecks() const = 0;
+
+	//! Writes the octree of the current mesh to a file.
+	/** Building the octree of a large mesh takes a while. The tree
+	written with this function can be read with readTree() instead.
+	\param file File to write to.
+	\return True if successful. */
+	virtual bool writeTree(io::IWriteFile* file) const = 0;
+
+	//! Sets a new mesh and reads its octree from a file written by writeTree().
+	/** The file is checked against the mesh. If it was written for
+	another mesh, the tree is built like in setMesh().
+	\param mesh Mesh to display.
+	\param file File to read from.
+	\return True if the tree was read from the file. */
+	virtual bool readTree(IMesh* mesh, io::IReadFile* file) = 0;
 };
 
 } // end namespace scene
@@ -0,0 +1,107 @@
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#ifndef __I_PAGED_TERRAIN_SCENE_NODE_H_INCLUDED__
+#define __I_PAGED_TERRAIN_SCENE_NODE_H_INCLUDED__
+
+#include "ISceneNode.h"
+#include "dimension2d.h"
+
+namespace irr
+{
+namespace scene
+{
+
+	//! Scene node for terrains which are too large to be kept in memory.
+	/** The heightmap is read from a RAW file with 16 bit heights in the
+	native byte order of the system. It contains rows along the x axis, one
+	after another in z direction. Like for ITerrainSceneNode::loadHeightMapRAW()
+	a height of 256 is 1 unit before scaling.
+
+	The terrain is divided into square tiles. Tiles inside the view
+	frustum or closer to the camera than the load distance are loaded on a
+	background thread and used as soon as they are ready. Only heightmaps
+	on disk are read on that thread, with a file handle of its own. Tiles which were
+	not drawn for the longest time are released when the memory used by all
+	tiles exceeds a budget. Each tile is drawn with one of several levels of
+	detail, depending on its distance to the camera, and stitched to the
+	levels of detail of its neighbours.
+	Create it with ISceneManager::addPagedTerrainSceneNode(). */
+	class IPagedTerrainSceneNode : public ISceneNode
+	{
+	public:
+
+		//! Constructor
+		IPagedTerrainSceneNode(ISceneNode* parent, ISceneManager* mgr, s32 id,
+			const core::vector3df& position = core::vector3df(0,0,0),
+			const core::vector3df& rotation = core::vector3df(0,0,0),
+			const core::vector3df& scale = core::vector3df(1.0f, 1.0f, 1.0f))
+			: ISceneNode(parent, mgr, id, position, rotation, scale) {}
+
+		//! Returns the height of the terrain at a position
+		/** Only tiles which are loaded are used, other tiles are not loaded
+		by this call.
+		\param x X coordinate in world space.
+		\param z Z coordinate in world space.
+		\return Height in world space, or -FLT_MAX if the position is
+		outside of the terrain or its tile is not loaded. */
+		virtual f32 getHeight(f32 x, f32 z) const = 0;
+
+		//! Returns the number of height samples in x and z direction
+		virtual const core::dimension2du& getHeightmapSize() const = 0;
+
+		//! Returns the number of quads along a side of a tile
+		virtual u32 getTileSize() const = 0;
+
+		//! Returns the number of tiles in x and z direction
+		virtual const core::dimension2du& getTileCount() const = 0;
+
+		//! Returns if a tile is loaded
+		virtual bool isTileLoaded(u32 tileX, u32 tileZ) const = 0;
+
+		//! Returns the level of detail a tile was drawn with the last time the node was rendered
+		/** \return Level of detail, or -1 if the tile was not drawn. */
+		virtual s32 getTileLOD(u32 tileX, u32 tileZ) const = 0;
+
+		//! Returns the number of loaded tiles
+		virtual u32 getLoadedTileCount() const = 0;
+
+		//! Returns the number of tiles which are waiting to be loaded
+		virtual u32 getPendingTileCount() const = 0;
+
+		//! Waits until all tiles requested so far are loaded
+		/** They are used the next time the node is registered for rendering. */
+		virtual void waitForTiles() = 0;
+
+		//! Sets the memory in bytes which all loaded tiles may use together
+		/** When the budget is exceeded, the tiles which were not drawn for
+		the longest time are released. Tiles drawn in the current frame are
+		never released, even if they exceed the budget. */
+		virtual void setMemoryBudget(u32 bytes) = 0;
+
+		//! Returns the memory in bytes which all loaded tiles may use together
+		virtual u32 getMemoryBudget() const = 0;
+
+		//! Returns the memory in bytes used by the loaded tiles
+		virtual u32 getMemoryUsed() const = 0;
+
+		//! Sets the distance up to which tiles are loaded even outside of the view frustum
+		/** This avoids holes when the camera turns. The distance is in world space. */
+		virtual void setLoadDistance(f32 distance) = 0;
+
+		//! Returns the distance up to which tiles are loaded even outside of the view frustum
+		virtual f32 getLoadDistance() const = 0;
+
+		//! Sets the distance up to which tiles are drawn with the highest level of detail
+		/** Each following level of detail is used up to twice the distance
+		of the previous one. The distance is in world space. */
+		virtual void setLODDistance(f32 distance) = 0;
+
+		//! Returns the distance up to which tiles are drawn with the highest level of detail
+		virtual f32 getLODDistance() const = 0;
+	};
+
+} // end namespace scene
+} // end namespace irr
+
+#endif
@@ -51,6 +51,29 @@ public:
 	\param count Amount of particles in array. */
 	virtual void affect(u32 now, SParticle* particlearray, u32 count) = 0;
 
+	//! Prepares affecting the particles in several parts.
+	/** Particle systems call this once per update before they call
+	affectPart() for all parts of their particles, possibly from several
+	threads at the same time. Affectors which need the time since the last
+	update should calculate it here.
+	\param now Current time. (Same as ITimer::getTime() would return)
+	\return False if the affector can only work on all particles at once,
+	in that case affect() is called instead. The default implementation
+	returns false, so affectors which only implement affect() keep working. */
+	virtual bool beginAffect(u32 now) { return false; }
+
+	//! Affects a part of the particles after beginAffect() returned true.
+	/** Must not change the affector, as parts can be affected from several
+	threads at the same time. The default implementation calls affect(),
+	affectors returning true from beginAffect() should override it.
+	\param now Current time, the same as for beginAffect().
+	\param particlearray Array of particles.
+	\param count Amount of particles in array. */
+	virtual void affectPart(u32 now, SParticle* particlearray, u32 count)
+	{
+		affect(now, particlearray, count);
+	}
+
 	//! Sets whether or not the affector is currently enabled.
 	virtual void setEnabled(bool enabled) { Enabled = enabled; }
 
@@ -68,6 +68,29 @@ enum EParticleBehavior
 	EPB_EMITTER_FRAME_INTERPOLATION = 32
 };
 
+//! Primitives used to draw the particles
+enum E_PARTICLES_PRIMITIVE
+{
+	//! One point per particle, with the size of the material thickness
+	EPP_POINT=0,
+
+	//! Textured quads which face the camera, with the size of each particle
+	EPP_BILLBOARD,
+
+	//! Textured points, with the size of the material thickness
+	/** Drivers without video::EVDF_POINT_SPRITES draw billboards instead. */
+	EPP_POINTSPRITE
+};
+
+//! Names for particle primitives
+const c8* const ParticlePrimitiveNames[] =
+{
+	"Point",
+	"Billboard",
+	"PointSprite",
+	0
+};
+
 class IParticleSystemSceneNode : public ISceneNode
 {
 public:
@@ -119,6 +142,62 @@ public:
 	automatically. */
 	virtual void doParticleSystem(u32 time) = 0;
 
+	//! Sets the primitives used to draw the particles.
+	/** Points need only one vertex per particle instead of four, but all
+	particles have the same size, which is set with the Thickness of the
+	material. Default is EPP_BILLBOARD. */
+	virtual void setParticlePrimitive(E_PARTICLES_PRIMITIVE primitive) = 0;
+
+	//! Returns the primitives used to draw the particles.
+	virtual E_PARTICLES_PRIMITIVE getParticlePrimitive() const = 0;
+
+	//! Sets if the particles are drawn from back to front.
+	/** Alpha blended particles only look right when the ones farther
+	away from the camera are drawn first. The particles are sorted by
+	their depth each time the node is drawn. As particles and camera
+	usually move only a little between two frames, the order of the last
+	frame needs few fixes, otherwise a radix sort is used. Materials with
+	additive blending don't need sorting.
+	\param sort True to sort the particles. Default is false. */
+	virtual void setDepthSorting(bool sort) = 0;
+
+	//! Returns if the particles are drawn from back to front.
+	virtual bool getDepthSorting() const = 0;
+
+	//! Returns the number of particles which are currently alive.
+	virtual u32 getParticleCount() const = 0;
+
+	//! Sets the largest number of particles which are alive at the same time.
+	/** New particles beyond this number are dropped. Particle systems with
+	more than 16384 particles are drawn with 32 bit indices.
+	The default implementation ignores the limit.
+	\param count Largest number of particles. Default is no limit. */
+	virtual void setMaxParticleCount(u32 count) {}
+
+	//! Returns the largest number of particles which are alive at the same time.
+	/** \return Largest number of particles, 0xFFFFFFFF for no limit. */
+	virtual u32 getMaxParticleCount() const
+	{
+		return 0xFFFFFFFF;
+	}
+
+	//! Sets the number of threads which update the particles and create their vertices.
+	/** The particles are split into parts of several thousand particles,
+	so only large particle systems benefit from more than one thread. With
+	more than one thread, affectors which return true from
+	IParticleAffector::beginAffect() must allow calls of affectPart() from
+	several threads at the same time, which the built-in affectors do.
+	\param threadCount Number of threads including the calling thread,
+	0 uses one thread per processor. Default is 1. The default
+	implementation always updates on the calling thread. */
+	virtual void setUpdateThreadCount(u32 threadCount) {}
+
+	//! Returns the number of threads which update the particles.
+	virtual u32 getUpdateThreadCount() const
+	{
+		return 1;
+	}
+
 	//! Gets the particle emitter, which creates the particles.
 	/** \return The particle emitter. Can be 0 if none is set. */
 	virtual IParticleEmitter* getEmitter() =0;
@@ -7,11 +7,119 @@
 
 #include "IAnimatedMesh.h"
 #include "IQ3Shader.h"
+#include "plane3d.h"
 
 namespace irr
 {
 namespace scene
 {
+namespace quake3
+{
+	//! BSP tree and potentially visible sets of a Quake 3 level
+	/** The level is split into convex leafs by the BSP tree. Leafs are
+	grouped into clusters, and for each cluster the level stores which
+	other clusters can be seen from it. All positions are in the
+	coordinate system of the level mesh, so Y points up. */
+	struct SLevelVisibility
+	{
+		//! Node of the BSP tree
+		struct SNode
+		{
+			//! Splitting plane, points in front of it belong to Children[0]
+			core::plane3df Plane;
+
+			//! Front and back child, negative values are leafs with index -(value+1)
+			s32 Children[2];
+		};
+
+		//! Convex part of the level
+		struct SLeaf
+		{
+			//! Visibility cluster, -1 for leafs outside of the level
+			s32 Cluster;
+
+			//! Bounding box of the leaf
+			core::aabbox3df Box;
+
+			//! First entry in LeafFaces
+			u32 FirstFace;
+
+			//! Number of entries in LeafFaces
+			u32 FaceCount;
+		};
+
+		//! Part of the E_Q3_MESH_GEOMETRY mesh which was built from a face
+		struct SFace
+		{
+			//! Index of the mesh buffer
+			u32 MeshBuffer;
+
+			//! First index of the face in the mesh buffer
+			u32 FirstIndex;
+
+			//! Number of indices, 0 for faces which are not part of the mesh
+			u32 IndexCount;
+		};
+
+		SLevelVisibility() : ClusterCount(0), BytesPerCluster(0) {}
+
+		//! Returns the leaf containing a position, or -1 if there is no BSP tree
+		s32 getLeaf(const core::vector3df& pos) const
+		{
+			if (Nodes.empty())
+				return -1;
+
+			s32 index = 0;
+			while (index >= 0)
+			{
+				const SNode& node = Nodes[index];
+				index = node.Children[node.Plane.Normal.dotProduct(pos) + node.Plane.D >= 0.f ? 0 : 1];
+			}
+			return -1 - index;
+		}
+
+		//! Returns the cluster containing a position, or -1 if it's outside of the level
+		s32 getCluster(const core::vector3df& pos) const
+		{
+			const s32 leaf = getLeaf(pos);
+			return leaf >= 0 ? Leafs[leaf].Cluster : -1;
+		}
+
+		//! Returns if cluster to can be seen from cluster from
+		/** Everything is visible from outside of the level or when the
+		level has no visibility information. */
+		bool isClusterVisible(s32 from, s32 to) const
+		{
+			if (to < 0)
+				return false;
+			if (from < 0 || (u32)from >= ClusterCount || (u32)to >= ClusterCount)
+				return true;
+			return (ClusterVisibility[from*BytesPerCluster + (to>>3)] & (1 << (to&7))) != 0;
+		}
+
+		//! The BSP tree, the first node is the root
+		core::array<SNode> Nodes;
+
+		//! All leafs of the BSP tree
+		core::array<SLeaf> Leafs;
+
+		//! Indices into Faces for all leafs
+		core::array<u32> LeafFaces;
+
+		//! Geometry of all faces of the level
+		core::array<SFace> Faces;
+
+		//! Number of clusters
+		u32 ClusterCount;
+
+		//! Size of the visibility bit set of each cluster
+		u32 BytesPerCluster;
+
+		//! Bit sets of the clusters which can be seen from each cluster
+		core::array<u8> ClusterVisibility;
+	};
+} // end namespace quake3
+
 	//! Interface for a Mesh which can be loaded directly from a Quake3 .bsp-file.
 	/** The Mesh tries to load all textures of the map.*/
 	class IQ3LevelMesh : public IAnimatedMesh
@@ -37,6 +145,11 @@ namespace scene
 
 		//! returns the requested brush entity
 		virtual IMesh* getBrushEntityMesh(quake3::IEntity &ent) const = 0;
+
+		//! returns the BSP tree and the visibility information of the level
+		/** Used by IQ3LevelSceneNode to draw only the parts of the level
+		which can be seen from the camera. */
+		virtual const quake3::SLevelVisibility& getVisibility() const = 0;
 	};
 
 } // end namespace scene
@@ -0,0 +1,60 @@
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#ifndef __I_Q3_LEVEL_SCENE_NODE_H_INCLUDED__
+#define __I_Q3_LEVEL_SCENE_NODE_H_INCLUDED__
+
+#include "ISceneNode.h"
+
+namespace irr
+{
+namespace scene
+{
+	class IQ3LevelMesh;
+
+	//! Scene node drawing the geometry of a Quake 3 level.
+	/** Quake 3 levels store a BSP tree and for each part of the level
+	(cluster) a set of all other clusters which can be seen from it. Each
+	frame the node looks up the cluster of the camera and draws only the
+	faces of the leafs in potentially visible clusters which are inside the
+	view frustum. That's usually just a small part of the level, without
+	building an octree first.
+	Only the E_Q3_MESH_GEOMETRY mesh of the level is drawn, items and fog
+	have to be added with other scene nodes. */
+	class IQ3LevelSceneNode : public ISceneNode
+	{
+	public:
+
+		//! Constructor
+		IQ3LevelSceneNode(ISceneNode* parent, ISceneManager* mgr, s32 id,
+			const core::vector3df& position = core::vector3df(0,0,0),
+			const core::vector3df& rotation = core::vector3df(0,0,0),
+			const core::vector3df& scale = core::vector3df(1,1,1))
+			: ISceneNode(parent, mgr, id, position, rotation, scale) {}
+
+		//! Returns the level which is drawn
+		virtual IQ3LevelMesh* getLevelMesh() const = 0;
+
+		//! Sets if only the potentially visible faces are drawn
+		/** \param enable False to draw all faces of the level, true by default. */
+		virtual void setVisibilityCulling(bool enable) = 0;
+
+		//! Returns if only the potentially visible faces are drawn
+		virtual bool getVisibilityCulling() const = 0;
+
+		//! Returns the cluster the camera was in when the node was drawn the last time
+		/** \return Index of the cluster, or -1 if the camera was outside of the level. */
+		virtual s32 getCameraCluster() const = 0;
+
+		//! Returns the number of faces drawn the last time
+		virtual u32 getDrawnFaceCount() const = 0;
+
+		//! Returns the number of faces of the level geometry
+		virtual u32 getFaceCount() const = 0;
+	};
+
+} // end namespace scene
+} // end namespace irr
+
+#endif
+
@@ -7,6 +7,7 @@
 
 #include "IReferenceCounted.h"
 #include "coreutil.h"
+#include "EReadFileType.h"
 
 namespace irr
 {
@@ -42,6 +43,15 @@ namespace io
 		//! Get name of file.
 		/** \return File name as zero terminated character string. */
 		virtual const io::path& getFileName() const = 0;
+
+		//! Get the type of the class implementing this interface
+		/** Loaders may use this to pick a faster way to access the data,
+		for example by mapping a file on disk into memory.
+		\return Type of the file class, EFIT_UNKNOWN for own implementations. */
+		virtual EREAD_FILE_TYPE getType() const
+		{
+			return EFIT_UNKNOWN;
+		}
 	};
 
 	//! Internal function, please do not use.
@@ -109,9 +109,14 @@ namespace scene
 	class IMeshManipulator;
 	class IMeshSceneNode;
 	class IMeshWriter;
+	class ILODSceneNode;
+	class IBatchedMeshSceneNode;
+	class IClusteredMeshSceneNode;
 	class IMetaTriangleSelector;
 	class IOctreeSceneNode;
 	class IParticleSystemSceneNode;
+	class IQ3LevelMesh;
+	class IQ3LevelSceneNode;
 	class ISceneCollisionManager;
 	class ISceneLoader;
 	class ISceneNode;
@@ -121,6 +126,7 @@ namespace scene
 	class ISceneNodeFactory;
 	class ISceneUserDataSerializer;
 	class ITerrainSceneNode;
+	class IPagedTerrainSceneNode;
 	class ITextSceneNode;
 	class ITriangleSelector;
 	class IVolumeLightSceneNode;
@@ -265,6 +271,13 @@ namespace scene
 		 *      lightmapper.</TD>
 		 *  </TR>
 		 *  <TR>
+		 *    <TD>Irrlicht Binary Mesh (.irrbmesh)</TD>
+		 *    <TD>Binary static or skinned mesh format native to Irrlicht,
+		 *      written by the binary irr mesh writer. Vertices and indices
+		 *      are stored in the engine's memory layout, static meshes
+		 *      loaded from disk use a memory mapped file directly.</TD>
+		 *  </TR>
+		 *  <TR>
 		 *    <TD>LightWave (.lwo)</TD>
 		 *    <TD>Native to NewTek's LightWave 3D, the LWO format is well
 		 *      known and supported by many exporters. This loader will
@@ -512,6 +525,10 @@ namespace scene
 		//! Adds a scene node for rendering a animated water surface mesh.
 		/** Looks really good when the Material type EMT_TRANSPARENT_REFLECTION
 		is used.
+		The waves are only calculated when the node is drawn, so water outside of
+		the view costs no time. Setting the attribute "UpdateInterval" to a
+		number of milliseconds calculates the waves only once per interval and
+		interpolates the vertices between, see ISceneNode::deserializeAttributes().
 		\param waveHeight: Height of the water waves.
 		\param waveSpeed: Speed of the water waves.
 		\param waveLength: Length of a water wave.
@@ -564,6 +581,79 @@ namespace scene
 		virtual IOctreeSceneNode* addOctreeSceneNode(IMesh* mesh, ISceneNode* parent=0,
 			s32 id=-1, s32 minimalPolysPerNode=256, bool alsoAddIfMeshPointerZero=false) = 0;
 
+		//! Adds a scene node which draws simplified versions of a mesh when it gets small on the screen.
+		/** The levels of detail are created with
+		IMeshManipulator::createMeshSimplified(), each one with the triangle
+		count of the one before multiplied by reduction. Level 0 is the mesh
+		itself and is used while the node covers at least half of the
+		screen height, each following level is used down to half the size
+		of the level before, and the last level for all smaller sizes.
+		More levels can be added with ILODSceneNode::addLevel(), for
+		example one without mesh to hide the node when it's tiny.
+		\param mesh: Mesh with the most detail.
+		\param levelCount: Number of levels, including the mesh itself.
+		\param reduction: Factor for the triangle count of each level.
+		\param parent: Parent node of the LOD node.
+		\param id: id of the node. This id can be used to identify the node.
+		\param position: Position of the space relative to its parent where the node will be placed.
+		\param rotation: Initial rotation of the scene node.
+		\param scale: Initial scale of the scene node.
+		\return Pointer to the LOD node if successful, otherwise 0.
+		This pointer should not be dropped. See IReferenceCounted::drop() for more information. */
+		virtual ILODSceneNode* addLODSceneNode(IMesh* mesh, u32 levelCount=4, f32 reduction=0.25f,
+			ISceneNode* parent=0, s32 id=-1,
+			const core::vector3df& position = core::vector3df(0,0,0),
+			const core::vector3df& rotation = core::vector3df(0,0,0),
+			const core::vector3df& scale = core::vector3df(1.0f, 1.0f, 1.0f)) = 0;
+
+		//! Merges many static mesh scene nodes into one node with few draw calls.
+		/** The mesh buffers of all visible mesh, cube, sphere and octree
+		scene nodes of the list are transformed into the space of the new
+		node, grouped by material and merged into chunks of at most
+		maxChunkVertices vertices. Chunks with more than 65536 vertices
+		use 32 bit indices. Nodes with transparent materials are skipped,
+		as their buffers have to be sorted by distance.
+		The meshes of the batched nodes are no longer drawn by the nodes
+		themselves, see IMeshSceneNode::setMeshVisible(). Their children
+		are still rendered. The batched nodes are kept alive by
+		the batch node and are reported by its triangle selector for
+		picking when they had a triangle selector themselves.
+		\param nodes: Nodes to batch.
+		\param parent: Parent node of the batch node. Moving it moves all
+		batched geometry.
+		\param id: id of the node. This id can be used to identify the node.
+		\param maxChunkVertices: Largest number of vertices in one chunk.
+		Smaller chunks can be culled better, larger ones need fewer draw calls.
+		\return Pointer to the batch node. This pointer should not be
+		dropped. See IReferenceCounted::drop() for more information. */
+		virtual IBatchedMeshSceneNode* addBatchedMeshSceneNode(const core::array<ISceneNode*>& nodes,
+			ISceneNode* parent=0, s32 id=-1, u32 maxChunkVertices=0x10000) = 0;
+
+		//! Adds a scene node which culls small clusters of triangles of a mesh separately.
+		/** The triangle lists of the mesh are split into clusters with
+		IMeshManipulator::createClusteredMesh(). Clusters outside of the
+		view frustum, and for materials with backface culling those facing
+		away from the camera, are not drawn. This helps with large meshes
+		of which only a part is visible, especially with drivers which
+		process each triangle on the CPU. Meshes with many small buffers
+		are better drawn with a normal mesh scene node.
+		\param mesh: Static mesh to draw. It is copied, so changing it later
+		has no effect on the node.
+		\param parent: Parent of the scene node. Can be NULL if no parent.
+		\param id: id of the node. This id can be used to identify the node.
+		\param position: Position of the space relative to its parent where the node will be placed.
+		\param rotation: Initial rotation of the scene node.
+		\param scale: Initial scale of the scene node.
+		\param maxVertices: Largest number of vertices in a cluster.
+		\param maxTriangles: Largest number of triangles in a cluster.
+		\return Pointer to the node if successful, otherwise 0.
+		This pointer should not be dropped. See IReferenceCounted::drop() for more information. */
+		virtual IClusteredMeshSceneNode* addClusteredMeshSceneNode(IMesh* mesh, ISceneNode* parent=0, s32 id=-1,
+			const core::vector3df& position = core::vector3df(0,0,0),
+			const core::vector3df& rotation = core::vector3df(0,0,0),
+			const core::vector3df& scale = core::vector3df(1.0f, 1.0f, 1.0f),
+			u32 maxVertices=64, u32 maxTriangles=124) = 0;
+
 		//! Adds a camera scene node to the scene graph and sets it as active camera.
 		/** This camera does not react on user input like for example the one created with
 		addCameraSceneNodeFPS(). If you want to move or animate it, use animators or the
@@ -885,6 +975,53 @@ namespace scene
 			s32 maxLOD=5, E_TERRAIN_PATCH_SIZE patchSize=ETPS_17, s32 smoothFactor=0,
 			bool addAlsoIfHeightmapEmpty = false) = 0;
 
+		//! Adds a scene node for a terrain which is loaded tile by tile while it is drawn.
+		/** Only the tiles around the camera are kept in memory, so the
+		heightmap can be much larger than the memory. See
+		IPagedTerrainSceneNode for details.
+		\param heightMapFileName: RAW file with 16 bit heights in the native
+		byte order, with rows along the x axis. It can also be inside of an
+		archive added to the file system.
+		\param heightmapSize: Number of height samples in x and z direction.
+		Heightmaps larger than io::IReadFile::seek() can reach, which is
+		2 GB on systems with a 32 bit long, are rejected with an error and
+		the node stays flat.
+		\param parent: Parent of the scene node. Can be 0 if no parent.
+		\param id: Id of the node. This id can be used to identify the scene node.
+		\param position: Position of the space relative to its parent where the node will be placed.
+		\param rotation: Initial rotation of the scene node.
+		\param scale: Initial scale of the scene node. One height sample is
+		one unit in x and z direction, and a height of 256 is one unit in y
+		direction before scaling.
+		\param tileSize: Number of quads along a side of a tile, it is
+		rounded up to a power of two.
+		\param maxLOD: Number of levels of detail of the tiles.
+		\return Pointer to the created scene node, or 0 if the file could
+		not be opened. This pointer should not be dropped. See
+		IReferenceCounted::drop() for more information. */
+		virtual IPagedTerrainSceneNode* addPagedTerrainSceneNode(
+			const io::path& heightMapFileName, const core::dimension2du& heightmapSize,
+			ISceneNode* parent=0, s32 id=-1,
+			const core::vector3df& position = core::vector3df(0.0f,0.0f,0.0f),
+			const core::vector3df& rotation = core::vector3df(0.0f,0.0f,0.0f),
+			const core::vector3df& scale = core::vector3df(1.0f,1.0f,1.0f),
+			u32 tileSize=64, s32 maxLOD=5) = 0;
+
+		//! Adds a scene node for a terrain which is loaded tile by tile while it is drawn.
+		/** Just like the other addPagedTerrainSceneNode() method, but takes
+		an IReadFile pointer as parameter for the heightmap. Files on disk
+		are opened again for the background thread which loads the tiles.
+		Other files, like files inside of archives, are read on the main
+		thread when a tile is requested, which changes their position.
+		For more information take a look at the other function. */
+		virtual IPagedTerrainSceneNode* addPagedTerrainSceneNode(
+			io::IReadFile* heightMapFile, const core::dimension2du& heightmapSize,
+			ISceneNode* parent=0, s32 id=-1,
+			const core::vector3df& position = core::vector3df(0.0f,0.0f,0.0f),
+			const core::vector3df& rotation = core::vector3df(0.0f,0.0f,0.0f),
+			const core::vector3df& scale = core::vector3df(1.0f,1.0f,1.0f),
+			u32 tileSize=64, s32 maxLOD=5) = 0;
+
 		//! Adds a quake3 scene node to the scene graph.
 		/** A Quake3 Scene renders multiple meshes for a specific HighLanguage Shader (Quake3 Style )
 		\return Pointer to the quake3 scene node if successful, otherwise NULL.
@@ -893,6 +1030,18 @@ namespace scene
 												ISceneNode* parent=0, s32 id=-1
 												) = 0;
 
+		//! Adds a scene node drawing the geometry of a quake3 level to the scene graph.
+		/** Only the parts of the level which can be seen from the camera
+		are drawn, using the BSP tree and the visibility information stored
+		in the level. See IQ3LevelSceneNode for details.
+		\param mesh: The level, as loaded by getMesh() from a .bsp file.
+		\param parent: Parent node of the level node.
+		\param id: id of the node. This id can be used to identify the node.
+		\return Pointer to the level node if successful, otherwise 0.
+		This pointer should not be dropped. See IReferenceCounted::drop() for more information. */
+		virtual IQ3LevelSceneNode* addQuake3LevelSceneNode(IQ3LevelMesh* mesh,
+			ISceneNode* parent=0, s32 id=-1) = 0;
+
 
 		//! Adds an empty scene node to the scene graph.
 		/** Can be used for doing advanced transformations
@@ -1115,7 +1264,10 @@ namespace scene
 		\param pass: Specifies when the node wants to be drawn in relation to the other nodes.
 		For example, if the node is a shadow, it usually wants to be drawn after all other nodes
 		and will use ESNRP_SHADOW for this. See scene::E_SCENE_NODE_RENDER_PASS for details.
-		\return scene will be rendered ( passed culling ) */
+		\return scene will be rendered ( passed culling ). Nodes using
+		EAC_FRUSTUM_BOX culling are tested against the view frustum all at
+		once after all nodes registered themselves, for those 1 only means
+		that they passed the other culling tests. */
 		virtual u32 registerNodeForRendering(ISceneNode* node,
 			E_SCENE_NODE_RENDER_PASS pass = ESNRP_AUTOMATIC) = 0;
 
@@ -1671,6 +1823,32 @@ namespace scene
 		\return True if node is not visible in the current scene, else
 		false. */
 		virtual bool isCulled(const ISceneNode* node) const =0;
+
+		//! Get the number of scene nodes which passed the culling tests in the last drawAll() call.
+		/** Only nodes registered for render passes which are culled
+		(solid, transparent, effect, shadow and automatic) are counted. */
+		virtual u32 getVisibleNodeCount() const =0;
+
+		//! Get the number of scene nodes which were culled in the last drawAll() call.
+		virtual u32 getCulledNodeCount() const =0;
+
+		//! Adds a scene node which hides the nodes behind it in the software occlusion culling.
+		/** Occluders are rasterized into a small depth buffer on the CPU
+		each frame when the SOFTWARE_OCCLUSION_CULLING scene parameter is
+		set. All nodes which have automatic culling enabled are tested
+		against it before rendering. Good occluders are large, have few
+		triangles and are completely solid, like walls and buildings.
+		The occluder is only used while the node is visible and part of
+		the scene. Occluders which were removed from the scene are released
+		once the scene manager holds the last reference to them.
+		\param node The occluding node, its absolute transformation is used.
+		\param mesh Mesh used for rasterizing, usually a simplified version
+		of the visible mesh. It must not be larger than the visible
+		geometry. If 0, the mesh of mesh scene nodes is used. */
+		virtual void addOccluder(ISceneNode* node, IMesh* mesh=0) =0;
+
+		//! Removes a node added with addOccluder().
+		virtual void removeOccluder(ISceneNode* node) =0;
 	};
 
 
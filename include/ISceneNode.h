@@ -17,6 +17,7 @@
 #include "matrix4.h"
 #include "irrList.h"
 #include "IAttributes.h"
+#include "STransformHierarchy.h"
 
 namespace irr
 {
@@ -39,6 +40,8 @@ namespace scene
 	*/
 	class ISceneNode : virtual public io::IAttributeExchangingObject
 	{
+		friend class CSceneManager;
+
 	public:
 
 		//! Constructor
@@ -49,7 +52,9 @@ namespace scene
 			: RelativeTranslation(position), RelativeRotation(rotation), RelativeScale(scale),
 				Parent(0), SceneManager(mgr), TriangleSelector(0), ID(id),
 				AutomaticCullingState(EAC_BOX), DebugDataVisible(EDS_OFF),
-				IsVisible(true), IsDebugObject(false)
+				AbsoluteTransformationChangeCount(0), ParentTransformationChangeCount(0),
+				TransformHierarchy(0), TransformHierarchyIndex(-1), FrustumCullingPlane(0xff),
+				IsVisible(true), IsDebugObject(false), RelativeTransformationChanged(true)
 		{
 			if (parent)
 				parent->addChild(this);
@@ -61,6 +66,9 @@ namespace scene
 		//! Destructor
 		virtual ~ISceneNode()
 		{
+			if (TransformHierarchy)
+				TransformHierarchy->removeNode(TransformHierarchyIndex, this);
+
 			// delete all children
 			removeAll();
 
@@ -267,6 +275,7 @@ namespace scene
 		virtual void setVisible(bool isVisible)
 		{
 			IsVisible = isVisible;
+			updateTransformHierarchyVisibility();
 		}
 
 
@@ -304,6 +313,9 @@ namespace scene
 				child->remove(); // remove from old parent
 				Children.push_back(child);
 				child->Parent = this;
+				child->setTransformationDirty();
+				if (TransformHierarchy)
+					TransformHierarchy->HierarchyChanged = true;
 			}
 		}
 
@@ -321,8 +333,11 @@ namespace scene
 				if ((*it) == child)
 				{
 					(*it)->Parent = 0;
+					(*it)->setTransformationDirty();
 					(*it)->drop();
 					Children.erase(it);
+					if (TransformHierarchy)
+						TransformHierarchy->HierarchyChanged = true;
 					return true;
 				}
 
@@ -340,10 +355,13 @@ namespace scene
 			for (; it != Children.end(); ++it)
 			{
 				(*it)->Parent = 0;
+				(*it)->setTransformationDirty();
 				(*it)->drop();
 			}
 
 			Children.clear();
+			if (TransformHierarchy)
+				TransformHierarchy->HierarchyChanged = true;
 		}
 
 
@@ -365,6 +383,8 @@ namespace scene
 			{
 				Animators.push_back(animator);
 				animator->grab();
+				if (TransformHierarchy)
+					TransformHierarchy->setFlags(TransformHierarchyIndex, ETHF_ANIMATED);
 			}
 		}
 
@@ -482,6 +502,7 @@ namespace scene
 		virtual void setScale(const core::vector3df& scale)
 		{
 			RelativeScale = scale;
+			setTransformationDirty();
 		}
 
 
@@ -502,6 +523,7 @@ namespace scene
 		virtual void setRotation(const core::vector3df& rotation)
 		{
 			RelativeRotation = rotation;
+			setTransformationDirty();
 		}
 
 
@@ -521,6 +543,7 @@ namespace scene
 		virtual void setPosition(const core::vector3df& newpos)
 		{
 			RelativeTranslation = newpos;
+			setTransformationDirty();
 		}
 
 
@@ -661,16 +684,46 @@ namespace scene
 
 		//! Updates the absolute position based on the relative and the parents position
 		/** Note: This does not recursively update the parents absolute positions, so if you have a deeper
-			hierarchy you might want to update the parents first.*/
+			hierarchy you might want to update the parents first.
+			The absolute transformation is only recalculated when the relative transformation
+			or the absolute transformation of the parent changed since the last update. */
 		virtual void updateAbsolutePosition()
 		{
 			if (Parent)
 			{
+				if (!RelativeTransformationChanged &&
+					ParentTransformationChangeCount == Parent->AbsoluteTransformationChangeCount)
+					return;
+
 				AbsoluteTransformation =
 					Parent->getAbsoluteTransformation() * getRelativeTransformation();
+				ParentTransformationChangeCount = Parent->AbsoluteTransformationChangeCount;
 			}
 			else
+			{
+				if (!RelativeTransformationChanged)
+					return;
+
 				AbsoluteTransformation = getRelativeTransformation();
+			}
+
+			RelativeTransformationChanged = false;
+			++AbsoluteTransformationChangeCount;
+			if (TransformHierarchy)
+				TransformHierarchy->setFlags(TransformHierarchyIndex, ETHF_ABSOLUTE_CHANGED);
+		}
+
+
+		//! Forces a recalculation of the absolute transformation on the next updateAbsolutePosition().
+		/** setPosition(), setRotation() and setScale() do this automatically. Derived
+		scene nodes which modify RelativeTranslation, RelativeRotation or RelativeScale
+		directly, or which calculate their own getRelativeTransformation(), have to call
+		this whenever their relative transformation changes. */
+		void setTransformationDirty()
+		{
+			RelativeTransformationChanged = true;
+			if (TransformHierarchy)
+				TransformHierarchy->setFlags(TransformHierarchyIndex, ETHF_RELATIVE_CHANGED);
 		}
 
 
@@ -690,6 +743,18 @@ namespace scene
 		}
 
 
+		//! Returns if the node uses the transformation handling of ISceneNode unchanged.
+		/** The flat transform hierarchy (see FLAT_TRANSFORM_HIERARCHY) updates
+		such nodes and their children itself instead of calling OnAnimate() and
+		updateAbsolutePosition(). Nodes overriding one of these functions must
+		return false, which is the default.
+		\return True if OnAnimate() and updateAbsolutePosition() are not overridden. */
+		virtual bool hasPlainTransformation() const
+		{
+			return false;
+		}
+
+
 		//! Writes attributes of the scene node.
 		/** Implement this to expose the attributes of your scene node
 		for scripting languages, editors, debuggers or xml
@@ -734,6 +799,7 @@ namespace scene
 			setScale(in->getAttributeAsVector3d("Scale", RelativeScale));
 
 			IsVisible = in->getAttributeAsBool("Visible", IsVisible);
+			updateTransformHierarchyVisibility();
 			if (in->existsAttribute("AutomaticCulling"))
 			{
 				s32 tmpState = in->getAttributeAsEnumeration("AutomaticCulling",
@@ -765,6 +831,17 @@ namespace scene
 
 	protected:
 
+		//! Forwards the visibility to the flat transform hierarchy, if the node is stored in one.
+		void updateTransformHierarchyVisibility()
+		{
+			if (!TransformHierarchy)
+				return;
+			if (IsVisible)
+				TransformHierarchy->setFlags(TransformHierarchyIndex, ETHF_VISIBLE|ETHF_RELATIVE_CHANGED);
+			else
+				TransformHierarchy->clearFlags(TransformHierarchyIndex, ETHF_VISIBLE);
+		}
+
 		//! A clone function for the ISceneNode members.
 		/** This method can be used by clone() implementations of
 		derived classes
@@ -777,11 +854,13 @@ namespace scene
 			RelativeTranslation = toCopyFrom->RelativeTranslation;
 			RelativeRotation = toCopyFrom->RelativeRotation;
 			RelativeScale = toCopyFrom->RelativeScale;
+			setTransformationDirty();
 			ID = toCopyFrom->ID;
 			setTriangleSelector(toCopyFrom->TriangleSelector);
 			AutomaticCullingState = toCopyFrom->AutomaticCullingState;
 			DebugDataVisible = toCopyFrom->DebugDataVisible;
 			IsVisible = toCopyFrom->IsVisible;
+			updateTransformHierarchyVisibility();
 			IsDebugObject = toCopyFrom->IsDebugObject;
 
 			if (newManager)
@@ -859,11 +938,31 @@ namespace scene
 		//! Flag if debug data should be drawn, such as Bounding Boxes.
 		u32 DebugDataVisible;
 
+		//! Increased each time the absolute transformation is recalculated.
+		/** Children compare it with ParentTransformationChangeCount to find out
+		if they have to recalculate their own absolute transformation. */
+		u32 AbsoluteTransformationChangeCount;
+
+		//! AbsoluteTransformationChangeCount of the parent at the last update.
+		u32 ParentTransformationChangeCount;
+
+		//! Flat transform hierarchy of the scene manager this node is stored in, or 0.
+		STransformHierarchy* TransformHierarchy;
+
+		//! Index of this node in TransformHierarchy, -1 for the root node.
+		s32 TransformHierarchyIndex;
+
+		//! Frustum plane which culled the node in the last frame, tested first by the scene manager.
+		u8 FrustumCullingPlane;
+
 		//! Is the node visible?
 		bool IsVisible;
 
 		//! Is debug object?
 		bool IsDebugObject;
+
+		//! Set when the relative transformation changed since the last updateAbsolutePosition()
+		bool RelativeTransformationChanged;
 	};
 
 
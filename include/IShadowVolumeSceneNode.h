@@ -14,6 +14,13 @@ namespace scene
 	class IMesh;
 
 	//! Scene node for rendering a shadow volume into a stencil buffer.
+	/** The shadow volumes are cached. Earlier versions rebuilt them on
+	every update, now they are only rebuilt when a light moved relative to
+	the node or the shadow mesh changed. Code which modifies the vertices or
+	indices of the shadow mesh directly has to call IMeshBuffer::setDirty()
+	on the changed buffers, otherwise the shadows keep the old shape.
+	The null driver creates shadow volume nodes as well, it builds the
+	volumes but doesn't draw them. */
 	class IShadowVolumeSceneNode : public ISceneNode
 	{
 	public:
@@ -28,7 +35,26 @@ namespace scene
 		virtual void setShadowMesh(const IMesh* mesh) = 0;
 
 		//! Updates the shadow volumes for current light positions.
+		/** A shadow volume is only rebuilt when the position of its light
+		relative to the node changed, or when the change IDs of the shadow
+		mesh buffers changed. Call IMeshBuffer::setDirty() after modifying
+		the shadow mesh, otherwise the old volumes are kept. */
 		virtual void updateShadowVolumes() = 0;
+
+		//! Sets the number of threads which build the shadow volumes of different lights.
+		/** Each thread builds the volumes of other lights, so this only
+		helps when several lights change at the same time.
+		\param threadCount Number of threads including the calling thread,
+		0 uses one thread per processor. Default is 1. */
+		virtual void setUpdateThreadCount(u32 threadCount) = 0;
+
+		//! Returns the number of threads which build the shadow volumes.
+		virtual u32 getUpdateThreadCount() const = 0;
+
+		//! Returns the number of shadow volumes which were rebuilt by the last update.
+		/** Volumes of lights which didn't move relative to the node are
+		taken from the last update and not counted. */
+		virtual u32 getRebuiltVolumeCount() const = 0;
 	};
 
 } // end namespace scene
@@ -134,6 +134,27 @@ namespace scene
 		size. */
 		virtual bool overrideLODDistance(s32 LOD, f64 newDistance) =0;
 
+		//! Sets the largest height error of a patch on the screen.
+		/** Each visible patch is drawn with the coarsest LOD whose
+		largest height error, projected onto the screen, is at most
+		this many pixels. Flat patches get a coarse LOD even close to
+		the camera, rough patches keep their detail further away.
+		Overriding a LOD distance with overrideLODDistance() sets this
+		to 0, which selects the LODs by the distance thresholds.
+		\param pixels Largest error in pixels, the default is 2. */
+		virtual void setMaxScreenSpaceError(f32 pixels) =0;
+
+		//! Get the largest height error of a patch on the screen.
+		/** \return Largest error in pixels, 0 if the LODs are selected
+		by the distance thresholds. */
+		virtual f32 getMaxScreenSpaceError() const =0;
+
+		//! Get the number of patches drawn with a LOD.
+		/** \param LOD The level of detail, or -1 for all drawn patches.
+		\return Number of patches with this LOD at the last update of
+		the indices. */
+		virtual u32 getDrawnPatchCount(s32 LOD=-1) const =0;
+
 		//! Scales the base texture, similar to makePlanarTextureMapping.
 		/** \param scale The scaling amount. Values above 1.0
 		increase the number of time the texture is drawn on the
@@ -134,6 +134,26 @@ while it runs and enabling it will slow down the engine. */
 #undef _IRR_COMPILE_WITH_PROFILING_
 #endif
 
+//! Define _IRR_COMPILE_WITH_THREADS_ to allow the engine to split up some work onto worker threads.
+/** Uses pthreads on all platforms except Windows, so you might have to link with -lpthread.
+Without this define all work is done on the calling thread. Worker threads are only used
+when enabled by the application, for example with the scene::PARALLEL_ANIMATION_THREADS
+scene parameter. */
+#define _IRR_COMPILE_WITH_THREADS_
+#ifdef NO_IRR_COMPILE_WITH_THREADS_
+#undef _IRR_COMPILE_WITH_THREADS_
+#endif
+
+//! Define _IRR_COMPILE_WITH_SSE_ to use SSE instructions in some inner loops of the engine.
+/** It's enabled automatically when the compiler targets processors with SSE, like all
+x86-64 compilers do. Otherwise plain C++ code with the same results is used. */
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define _IRR_COMPILE_WITH_SSE_
+#endif
+#ifdef NO_IRR_COMPILE_WITH_SSE_
+#undef _IRR_COMPILE_WITH_SSE_
+#endif
+
 //! Define _IRR_COMPILE_WITH_DIRECT3D_9_ to compile the Irrlicht engine with DIRECT3D9.
 /** If you only want to use the software device or opengl you can disable those defines.
 This switch is mostly disabled because people do not get the g++ compiler compile
@@ -391,6 +411,11 @@ B3D, MS3D or X meshes */
 #ifdef NO_IRR_COMPILE_WITH_IRR_MESH_LOADER_
 #undef _IRR_COMPILE_WITH_IRR_MESH_LOADER_
 #endif
+//! Define _IRR_COMPILE_WITH_IRR_BINARY_MESH_LOADER_ if you want to load binary Irrlicht Engine .irrbmesh files
+#define _IRR_COMPILE_WITH_IRR_BINARY_MESH_LOADER_
+#ifdef NO_IRR_COMPILE_WITH_IRR_BINARY_MESH_LOADER_
+#undef _IRR_COMPILE_WITH_IRR_BINARY_MESH_LOADER_
+#endif
 //! Define _IRR_COMPILE_WITH_HALFLIFE_LOADER_ if you want to load Halflife animated files
 #define _IRR_COMPILE_WITH_HALFLIFE_LOADER_
 #ifdef NO_IRR_COMPILE_WITH_HALFLIFE_LOADER_
@@ -477,6 +502,11 @@ B3D, MS3D or X meshes */
 #ifdef NO_IRR_COMPILE_WITH_IRR_WRITER_
 #undef _IRR_COMPILE_WITH_IRR_WRITER_
 #endif
+//! Define _IRR_COMPILE_WITH_IRR_BINARY_WRITER_ if you want to write binary .irrbmesh files
+#define _IRR_COMPILE_WITH_IRR_BINARY_WRITER_
+#ifdef NO_IRR_COMPILE_WITH_IRR_BINARY_WRITER_
+#undef _IRR_COMPILE_WITH_IRR_BINARY_WRITER_
+#endif
 //! Define _IRR_COMPILE_WITH_COLLADA_WRITER_ if you want to write Collada files
 #define _IRR_COMPILE_WITH_COLLADA_WRITER_
 #ifdef NO_IRR_COMPILE_WITH_COLLADA_WRITER_
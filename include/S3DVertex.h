@@ -8,6 +8,7 @@
 #include "vector3d.h"
 #include "vector2d.h"
 #include "SColor.h"
+#include "aabbox3d.h"
 
 namespace irr
 {
@@ -26,7 +27,15 @@ enum E_VERTEX_TYPE
 
 	//! Vertex with a tangent and binormal vector, video::S3DVertexTangents.
 	/** Usually used for tangent space normal mapping. */
-	EVT_TANGENTS
+	EVT_TANGENTS,
+
+	//! Compressed standard vertex, video::S3DVertexQuantized.
+	/** Uses 20 instead of 36 bytes, mainly for large static geometry. */
+	EVT_QUANTIZED,
+
+	//! Compressed vertex with tangent and binormal, video::S3DVertexQuantizedTangents.
+	/** Uses 28 instead of 60 bytes. */
+	EVT_QUANTIZED_TANGENTS
 };
 
 //! Array holding the built in vertex type names
@@ -35,6 +44,8 @@ const char* const sBuiltInVertexTypeNames[] =
 	"standard",
 	"2tcoords",
 	"tangents",
+	"quantized",
+	"quantizedtangents",
 	0
 };
 
@@ -252,6 +263,276 @@ struct S3DVertexTangents : public S3DVertex
 };
 
 
+//! Encodes a direction with the octahedral mapping into two 16 bit values
+/** The direction is projected onto an octahedron, which is unfolded into a
+square. This keeps the error nearly the same for all directions. A zero
+vector is encoded as (0,0,1). */
+inline void encodeOctahedral(const core::vector3df& dir, s16* out)
+{
+	const f32 length = core::abs_(dir.X) + core::abs_(dir.Y) + core::abs_(dir.Z);
+	if (length == 0.f)
+	{
+		out[0] = out[1] = 0;
+		return;
+	}
+
+	f32 x = dir.X / length;
+	f32 y = dir.Y / length;
+	if (dir.Z < 0.f)
+	{
+		// fold the lower half over the diagonals
+		const f32 fx = (1.f - core::abs_(y)) * (x < 0.f ? -1.f : 1.f);
+		y = (1.f - core::abs_(x)) * (y < 0.f ? -1.f : 1.f);
+		x = fx;
+	}
+	out[0] = (s16)core::round32(x * 32767.f);
+	out[1] = (s16)core::round32(y * 32767.f);
+}
+
+//! Decodes a normalized direction encoded with encodeOctahedral()
+inline core::vector3df decodeOctahedral(const s16* in)
+{
+	core::vector3df dir(in[0] / 32767.f, in[1] / 32767.f, 0.f);
+	dir.Z = 1.f - core::abs_(dir.X) - core::abs_(dir.Y);
+	if (dir.Z < 0.f)
+	{
+		const f32 x = (1.f - core::abs_(dir.Y)) * (dir.X < 0.f ? -1.f : 1.f);
+		dir.Y = (1.f - core::abs_(dir.X)) * (dir.Y < 0.f ? -1.f : 1.f);
+		dir.X = x;
+	}
+	return dir.normalize();
+}
+
+
+//! Scale and offset converting the 16 bit positions of quantized vertices to floats.
+/** Each mesh buffer with quantized vertices has its own quantization, so
+the 16 bit range covers just the bounding box of the buffer. */
+struct SVertexQuantization
+{
+	//! Default constructor, positions are used as integers
+	SVertexQuantization() : Offset(0.f,0.f,0.f), Scale(1.f,1.f,1.f) {}
+
+	//! Creates a quantization covering a box with the full 16 bit range
+	SVertexQuantization(const core::aabbox3df& box)
+		: Offset(box.getCenter()), Scale(box.getExtent() * (0.5f / 32767.f)) {}
+
+	//! Decodes a quantized position
+	core::vector3df decode(const s16* pos) const
+	{
+		return core::vector3df(Offset.X + pos[0] * Scale.X,
+			Offset.Y + pos[1] * Scale.Y, Offset.Z + pos[2] * Scale.Z);
+	}
+
+	//! Quantizes a position, positions outside of the range are clamped
+	void encode(const core::vector3df& pos, s16* out) const
+	{
+		out[0] = encode(pos.X - Offset.X, Scale.X);
+		out[1] = encode(pos.Y - Offset.Y, Scale.Y);
+		out[2] = encode(pos.Z - Offset.Z, Scale.Z);
+	}
+
+	bool operator==(const SVertexQuantization& other) const
+	{
+		return Offset == other.Offset && Scale == other.Scale;
+	}
+
+	bool operator!=(const SVertexQuantization& other) const
+	{
+		return !(*this == other);
+	}
+
+	//! Position of quantized value 0
+	core::vector3df Offset;
+
+	//! Distance between two quantized values along each axis
+	core::vector3df Scale;
+
+private:
+
+	static s16 encode(f32 value, f32 scale)
+	{
+		if (scale == 0.f)
+			return 0;
+		return (s16)core::s32_clamp(core::round32(value / scale), -32767, 32767);
+	}
+};
+
+
+//! Compressed standard vertex.
+/** The position is stored with 16 bit integers, which are converted with
+the SVertexQuantization of the mesh buffer, the normal with the octahedral
+mapping and the texture coordinates as half floats. So it needs 20 instead
+of 36 bytes. Use the get and set methods to access the values, or convert
+whole meshes with IMeshManipulator::createMeshQuantized(). */
+struct S3DVertexQuantized
+{
+	//! default constructor
+	S3DVertexQuantized() {}
+
+	//! constructor compressing a standard vertex
+	S3DVertexQuantized(const S3DVertex& v, const SVertexQuantization& quantization)
+	{
+		set(v, quantization);
+	}
+
+	//! Compresses a standard vertex
+	void set(const S3DVertex& v, const SVertexQuantization& quantization)
+	{
+		setPosition(v.Pos, quantization);
+		setNormal(v.Normal);
+		Color = v.Color;
+		setTCoords(v.TCoords);
+	}
+
+	//! Decompresses into a standard vertex
+	S3DVertex get(const SVertexQuantization& quantization) const
+	{
+		return S3DVertex(getPosition(quantization), getNormal(), Color, getTCoords());
+	}
+
+	core::vector3df getPosition(const SVertexQuantization& quantization) const
+	{
+		return quantization.decode(Pos);
+	}
+
+	void setPosition(const core::vector3df& pos, const SVertexQuantization& quantization)
+	{
+		quantization.encode(pos, Pos);
+		Pos[3] = 0;
+	}
+
+	core::vector3df getNormal() const
+	{
+		return decodeOctahedral(Normal);
+	}
+
+	void setNormal(const core::vector3df& normal)
+	{
+		encodeOctahedral(normal, Normal);
+	}
+
+	core::vector2df getTCoords() const
+	{
+		return core::vector2df(core::f16_to_f32(TCoords[0]), core::f16_to_f32(TCoords[1]));
+	}
+
+	void setTCoords(const core::vector2df& tcoords)
+	{
+		TCoords[0] = core::f32_to_f16(tcoords.X);
+		TCoords[1] = core::f32_to_f16(tcoords.Y);
+	}
+
+	//! Quantized position, the fourth value is unused
+	s16 Pos[4];
+
+	//! Octahedral encoded normal vector
+	s16 Normal[2];
+
+	//! Color
+	SColor Color;
+
+	//! Texture coordinates as half floats
+	u16 TCoords[2];
+
+	bool operator==(const S3DVertexQuantized& other) const
+	{
+		return Pos[0] == other.Pos[0] && Pos[1] == other.Pos[1] && Pos[2] == other.Pos[2] &&
+			Normal[0] == other.Normal[0] && Normal[1] == other.Normal[1] && Color == other.Color &&
+			TCoords[0] == other.TCoords[0] && TCoords[1] == other.TCoords[1];
+	}
+
+	bool operator!=(const S3DVertexQuantized& other) const
+	{
+		return !(*this == other);
+	}
+
+	E_VERTEX_TYPE getType() const
+	{
+		return EVT_QUANTIZED;
+	}
+};
+
+
+//! Compressed vertex with a tangent and binormal vector.
+/** Like S3DVertexQuantized, with octahedral encoded tangent and binormal.
+Needs 28 instead of 60 bytes. */
+struct S3DVertexQuantizedTangents : public S3DVertexQuantized
+{
+	//! default constructor
+	S3DVertexQuantizedTangents() {}
+
+	//! constructor compressing a tangent vertex
+	S3DVertexQuantizedTangents(const S3DVertexTangents& v, const SVertexQuantization& quantization)
+	{
+		set(v, quantization);
+	}
+
+	//! Compresses a tangent vertex
+	void set(const S3DVertexTangents& v, const SVertexQuantization& quantization)
+	{
+		S3DVertexQuantized::set(v, quantization);
+		setTangent(v.Tangent);
+		setBinormal(v.Binormal);
+	}
+
+	//! Decompresses into a tangent vertex
+	S3DVertexTangents get(const SVertexQuantization& quantization) const
+	{
+		return S3DVertexTangents(getPosition(quantization), getNormal(), Color,
+			getTCoords(), getTangent(), getBinormal());
+	}
+
+	core::vector3df getTangent() const
+	{
+		return decodeOctahedral(Tangent);
+	}
+
+	void setTangent(const core::vector3df& tangent)
+	{
+		encodeOctahedral(tangent, Tangent);
+	}
+
+	core::vector3df getBinormal() const
+	{
+		return decodeOctahedral(Binormal);
+	}
+
+	void setBinormal(const core::vector3df& binormal)
+	{
+		encodeOctahedral(binormal, Binormal);
+	}
+
+	//! Octahedral encoded tangent vector
+	s16 Tangent[2];
+
+	//! Octahedral encoded binormal vector
+	s16 Binormal[2];
+
+	bool operator==(const S3DVertexQuantizedTangents& other) const
+	{
+		return S3DVertexQuantized::operator==(other) &&
+			Tangent[0] == other.Tangent[0] && Tangent[1] == other.Tangent[1] &&
+			Binormal[0] == other.Binormal[0] && Binormal[1] == other.Binormal[1];
+	}
+
+	bool operator!=(const S3DVertexQuantizedTangents& other) const
+	{
+		return !(*this == other);
+	}
+
+	E_VERTEX_TYPE getType() const
+	{
+		return EVT_QUANTIZED_TANGENTS;
+	}
+};
+
+
+//! Returns if vertices of a type have to be decoded with a video::SVertexQuantization
+inline bool isQuantizedVertexType(E_VERTEX_TYPE vertexType)
+{
+	return vertexType == EVT_QUANTIZED || vertexType == EVT_QUANTIZED_TANGENTS;
+}
+
 
 inline u32 getVertexPitchFromType(E_VERTEX_TYPE vertexType)
 {
@@ -261,6 +542,10 @@ inline u32 getVertexPitchFromType(E_VERTEX_TYPE vertexType)
 		return sizeof(video::S3DVertex2TCoords);
 	case video::EVT_TANGENTS:
 		return sizeof(video::S3DVertexTangents);
+	case video::EVT_QUANTIZED:
+		return sizeof(video::S3DVertexQuantized);
+	case video::EVT_QUANTIZED_TANGENTS:
+		return sizeof(video::S3DVertexQuantizedTangents);
 	default:
 		return sizeof(video::S3DVertex);
 	}
@@ -0,0 +1,63 @@
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#ifndef __S_MESH_CLUSTER_H_INCLUDED__
+#define __S_MESH_CLUSTER_H_INCLUDED__
+
+#include "vector3d.h"
+
+namespace irr
+{
+namespace scene
+{
+
+	//! A small group of neighboring triangles of a mesh buffer, see IMeshManipulator::createClusteredMesh()
+	/** The triangles of a cluster are stored one after another in the index
+	list of the mesh buffer, so a cluster can be drawn as a range of indices.
+	All values are in the space of the mesh. */
+	struct SMeshCluster
+	{
+		//! Index of the mesh buffer in the mesh
+		u32 MeshBuffer;
+
+		//! First index of the cluster in the index list of the mesh buffer
+		u32 FirstIndex;
+
+		//! Number of triangles in the cluster
+		u32 TriangleCount;
+
+		//! Number of different vertices used by the triangles
+		u32 VertexCount;
+
+		//! Center of a sphere containing all triangles
+		core::vector3df Center;
+
+		//! Radius of the sphere containing all triangles
+		f32 Radius;
+
+		//! Average direction of the triangle normals
+		core::vector3df ConeAxis;
+
+		//! Tip of the cone, behind all triangle planes
+		core::vector3df ConeApex;
+
+		//! Sine of the largest angle between ConeAxis and a triangle normal.
+		/** All triangles face away from a viewer at position p when
+		(ConeApex-p).dotProduct(ConeAxis) >= ConeCutoff*(ConeApex-p).getLength().
+		It is 1 when the normals are spread too far for such a test. */
+		f32 ConeCutoff;
+
+		//! Returns true if all triangles face away from a viewer at the given position
+		bool isBackFacing(const core::vector3df& viewer) const
+		{
+			if (ConeCutoff >= 1.f)
+				return false;
+			const core::vector3df direction = ConeApex - viewer;
+			return direction.dotProduct(ConeAxis) >= ConeCutoff * direction.getLength();
+		}
+	};
+
+} // end namespace scene
+} // end namespace irr
+
+#endif
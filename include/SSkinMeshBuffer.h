@@ -21,7 +21,7 @@ struct SSkinMeshBuffer : public IMeshBuffer
 	//! Default constructor
 	SSkinMeshBuffer(video::E_VERTEX_TYPE vt=video::EVT_STANDARD) :
 		ChangedID_Vertex(1), ChangedID_Index(1), VertexType(vt),
-		PrimitiveType(EPT_TRIANGLES),
+		IndexType(video::EIT_16BIT), PrimitiveType(EPT_TRIANGLES),
 		MappingHint_Vertex(EHM_NEVER), MappingHint_Index(EHM_NEVER),
 		BoundingBoxNeedsRecalculated(true)
 	{
@@ -102,27 +102,71 @@ struct SSkinMeshBuffer : public IMeshBuffer
 	/** \return Index type of this buffer. */
 	virtual video::E_INDEX_TYPE getIndexType() const
 	{
-		return video::EIT_16BIT;
+		return IndexType;
 	}
 
 	//! Get pointer to index array
+	/** Points to Indices32 if the index type is video::EIT_32BIT. */
 	virtual const u16* getIndices() const
 	{
+		if (IndexType == video::EIT_32BIT)
+			return (const u16*)Indices32.const_pointer();
 		return Indices.const_pointer();
 	}
 
 	//! Get pointer to index array
+	/** Points to Indices32 if the index type is video::EIT_32BIT. */
 	virtual u16* getIndices()
 	{
+		if (IndexType == video::EIT_32BIT)
+			return (u16*)Indices32.pointer();
 		return Indices.pointer();
 	}
 
 	//! Get index count
 	virtual u32 getIndexCount() const
 	{
+		if (IndexType == video::EIT_32BIT)
+			return Indices32.size();
 		return Indices.size();
 	}
 
+	//! Get the index at position i, for both index types
+	u32 getIndex(u32 i) const
+	{
+		if (IndexType == video::EIT_32BIT)
+			return Indices32[i];
+		return Indices[i];
+	}
+
+	//! Add an index, switches to 32 bit indices when it doesn't fit into 16 bit
+	void addIndex(u32 index)
+	{
+		if (IndexType == video::EIT_16BIT)
+		{
+			if (index <= 0xffff)
+			{
+				Indices.push_back((u16)index);
+				return;
+			}
+			convertTo32BitIndices();
+		}
+		Indices32.push_back(index);
+	}
+
+	//! Move the indices to Indices32, for more than 65536 vertices
+	void convertTo32BitIndices()
+	{
+		if (IndexType == video::EIT_32BIT)
+			return;
+		Indices32.reallocate(Indices.allocated_size());
+		for (u32 n=0; n<Indices.size(); ++n)
+			Indices32.push_back(Indices[n]);
+		Indices.clear();
+		IndexType = video::EIT_32BIT;
+		setDirty(EBT_INDEX);
+	}
+
 	//! Get bounding box
 	virtual const core::aabbox3d<f32>& getBoundingBox() const
 	{
@@ -181,6 +225,8 @@ struct SSkinMeshBuffer : public IMeshBuffer
 				}
 				break;
 			}
+			default:
+				break;
 		}
 	}
 
@@ -390,6 +436,8 @@ struct SSkinMeshBuffer : public IMeshBuffer
 	core::array<video::S3DVertex2TCoords> Vertices_2TCoords;
 	core::array<video::S3DVertex> Vertices_Standard;
 	core::array<u16> Indices;
+	//! Indices used instead of Indices if IndexType is video::EIT_32BIT
+	core::array<u32> Indices32;
 
 	u32 ChangedID_Vertex;
 	u32 ChangedID_Index;
@@ -399,6 +447,7 @@ struct SSkinMeshBuffer : public IMeshBuffer
 
 	video::SMaterial Material;
 	video::E_VERTEX_TYPE VertexType;
+	video::E_INDEX_TYPE IndexType;
 
 	core::aabbox3d<f32> BoundingBox;
 
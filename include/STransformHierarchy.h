@@ -0,0 +1,101 @@
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#ifndef __S_TRANSFORM_HIERARCHY_H_INCLUDED__
+#define __S_TRANSFORM_HIERARCHY_H_INCLUDED__
+
+#include "irrArray.h"
+#include "matrix4.h"
+
+namespace irr
+{
+namespace scene
+{
+	class ISceneNode;
+
+	//! Flags of the scene nodes stored in an STransformHierarchy
+	enum E_TRANSFORM_HIERARCHY_FLAG
+	{
+		//! The relative transformation changed, the absolute one has to be recalculated
+		ETHF_RELATIVE_CHANGED = 1,
+
+		//! The absolute transformation was already recalculated, children have to follow
+		ETHF_ABSOLUTE_CHANGED = 2,
+
+		//! The node is visible (but maybe not one of its parents)
+		ETHF_VISIBLE = 4,
+
+		//! The node has animators
+		ETHF_ANIMATED = 8,
+
+		//! The node animates itself and its children with OnAnimate()
+		/** Used for nodes which return false from
+		ISceneNode::hasPlainTransformation(). Children of such nodes
+		are not part of the hierarchy. */
+		ETHF_CUSTOM = 16
+	};
+
+	//! Flat storage of the transformations of a scene graph.
+	/** Used by the scene manager when the FLAT_TRANSFORM_HIERARCHY
+	scene parameter is set. The nodes are sorted so that parents are always
+	stored before their children. This allows updating all absolute
+	transformations in one linear pass over densely packed arrays instead
+	of walking the scene graph, and nodes which don't change are never
+	touched. Scene nodes forward changes of their transformation,
+	visibility and animators into this storage while they are part of it.
+	With PARALLEL_ANIMATION_THREADS, the scene manager uses only the Nodes and
+	HierarchyChanged members, to notice when the jobs of the animation threads
+	have to be regrouped.
+	*/
+	struct STransformHierarchy
+	{
+		STransformHierarchy() : HierarchyChanged(true), RootChangeCount(0) {}
+
+		//! Sets flags of a stored node, invalid indices are ignored.
+		void setFlags(s32 index, u8 flags)
+		{
+			if ((u32)index < Flags.size())
+				Flags[index] |= flags;
+		}
+
+		//! Removes flags of a stored node, invalid indices are ignored.
+		void clearFlags(s32 index, u8 flags)
+		{
+			if ((u32)index < Flags.size())
+				Flags[index] &= ~flags;
+		}
+
+		//! Called when a stored node is deleted.
+		void removeNode(s32 index, const ISceneNode* node)
+		{
+			if ((u32)index < Nodes.size() && Nodes[index] == node)
+				Nodes[index] = 0;
+			HierarchyChanged = true;
+		}
+
+		//! Stored nodes, 0 for nodes which have been deleted since the last rebuild.
+		core::array<ISceneNode*> Nodes;
+
+		//! Index of the parent of each node, -1 for children of the root node.
+		core::array<s32> Parents;
+
+		//! Absolute transformation of each node.
+		core::array<core::matrix4> AbsoluteTransformations;
+
+		//! Combination of E_TRANSFORM_HIERARCHY_FLAG values for each node.
+		core::array<u8> Flags;
+
+		//! State of each node during the last update, used by the children.
+		core::array<u8> States;
+
+		//! Set when nodes were added, removed or moved to another parent, or animated mesh scene nodes got another mesh.
+		bool HierarchyChanged;
+
+		//! Change count of the root transformation at the last update.
+		u32 RootChangeCount;
+	};
+
+} // end namespace scene
+} // end namespace irr
+
+#endif
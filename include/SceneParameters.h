@@ -174,6 +174,66 @@ namespace scene
 	**/
 	const c8* const DEBUG_NORMAL_COLOR = "DEBUG_Normal_Color";
 
+	//! Name of the parameter for animating the scene with several threads.
+	/** When set to a value larger than 1 the scene manager animates its
+	direct children (the top-level hierarchies of the scene) in parallel on
+	that many threads (including the calling thread) in ISceneManager::drawAll().
+	Only use this when the animators and OnAnimate() implementations of
+	different top-level nodes don't modify shared data. Deletion animators
+	are safe to use. Collision response animators are safe as well, the
+	scene collision manager runs one collision query at a time, but their
+	triangle selectors must not be built from nodes animated at the same
+	time by another top-level hierarchy. The default is 0 which animates on the calling thread only.
+	Needs the engine compiled with _IRR_COMPILE_WITH_THREADS_.
+	Use it like this:
+	\code
+	SceneManager->getParameters()->setAttribute(scene::PARALLEL_ANIMATION_THREADS, 4);
+	\endcode
+	**/
+	const c8* const PARALLEL_ANIMATION_THREADS = "Parallel_Animation_Threads";
+
+	//! Name of the parameter for updating transformations from a flat transform hierarchy
+	/** When set, the scene manager keeps the nodes of the scene in a flat
+	array sorted by depth (see STransformHierarchy) and updates the absolute
+	transformations in one linear pass. Only nodes whose transformation
+	changed, whose parent moved or which have animators are touched.
+	Nodes which don't return true from ISceneNode::hasPlainTransformation()
+	are animated with OnAnimate() as before. PARALLEL_ANIMATION_THREADS is ignored while
+	this parameter is set.
+	Use it like this:
+	\code
+	SceneManager->getParameters()->setAttribute(scene::FLAT_TRANSFORM_HIERARCHY, true);
+	\endcode
+	**/
+	const c8* const FLAT_TRANSFORM_HIERARCHY = "Flat_Transform_Hierarchy";
+
+	//! Name of the parameter for enabling software occlusion culling
+	/** When set to a value larger than 0, the occluders added with
+	ISceneManager::addOccluder() are rasterized into a depth buffer of
+	that width on the CPU, the height follows the aspect ratio of the
+	camera. Nodes completely hidden behind the occluders are not rendered.
+	Values around 256 work well, larger buffers are more exact but slower.
+	Use it like this:
+	\code
+	SceneManager->getParameters()->setAttribute(scene::SOFTWARE_OCCLUSION_CULLING, 256);
+	\endcode
+	**/
+	const c8* const SOFTWARE_OCCLUSION_CULLING = "Software_Occlusion_Culling";
+
+	//! Name of the parameter for storing terrains in a compact way
+	/** When set to true, terrain scene nodes loaded afterwards keep only a
+	16 bit height per heightmap sample instead of two full vertices. The
+	vertices of the visible patches are rebuilt from the heights into a
+	small render buffer whenever the visible patches change. This needs
+	far less memory, which helps most with the software and null drivers,
+	but the mesh of the terrain has no vertices then. The default is false.
+	Use it like this:
+	\code
+	SceneManager->getParameters()->setAttribute(scene::TERRAIN_COMPACT_STORAGE, true);
+	\endcode
+	**/
+	const c8* const TERRAIN_COMPACT_STORAGE = "Terrain_Compact_Storage";
+
 
 } // end namespace scene
 } // end namespace irr
@@ -0,0 +1,287 @@
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#ifndef __IRR_HASH_MAP_H_INCLUDED__
+#define __IRR_HASH_MAP_H_INCLUDED__
+
+#include "irrTypes.h"
+#include "irrArray.h"
+#include "irrString.h"
+#include <string.h>
+
+namespace irr
+{
+namespace core
+{
+
+//! Hashes the bytes of a value, for plain structures without padding.
+template <class T>
+struct hash_bytes
+{
+	u32 operator()(const T& value) const
+	{
+		// FNV-1a
+		const u8* p = (const u8*)&value;
+		u32 h = 2166136261u;
+		for (u32 i=0; i<sizeof(T); ++i)
+			h = (h ^ p[i]) * 16777619u;
+		return h;
+	}
+};
+
+//! Compares the bytes of two values, the equality which matches hash_bytes.
+template <class T>
+struct equal_bytes
+{
+	bool operator()(const T& a, const T& b) const
+	{
+		return memcmp(&a, &b, sizeof(T)) == 0;
+	}
+};
+
+//! Default hash function of hashmap, hashes the bytes of the key.
+template <class T>
+struct hash : public hash_bytes<T>
+{
+};
+
+//! Hashes the characters of a string.
+template <typename T, typename TAlloc>
+struct hash<string<T, TAlloc> >
+{
+	u32 operator()(const string<T, TAlloc>& value) const
+	{
+		u32 h = 2166136261u;
+		for (u32 i=0; i<value.size(); ++i)
+			h = (h ^ (u32)value[i]) * 16777619u;
+		return h;
+	}
+};
+
+//! Default equality of hashmap, uses operator==.
+template <class T>
+struct equal_to
+{
+	bool operator()(const T& a, const T& b) const
+	{
+		return a == b;
+	}
+};
+
+
+//! Associative array using a hash table with open addressing.
+/** All entries are stored in a single array in insertion order, and a
+table of slots with linear probing refers to them. So unlike core::map no
+memory is allocated for each entry, and finding a key usually needs one
+comparison instead of one per level of a tree.
+Hash function and equality can be passed as template parameters, keys which
+are equal must have the same hash. For vertices and other plain structures
+use hash_bytes and equal_bytes, operator== of vectors uses a tolerance.
+Pointers to nodes become invalid when entries are inserted or removed. */
+template <class KeyType, class ValueType, class HashFunc = hash<KeyType>, class EqualFunc = equal_to<KeyType> >
+class hashmap
+{
+public:
+
+	//! Entry of the map
+	class Node
+	{
+	public:
+
+		Node(const KeyType& key, const ValueType& value, u32 keyHash)
+			: Key(key), Value(value), Hash(keyHash) {}
+
+		const KeyType& getKey() const { return Key; }
+
+		ValueType& getValue() { return Value; }
+
+		const ValueType& getValue() const { return Value; }
+
+		void setValue(const ValueType& value) { Value = value; }
+
+	private:
+
+		friend class hashmap;
+
+		KeyType Key;
+		ValueType Value;
+		u32 Hash;
+	};
+
+	//! Makes room for count entries, so inserting them doesn't have to grow the table.
+	void reserve(u32 count)
+	{
+		Nodes.reallocate(count);
+		if (count*2 > Slots.size())
+			rehash(count*2);
+	}
+
+	//! Inserts a new key.
+	/** \param key The key to insert.
+	\param value The value of the key.
+	\return True if the key was inserted, false if it already exists. */
+	bool insert(const KeyType& key, const ValueType& value)
+	{
+		const u32 keyHash = HashFunc()(key);
+		if ((Nodes.size()+1)*2 > Slots.size())
+			rehash(Slots.size()*2);
+
+		const u32 slot = findSlot(key, keyHash);
+		if (Slots[slot])
+			return false;
+
+		Nodes.push_back(Node(key, value, keyHash));
+		Slots[slot] = Nodes.size();
+		return true;
+	}
+
+	//! Inserts a key or replaces the value of an existing key.
+	void set(const KeyType& key, const ValueType& value)
+	{
+		Node* node = find(key);
+		if (node)
+			node->Value = value;
+		else
+			insert(key, value);
+	}
+
+	//! Finds a key.
+	/** \return Node of the key, or 0 if it's not in the map. */
+	Node* find(const KeyType& key) const
+	{
+		if (Nodes.empty())
+			return 0;
+
+		const u32 slot = findSlot(key, HashFunc()(key));
+		return Slots[slot] ? const_cast<Node*>(&Nodes[Slots[slot]-1]) : 0;
+	}
+
+	//! Removes a key.
+	/** The last entry is moved to the place of the removed one.
+	\return True if the key was removed, false if it's not in the map. */
+	bool remove(const KeyType& key)
+	{
+		if (Nodes.empty())
+			return false;
+
+		u32 hole = findSlot(key, HashFunc()(key));
+		const u32 index = Slots[hole];
+		if (!index)
+			return false;
+
+		// move following entries of the probe sequence back into the hole
+		const u32 mask = Slots.size()-1;
+		for (u32 slot=(hole+1)&mask; Slots[slot]; slot=(slot+1)&mask)
+		{
+			const u32 ideal = Nodes[Slots[slot]-1].Hash & mask;
+			if (((slot - ideal) & mask) >= ((slot - hole) & mask))
+			{
+				Slots[hole] = Slots[slot];
+				hole = slot;
+			}
+		}
+		Slots[hole] = 0;
+
+		// fill the gap in the entries with the last one
+		const u32 last = Nodes.size();
+		if (index != last)
+		{
+			u32 slot = Nodes[last-1].Hash & mask;
+			while (Slots[slot] != last)
+				slot = (slot+1) & mask;
+			Slots[slot] = index;
+			Nodes[index-1] = Nodes[last-1];
+		}
+		Nodes.erase(last-1);
+		return true;
+	}
+
+	//! Removes all entries
+	void clear()
+	{
+		Nodes.clear();
+		Slots.clear();
+	}
+
+	//! Returns the number of entries
+	u32 size() const
+	{
+		return Nodes.size();
+	}
+
+	//! Returns if the map is empty
+	bool empty() const
+	{
+		return Nodes.empty();
+	}
+
+	//! Returns an entry for iterating over the map
+	/** \param index Index between 0 and size()-1, the order is the insertion order until entries are removed. */
+	Node& getNode(u32 index)
+	{
+		return Nodes[index];
+	}
+
+	//! Returns an entry for iterating over the map
+	const Node& getNode(u32 index) const
+	{
+		return Nodes[index];
+	}
+
+	//! Swap the content of this map with the content of another map
+	void swap(hashmap& other)
+	{
+		Nodes.swap(other.Nodes);
+		Slots.swap(other.Slots);
+	}
+
+private:
+
+	//! Returns the slot of a key, or the empty slot where it belongs
+	u32 findSlot(const KeyType& key, u32 keyHash) const
+	{
+		const u32 mask = Slots.size()-1;
+		u32 slot = keyHash & mask;
+		while (Slots[slot])
+		{
+			const Node& node = Nodes[Slots[slot]-1];
+			if (node.Hash == keyHash && EqualFunc()(node.Key, key))
+				break;
+			slot = (slot+1) & mask;
+		}
+		return slot;
+	}
+
+	//! Rebuilds the slot table with at least minSize slots
+	void rehash(u32 minSize)
+	{
+		u32 size = 16;
+		while (size < minSize)
+			size <<= 1;
+
+		Slots.set_used(size);
+		for (u32 i=0; i<size; ++i)
+			Slots[i] = 0;
+
+		const u32 mask = size-1;
+		for (u32 n=0; n<Nodes.size(); ++n)
+		{
+			u32 slot = Nodes[n].Hash & mask;
+			while (Slots[slot])
+				slot = (slot+1) & mask;
+			Slots[slot] = n+1;
+		}
+	}
+
+	//! all entries
+	array<Node> Nodes;
+
+	//! index+1 of the entry in each slot, 0 for empty slots
+	array<u32> Slots;
+};
+
+} // end namespace core
+} // end namespace irr
+
+#endif
+
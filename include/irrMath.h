@@ -757,6 +757,62 @@ namespace core
 		return x - floorf ( x );
 	}
 
+	//! Converts a float to a 16 bit half float, rounding to the nearest value
+	/** Values too large for half floats become infinity, too small ones zero. */
+	inline u16 f32_to_f16(f32 value)
+	{
+		const u32 bits = IR(value);
+		const u16 sign = (u16)((bits >> 16) & 0x8000);
+		const u32 absBits = bits & 0x7FFFFFFF;
+
+		// infinity and NaN
+		if (absBits >= 0x7F800000)
+			return sign | 0x7C00 | (absBits > 0x7F800000 ? 0x200 : 0);
+		// larger than the largest half float
+		if (absBits >= 0x477FF000)
+			return sign | 0x7C00;
+		// denormalized half floats
+		if (absBits < 0x38800000)
+		{
+			if (absBits < 0x33000000)
+				return sign;
+			const u32 shift = 126 - (absBits >> 23);
+			const u32 mantissa = (absBits & 0x7FFFFF) | 0x800000;
+			return sign | (u16)((mantissa + (1 << (shift-1))) >> shift);
+		}
+		// rebias the exponent and round the mantissa to even
+		return sign | (u16)((absBits - 0x38000000 + 0xFFF + ((absBits >> 13) & 1)) >> 13);
+	}
+
+	//! Converts a 16 bit half float to a float
+	inline f32 f16_to_f32(u16 value)
+	{
+		const u32 sign = (u32)(value & 0x8000) << 16;
+		const u32 exponent = (value >> 10) & 0x1F;
+		u32 mantissa = value & 0x3FF;
+		u32 bits;
+
+		if (exponent == 0x1F)
+			bits = sign | 0x7F800000 | (mantissa << 13);
+		else if (exponent)
+			bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+		else if (mantissa)
+		{
+			// normalize denormalized half floats
+			u32 e = 113;
+			while (!(mantissa & 0x400))
+			{
+				mantissa <<= 1;
+				--e;
+			}
+			bits = sign | (e << 23) | ((mantissa & 0x3FF) << 13);
+		}
+		else
+			bits = sign;
+
+		return FR(bits);
+	}
+
 } // end namespace core
 } // end namespace irr
 
@@ -925,26 +925,25 @@ public:
 		if ((length <= 0) || (begin>=size()))
 			return string<T>("");
 		// clamp length to maximal value
-		if ((length+begin) > size())
-			length = size()-begin;
+		const u32 count = core::min_((u32)length, size()-begin);
 
 		string<T> o;
-		o.reserve(length+1);
+		o.reserve(count+1);
 
-		s32 i;
+		u32 i;
 		if ( !make_lower )
 		{
-			for (i=0; i<length; ++i)
+			for (i=0; i<count; ++i)
 				o.array[i] = array[i+begin];
 		}
 		else
 		{
-			for (i=0; i<length; ++i)
+			for (i=0; i<count; ++i)
 				o.array[i] = locale_lower ( array[i+begin] );
 		}
 
-		o.array[length] = 0;
-		o.used = length + 1;
+		o.array[count] = 0;
+		o.used = count + 1;
 
 		return o;
 	}
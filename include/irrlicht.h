@@ -49,6 +49,7 @@
 #include "EMaterialTypes.h"
 #include "EMeshWriterEnums.h"
 #include "EMessageBoxFlags.h"
+#include "EReadFileType.h"
 #include "ESceneNodeAnimatorTypes.h"
 #include "ESceneNodeTypes.h"
 #include "ETerrainElements.h"
@@ -60,6 +61,8 @@
 #include "IAnimatedMeshSceneNode.h"
 #include "IAttributeExchangingObject.h"
 #include "IAttributes.h"
+#include "IBatchedMeshSceneNode.h"
+#include "IClusteredMeshSceneNode.h"
 #include "IBillboardSceneNode.h"
 #include "IBillboardTextSceneNode.h"
 #include "IBoneSceneNode.h"
@@ -105,6 +108,7 @@
 #include "IImageWriter.h"
 #include "IIndexBuffer.h"
 #include "ILightSceneNode.h"
+#include "ILODSceneNode.h"
 #include "ILogger.h"
 #include "IMaterialRenderer.h"
 #include "IMaterialRendererServices.h"
@@ -119,8 +123,10 @@
 #include "IColladaMeshWriter.h"
 #include "IMetaTriangleSelector.h"
 #include "IOSOperator.h"
+#include "IPagedTerrainSceneNode.h"
 #include "IParticleSystemSceneNode.h" // also includes all emitters and attractors
 #include "IQ3LevelMesh.h"
+#include "IQ3LevelSceneNode.h"
 #include "IQ3Shader.h"
 #include "IReadFile.h"
 #include "IReferenceCounted.h"
@@ -129,6 +135,7 @@
 #include "IRenderTarget.h"
 #include "IrrlichtDevice.h"
 #include "irrList.h"
+#include "irrHashMap.h"
 #include "irrMap.h"
 #include "irrMath.h"
 #include "irrString.h"
@@ -183,9 +190,11 @@
 #include "SMeshBuffer.h"
 #include "SMeshBufferLightMap.h"
 #include "SMeshBufferTangents.h"
+#include "SMeshCluster.h"
 #include "SParticle.h"
 #include "SSharedMeshBuffer.h"
 #include "SSkinMeshBuffer.h"
+#include "STransformHierarchy.h"
 #include "SVertexIndex.h"
 #include "SViewFrustum.h"
 #include "triangle3d.h"
@@ -9,6 +9,7 @@
 #include "CMeshTextureLoader.h"
 #include "os.h"
 #include "SMeshBuffer.h"
+#include "CMeshBufferHelper.h"
 #include "SAnimatedMesh.h"
 #include "IReadFile.h"
 #include "IVideoDriver.h"
@@ -182,6 +183,7 @@ IAnimatedMesh* C3DSMeshFileLoader::createMesh(io::IReadFile* file)
 	CurrentMaterial.clear();
 	Materials.clear();
 	MeshBufferNames.clear();
+	MeshBufferIndices.clear();
 	cleanUp();
 
 	if (Mesh)
@@ -197,18 +199,21 @@ IAnimatedMesh* C3DSMeshFileLoader::createMesh(io::IReadFile* file)
 		{
 			SMeshBuffer* mb = ((SMeshBuffer*)Mesh->getMeshBuffer(i));
 			// drop empty buffers
-			if (mb->getIndexCount() == 0 || mb->getVertexCount() == 0)
+			if (MeshBufferIndices[i].empty() || mb->getVertexCount() == 0)
 			{
-				Mesh->MeshBuffers.erase(i--);
+				Mesh->MeshBuffers.erase(i);
+				MeshBufferIndices.erase(i--);
 				mb->drop();
 			}
 			else
 			{
-				if (mb->Material.MaterialType == video::EMT_PARALLAX_MAP_SOLID)
+				Mesh->MeshBuffers[i] = createIndexedMeshBuffer(mb, MeshBufferIndices[i]);
+				mb->drop();
+				if (Mesh->MeshBuffers[i]->getMaterial().MaterialType == video::EMT_PARALLAX_MAP_SOLID)
 				{
 					SMesh tmp;
-					tmp.addMeshBuffer(mb);
-					mb->drop();
+					tmp.addMeshBuffer(Mesh->MeshBuffers[i]);
+					Mesh->MeshBuffers[i]->drop();
 					IMesh* tangentMesh = SceneManager->getMeshManipulator()->createMeshWithTangents(&tmp);
 					Mesh->MeshBuffers[i]=tangentMesh->getMeshBuffer(0);
 					// we need to grab because we replace the buffer manually.
@@ -220,6 +225,7 @@ IAnimatedMesh* C3DSMeshFileLoader::createMesh(io::IReadFile* file)
 			}
 		}
 
+		MeshBufferIndices.clear();
 		Mesh->recalculateBoundingBox();
 
 		SAnimatedMesh* am = new SAnimatedMesh();
@@ -1034,6 +1040,7 @@ void C3DSMeshFileLoader::composeObject(io::IReadFile* file, const core::stringc&
 			Mesh->addMeshBuffer(mb);
 			mb->getMaterial() = Materials[0].Material;
 			mb->drop();
+			MeshBufferIndices.push_back(core::array<u32>());
 			// add an empty mesh buffer name
 			MeshBufferNames.push_back("");
 		}
@@ -1044,8 +1051,8 @@ void C3DSMeshFileLoader::composeObject(io::IReadFile* file, const core::stringc&
 		SMeshBuffer* mb = 0;
 		video::SMaterial* mat=0;
 		u32 mbPos;
-		// -3 because we add three vertices at once
-		u32 maxPrimitives = core::min_(SceneManager->getVideoDriver()->getMaximalPrimitiveCount(), (u32)((1<<16)-1))-3; // currently hardcoded s16 max value for index pointers
+		// -3 because we add three vertices at once, buffers with more than 65536 vertices get 32 bit indices
+		u32 maxPrimitives = SceneManager->getVideoDriver()->getMaximalPrimitiveCount()-3;
 
 		// find mesh buffer for this group
 		for (mbPos=0; mbPos<Materials.size(); ++mbPos)
@@ -1083,6 +1090,8 @@ void C3DSMeshFileLoader::composeObject(io::IReadFile* file, const core::stringc&
 					mb->drop();
 					Mesh->MeshBuffers[mbPos] = Mesh->MeshBuffers.getLast();
 					Mesh->MeshBuffers[Mesh->MeshBuffers.size()-1] = tmp;
+					MeshBufferIndices.push_back(core::array<u32>());
+					MeshBufferIndices[mbPos].swap(MeshBufferIndices.getLast());
 					mb->getMaterial() = tmp->getMaterial();
 					vtxCount=0;
 				}
@@ -1118,9 +1127,9 @@ void C3DSMeshFileLoader::composeObject(io::IReadFile* file, const core::stringc&
 
 				// add indices
 
-				mb->Indices.push_back(vtxCount);
-				mb->Indices.push_back(vtxCount+2);
-				mb->Indices.push_back(vtxCount+1);
+				MeshBufferIndices[mbPos].push_back(vtxCount);
+				MeshBufferIndices[mbPos].push_back(vtxCount+2);
+				MeshBufferIndices[mbPos].push_back(vtxCount+1);
 			}
 		}
 		else
@@ -1143,6 +1152,7 @@ void C3DSMeshFileLoader::loadMaterials(io::IReadFile* file)
 		MeshBufferNames.push_back("");
 		SMeshBuffer* m = new scene::SMeshBuffer();
 		Mesh->addMeshBuffer(m);
+		MeshBufferIndices.push_back(core::array<u32>());
 
 		m->getMaterial() = Materials[i].Material;
 		if (Materials[i].Filename[0].size())
@@ -154,6 +154,8 @@ private:
 	SCurrentMaterial CurrentMaterial;
 	core::array<SCurrentMaterial> Materials;
 	core::array<core::stringc> MeshBufferNames;
+	// indices of each mesh buffer, large buffers get 32 bit indices in the end
+	core::array<core::array<u32> > MeshBufferIndices;
 	core::matrix4 TransformationMatrix;
 
 	SMesh* Mesh;
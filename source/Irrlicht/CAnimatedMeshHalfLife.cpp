@@ -267,6 +267,7 @@ void CAnimatedMeshHalfLife::setHardwareMappingHint(E_HARDWARE_MAPPING newMapping
 //! flags the meshbuffer as changed, reloads hardware buffers
 void CAnimatedMeshHalfLife::setDirty(E_BUFFER_TYPE buffer)
 {
+	MeshIPol->setDirty(buffer);
 }
 
 
@@ -585,6 +586,7 @@ void CAnimatedMeshHalfLife::buildVertices()
 	*/
 					}
 				} // tricmd
+				buffer->setDirty(EBT_VERTEX);
 			} // nummesh
 		} // model
 	} // bodypart
@@ -280,6 +280,7 @@ void CAnimatedMeshMD3::buildVertexArray(u32 frameA, u32 frameB, f32 interpolate,
 		v.Normal.Z = nA.Y + interpolate * (nB.Y - nA.Y);
 	}
 
+	dest->setDirty(EBT_VERTEX);
 	dest->recalculateBoundingBox();
 }
 
@@ -826,6 +826,10 @@ void CAnimatedMeshSceneNode::setMesh(IAnimatedMesh* mesh)
 
 		// grab the mesh (it's non-null!)
 		Mesh->grab();
+
+		// nodes sharing a mesh are animated by the same thread
+		if (TransformHierarchy)
+			TransformHierarchy->HierarchyChanged = true;
 	}
 
 	// get materials and bounding box
@@ -294,15 +294,15 @@ bool CB3DMeshFileLoader::readChunkMESH(CSkinnedMesh::SJoint *inJoint)
 			{
 				s32 i;
 
-				for ( i=0; i<(s32)meshBuffer->Indices.size(); i+=3)
+				for ( i=0; i<(s32)meshBuffer->getIndexCount(); i+=3)
 				{
-					core::plane3df p(meshBuffer->getVertex(meshBuffer->Indices[i+0])->Pos,
-							meshBuffer->getVertex(meshBuffer->Indices[i+1])->Pos,
-							meshBuffer->getVertex(meshBuffer->Indices[i+2])->Pos);
+					core::plane3df p(meshBuffer->getVertex(meshBuffer->getIndex(i+0))->Pos,
+							meshBuffer->getVertex(meshBuffer->getIndex(i+1))->Pos,
+							meshBuffer->getVertex(meshBuffer->getIndex(i+2))->Pos);
 
-					meshBuffer->getVertex(meshBuffer->Indices[i+0])->Normal += p.Normal;
-					meshBuffer->getVertex(meshBuffer->Indices[i+1])->Normal += p.Normal;
-					meshBuffer->getVertex(meshBuffer->Indices[i+2])->Normal += p.Normal;
+					meshBuffer->getVertex(meshBuffer->getIndex(i+0))->Normal += p.Normal;
+					meshBuffer->getVertex(meshBuffer->getIndex(i+1))->Normal += p.Normal;
+					meshBuffer->getVertex(meshBuffer->getIndex(i+2))->Normal += p.Normal;
 				}
 
 				for ( i = 0; i<(s32)meshBuffer->getVertexCount(); ++i )
@@ -475,7 +475,10 @@ bool CB3DMeshFileLoader::readChunkTRIS(scene::SSkinMeshBuffer *meshBuffer, u32 m
 		B3dMaterial = 0;
 
 	const s32 memoryNeeded = B3dStack.getLast().length / sizeof(s32);
-	meshBuffer->Indices.reallocate(memoryNeeded + meshBuffer->Indices.size() + 1);
+	if (meshBuffer->getIndexType() == video::EIT_16BIT)
+		meshBuffer->Indices.reallocate(memoryNeeded + meshBuffer->Indices.size() + 1);
+	else
+		meshBuffer->Indices32.reallocate(memoryNeeded + meshBuffer->Indices32.size() + 1);
 
 	while((B3dStack.getLast().startposition + B3dStack.getLast().length) > B3DFile->getPos()) // this chunk repeats
 	{
@@ -553,9 +556,10 @@ bool CB3DMeshFileLoader::readChunkTRIS(scene::SSkinMeshBuffer *meshBuffer, u32 m
 			}
 		}
 
-		meshBuffer->Indices.push_back( AnimatedVertices_VertexID[ vertex_id[0] ] );
-		meshBuffer->Indices.push_back( AnimatedVertices_VertexID[ vertex_id[1] ] );
-		meshBuffer->Indices.push_back( AnimatedVertices_VertexID[ vertex_id[2] ] );
+		// switches to 32 bit indices for large buffers instead of splitting them
+		meshBuffer->addIndex( AnimatedVertices_VertexID[ vertex_id[0] ] );
+		meshBuffer->addIndex( AnimatedVertices_VertexID[ vertex_id[1] ] );
+		meshBuffer->addIndex( AnimatedVertices_VertexID[ vertex_id[2] ] );
 	}
 
 	B3dStack.erase(B3dStack.size()-1);
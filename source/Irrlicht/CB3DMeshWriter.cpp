@@ -316,6 +316,27 @@ bool CB3DMeshWriter::writeMesh(io::IWriteFile* file, IMesh* const mesh, s32 flag
                     }
                 }
                 break;
+                case EVT_QUANTIZED:
+                case EVT_QUANTIZED_TANGENTS:
+                {
+                    const u32 pitch = getVertexPitchFromType(mb->getVertexType());
+                    const S3DVertexQuantized *v = (const S3DVertexQuantized *) ((const u8 *) mb->getVertices() + j*pitch);
+                    const SColorf col(v->Color);
+                    write(file, &col.r, 4);
+                    write(file, &col.g, 4);
+                    write(file, &col.b, 4);
+                    write(file, &col.a, 4);
+
+                    const vector2df tcoords = v->getTCoords();
+                    write(file, &tcoords.X, 4);
+                    write(file, &tcoords.Y, 4);
+                    if (texcoords == 2)
+                    {
+                        write(file, &zero, 4);
+                        write(file, &zero, 4);
+                    }
+                }
+                break;
             }
         }
     }
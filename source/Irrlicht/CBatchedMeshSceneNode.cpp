@@ -0,0 +1,661 @@
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#include "CBatchedMeshSceneNode.h"
+#include "CTriangleSelector.h"
+#include "CDynamicMeshBuffer.h"
+#include "IMeshSceneNode.h"
+#include "ISceneManager.h"
+#include "IVideoDriver.h"
+#include "ICameraSceneNode.h"
+#include "IMaterialRenderer.h"
+#include "SViewFrustum.h"
+#include "os.h"
+
+namespace irr
+{
+namespace scene
+{
+
+namespace
+{
+
+//! Triangle selector which reports the source nodes of the triangles of a batch
+class CBatchedMeshTriangleSelector : public CTriangleSelector
+{
+public:
+
+	CBatchedMeshTriangleSelector(ISceneNode* node) : CTriangleSelector(node)
+	{
+		#ifdef _DEBUG
+		setDebugName("CBatchedMeshTriangleSelector");
+		#endif
+	}
+
+	//! Adds triangles of a chunk
+	void addTriangles(CDynamicMeshBuffer* chunk, u32 chunkIndex, u32 firstTriangle, u32 triangleCount, ISceneNode* source)
+	{
+		SCollisionTriangleRange range;
+		range.RangeStart = Triangles.size();
+		range.RangeSize = triangleCount;
+		range.SceneNode = source;
+		range.MeshBuffer = chunk;
+		range.MaterialIndex = chunkIndex;
+		BufferRanges.push_back(range);
+
+		const IVertexBuffer& vertices = chunk->getVertexBuffer();
+		const IIndexBuffer& indices = chunk->getIndexBuffer();
+		for (u32 i=firstTriangle*3; i<(firstTriangle+triangleCount)*3; i+=3)
+		{
+			Triangles.push_back(core::triangle3df(vertices[indices[i]].Pos,
+				vertices[indices[i+1]].Pos, vertices[indices[i+2]].Pos));
+		}
+	}
+
+	//! Updates the bounding box after all triangles were added
+	void finish()
+	{
+		updateBoundingBox();
+	}
+
+	//! Return the scene node associated with a given triangle.
+	virtual ISceneNode* getSceneNodeForTriangle(u32 triangleIndex) const _IRR_OVERRIDE_
+	{
+		for (u32 i=0; i<BufferRanges.size(); ++i)
+		{
+			if (BufferRanges[i].isIndexInRange(triangleIndex))
+				return BufferRanges[i].SceneNode;
+		}
+		return SceneNode;
+	}
+};
+
+//! Mesh buffer of a node waiting to be merged into a chunk
+struct SBatchEntry
+{
+	const IMeshBuffer* Buffer;
+	u32 SourceNode;
+	//! Morton code of the center, so entries close to each other end up in the same chunk
+	u32 Code;
+	core::vector3df Center;
+
+	bool operator<(const SBatchEntry& other) const { return Code < other.Code; }
+};
+
+//! Mesh buffers with the same material and vertex type
+struct SBatchGroup
+{
+	video::SMaterial Material;
+	video::E_VERTEX_TYPE VertexType;
+	core::array<SBatchEntry> Entries;
+	core::aabbox3df Box;
+};
+
+//! Spreads the lower 10 bits of a value to every third bit
+u32 spreadBits(u32 v)
+{
+	v &= 0x3ff;
+	v = (v | (v << 16)) & 0x030000ff;
+	v = (v | (v << 8)) & 0x0300f00f;
+	v = (v | (v << 4)) & 0x030c30c3;
+	v = (v | (v << 2)) & 0x09249249;
+	return v;
+}
+
+u32 getMortonCode(const core::vector3df& pos, const core::aabbox3df& box)
+{
+	const core::vector3df extent = box.getExtent();
+	u32 code = 0;
+	for (u32 axis=0; axis<3; ++axis)
+	{
+		const f32 size = axis==0 ? extent.X : axis==1 ? extent.Y : extent.Z;
+		const f32 value = axis==0 ? pos.X-box.MinEdge.X : axis==1 ? pos.Y-box.MinEdge.Y : pos.Z-box.MinEdge.Z;
+		const u32 cell = size > 0.f ? (u32)core::clamp(value / size * 1023.f, 0.f, 1023.f) : 0;
+		code |= spreadBits(cell) << axis;
+	}
+	return code;
+}
+
+//! Returns the type the vertices of a buffer get in a chunk
+video::E_VERTEX_TYPE getBatchVertexType(video::E_VERTEX_TYPE type)
+{
+	switch (type)
+	{
+	case video::EVT_QUANTIZED:
+		return video::EVT_STANDARD;
+	case video::EVT_QUANTIZED_TANGENTS:
+		return video::EVT_TANGENTS;
+	default:
+		return type;
+	}
+}
+
+void decodeVertex(video::S3DVertex& out, const video::S3DVertexQuantized& in, const video::SVertexQuantization& quantization)
+{
+	out = in.get(quantization);
+}
+
+void decodeVertex(video::S3DVertexTangents& out, const video::S3DVertexQuantizedTangents& in, const video::SVertexQuantization& quantization)
+{
+	out = in.get(quantization);
+}
+
+void transformVertex(video::S3DVertex& v, const core::matrix4& transform, const core::matrix4& normalTransform)
+{
+	transform.transformVect(v.Pos);
+	normalTransform.rotateVect(v.Normal);
+	v.Normal.normalize();
+}
+
+void transformVertex(video::S3DVertexTangents& v, const core::matrix4& transform, const core::matrix4& normalTransform)
+{
+	transformVertex((video::S3DVertex&)v, transform, normalTransform);
+	transform.rotateVect(v.Tangent);
+	v.Tangent.normalize();
+	transform.rotateVect(v.Binormal);
+	v.Binormal.normalize();
+}
+
+//! Copies the vertices of a buffer to the end of the vertex array of a chunk and transforms them
+template <class T>
+void appendVertices(T* out, const IMeshBuffer* mb, const core::matrix4& transform, const core::matrix4& normalTransform)
+{
+	const u32 count = mb->getVertexCount();
+	const video::SVertexQuantization quantization = mb->getVertexQuantization();
+
+	switch (mb->getVertexType())
+	{
+	case video::EVT_QUANTIZED:
+		for (u32 i=0; i<count; ++i)
+			decodeVertex(out[i], ((const video::S3DVertexQuantized*)mb->getVertices())[i], quantization);
+		break;
+	case video::EVT_QUANTIZED_TANGENTS:
+		for (u32 i=0; i<count; ++i)
+			decodeVertex(out[i], ((const video::S3DVertexQuantizedTangents*)mb->getVertices())[i], quantization);
+		break;
+	default:
+		{
+			const T* in = (const T*)mb->getVertices();
+			for (u32 i=0; i<count; ++i)
+				out[i] = in[i];
+		}
+		break;
+	}
+
+	for (u32 i=0; i<count; ++i)
+		transformVertex(out[i], transform, normalTransform);
+}
+
+//! Copies the indices of a buffer to the end of the index array of a chunk
+template <class TOut, class TIn>
+void appendIndices(TOut* out, const TIn* in, u32 count, u32 firstVertex, bool flip)
+{
+	for (u32 i=0; i+2<count; i+=3)
+	{
+		out[i] = (TOut)(in[i] + firstVertex);
+		out[i+1] = (TOut)(in[flip ? i+2 : i+1] + firstVertex);
+		out[i+2] = (TOut)(in[flip ? i+1 : i+2] + firstVertex);
+	}
+}
+
+template <class TOut>
+void appendIndices(TOut* out, const IMeshBuffer* mb, u32 firstVertex, bool flip)
+{
+	if (mb->getIndexType() == video::EIT_32BIT)
+		appendIndices(out, (const u32*)mb->getIndices(), mb->getIndexCount(), firstVertex, flip);
+	else
+		appendIndices(out, mb->getIndices(), mb->getIndexCount(), firstVertex, flip);
+}
+
+} // end anonymous namespace
+
+
+//! constructor
+CBatchedMeshSceneNode::CBatchedMeshSceneNode(const core::array<ISceneNode*>& nodes,
+		u32 maxChunkVertices, ISceneNode* parent, ISceneManager* mgr, s32 id)
+	: IBatchedMeshSceneNode(parent, mgr, id), Mesh(0)
+{
+#ifdef _DEBUG
+	setDebugName("CBatchedMeshSceneNode");
+#endif
+
+	Mesh = new SMesh();
+	batch(nodes, maxChunkVertices);
+}
+
+
+//! constructor for clones
+CBatchedMeshSceneNode::CBatchedMeshSceneNode(ISceneNode* parent, ISceneManager* mgr, s32 id)
+	: IBatchedMeshSceneNode(parent, mgr, id), Mesh(0)
+{
+#ifdef _DEBUG
+	setDebugName("CBatchedMeshSceneNode");
+#endif
+}
+
+
+//! destructor
+CBatchedMeshSceneNode::~CBatchedMeshSceneNode()
+{
+	for (u32 i=0; i<SourceNodes.size(); ++i)
+		SourceNodes[i]->drop();
+
+	if (Mesh)
+		Mesh->drop();
+}
+
+
+//! Merges the mesh buffers of the nodes into chunks
+void CBatchedMeshSceneNode::batch(const core::array<ISceneNode*>& nodes, u32 maxChunkVertices)
+{
+	video::IVideoDriver* driver = SceneManager->getVideoDriver();
+
+	// vertices are stored relative to the batch node
+	core::matrix4 toBatch;
+	AbsoluteTransformation.getInverse(toBatch);
+
+	core::array<SBatchGroup> groups;
+	core::array<core::matrix4> transforms;
+	core::array<bool> pickable;
+
+	for (u32 n=0; n<nodes.size(); ++n)
+	{
+		ISceneNode* node = nodes[n];
+		if (!node || node == this || !node->isVisible())
+			continue;
+
+		const ESCENE_NODE_TYPE type = node->getType();
+		if (type != ESNT_MESH && type != ESNT_CUBE && type != ESNT_SPHERE && type != ESNT_OCTREE)
+			continue;
+
+		// meshes which are already drawn by another batch are skipped
+		IMeshSceneNode* meshNode = (IMeshSceneNode*)node;
+		IMesh* mesh = meshNode->getMesh();
+		if (!mesh || !meshNode->isMeshVisible())
+			continue;
+
+		// transparent buffers have to be sorted per node, so those nodes are not batched
+		bool canBatch = true;
+		for (u32 i=0; i<mesh->getMeshBufferCount() && canBatch; ++i)
+		{
+			const video::SMaterial& material = i < node->getMaterialCount() ?
+				node->getMaterial(i) : mesh->getMeshBuffer(i)->getMaterial();
+			const video::IMaterialRenderer* rnd = driver ? driver->getMaterialRenderer(material.MaterialType) : 0;
+			if ((rnd && rnd->isTransparent()) || material.isTransparent())
+				canBatch = false;
+		}
+		if (!canBatch)
+			continue;
+
+		node->updateAbsolutePosition();
+		const core::matrix4 transform = toBatch * node->getAbsoluteTransformation();
+		bool added = false;
+
+		for (u32 i=0; i<mesh->getMeshBufferCount(); ++i)
+		{
+			const IMeshBuffer* mb = mesh->getMeshBuffer(i);
+			if (!mb->getIndexCount() || mb->getPrimitiveType() != EPT_TRIANGLES)
+				continue;
+
+			const video::SMaterial& material = i < node->getMaterialCount() ?
+				node->getMaterial(i) : mb->getMaterial();
+			const video::E_VERTEX_TYPE vertexType = getBatchVertexType(mb->getVertexType());
+
+			u32 g=0;
+			for (; g<groups.size(); ++g)
+			{
+				if (groups[g].VertexType == vertexType && groups[g].Material == material)
+					break;
+			}
+			if (g == groups.size())
+			{
+				groups.push_back(SBatchGroup());
+				groups[g].Material = material;
+				groups[g].VertexType = vertexType;
+			}
+
+			SBatchEntry entry;
+			entry.Buffer = mb;
+			entry.SourceNode = SourceNodes.size();
+			entry.Code = 0;
+			core::aabbox3df box = mb->getBoundingBox();
+			transform.transformBoxEx(box);
+			entry.Center = box.getCenter();
+			if (groups[g].Entries.empty())
+				groups[g].Box.reset(entry.Center);
+			else
+				groups[g].Box.addInternalPoint(entry.Center);
+			groups[g].Entries.push_back(entry);
+			added = true;
+		}
+
+		if (added)
+		{
+			node->grab();
+			meshNode->setMeshVisible(false);
+			SourceNodes.push_back(node);
+			transforms.push_back(transform);
+			pickable.push_back(node->getTriangleSelector() != 0);
+		}
+	}
+
+	// normals are transformed by the inverse transposed matrix, which keeps
+	// them perpendicular to the surface also for non-uniform scales
+	core::array<core::matrix4> normalTransforms;
+	core::array<bool> flipped;
+	for (u32 i=0; i<transforms.size(); ++i)
+	{
+		core::matrix4 inverse;
+		if (transforms[i].getInverse(inverse))
+			normalTransforms.push_back(inverse.getTransposed());
+		else
+			normalTransforms.push_back(transforms[i]);
+
+		// mirroring transformations turn the triangles inside out
+		const core::vector3df x(transforms[i][0], transforms[i][1], transforms[i][2]);
+		const core::vector3df y(transforms[i][4], transforms[i][5], transforms[i][6]);
+		const core::vector3df z(transforms[i][8], transforms[i][9], transforms[i][10]);
+		flipped.push_back(x.crossProduct(y).dotProduct(z) < 0.f);
+	}
+
+	for (u32 g=0; g<groups.size(); ++g)
+	{
+		SBatchGroup& group = groups[g];
+		for (u32 i=0; i<group.Entries.size(); ++i)
+			group.Entries[i].Code = getMortonCode(group.Entries[i].Center, group.Box);
+		group.Entries.sort();
+
+		u32 first = 0;
+		while (first < group.Entries.size())
+		{
+			// buffers are never split, so a chunk has at least one buffer
+			u32 last = first;
+			u32 vertexCount = group.Entries[first].Buffer->getVertexCount();
+			u32 indexCount = group.Entries[first].Buffer->getIndexCount();
+			while (last+1 < group.Entries.size() &&
+				vertexCount + group.Entries[last+1].Buffer->getVertexCount() <= maxChunkVertices)
+			{
+				++last;
+				vertexCount += group.Entries[last].Buffer->getVertexCount();
+				indexCount += group.Entries[last].Buffer->getIndexCount();
+			}
+
+			CDynamicMeshBuffer* chunk = new CDynamicMeshBuffer(group.VertexType,
+				vertexCount > 0x10000 ? video::EIT_32BIT : video::EIT_16BIT);
+			chunk->Material = group.Material;
+			chunk->getVertexBuffer().set_used(vertexCount);
+			chunk->getIndexBuffer().set_used(indexCount);
+
+			core::array<SSourceRange> ranges;
+			u32 firstVertex = 0;
+			u32 firstIndex = 0;
+			for (u32 e=first; e<=last; ++e)
+			{
+				const SBatchEntry& entry = group.Entries[e];
+				const IMeshBuffer* mb = entry.Buffer;
+				const core::matrix4& transform = transforms[entry.SourceNode];
+				const core::matrix4& normalTransform = normalTransforms[entry.SourceNode];
+
+				switch (group.VertexType)
+				{
+				case video::EVT_STANDARD:
+					appendVertices((video::S3DVertex*)chunk->getVertexBuffer().getData() + firstVertex,
+						mb, transform, normalTransform);
+					break;
+				case video::EVT_2TCOORDS:
+					appendVertices((video::S3DVertex2TCoords*)chunk->getVertexBuffer().getData() + firstVertex,
+						mb, transform, normalTransform);
+					break;
+				case video::EVT_TANGENTS:
+					appendVertices((video::S3DVertexTangents*)chunk->getVertexBuffer().getData() + firstVertex,
+						mb, transform, normalTransform);
+					break;
+				default:
+					break;
+				}
+
+				if (chunk->getIndexType() == video::EIT_32BIT)
+					appendIndices((u32*)chunk->getIndexBuffer().getData() + firstIndex, mb, firstVertex, flipped[entry.SourceNode]);
+				else
+					appendIndices((u16*)chunk->getIndexBuffer().getData() + firstIndex, mb, firstVertex, flipped[entry.SourceNode]);
+
+				// neighbouring buffers of the same node share their range
+				if (ranges.empty() || ranges.getLast().SourceNode != entry.SourceNode)
+				{
+					SSourceRange range;
+					range.FirstTriangle = firstIndex / 3;
+					range.SourceNode = entry.SourceNode;
+					ranges.push_back(range);
+				}
+
+				firstVertex += mb->getVertexCount();
+				firstIndex += mb->getIndexCount();
+			}
+
+			chunk->setHardwareMappingHint(EHM_STATIC);
+			chunk->recalculateBoundingBox();
+			Mesh->addMeshBuffer(chunk);
+			chunk->drop();
+			Ranges.push_back(ranges);
+
+			first = last+1;
+		}
+	}
+
+	Mesh->recalculateBoundingBox();
+
+	createTriangleSelector(pickable);
+
+	char tmp[256];
+	snprintf_irr(tmp, 256, "Batched %u nodes into %u mesh buffers.", SourceNodes.size(), Mesh->getMeshBufferCount());
+	os::Printer::log(tmp, ELL_DEBUG);
+}
+
+
+//! Creates the triangle selector reporting the source nodes
+void CBatchedMeshSceneNode::createTriangleSelector(const core::array<bool>& pickable)
+{
+	CBatchedMeshTriangleSelector* selector = 0;
+
+	for (u32 c=0; c<Ranges.size(); ++c)
+	{
+		CDynamicMeshBuffer* chunk = (CDynamicMeshBuffer*)Mesh->getMeshBuffer(c);
+		const u32 triangleCount = chunk->getIndexCount() / 3;
+
+		for (u32 r=0; r<Ranges[c].size(); ++r)
+		{
+			// only nodes which could be picked before keep that ability
+			if (!pickable[Ranges[c][r].SourceNode])
+				continue;
+
+			if (!selector)
+				selector = new CBatchedMeshTriangleSelector(this);
+
+			const u32 first = Ranges[c][r].FirstTriangle;
+			const u32 end = r+1 < Ranges[c].size() ? Ranges[c][r+1].FirstTriangle : triangleCount;
+			selector->addTriangles(chunk, c, first, end-first, SourceNodes[Ranges[c][r].SourceNode]);
+		}
+	}
+
+	if (selector)
+	{
+		selector->finish();
+		setTriangleSelector(selector);
+		selector->drop();
+	}
+}
+
+
+//! Finds the chunks inside the view frustum
+void CBatchedMeshSceneNode::cullChunks()
+{
+	VisibleChunks.set_used(0);
+
+	const ICameraSceneNode* camera = SceneManager->getActiveCamera();
+	if (!camera || AutomaticCullingState == EAC_OFF)
+	{
+		for (u32 i=0; i<Mesh->getMeshBufferCount(); ++i)
+			VisibleChunks.push_back(i);
+		return;
+	}
+
+	SViewFrustum frust = *camera->getViewFrustum();
+
+	//transform the frustum to the current absolute transformation
+	if ( !AbsoluteTransformation.isIdentity() )
+	{
+		core::matrix4 invTrans(AbsoluteTransformation, core::matrix4::EM4CONST_INVERSE);
+		frust.transform(invTrans);
+	}
+
+	const u32 chunkCount = Mesh->getMeshBufferCount();
+	if (CullingPlanes.size() != chunkCount)
+	{
+		CullingPlanes.set_used(chunkCount);
+		for (u32 i=0; i<chunkCount; ++i)
+			CullingPlanes[i] = CFrustumCuller::NO_PLANE;
+	}
+
+	Culler.clear();
+	for (u32 i=0; i<chunkCount; ++i)
+		Culler.addBox(Mesh->getMeshBuffer(i)->getBoundingBox(), CullingPlanes[i]);
+	Culler.cull(frust);
+
+	for (u32 i=0; i<chunkCount; ++i)
+	{
+		CullingPlanes[i] = Culler.getCullingPlane(i);
+		if (CullingPlanes[i] == CFrustumCuller::NO_PLANE)
+			VisibleChunks.push_back(i);
+	}
+}
+
+
+void CBatchedMeshSceneNode::OnRegisterSceneNode()
+{
+	if (IsVisible)
+	{
+		cullChunks();
+
+		// only nodes with solid materials get batched
+		if (!VisibleChunks.empty())
+			SceneManager->registerNodeForRendering(this, scene::ESNRP_SOLID);
+
+		ISceneNode::OnRegisterSceneNode();
+	}
+}
+
+
+//! renders the node.
+void CBatchedMeshSceneNode::render()
+{
+	video::IVideoDriver* driver = SceneManager->getVideoDriver();
+
+	if (!driver)
+		return;
+
+	driver->setTransform(video::ETS_WORLD, AbsoluteTransformation);
+
+	for (u32 i=0; i<VisibleChunks.size(); ++i)
+	{
+		IMeshBuffer* mb = Mesh->getMeshBuffer(VisibleChunks[i]);
+		driver->setMaterial(mb->getMaterial());
+		driver->drawMeshBuffer(mb);
+	}
+
+	// for debug purposes only:
+	if (DebugDataVisible)
+	{
+		video::SMaterial m;
+		m.Lighting = false;
+		driver->setMaterial(m);
+
+		if (DebugDataVisible & scene::EDS_BBOX)
+			driver->draw3DBox(Mesh->getBoundingBox(), video::SColor(255,255,255,255));
+		if (DebugDataVisible & scene::EDS_BBOX_BUFFERS)
+		{
+			for (u32 i=0; i<VisibleChunks.size(); ++i)
+				driver->draw3DBox(Mesh->getMeshBuffer(VisibleChunks[i])->getBoundingBox(), video::SColor(255,190,128,128));
+		}
+	}
+}
+
+
+//! returns the axis aligned bounding box of this node
+const core::aabbox3d<f32>& CBatchedMeshSceneNode::getBoundingBox() const
+{
+	return Mesh->getBoundingBox();
+}
+
+
+//! returns the material based on the zero based index i.
+video::SMaterial& CBatchedMeshSceneNode::getMaterial(u32 i)
+{
+	if (i >= Mesh->getMeshBufferCount())
+		return ISceneNode::getMaterial(i);
+
+	return Mesh->getMeshBuffer(i)->getMaterial();
+}
+
+
+//! returns amount of materials used by this scene node.
+u32 CBatchedMeshSceneNode::getMaterialCount() const
+{
+	return Mesh->getMeshBufferCount();
+}
+
+
+//! Returns a node of the batch
+ISceneNode* CBatchedMeshSceneNode::getSourceNode(u32 index) const
+{
+	return index < SourceNodes.size() ? SourceNodes[index] : 0;
+}
+
+
+//! Returns the node a triangle of a chunk was created from
+ISceneNode* CBatchedMeshSceneNode::getSourceNode(u32 chunk, u32 triangle) const
+{
+	if (chunk >= Ranges.size() || triangle >= Mesh->getMeshBuffer(chunk)->getIndexCount()/3)
+		return 0;
+
+	// last range starting at or before the triangle
+	const core::array<SSourceRange>& ranges = Ranges[chunk];
+	u32 low = 0;
+	u32 high = ranges.size();
+	while (high - low > 1)
+	{
+		const u32 mid = (low + high) / 2;
+		if (ranges[mid].FirstTriangle <= triangle)
+			low = mid;
+		else
+			high = mid;
+	}
+	return SourceNodes[ranges[low].SourceNode];
+}
+
+
+//! Creates a clone of this scene node and its children.
+ISceneNode* CBatchedMeshSceneNode::clone(ISceneNode* newParent, ISceneManager* newManager)
+{
+	if (!newParent)
+		newParent = Parent;
+	if (!newManager)
+		newManager = SceneManager;
+
+	CBatchedMeshSceneNode* nb = new CBatchedMeshSceneNode(newParent, newManager, ID);
+
+	nb->cloneMembers(this, newManager);
+	nb->Mesh = Mesh;
+	Mesh->grab();
+	nb->Ranges = Ranges;
+	nb->SourceNodes = SourceNodes;
+	for (u32 i=0; i<SourceNodes.size(); ++i)
+		SourceNodes[i]->grab();
+
+	if (newParent)
+		nb->drop();
+	return nb;
+}
+
+} // end namespace scene
+} // end namespace irr
+
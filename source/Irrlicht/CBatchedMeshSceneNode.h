@@ -0,0 +1,103 @@
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#ifndef __C_BATCHED_MESH_SCENE_NODE_H_INCLUDED__
+#define __C_BATCHED_MESH_SCENE_NODE_H_INCLUDED__
+
+#include "IBatchedMeshSceneNode.h"
+#include "SMesh.h"
+#include "CFrustumCuller.h"
+
+namespace irr
+{
+namespace scene
+{
+
+	//! Scene node which draws the geometry of many static mesh scene nodes with few draw calls
+	class CBatchedMeshSceneNode : public IBatchedMeshSceneNode
+	{
+	public:
+
+		//! constructor
+		/** Batches the visible mesh, cube, sphere and octree scene nodes
+		of the list and hides them. */
+		CBatchedMeshSceneNode(const core::array<ISceneNode*>& nodes, u32 maxChunkVertices,
+			ISceneNode* parent, ISceneManager* mgr, s32 id);
+
+		//! destructor
+		virtual ~CBatchedMeshSceneNode();
+
+		virtual void OnRegisterSceneNode() _IRR_OVERRIDE_;
+
+		//! renders the node.
+		virtual void render() _IRR_OVERRIDE_;
+
+		//! returns the axis aligned bounding box of this node
+		virtual const core::aabbox3d<f32>& getBoundingBox() const _IRR_OVERRIDE_;
+
+		//! returns the material based on the zero based index i.
+		virtual video::SMaterial& getMaterial(u32 i) _IRR_OVERRIDE_;
+
+		//! returns amount of materials used by this scene node.
+		virtual u32 getMaterialCount() const _IRR_OVERRIDE_;
+
+		//! Returns type of the scene node
+		virtual ESCENE_NODE_TYPE getType() const _IRR_OVERRIDE_ { return ESNT_BATCHED_MESH; }
+
+		//! Returns the mesh with one mesh buffer for each chunk
+		virtual IMesh* getMesh() const _IRR_OVERRIDE_ { return Mesh; }
+
+		//! Returns the number of nodes in the batch
+		virtual u32 getSourceNodeCount() const _IRR_OVERRIDE_ { return SourceNodes.size(); }
+
+		//! Returns a node of the batch
+		virtual ISceneNode* getSourceNode(u32 index) const _IRR_OVERRIDE_;
+
+		//! Returns the node a triangle of a chunk was created from
+		virtual ISceneNode* getSourceNode(u32 chunk, u32 triangle) const _IRR_OVERRIDE_;
+
+		//! Returns the number of chunks which were inside the view frustum the last time the node was drawn
+		virtual u32 getVisibleChunkCount() const _IRR_OVERRIDE_ { return VisibleChunks.size(); }
+
+		//! Creates a clone of this scene node and its children.
+		/** The clone shares the chunks and the source nodes with this node. */
+		virtual ISceneNode* clone(ISceneNode* newParent=0, ISceneManager* newManager=0) _IRR_OVERRIDE_;
+
+		//! Triangles of a chunk which were created from one source node
+		struct SSourceRange
+		{
+			//! First triangle of the range in the chunk
+			u32 FirstTriangle;
+			//! Index into the source nodes
+			u32 SourceNode;
+		};
+
+	private:
+
+		//! constructor for clones
+		CBatchedMeshSceneNode(ISceneNode* parent, ISceneManager* mgr, s32 id);
+
+		//! Merges the mesh buffers of the nodes into chunks
+		void batch(const core::array<ISceneNode*>& nodes, u32 maxChunkVertices);
+
+		//! Creates the triangle selector reporting the source nodes
+		void createTriangleSelector(const core::array<bool>& pickable);
+
+		//! Finds the chunks inside the view frustum
+		void cullChunks();
+
+		SMesh* Mesh;
+		//! source ranges of each chunk, sorted by their first triangle
+		core::array<core::array<SSourceRange> > Ranges;
+		core::array<ISceneNode*> SourceNodes;
+		core::array<u32> VisibleChunks;
+		CFrustumCuller Culler;
+		//! plane which culled each chunk the last time
+		core::array<u8> CullingPlanes;
+	};
+
+} // end namespace scene
+} // end namespace irr
+
+#endif
+
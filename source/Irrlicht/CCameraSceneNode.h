@@ -139,6 +139,9 @@ namespace scene
 		//! Returns type of the scene node
 		virtual ESCENE_NODE_TYPE getType() const _IRR_OVERRIDE_ { return ESNT_CAMERA; }
 
+		//! Uses the transformation handling of ISceneNode
+		virtual bool hasPlainTransformation() const _IRR_OVERRIDE_ { return true; }
+
 		//! Binds the camera scene node's rotation to its target position and vice versa, or unbinds them.
 		virtual void bindTargetAndRotation(bool bound) _IRR_OVERRIDE_;
 
@@ -0,0 +1,327 @@
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#include "CClusteredMeshSceneNode.h"
+#include "ISceneManager.h"
+#include "IVideoDriver.h"
+#include "ICameraSceneNode.h"
+#include "IMaterialRenderer.h"
+#include "SViewFrustum.h"
+
+namespace irr
+{
+namespace scene
+{
+
+//! constructor
+CClusteredMeshSceneNode::CClusteredMeshSceneNode(IMesh* mesh, const core::array<SMeshCluster>& clusters,
+		ISceneNode* parent, ISceneManager* mgr, s32 id,
+		const core::vector3df& position, const core::vector3df& rotation,
+		const core::vector3df& scale)
+	: IClusteredMeshSceneNode(parent, mgr, id, position, rotation, scale),
+	Mesh(mesh), Clusters(clusters), VisibleClusterCount(0), VisibleTriangleCount(0), PassCount(0)
+{
+	#ifdef _DEBUG
+	setDebugName("CClusteredMeshSceneNode");
+	#endif
+
+	Mesh->grab();
+
+	const u32 bufferCount = Mesh->getMeshBufferCount();
+	BufferClusters.reallocate(bufferCount+1);
+	u32 c = 0;
+	for (u32 b=0; b<bufferCount; ++b)
+	{
+		BufferClusters.push_back(c);
+		while (c < Clusters.size() && Clusters[c].MeshBuffer == b)
+			++c;
+
+		Materials.push_back(Mesh->getMeshBuffer(b)->getMaterial());
+	}
+	BufferClusters.push_back(c);
+}
+
+
+//! destructor
+CClusteredMeshSceneNode::~CClusteredMeshSceneNode()
+{
+	Mesh->drop();
+}
+
+
+//! Collects the index ranges of the visible clusters
+void CClusteredMeshSceneNode::cullClusters()
+{
+	VisibleRanges.set_used(0);
+	VisibleClusterCount = 0;
+	VisibleTriangleCount = 0;
+
+	const ICameraSceneNode* camera = SceneManager->getActiveCamera();
+	const bool cull = camera && AutomaticCullingState != EAC_OFF;
+
+	// frustum planes and camera position in the space of the mesh
+	SViewFrustum frust;
+	bool coneCulling = false;
+	if (cull)
+	{
+		frust = *camera->getViewFrustum();
+		if ( !AbsoluteTransformation.isIdentity() )
+		{
+			core::matrix4 invTrans(AbsoluteTransformation, core::matrix4::EM4CONST_INVERSE);
+			frust.transform(invTrans);
+		}
+		// the transformation scales the plane normals, distances to spheres need unit normals
+		for (u32 p=0; p<SViewFrustum::VF_PLANE_COUNT; ++p)
+		{
+			core::plane3df& plane = frust.planes[p];
+			const f32 length = plane.Normal.getLength();
+			if (length > 0.f)
+			{
+				plane.Normal /= length;
+				plane.D /= length;
+			}
+		}
+		// all triangles face the viewer of an orthogonal camera the same way
+		coneCulling = !camera->isOrthogonal();
+	}
+
+	for (u32 b=0; b<Mesh->getMeshBufferCount(); ++b)
+	{
+		const u32 first = BufferClusters[b];
+		const u32 end = BufferClusters[b+1];
+
+		if (first == end)
+		{
+			const IMeshBuffer* mb = Mesh->getMeshBuffer(b);
+			SIndexRange range;
+			range.MeshBuffer = b;
+			range.FirstIndex = 0;
+			range.IndexCount = mb->getIndexCount();
+			VisibleRanges.push_back(range);
+			VisibleTriangleCount += mb->getPrimitiveCount();
+			continue;
+		}
+
+		const bool backfaceCulling = coneCulling && Materials[b].BackfaceCulling && !Materials[b].FrontfaceCulling;
+
+		for (u32 c=first; c<end; ++c)
+		{
+			const SMeshCluster& cluster = Clusters[c];
+
+			if (cull)
+			{
+				u32 p;
+				for (p=0; p<SViewFrustum::VF_PLANE_COUNT; ++p)
+				{
+					if (frust.planes[p].getDistanceTo(cluster.Center) > cluster.Radius)
+						break;
+				}
+				if (p < SViewFrustum::VF_PLANE_COUNT)
+					continue;
+
+				if (backfaceCulling && cluster.isBackFacing(frust.cameraPosition))
+					continue;
+			}
+
+			++VisibleClusterCount;
+			VisibleTriangleCount += cluster.TriangleCount;
+
+			// clusters following each other in the index list are merged
+			if (!VisibleRanges.empty() && VisibleRanges.getLast().MeshBuffer == b &&
+				VisibleRanges.getLast().FirstIndex + VisibleRanges.getLast().IndexCount == cluster.FirstIndex)
+			{
+				VisibleRanges.getLast().IndexCount += cluster.TriangleCount*3;
+			}
+			else
+			{
+				SIndexRange range;
+				range.MeshBuffer = b;
+				range.FirstIndex = cluster.FirstIndex;
+				range.IndexCount = cluster.TriangleCount*3;
+				VisibleRanges.push_back(range);
+			}
+		}
+	}
+}
+
+
+void CClusteredMeshSceneNode::OnRegisterSceneNode()
+{
+	if (IsVisible)
+	{
+		video::IVideoDriver* driver = SceneManager->getVideoDriver();
+
+		PassCount = 0;
+		int transparentCount = 0;
+		int solidCount = 0;
+
+		for (u32 i=0; i<Materials.size(); ++i)
+		{
+			video::IMaterialRenderer* rnd = driver->getMaterialRenderer(Materials[i].MaterialType);
+
+			if ((rnd && rnd->isTransparent()) || Materials[i].isTransparent())
+				++transparentCount;
+			else
+				++solidCount;
+
+			if (solidCount && transparentCount)
+				break;
+		}
+
+		if (solidCount)
+			SceneManager->registerNodeForRendering(this, scene::ESNRP_SOLID);
+
+		if (transparentCount)
+			SceneManager->registerNodeForRendering(this, scene::ESNRP_TRANSPARENT);
+
+		ISceneNode::OnRegisterSceneNode();
+	}
+}
+
+
+//! Draws the visible index ranges of a mesh buffer with one call
+void CClusteredMeshSceneNode::drawRanges(video::IVideoDriver* driver, const IMeshBuffer* mb, u32 first, u32 end)
+{
+	// everything visible, the driver may use its hardware buffers
+	if (end - first == 1 && VisibleRanges[first].IndexCount == mb->getIndexCount())
+	{
+		driver->drawMeshBuffer(mb);
+		return;
+	}
+
+	const u32 indexSize = (mb->getIndexType() == video::EIT_32BIT) ? sizeof(u32) : sizeof(u16);
+	const u8* indices = (const u8*)mb->getIndices();
+	u32 indexCount = 0;
+
+	if (end - first == 1)
+	{
+		indices += VisibleRanges[first].FirstIndex * indexSize;
+		indexCount = VisibleRanges[first].IndexCount;
+	}
+	else
+	{
+		u32 i;
+		for (i=first; i<end; ++i)
+			indexCount += VisibleRanges[i].IndexCount;
+		MergedIndices.set_used(indexCount * indexSize);
+
+		u8* target = MergedIndices.pointer();
+		for (i=first; i<end; ++i)
+		{
+			const u32 size = VisibleRanges[i].IndexCount * indexSize;
+			memcpy(target, indices + VisibleRanges[i].FirstIndex * indexSize, size);
+			target += size;
+		}
+		indices = MergedIndices.const_pointer();
+	}
+
+	driver->drawVertexPrimitiveList(mb->getVertices(), mb->getVertexCount(), indices, indexCount/3,
+		mb->getVertexType(), scene::EPT_TRIANGLES, mb->getIndexType());
+}
+
+
+//! renders the node.
+void CClusteredMeshSceneNode::render()
+{
+	video::IVideoDriver* driver = SceneManager->getVideoDriver();
+
+	if (!driver)
+		return;
+
+	const bool isTransparentPass =
+		SceneManager->getSceneNodeRenderPass() == scene::ESNRP_TRANSPARENT;
+
+	// the camera doesn't move between the solid and transparent pass
+	++PassCount;
+	if (PassCount == 1)
+		cullClusters();
+
+	driver->setTransform(video::ETS_WORLD, AbsoluteTransformation);
+
+	u32 first = 0;
+	while (first < VisibleRanges.size())
+	{
+		const u32 b = VisibleRanges[first].MeshBuffer;
+		u32 end = first+1;
+		while (end < VisibleRanges.size() && VisibleRanges[end].MeshBuffer == b)
+			++end;
+
+		const video::SMaterial& material = Materials[b];
+		video::IMaterialRenderer* rnd = driver->getMaterialRenderer(material.MaterialType);
+		const bool transparent = (rnd && rnd->isTransparent()) || material.isTransparent();
+
+		if (transparent == isTransparentPass)
+		{
+			IMeshBuffer* mb = Mesh->getMeshBuffer(b);
+			driver->setMaterial(material);
+			if (BufferClusters[b] == BufferClusters[b+1])
+				driver->drawMeshBuffer(mb);
+			else
+				drawRanges(driver, mb, first, end);
+		}
+		first = end;
+	}
+
+	// for debug purposes only:
+	if (DebugDataVisible && PassCount == 1)
+	{
+		video::SMaterial m;
+		m.Lighting = false;
+		driver->setMaterial(m);
+
+		if (DebugDataVisible & scene::EDS_BBOX)
+			driver->draw3DBox(Mesh->getBoundingBox(), video::SColor(255,255,255,255));
+		if (DebugDataVisible & scene::EDS_BBOX_BUFFERS)
+		{
+			for (u32 g=0; g<Mesh->getMeshBufferCount(); ++g)
+				driver->draw3DBox(Mesh->getMeshBuffer(g)->getBoundingBox(), video::SColor(255,190,128,128));
+		}
+	}
+}
+
+
+//! returns the axis aligned bounding box of this node
+const core::aabbox3d<f32>& CClusteredMeshSceneNode::getBoundingBox() const
+{
+	return Mesh->getBoundingBox();
+}
+
+
+//! returns the material based on the zero based index i.
+video::SMaterial& CClusteredMeshSceneNode::getMaterial(u32 i)
+{
+	if (i >= Materials.size())
+		return ISceneNode::getMaterial(i);
+
+	return Materials[i];
+}
+
+
+//! returns amount of materials used by this scene node.
+u32 CClusteredMeshSceneNode::getMaterialCount() const
+{
+	return Materials.size();
+}
+
+
+//! Creates a clone of this scene node and its children.
+ISceneNode* CClusteredMeshSceneNode::clone(ISceneNode* newParent, ISceneManager* newManager)
+{
+	if (!newParent)
+		newParent = Parent;
+	if (!newManager)
+		newManager = SceneManager;
+
+	CClusteredMeshSceneNode* nb = new CClusteredMeshSceneNode(Mesh, Clusters, newParent,
+		newManager, ID, RelativeTranslation, RelativeRotation, RelativeScale);
+
+	nb->cloneMembers(this, newManager);
+	nb->Materials = Materials;
+
+	if (newParent)
+		nb->drop();
+	return nb;
+}
+
+} // end namespace scene
+} // end namespace irr
@@ -0,0 +1,103 @@
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#ifndef __C_CLUSTERED_MESH_SCENE_NODE_H_INCLUDED__
+#define __C_CLUSTERED_MESH_SCENE_NODE_H_INCLUDED__
+
+#include "IClusteredMeshSceneNode.h"
+#include "IMesh.h"
+
+namespace irr
+{
+namespace video
+{
+	class IVideoDriver;
+}
+namespace scene
+{
+
+	//! Scene node which culls small clusters of triangles of a static mesh separately
+	class CClusteredMeshSceneNode : public IClusteredMeshSceneNode
+	{
+	public:
+
+		//! constructor
+		/** \param mesh Mesh created by IMeshManipulator::createClusteredMesh().
+		\param clusters The clusters of the mesh. */
+		CClusteredMeshSceneNode(IMesh* mesh, const core::array<SMeshCluster>& clusters,
+			ISceneNode* parent, ISceneManager* mgr, s32 id,
+			const core::vector3df& position = core::vector3df(0,0,0),
+			const core::vector3df& rotation = core::vector3df(0,0,0),
+			const core::vector3df& scale = core::vector3df(1.0f, 1.0f, 1.0f));
+
+		//! destructor
+		virtual ~CClusteredMeshSceneNode();
+
+		virtual void OnRegisterSceneNode() _IRR_OVERRIDE_;
+
+		//! renders the node.
+		virtual void render() _IRR_OVERRIDE_;
+
+		//! returns the axis aligned bounding box of this node
+		virtual const core::aabbox3d<f32>& getBoundingBox() const _IRR_OVERRIDE_;
+
+		//! returns the material based on the zero based index i.
+		virtual video::SMaterial& getMaterial(u32 i) _IRR_OVERRIDE_;
+
+		//! returns amount of materials used by this scene node.
+		virtual u32 getMaterialCount() const _IRR_OVERRIDE_;
+
+		//! Returns type of the scene node
+		virtual ESCENE_NODE_TYPE getType() const _IRR_OVERRIDE_ { return ESNT_CLUSTERED_MESH; }
+
+		//! Returns the clustered mesh
+		virtual IMesh* getMesh() const _IRR_OVERRIDE_ { return Mesh; }
+
+		//! Returns the clusters of all mesh buffers
+		virtual const core::array<SMeshCluster>& getClusters() const _IRR_OVERRIDE_ { return Clusters; }
+
+		//! Returns the number of clusters which were drawn the last time the node was rendered
+		virtual u32 getVisibleClusterCount() const _IRR_OVERRIDE_ { return VisibleClusterCount; }
+
+		//! Returns the number of triangles which were drawn the last time the node was rendered
+		virtual u32 getVisibleTriangleCount() const _IRR_OVERRIDE_ { return VisibleTriangleCount; }
+
+		//! Creates a clone of this scene node and its children.
+		/** The clone shares the mesh with this node. */
+		virtual ISceneNode* clone(ISceneNode* newParent=0, ISceneManager* newManager=0) _IRR_OVERRIDE_;
+
+	private:
+
+		//! Indices of neighboring visible clusters, which are drawn together
+		struct SIndexRange
+		{
+			u32 MeshBuffer;
+			u32 FirstIndex;
+			u32 IndexCount;
+		};
+
+		//! Collects the index ranges of the visible clusters
+		void cullClusters();
+
+		//! Draws the visible index ranges of a mesh buffer with one call
+		void drawRanges(video::IVideoDriver* driver, const IMeshBuffer* mb, u32 first, u32 end);
+
+		IMesh* Mesh;
+		core::array<SMeshCluster> Clusters;
+		//! first cluster of each mesh buffer, with one entry more than mesh buffers
+		core::array<u32> BufferClusters;
+		core::array<video::SMaterial> Materials;
+
+		//! visible ranges sorted by mesh buffer and first index
+		core::array<SIndexRange> VisibleRanges;
+		//! indices of several ranges copied together
+		core::array<u8> MergedIndices;
+		u32 VisibleClusterCount;
+		u32 VisibleTriangleCount;
+		s32 PassCount;
+	};
+
+} // end namespace scene
+} // end namespace irr
+
+#endif
@@ -22,6 +22,7 @@
 #include "IMeshSceneNode.h"
 #include "SMeshBufferLightMap.h"
 #include "irrMap.h"
+#include "irrHashMap.h"
 
 #ifdef _DEBUG
 #define COLLADA_READER_DEBUG
@@ -2145,7 +2146,15 @@ void CColladaFileLoader::readPolygonSection(io::IXMLReaderUTF8* reader,
 		scene::SMeshBuffer* mbuffer = new SMeshBuffer();
 		buffer = mbuffer;
 
-		core::map<video::S3DVertex, int> vertMap;
+		// vertices built from the same sources are compared bytewise
+		typedef core::hashmap<video::S3DVertex, int,
+			core::hash_bytes<video::S3DVertex>, core::equal_bytes<video::S3DVertex> > VertexMap;
+		VertexMap vertMap;
+
+		u32 cornerCount = 0;
+		for (u32 i=0; i<polygons.size(); ++i)
+			cornerCount += polygons[i].Indices.size() / maxOffset;
+		vertMap.reserve(cornerCount);
 
 		for (u32 i=0; i<polygons.size(); ++i)
 		{
@@ -2219,7 +2228,7 @@ void CColladaFileLoader::readPolygonSection(io::IXMLReaderUTF8* reader,
 				}
 
 				//first, try to find this vertex in the mesh
-				core::map<video::S3DVertex, int>::Node* n = vertMap.find(vtx);
+				VertexMap::Node* n = vertMap.find(vtx);
 				if (n)
 				{
 					indices.push_back(n->getValue());
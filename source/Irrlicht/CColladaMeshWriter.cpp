@@ -1535,6 +1535,18 @@ void CColladaMeshWriter::writeMeshGeometry(const irr::core::stringw& meshname, s
 					}
 				}
 				break;
+			case video::EVT_QUANTIZED:
+			case video::EVT_QUANTIZED_TANGENTS:
+				{
+					// the const accessors decode quantized vertices
+					const scene::IMeshBuffer* constBuffer = buffer;
+					for (u32 j=0; j<vertexCount; ++j)
+					{
+						writeVector(constBuffer->getPosition(j));
+						Writer->writeLineBreak();
+					}
+				}
+				break;
 			}
 		}
 
@@ -1625,6 +1637,18 @@ void CColladaMeshWriter::writeMeshGeometry(const irr::core::stringw& meshname, s
 					}
 				}
 				break;
+			case video::EVT_QUANTIZED:
+			case video::EVT_QUANTIZED_TANGENTS:
+				{
+					// the const accessors decode quantized vertices
+					const scene::IMeshBuffer* constBuffer = buffer;
+					for (u32 j=0; j<vertexCount; ++j)
+					{
+						writeUv(constBuffer->getTCoords(j));
+						Writer->writeLineBreak();
+					}
+				}
+				break;
 			}
 		}
 
@@ -1712,6 +1736,18 @@ void CColladaMeshWriter::writeMeshGeometry(const irr::core::stringw& meshname, s
 					}
 				}
 				break;
+			case video::EVT_QUANTIZED:
+			case video::EVT_QUANTIZED_TANGENTS:
+				{
+					// the const accessors decode quantized vertices
+					const scene::IMeshBuffer* constBuffer = buffer;
+					for (u32 j=0; j<vertexCount; ++j)
+					{
+						writeVector(constBuffer->getNormal(j));
+						Writer->writeLineBreak();
+					}
+				}
+				break;
 			}
 		}
 
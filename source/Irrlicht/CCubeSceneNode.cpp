@@ -163,7 +163,7 @@ IShadowVolumeSceneNode* CCubeSceneNode::addShadowVolumeSceneNode(
 
 void CCubeSceneNode::OnRegisterSceneNode()
 {
-	if (IsVisible)
+	if (IsVisible && MeshVisible)
 		SceneManager->registerNodeForRendering(this);
 	ISceneNode::OnRegisterSceneNode();
 }
@@ -45,6 +45,9 @@ namespace scene
 		//! Returns type of the scene node
 		virtual ESCENE_NODE_TYPE getType() const _IRR_OVERRIDE_ { return ESNT_CUBE; }
 
+		//! Uses the transformation handling of ISceneNode
+		virtual bool hasPlainTransformation() const _IRR_OVERRIDE_ { return true; }
+
 		//! Creates shadow volume scene node as child of this node
 		//! and returns a pointer to it.
 		virtual IShadowVolumeSceneNode* addShadowVolumeSceneNode(const IMesh* shadowMesh,
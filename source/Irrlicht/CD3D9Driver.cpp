@@ -659,6 +659,8 @@ bool CD3D9Driver::queryFeature(E_VIDEO_DRIVER_FEATURE feature) const
 		return true;
 	case EVDF_TEXTURE_CUBEMAP:
 		return true;
+	case EVDF_POINT_SPRITES:
+		return Caps.MaxPointSize > 1.0f;
 	default:
 		return false;
 	};
@@ -922,7 +924,9 @@ bool CD3D9Driver::updateVertexHardwareBuffer(SHWBufferLink_d3d9 *hwBuffer)
 	const scene::IMeshBuffer* mb = hwBuffer->MeshBuffer;
 	const void* vertices=mb->getVertices();
 	const u32 vertexCount=mb->getVertexCount();
-	const E_VERTEX_TYPE vType=mb->getVertexType();
+	// the flexible vertex formats can't decode quantized vertices, so they
+	// are decoded once into the buffer
+	const E_VERTEX_TYPE vType=getDecodedVertexType(mb->getVertexType());
 	const u32 vertexSize = getVertexPitchFromType(vType);
 	const u32 bufSize = vertexSize * vertexCount;
 
@@ -965,14 +969,14 @@ bool CD3D9Driver::updateVertexHardwareBuffer(SHWBufferLink_d3d9 *hwBuffer)
 
 		void* lockedBuffer = 0;
 		hwBuffer->vertexBuffer->Lock(0, bufSize, (void**)&lockedBuffer, flags);
-		memcpy(lockedBuffer, vertices, bufSize);
+		decodeQuantizedVertices(vertices, vertexCount, mb->getVertexType(), mb->getVertexQuantization(), lockedBuffer);
 		hwBuffer->vertexBuffer->Unlock();
 	}
 	else
 	{
 		void* lockedBuffer = 0;
 		hwBuffer->vertexBuffer->Lock(0, bufSize, (void**)&lockedBuffer, D3DLOCK_DISCARD);
-		memcpy(lockedBuffer, vertices, bufSize);
+		decodeQuantizedVertices(vertices, vertexCount, mb->getVertexType(), mb->getVertexQuantization(), lockedBuffer);
 		hwBuffer->vertexBuffer->Unlock();
 	}
 
@@ -1151,13 +1155,14 @@ void CD3D9Driver::drawHardwareBuffer(SHWBufferLink *_HWBuffer)
 	HWBuffer->LastUsed=0;//reset count
 
 	const scene::IMeshBuffer* mb = HWBuffer->MeshBuffer;
-	const E_VERTEX_TYPE vType = mb->getVertexType();
-	const u32 stride = getVertexPitchFromType(vType);
+	E_VERTEX_TYPE vType = mb->getVertexType();
 	const void* vPtr = mb->getVertices();
 	const void* iPtr = mb->getIndices();
 	if (HWBuffer->vertexBuffer)
 	{
-		pID3DDevice->SetStreamSource(0, HWBuffer->vertexBuffer, 0, stride);
+		// quantized vertices are stored decoded in the vertex buffer
+		vType = getDecodedVertexType(vType);
+		pID3DDevice->SetStreamSource(0, HWBuffer->vertexBuffer, 0, getVertexPitchFromType(vType));
 		vPtr=0;
 	}
 	if (HWBuffer->indexBuffer)
@@ -1166,7 +1171,7 @@ void CD3D9Driver::drawHardwareBuffer(SHWBufferLink *_HWBuffer)
 		iPtr=0;
 	}
 
-	drawVertexPrimitiveList(vPtr, mb->getVertexCount(), iPtr, mb->getPrimitiveCount(), mb->getVertexType(), mb->getPrimitiveType(), mb->getIndexType());
+	drawVertexPrimitiveList(vPtr, mb->getVertexCount(), iPtr, mb->getPrimitiveCount(), vType, mb->getPrimitiveType(), mb->getIndexType());
 
 	if (HWBuffer->vertexBuffer)
 		pID3DDevice->SetStreamSource(0, 0, 0, 0);
@@ -1291,6 +1296,9 @@ void CD3D9Driver::drawVertexPrimitiveList(const void* vertices,
 	if (!vertexCount || !primitiveCount)
 		return;
 
+	// the flexible vertex formats can't decode quantized vertices
+	vertices = decodeQuantizedVertices(vertices, vertexCount, vType);
+
 	draw2D3DVertexPrimitiveList(vertices, vertexCount, indexList, primitiveCount,
 		vType, pType, iType, true);
 }
@@ -0,0 +1,169 @@
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#include "CFrustumCuller.h"
+
+#ifdef _IRR_COMPILE_WITH_SSE_
+#include <xmmintrin.h>
+#endif
+
+namespace irr
+{
+namespace scene
+{
+
+//! Removes all boxes
+void CFrustumCuller::clear()
+{
+	CenterX.set_used(0);
+	CenterY.set_used(0);
+	CenterZ.set_used(0);
+	ExtentX.set_used(0);
+	ExtentY.set_used(0);
+	ExtentZ.set_used(0);
+	Results.set_used(0);
+}
+
+
+//! Adds a world space box which will be tested in the next cull() call.
+u32 CFrustumCuller::addBox(const core::aabbox3df& box, u8 planeHint)
+{
+	const core::vector3df center = box.getCenter();
+	const core::vector3df extent = box.MaxEdge - center;
+
+	CenterX.push_back(center.X);
+	CenterY.push_back(center.Y);
+	CenterZ.push_back(center.Z);
+	ExtentX.push_back(extent.X);
+	ExtentY.push_back(extent.Y);
+	ExtentZ.push_back(extent.Z);
+	Results.push_back(planeHint < NO_PLANE ? planeHint : (u8)NO_PLANE);
+
+	return Results.size()-1;
+}
+
+
+//! Tests a single box against a single plane
+bool CFrustumCuller::isCulledByPlane(u32 index, const core::plane3df& plane) const
+{
+	// distance of the box corner which is nearest to the inner side of the plane
+	const f32 d = plane.Normal.X * CenterX[index] + plane.Normal.Y * CenterY[index] +
+		plane.Normal.Z * CenterZ[index] + plane.D -
+		(core::abs_(plane.Normal.X) * ExtentX[index] + core::abs_(plane.Normal.Y) * ExtentY[index] +
+		core::abs_(plane.Normal.Z) * ExtentZ[index]);
+
+	// all corners in front of the plane means outside the frustum
+	return d > core::ROUNDING_ERROR_f32;
+}
+
+
+//! Tests all boxes against the frustum.
+void CFrustumCuller::cull(const SViewFrustum& frustum)
+{
+	const u32 count = Results.size();
+	if (!count)
+		return;
+
+	// bit i is set while box i of a group of four is undecided
+	Pending.set_used((count+3)/4);
+	u32 i;
+	for (i=0; i<Pending.size(); ++i)
+		Pending[i] = 0;
+
+	// plane which culled the box last time first, that's usually enough
+	for (i=0; i<count; ++i)
+	{
+		const u8 hint = Results[i];
+		if (hint < NO_PLANE && isCulledByPlane(i, frustum.planes[hint]))
+			continue;
+		Results[i] = NO_PLANE;
+		Pending[i/4] |= (u8)(1 << (i&3));
+	}
+
+	// pad to full groups of four, the padded boxes are never pending
+	const u32 padded = Pending.size()*4;
+	for (i=count; i<padded; ++i)
+	{
+		CenterX.push_back(0.f);
+		CenterY.push_back(0.f);
+		CenterZ.push_back(0.f);
+		ExtentX.push_back(0.f);
+		ExtentY.push_back(0.f);
+		ExtentZ.push_back(0.f);
+	}
+
+#ifdef _IRR_COMPILE_WITH_SSE_
+	__m128 nx[SViewFrustum::VF_PLANE_COUNT], ny[SViewFrustum::VF_PLANE_COUNT], nz[SViewFrustum::VF_PLANE_COUNT];
+	__m128 ax[SViewFrustum::VF_PLANE_COUNT], ay[SViewFrustum::VF_PLANE_COUNT], az[SViewFrustum::VF_PLANE_COUNT];
+	__m128 pd[SViewFrustum::VF_PLANE_COUNT];
+	for (u32 p=0; p<SViewFrustum::VF_PLANE_COUNT; ++p)
+	{
+		const core::plane3df& plane = frustum.planes[p];
+		nx[p] = _mm_set1_ps(plane.Normal.X);
+		ny[p] = _mm_set1_ps(plane.Normal.Y);
+		nz[p] = _mm_set1_ps(plane.Normal.Z);
+		ax[p] = _mm_set1_ps(core::abs_(plane.Normal.X));
+		ay[p] = _mm_set1_ps(core::abs_(plane.Normal.Y));
+		az[p] = _mm_set1_ps(core::abs_(plane.Normal.Z));
+		pd[p] = _mm_set1_ps(plane.D);
+	}
+	const __m128 epsilon = _mm_set1_ps(core::ROUNDING_ERROR_f32);
+#endif
+
+	for (u32 group=0; group<Pending.size(); ++group)
+	{
+		u32 undecided = Pending[group];
+		if (!undecided)
+			continue;
+
+		const u32 first = group*4;
+
+#ifdef _IRR_COMPILE_WITH_SSE_
+		const __m128 cx = _mm_loadu_ps(&CenterX[first]);
+		const __m128 cy = _mm_loadu_ps(&CenterY[first]);
+		const __m128 cz = _mm_loadu_ps(&CenterZ[first]);
+		const __m128 ex = _mm_loadu_ps(&ExtentX[first]);
+		const __m128 ey = _mm_loadu_ps(&ExtentY[first]);
+		const __m128 ez = _mm_loadu_ps(&ExtentZ[first]);
+#endif
+
+		for (u32 p=0; p<SViewFrustum::VF_PLANE_COUNT && undecided; ++p)
+		{
+			u32 culled;
+#ifdef _IRR_COMPILE_WITH_SSE_
+			const __m128 dist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx[p], cx), _mm_mul_ps(ny[p], cy)),
+				_mm_add_ps(_mm_mul_ps(nz[p], cz), pd[p]));
+			const __m128 radius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax[p], ex), _mm_mul_ps(ay[p], ey)),
+				_mm_mul_ps(az[p], ez));
+			culled = (u32)_mm_movemask_ps(_mm_cmpgt_ps(_mm_sub_ps(dist, radius), epsilon));
+#else
+			culled = 0;
+			for (u32 lane=0; lane<4; ++lane)
+			{
+				if (isCulledByPlane(first+lane, frustum.planes[p]))
+					culled |= 1 << lane;
+			}
+#endif
+			culled &= undecided;
+			if (!culled)
+				continue;
+
+			for (u32 lane=0; lane<4; ++lane)
+			{
+				if (culled & (1 << lane))
+					Results[first+lane] = (u8)p;
+			}
+			undecided &= ~culled;
+		}
+	}
+
+	CenterX.set_used(count);
+	CenterY.set_used(count);
+	CenterZ.set_used(count);
+	ExtentX.set_used(count);
+	ExtentY.set_used(count);
+	ExtentZ.set_used(count);
+}
+
+} // end namespace scene
+} // end namespace irr
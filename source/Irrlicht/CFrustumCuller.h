@@ -0,0 +1,73 @@
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#ifndef __C_FRUSTUM_CULLER_H_INCLUDED__
+#define __C_FRUSTUM_CULLER_H_INCLUDED__
+
+#include "IrrCompileConfig.h"
+#include "SViewFrustum.h"
+#include "irrArray.h"
+
+namespace irr
+{
+namespace scene
+{
+
+//! Tests many world space bounding boxes against the planes of a view frustum.
+/** The boxes are stored as centers and half extents in separate arrays, so
+four boxes can be tested against a plane at once with SSE. For each box the
+plane which culled it is returned, which can be passed back as hint in the
+next frame. As objects and the camera usually don't move much between frames,
+that plane will often cull the box again and the other planes don't have to
+be tested at all. */
+class CFrustumCuller
+{
+public:
+
+	//! Returned by getCullingPlane() for visible boxes, also used for "no hint".
+	enum { NO_PLANE = SViewFrustum::VF_PLANE_COUNT };
+
+	//! Removes all boxes
+	void clear();
+
+	//! Adds a world space box which will be tested in the next cull() call.
+	/** \param box The axis aligned box.
+	\param planeHint Plane which culled the box the last time, or NO_PLANE.
+	\return Index of the box, used for getCullingPlane(). */
+	u32 addBox(const core::aabbox3df& box, u8 planeHint);
+
+	//! Returns the number of boxes added since the last clear()
+	u32 getBoxCount() const { return Results.size(); }
+
+	//! Tests all boxes against the frustum.
+	/** A box is culled when it is completely in front of one of the
+	frustum planes, just like the EAC_FRUSTUM_BOX test of the scene manager. */
+	void cull(const SViewFrustum& frustum);
+
+	//! Returns the plane which culled a box in the last cull() call, or NO_PLANE if it's visible.
+	u8 getCullingPlane(u32 index) const { return Results[index]; }
+
+private:
+
+	//! Tests a single box against a single plane
+	bool isCulledByPlane(u32 index, const core::plane3df& plane) const;
+
+	// boxes as centers and half extents, padded to a multiple of 4
+	core::array<f32> CenterX;
+	core::array<f32> CenterY;
+	core::array<f32> CenterZ;
+	core::array<f32> ExtentX;
+	core::array<f32> ExtentY;
+	core::array<f32> ExtentZ;
+
+	// plane hints on input, culling planes after cull()
+	core::array<u8> Results;
+
+	// undecided boxes of each group of four during cull()
+	core::array<u8> Pending;
+};
+
+} // end namespace scene
+} // end namespace irr
+
+#endif // __C_FRUSTUM_CULLER_H_INCLUDED__
@@ -0,0 +1,636 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#include "IrrCompileConfig.h"
+#ifdef _IRR_COMPILE_WITH_IRR_BINARY_MESH_LOADER_
+
+#include "CIrrBinaryMeshFileLoader.h"
+#include "CMappedReadFile.h"
+#include "CMappedMeshBuffer.h"
+#include "CMeshTextureLoader.h"
+#include "CDynamicMeshBuffer.h"
+#include "SAnimatedMesh.h"
+#include "SMesh.h"
+#include "SSkinMeshBuffer.h"
+#include "IReadFile.h"
+#include "IFileSystem.h"
+#include "IVideoDriver.h"
+#include "os.h"
+
+namespace irr
+{
+namespace scene
+{
+
+namespace
+{
+
+core::aabbox3df getBoundingBox(const f32* values)
+{
+	return core::aabbox3df(values[0], values[1], values[2], values[3], values[4], values[5]);
+}
+
+video::SVertexQuantization getQuantization(const SIrrBinaryMeshBuffer& entry)
+{
+	video::SVertexQuantization quantization;
+	quantization.Offset.set(entry.QuantizationOffset[0], entry.QuantizationOffset[1], entry.QuantizationOffset[2]);
+	quantization.Scale.set(entry.QuantizationScale[0], entry.QuantizationScale[1], entry.QuantizationScale[2]);
+	return quantization;
+}
+
+//! checks that all indices of a buffer reference one of its vertices
+bool hasValidIndices(const IMeshBuffer* buffer)
+{
+	const u32 vertexCount = buffer->getVertexCount();
+	const u32 indexCount = buffer->getIndexCount();
+	u32 i;
+	if (buffer->getIndexType() == video::EIT_32BIT)
+	{
+		const u32* indices = (const u32*)buffer->getIndices();
+		for (i=0; i<indexCount; ++i)
+			if (indices[i] >= vertexCount)
+				return false;
+	}
+	else
+	{
+		const u16* indices = buffer->getIndices();
+		for (i=0; i<indexCount; ++i)
+			if (indices[i] >= vertexCount)
+				return false;
+	}
+	return true;
+}
+
+//! copies the vertices and indices of a buffer out of the file
+template <class T>
+IMeshBuffer* readMeshBuffer(io::IReadFile* file, const SIrrBinaryMeshBuffer& entry)
+{
+	if (entry.IndexType == video::EIT_16BIT)
+	{
+		CMeshBuffer<T>* buffer = new CMeshBuffer<T>();
+		buffer->Vertices.set_used(entry.VertexCount);
+		buffer->Indices.set_used(entry.IndexCount);
+		file->seek(entry.VertexOffset);
+		file->read(buffer->Vertices.pointer(), entry.VertexCount*sizeof(T));
+		file->seek(entry.IndexOffset);
+		file->read(buffer->Indices.pointer(), entry.IndexCount*sizeof(u16));
+		buffer->Quantization = getQuantization(entry);
+		return buffer;
+	}
+
+	// large buffers of the float vertex types
+	CDynamicMeshBuffer* buffer = new CDynamicMeshBuffer((video::E_VERTEX_TYPE)entry.VertexType, video::EIT_32BIT);
+	buffer->getVertexBuffer().set_used(entry.VertexCount);
+	buffer->getIndexBuffer().set_used(entry.IndexCount);
+	file->seek(entry.VertexOffset);
+	file->read(buffer->getVertexBuffer().getData(), entry.VertexCount*sizeof(T));
+	file->seek(entry.IndexOffset);
+	file->read(buffer->getIndexBuffer().getData(), entry.IndexCount*sizeof(u32));
+	return buffer;
+}
+
+//! copies quantized vertices with 32 bit indices out of the file
+/** No mesh buffer holding its own arrays supports this combination, so the
+data is kept in a memory file which a mapped mesh buffer points into. */
+IMeshBuffer* readQuantizedMeshBuffer32(io::IFileSystem* fileSystem, io::IReadFile* file, const SIrrBinaryMeshBuffer& entry)
+{
+	const video::E_VERTEX_TYPE vType = (video::E_VERTEX_TYPE)entry.VertexType;
+	const u32 vertexSize = entry.VertexCount*video::getVertexPitchFromType(vType);
+	const u32 indexSize = entry.IndexCount*sizeof(u32);
+	c8* data = new c8[vertexSize+indexSize];
+	file->seek(entry.VertexOffset);
+	file->read(data, vertexSize);
+	file->seek(entry.IndexOffset);
+	file->read(data+vertexSize, indexSize);
+
+	io::IReadFile* owner = fileSystem->createMemoryReadFile(data, vertexSize+indexSize, file->getFileName(), true);
+	CMappedMeshBuffer* buffer = new CMappedMeshBuffer(owner, data, entry.VertexCount, vType,
+		data+vertexSize, entry.IndexCount, video::EIT_32BIT);
+	owner->drop();
+	buffer->Quantization = getQuantization(entry);
+	return buffer;
+}
+
+} // end anonymous namespace
+
+
+//! Constructor
+CIrrBinaryMeshFileLoader::CIrrBinaryMeshFileLoader(scene::ISceneManager* smgr)
+	: SceneManager(smgr)
+{
+	#ifdef _DEBUG
+	setDebugName("CIrrBinaryMeshFileLoader");
+	#endif
+
+	TextureLoader = new CMeshTextureLoader( SceneManager->getFileSystem(), SceneManager->getVideoDriver() );
+}
+
+
+//! Returns true if the file maybe is able to be loaded by this class.
+/** This decision should be based only on the file extension (e.g. ".cob") */
+bool CIrrBinaryMeshFileLoader::isALoadableFileExtension(const io::path& filename) const
+{
+	return core::hasFileExtension ( filename, "irrbmesh" );
+}
+
+
+//! creates/loads an animated mesh from the file.
+//! \return Pointer to the created mesh. Returns 0 if loading failed.
+//! If you no longer need the mesh, you should call IAnimatedMesh::drop().
+//! See IReferenceCounted::drop() for more information.
+IAnimatedMesh* CIrrBinaryMeshFileLoader::createMesh(io::IReadFile* file)
+{
+	if (!file)
+		return 0;
+#ifdef __BIG_ENDIAN__
+	os::Printer::log("Binary Irrlicht meshes are not supported on big-endian systems.", ELL_ERROR);
+	return 0;
+#endif
+
+	SIrrBinaryMeshHeader header;
+	if (file->read(&header, sizeof(header)) != sizeof(header) ||
+		header.Magic != IRR_BINARY_MESH_MAGIC)
+	{
+		os::Printer::log("Not a binary Irrlicht mesh", file->getFileName(), ELL_ERROR);
+		return 0;
+	}
+	if (header.Version != IRR_BINARY_MESH_VERSION)
+	{
+		os::Printer::log("Unsupported binary Irrlicht mesh version", file->getFileName(), ELL_ERROR);
+		return 0;
+	}
+
+	if ( getMeshTextureLoader() )
+		getMeshTextureLoader()->setMeshFile(file);
+
+	// material table
+
+	core::array<video::SMaterial> materials;
+	if (!file->seek(header.MaterialOffset) || !isReadable(file, header.MaterialCount, 1))
+	{
+		os::Printer::log("Invalid material table in binary Irrlicht mesh", file->getFileName(), ELL_ERROR);
+		return 0;
+	}
+	materials.reallocate(header.MaterialCount);
+	u32 i;
+	for (i=0; i<header.MaterialCount; ++i)
+	{
+		video::SMaterial material;
+		if (!readMaterial(file, material))
+		{
+			os::Printer::log("Invalid material table in binary Irrlicht mesh", file->getFileName(), ELL_ERROR);
+			return 0;
+		}
+		materials.push_back(material);
+	}
+
+	// buffer table
+
+	core::array<SIrrBinaryMeshBuffer> buffers;
+	if (!file->seek(header.BufferOffset) || !isReadable(file, header.BufferCount, sizeof(SIrrBinaryMeshBuffer)))
+	{
+		os::Printer::log("Invalid buffer table in binary Irrlicht mesh", file->getFileName(), ELL_ERROR);
+		return 0;
+	}
+	buffers.set_used(header.BufferCount);
+	if (header.BufferCount)
+		file->read(buffers.pointer(), header.BufferCount*sizeof(SIrrBinaryMeshBuffer));
+	for (i=0; i<buffers.size(); ++i)
+	{
+		if (!isValidBuffer(buffers[i], materials.size(), file->getSize()))
+		{
+			os::Printer::log("Invalid mesh buffer in binary Irrlicht mesh", file->getFileName(), ELL_ERROR);
+			return 0;
+		}
+	}
+
+	if (header.Flags & EIBMF_SKINNED)
+		return createSkinnedMesh(file, header, materials, buffers);
+
+	// Files on disk are mapped, so the vertices and indices are only
+	// paged in when they are accessed and never copied.
+	io::CMappedReadFile* mappedFile = 0;
+	if (file->getType() == io::ERFT_READ_FILE)
+	{
+		mappedFile = io::CMappedReadFile::createMappedReadFile(file->getFileName());
+		if (mappedFile && mappedFile->getSize() != file->getSize())
+		{
+			mappedFile->drop();
+			mappedFile = 0;
+		}
+	}
+
+	IAnimatedMesh* mesh = createStaticMesh(file, mappedFile, header, materials, buffers);
+
+	if (mappedFile)
+		mappedFile->drop();
+
+	return mesh;
+}
+
+
+IAnimatedMesh* CIrrBinaryMeshFileLoader::createStaticMesh(io::IReadFile* file, io::CMappedReadFile* mappedFile,
+		const SIrrBinaryMeshHeader& header, const core::array<video::SMaterial>& materials,
+		const core::array<SIrrBinaryMeshBuffer>& buffers)
+{
+	SMesh* mesh = new SMesh();
+
+	for (u32 i=0; i<buffers.size(); ++i)
+	{
+		const SIrrBinaryMeshBuffer& entry = buffers[i];
+		IMeshBuffer* buffer = 0;
+
+		if (mappedFile)
+		{
+			u8* data = mappedFile->getMappedData();
+			CMappedMeshBuffer* mappedBuffer = new CMappedMeshBuffer(mappedFile,
+				data + entry.VertexOffset, entry.VertexCount, (video::E_VERTEX_TYPE)entry.VertexType,
+				data + entry.IndexOffset, entry.IndexCount, (video::E_INDEX_TYPE)entry.IndexType);
+			mappedBuffer->Quantization = getQuantization(entry);
+			buffer = mappedBuffer;
+		}
+		else
+		{
+			switch (entry.VertexType)
+			{
+			case video::EVT_STANDARD:
+				buffer = readMeshBuffer<video::S3DVertex>(file, entry);
+				break;
+			case video::EVT_2TCOORDS:
+				buffer = readMeshBuffer<video::S3DVertex2TCoords>(file, entry);
+				break;
+			case video::EVT_TANGENTS:
+				buffer = readMeshBuffer<video::S3DVertexTangents>(file, entry);
+				break;
+			case video::EVT_QUANTIZED:
+				if (entry.IndexType == video::EIT_16BIT)
+					buffer = readMeshBuffer<video::S3DVertexQuantized>(file, entry);
+				else
+					buffer = readQuantizedMeshBuffer32(SceneManager->getFileSystem(), file, entry);
+				break;
+			case video::EVT_QUANTIZED_TANGENTS:
+				if (entry.IndexType == video::EIT_16BIT)
+					buffer = readMeshBuffer<video::S3DVertexQuantizedTangents>(file, entry);
+				else
+					buffer = readQuantizedMeshBuffer32(SceneManager->getFileSystem(), file, entry);
+				break;
+			}
+		}
+
+		if (!hasValidIndices(buffer))
+		{
+			os::Printer::log("Invalid indices in binary Irrlicht mesh", file->getFileName(), ELL_ERROR);
+			buffer->drop();
+			mesh->drop();
+			return 0;
+		}
+
+		buffer->getMaterial() = materials[entry.MaterialIndex];
+		buffer->setBoundingBox(getBoundingBox(entry.BoundingBox));
+		buffer->setPrimitiveType((E_PRIMITIVE_TYPE)entry.PrimitiveType);
+		buffer->setHardwareMappingHint((E_HARDWARE_MAPPING)(entry.HardwareMappingHints & 0xf), EBT_VERTEX);
+		buffer->setHardwareMappingHint((E_HARDWARE_MAPPING)(entry.HardwareMappingHints >> 4), EBT_INDEX);
+		mesh->addMeshBuffer(buffer);
+		buffer->drop();
+	}
+
+	mesh->setBoundingBox(getBoundingBox(header.BoundingBox));
+
+	SAnimatedMesh* animatedMesh = new SAnimatedMesh(mesh);
+	mesh->drop();
+
+	return animatedMesh;
+}
+
+
+IAnimatedMesh* CIrrBinaryMeshFileLoader::createSkinnedMesh(io::IReadFile* file,
+		const SIrrBinaryMeshHeader& header, const core::array<video::SMaterial>& materials,
+		const core::array<SIrrBinaryMeshBuffer>& buffers)
+{
+#ifdef _IRR_COMPILE_WITH_SKINNED_MESH_SUPPORT_
+	ISkinnedMesh* mesh = SceneManager->createSkinnedMesh();
+
+	// skinned meshes animate their buffers, so the data is always copied
+	u32 i;
+	for (i=0; i<buffers.size(); ++i)
+	{
+		const SIrrBinaryMeshBuffer& entry = buffers[i];
+		SSkinMeshBuffer* buffer = mesh->addMeshBuffer();
+		void* vertices = 0;
+
+		buffer->VertexType = (video::E_VERTEX_TYPE)entry.VertexType;
+		switch (buffer->VertexType)
+		{
+		case video::EVT_STANDARD:
+			buffer->Vertices_Standard.set_used(entry.VertexCount);
+			vertices = buffer->Vertices_Standard.pointer();
+			break;
+		case video::EVT_2TCOORDS:
+			buffer->Vertices_2TCoords.set_used(entry.VertexCount);
+			vertices = buffer->Vertices_2TCoords.pointer();
+			break;
+		case video::EVT_TANGENTS:
+			buffer->Vertices_Tangents.set_used(entry.VertexCount);
+			vertices = buffer->Vertices_Tangents.pointer();
+			break;
+		default:
+			os::Printer::log("Skinned meshes can't use quantized vertices", file->getFileName(), ELL_ERROR);
+			mesh->drop();
+			return 0;
+		}
+		file->seek(entry.VertexOffset);
+		file->read(vertices, entry.VertexCount*video::getVertexPitchFromType(buffer->VertexType));
+
+		file->seek(entry.IndexOffset);
+		if (entry.IndexType == video::EIT_32BIT)
+		{
+			buffer->IndexType = video::EIT_32BIT;
+			buffer->Indices32.set_used(entry.IndexCount);
+			file->read(buffer->Indices32.pointer(), entry.IndexCount*sizeof(u32));
+		}
+		else
+		{
+			buffer->Indices.set_used(entry.IndexCount);
+			file->read(buffer->Indices.pointer(), entry.IndexCount*sizeof(u16));
+		}
+		if (!hasValidIndices(buffer))
+		{
+			os::Printer::log("Invalid indices in binary Irrlicht mesh", file->getFileName(), ELL_ERROR);
+			mesh->drop();
+			return 0;
+		}
+
+		buffer->Material = materials[entry.MaterialIndex];
+		buffer->BoundingBox = getBoundingBox(entry.BoundingBox);
+		buffer->setPrimitiveType((E_PRIMITIVE_TYPE)entry.PrimitiveType);
+		buffer->setHardwareMappingHint((E_HARDWARE_MAPPING)(entry.HardwareMappingHints & 0xf), EBT_VERTEX);
+		buffer->setHardwareMappingHint((E_HARDWARE_MAPPING)(entry.HardwareMappingHints >> 4), EBT_INDEX);
+	}
+
+	// joints reference each other by index, so all of them are created first
+	if (!file->seek(header.JointOffset) || !isReadable(file, header.JointCount, 1))
+	{
+		os::Printer::log("Invalid joints in binary Irrlicht mesh", file->getFileName(), ELL_ERROR);
+		mesh->drop();
+		return 0;
+	}
+	for (i=0; i<header.JointCount; ++i)
+		mesh->addJoint(0);
+	for (i=0; i<header.JointCount; ++i)
+	{
+		if (!readJoint(file, mesh, mesh->getAllJoints()[i]))
+		{
+			os::Printer::log("Invalid joints in binary Irrlicht mesh", file->getFileName(), ELL_ERROR);
+			mesh->drop();
+			return 0;
+		}
+	}
+
+	mesh->setAnimationSpeed(header.AnimationSpeed);
+	mesh->finalize();
+
+	return mesh;
+#else
+	os::Printer::log("Skinned mesh support is disabled, can't load", file->getFileName(), ELL_ERROR);
+	return 0;
+#endif
+}
+
+
+bool CIrrBinaryMeshFileLoader::readMaterial(io::IReadFile* file, video::SMaterial& material)
+{
+	video::IVideoDriver* driver = SceneManager->getVideoDriver();
+
+	core::stringc typeName;
+	if (!readString(file, typeName))
+		return false;
+	material.MaterialType = video::EMT_SOLID;
+	for (u32 i=0; i<driver->getMaterialRendererCount(); ++i)
+	{
+		if (typeName == driver->getMaterialRendererName(i))
+		{
+			material.MaterialType = (video::E_MATERIAL_TYPE)i;
+			break;
+		}
+	}
+
+	u32 colors[4];
+	f32 values[5];
+	u8 modes[8];
+	u16 flags;
+	u8 layerCount;
+	if (file->read(colors, sizeof(colors)) != sizeof(colors) ||
+		file->read(values, sizeof(values)) != sizeof(values) ||
+		file->read(modes, sizeof(modes)) != sizeof(modes) ||
+		file->read(&flags, sizeof(flags)) != sizeof(flags) ||
+		file->read(&layerCount, 1) != 1)
+		return false;
+
+	material.AmbientColor.color = colors[0];
+	material.DiffuseColor.color = colors[1];
+	material.EmissiveColor.color = colors[2];
+	material.SpecularColor.color = colors[3];
+
+	material.Shininess = values[0];
+	material.MaterialTypeParam = values[1];
+	material.MaterialTypeParam2 = values[2];
+	material.Thickness = values[3];
+	material.BlendFactor = values[4];
+
+	material.ZBuffer = modes[0];
+	material.AntiAliasing = modes[1];
+	material.ColorMask = modes[2];
+	material.ColorMaterial = modes[3];
+	material.BlendOperation = (video::E_BLEND_OPERATION)modes[4];
+	material.PolygonOffsetFactor = modes[5];
+	material.PolygonOffsetDirection = (video::E_POLYGON_OFFSET)modes[6];
+	material.ZWriteFineControl = (video::E_ZWRITE_FINE_CONTROL)modes[7];
+
+	material.Wireframe = (flags & EIBMTF_WIREFRAME) != 0;
+	material.PointCloud = (flags & EIBMTF_POINTCLOUD) != 0;
+	material.GouraudShading = (flags & EIBMTF_GOURAUD_SHADING) != 0;
+	material.Lighting = (flags & EIBMTF_LIGHTING) != 0;
+	material.ZWriteEnable = (flags & EIBMTF_ZWRITE_ENABLE) != 0;
+	material.BackfaceCulling = (flags & EIBMTF_BACK_FACE_CULLING) != 0;
+	material.FrontfaceCulling = (flags & EIBMTF_FRONT_FACE_CULLING) != 0;
+	material.FogEnable = (flags & EIBMTF_FOG_ENABLE) != 0;
+	material.NormalizeNormals = (flags & EIBMTF_NORMALIZE_NORMALS) != 0;
+	material.UseMipMaps = (flags & EIBMTF_USE_MIP_MAPS) != 0;
+
+	for (u32 i=0; i<layerCount; ++i)
+	{
+		core::stringc textureName;
+		u8 layerValues[6];
+		if (!readString(file, textureName) ||
+			file->read(layerValues, sizeof(layerValues)) != sizeof(layerValues))
+			return false;
+
+		core::matrix4 matrix;
+		if ((layerValues[3] & EIBLF_TEXTURE_MATRIX) &&
+			file->read(matrix.pointer(), 16*sizeof(f32)) != 16*sizeof(f32))
+			return false;
+
+		// layers of files written with more textures than supported are skipped
+		if (i >= video::MATERIAL_MAX_TEXTURES)
+			continue;
+
+		video::SMaterialLayer& layer = material.TextureLayer[i];
+		if (textureName.size() && getMeshTextureLoader())
+			layer.Texture = getMeshTextureLoader()->getTexture(textureName);
+		layer.TextureWrapU = layerValues[0];
+		layer.TextureWrapV = layerValues[1];
+		layer.TextureWrapW = layerValues[2];
+		layer.BilinearFilter = (layerValues[3] & EIBLF_BILINEAR_FILTER) != 0;
+		layer.TrilinearFilter = (layerValues[3] & EIBLF_TRILINEAR_FILTER) != 0;
+		layer.AnisotropicFilter = layerValues[4];
+		layer.LODBias = (s8)layerValues[5];
+		if (layerValues[3] & EIBLF_TEXTURE_MATRIX)
+			layer.setTextureMatrix(matrix);
+	}
+
+	return true;
+}
+
+
+bool CIrrBinaryMeshFileLoader::readJoint(io::IReadFile* file, ISkinnedMesh* mesh, ISkinnedMesh::SJoint* joint)
+{
+	const core::array<ISkinnedMesh::SJoint*>& allJoints = mesh->getAllJoints();
+
+	if (!readString(file, joint->Name) ||
+		file->read(joint->LocalMatrix.pointer(), 16*sizeof(f32)) != 16*sizeof(f32) ||
+		file->read(joint->GlobalInversedMatrix.pointer(), 16*sizeof(f32)) != 16*sizeof(f32))
+		return false;
+
+	u32 count;
+	u32 i;
+	if (!readU32(file, count) || !isReadable(file, count, sizeof(u32)))
+		return false;
+	for (i=0; i<count; ++i)
+	{
+		u32 child;
+		readU32(file, child);
+		if (child >= allJoints.size())
+			return false;
+		joint->Children.push_back(allJoints[child]);
+	}
+
+	if (!readU32(file, count) || !isReadable(file, count, sizeof(u32)))
+		return false;
+	const u32 bufferCount = mesh->getMeshBufferCount();
+	joint->AttachedMeshes.set_used(count);
+	if (count)
+		file->read(joint->AttachedMeshes.pointer(), count*sizeof(u32));
+	for (i=0; i<count; ++i)
+	{
+		if (joint->AttachedMeshes[i] >= bufferCount)
+			return false;
+	}
+
+	f32 values[5];
+	if (!readU32(file, count) || !isReadable(file, count, 4*sizeof(f32)))
+		return false;
+	for (i=0; i<count; ++i)
+	{
+		file->read(values, 4*sizeof(f32));
+		ISkinnedMesh::SPositionKey* key = mesh->addPositionKey(joint);
+		key->frame = values[0];
+		key->position.set(values[1], values[2], values[3]);
+	}
+
+	if (!readU32(file, count) || !isReadable(file, count, 4*sizeof(f32)))
+		return false;
+	for (i=0; i<count; ++i)
+	{
+		file->read(values, 4*sizeof(f32));
+		ISkinnedMesh::SScaleKey* key = mesh->addScaleKey(joint);
+		key->frame = values[0];
+		key->scale.set(values[1], values[2], values[3]);
+	}
+
+	if (!readU32(file, count) || !isReadable(file, count, 5*sizeof(f32)))
+		return false;
+	for (i=0; i<count; ++i)
+	{
+		file->read(values, 5*sizeof(f32));
+		ISkinnedMesh::SRotationKey* key = mesh->addRotationKey(joint);
+		key->frame = values[0];
+		key->rotation.set(values[1], values[2], values[3], values[4]);
+	}
+
+	if (!readU32(file, count) || !isReadable(file, count, 12))
+		return false;
+	for (i=0; i<count; ++i)
+	{
+		u16 buffer[2];
+		u32 vertex;
+		f32 strength;
+		file->read(buffer, sizeof(buffer));
+		readU32(file, vertex);
+		file->read(&strength, sizeof(f32));
+		if (buffer[0] >= bufferCount || vertex >= mesh->getMeshBuffer(buffer[0])->getVertexCount())
+			return false;
+
+		ISkinnedMesh::SWeight* weight = mesh->addWeight(joint);
+		weight->buffer_id = buffer[0];
+		weight->vertex_id = vertex;
+		weight->strength = strength;
+	}
+
+	return true;
+}
+
+
+bool CIrrBinaryMeshFileLoader::readString(io::IReadFile* file, core::stringc& str)
+{
+	u32 length;
+	if (!readU32(file, length) || !isReadable(file, length, 1))
+		return false;
+
+	core::array<c8> chars(length+1);
+	chars.set_used(length);
+	if (length)
+		file->read(chars.pointer(), length);
+	chars.push_back(0);
+	str = chars.const_pointer();
+	return true;
+}
+
+
+bool CIrrBinaryMeshFileLoader::readU32(io::IReadFile* file, u32& value)
+{
+	return file->read(&value, sizeof(u32)) == sizeof(u32);
+}
+
+
+bool CIrrBinaryMeshFileLoader::isValidBuffer(const SIrrBinaryMeshBuffer& buffer, u32 materialCount, long fileSize) const
+{
+	if (buffer.MaterialIndex >= materialCount ||
+		buffer.VertexType > video::EVT_QUANTIZED_TANGENTS ||
+		buffer.IndexType > video::EIT_32BIT ||
+		buffer.PrimitiveType > EPT_POINT_SPRITES)
+		return false;
+
+	// the mapped blobs must be aligned for the vertex structures
+	if ((buffer.VertexOffset % IRR_BINARY_MESH_ALIGNMENT) || (buffer.IndexOffset % IRR_BINARY_MESH_ALIGNMENT))
+		return false;
+
+	const u64 vertexEnd = buffer.VertexOffset +
+		(u64)buffer.VertexCount * video::getVertexPitchFromType((video::E_VERTEX_TYPE)buffer.VertexType);
+	const u64 indexEnd = buffer.IndexOffset +
+		(u64)buffer.IndexCount * (buffer.IndexType == video::EIT_32BIT ? sizeof(u32) : sizeof(u16));
+	return vertexEnd <= (u64)fileSize && indexEnd <= (u64)fileSize;
+}
+
+
+bool CIrrBinaryMeshFileLoader::isReadable(io::IReadFile* file, u32 count, u32 size) const
+{
+	return (u64)count * size <= (u64)(file->getSize() - file->getPos());
+}
+
+
+} // end namespace scene
+} // end namespace irr
+
+#endif // _IRR_COMPILE_WITH_IRR_BINARY_MESH_LOADER_
+
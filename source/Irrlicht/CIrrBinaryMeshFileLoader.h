@@ -0,0 +1,82 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#ifndef __C_IRR_BINARY_MESH_FILE_LOADER_H_INCLUDED__
+#define __C_IRR_BINARY_MESH_FILE_LOADER_H_INCLUDED__
+
+#include "IMeshLoader.h"
+#include "ISceneManager.h"
+#include "ISkinnedMesh.h"
+#include "SIrrBinaryMeshStructs.h"
+
+namespace irr
+{
+namespace io
+{
+	class CMappedReadFile;
+}
+namespace scene
+{
+
+
+//! Meshloader capable of loading .irrbmesh meshes, the binary Irrlicht Engine mesh format
+/** Static meshes loaded from files on disk use the vertices and indices of
+a memory mapped file directly instead of copying them. */
+class CIrrBinaryMeshFileLoader : public IMeshLoader
+{
+public:
+
+	//! Constructor
+	CIrrBinaryMeshFileLoader(scene::ISceneManager* smgr);
+
+	//! returns true if the file maybe is able to be loaded by this class
+	//! based on the file extension (e.g. ".cob")
+	virtual bool isALoadableFileExtension(const io::path& filename) const _IRR_OVERRIDE_;
+
+	//! creates/loads an animated mesh from the file.
+	//! \return Pointer to the created mesh. Returns 0 if loading failed.
+	//! If you no longer need the mesh, you should call IAnimatedMesh::drop().
+	//! See IReferenceCounted::drop() for more information.
+	virtual IAnimatedMesh* createMesh(io::IReadFile* file) _IRR_OVERRIDE_;
+
+private:
+
+	//! creates a static mesh, the buffers use mappedFile if it is given
+	IAnimatedMesh* createStaticMesh(io::IReadFile* file, io::CMappedReadFile* mappedFile,
+		const SIrrBinaryMeshHeader& header, const core::array<video::SMaterial>& materials,
+		const core::array<SIrrBinaryMeshBuffer>& buffers);
+
+	//! creates a skinned mesh, the data is always copied
+	IAnimatedMesh* createSkinnedMesh(io::IReadFile* file,
+		const SIrrBinaryMeshHeader& header, const core::array<video::SMaterial>& materials,
+		const core::array<SIrrBinaryMeshBuffer>& buffers);
+
+	//! reads an entry of the material table
+	bool readMaterial(io::IReadFile* file, video::SMaterial& material);
+
+	//! reads a joint of a skinned mesh
+	bool readJoint(io::IReadFile* file, ISkinnedMesh* mesh, ISkinnedMesh::SJoint* joint);
+
+	//! reads a string stored with its length in front
+	bool readString(io::IReadFile* file, core::stringc& str);
+
+	bool readU32(io::IReadFile* file, u32& value);
+
+	//! returns true if the vertices and indices of the buffer are inside of the file
+	bool isValidBuffer(const SIrrBinaryMeshBuffer& buffer, u32 materialCount, long fileSize) const;
+
+	//! returns true if count elements of the given size can be read from the file
+	bool isReadable(io::IReadFile* file, u32 count, u32 size) const;
+
+	// member variables
+
+	scene::ISceneManager* SceneManager;
+};
+
+
+} // end namespace scene
+} // end namespace irr
+
+#endif
+
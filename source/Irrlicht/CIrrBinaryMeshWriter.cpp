@@ -0,0 +1,336 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#include "IrrCompileConfig.h"
+
+#ifdef _IRR_COMPILE_WITH_IRR_BINARY_WRITER_
+
+#include "CIrrBinaryMeshWriter.h"
+#include "SIrrBinaryMeshStructs.h"
+#include "os.h"
+#include "IWriteFile.h"
+#include "IMesh.h"
+#include "IMeshBuffer.h"
+#include "ITexture.h"
+
+namespace irr
+{
+namespace scene
+{
+
+
+CIrrBinaryMeshWriter::CIrrBinaryMeshWriter(video::IVideoDriver* driver,
+				io::IFileSystem* fs)
+	: FileSystem(fs), VideoDriver(driver)
+{
+	#ifdef _DEBUG
+	setDebugName("CIrrBinaryMeshWriter");
+	#endif
+
+	if (VideoDriver)
+		VideoDriver->grab();
+
+	if (FileSystem)
+		FileSystem->grab();
+}
+
+
+CIrrBinaryMeshWriter::~CIrrBinaryMeshWriter()
+{
+	if (VideoDriver)
+		VideoDriver->drop();
+
+	if (FileSystem)
+		FileSystem->drop();
+}
+
+
+//! Returns the type of the mesh writer
+EMESH_WRITER_TYPE CIrrBinaryMeshWriter::getType() const
+{
+	return EMWT_IRR_BINARY_MESH;
+}
+
+
+//! writes a mesh
+bool CIrrBinaryMeshWriter::writeMesh(io::IWriteFile* file, scene::IMesh* mesh, s32 flags)
+{
+	if (!file || !mesh)
+		return false;
+#ifdef __BIG_ENDIAN__
+	os::Printer::log("Binary Irrlicht mesh export does not support big-endian systems.", ELL_ERROR);
+	return false;
+#endif
+
+	os::Printer::log("Writing mesh", file->getFileName());
+
+	MeshDirectory = FileSystem->getFileDir(file->getFileName());
+
+	const long start = file->getPos();
+	const u32 bufferCount = mesh->getMeshBufferCount();
+
+	ISkinnedMesh* skinnedMesh = 0;
+	if (mesh->getMeshType() == EAMT_SKINNED)
+		skinnedMesh = static_cast<ISkinnedMesh*>(mesh);
+
+	SIrrBinaryMeshHeader header;
+	memset(&header, 0, sizeof(header));
+	header.Magic = IRR_BINARY_MESH_MAGIC;
+	header.Version = IRR_BINARY_MESH_VERSION;
+	header.BufferCount = bufferCount;
+	const core::aabbox3df& box = mesh->getBoundingBox();
+	header.BoundingBox[0] = box.MinEdge.X;
+	header.BoundingBox[1] = box.MinEdge.Y;
+	header.BoundingBox[2] = box.MinEdge.Z;
+	header.BoundingBox[3] = box.MaxEdge.X;
+	header.BoundingBox[4] = box.MaxEdge.Y;
+	header.BoundingBox[5] = box.MaxEdge.Z;
+
+	// header is written again once all offsets are known
+	file->write(&header, sizeof(header));
+
+	// material table, equal materials are only stored once
+
+	core::array<video::SMaterial> materials;
+	core::array<SIrrBinaryMeshBuffer> buffers;
+	buffers.set_used(bufferCount);
+	u32 i;
+	for (i=0; i<bufferCount; ++i)
+	{
+		const IMeshBuffer* mb = mesh->getMeshBuffer(i);
+		s32 index = materials.linear_search(mb->getMaterial());
+		if (index == -1)
+		{
+			index = materials.size();
+			materials.push_back(mb->getMaterial());
+		}
+
+		SIrrBinaryMeshBuffer& entry = buffers[i];
+		memset(&entry, 0, sizeof(entry));
+		entry.MaterialIndex = index;
+		entry.VertexType = (u8)mb->getVertexType();
+		entry.IndexType = (u8)mb->getIndexType();
+		entry.PrimitiveType = (u8)mb->getPrimitiveType();
+		entry.HardwareMappingHints = (u8)(mb->getHardwareMappingHint_Vertex() | (mb->getHardwareMappingHint_Index() << 4));
+		entry.VertexCount = mb->getVertexCount();
+		entry.IndexCount = mb->getIndexCount();
+		const core::aabbox3df& bbox = mb->getBoundingBox();
+		entry.BoundingBox[0] = bbox.MinEdge.X;
+		entry.BoundingBox[1] = bbox.MinEdge.Y;
+		entry.BoundingBox[2] = bbox.MinEdge.Z;
+		entry.BoundingBox[3] = bbox.MaxEdge.X;
+		entry.BoundingBox[4] = bbox.MaxEdge.Y;
+		entry.BoundingBox[5] = bbox.MaxEdge.Z;
+		const video::SVertexQuantization quantization = mb->getVertexQuantization();
+		entry.QuantizationOffset[0] = quantization.Offset.X;
+		entry.QuantizationOffset[1] = quantization.Offset.Y;
+		entry.QuantizationOffset[2] = quantization.Offset.Z;
+		entry.QuantizationScale[0] = quantization.Scale.X;
+		entry.QuantizationScale[1] = quantization.Scale.Y;
+		entry.QuantizationScale[2] = quantization.Scale.Z;
+	}
+
+	header.MaterialCount = materials.size();
+	header.MaterialOffset = file->getPos() - start;
+	for (i=0; i<materials.size(); ++i)
+		writeMaterial(file, materials[i]);
+
+	// buffer table, written again once the blob offsets are known
+	header.BufferOffset = file->getPos() - start;
+	if (bufferCount)
+		file->write(buffers.const_pointer(), bufferCount*sizeof(SIrrBinaryMeshBuffer));
+
+	if (skinnedMesh)
+	{
+		const core::array<ISkinnedMesh::SJoint*>& allJoints = skinnedMesh->getAllJoints();
+		header.Flags |= EIBMF_SKINNED;
+		header.AnimationSpeed = skinnedMesh->getAnimationSpeed();
+		header.JointCount = allJoints.size();
+		header.JointOffset = file->getPos() - start;
+		for (i=0; i<allJoints.size(); ++i)
+			writeJoint(file, allJoints, allJoints[i]);
+	}
+
+	// vertex and index blobs
+
+	for (i=0; i<bufferCount; ++i)
+	{
+		const IMeshBuffer* mb = mesh->getMeshBuffer(i);
+		SIrrBinaryMeshBuffer& entry = buffers[i];
+
+		writePadding(file, start);
+		entry.VertexOffset = file->getPos() - start;
+		file->write(mb->getVertices(), entry.VertexCount * video::getVertexPitchFromType(mb->getVertexType()));
+
+		writePadding(file, start);
+		entry.IndexOffset = file->getPos() - start;
+		file->write(mb->getIndices(), entry.IndexCount * (mb->getIndexType() == video::EIT_32BIT ? sizeof(u32) : sizeof(u16)));
+	}
+
+	// write header and buffer table with the final offsets
+	const long end = file->getPos();
+	file->seek(start);
+	file->write(&header, sizeof(header));
+	file->seek(start + header.BufferOffset);
+	if (bufferCount)
+		file->write(buffers.const_pointer(), bufferCount*sizeof(SIrrBinaryMeshBuffer));
+	file->seek(end);
+
+	return true;
+}
+
+
+void CIrrBinaryMeshWriter::writeMaterial(io::IWriteFile* file, const video::SMaterial& material)
+{
+	const c8* typeName = VideoDriver->getMaterialRendererName(material.MaterialType);
+	writeString(file, typeName ? typeName : "");
+
+	writeU32(file, material.AmbientColor.color);
+	writeU32(file, material.DiffuseColor.color);
+	writeU32(file, material.EmissiveColor.color);
+	writeU32(file, material.SpecularColor.color);
+
+	const f32 values[] = { material.Shininess, material.MaterialTypeParam,
+		material.MaterialTypeParam2, material.Thickness, material.BlendFactor };
+	file->write(values, sizeof(values));
+
+	const u8 modes[] = { material.ZBuffer, material.AntiAliasing,
+		material.ColorMask, material.ColorMaterial, (u8)material.BlendOperation,
+		material.PolygonOffsetFactor, (u8)material.PolygonOffsetDirection,
+		(u8)material.ZWriteFineControl };
+	file->write(modes, sizeof(modes));
+
+	u16 flags = 0;
+	if (material.Wireframe)
+		flags |= EIBMTF_WIREFRAME;
+	if (material.PointCloud)
+		flags |= EIBMTF_POINTCLOUD;
+	if (material.GouraudShading)
+		flags |= EIBMTF_GOURAUD_SHADING;
+	if (material.Lighting)
+		flags |= EIBMTF_LIGHTING;
+	if (material.ZWriteEnable)
+		flags |= EIBMTF_ZWRITE_ENABLE;
+	if (material.BackfaceCulling)
+		flags |= EIBMTF_BACK_FACE_CULLING;
+	if (material.FrontfaceCulling)
+		flags |= EIBMTF_FRONT_FACE_CULLING;
+	if (material.FogEnable)
+		flags |= EIBMTF_FOG_ENABLE;
+	if (material.NormalizeNormals)
+		flags |= EIBMTF_NORMALIZE_NORMALS;
+	if (material.UseMipMaps)
+		flags |= EIBMTF_USE_MIP_MAPS;
+	file->write(&flags, sizeof(flags));
+
+	const u8 layerCount = (u8)video::MATERIAL_MAX_TEXTURES;
+	file->write(&layerCount, 1);
+	for (u32 i=0; i<video::MATERIAL_MAX_TEXTURES; ++i)
+	{
+		const video::SMaterialLayer& layer = material.TextureLayer[i];
+
+		io::path textureName;
+		if (layer.Texture)
+			textureName = FileSystem->getRelativeFilename(layer.Texture->getName().getPath(), MeshDirectory);
+		writeString(file, core::stringc(textureName));
+
+		const bool hasMatrix = !layer.getTextureMatrix().isIdentity();
+		u8 layerFlags = 0;
+		if (layer.BilinearFilter)
+			layerFlags |= EIBLF_BILINEAR_FILTER;
+		if (layer.TrilinearFilter)
+			layerFlags |= EIBLF_TRILINEAR_FILTER;
+		if (hasMatrix)
+			layerFlags |= EIBLF_TEXTURE_MATRIX;
+
+		const u8 layerValues[] = { layer.TextureWrapU, layer.TextureWrapV,
+			layer.TextureWrapW, layerFlags, layer.AnisotropicFilter, (u8)layer.LODBias };
+		file->write(layerValues, sizeof(layerValues));
+
+		if (hasMatrix)
+			file->write(layer.getTextureMatrix().pointer(), 16*sizeof(f32));
+	}
+}
+
+
+void CIrrBinaryMeshWriter::writeJoint(io::IWriteFile* file,
+		const core::array<ISkinnedMesh::SJoint*>& allJoints, const ISkinnedMesh::SJoint* joint)
+{
+	writeString(file, joint->Name);
+	file->write(joint->LocalMatrix.pointer(), 16*sizeof(f32));
+	file->write(joint->GlobalInversedMatrix.pointer(), 16*sizeof(f32));
+
+	u32 i;
+	writeU32(file, joint->Children.size());
+	for (i=0; i<joint->Children.size(); ++i)
+		writeU32(file, allJoints.linear_search(joint->Children[i]));
+
+	writeU32(file, joint->AttachedMeshes.size());
+	if (joint->AttachedMeshes.size())
+		file->write(joint->AttachedMeshes.const_pointer(), joint->AttachedMeshes.size()*sizeof(u32));
+
+	writeU32(file, joint->PositionKeys.size());
+	for (i=0; i<joint->PositionKeys.size(); ++i)
+	{
+		const ISkinnedMesh::SPositionKey& key = joint->PositionKeys[i];
+		const f32 values[] = { key.frame, key.position.X, key.position.Y, key.position.Z };
+		file->write(values, sizeof(values));
+	}
+
+	writeU32(file, joint->ScaleKeys.size());
+	for (i=0; i<joint->ScaleKeys.size(); ++i)
+	{
+		const ISkinnedMesh::SScaleKey& key = joint->ScaleKeys[i];
+		const f32 values[] = { key.frame, key.scale.X, key.scale.Y, key.scale.Z };
+		file->write(values, sizeof(values));
+	}
+
+	writeU32(file, joint->RotationKeys.size());
+	for (i=0; i<joint->RotationKeys.size(); ++i)
+	{
+		const ISkinnedMesh::SRotationKey& key = joint->RotationKeys[i];
+		const f32 values[] = { key.frame, key.rotation.X, key.rotation.Y, key.rotation.Z, key.rotation.W };
+		file->write(values, sizeof(values));
+	}
+
+	writeU32(file, joint->Weights.size());
+	for (i=0; i<joint->Weights.size(); ++i)
+	{
+		const ISkinnedMesh::SWeight& weight = joint->Weights[i];
+		const u16 buffer[2] = { weight.buffer_id, 0 };
+		file->write(buffer, sizeof(buffer));
+		writeU32(file, weight.vertex_id);
+		file->write(&weight.strength, sizeof(f32));
+	}
+}
+
+
+void CIrrBinaryMeshWriter::writeString(io::IWriteFile* file, const core::stringc& str)
+{
+	writeU32(file, str.size());
+	if (str.size())
+		file->write(str.c_str(), str.size());
+}
+
+
+void CIrrBinaryMeshWriter::writeU32(io::IWriteFile* file, u32 value)
+{
+	file->write(&value, sizeof(u32));
+}
+
+
+void CIrrBinaryMeshWriter::writePadding(io::IWriteFile* file, long start)
+{
+	static const u8 zeros[IRR_BINARY_MESH_ALIGNMENT] = { 0 };
+	const u32 rest = (u32)(file->getPos() - start) % IRR_BINARY_MESH_ALIGNMENT;
+	if (rest)
+		file->write(zeros, IRR_BINARY_MESH_ALIGNMENT - rest);
+}
+
+
+} // end namespace
+} // end namespace
+
+#endif
+
@@ -0,0 +1,58 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#ifndef __IRR_IRR_BINARY_MESH_WRITER_H_INCLUDED__
+#define __IRR_IRR_BINARY_MESH_WRITER_H_INCLUDED__
+
+#include "IMeshWriter.h"
+#include "ISkinnedMesh.h"
+#include "IVideoDriver.h"
+#include "IFileSystem.h"
+
+namespace irr
+{
+namespace scene
+{
+
+	//! class to write meshes, implementing a writer for binary Irrlicht meshes (.irrbmesh)
+	/** Static and skinned meshes are written. Vertices and indices are
+	stored in the engine's memory layout, see SIrrBinaryMeshStructs.h. */
+	class CIrrBinaryMeshWriter : public IMeshWriter
+	{
+	public:
+
+		CIrrBinaryMeshWriter(video::IVideoDriver* driver, io::IFileSystem* fs);
+		virtual ~CIrrBinaryMeshWriter();
+
+		//! Returns the type of the mesh writer
+		virtual EMESH_WRITER_TYPE getType() const _IRR_OVERRIDE_;
+
+		//! writes a mesh
+		virtual bool writeMesh(io::IWriteFile* file, scene::IMesh* mesh, s32 flags=EMWF_NONE) _IRR_OVERRIDE_;
+
+	protected:
+
+		void writeMaterial(io::IWriteFile* file, const video::SMaterial& material);
+
+		void writeJoint(io::IWriteFile* file, const core::array<ISkinnedMesh::SJoint*>& allJoints, const ISkinnedMesh::SJoint* joint);
+
+		void writeString(io::IWriteFile* file, const core::stringc& str);
+
+		void writeU32(io::IWriteFile* file, u32 value);
+
+		//! writes zeros up to the next position aligned relative to start
+		void writePadding(io::IWriteFile* file, long start);
+
+		// member variables:
+
+		io::IFileSystem* FileSystem;
+		video::IVideoDriver* VideoDriver;
+		io::path MeshDirectory;
+	};
+
+} // end namespace
+} // end namespace
+
+#endif
+
@@ -428,6 +428,8 @@ void CIrrMeshFileLoader::readMeshBuffer(io::IXMLReader* reader, int vertexCount,
 				Vertices.push_back(vtx);
 			}
 			break;
+			default:
+			break;
 			};
 
 		}
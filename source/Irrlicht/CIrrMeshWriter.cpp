@@ -161,21 +161,44 @@ void CIrrMeshWriter::writeMeshBuffer(const scene::IMeshBuffer* buffer)
 
 	// write vertices
 
-	const core::stringw vertexTypeStr = video::sBuiltInVertexTypeNames[buffer->getVertexType()];
+	u32 vertexCount = buffer->getVertexCount();
+	video::E_VERTEX_TYPE vertexType = buffer->getVertexType();
+	const void* vertices = buffer->getVertices();
+
+	// quantized vertices are written decoded
+	core::array<video::S3DVertex> decoded;
+	core::array<video::S3DVertexTangents> decodedTangents;
+	const video::SVertexQuantization quantization = buffer->getVertexQuantization();
+	if (vertexType == video::EVT_QUANTIZED)
+	{
+		decoded.set_used(vertexCount);
+		for (u32 j=0; j<vertexCount; ++j)
+			decoded[j] = ((const video::S3DVertexQuantized*)vertices)[j].get(quantization);
+		vertices = decoded.const_pointer();
+		vertexType = video::EVT_STANDARD;
+	}
+	else if (vertexType == video::EVT_QUANTIZED_TANGENTS)
+	{
+		decodedTangents.set_used(vertexCount);
+		for (u32 j=0; j<vertexCount; ++j)
+			decodedTangents[j] = ((const video::S3DVertexQuantizedTangents*)vertices)[j].get(quantization);
+		vertices = decodedTangents.const_pointer();
+		vertexType = video::EVT_TANGENTS;
+	}
+
+	const core::stringw vertexTypeStr = video::sBuiltInVertexTypeNames[vertexType];
 
 	Writer->writeElement(L"vertices", false,
 		L"type", vertexTypeStr.c_str(),
-		L"vertexCount", core::stringw(buffer->getVertexCount()).c_str());
+		L"vertexCount", core::stringw(vertexCount).c_str());
 
 	Writer->writeLineBreak();
 
-	u32 vertexCount = buffer->getVertexCount();
-
-	switch(buffer->getVertexType())
+	switch(vertexType)
 	{
 	case video::EVT_STANDARD:
 		{
-			video::S3DVertex* vtx = (video::S3DVertex*)buffer->getVertices();
+			const video::S3DVertex* vtx = (const video::S3DVertex*)vertices;
 			for (u32 j=0; j<vertexCount; ++j)
 			{
 				core::stringw str = getVectorAsStringLine(vtx[j].Pos);
@@ -195,7 +218,7 @@ void CIrrMeshWriter::writeMeshBuffer(const scene::IMeshBuffer* buffer)
 		break;
 	case video::EVT_2TCOORDS:
 		{
-			video::S3DVertex2TCoords* vtx = (video::S3DVertex2TCoords*)buffer->getVertices();
+			const video::S3DVertex2TCoords* vtx = (const video::S3DVertex2TCoords*)vertices;
 			for (u32 j=0; j<vertexCount; ++j)
 			{
 				core::stringw str = getVectorAsStringLine(vtx[j].Pos);
@@ -217,7 +240,7 @@ void CIrrMeshWriter::writeMeshBuffer(const scene::IMeshBuffer* buffer)
 		break;
 	case video::EVT_TANGENTS:
 		{
-			video::S3DVertexTangents* vtx = (video::S3DVertexTangents*)buffer->getVertices();
+			const video::S3DVertexTangents* vtx = (const video::S3DVertexTangents*)vertices;
 			for (u32 j=0; j<vertexCount; ++j)
 			{
 				core::stringw str = getVectorAsStringLine(vtx[j].Pos);
@@ -239,6 +262,10 @@ void CIrrMeshWriter::writeMeshBuffer(const scene::IMeshBuffer* buffer)
 			}
 		}
 		break;
+	case video::EVT_QUANTIZED:
+	case video::EVT_QUANTIZED_TANGENTS:
+		// already decoded to EVT_STANDARD or EVT_TANGENTS above
+		break;
 	}
 
 	Writer->writeClosingTag(L"vertices");
@@ -0,0 +1,285 @@
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#include "CLODSceneNode.h"
+#include "ISceneManager.h"
+#include "IVideoDriver.h"
+#include "ICameraSceneNode.h"
+#include "IMaterialRenderer.h"
+
+namespace irr
+{
+namespace scene
+{
+
+//! constructor
+CLODSceneNode::CLODSceneNode(ISceneNode* parent, ISceneManager* mgr, s32 id,
+		const core::vector3df& position, const core::vector3df& rotation,
+		const core::vector3df& scale)
+	: ILODSceneNode(parent, mgr, id, position, rotation, scale),
+	CurrentLevel(-1), ScreenSize(0.f)
+{
+#ifdef _DEBUG
+	setDebugName("CLODSceneNode");
+#endif
+}
+
+
+//! destructor
+CLODSceneNode::~CLODSceneNode()
+{
+	removeLevels();
+}
+
+
+void CLODSceneNode::OnRegisterSceneNode()
+{
+	if (IsVisible)
+	{
+		selectLevel();
+
+		IMesh* mesh = CurrentLevel >= 0 ? Levels[CurrentLevel].Mesh : 0;
+		if (mesh)
+		{
+			video::IVideoDriver* driver = SceneManager->getVideoDriver();
+
+			u32 transparentCount = 0;
+			u32 solidCount = 0;
+
+			// count transparent and solid materials of the mesh buffers of this level
+			for (u32 i=0; i<mesh->getMeshBufferCount(); ++i)
+			{
+				const video::SMaterial& material = i < Materials.size() ?
+					Materials[i] : mesh->getMeshBuffer(i)->getMaterial();
+				const video::IMaterialRenderer* const rnd =
+					driver->getMaterialRenderer(material.MaterialType);
+
+				if ((rnd && rnd->isTransparent()) || material.isTransparent())
+					++transparentCount;
+				else
+					++solidCount;
+
+				if (solidCount && transparentCount)
+					break;
+			}
+
+			if (solidCount)
+				SceneManager->registerNodeForRendering(this, scene::ESNRP_SOLID);
+
+			if (transparentCount)
+				SceneManager->registerNodeForRendering(this, scene::ESNRP_TRANSPARENT);
+		}
+
+		ISceneNode::OnRegisterSceneNode();
+	}
+}
+
+
+//! renders the node.
+void CLODSceneNode::render()
+{
+	video::IVideoDriver* driver = SceneManager->getVideoDriver();
+	IMesh* mesh = CurrentLevel >= 0 ? Levels[CurrentLevel].Mesh : 0;
+
+	if (!driver || !mesh)
+		return;
+
+	const bool isTransparentPass =
+		SceneManager->getSceneNodeRenderPass() == scene::ESNRP_TRANSPARENT;
+
+	driver->setTransform(video::ETS_WORLD, AbsoluteTransformation);
+
+	for (u32 i=0; i<mesh->getMeshBufferCount(); ++i)
+	{
+		IMeshBuffer* mb = mesh->getMeshBuffer(i);
+		if (!mb || !mb->getIndexCount())
+			continue;
+
+		const video::SMaterial& material = i < Materials.size() ? Materials[i] : mb->getMaterial();
+		const video::IMaterialRenderer* const rnd = driver->getMaterialRenderer(material.MaterialType);
+		const bool transparent = (rnd && rnd->isTransparent()) || material.isTransparent();
+
+		// only render transparent buffer if this is the transparent render pass
+		// and solid only in solid pass
+		if (transparent == isTransparentPass)
+		{
+			driver->setMaterial(material);
+			driver->drawMeshBuffer(mb);
+		}
+	}
+
+	// for debug purposes only:
+	if (DebugDataVisible && !isTransparentPass)
+	{
+		video::SMaterial m;
+		m.Lighting = false;
+		driver->setMaterial(m);
+
+		if (DebugDataVisible & scene::EDS_BBOX)
+			driver->draw3DBox(Box, video::SColor(255,255,255,255));
+		if (DebugDataVisible & scene::EDS_BBOX_BUFFERS)
+		{
+			for (u32 i=0; i<mesh->getMeshBufferCount(); ++i)
+				driver->draw3DBox(mesh->getMeshBuffer(i)->getBoundingBox(), video::SColor(255,190,128,128));
+		}
+	}
+}
+
+
+//! Chooses the level by the size of the bounding sphere on the screen
+void CLODSceneNode::selectLevel()
+{
+	const ICameraSceneNode* camera = SceneManager->getActiveCamera();
+	if (Levels.empty())
+	{
+		CurrentLevel = -1;
+		return;
+	}
+	if (!camera)
+	{
+		CurrentLevel = 0;
+		return;
+	}
+
+	const core::aabbox3df box = getTransformedBoundingBox();
+	const f32 radius = box.getExtent().getLength() * 0.5f;
+	const core::matrix4& projection = camera->getProjectionMatrix();
+
+	// the projection scales the view height to 2 at distance 1 for perspective
+	// projections, and at all distances for orthogonal ones
+	ScreenSize = radius * projection[5];
+	if (!core::iszero(projection[11]))
+	{
+		const f32 distance = core::max_(box.getCenter().getDistanceFrom(camera->getAbsolutePosition()),
+			camera->getNearValue(), core::ROUNDING_ERROR_f32);
+		ScreenSize /= distance;
+	}
+
+	CurrentLevel = Levels.size()-1;
+	for (u32 i=0; i+1<Levels.size(); ++i)
+	{
+		if (ScreenSize >= Levels[i].MinScreenSize)
+		{
+			CurrentLevel = i;
+			break;
+		}
+	}
+}
+
+
+//! returns the axis aligned bounding box of this node
+const core::aabbox3d<f32>& CLODSceneNode::getBoundingBox() const
+{
+	return Box;
+}
+
+
+//! returns the material based on the zero based index i.
+video::SMaterial& CLODSceneNode::getMaterial(u32 i)
+{
+	if (i >= Materials.size())
+		return ISceneNode::getMaterial(i);
+
+	return Materials[i];
+}
+
+
+//! returns amount of materials used by this scene node.
+u32 CLODSceneNode::getMaterialCount() const
+{
+	return Materials.size();
+}
+
+
+//! Adds a level of detail.
+void CLODSceneNode::addLevel(IMesh* mesh, f32 minScreenSize)
+{
+	SLevel level;
+	level.Mesh = mesh;
+	level.MinScreenSize = minScreenSize;
+
+	// levels with more detail first
+	u32 index = 0;
+	while (index < Levels.size() && Levels[index].MinScreenSize >= minScreenSize)
+		++index;
+	Levels.insert(level, index);
+
+	if (!mesh)
+		return;
+	mesh->grab();
+
+	// the materials of the first mesh are used for all levels
+	if (Materials.empty())
+	{
+		for (u32 i=0; i<mesh->getMeshBufferCount(); ++i)
+			Materials.push_back(mesh->getMeshBuffer(i)->getMaterial());
+	}
+
+	// the box has to contain all levels, so the node isn't culled depending on the level
+	bool first = true;
+	for (u32 i=0; i<Levels.size(); ++i)
+	{
+		if (!Levels[i].Mesh)
+			continue;
+		if (first)
+			Box = Levels[i].Mesh->getBoundingBox();
+		else
+			Box.addInternalBox(Levels[i].Mesh->getBoundingBox());
+		first = false;
+	}
+}
+
+
+//! Removes all levels
+void CLODSceneNode::removeLevels()
+{
+	for (u32 i=0; i<Levels.size(); ++i)
+	{
+		if (Levels[i].Mesh)
+			Levels[i].Mesh->drop();
+	}
+	Levels.clear();
+	Materials.clear();
+	Box.reset(0,0,0);
+	CurrentLevel = -1;
+}
+
+
+//! Returns the mesh of a level, level 0 has the most detail
+IMesh* CLODSceneNode::getLevelMesh(u32 level) const
+{
+	return level < Levels.size() ? Levels[level].Mesh : 0;
+}
+
+
+//! Returns the smallest screen size a level is used for
+f32 CLODSceneNode::getLevelScreenSize(u32 level) const
+{
+	return level < Levels.size() ? Levels[level].MinScreenSize : 0.f;
+}
+
+
+//! Creates a clone of this scene node and its children.
+ISceneNode* CLODSceneNode::clone(ISceneNode* newParent, ISceneManager* newManager)
+{
+	if (!newParent)
+		newParent = Parent;
+	if (!newManager)
+		newManager = SceneManager;
+
+	CLODSceneNode* nb = new CLODSceneNode(newParent, newManager, ID,
+		RelativeTranslation, RelativeRotation, RelativeScale);
+
+	nb->cloneMembers(this, newManager);
+	for (u32 i=0; i<Levels.size(); ++i)
+		nb->addLevel(Levels[i].Mesh, Levels[i].MinScreenSize);
+	nb->Materials = Materials;
+
+	if (newParent)
+		nb->drop();
+	return nb;
+}
+
+} // end namespace scene
+} // end namespace irr
+
@@ -0,0 +1,92 @@
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#ifndef __C_LOD_SCENE_NODE_H_INCLUDED__
+#define __C_LOD_SCENE_NODE_H_INCLUDED__
+
+#include "ILODSceneNode.h"
+#include "IMesh.h"
+
+namespace irr
+{
+namespace scene
+{
+
+	//! Scene node which draws one of several meshes depending on its size on the screen
+	class CLODSceneNode : public ILODSceneNode
+	{
+	public:
+
+		//! constructor
+		CLODSceneNode(ISceneNode* parent, ISceneManager* mgr, s32 id,
+			const core::vector3df& position = core::vector3df(0,0,0),
+			const core::vector3df& rotation = core::vector3df(0,0,0),
+			const core::vector3df& scale = core::vector3df(1,1,1));
+
+		//! destructor
+		virtual ~CLODSceneNode();
+
+		virtual void OnRegisterSceneNode() _IRR_OVERRIDE_;
+
+		//! renders the node.
+		virtual void render() _IRR_OVERRIDE_;
+
+		//! returns the axis aligned bounding box of this node
+		virtual const core::aabbox3d<f32>& getBoundingBox() const _IRR_OVERRIDE_;
+
+		//! returns the material based on the zero based index i.
+		virtual video::SMaterial& getMaterial(u32 i) _IRR_OVERRIDE_;
+
+		//! returns amount of materials used by this scene node.
+		virtual u32 getMaterialCount() const _IRR_OVERRIDE_;
+
+		//! Returns type of the scene node
+		virtual ESCENE_NODE_TYPE getType() const _IRR_OVERRIDE_ { return ESNT_LOD; }
+
+		//! Adds a level of detail.
+		virtual void addLevel(IMesh* mesh, f32 minScreenSize) _IRR_OVERRIDE_;
+
+		//! Removes all levels
+		virtual void removeLevels() _IRR_OVERRIDE_;
+
+		//! Returns the number of levels
+		virtual u32 getLevelCount() const _IRR_OVERRIDE_ { return Levels.size(); }
+
+		//! Returns the mesh of a level, level 0 has the most detail
+		virtual IMesh* getLevelMesh(u32 level) const _IRR_OVERRIDE_;
+
+		//! Returns the smallest screen size a level is used for
+		virtual f32 getLevelScreenSize(u32 level) const _IRR_OVERRIDE_;
+
+		//! Returns the level chosen the last time the node was drawn
+		virtual s32 getCurrentLevel() const _IRR_OVERRIDE_ { return CurrentLevel; }
+
+		//! Returns the screen size of the node when it was drawn the last time
+		virtual f32 getScreenSize() const _IRR_OVERRIDE_ { return ScreenSize; }
+
+		//! Creates a clone of this scene node and its children.
+		virtual ISceneNode* clone(ISceneNode* newParent=0, ISceneManager* newManager=0) _IRR_OVERRIDE_;
+
+	private:
+
+		struct SLevel
+		{
+			IMesh* Mesh;
+			f32 MinScreenSize;
+		};
+
+		//! Chooses the level by the size of the bounding sphere on the screen
+		void selectLevel();
+
+		core::array<SLevel> Levels;
+		core::array<video::SMaterial> Materials;
+		core::aabbox3df Box;
+		s32 CurrentLevel;
+		f32 ScreenSize;
+	};
+
+} // end namespace scene
+} // end namespace irr
+
+#endif
+
@@ -0,0 +1,308 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#ifndef __C_MAPPED_MESH_BUFFER_H_INCLUDED__
+#define __C_MAPPED_MESH_BUFFER_H_INCLUDED__
+
+#include "CMeshBuffer.h"
+
+namespace irr
+{
+namespace scene
+{
+	//! Mesh buffer using vertices and indices stored in memory owned by another object
+	/** Used for meshes loaded from memory mapped files. The owner, usually the
+	mapped file, is kept alive as long as the buffer exists. The data can be
+	changed, but not resized, so the append methods do nothing. */
+	class CMappedMeshBuffer : public IMeshBuffer
+	{
+	public:
+		//! constructor
+		CMappedMeshBuffer(IReferenceCounted* owner,
+				void* vertices, u32 vertexCount, video::E_VERTEX_TYPE vertexType,
+				void* indices, u32 indexCount, video::E_INDEX_TYPE indexType)
+			: Owner(owner), Vertices((u8*)vertices), VertexCount(vertexCount),
+			Indices(indices), IndexCount(indexCount),
+			ChangedID_Vertex(1), ChangedID_Index(1),
+			VertexType(vertexType), IndexType(indexType),
+			Pitch(video::getVertexPitchFromType(vertexType)),
+			MappingHintVertex(EHM_NEVER), MappingHintIndex(EHM_NEVER),
+			PrimitiveType(EPT_TRIANGLES)
+		{
+			#ifdef _DEBUG
+			setDebugName("CMappedMeshBuffer");
+			#endif
+			if (Owner)
+				Owner->grab();
+		}
+
+		//! destructor
+		virtual ~CMappedMeshBuffer()
+		{
+			if (Owner)
+				Owner->drop();
+		}
+
+		//! returns the material of this meshbuffer
+		virtual const video::SMaterial& getMaterial() const _IRR_OVERRIDE_
+		{
+			return Material;
+		}
+
+		//! returns the material of this meshbuffer
+		virtual video::SMaterial& getMaterial() _IRR_OVERRIDE_
+		{
+			return Material;
+		}
+
+		//! returns which type of vertex data is stored.
+		virtual video::E_VERTEX_TYPE getVertexType() const _IRR_OVERRIDE_
+		{
+			return VertexType;
+		}
+
+		//! returns the quantization of the vertex positions
+		virtual video::SVertexQuantization getVertexQuantization() const _IRR_OVERRIDE_
+		{
+			return Quantization;
+		}
+
+		//! returns pointer to vertices
+		virtual const void* getVertices() const _IRR_OVERRIDE_
+		{
+			return Vertices;
+		}
+
+		//! returns pointer to vertices
+		virtual void* getVertices() _IRR_OVERRIDE_
+		{
+			return Vertices;
+		}
+
+		//! returns amount of vertices
+		virtual u32 getVertexCount() const _IRR_OVERRIDE_
+		{
+			return VertexCount;
+		}
+
+		//! returns the type of the indices
+		virtual video::E_INDEX_TYPE getIndexType() const _IRR_OVERRIDE_
+		{
+			return IndexType;
+		}
+
+		//! returns pointer to indices
+		virtual const u16* getIndices() const _IRR_OVERRIDE_
+		{
+			return (const u16*)Indices;
+		}
+
+		//! returns pointer to indices
+		virtual u16* getIndices() _IRR_OVERRIDE_
+		{
+			return (u16*)Indices;
+		}
+
+		//! returns amount of indices
+		virtual u32 getIndexCount() const _IRR_OVERRIDE_
+		{
+			return IndexCount;
+		}
+
+		//! returns an axis aligned bounding box
+		virtual const core::aabbox3d<f32>& getBoundingBox() const _IRR_OVERRIDE_
+		{
+			return BoundingBox;
+		}
+
+		//! set user axis aligned bounding box
+		virtual void setBoundingBox( const core::aabbox3df& box) _IRR_OVERRIDE_
+		{
+			BoundingBox = box;
+		}
+
+		//! recalculates the bounding box
+		virtual void recalculateBoundingBox() _IRR_OVERRIDE_
+		{
+			if (VertexCount)
+			{
+				BoundingBox.reset(decodePosition(0));
+				for (u32 i=1; i<VertexCount; ++i)
+					BoundingBox.addInternalPoint(decodePosition(i));
+			}
+			else
+				BoundingBox.reset(0,0,0);
+		}
+
+		//! returns position of vertex i
+		virtual const core::vector3df& getPosition(u32 i) const _IRR_OVERRIDE_
+		{
+			if (isQuantizedVertexType())
+				return DecodedValues.next().Pos = decodePosition(i);
+			return vertex(i)->Pos;
+		}
+
+		//! returns position of vertex i
+		virtual core::vector3df& getPosition(u32 i) _IRR_OVERRIDE_
+		{
+			if (isQuantizedVertexType())
+			{
+				_IRR_DEBUG_BREAK_IF(true)
+				return DecodedValues.next().Pos = decodePosition(i);
+			}
+			return vertex(i)->Pos;
+		}
+
+		//! returns normal of vertex i
+		virtual const core::vector3df& getNormal(u32 i) const _IRR_OVERRIDE_
+		{
+			if (isQuantizedVertexType())
+				return DecodedValues.next().Normal = quantizedVertex(i)->getNormal();
+			return vertex(i)->Normal;
+		}
+
+		//! returns normal of vertex i
+		virtual core::vector3df& getNormal(u32 i) _IRR_OVERRIDE_
+		{
+			if (isQuantizedVertexType())
+			{
+				_IRR_DEBUG_BREAK_IF(true)
+				return DecodedValues.next().Normal = quantizedVertex(i)->getNormal();
+			}
+			return vertex(i)->Normal;
+		}
+
+		//! returns texture coord of vertex i
+		virtual const core::vector2df& getTCoords(u32 i) const _IRR_OVERRIDE_
+		{
+			if (isQuantizedVertexType())
+				return DecodedValues.next().TCoords = quantizedVertex(i)->getTCoords();
+			return vertex(i)->TCoords;
+		}
+
+		//! returns texture coord of vertex i
+		virtual core::vector2df& getTCoords(u32 i) _IRR_OVERRIDE_
+		{
+			if (isQuantizedVertexType())
+			{
+				_IRR_DEBUG_BREAK_IF(true)
+				return DecodedValues.next().TCoords = quantizedVertex(i)->getTCoords();
+			}
+			return vertex(i)->TCoords;
+		}
+
+		//! append the vertices and indices to the current buffer
+		/** Not supported, the size of the data is fixed. */
+		virtual void append(const void* const vertices, u32 numVertices, const u16* const indices, u32 numIndices) _IRR_OVERRIDE_ {}
+
+		//! append the meshbuffer to the current buffer
+		/** Not supported, the size of the data is fixed. */
+		virtual void append(const IMeshBuffer* const other) _IRR_OVERRIDE_ {}
+
+		//! get the current hardware mapping hint
+		virtual E_HARDWARE_MAPPING getHardwareMappingHint_Vertex() const _IRR_OVERRIDE_
+		{
+			return MappingHintVertex;
+		}
+
+		//! get the current hardware mapping hint
+		virtual E_HARDWARE_MAPPING getHardwareMappingHint_Index() const _IRR_OVERRIDE_
+		{
+			return MappingHintIndex;
+		}
+
+		//! set the hardware mapping hint, for driver
+		virtual void setHardwareMappingHint( E_HARDWARE_MAPPING NewMappingHint, E_BUFFER_TYPE buffer=EBT_VERTEX_AND_INDEX ) _IRR_OVERRIDE_
+		{
+			if (buffer==EBT_VERTEX_AND_INDEX || buffer==EBT_VERTEX)
+				MappingHintVertex=NewMappingHint;
+			if (buffer==EBT_VERTEX_AND_INDEX || buffer==EBT_INDEX)
+				MappingHintIndex=NewMappingHint;
+		}
+
+		//! Describe what kind of primitive geometry is used by the meshbuffer
+		virtual void setPrimitiveType(E_PRIMITIVE_TYPE type) _IRR_OVERRIDE_
+		{
+			PrimitiveType = type;
+		}
+
+		//! Get the kind of primitive geometry which is used by the meshbuffer
+		virtual E_PRIMITIVE_TYPE getPrimitiveType() const _IRR_OVERRIDE_
+		{
+			return PrimitiveType;
+		}
+
+		//! flags the mesh as changed, reloads hardware buffers
+		virtual void setDirty(E_BUFFER_TYPE buffer=EBT_VERTEX_AND_INDEX) _IRR_OVERRIDE_
+		{
+			if (buffer==EBT_VERTEX_AND_INDEX || buffer==EBT_VERTEX)
+				++ChangedID_Vertex;
+			if (buffer==EBT_VERTEX_AND_INDEX || buffer==EBT_INDEX)
+				++ChangedID_Index;
+		}
+
+		//! Get the currently used ID for identification of changes.
+		/** This shouldn't be used for anything outside the VideoDriver. */
+		virtual u32 getChangedID_Vertex() const _IRR_OVERRIDE_ {return ChangedID_Vertex;}
+
+		//! Get the currently used ID for identification of changes.
+		/** This shouldn't be used for anything outside the VideoDriver. */
+		virtual u32 getChangedID_Index() const _IRR_OVERRIDE_ {return ChangedID_Index;}
+
+		//! Material of this meshBuffer
+		video::SMaterial Material;
+
+		//! Quantization of the positions, only used by quantized vertex types
+		video::SVertexQuantization Quantization;
+
+		//! Bounding box
+		core::aabbox3df BoundingBox;
+
+	private:
+
+		bool isQuantizedVertexType() const
+		{
+			return video::isQuantizedVertexType(VertexType);
+		}
+
+		video::S3DVertex* vertex(u32 i) const
+		{
+			return reinterpret_cast<video::S3DVertex*>(Vertices + i*Pitch);
+		}
+
+		const video::S3DVertexQuantized* quantizedVertex(u32 i) const
+		{
+			return reinterpret_cast<const video::S3DVertexQuantized*>(Vertices + i*Pitch);
+		}
+
+		core::vector3df decodePosition(u32 i) const
+		{
+			if (isQuantizedVertexType())
+				return quantizedVertex(i)->getPosition(Quantization);
+			return vertex(i)->Pos;
+		}
+
+		IReferenceCounted* Owner;
+		u8* Vertices;
+		u32 VertexCount;
+		void* Indices;
+		u32 IndexCount;
+		u32 ChangedID_Vertex;
+		u32 ChangedID_Index;
+		video::E_VERTEX_TYPE VertexType;
+		video::E_INDEX_TYPE IndexType;
+		u32 Pitch;
+		E_HARDWARE_MAPPING MappingHintVertex;
+		E_HARDWARE_MAPPING MappingHintIndex;
+		E_PRIMITIVE_TYPE PrimitiveType;
+		//! Slots for the vertex accessors of quantized vertices
+		mutable SDecodedQuantizedValues DecodedValues;
+	};
+
+
+} // end namespace scene
+} // end namespace irr
+
+#endif
+
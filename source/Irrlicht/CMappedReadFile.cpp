@@ -0,0 +1,172 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#include "CMappedReadFile.h"
+
+#if defined(_IRR_WINDOWS_API_)
+	#if !defined(WIN32_LEAN_AND_MEAN)
+		#define WIN32_LEAN_AND_MEAN
+	#endif
+	#include <windows.h>
+#elif defined(_IRR_POSIX_API_) || defined(_IRR_OSX_PLATFORM_)
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <fcntl.h>
+	#include <unistd.h>
+#endif
+
+namespace irr
+{
+namespace io
+{
+
+
+CMappedReadFile::CMappedReadFile(const io::path& fileName)
+: Data(0), FileSize(0), Pos(0), Filename(fileName)
+{
+	#ifdef _DEBUG
+	setDebugName("CMappedReadFile");
+	#endif
+
+	mapFile();
+}
+
+
+CMappedReadFile::~CMappedReadFile()
+{
+	if (!Data)
+		return;
+
+#if defined(_IRR_WINDOWS_API_)
+	UnmapViewOfFile(Data);
+#elif defined(_IRR_POSIX_API_) || defined(_IRR_OSX_PLATFORM_)
+	munmap(Data, FileSize);
+#endif
+}
+
+
+//! returns how much was read
+size_t CMappedReadFile::read(void* buffer, size_t sizeToRead)
+{
+	long amount = static_cast<long>(sizeToRead);
+	if (Pos + amount > FileSize)
+		amount -= Pos + amount - FileSize;
+
+	if (amount <= 0)
+		return 0;
+
+	memcpy(buffer, Data + Pos, amount);
+
+	Pos += amount;
+
+	return static_cast<size_t>(amount);
+}
+
+
+//! changes position in file, returns true if successful
+//! if relativeMovement==true, the pos is changed relative to current pos,
+//! otherwise from begin of file
+bool CMappedReadFile::seek(long finalPos, bool relativeMovement)
+{
+	if (relativeMovement)
+		finalPos += Pos;
+
+	if (finalPos < 0 || finalPos > FileSize)
+		return false;
+
+	Pos = finalPos;
+	return true;
+}
+
+
+//! returns size of file
+long CMappedReadFile::getSize() const
+{
+	return FileSize;
+}
+
+
+//! returns where in the file we are.
+long CMappedReadFile::getPos() const
+{
+	return Pos;
+}
+
+
+//! returns name of file
+const io::path& CMappedReadFile::getFileName() const
+{
+	return Filename;
+}
+
+
+//! maps the file
+void CMappedReadFile::mapFile()
+{
+	if (Filename.size() == 0)
+		return;
+
+#if defined(_IRR_WINDOWS_API_)
+#if defined(_IRR_WCHAR_FILESYSTEM)
+	HANDLE file = CreateFileW(Filename.c_str(), GENERIC_READ, FILE_SHARE_READ,
+		0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+#else
+	HANDLE file = CreateFileA(Filename.c_str(), GENERIC_READ, FILE_SHARE_READ,
+		0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+#endif
+	if (file == INVALID_HANDLE_VALUE)
+		return;
+
+	LARGE_INTEGER size;
+	if (GetFileSizeEx(file, &size) && size.QuadPart > 0 && size.HighPart == 0 &&
+		size.LowPart <= 0x7fffffff)
+	{
+		// copy-on-write view, changes stay in memory
+		HANDLE mapping = CreateFileMapping(file, 0, PAGE_WRITECOPY, 0, 0, 0);
+		if (mapping)
+		{
+			Data = (u8*)MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+			if (Data)
+				FileSize = (long)size.LowPart;
+			// the view keeps the mapping alive
+			CloseHandle(mapping);
+		}
+	}
+	CloseHandle(file);
+#elif defined(_IRR_POSIX_API_) || defined(_IRR_OSX_PLATFORM_)
+	const int file = open(Filename.c_str(), O_RDONLY);
+	if (file == -1)
+		return;
+
+	struct stat info;
+	if (fstat(file, &info) == 0 && info.st_size > 0 &&
+		(long)info.st_size == info.st_size)
+	{
+		// private mapping, changes are copy-on-write and never written back
+		void* data = mmap(0, info.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, file, 0);
+		if (data != MAP_FAILED)
+		{
+			Data = (u8*)data;
+			FileSize = (long)info.st_size;
+		}
+	}
+	close(file);
+#endif
+}
+
+
+CMappedReadFile* CMappedReadFile::createMappedReadFile(const io::path& fileName)
+{
+	CMappedReadFile* file = new CMappedReadFile(fileName);
+	if (file->isOpen())
+		return file;
+
+	file->drop();
+	return 0;
+}
+
+
+} // end namespace io
+} // end namespace irr
+
@@ -0,0 +1,83 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#ifndef __C_MAPPED_READ_FILE_H_INCLUDED__
+#define __C_MAPPED_READ_FILE_H_INCLUDED__
+
+#include "IReadFile.h"
+#include "irrString.h"
+
+namespace irr
+{
+
+namespace io
+{
+
+	/*!
+		Class for reading a file from disk which is mapped into memory.
+		The mapping is private and copy-on-write, so the data may be changed
+		through getMappedData() without touching the file on disk.
+	*/
+	class CMappedReadFile : public IReadFile
+	{
+	public:
+
+		CMappedReadFile(const io::path& fileName);
+
+		virtual ~CMappedReadFile();
+
+		//! returns how much was read
+		virtual size_t read(void* buffer, size_t sizeToRead) _IRR_OVERRIDE_;
+
+		//! changes position in file, returns true if successful
+		virtual bool seek(long finalPos, bool relativeMovement = false) _IRR_OVERRIDE_;
+
+		//! returns size of file
+		virtual long getSize() const _IRR_OVERRIDE_;
+
+		//! returns if file is mapped
+		bool isOpen() const
+		{
+			return Data != 0;
+		}
+
+		//! returns where in the file we are.
+		virtual long getPos() const _IRR_OVERRIDE_;
+
+		//! returns name of file
+		virtual const io::path& getFileName() const _IRR_OVERRIDE_;
+
+		//! Get the type of the class implementing this interface
+		virtual EREAD_FILE_TYPE getType() const _IRR_OVERRIDE_
+		{
+			return ERFT_MAPPED_READ_FILE;
+		}
+
+		//! returns the start of the mapped file contents
+		u8* getMappedData() const
+		{
+			return Data;
+		}
+
+		//! map a file on disk into memory.
+		/** \return 0 if the file can't be opened or the platform does not
+		support memory mapped files. */
+		static CMappedReadFile* createMappedReadFile(const io::path& fileName);
+
+	private:
+
+		//! maps the file
+		void mapFile();
+
+		u8* Data;
+		long FileSize;
+		long Pos;
+		io::path Filename;
+	};
+
+} // end namespace io
+} // end namespace irr
+
+#endif
+
@@ -0,0 +1,58 @@
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#ifndef __C_MESH_BUFFER_HELPER_H_INCLUDED__
+#define __C_MESH_BUFFER_HELPER_H_INCLUDED__
+
+#include "CMeshBuffer.h"
+#include "CDynamicMeshBuffer.h"
+
+namespace irr
+{
+namespace scene
+{
+
+//! Sets 32 bit indices for the vertices of a mesh buffer.
+/** Loaders and mesh manipulations collect indices as u32, so large meshes
+don't have to be split. As long as all vertices can be reached with 16 bit
+indices they are stored in the buffer itself, else the vertices are copied
+into a CDynamicMeshBuffer with 32 bit indices.
+\param buffer Buffer with vertices and material, its indices are replaced.
+\param indices Indices into the vertices of buffer.
+\return buffer or the new CDynamicMeshBuffer. Drop it when done, buffer is
+grabbed when it is returned. */
+template <class T>
+IMeshBuffer* createIndexedMeshBuffer(CMeshBuffer<T>* buffer, const core::array<u32>& indices)
+{
+	u32 i;
+	if (buffer->Vertices.size() <= 65536)
+	{
+		buffer->Indices.set_used(indices.size());
+		for (i=0; i<indices.size(); ++i)
+			buffer->Indices[i] = (u16)indices[i];
+		buffer->setDirty(EBT_INDEX);
+		buffer->grab();
+		return buffer;
+	}
+
+	CDynamicMeshBuffer* large = new CDynamicMeshBuffer(buffer->getVertexType(), video::EIT_32BIT);
+	large->getMaterial() = buffer->Material;
+	large->setBoundingBox(buffer->BoundingBox);
+	large->setPrimitiveType(buffer->getPrimitiveType());
+	large->setHardwareMappingHint(buffer->getHardwareMappingHint_Vertex(), EBT_VERTEX);
+	large->setHardwareMappingHint(buffer->getHardwareMappingHint_Index(), EBT_INDEX);
+
+	large->getVertexBuffer().reallocate(buffer->Vertices.size());
+	for (i=0; i<buffer->Vertices.size(); ++i)
+		large->getVertexBuffer().push_back((const video::S3DVertex&)buffer->Vertices[i]);
+	large->getIndexBuffer().reallocate(indices.size());
+	for (i=0; i<indices.size(); ++i)
+		large->getIndexBuffer().push_back(indices[i]);
+	return large;
+}
+
+} // end namespace scene
+} // end namespace irr
+
+#endif
+
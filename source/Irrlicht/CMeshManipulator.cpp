@@ -5,10 +5,15 @@
 #include "CMeshManipulator.h"
 #include "SMesh.h"
 #include "CMeshBuffer.h"
+#include "CDynamicMeshBuffer.h"
+#include "CMeshSimplifier.h"
+#include "CMeshOptimizer.h"
 #include "SAnimatedMesh.h"
 #include "os.h"
-#include "irrMap.h"
+#include "irrHashMap.h"
 #include "triangle3d.h"
+#include "CThreadPool.h"
+#include "CMeshBufferHelper.h"
 
 namespace irr
 {
@@ -75,6 +80,51 @@ void CMeshManipulator::flipSurfaces(scene::IMesh* mesh) const
 
 namespace
 {
+// Returns the positions of all vertices with their pitch, quantized positions are decoded
+const u8* getVertexPositions(const IMeshBuffer* buffer, core::array<core::vector3df>& decoded, u32& pitch)
+{
+	if (!video::isQuantizedVertexType(buffer->getVertexType()))
+	{
+		pitch = video::getVertexPitchFromType(buffer->getVertexType());
+		return (const u8*)buffer->getVertices();
+	}
+
+	const u32 vertexCount = buffer->getVertexCount();
+	decoded.set_used(vertexCount);
+	for (u32 i=0; i<vertexCount; ++i)
+		decoded[i] = buffer->getPosition(i);
+	pitch = sizeof(core::vector3df);
+	return (const u8*)decoded.const_pointer();
+}
+
+inline const core::vector3df& getVertexPosition(const u8* positions, u32 pitch, u32 i)
+{
+	return *(const core::vector3df*)(positions + i*pitch);
+}
+
+// Writes normals directly into the vertex array, quantized normals are encoded
+struct SNormalWriter
+{
+	SNormalWriter(IMeshBuffer* buffer)
+		: Vertices((u8*)buffer->getVertices()),
+		Pitch(video::getVertexPitchFromType(buffer->getVertexType())),
+		Quantized(video::isQuantizedVertexType(buffer->getVertexType()))
+	{
+	}
+
+	void set(u32 i, const core::vector3df& normal) const
+	{
+		if (Quantized)
+			((video::S3DVertexQuantized*)(Vertices + i*Pitch))->setNormal(normal);
+		else
+			((video::S3DVertex*)(Vertices + i*Pitch))->Normal = normal;
+	}
+
+	u8* Vertices;
+	u32 Pitch;
+	bool Quantized;
+};
+
 template <typename T>
 void recalculateNormalsT(IMeshBuffer* buffer, bool smooth, bool angleWeighted)
 {
@@ -82,44 +132,52 @@ void recalculateNormalsT(IMeshBuffer* buffer, bool smooth, bool angleWeighted)
 	const u32 idxcnt = buffer->getIndexCount();
 	const T* idx = reinterpret_cast<T*>(buffer->getIndices());
 
+	// work on the vertex array instead of the virtual accessors
+	core::array<core::vector3df> decoded;
+	u32 pitch;
+	const u8* positions = getVertexPositions(buffer, decoded, pitch);
+	const SNormalWriter normals(buffer);
+
 	if (!smooth)
 	{
 		for (u32 i=0; i<idxcnt; i+=3)
 		{
-			const core::vector3df& v1 = buffer->getPosition(idx[i+0]);
-			const core::vector3df& v2 = buffer->getPosition(idx[i+1]);
-			const core::vector3df& v3 = buffer->getPosition(idx[i+2]);
+			const core::vector3df& v1 = getVertexPosition(positions, pitch, idx[i+0]);
+			const core::vector3df& v2 = getVertexPosition(positions, pitch, idx[i+1]);
+			const core::vector3df& v3 = getVertexPosition(positions, pitch, idx[i+2]);
 			const core::vector3df normal = core::plane3d<f32>(v1, v2, v3).Normal;
-			buffer->getNormal(idx[i+0]) = normal;
-			buffer->getNormal(idx[i+1]) = normal;
-			buffer->getNormal(idx[i+2]) = normal;
+			normals.set(idx[i+0], normal);
+			normals.set(idx[i+1], normal);
+			normals.set(idx[i+2], normal);
 		}
 	}
 	else
 	{
 		u32 i;
+		core::array<core::vector3df> sums;
+		sums.set_used(vtxcnt);
 
 		for ( i = 0; i!= vtxcnt; ++i )
-			buffer->getNormal(i).set(0.f, 0.f, 0.f);
+			sums[i].set(0.f, 0.f, 0.f);
 
 		for ( i=0; i<idxcnt; i+=3)
 		{
-			const core::vector3df& v1 = buffer->getPosition(idx[i+0]);
-			const core::vector3df& v2 = buffer->getPosition(idx[i+1]);
-			const core::vector3df& v3 = buffer->getPosition(idx[i+2]);
+			const core::vector3df& v1 = getVertexPosition(positions, pitch, idx[i+0]);
+			const core::vector3df& v2 = getVertexPosition(positions, pitch, idx[i+1]);
+			const core::vector3df& v3 = getVertexPosition(positions, pitch, idx[i+2]);
 			const core::vector3df normal = core::plane3d<f32>(v1, v2, v3).Normal;
 
 			core::vector3df weight(1.f,1.f,1.f);
 			if (angleWeighted)
 				weight = irr::scene::getAngleWeight(v1,v2,v3); // writing irr::scene:: necessary for borland
 
-			buffer->getNormal(idx[i+0]) += weight.X*normal;
-			buffer->getNormal(idx[i+1]) += weight.Y*normal;
-			buffer->getNormal(idx[i+2]) += weight.Z*normal;
+			sums[idx[i+0]] += weight.X*normal;
+			sums[idx[i+1]] += weight.Y*normal;
+			sums[idx[i+2]] += weight.Z*normal;
 		}
 
 		for ( i = 0; i!= vtxcnt; ++i )
-			buffer->getNormal(i).normalize();
+			normals.set(i, sums[i].normalize());
 	}
 }
 }
@@ -136,6 +194,10 @@ void CMeshManipulator::recalculateNormals(IMeshBuffer* buffer, bool smooth, bool
 		recalculateNormalsT<u16>(buffer, smooth, angleWeighted);
 	else
 		recalculateNormalsT<u32>(buffer, smooth, angleWeighted);
+
+	// the decoded copies of quantized vertices have to be updated
+	if (video::isQuantizedVertexType(buffer->getVertexType()))
+		buffer->setDirty(EBT_VERTEX);
 }
 
 
@@ -293,7 +355,7 @@ void recalculateTangentsT(IMeshBuffer* buffer, bool recalculateNormals, bool smo
 			//Angle-weighted normals look better, but are slightly more CPU intensive to calculate
 			core::vector3df weight(1.f,1.f,1.f);
 			if (angleWeighted)
-				weight = irr::scene::getAngleWeight(v[i+0].Pos,v[i+1].Pos,v[i+2].Pos);	// writing irr::scene:: necessary for borland
+				weight = irr::scene::getAngleWeight(v[idx[i+0]].Pos,v[idx[i+1]].Pos,v[idx[i+2]].Pos);	// writing irr::scene:: necessary for borland
 			core::vector3df localNormal;
 			core::vector3df localTangent;
 			core::vector3df localBinormal;
@@ -577,8 +639,115 @@ void CMeshManipulator::makePlanarTextureMapping(scene::IMesh* mesh, f32 resoluti
 }
 
 
+namespace
+{
+// Copies the indices of a mesh buffer into a 32 bit array
+void getIndices(const IMeshBuffer* mb, core::array<u32>& indices)
+{
+	const u32 indexCount = mb->getIndexCount();
+	indices.set_used(indexCount);
+	u32 i;
+	if (mb->getIndexType() == video::EIT_32BIT)
+	{
+		const u32* source = (const u32*)mb->getIndices();
+		for (i=0; i<indexCount; ++i)
+			indices[i] = source[i];
+	}
+	else
+	{
+		const u16* source = mb->getIndices();
+		for (i=0; i<indexCount; ++i)
+			indices[i] = source[i];
+	}
+}
+
+// Creates a mesh buffer with the material and bounding box of mb, with 32 bit indices when needed
+template <class T>
+IMeshBuffer* createMeshBuffer(const IMeshBuffer* mb, const core::array<T>& vertices, const core::array<u32>& indices)
+{
+	CMeshBuffer<T>* buffer = new CMeshBuffer<T>();
+	buffer->BoundingBox = mb->getBoundingBox();
+	buffer->Material = mb->getMaterial();
+	buffer->Vertices = vertices;
+	IMeshBuffer* result = createIndexedMeshBuffer(buffer, indices);
+	buffer->drop();
+	return result;
+}
+
+// Copies a mesh buffer, optionally with separate vertices for each index
+template <class T>
+IMeshBuffer* copyMeshBuffer(const IMeshBuffer* mb, bool uniquePrimitives)
+{
+	const T* v = (const T*)mb->getVertices();
+	core::array<u32> indices;
+	getIndices(mb, indices);
+
+	core::array<T> vertices;
+	u32 i;
+	if (uniquePrimitives)
+	{
+		vertices.set_used(indices.size());
+		for (i=0; i<indices.size(); ++i)
+		{
+			vertices[i] = v[indices[i]];
+			indices[i] = i;
+		}
+	}
+	else
+	{
+		vertices.set_used(mb->getVertexCount());
+		for (i=0; i<vertices.size(); ++i)
+			vertices[i] = v[i];
+	}
+	return createMeshBuffer(mb, vertices, indices);
+}
+
+// Copies a mesh buffer with quantized vertices, optionally with separate vertices for each index
+template <class T>
+IMeshBuffer* copyQuantizedMeshBuffer(const IMeshBuffer* mb, bool uniquePrimitives)
+{
+	// quantized vertices only exist in buffers with 16 bit indices
+	if (uniquePrimitives && mb->getIndexCount() > 65536)
+	{
+		os::Printer::log("Cannot create unique primitives, too many quantized vertices", ELL_ERROR);
+		return 0;
+	}
+
+	CMeshBuffer<T>* buffer = new CMeshBuffer<T>();
+	buffer->Material = mb->getMaterial();
+	buffer->Quantization = mb->getVertexQuantization();
+
+	const T* v = (const T*)mb->getVertices();
+	const u16* idx = mb->getIndices();
+	const u32 icount = mb->getIndexCount();
+	u32 i;
+	if (uniquePrimitives)
+	{
+		buffer->Vertices.reallocate(icount);
+		buffer->Indices.reallocate(icount);
+		for (i=0; i<icount; ++i)
+		{
+			buffer->Vertices.push_back(v[idx[i]]);
+			buffer->Indices.push_back(i);
+		}
+	}
+	else
+	{
+		const u32 vcount = mb->getVertexCount();
+		buffer->Vertices.reallocate(vcount);
+		for (i=0; i<vcount; ++i)
+			buffer->Vertices.push_back(v[i]);
+		buffer->Indices.reallocate(icount);
+		for (i=0; i<icount; ++i)
+			buffer->Indices.push_back(idx[i]);
+	}
+	buffer->setBoundingBox(mb->getBoundingBox());
+	return buffer;
+}
+} // end anonymous namespace
+
+
 //! Clones a static IMesh into a modifyable SMesh.
-// not yet 32bit
 SMesh* CMeshManipulator::createMeshCopy(scene::IMesh* mesh) const
 {
 	if (!mesh)
@@ -591,64 +760,32 @@ SMesh* CMeshManipulator::createMeshCopy(scene::IMesh* mesh) const
 	for ( u32 b=0; b<meshBufferCount; ++b)
 	{
 		const IMeshBuffer* const mb = mesh->getMeshBuffer(b);
+		IMeshBuffer* buffer = 0;
+
 		switch(mb->getVertexType())
 		{
 		case video::EVT_STANDARD:
-			{
-				SMeshBuffer* buffer = new SMeshBuffer();
-				buffer->Material = mb->getMaterial();
-				const u32 vcount = mb->getVertexCount();
-				buffer->Vertices.reallocate(vcount);
-				video::S3DVertex* vertices = (video::S3DVertex*)mb->getVertices();
-				for (u32 i=0; i < vcount; ++i)
-					buffer->Vertices.push_back(vertices[i]);
-				const u32 icount = mb->getIndexCount();
-				buffer->Indices.reallocate(icount);
-				const u16* indices = mb->getIndices();
-				for (u32 i=0; i < icount; ++i)
-					buffer->Indices.push_back(indices[i]);
-				clone->addMeshBuffer(buffer);
-				buffer->drop();
-			}
+			buffer = copyMeshBuffer<video::S3DVertex>(mb, false);
 			break;
 		case video::EVT_2TCOORDS:
-			{
-				SMeshBufferLightMap* buffer = new SMeshBufferLightMap();
-				buffer->Material = mb->getMaterial();
-				const u32 vcount = mb->getVertexCount();
-				buffer->Vertices.reallocate(vcount);
-				video::S3DVertex2TCoords* vertices = (video::S3DVertex2TCoords*)mb->getVertices();
-				for (u32 i=0; i < vcount; ++i)
-					buffer->Vertices.push_back(vertices[i]);
-				const u32 icount = mb->getIndexCount();
-				buffer->Indices.reallocate(icount);
-				const u16* indices = mb->getIndices();
-				for (u32 i=0; i < icount; ++i)
-					buffer->Indices.push_back(indices[i]);
-				clone->addMeshBuffer(buffer);
-				buffer->drop();
-			}
+			buffer = copyMeshBuffer<video::S3DVertex2TCoords>(mb, false);
 			break;
 		case video::EVT_TANGENTS:
-			{
-				SMeshBufferTangents* buffer = new SMeshBufferTangents();
-				buffer->Material = mb->getMaterial();
-				const u32 vcount = mb->getVertexCount();
-				buffer->Vertices.reallocate(vcount);
-				video::S3DVertexTangents* vertices = (video::S3DVertexTangents*)mb->getVertices();
-				for (u32 i=0; i < vcount; ++i)
-					buffer->Vertices.push_back(vertices[i]);
-				const u32 icount = mb->getIndexCount();
-				buffer->Indices.reallocate(icount);
-				const u16* indices = mb->getIndices();
-				for (u32 i=0; i < icount; ++i)
-					buffer->Indices.push_back(indices[i]);
-				clone->addMeshBuffer(buffer);
-				buffer->drop();
-			}
+			buffer = copyMeshBuffer<video::S3DVertexTangents>(mb, false);
+			break;
+		case video::EVT_QUANTIZED:
+			buffer = copyQuantizedMeshBuffer<video::S3DVertexQuantized>(mb, false);
+			break;
+		case video::EVT_QUANTIZED_TANGENTS:
+			buffer = copyQuantizedMeshBuffer<video::S3DVertexQuantizedTangents>(mb, false);
 			break;
 		}// end switch
 
+		if (buffer)
+		{
+			clone->addMeshBuffer(buffer);
+			buffer->drop();
+		}
 	}// end for all mesh buffers
 
 	clone->BoundingBox = mesh->getBoundingBox();
@@ -657,7 +794,6 @@ SMesh* CMeshManipulator::createMeshCopy(scene::IMesh* mesh) const
 
 
 //! Creates a copy of the mesh, which will only consist of unique primitives
-// not yet 32bit
 IMesh* CMeshManipulator::createMeshUniquePrimitives(IMesh* mesh) const
 {
 	if (!mesh)
@@ -670,285 +806,619 @@ IMesh* CMeshManipulator::createMeshUniquePrimitives(IMesh* mesh) const
 	for ( u32 b=0; b<meshBufferCount; ++b)
 	{
 		const IMeshBuffer* const mb = mesh->getMeshBuffer(b);
-		const s32 idxCnt = mb->getIndexCount();
-		const u16* idx = mb->getIndices();
+		IMeshBuffer* buffer = 0;
 
 		switch(mb->getVertexType())
 		{
 		case video::EVT_STANDARD:
-			{
-				SMeshBuffer* buffer = new SMeshBuffer();
-				buffer->Material = mb->getMaterial();
+			buffer = copyMeshBuffer<video::S3DVertex>(mb, true);
+			break;
+		case video::EVT_2TCOORDS:
+			buffer = copyMeshBuffer<video::S3DVertex2TCoords>(mb, true);
+			break;
+		case video::EVT_TANGENTS:
+			buffer = copyMeshBuffer<video::S3DVertexTangents>(mb, true);
+			break;
+		case video::EVT_QUANTIZED:
+			buffer = copyQuantizedMeshBuffer<video::S3DVertexQuantized>(mb, true);
+			break;
+		case video::EVT_QUANTIZED_TANGENTS:
+			buffer = copyQuantizedMeshBuffer<video::S3DVertexQuantizedTangents>(mb, true);
+			break;
+		}// end switch
 
-				video::S3DVertex* v =
-					(video::S3DVertex*)mb->getVertices();
+		if (buffer)
+		{
+			clone->addMeshBuffer(buffer);
+			buffer->drop();
+		}
+	}// end for all mesh buffers
 
-				buffer->Vertices.reallocate(idxCnt);
-				buffer->Indices.reallocate(idxCnt);
-				for (s32 i=0; i<idxCnt; i += 3)
-				{
-					buffer->Vertices.push_back( v[idx[i + 0 ]] );
-					buffer->Vertices.push_back( v[idx[i + 1 ]] );
-					buffer->Vertices.push_back( v[idx[i + 2 ]] );
+	clone->BoundingBox = mesh->getBoundingBox();
+	return clone;
+}
 
-					buffer->Indices.push_back( i + 0 );
-					buffer->Indices.push_back( i + 1 );
-					buffer->Indices.push_back( i + 2 );
-				}
 
-				buffer->setBoundingBox(mb->getBoundingBox());
-				clone->addMeshBuffer(buffer);
-				buffer->drop();
-			}
-			break;
-		case video::EVT_2TCOORDS:
-			{
-				SMeshBufferLightMap* buffer = new SMeshBufferLightMap();
-				buffer->Material = mb->getMaterial();
+namespace
+{
+// Vertices are welded when positions, normals and tangents differ by at most
+// the tolerance and all other attributes are equal.
+inline bool isWeldable(const video::S3DVertex& a, const video::S3DVertex& b, f32 tolerance)
+{
+	return a.Pos.equals(b.Pos, tolerance) &&
+		a.Normal.equals(b.Normal, tolerance) &&
+		a.TCoords.equals(b.TCoords) &&
+		a.Color == b.Color;
+}
+
+inline bool isWeldable(const video::S3DVertex2TCoords& a, const video::S3DVertex2TCoords& b, f32 tolerance)
+{
+	return a.Pos.equals(b.Pos, tolerance) &&
+		a.Normal.equals(b.Normal, tolerance) &&
+		a.TCoords.equals(b.TCoords) &&
+		a.TCoords2.equals(b.TCoords2) &&
+		a.Color == b.Color;
+}
+
+inline bool isWeldable(const video::S3DVertexTangents& a, const video::S3DVertexTangents& b, f32 tolerance)
+{
+	return a.Pos.equals(b.Pos, tolerance) &&
+		a.Normal.equals(b.Normal, tolerance) &&
+		a.TCoords.equals(b.TCoords) &&
+		a.Tangent.equals(b.Tangent, tolerance) &&
+		a.Binormal.equals(b.Binormal, tolerance) &&
+		a.Color == b.Color;
+}
 
-				video::S3DVertex2TCoords* v =
-					(video::S3DVertex2TCoords*)mb->getVertices();
+// Vertex with only a position, to weld positions
+struct SWeldPosition
+{
+	core::vector3df Pos;
+};
 
-				buffer->Vertices.reallocate(idxCnt);
-				buffer->Indices.reallocate(idxCnt);
-				for (s32 i=0; i<idxCnt; i += 3)
-				{
-					buffer->Vertices.push_back( v[idx[i + 0 ]] );
-					buffer->Vertices.push_back( v[idx[i + 1 ]] );
-					buffer->Vertices.push_back( v[idx[i + 2 ]] );
+inline bool isWeldable(const SWeldPosition& a, const SWeldPosition& b, f32 tolerance)
+{
+	return a.Pos.equals(b.Pos, tolerance);
+}
+
+// Cell of the welding grid along one axis, and the neighbor cell which is nearer
+inline void getWeldCells(f32 value, f64 invCellSize, u32 cells[2])
+{
+	const f64 scaled = value * invCellSize;
+	const f64 cell = floor(scaled);
+	s32 c;
+	if (cell >= 2147483646.0)
+		c = 2147483646;
+	else if (cell > -2147483646.0)
+		c = (s32)cell;
+	else
+		c = -2147483646;
+	cells[0] = (u32)c;
+	cells[1] = (u32)(scaled - cell < 0.5 ? c-1 : c+1);
+}
+
+inline u32 getWeldBucket(u32 x, u32 y, u32 z, u32 mask)
+{
+	return ((x * 73856093u) ^ (y * 19349663u) ^ (z * 83492791u)) & mask;
+}
 
-					buffer->Indices.push_back( i + 0 );
-					buffer->Indices.push_back( i + 1 );
-					buffer->Indices.push_back( i + 2 );
+// Finds the welded vertex of every vertex.
+/** Each vertex is welded to the first vertex before it which it matches, so
+the result is the same as when comparing with all previous vertices. But the
+positions are sorted into a hashed grid with cells four times the tolerance,
+so only the vertices in eight neighboring cells have to be compared. */
+template <class T>
+void weldVertices(const T* v, u32 vertexCount, f32 tolerance,
+		core::array<u32>& redirects, core::array<T>& welded)
+{
+	redirects.set_used(vertexCount);
+	welded.set_used(0);
+	welded.reallocate(vertexCount);
+
+	// matching positions are at most a quarter cell apart, so they are either
+	// in the same cell or in the neighbor cell nearer to the vertex
+	const f64 invCellSize = tolerance > 0.f ? 0.25 / tolerance : 1.0;
+
+	u32 bucketCount = 64;
+	while (bucketCount < vertexCount && bucketCount < 0x40000000)
+		bucketCount <<= 1;
+	bucketCount <<= 1;
+	const u32 mask = bucketCount - 1;
+
+	// vertices of each bucket in ascending order
+	core::array<core::vector2d<s32> > buckets; // first and last vertex
+	core::array<s32> next;
+	buckets.set_used(bucketCount);
+	next.set_used(vertexCount);
+	u32 i;
+	for (i=0; i<bucketCount; ++i)
+		buckets[i].X = -1;
+
+	for (i=0; i<vertexCount; ++i)
+	{
+		u32 x[2], y[2], z[2];
+		getWeldCells(v[i].Pos.X, invCellSize, x);
+		getWeldCells(v[i].Pos.Y, invCellSize, y);
+		getWeldCells(v[i].Pos.Z, invCellSize, z);
+
+		// first matching vertex in the eight cells
+		s32 match = -1;
+		for (u32 n=0; n<8; ++n)
+		{
+			const u32 bucket = getWeldBucket(x[n&1], y[(n>>1)&1], z[n>>2], mask);
+			for (s32 j=buckets[bucket].X; j>=0 && (match<0 || j<match); j=next[j])
+			{
+				if (isWeldable(v[i], v[j], tolerance))
+				{
+					match = j;
+					break;
 				}
-				buffer->setBoundingBox(mb->getBoundingBox());
-				clone->addMeshBuffer(buffer);
-				buffer->drop();
 			}
-			break;
-		case video::EVT_TANGENTS:
-			{
-				SMeshBufferTangents* buffer = new SMeshBufferTangents();
-				buffer->Material = mb->getMaterial();
+		}
 
-				video::S3DVertexTangents* v =
-					(video::S3DVertexTangents*)mb->getVertices();
+		if (match >= 0)
+		{
+			redirects[i] = redirects[match];
+		}
+		else
+		{
+			redirects[i] = welded.size();
+			welded.push_back(v[i]);
+		}
 
-				buffer->Vertices.reallocate(idxCnt);
-				buffer->Indices.reallocate(idxCnt);
-				for (s32 i=0; i<idxCnt; i += 3)
-				{
-					buffer->Vertices.push_back( v[idx[i + 0 ]] );
-					buffer->Vertices.push_back( v[idx[i + 1 ]] );
-					buffer->Vertices.push_back( v[idx[i + 2 ]] );
+		const u32 bucket = getWeldBucket(x[0], y[0], z[0], mask);
+		next[i] = -1;
+		if (buckets[bucket].X < 0)
+			buckets[bucket].X = i;
+		else
+			next[buckets[bucket].Y] = i;
+		buckets[bucket].Y = i;
+	}
+}
 
-					buffer->Indices.push_back( i + 0 );
-					buffer->Indices.push_back( i + 1 );
-					buffer->Indices.push_back( i + 2 );
-				}
+// Creates a mesh buffer with welded vertices, with 32 bit indices when needed
+template <class T>
+IMeshBuffer* createWeldedMeshBuffer(const IMeshBuffer* mb, f32 tolerance)
+{
+	core::array<T> vertices;
+	core::array<u32> redirects;
+	weldVertices((const T*)mb->getVertices(), mb->getVertexCount(), tolerance, redirects, vertices);
+
+	// Clean up any degenerate tris
+	const u32 indexCount = mb->getIndexCount();
+	const bool indices32 = mb->getIndexType() == video::EIT_32BIT;
+	const u16* indices = mb->getIndices();
+	core::array<u32> welded;
+	welded.reallocate(indexCount);
+	for (u32 i=0; i+2<indexCount; i+=3)
+	{
+		u32 a, b, c;
+		if (indices32)
+		{
+			a = redirects[((const u32*)indices)[i]];
+			b = redirects[((const u32*)indices)[i+1]];
+			c = redirects[((const u32*)indices)[i+2]];
+		}
+		else
+		{
+			a = redirects[indices[i]];
+			b = redirects[indices[i+1]];
+			c = redirects[indices[i+2]];
+		}
 
-				buffer->setBoundingBox(mb->getBoundingBox());
-				clone->addMeshBuffer(buffer);
-				buffer->drop();
-			}
-			break;
-		}// end switch
+		if (a == b || b == c || a == c)
+			continue;
 
-	}// end for all mesh buffers
+		welded.push_back(a);
+		welded.push_back(b);
+		welded.push_back(c);
+	}
 
-	clone->BoundingBox = mesh->getBoundingBox();
-	return clone;
+	return createMeshBuffer(mb, vertices, welded);
 }
+} // end anonymous namespace
 
 
 //! Creates a copy of a mesh, which will have identical vertices welded together
-// not yet 32bit
 IMesh* CMeshManipulator::createMeshWelded(IMesh *mesh, f32 tolerance) const
 {
 	SMesh* clone = new SMesh();
 	clone->BoundingBox = mesh->getBoundingBox();
 
-	core::array<u16> redirects;
-
 	for (u32 b=0; b<mesh->getMeshBufferCount(); ++b)
 	{
 		const IMeshBuffer* const mb = mesh->getMeshBuffer(b);
-		// reset redirect list
-		redirects.set_used(mb->getVertexCount());
-
-		const u16* indices = 0;
-		u32 indexCount = 0;
-		core::array<u16>* outIdx = 0;
+		IMeshBuffer* buffer = 0;
 
 		switch(mb->getVertexType())
 		{
 		case video::EVT_STANDARD:
+			buffer = createWeldedMeshBuffer<video::S3DVertex>(mb, tolerance);
+			break;
+		case video::EVT_2TCOORDS:
+			buffer = createWeldedMeshBuffer<video::S3DVertex2TCoords>(mb, tolerance);
+			break;
+		case video::EVT_TANGENTS:
+			buffer = createWeldedMeshBuffer<video::S3DVertexTangents>(mb, tolerance);
+			break;
+		default:
+			os::Printer::log("Cannot create welded mesh, vertex type unsupported", ELL_ERROR);
+			break;
+		}
+
+		if (buffer)
 		{
-			SMeshBuffer* buffer = new SMeshBuffer();
-			buffer->BoundingBox = mb->getBoundingBox();
-			buffer->Material = mb->getMaterial();
 			clone->addMeshBuffer(buffer);
 			buffer->drop();
+		}
+	}
+	return clone;
+}
 
-			video::S3DVertex* v =
-					(video::S3DVertex*)mb->getVertices();
 
-			u32 vertexCount = mb->getVertexCount();
+namespace
+{
+//! Data shared by the jobs of recalculateNormalsWelded
+struct SWeldedNormals
+{
+	const u8* Positions;
+	u32 Pitch;
+	const u32* Indices;
+	u32 TriangleCount;
+	u32 VertexCount;
+	//! cosine of the largest angle between smoothed triangles
+	f32 MinCos;
+	bool AngleWeighted;
+
+	//! unit normal of each triangle
+	core::array<core::vector3df> FaceNormals;
+	//! weight of each corner of the triangles
+	core::array<f32> CornerWeights;
+	//! corners of each vertex, VertexCorners[VertexFirst[i]] to VertexCorners[VertexFirst[i+1]-1]
+	core::array<u32> VertexFirst;
+	core::array<u32> VertexCorners;
+	//! corners at each welded position, in the same way
+	core::array<u32> PositionIds;
+	core::array<u32> PositionFirst;
+	core::array<u32> PositionCorners;
+
+	//! vertices of tangent mesh buffers, 0 for other types
+	video::S3DVertexTangents* TangentVertices;
+	core::array<core::vector3df> CornerTangents;
+	core::array<core::vector3df> CornerBinormals;
+
+	SNormalWriter* Normals;
+	u32 JobSize;
+};
 
-			indices = mb->getIndices();
-			indexCount = mb->getIndexCount();
-			outIdx = &buffer->Indices;
+// Sorts the corners of the triangles by a key of their vertex, first[k] is the first corner with key k
+void buildCornerLists(const core::array<u32>& indices, const u32* vertexKeys, u32 keyCount,
+		core::array<u32>& first, core::array<u32>& corners)
+{
+	const u32 cornerCount = indices.size();
+	first.set_used(keyCount+1);
+	u32 i;
+	for (i=0; i<=keyCount; ++i)
+		first[i] = 0;
+	for (i=0; i<cornerCount; ++i)
+		++first[(vertexKeys ? vertexKeys[indices[i]] : indices[i])+1];
+	for (i=0; i<keyCount; ++i)
+		first[i+1] += first[i];
+
+	corners.set_used(cornerCount);
+	core::array<u32> fill(first);
+	for (i=0; i<cornerCount; ++i)
+		corners[fill[vertexKeys ? vertexKeys[indices[i]] : indices[i]]++] = i;
+}
 
-			buffer->Vertices.reallocate(vertexCount);
+// Calculates the normals and corner weights of a range of triangles
+void calculateFaceNormals(void* userData, u32 job)
+{
+	SWeldedNormals& data = *(SWeldedNormals*)userData;
+	const u32 end = core::min_((job+1)*data.JobSize, data.TriangleCount);
 
-			for (u32 i=0; i < vertexCount; ++i)
+	for (u32 t=job*data.JobSize; t<end; ++t)
+	{
+		const u32* idx = data.Indices + t*3;
+		const core::vector3df& v1 = getVertexPosition(data.Positions, data.Pitch, idx[0]);
+		const core::vector3df& v2 = getVertexPosition(data.Positions, data.Pitch, idx[1]);
+		const core::vector3df& v3 = getVertexPosition(data.Positions, data.Pitch, idx[2]);
+
+		core::vector3df normal = (v2-v1).crossProduct(v3-v1);
+		core::vector3df weight(1.f, 1.f, 1.f);
+		if (normal.getLengthSQ() == 0.f)
+			weight.set(0.f, 0.f, 0.f); // degenerated triangles have no direction
+		else if (data.AngleWeighted)
+			weight = getAngleWeight(v1, v2, v3);
+		data.FaceNormals[t] = normal.normalize();
+		data.CornerWeights[t*3] = weight.X;
+		data.CornerWeights[t*3+1] = weight.Y;
+		data.CornerWeights[t*3+2] = weight.Z;
+
+		if (data.TangentVertices)
+		{
+			const video::S3DVertexTangents* v = data.TangentVertices;
+			core::vector3df localNormal;
+			for (u32 k=0; k<3; ++k)
 			{
-				bool found = false;
-				for (u32 j=0; j < i; ++j)
-				{
-					if ( v[i].Pos.equals( v[j].Pos, tolerance) &&
-						 v[i].Normal.equals( v[j].Normal, tolerance) &&
-						 v[i].TCoords.equals( v[j].TCoords ) &&
-						(v[i].Color == v[j].Color) )
-					{
-						redirects[i] = redirects[j];
-						found = true;
-						break;
-					}
-				}
-				if (!found)
+				const u32 a = idx[k];
+				const u32 b = idx[(k+1)%3];
+				const u32 c = idx[(k+2)%3];
+				if (v[a].Pos == v[b].Pos || v[a].Pos == v[c].Pos || v[b].Pos == v[c].Pos)
 				{
-					redirects[i] = buffer->Vertices.size();
-					buffer->Vertices.push_back(v[i]);
+					data.CornerTangents[t*3+k].set(0.f, 0.f, 0.f);
+					data.CornerBinormals[t*3+k].set(0.f, 0.f, 0.f);
+					continue;
 				}
+				calculateTangents(localNormal, data.CornerTangents[t*3+k], data.CornerBinormals[t*3+k],
+					v[a].Pos, v[b].Pos, v[c].Pos, v[a].TCoords, v[b].TCoords, v[c].TCoords);
+				data.CornerTangents[t*3+k] *= weight.X*(k==0) + weight.Y*(k==1) + weight.Z*(k==2);
+				data.CornerBinormals[t*3+k] *= weight.X*(k==0) + weight.Y*(k==1) + weight.Z*(k==2);
 			}
-
-			break;
 		}
-		case video::EVT_2TCOORDS:
-		{
-			SMeshBufferLightMap* buffer = new SMeshBufferLightMap();
-			buffer->BoundingBox = mb->getBoundingBox();
-			buffer->Material = mb->getMaterial();
-			clone->addMeshBuffer(buffer);
-			buffer->drop();
-
-			video::S3DVertex2TCoords* v =
-					(video::S3DVertex2TCoords*)mb->getVertices();
+	}
+}
 
-			u32 vertexCount = mb->getVertexCount();
+// Sums up the triangle normals around a range of vertices
+void calculateVertexNormals(void* userData, u32 job)
+{
+	SWeldedNormals& data = *(SWeldedNormals*)userData;
+	const u32 end = core::min_((job+1)*data.JobSize, data.VertexCount);
 
-			indices = mb->getIndices();
-			indexCount = mb->getIndexCount();
-			outIdx = &buffer->Indices;
+	for (u32 i=job*data.JobSize; i<end; ++i)
+	{
+		// the triangles using the vertex decide its direction
+		core::vector3df own(0.f, 0.f, 0.f);
+		u32 c;
+		for (c=data.VertexFirst[i]; c<data.VertexFirst[i+1]; ++c)
+		{
+			const u32 corner = data.VertexCorners[c];
+			own += data.FaceNormals[corner/3] * data.CornerWeights[corner];
+		}
+		own.normalize();
 
-			buffer->Vertices.reallocate(vertexCount);
+		// all triangles at the position which are near enough to that direction
+		core::vector3df normal(0.f, 0.f, 0.f);
+		const u32 position = data.PositionIds[i];
+		for (c=data.PositionFirst[position]; c<data.PositionFirst[position+1]; ++c)
+		{
+			const u32 corner = data.PositionCorners[c];
+			const core::vector3df& faceNormal = data.FaceNormals[corner/3];
+			if (data.Indices[corner] == i || faceNormal.dotProduct(own) >= data.MinCos)
+				normal += faceNormal * data.CornerWeights[corner];
+		}
+		normal.normalize();
+		data.Normals->set(i, normal);
 
-			for (u32 i=0; i < vertexCount; ++i)
+		if (data.TangentVertices)
+		{
+			core::vector3df tangent(0.f, 0.f, 0.f);
+			core::vector3df binormal(0.f, 0.f, 0.f);
+			for (c=data.VertexFirst[i]; c<data.VertexFirst[i+1]; ++c)
 			{
-				bool found = false;
-				for (u32 j=0; j < i; ++j)
-				{
-					if ( v[i].Pos.equals( v[j].Pos, tolerance) &&
-						 v[i].Normal.equals( v[j].Normal, tolerance) &&
-						 v[i].TCoords.equals( v[j].TCoords ) &&
-						 v[i].TCoords2.equals( v[j].TCoords2 ) &&
-						(v[i].Color == v[j].Color) )
-					{
-						redirects[i] = redirects[j];
-						found = true;
-						break;
-					}
-				}
-				if (!found)
-				{
-					redirects[i] = buffer->Vertices.size();
-					buffer->Vertices.push_back(v[i]);
-				}
+				tangent += data.CornerTangents[data.VertexCorners[c]];
+				binormal += data.CornerBinormals[data.VertexCorners[c]];
 			}
-			break;
+			// keep the tangent space orthogonal to the smoothed normal
+			tangent -= normal * normal.dotProduct(tangent);
+			binormal -= normal * normal.dotProduct(binormal);
+			data.TangentVertices[i].Tangent = tangent.normalize();
+			data.TangentVertices[i].Binormal = binormal.normalize();
 		}
-		case video::EVT_TANGENTS:
-		{
-			SMeshBufferTangents* buffer = new SMeshBufferTangents();
-			buffer->BoundingBox = mb->getBoundingBox();
-			buffer->Material = mb->getMaterial();
-			clone->addMeshBuffer(buffer);
-			buffer->drop();
+	}
+}
 
-			video::S3DVertexTangents* v =
-					(video::S3DVertexTangents*)mb->getVertices();
+// Creates the threads for the normal jobs, none if only one thread is used
+CThreadPool* createNormalThreads(u32& threadCount)
+{
+	if (threadCount == 0)
+		threadCount = CThreadPool::getProcessorCount();
+	return threadCount > 1 ? new CThreadPool(threadCount-1) : 0;
+}
 
-			u32 vertexCount = mb->getVertexCount();
+// Runs the jobs in the pool, or in this thread without a pool
+void runNormalJobs(CThreadPool* pool, CThreadPool::JobFunction job, void* userData, u32 jobCount)
+{
+	if (pool && jobCount > 1)
+		pool->run(job, userData, jobCount);
+	else
+	{
+		for (u32 i=0; i<jobCount; ++i)
+			job(userData, i);
+	}
+}
 
-			indices = mb->getIndices();
-			indexCount = mb->getIndexCount();
-			outIdx = &buffer->Indices;
+// Recalculates the welded normals of one buffer with the threads of the pool
+void recalculateBufferNormalsWelded(IMeshBuffer* buffer, f32 maxAngle,
+		bool angleWeighted, f32 tolerance, CThreadPool* pool, u32 threadCount)
+{
+	if (!buffer || buffer->getPrimitiveType() != EPT_TRIANGLES)
+		return;
 
-			buffer->Vertices.reallocate(vertexCount);
+	SWeldedNormals data;
+	core::array<core::vector3df> decoded;
+	data.Positions = getVertexPositions(buffer, decoded, data.Pitch);
+	core::array<u32> indices;
+	getIndices(buffer, indices);
+	indices.set_used(indices.size() - indices.size()%3);
+	data.Indices = indices.const_pointer();
+	data.TriangleCount = indices.size() / 3;
+	data.VertexCount = buffer->getVertexCount();
+	data.MinCos = maxAngle >= 180.f ? -2.f : cosf(maxAngle * core::DEGTORAD);
+	data.AngleWeighted = angleWeighted;
+	data.TangentVertices = buffer->getVertexType() == video::EVT_TANGENTS ?
+		(video::S3DVertexTangents*)buffer->getVertices() : 0;
+	SNormalWriter normals(buffer);
+	data.Normals = &normals;
+
+	// give the same id to all vertices at the same position
+	core::array<SWeldPosition> positions;
+	positions.set_used(data.VertexCount);
+	u32 i;
+	for (i=0; i<data.VertexCount; ++i)
+		positions[i].Pos = getVertexPosition(data.Positions, data.Pitch, i);
+	core::array<SWeldPosition> welded;
+	weldVertices(positions.const_pointer(), data.VertexCount, tolerance, data.PositionIds, welded);
+	positions.clear();
+
+	buildCornerLists(indices, 0, data.VertexCount, data.VertexFirst, data.VertexCorners);
+	buildCornerLists(indices, data.PositionIds.const_pointer(), welded.size(), data.PositionFirst, data.PositionCorners);
+
+	data.FaceNormals.set_used(data.TriangleCount);
+	data.CornerWeights.set_used(indices.size());
+	if (data.TangentVertices)
+	{
+		data.CornerTangents.set_used(indices.size());
+		data.CornerBinormals.set_used(indices.size());
+	}
 
-			for (u32 i=0; i < vertexCount; ++i)
-			{
-				bool found = false;
-				for (u32 j=0; j < i; ++j)
-				{
-					if ( v[i].Pos.equals( v[j].Pos, tolerance) &&
-						 v[i].Normal.equals( v[j].Normal, tolerance) &&
-						 v[i].TCoords.equals( v[j].TCoords ) &&
-						 v[i].Tangent.equals( v[j].Tangent, tolerance ) &&
-						 v[i].Binormal.equals( v[j].Binormal, tolerance ) &&
-						(v[i].Color == v[j].Color) )
-					{
-						redirects[i] = redirects[j];
-						found = true;
-						break;
-					}
-				}
-				if (!found)
-				{
-					redirects[i] = buffer->Vertices.size();
-					buffer->Vertices.push_back(v[i]);
-				}
-			}
-			break;
-		}
-		default:
-			os::Printer::log("Cannot create welded mesh, vertex type unsupported", ELL_ERROR);
-			break;
+	// a few jobs per thread balance the work
+	const u32 jobsPerThread = threadCount > 1 ? 4 : 1;
+	data.JobSize = core::max_(data.TriangleCount / (threadCount*jobsPerThread) + 1, 1024u);
+	runNormalJobs(pool, calculateFaceNormals, &data, (data.TriangleCount + data.JobSize - 1) / data.JobSize);
+	data.JobSize = core::max_(data.VertexCount / (threadCount*jobsPerThread) + 1, 1024u);
+	runNormalJobs(pool, calculateVertexNormals, &data, (data.VertexCount + data.JobSize - 1) / data.JobSize);
+
+	buffer->setDirty(EBT_VERTEX);
+}
+} // end anonymous namespace
+
+
+//! Recalculates smooth normals, also across vertices which only share their position.
+void CMeshManipulator::recalculateNormalsWelded(IMeshBuffer* buffer, f32 maxAngle,
+		bool angleWeighted, f32 tolerance, u32 threadCount) const
+{
+	if (!buffer || buffer->getPrimitiveType() != EPT_TRIANGLES)
+		return;
+
+	CThreadPool* pool = createNormalThreads(threadCount);
+	recalculateBufferNormalsWelded(buffer, maxAngle, angleWeighted, tolerance, pool, threadCount);
+	if (pool)
+		pool->drop();
+}
+
+
+//! Recalculates smooth normals of all mesh buffers, also across vertices which only share their position.
+void CMeshManipulator::recalculateNormalsWelded(IMesh* mesh, f32 maxAngle,
+		bool angleWeighted, f32 tolerance, u32 threadCount) const
+{
+	if (!mesh)
+		return;
+
+	// the threads are shared by all mesh buffers
+	CThreadPool* pool = createNormalThreads(threadCount);
+	const u32 bcount = mesh->getMeshBufferCount();
+	for (u32 b=0; b<bcount; ++b)
+		recalculateBufferNormalsWelded(mesh->getMeshBuffer(b), maxAngle, angleWeighted, tolerance, pool, threadCount);
+	if (pool)
+		pool->drop();
+}
+
+
+namespace
+{
+
+// Creates a mesh buffer with the triangles which remain after simplification, and only the vertices they use
+template <class T>
+IMeshBuffer* createSimplifiedMeshBuffer(const IMeshBuffer* mb, CMeshSimplifier& simplifier,
+		u32 targetTriangleCount, f32 maxError)
+{
+	const T* v = (const T*)mb->getVertices();
+	const u32 vertexCount = mb->getVertexCount();
+	u32 i;
+
+	core::array<u32> indices;
+	getIndices(mb, indices);
+
+	if (mb->getPrimitiveType() == EPT_TRIANGLES)
+	{
+		core::array<core::vector3df> positions;
+		positions.set_used(vertexCount);
+		for (i=0; i<vertexCount; ++i)
+			positions[i] = v[i].Pos;
+		simplifier.simplify(indices, positions, targetTriangleCount, maxError);
+	}
+
+	// keep the order of the remaining vertices
+	core::array<u32> redirects;
+	redirects.set_used(vertexCount);
+	for (i=0; i<vertexCount; ++i)
+		redirects[i] = 0;
+	for (i=0; i<indices.size(); ++i)
+		redirects[indices[i]] = 1;
+
+	core::array<T> vertices;
+	for (i=0; i<vertexCount; ++i)
+	{
+		if (redirects[i])
+		{
+			redirects[i] = vertices.size();
+			vertices.push_back(v[i]);
 		}
+	}
+	for (i=0; i<indices.size(); ++i)
+		indices[i] = redirects[indices[i]];
 
-		// Clean up any degenerate tris
- 		core::array<u16> &Indices = *outIdx;
-		Indices.clear();
-		Indices.reallocate(indexCount);
-		for (u32 i = 0; i < indexCount; i+=3)
- 		{
-			u16 a, b, c;
-			a = redirects[indices[i]];
-			b = redirects[indices[i+1]];
-			c = redirects[indices[i+2]];
+	IMeshBuffer* buffer = createMeshBuffer(mb, vertices, indices);
+	buffer->recalculateBoundingBox();
+	return buffer;
+}
+} // end anonymous namespace
 
-			bool drop = false;
 
-			if (a == b || b == c || a == c)
-				drop = true;
+//! Creates a copy of the mesh with fewer triangles, using quadric error metrics.
+IMesh* CMeshManipulator::createMeshSimplified(IMesh* mesh, u32 targetTriangleCount, f32 maxError) const
+{
+	if (!mesh)
+		return 0;
 
-			// Open for other checks
+	SMesh* clone = new SMesh();
 
-			if (!drop)
-			{
-				Indices.push_back(a);
-				Indices.push_back(b);
-				Indices.push_back(c);
-			}
+	u32 triangleCount = 0;
+	u32 b;
+	for (b=0; b<mesh->getMeshBufferCount(); ++b)
+		triangleCount += mesh->getMeshBuffer(b)->getIndexCount()/3;
+
+	// the error is relative to the mesh size, the simplifier works with distances
+	const f32 scale = mesh->getBoundingBox().getExtent().getLength();
+
+	CMeshSimplifier simplifier;
+	for (b=0; b<mesh->getMeshBufferCount(); ++b)
+	{
+		const IMeshBuffer* const mb = mesh->getMeshBuffer(b);
+		const u32 target = triangleCount ?
+			(u32)((f64)targetTriangleCount * (mb->getIndexCount()/3) / triangleCount) : 0;
+		IMeshBuffer* buffer = 0;
+
+		switch(mb->getVertexType())
+		{
+		case video::EVT_STANDARD:
+			buffer = createSimplifiedMeshBuffer<video::S3DVertex>(mb, simplifier, target, maxError*scale);
+			break;
+		case video::EVT_2TCOORDS:
+			buffer = createSimplifiedMeshBuffer<video::S3DVertex2TCoords>(mb, simplifier, target, maxError*scale);
+			break;
+		case video::EVT_TANGENTS:
+			buffer = createSimplifiedMeshBuffer<video::S3DVertexTangents>(mb, simplifier, target, maxError*scale);
+			break;
+		default:
+			os::Printer::log("Cannot create simplified mesh, vertex type unsupported", ELL_ERROR);
+			break;
+		}
+
+		if (buffer)
+		{
+			clone->addMeshBuffer(buffer);
+			buffer->drop();
 		}
 	}
+
+	clone->recalculateBoundingBox();
 	return clone;
 }
 
 
 //! Creates a copy of the mesh, which will only consist of S3DVertexTangents vertices.
-// not yet 32bit
 IMesh* CMeshManipulator::createMeshWithTangents(IMesh* mesh, bool recalculateNormals, bool smooth, bool angleWeighted, bool calculateTangents) const
 {
 	if (!mesh)
@@ -963,20 +1433,23 @@ IMesh* CMeshManipulator::createMeshWithTangents(IMesh* mesh, bool recalculateNor
 	{
 		const IMeshBuffer* const original = mesh->getMeshBuffer(b);
 		const u32 idxCnt = original->getIndexCount();
-		const u16* idx = original->getIndices();
+		core::array<u32> idx;
+		getIndices(original, idx);
 
-		SMeshBufferTangents* buffer = new SMeshBufferTangents();
+		core::array<video::S3DVertexTangents> vertices;
+		core::array<u32> indices;
+		vertices.reallocate(idxCnt);
+		indices.reallocate(idxCnt);
 
-		buffer->Material = original->getMaterial();
-		buffer->Vertices.reallocate(idxCnt);
-		buffer->Indices.reallocate(idxCnt);
-
-		core::map<video::S3DVertexTangents, int> vertMap;
+		typedef core::hashmap<video::S3DVertexTangents, int, core::hash_bytes<video::S3DVertexTangents>, core::equal_bytes<video::S3DVertexTangents> > VertexMap;
+		VertexMap vertMap;
+		vertMap.reserve(idxCnt);
 		int vertLocation;
 
 		// copy vertices
 
 		const video::E_VERTEX_TYPE vType = original->getVertexType();
+		const video::SVertexQuantization quantization = original->getVertexQuantization();
 		video::S3DVertexTangents vNew;
 		for (u32 i=0; i<idxCnt; ++i)
 		{
@@ -1005,22 +1478,38 @@ IMesh* CMeshManipulator::createMeshWithTangents(IMesh* mesh, bool recalculateNor
 					vNew = v[idx[i]];
 				}
 				break;
+			case video::EVT_QUANTIZED:
+				{
+					const video::S3DVertexQuantized* v =
+						(const video::S3DVertexQuantized*)original->getVertices();
+					vNew = video::S3DVertexTangents(
+							v[idx[i]].getPosition(quantization), v[idx[i]].getNormal(), v[idx[i]].Color, v[idx[i]].getTCoords());
+				}
+				break;
+			case video::EVT_QUANTIZED_TANGENTS:
+				{
+					const video::S3DVertexQuantizedTangents* v =
+						(const video::S3DVertexQuantizedTangents*)original->getVertices();
+					vNew = v[idx[i]].get(quantization);
+				}
+				break;
 			}
-			core::map<video::S3DVertexTangents, int>::Node* n = vertMap.find(vNew);
+			VertexMap::Node* n = vertMap.find(vNew);
 			if (n)
 			{
 				vertLocation = n->getValue();
 			}
 			else
 			{
-				vertLocation = buffer->Vertices.size();
-				buffer->Vertices.push_back(vNew);
+				vertLocation = vertices.size();
+				vertices.push_back(vNew);
 				vertMap.insert(vNew, vertLocation);
 			}
 
 			// create new indices
-			buffer->Indices.push_back(vertLocation);
+			indices.push_back(vertLocation);
 		}
+		IMeshBuffer* buffer = createMeshBuffer(original, vertices, indices);
 		buffer->recalculateBoundingBox();
 
 		// add new buffer
@@ -1073,6 +1562,13 @@ void CMeshManipulator::heightmapOptimizeMesh(IMeshBuffer * const mb, const f32 t
 	using namespace core;
 	using namespace video;
 
+	// the acceleration structure marks unused entries with USHRT_MAX
+	if (mb->getIndexType() != EIT_16BIT)
+	{
+		os::Printer::log("Cannot optimize a heightmap with 32bit indices", ELL_ERROR);
+		return;
+	}
+
 	array<height_edge> edges;
 
 	const u32 idxs = mb->getIndexCount();
@@ -1349,7 +1845,6 @@ donehere:
 
 
 //! Creates a copy of the mesh, which will only consist of S3DVertex2TCoords vertices.
-// not yet 32bit
 IMesh* CMeshManipulator::createMeshWith2TCoords(IMesh* mesh) const
 {
 	if (!mesh)
@@ -1364,19 +1859,23 @@ IMesh* CMeshManipulator::createMeshWith2TCoords(IMesh* mesh) const
 	{
 		const IMeshBuffer* const original = mesh->getMeshBuffer(b);
 		const u32 idxCnt = original->getIndexCount();
-		const u16* idx = original->getIndices();
+		core::array<u32> idx;
+		getIndices(original, idx);
 
-		SMeshBufferLightMap* buffer = new SMeshBufferLightMap();
-		buffer->Material = original->getMaterial();
-		buffer->Vertices.reallocate(idxCnt);
-		buffer->Indices.reallocate(idxCnt);
+		core::array<video::S3DVertex2TCoords> vertices;
+		core::array<u32> indices;
+		vertices.reallocate(idxCnt);
+		indices.reallocate(idxCnt);
 
-		core::map<video::S3DVertex2TCoords, int> vertMap;
+		typedef core::hashmap<video::S3DVertex2TCoords, int, core::hash_bytes<video::S3DVertex2TCoords>, core::equal_bytes<video::S3DVertex2TCoords> > VertexMap;
+		VertexMap vertMap;
+		vertMap.reserve(idxCnt);
 		int vertLocation;
 
 		// copy vertices
 
 		const video::E_VERTEX_TYPE vType = original->getVertexType();
+		const video::SVertexQuantization quantization = original->getVertexQuantization();
 		video::S3DVertex2TCoords vNew;
 		for (u32 i=0; i<idxCnt; ++i)
 		{
@@ -1405,22 +1904,34 @@ IMesh* CMeshManipulator::createMeshWith2TCoords(IMesh* mesh) const
 							v[idx[i]].Pos, v[idx[i]].Normal, v[idx[i]].Color, v[idx[i]].TCoords, v[idx[i]].TCoords);
 				}
 				break;
+			case video::EVT_QUANTIZED:
+			case video::EVT_QUANTIZED_TANGENTS:
+				{
+					const u32 pitch = video::getVertexPitchFromType(vType);
+					const video::S3DVertexQuantized* v = (const video::S3DVertexQuantized*)
+						((const u8*)original->getVertices() + idx[i]*pitch);
+					const core::vector2df tcoords = v->getTCoords();
+					vNew = video::S3DVertex2TCoords(
+							v->getPosition(quantization), v->getNormal(), v->Color, tcoords, tcoords);
+				}
+				break;
 			}
-			core::map<video::S3DVertex2TCoords, int>::Node* n = vertMap.find(vNew);
+			VertexMap::Node* n = vertMap.find(vNew);
 			if (n)
 			{
 				vertLocation = n->getValue();
 			}
 			else
 			{
-				vertLocation = buffer->Vertices.size();
-				buffer->Vertices.push_back(vNew);
+				vertLocation = vertices.size();
+				vertices.push_back(vNew);
 				vertMap.insert(vNew, vertLocation);
 			}
 
 			// create new indices
-			buffer->Indices.push_back(vertLocation);
+			indices.push_back(vertLocation);
 		}
+		IMeshBuffer* buffer = createMeshBuffer(original, vertices, indices);
 		buffer->recalculateBoundingBox();
 
 		// add new buffer
@@ -1434,7 +1945,6 @@ IMesh* CMeshManipulator::createMeshWith2TCoords(IMesh* mesh) const
 
 
 //! Creates a copy of the mesh, which will only consist of S3DVertex vertices.
-// not yet 32bit
 IMesh* CMeshManipulator::createMeshWith1TCoords(IMesh* mesh) const
 {
 	if (!mesh)
@@ -1448,18 +1958,22 @@ IMesh* CMeshManipulator::createMeshWith1TCoords(IMesh* mesh) const
 	{
 		IMeshBuffer* original = mesh->getMeshBuffer(b);
 		const u32 idxCnt = original->getIndexCount();
-		const u16* idx = original->getIndices();
+		core::array<u32> idx;
+		getIndices(original, idx);
 
-		SMeshBuffer* buffer = new SMeshBuffer();
-		buffer->Material = original->getMaterial();
-		buffer->Vertices.reallocate(idxCnt);
-		buffer->Indices.reallocate(idxCnt);
+		core::array<video::S3DVertex> vertices;
+		core::array<u32> indices;
+		vertices.reallocate(idxCnt);
+		indices.reallocate(idxCnt);
 
-		core::map<video::S3DVertex, int> vertMap;
+		typedef core::hashmap<video::S3DVertex, int, core::hash_bytes<video::S3DVertex>, core::equal_bytes<video::S3DVertex> > VertexMap;
+		VertexMap vertMap;
+		vertMap.reserve(idxCnt);
 		int vertLocation;
 
 		// copy vertices
 		const video::E_VERTEX_TYPE vType = original->getVertexType();
+		const video::SVertexQuantization quantization = original->getVertexQuantization();
 		video::S3DVertex vNew;
 		for (u32 i=0; i<idxCnt; ++i)
 		{
@@ -1488,22 +2002,32 @@ IMesh* CMeshManipulator::createMeshWith1TCoords(IMesh* mesh) const
 							v[idx[i]].Pos, v[idx[i]].Normal, v[idx[i]].Color, v[idx[i]].TCoords);
 				}
 				break;
+			case video::EVT_QUANTIZED:
+			case video::EVT_QUANTIZED_TANGENTS:
+				{
+					const u32 pitch = video::getVertexPitchFromType(vType);
+					const video::S3DVertexQuantized* v = (const video::S3DVertexQuantized*)
+						((const u8*)original->getVertices() + idx[i]*pitch);
+					vNew = v->get(quantization);
+				}
+				break;
 			}
-			core::map<video::S3DVertex, int>::Node* n = vertMap.find(vNew);
+			VertexMap::Node* n = vertMap.find(vNew);
 			if (n)
 			{
 				vertLocation = n->getValue();
 			}
 			else
 			{
-				vertLocation = buffer->Vertices.size();
-				buffer->Vertices.push_back(vNew);
+				vertLocation = vertices.size();
+				vertices.push_back(vNew);
 				vertMap.insert(vNew, vertLocation);
 			}
 
 			// create new indices
-			buffer->Indices.push_back(vertLocation);
+			indices.push_back(vertLocation);
 		}
+		IMeshBuffer* buffer = createMeshBuffer(original, vertices, indices);
 		buffer->recalculateBoundingBox();
 		// add new buffer
 		clone->addMeshBuffer(buffer);
@@ -1714,6 +2238,54 @@ private:
 
 } // end anonymous namespace
 
+namespace
+{
+
+// Size of the FIFO cache used to find the clusters for the overdraw optimization
+const u32 OverdrawCacheSize = 16;
+
+// Creates a mesh buffer sorted for the vertex cache, overdraw and vertex fetching
+template <class T>
+IMeshBuffer* createOptimizedMeshBuffer(const IMeshBuffer* mb, CMeshOptimizer& optimizer, f32 overdrawThreshold)
+{
+	const T* v = (const T*)mb->getVertices();
+	const u32 vertexCount = mb->getVertexCount();
+	u32 i;
+
+	core::array<u32> indices;
+	getIndices(mb, indices);
+
+	if (mb->getPrimitiveType() == EPT_TRIANGLES)
+	{
+		// incomplete triangles would shift all following ones
+		indices.set_used(indices.size() - indices.size()%3);
+
+		optimizer.optimizeVertexCache(indices, vertexCount);
+		if (overdrawThreshold >= 1.f)
+		{
+			core::array<core::vector3df> positions;
+			positions.set_used(vertexCount);
+			for (i=0; i<vertexCount; ++i)
+				positions[i] = v[i].Pos;
+			optimizer.optimizeOverdraw(indices, positions, overdrawThreshold, OverdrawCacheSize);
+		}
+	}
+
+	core::array<u32> remap;
+	optimizer.optimizeVertexFetch(indices, vertexCount, remap);
+
+	core::array<T> vertices;
+	vertices.set_used(remap.size());
+	for (i=0; i<remap.size(); ++i)
+		vertices[i] = v[remap[i]];
+
+	IMeshBuffer* buffer = createMeshBuffer(mb, vertices, indices);
+	buffer->recalculateBoundingBox();
+	return buffer;
+}
+} // end anonymous namespace
+
+
 /**
 Vertex cache optimization according to the Forsyth paper:
 http://home.comcast.net/~tom_forsyth/papers/fast_vert_cache_opt.html
@@ -1737,7 +2309,34 @@ IMesh* CMeshManipulator::createForsythOptimizedMesh(const IMesh *mesh) const
 
 		if (mb->getIndexType() != video::EIT_16BIT)
 		{
-			os::Printer::log("Cannot optimize a mesh with 32bit indices", ELL_ERROR);
+			// the same algorithm without the 16 bit limits
+			CMeshOptimizer optimizer;
+			IMeshBuffer* buffer = 0;
+			switch(mb->getVertexType())
+			{
+			case video::EVT_STANDARD:
+				buffer = createOptimizedMeshBuffer<video::S3DVertex>(mb, optimizer, 0.f);
+				break;
+			case video::EVT_2TCOORDS:
+				buffer = createOptimizedMeshBuffer<video::S3DVertex2TCoords>(mb, optimizer, 0.f);
+				break;
+			case video::EVT_TANGENTS:
+				buffer = createOptimizedMeshBuffer<video::S3DVertexTangents>(mb, optimizer, 0.f);
+				break;
+			default:
+				break;
+			}
+			if (buffer)
+			{
+				newmesh->addMeshBuffer(buffer);
+				buffer->drop();
+			}
+			continue;
+		}
+
+		if (video::isQuantizedVertexType(mb->getVertexType()))
+		{
+			os::Printer::log("Cannot optimize a mesh with quantized vertices", ELL_ERROR);
 			newmesh->drop();
 			return 0;
 		}
@@ -1808,8 +2407,10 @@ IMesh* CMeshManipulator::createForsythOptimizedMesh(const IMesh *mesh) const
 				buf->Vertices.reallocate(vcount);
 				buf->Indices.reallocate(icount);
 
-				core::map<const video::S3DVertex, const u16> sind; // search index for fast operation
-				typedef core::map<const video::S3DVertex, const u16>::Node snode;
+				typedef core::hashmap<video::S3DVertex, u16, core::hash_bytes<video::S3DVertex>, core::equal_bytes<video::S3DVertex> > SearchIndex;
+				SearchIndex sind; // search index for fast operation
+				typedef SearchIndex::Node snode;
+				sind.reserve(vcount);
 
 				// Main algorithm
 				u32 highest = 0;
@@ -1920,8 +2521,10 @@ IMesh* CMeshManipulator::createForsythOptimizedMesh(const IMesh *mesh) const
 				buf->Vertices.reallocate(vcount);
 				buf->Indices.reallocate(icount);
 
-				core::map<const video::S3DVertex2TCoords, const u16> sind; // search index for fast operation
-				typedef core::map<const video::S3DVertex2TCoords, const u16>::Node snode;
+				typedef core::hashmap<video::S3DVertex2TCoords, u16, core::hash_bytes<video::S3DVertex2TCoords>, core::equal_bytes<video::S3DVertex2TCoords> > SearchIndex;
+				SearchIndex sind; // search index for fast operation
+				typedef SearchIndex::Node snode;
+				sind.reserve(vcount);
 
 				// Main algorithm
 				u32 highest = 0;
@@ -2033,8 +2636,10 @@ IMesh* CMeshManipulator::createForsythOptimizedMesh(const IMesh *mesh) const
 				buf->Vertices.reallocate(vcount);
 				buf->Indices.reallocate(icount);
 
-				core::map<const video::S3DVertexTangents, const u16> sind; // search index for fast operation
-				typedef core::map<const video::S3DVertexTangents, const u16>::Node snode;
+				typedef core::hashmap<video::S3DVertexTangents, u16, core::hash_bytes<video::S3DVertexTangents>, core::equal_bytes<video::S3DVertexTangents> > SearchIndex;
+				SearchIndex sind; // search index for fast operation
+				typedef SearchIndex::Node snode;
+				sind.reserve(vcount);
 
 				// Main algorithm
 				u32 highest = 0;
@@ -2135,6 +2740,8 @@ IMesh* CMeshManipulator::createForsythOptimizedMesh(const IMesh *mesh) const
 				buf->drop();
 			}
 			break;
+			default:
+			break;
 		}
 
 		delete [] vc;
@@ -2145,6 +2752,241 @@ IMesh* CMeshManipulator::createForsythOptimizedMesh(const IMesh *mesh) const
 	return newmesh;
 }
 
+
+//! Creates a copy of a mesh optimized for vertex processing, overdraw and vertex fetching.
+IMesh* CMeshManipulator::createOptimizedMesh(const IMesh* mesh, f32 overdrawThreshold) const
+{
+	if (!mesh)
+		return 0;
+
+	SMesh* clone = new SMesh();
+	CMeshOptimizer optimizer;
+
+	for (u32 b=0; b<mesh->getMeshBufferCount(); ++b)
+	{
+		const IMeshBuffer* const mb = mesh->getMeshBuffer(b);
+		IMeshBuffer* buffer = 0;
+
+		switch(mb->getVertexType())
+		{
+		case video::EVT_STANDARD:
+			buffer = createOptimizedMeshBuffer<video::S3DVertex>(mb, optimizer, overdrawThreshold);
+			break;
+		case video::EVT_2TCOORDS:
+			buffer = createOptimizedMeshBuffer<video::S3DVertex2TCoords>(mb, optimizer, overdrawThreshold);
+			break;
+		case video::EVT_TANGENTS:
+			buffer = createOptimizedMeshBuffer<video::S3DVertexTangents>(mb, optimizer, overdrawThreshold);
+			break;
+		default:
+			os::Printer::log("Cannot create optimized mesh, vertex type unsupported", ELL_ERROR);
+			break;
+		}
+
+		if (buffer)
+		{
+			clone->addMeshBuffer(buffer);
+			buffer->drop();
+		}
+	}
+
+	clone->recalculateBoundingBox();
+	return clone;
+}
+
+
+//! Simulates a FIFO post-transform vertex cache for all mesh buffers of a mesh.
+SVertexCacheStatistics CMeshManipulator::getVertexCacheStatistics(const IMesh* mesh, u32 cacheSize) const
+{
+	SVertexCacheStatistics stats;
+	stats.TransformedVertices = 0;
+	stats.Triangles = 0;
+	stats.Vertices = 0;
+
+	if (mesh)
+	{
+		CMeshOptimizer optimizer;
+		core::array<u32> indices;
+		for (u32 b=0; b<mesh->getMeshBufferCount(); ++b)
+		{
+			const IMeshBuffer* const mb = mesh->getMeshBuffer(b);
+			if (mb->getPrimitiveType() != EPT_TRIANGLES)
+				continue;
+
+			getIndices(mb, indices);
+			u32 vertices;
+			stats.TransformedVertices += optimizer.analyzeVertexCache(indices, mb->getVertexCount(), cacheSize, vertices);
+			stats.Triangles += indices.size()/3;
+			stats.Vertices += vertices;
+		}
+	}
+
+	stats.ACMR = stats.Triangles ? (f32)stats.TransformedVertices / stats.Triangles : 0.f;
+	stats.ATVR = stats.Vertices ? (f32)stats.TransformedVertices / stats.Vertices : 0.f;
+	return stats;
+}
+
+
+namespace
+{
+// Creates a mesh buffer with the triangles sorted into clusters and the vertices in order of use
+template <class T>
+IMeshBuffer* createClusteredMeshBuffer(const IMeshBuffer* mb, CMeshOptimizer& optimizer,
+	u32 maxVertices, u32 maxTriangles, core::array<SMeshCluster>& clusters)
+{
+	const T* v = (const T*)mb->getVertices();
+	const u32 vertexCount = mb->getVertexCount();
+	u32 i;
+
+	core::array<u32> indices;
+	getIndices(mb, indices);
+	indices.set_used(indices.size() - indices.size()%3);
+
+	// the cache order keeps the seeds of the clusters close together
+	optimizer.optimizeVertexCache(indices, vertexCount);
+
+	core::array<core::vector3df> positions;
+	positions.set_used(vertexCount);
+	for (i=0; i<vertexCount; ++i)
+		positions[i] = v[i].Pos;
+	optimizer.buildClusters(indices, positions, maxVertices, maxTriangles, clusters);
+
+	core::array<u32> remap;
+	optimizer.optimizeVertexFetch(indices, vertexCount, remap);
+
+	core::array<T> vertices;
+	vertices.set_used(remap.size());
+	for (i=0; i<remap.size(); ++i)
+		vertices[i] = v[remap[i]];
+
+	IMeshBuffer* buffer = createMeshBuffer(mb, vertices, indices);
+	buffer->recalculateBoundingBox();
+	return buffer;
+}
+} // end anonymous namespace
+
+
+//! Creates a copy of a mesh with the triangles of each mesh buffer grouped into small clusters.
+IMesh* CMeshManipulator::createClusteredMesh(const IMesh* mesh, core::array<SMeshCluster>& clusters,
+		u32 maxVertices, u32 maxTriangles) const
+{
+	clusters.set_used(0);
+	if (!mesh)
+		return 0;
+
+	SMesh* clone = new SMesh();
+	CMeshOptimizer optimizer;
+
+	for (u32 b=0; b<mesh->getMeshBufferCount(); ++b)
+	{
+		IMeshBuffer* const mb = mesh->getMeshBuffer(b);
+		const u32 firstCluster = clusters.size();
+		IMeshBuffer* buffer = 0;
+
+		if (mb->getPrimitiveType() == EPT_TRIANGLES)
+		{
+			switch(mb->getVertexType())
+			{
+			case video::EVT_STANDARD:
+				buffer = createClusteredMeshBuffer<video::S3DVertex>(mb, optimizer, maxVertices, maxTriangles, clusters);
+				break;
+			case video::EVT_2TCOORDS:
+				buffer = createClusteredMeshBuffer<video::S3DVertex2TCoords>(mb, optimizer, maxVertices, maxTriangles, clusters);
+				break;
+			case video::EVT_TANGENTS:
+				buffer = createClusteredMeshBuffer<video::S3DVertexTangents>(mb, optimizer, maxVertices, maxTriangles, clusters);
+				break;
+			default:
+				break;
+			}
+		}
+
+		if (buffer)
+		{
+			for (u32 i=firstCluster; i<clusters.size(); ++i)
+				clusters[i].MeshBuffer = clone->getMeshBufferCount();
+			clone->addMeshBuffer(buffer);
+			buffer->drop();
+		}
+		else
+			clone->addMeshBuffer(mb);
+	}
+
+	clone->recalculateBoundingBox();
+	return clone;
+}
+
+
+namespace
+{
+// Creates a mesh buffer with vertices of type Q compressed from vertices of type T
+template <class T, class Q>
+IMeshBuffer* createQuantizedMeshBuffer(const IMeshBuffer* mb)
+{
+	const T* v = (const T*)mb->getVertices();
+	const u32 vertexCount = mb->getVertexCount();
+	u32 i;
+
+	// the stored bounding box might be outdated
+	core::aabbox3df box(0,0,0,0,0,0);
+	if (vertexCount)
+	{
+		box.reset(v[0].Pos);
+		for (i=1; i<vertexCount; ++i)
+			box.addInternalPoint(v[i].Pos);
+	}
+
+	CMeshBuffer<Q>* buffer = new CMeshBuffer<Q>();
+	buffer->Material = mb->getMaterial();
+	buffer->Quantization = video::SVertexQuantization(box);
+	buffer->Vertices.set_used(vertexCount);
+	for (i=0; i<vertexCount; ++i)
+		buffer->Vertices[i].set(v[i], buffer->Quantization);
+	buffer->Indices.set_used(mb->getIndexCount());
+	for (i=0; i<mb->getIndexCount(); ++i)
+		buffer->Indices[i] = mb->getIndices()[i];
+
+	buffer->setPrimitiveType(mb->getPrimitiveType());
+	buffer->setHardwareMappingHint(mb->getHardwareMappingHint_Vertex(), EBT_VERTEX);
+	buffer->setHardwareMappingHint(mb->getHardwareMappingHint_Index(), EBT_INDEX);
+	buffer->recalculateBoundingBox();
+	return buffer;
+}
+} // end anonymous namespace
+
+
+//! Creates a copy of a mesh with compressed vertices.
+IMesh* CMeshManipulator::createMeshQuantized(const IMesh* mesh) const
+{
+	if (!mesh)
+		return 0;
+
+	SMesh* clone = new SMesh();
+
+	for (u32 b=0; b<mesh->getMeshBufferCount(); ++b)
+	{
+		IMeshBuffer* const mb = mesh->getMeshBuffer(b);
+
+		if (mb->getIndexType() == video::EIT_16BIT && mb->getVertexType() == video::EVT_STANDARD)
+		{
+			IMeshBuffer* buffer = createQuantizedMeshBuffer<video::S3DVertex, video::S3DVertexQuantized>(mb);
+			clone->addMeshBuffer(buffer);
+			buffer->drop();
+		}
+		else if (mb->getIndexType() == video::EIT_16BIT && mb->getVertexType() == video::EVT_TANGENTS)
+		{
+			IMeshBuffer* buffer = createQuantizedMeshBuffer<video::S3DVertexTangents, video::S3DVertexQuantizedTangents>(mb);
+			clone->addMeshBuffer(buffer);
+			buffer->drop();
+		}
+		else
+			clone->addMeshBuffer(mb);
+	}
+
+	clone->recalculateBoundingBox();
+	return clone;
+}
+
 } // end namespace scene
 } // end namespace irr
 
@@ -35,6 +35,14 @@ public:
 	\param smooth: Whether to use smoothed normals. */
 	virtual void recalculateNormals(IMeshBuffer* buffer, bool smooth = false, bool angleWeighted = false) const _IRR_OVERRIDE_;
 
+	//! Recalculates smooth normals, also across vertices which only share their position.
+	virtual void recalculateNormalsWelded(IMeshBuffer* buffer, f32 maxAngle=180.f,
+		bool angleWeighted=true, f32 tolerance=core::ROUNDING_ERROR_f32, u32 threadCount=1) const _IRR_OVERRIDE_;
+
+	//! Recalculates smooth normals of all mesh buffers, also across vertices which only share their position.
+	virtual void recalculateNormalsWelded(IMesh* mesh, f32 maxAngle=180.f,
+		bool angleWeighted=true, f32 tolerance=core::ROUNDING_ERROR_f32, u32 threadCount=1) const _IRR_OVERRIDE_;
+
 	//! Clones a static IMesh into a modifiable SMesh.
 	virtual SMesh* createMeshCopy(scene::IMesh* mesh) const _IRR_OVERRIDE_;
 
@@ -75,6 +83,9 @@ public:
 	//! Creates a copy of the mesh, which will have all duplicated vertices removed, i.e. maximal amount of vertices are shared via indexing.
 	virtual IMesh* createMeshWelded(IMesh *mesh, f32 tolerance=core::ROUNDING_ERROR_f32) const _IRR_OVERRIDE_;
 
+	//! Creates a copy of the mesh with fewer triangles, using quadric error metrics.
+	virtual IMesh* createMeshSimplified(IMesh* mesh, u32 targetTriangleCount, f32 maxError=1.f) const _IRR_OVERRIDE_;
+
 	//! Returns amount of polygons in mesh.
 	virtual s32 getPolyCount(scene::IMesh* mesh) const _IRR_OVERRIDE_;
 
@@ -87,6 +98,19 @@ public:
 	//! create a mesh optimized for the vertex cache
 	virtual IMesh* createForsythOptimizedMesh(const scene::IMesh *mesh) const _IRR_OVERRIDE_;
 
+	//! Creates a copy of a mesh optimized for vertex processing, overdraw and vertex fetching.
+	virtual IMesh* createOptimizedMesh(const IMesh* mesh, f32 overdrawThreshold=1.05f) const _IRR_OVERRIDE_;
+
+	//! Simulates a FIFO post-transform vertex cache for all mesh buffers of a mesh.
+	virtual SVertexCacheStatistics getVertexCacheStatistics(const IMesh* mesh, u32 cacheSize=16) const _IRR_OVERRIDE_;
+
+	//! Creates a copy of a mesh with the triangles of each mesh buffer grouped into small clusters.
+	virtual IMesh* createClusteredMesh(const IMesh* mesh, core::array<SMeshCluster>& clusters,
+		u32 maxVertices=64, u32 maxTriangles=124) const _IRR_OVERRIDE_;
+
+	//! Creates a copy of a mesh with compressed vertices.
+	virtual IMesh* createMeshQuantized(const IMesh* mesh) const _IRR_OVERRIDE_;
+
 	//! Optimizes the mesh using an algorithm tuned for heightmaps
 	virtual void heightmapOptimizeMesh(IMesh * const m, const f32 tolerance = core::ROUNDING_ERROR_f32) const _IRR_OVERRIDE_;
 
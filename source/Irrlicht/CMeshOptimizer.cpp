@@ -0,0 +1,549 @@
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#include "CMeshOptimizer.h"
+#include "aabbox3d.h"
+
+namespace irr
+{
+namespace scene
+{
+
+namespace
+{
+	//! size of the LRU cache assumed by optimizeVertexCache
+	const u32 MaxCacheSize = 32;
+
+	struct SCluster
+	{
+		u32 First;
+		u32 End;
+		f32 SortKey;
+
+		// clusters facing away from the center first, equal ones in original order
+		bool operator<(const SCluster& other) const
+		{
+			return SortKey > other.SortKey || (SortKey == other.SortKey && First < other.First);
+		}
+	};
+}
+
+
+//! Fills TriangleFirst and Triangles, active receives the triangle count of each vertex
+void CMeshOptimizer::buildTriangleLists(const core::array<u32>& indices, u32 vertexCount, core::array<u32>& active)
+{
+	const u32 triangleCount = indices.size()/3;
+	u32 i;
+	active.set_used(vertexCount);
+	for (i=0; i<vertexCount; ++i)
+		active[i] = 0;
+	for (i=0; i<triangleCount*3; ++i)
+		++active[indices[i]];
+
+	TriangleFirst.set_used(vertexCount+1);
+	u32 sum = 0;
+	for (i=0; i<vertexCount; ++i)
+	{
+		TriangleFirst[i] = sum;
+		sum += active[i];
+	}
+	TriangleFirst[vertexCount] = sum;
+
+	core::array<u32> fill;
+	fill.set_used(vertexCount);
+	for (i=0; i<vertexCount; ++i)
+		fill[i] = TriangleFirst[i];
+	Triangles.set_used(sum);
+	for (i=0; i<triangleCount*3; ++i)
+		Triangles[fill[indices[i]]++] = i/3;
+}
+
+
+//! Score of a vertex by its position in the simulated LRU cache and its remaining triangles
+f32 CMeshOptimizer::getVertexScore(s32 cachePosition, u32 activeTriangles) const
+{
+	if (!activeTriangles)
+		return -1.f;
+
+	f32 score = 0.f;
+	if (cachePosition >= 0)
+	{
+		// the vertices of the last triangle get a fixed score, so it's not
+		// preferred to use them again immediately
+		if (cachePosition < 3)
+			score = 0.75f;
+		else
+			score = powf(1.f - (cachePosition-3) / (f32)(MaxCacheSize-3), 1.5f);
+	}
+
+	// vertices with few remaining triangles are finished first
+	score += 2.f * core::reciprocal_squareroot((f32)activeTriangles);
+	return score;
+}
+
+
+//! Sorts the triangles for the post-transform vertex cache.
+void CMeshOptimizer::optimizeVertexCache(core::array<u32>& indices, u32 vertexCount)
+{
+	const u32 triangleCount = indices.size()/3;
+	if (!triangleCount)
+		return;
+
+	u32 i;
+	core::array<u32> active;
+	buildTriangleLists(indices, vertexCount, active);
+
+	core::array<s32> cachePosition;
+	core::array<f32> vertexScore;
+	cachePosition.set_used(vertexCount);
+	vertexScore.set_used(vertexCount);
+	for (i=0; i<vertexCount; ++i)
+	{
+		cachePosition[i] = -1;
+		vertexScore[i] = getVertexScore(-1, active[i]);
+	}
+
+	core::array<f32> triangleScore;
+	core::array<u8> emitted;
+	triangleScore.set_used(triangleCount);
+	emitted.set_used(triangleCount);
+	for (i=0; i<triangleCount; ++i)
+	{
+		triangleScore[i] = vertexScore[indices[i*3]] + vertexScore[indices[i*3+1]] + vertexScore[indices[i*3+2]];
+		emitted[i] = 0;
+	}
+
+	core::array<u32> result;
+	result.set_used(triangleCount*3);
+
+	u32 cache[MaxCacheSize+3];
+	u32 newCache[MaxCacheSize+3];
+	u32 cacheSize = 0;
+
+	// the best triangle to start with, later only triangles around cached vertices are checked
+	s32 best = 0;
+	for (i=1; i<triangleCount; ++i)
+	{
+		if (triangleScore[i] > triangleScore[best])
+			best = i;
+	}
+
+	u32 nextUnemitted = 0;
+	for (u32 t=0; t<triangleCount; ++t)
+	{
+		if (best < 0)
+		{
+			// nothing around the cache left, continue with the next triangle in input order
+			while (emitted[nextUnemitted])
+				++nextUnemitted;
+			best = nextUnemitted;
+		}
+
+		const u32* tri = &indices[best*3];
+		result[t*3] = tri[0];
+		result[t*3+1] = tri[1];
+		result[t*3+2] = tri[2];
+		emitted[best] = 1;
+
+		// remove the triangle from the lists of its vertices
+		u32 k;
+		for (k=0; k<3; ++k)
+		{
+			const u32 v = tri[k];
+			const u32 first = TriangleFirst[v];
+			const u32 last = first + active[v] - 1;
+			for (u32 j=first; j<=last; ++j)
+			{
+				if (Triangles[j] == (u32)best)
+				{
+					Triangles[j] = Triangles[last];
+					Triangles[last] = best;
+					break;
+				}
+			}
+			--active[v];
+		}
+
+		// the vertices of the triangle move to the front of the cache
+		u32 newSize = 0;
+		for (k=0; k<3; ++k)
+			newCache[newSize++] = tri[k];
+		for (k=0; k<cacheSize; ++k)
+		{
+			const u32 v = cache[k];
+			if (v != tri[0] && v != tri[1] && v != tri[2])
+				newCache[newSize++] = v;
+		}
+
+		// update the scores of all vertices in the cache, including those which just fell out
+		best = -1;
+		f32 bestScore = -1.f;
+		for (k=0; k<newSize; ++k)
+		{
+			const u32 v = newCache[k];
+			cachePosition[v] = k < MaxCacheSize ? (s32)k : -1;
+			const f32 score = getVertexScore(cachePosition[v], active[v]);
+			const f32 delta = score - vertexScore[v];
+			vertexScore[v] = score;
+
+			for (u32 j=TriangleFirst[v]; j<TriangleFirst[v]+active[v]; ++j)
+			{
+				const u32 other = Triangles[j];
+				triangleScore[other] += delta;
+				if (triangleScore[other] > bestScore)
+				{
+					best = other;
+					bestScore = triangleScore[other];
+				}
+			}
+		}
+
+		cacheSize = core::min_(newSize, MaxCacheSize);
+		for (k=0; k<cacheSize; ++k)
+			cache[k] = newCache[k];
+	}
+
+	indices.swap(result);
+}
+
+
+//! Adds a triangle to the FIFO cache, returns the number of misses
+u32 CMeshOptimizer::updateCache(u32 a, u32 b, u32 c, u32 cacheSize)
+{
+	u32 misses = 0;
+	const u32 v[3] = { a, b, c };
+	for (u32 k=0; k<3; ++k)
+	{
+		if (Timestamp - CacheTimestamps[v[k]] > cacheSize)
+		{
+			CacheTimestamps[v[k]] = Timestamp++;
+			++misses;
+		}
+	}
+	return misses;
+}
+
+
+//! Sorts clusters of triangles to reduce overdraw.
+void CMeshOptimizer::optimizeOverdraw(core::array<u32>& indices, const core::array<core::vector3df>& positions,
+		f32 threshold, u32 cacheSize)
+{
+	const u32 triangleCount = indices.size()/3;
+	if (!triangleCount)
+		return;
+
+	u32 i;
+	CacheTimestamps.set_used(positions.size());
+	for (i=0; i<CacheTimestamps.size(); ++i)
+		CacheTimestamps[i] = 0;
+	Timestamp = cacheSize+1;
+
+	// hard boundaries where the cache starts from scratch anyway
+	core::array<u32> hard;
+	for (i=0; i<triangleCount; ++i)
+	{
+		const u32 misses = updateCache(indices[i*3], indices[i*3+1], indices[i*3+2], cacheSize);
+		if (i == 0 || misses == 3)
+			hard.push_back(i);
+	}
+	hard.push_back(triangleCount);
+
+	// soft boundaries inside of them, where starting a new cluster costs
+	// less than threshold times the ACMR of the hard cluster
+	core::array<SCluster> clusters;
+	for (u32 h=0; h+1<hard.size(); ++h)
+	{
+		const u32 start = hard[h];
+		const u32 end = hard[h+1];
+
+		Timestamp += cacheSize+1;
+		u32 misses = 0;
+		for (i=start; i<end; ++i)
+			misses += updateCache(indices[i*3], indices[i*3+1], indices[i*3+2], cacheSize);
+		const f32 clusterThreshold = threshold * misses / (f32)(end-start);
+
+		SCluster cluster;
+		cluster.First = start;
+		Timestamp += cacheSize+1;
+		u32 runningMisses = 0;
+		u32 runningTriangles = 0;
+		for (i=start; i<end; ++i)
+		{
+			runningMisses += updateCache(indices[i*3], indices[i*3+1], indices[i*3+2], cacheSize);
+			++runningTriangles;
+
+			if (i+1 < end && runningMisses <= clusterThreshold * runningTriangles)
+			{
+				cluster.End = i+1;
+				clusters.push_back(cluster);
+				cluster.First = i+1;
+				Timestamp += cacheSize+1;
+				runningMisses = 0;
+				runningTriangles = 0;
+			}
+		}
+		cluster.End = end;
+		clusters.push_back(cluster);
+	}
+
+	// center of the mesh
+	core::vector3df meshCenter;
+	for (i=0; i<triangleCount*3; ++i)
+		meshCenter += positions[indices[i]];
+	meshCenter /= (f32)(triangleCount*3);
+
+	for (u32 c=0; c<clusters.size(); ++c)
+	{
+		SCluster& cluster = clusters[c];
+
+		// area weighted center and normal of the cluster
+		core::vector3df center;
+		core::vector3df normal;
+		f32 area = 0.f;
+		for (i=cluster.First; i<cluster.End; ++i)
+		{
+			const core::vector3df& p0 = positions[indices[i*3]];
+			const core::vector3df& p1 = positions[indices[i*3+1]];
+			const core::vector3df& p2 = positions[indices[i*3+2]];
+			const core::vector3df n = (p1-p0).crossProduct(p2-p0);
+			const f32 triangleArea = n.getLength();
+			center += (p0+p1+p2) * (triangleArea / 3.f);
+			normal += n;
+			area += triangleArea;
+		}
+		if (area > 0.f)
+			center /= area;
+		normal.normalize();
+
+		cluster.SortKey = (center - meshCenter).dotProduct(normal);
+	}
+
+	clusters.sort();
+
+	core::array<u32> result;
+	result.reallocate(indices.size());
+	for (u32 c=0; c<clusters.size(); ++c)
+	{
+		for (i=clusters[c].First*3; i<clusters[c].End*3; ++i)
+			result.push_back(indices[i]);
+	}
+	indices.swap(result);
+}
+
+
+//! Numbers the vertices in order of their first use.
+void CMeshOptimizer::optimizeVertexFetch(core::array<u32>& indices, u32 vertexCount, core::array<u32>& remap)
+{
+	const u32 unused = 0xffffffff;
+	core::array<u32> newIndex;
+	newIndex.set_used(vertexCount);
+	u32 i;
+	for (i=0; i<vertexCount; ++i)
+		newIndex[i] = unused;
+
+	remap.set_used(0);
+	for (i=0; i<indices.size(); ++i)
+	{
+		u32& index = newIndex[indices[i]];
+		if (index == unused)
+		{
+			index = remap.size();
+			remap.push_back(indices[i]);
+		}
+		indices[i] = index;
+	}
+}
+
+
+//! Simulates a FIFO post-transform cache.
+u32 CMeshOptimizer::analyzeVertexCache(const core::array<u32>& indices, u32 vertexCount, u32 cacheSize,
+		u32& referencedVertices)
+{
+	u32 i;
+	CacheTimestamps.set_used(vertexCount);
+	for (i=0; i<vertexCount; ++i)
+		CacheTimestamps[i] = 0;
+	Timestamp = cacheSize+1;
+
+	u32 misses = 0;
+	for (i=0; i+2<indices.size(); i+=3)
+		misses += updateCache(indices[i], indices[i+1], indices[i+2], cacheSize);
+
+	referencedVertices = 0;
+	for (i=0; i<vertexCount; ++i)
+	{
+		if (CacheTimestamps[i])
+			++referencedVertices;
+	}
+	return misses;
+}
+
+//! Groups the triangles into clusters of neighboring triangles.
+void CMeshOptimizer::buildClusters(core::array<u32>& indices, const core::array<core::vector3df>& positions,
+		u32 maxVertices, u32 maxTriangles, core::array<SMeshCluster>& clusters)
+{
+	const u32 triangleCount = indices.size()/3;
+	const u32 vertexCount = positions.size();
+	if (!triangleCount)
+		return;
+	if (maxVertices < 3)
+		maxVertices = 3;
+	if (maxTriangles < 1)
+		maxTriangles = 1;
+
+	u32 i;
+	core::array<u32> active;
+	buildTriangleLists(indices, vertexCount, active);
+
+	core::array<core::vector3df> normals;
+	normals.set_used(triangleCount);
+	for (i=0; i<triangleCount; ++i)
+	{
+		// slivers are treated as degenerated, their normals are too inaccurate
+		const core::vector3df& p0 = positions[indices[i*3]];
+		const core::vector3df edge1 = positions[indices[i*3+1]] - p0;
+		const core::vector3df edge2 = positions[indices[i*3+2]] - p0;
+		normals[i] = edge1.crossProduct(edge2);
+		const f32 edgeSQ = edge1.getLengthSQ() + edge2.getLengthSQ();
+		if (normals[i].getLengthSQ() > 1e-8f * edgeSQ * edgeSQ)
+			normals[i].normalize();
+		else
+			normals[i].set(0.f, 0.f, 0.f);
+	}
+
+	// vertices of the current cluster are marked with their position in clusterVertices
+	const u32 unused = 0xffffffff;
+	core::array<u32> mark;
+	mark.set_used(vertexCount);
+	for (i=0; i<vertexCount; ++i)
+		mark[i] = unused;
+
+	core::array<u8> emitted;
+	emitted.set_used(triangleCount);
+	for (i=0; i<triangleCount; ++i)
+		emitted[i] = 0;
+
+	core::array<u32> result;
+	result.reallocate(triangleCount*3);
+	core::array<u32> clusterVertices;
+	core::array<u32> clusterTriangles;
+	u32 seed = 0;
+
+	while (result.size() < triangleCount*3)
+	{
+		while (emitted[seed])
+			++seed;
+
+		clusterVertices.set_used(0);
+		clusterTriangles.set_used(0);
+		core::vector3df normalSum;
+		u32 triangle = seed;
+
+		do
+		{
+			// add the triangle
+			emitted[triangle] = 1;
+			clusterTriangles.push_back(triangle);
+			normalSum += normals[triangle];
+			for (u32 k=0; k<3; ++k)
+			{
+				const u32 v = indices[triangle*3+k];
+				result.push_back(v);
+				if (mark[v] == unused)
+				{
+					mark[v] = clusterVertices.size();
+					clusterVertices.push_back(v);
+				}
+			}
+
+			if (clusterTriangles.size() >= maxTriangles)
+				break;
+
+			// find the adjacent triangle with the fewest new vertices,
+			// and of those the one closest to the average normal
+			core::vector3df axis(normalSum);
+			axis.normalize();
+			triangle = unused;
+			u32 bestNew = 4;
+			f32 bestDot = -2.f;
+			for (u32 c=0; c<clusterVertices.size(); ++c)
+			{
+				const u32 v = clusterVertices[c];
+				for (u32 t=TriangleFirst[v]; t<TriangleFirst[v+1]; ++t)
+				{
+					const u32 candidate = Triangles[t];
+					if (emitted[candidate])
+						continue;
+
+					const u32 newVertices = (mark[indices[candidate*3]] == unused ? 1 : 0) +
+						(mark[indices[candidate*3+1]] == unused ? 1 : 0) +
+						(mark[indices[candidate*3+2]] == unused ? 1 : 0);
+					if (clusterVertices.size() + newVertices > maxVertices || newVertices > bestNew)
+						continue;
+
+					const f32 dot = normals[candidate].dotProduct(axis);
+					if (newVertices < bestNew || dot > bestDot)
+					{
+						triangle = candidate;
+						bestNew = newVertices;
+						bestDot = dot;
+					}
+				}
+			}
+		} while (triangle != unused);
+
+		// bounding sphere around the center of the bounding box
+		core::aabbox3df box(positions[clusterVertices[0]]);
+		for (i=1; i<clusterVertices.size(); ++i)
+			box.addInternalPoint(positions[clusterVertices[i]]);
+
+		SMeshCluster cluster;
+		cluster.MeshBuffer = 0;
+		cluster.FirstIndex = result.size() - clusterTriangles.size()*3;
+		cluster.TriangleCount = clusterTriangles.size();
+		cluster.VertexCount = clusterVertices.size();
+		cluster.Center = box.getCenter();
+		f32 radiusSQ = 0.f;
+		for (i=0; i<clusterVertices.size(); ++i)
+			radiusSQ = core::max_(radiusSQ, (f32)positions[clusterVertices[i]].getDistanceFromSQ(cluster.Center));
+		cluster.Radius = sqrtf(radiusSQ);
+
+		// normal cone, degenerated triangles are invisible and don't count
+		cluster.ConeAxis = normalSum;
+		cluster.ConeAxis.normalize();
+		f32 minDot = 1.f;
+		for (i=0; i<clusterTriangles.size(); ++i)
+		{
+			const core::vector3df& normal = normals[clusterTriangles[i]];
+			if (!normal.equals(core::vector3df(0.f)))
+				minDot = core::min_(minDot, normal.dotProduct(cluster.ConeAxis));
+		}
+		// with a cone wider than about 84 degrees almost nothing could be culled
+		cluster.ConeCutoff = (minDot > 0.1f) ? sqrtf(1.f - minDot*minDot) : 1.f;
+
+		// move the apex back along the axis until it's behind all triangle planes
+		f32 apexDistance = 0.f;
+		if (cluster.ConeCutoff < 1.f)
+		{
+			for (i=0; i<clusterTriangles.size(); ++i)
+			{
+				const u32 t = clusterTriangles[i];
+				const core::vector3df& normal = normals[t];
+				const f32 dn = normal.dotProduct(cluster.ConeAxis);
+				if (dn > 0.f)
+					apexDistance = core::max_(apexDistance, (cluster.Center - positions[indices[t*3]]).dotProduct(normal) / dn);
+			}
+		}
+		cluster.ConeApex = cluster.Center - cluster.ConeAxis * apexDistance;
+
+		clusters.push_back(cluster);
+
+		for (i=0; i<clusterVertices.size(); ++i)
+			mark[clusterVertices[i]] = unused;
+	}
+
+	indices.swap(result);
+}
+
+} // end namespace scene
+} // end namespace irr
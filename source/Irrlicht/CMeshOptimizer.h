@@ -0,0 +1,94 @@
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#ifndef __C_MESH_OPTIMIZER_H_INCLUDED__
+#define __C_MESH_OPTIMIZER_H_INCLUDED__
+
+#include "irrArray.h"
+#include "vector3d.h"
+#include "SMeshCluster.h"
+
+namespace irr
+{
+namespace scene
+{
+
+//! Reorders indexed triangle lists so the GPU has less work with them.
+/** The steps are meant to be used in this order:
+- optimizeVertexCache() sorts the triangles so vertices are reused while
+  they are still in the post-transform cache (Forsyth's algorithm).
+- optimizeOverdraw() splits that order into clusters which hardly lose cache
+  efficiency and draws the clusters facing away from the mesh center first,
+  as they are likely to hide the others.
+- optimizeVertexFetch() numbers the vertices in the order they are used, so
+  the vertex data is read sequentially.
+buildClusters() can be used instead of optimizeOverdraw() to group the
+triangles into small clusters which can be culled separately. */
+class CMeshOptimizer
+{
+public:
+
+	//! Sorts the triangles for the post-transform vertex cache.
+	void optimizeVertexCache(core::array<u32>& indices, u32 vertexCount);
+
+	//! Sorts clusters of triangles to reduce overdraw.
+	/** \param indices Triangles sorted by optimizeVertexCache().
+	\param positions Vertex positions.
+	\param threshold How much worse the ACMR of the result may get, 1.05 allows 5%.
+	\param cacheSize Size of the simulated FIFO cache. */
+	void optimizeOverdraw(core::array<u32>& indices, const core::array<core::vector3df>& positions,
+		f32 threshold, u32 cacheSize);
+
+	//! Numbers the vertices in order of their first use.
+	/** \param indices Indices which are renumbered.
+	\param vertexCount Number of vertices.
+	\param remap Receives the old vertex index of each new one, unused vertices are left out. */
+	void optimizeVertexFetch(core::array<u32>& indices, u32 vertexCount, core::array<u32>& remap);
+
+	//! Simulates a FIFO post-transform cache.
+	/** \param indices Triangle list.
+	\param vertexCount Number of vertices.
+	\param cacheSize Size of the simulated cache.
+	\param referencedVertices Receives the number of vertices used by the triangles.
+	\return Number of vertices which have to be transformed. */
+	u32 analyzeVertexCache(const core::array<u32>& indices, u32 vertexCount, u32 cacheSize,
+		u32& referencedVertices);
+
+	//! Groups the triangles into clusters of neighboring triangles.
+	/** Each cluster is grown from the first remaining triangle, adding the
+	adjacent triangles which need the fewest new vertices and fit best to
+	the normals of the cluster.
+	\param indices Triangle list, sorted so the triangles of each cluster
+	follow each other.
+	\param positions Vertex positions.
+	\param maxVertices Largest number of vertices in a cluster.
+	\param maxTriangles Largest number of triangles in a cluster.
+	\param clusters The clusters are appended to this array, with
+	MeshBuffer set to 0. */
+	void buildClusters(core::array<u32>& indices, const core::array<core::vector3df>& positions,
+		u32 maxVertices, u32 maxTriangles, core::array<SMeshCluster>& clusters);
+
+private:
+
+	//! Score of a vertex by its position in the simulated LRU cache and its remaining triangles
+	f32 getVertexScore(s32 cachePosition, u32 activeTriangles) const;
+
+	//! Fills TriangleFirst and Triangles, active receives the triangle count of each vertex
+	void buildTriangleLists(const core::array<u32>& indices, u32 vertexCount, core::array<u32>& active);
+
+	//! Adds a triangle to the FIFO cache, returns the number of misses
+	u32 updateCache(u32 a, u32 b, u32 c, u32 cacheSize);
+
+	//! FIFO cache simulation, a vertex is cached while Timestamp-CacheTimestamps[v] <= cache size
+	core::array<u32> CacheTimestamps;
+	u32 Timestamp;
+
+	//! triangles of each vertex, TriangleFirst has one entry more than vertices
+	core::array<u32> TriangleFirst;
+	core::array<u32> Triangles;
+};
+
+} // end namespace scene
+} // end namespace irr
+
+#endif // __C_MESH_OPTIMIZER_H_INCLUDED__
@@ -48,6 +48,13 @@ CMeshSceneNode::~CMeshSceneNode()
 //! frame
 void CMeshSceneNode::OnRegisterSceneNode()
 {
+	if (IsVisible && !MeshVisible)
+	{
+		// the mesh is drawn by another node, only the children are rendered
+		ISceneNode::OnRegisterSceneNode();
+		return;
+	}
+
 	if (IsVisible)
 	{
 		// because this node supports rendering of mixed mode meshes consisting of
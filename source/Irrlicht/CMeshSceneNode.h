@@ -54,6 +54,9 @@ namespace scene
 		//! Returns type of the scene node
 		virtual ESCENE_NODE_TYPE getType() const _IRR_OVERRIDE_ { return ESNT_MESH; }
 
+		//! Uses the transformation handling of ISceneNode
+		virtual bool hasPlainTransformation() const _IRR_OVERRIDE_ { return true; }
+
 		//! Sets a new mesh
 		virtual void setMesh(IMesh* mesh) _IRR_OVERRIDE_;
 
@@ -0,0 +1,423 @@
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#include "CMeshSimplifier.h"
+#include "irrHashMap.h"
+
+namespace irr
+{
+namespace scene
+{
+
+//! Simplifies a triangle list.
+u32 CMeshSimplifier::simplify(core::array<u32>& indices, const core::array<core::vector3df>& positions,
+		u32 targetTriangleCount, f32 maxError)
+{
+	Error = 0.f;
+	Stamp = 0;
+
+	prepare(indices, positions);
+
+	const u32 triangleCount = indices.size()/3;
+	Removed.set_used(triangleCount);
+	u32 i;
+	for (i=0; i<triangleCount; ++i)
+		Removed[i] = 0;
+
+	const f32 maxCost = maxError*maxError;
+	u32 remaining = triangleCount;
+
+	// each pass collapses edges which don't share any triangles, so the
+	// adjacency only has to be rebuilt once per pass
+	while (remaining > targetTriangleCount)
+	{
+		buildAdjacency(indices);
+
+		Collapses.set_used(0);
+		for (u32 t=0; t<triangleCount; ++t)
+		{
+			if (Removed[t])
+				continue;
+
+			for (u32 k=0; k<3; ++k)
+			{
+				const u32 a = Remap[indices[t*3+k]];
+				const u32 b = Remap[indices[t*3+(k+1)%3]];
+				SCollapse c;
+				if (!Locked[a])
+				{
+					c.From = a;
+					c.To = b;
+					c.Cost = getCost(a, b);
+					if (c.Cost <= maxCost)
+						Collapses.push_back(c);
+				}
+				if (!Locked[b])
+				{
+					c.From = b;
+					c.To = a;
+					c.Cost = getCost(b, a);
+					if (c.Cost <= maxCost)
+						Collapses.push_back(c);
+				}
+			}
+		}
+		if (Collapses.empty())
+			break;
+		Collapses.sort();
+
+		Dirty.set_used(Positions.size());
+		for (i=0; i<Dirty.size(); ++i)
+			Dirty[i] = 0;
+
+		u32 collapsed = 0;
+		for (i=0; i<Collapses.size() && remaining > targetTriangleCount; ++i)
+		{
+			const SCollapse& c = Collapses[i];
+			if (Dirty[c.From] || Dirty[c.To])
+				continue;
+
+			u32 toVertex;
+			if (!canCollapse(indices, c.From, c.To, toVertex))
+				continue;
+
+			// the triangles around From change, so all their positions are done for this pass
+			for (u32 j=TriangleFirst[c.From]; j<TriangleFirst[c.From+1]; ++j)
+			{
+				const u32 t = Triangles[j];
+				if (Removed[t])
+					continue;
+				Dirty[Remap[indices[t*3]]] = 1;
+				Dirty[Remap[indices[t*3+1]]] = 1;
+				Dirty[Remap[indices[t*3+2]]] = 1;
+			}
+
+			remaining -= collapse(indices, c.From, c.To, toVertex);
+			Error = core::max_(Error, c.Cost);
+			++collapsed;
+		}
+
+		if (!collapsed)
+			break;
+	}
+
+	// remove the collapsed triangles
+	u32 used = 0;
+	for (i=0; i<triangleCount; ++i)
+	{
+		if (Removed[i])
+			continue;
+		indices[used++] = indices[i*3];
+		indices[used++] = indices[i*3+1];
+		indices[used++] = indices[i*3+2];
+	}
+	indices.set_used(used);
+
+	Error = sqrtf(Error);
+	return remaining;
+}
+
+
+//! Builds the position ids, the quadrics and finds the vertices which must not move
+void CMeshSimplifier::prepare(core::array<u32>& indices, const core::array<core::vector3df>& positions)
+{
+	// vertices with the same position are one position, so triangles on
+	// both sides of UV seams are connected
+	typedef core::hashmap<core::vector3df, u32, core::hash_bytes<core::vector3df>, core::equal_bytes<core::vector3df> > PositionMap;
+	PositionMap positionMap;
+	positionMap.reserve(positions.size());
+
+	Remap.set_used(positions.size());
+	Positions.set_used(0);
+	Locked.set_used(0);
+	u32 i;
+	for (i=0; i<positions.size(); ++i)
+	{
+		PositionMap::Node* n = positionMap.find(positions[i]);
+		if (n)
+		{
+			// more than one vertex at a position is a seam
+			Remap[i] = n->getValue();
+			Locked[n->getValue()] = 1;
+		}
+		else
+		{
+			Remap[i] = Positions.size();
+			positionMap.insert(positions[i], Positions.size());
+			Positions.push_back(positions[i]);
+			Locked.push_back(0);
+		}
+	}
+
+	// remove triangles which are degenerated already, they would break the edge counts
+	u32 used = 0;
+	for (i=0; i+2<indices.size(); i+=3)
+	{
+		const u32 a = Remap[indices[i]];
+		const u32 b = Remap[indices[i+1]];
+		const u32 c = Remap[indices[i+2]];
+		if (a == b || b == c || a == c)
+			continue;
+		indices[used++] = indices[i];
+		indices[used++] = indices[i+1];
+		indices[used++] = indices[i+2];
+	}
+	indices.set_used(used);
+
+	Quadrics.set_used(Positions.size());
+	memset(Quadrics.pointer(), 0, Quadrics.size()*sizeof(SQuadric));
+
+	typedef core::hashmap<u64, u32, core::hash_bytes<u64>, core::equal_bytes<u64> > EdgeMap;
+	EdgeMap edges;
+	edges.reserve(indices.size());
+
+	for (i=0; i<indices.size(); i+=3)
+	{
+		const u32 p[3] = { Remap[indices[i]], Remap[indices[i+1]], Remap[indices[i+2]] };
+
+		// plane of the triangle, weighted by its area
+		const core::vector3d<f64> p0(Positions[p[0]].X, Positions[p[0]].Y, Positions[p[0]].Z);
+		const core::vector3d<f64> p1(Positions[p[1]].X, Positions[p[1]].Y, Positions[p[1]].Z);
+		const core::vector3d<f64> p2(Positions[p[2]].X, Positions[p[2]].Y, Positions[p[2]].Z);
+		core::vector3d<f64> normal = (p1-p0).crossProduct(p2-p0);
+		const f64 length = normal.getLength();
+		if (length > 0.0)
+		{
+			normal /= length;
+			const f64 d = -normal.dotProduct(p0);
+			const f64 weight = length * 0.5;
+
+			for (u32 k=0; k<3; ++k)
+			{
+				SQuadric& q = Quadrics[p[k]];
+				q.A00 += weight * normal.X * normal.X;
+				q.A01 += weight * normal.X * normal.Y;
+				q.A02 += weight * normal.X * normal.Z;
+				q.A11 += weight * normal.Y * normal.Y;
+				q.A12 += weight * normal.Y * normal.Z;
+				q.A22 += weight * normal.Z * normal.Z;
+				q.B0 += weight * normal.X * d;
+				q.B1 += weight * normal.Y * d;
+				q.B2 += weight * normal.Z * d;
+				q.C += weight * d * d;
+				q.Weight += weight;
+			}
+		}
+
+		for (u32 k=0; k<3; ++k)
+		{
+			const u32 a = core::min_(p[k], p[(k+1)%3]);
+			const u32 b = core::max_(p[k], p[(k+1)%3]);
+			const u64 key = ((u64)a << 32) | b;
+			EdgeMap::Node* n = edges.find(key);
+			if (n)
+				++n->getValue();
+			else
+				edges.insert(key, 1);
+		}
+	}
+
+	// open edges are borders of the mesh or of the material, non-manifold
+	// edges can't be collapsed safely
+	for (i=0; i<edges.size(); ++i)
+	{
+		if (edges.getNode(i).getValue() != 2)
+		{
+			const u64 key = edges.getNode(i).getKey();
+			Locked[(u32)(key >> 32)] = 1;
+			Locked[(u32)(key & 0xffffffff)] = 1;
+		}
+	}
+
+	Stamps.set_used(Positions.size());
+	for (i=0; i<Stamps.size(); ++i)
+		Stamps[i] = 0;
+}
+
+
+//! Builds the list of triangles around each position
+void CMeshSimplifier::buildAdjacency(const core::array<u32>& indices)
+{
+	const u32 positionCount = Positions.size();
+	TriangleFirst.set_used(positionCount+1);
+	u32 i;
+	for (i=0; i<=positionCount; ++i)
+		TriangleFirst[i] = 0;
+
+	const u32 triangleCount = indices.size()/3;
+	for (i=0; i<triangleCount; ++i)
+	{
+		if (Removed[i])
+			continue;
+		++TriangleFirst[Remap[indices[i*3]]];
+		++TriangleFirst[Remap[indices[i*3+1]]];
+		++TriangleFirst[Remap[indices[i*3+2]]];
+	}
+
+	// counts to offsets, TriangleFirst[p] points to the end of the range while filling
+	u32 sum = 0;
+	for (i=0; i<positionCount; ++i)
+	{
+		sum += TriangleFirst[i];
+		TriangleFirst[i] = sum;
+	}
+	TriangleFirst[positionCount] = sum;
+
+	Triangles.set_used(sum);
+	for (i=triangleCount; i>0; --i)
+	{
+		const u32 t = i-1;
+		if (Removed[t])
+			continue;
+		Triangles[--TriangleFirst[Remap[indices[t*3]]]] = t;
+		Triangles[--TriangleFirst[Remap[indices[t*3+1]]]] = t;
+		Triangles[--TriangleFirst[Remap[indices[t*3+2]]]] = t;
+	}
+}
+
+
+//! Returns the error of a collapse, as squared distance
+f32 CMeshSimplifier::getCost(u32 from, u32 to) const
+{
+	const SQuadric& a = Quadrics[from];
+	const SQuadric& b = Quadrics[to];
+	const f64 weight = a.Weight + b.Weight;
+	if (weight <= 0.0)
+		return 0.f;
+
+	const f64 x = Positions[to].X;
+	const f64 y = Positions[to].Y;
+	const f64 z = Positions[to].Z;
+
+	const f64 error =
+		(a.A00+b.A00)*x*x + (a.A11+b.A11)*y*y + (a.A22+b.A22)*z*z +
+		2.0*((a.A01+b.A01)*x*y + (a.A02+b.A02)*x*z + (a.A12+b.A12)*y*z) +
+		2.0*((a.B0+b.B0)*x + (a.B1+b.B1)*y + (a.B2+b.B2)*z) +
+		a.C + b.C;
+
+	return (f32)(core::max_(error, 0.0) / weight);
+}
+
+
+//! Checks topology and flipped triangles, returns the vertex index from is replaced with
+bool CMeshSimplifier::canCollapse(const core::array<u32>& indices, u32 from, u32 to, u32& toVertex)
+{
+	Stamp += 2;
+	const u32 ring = Stamp;
+	const u32 common = Stamp+1;
+
+	u32 shared = 0;
+	u32 j;
+	for (j=TriangleFirst[from]; j<TriangleFirst[from+1]; ++j)
+	{
+		const u32 t = Triangles[j];
+		if (Removed[t])
+			continue;
+
+		const u32* tri = &indices[t*3];
+		s32 toCorner = -1;
+		s32 fromCorner = -1;
+		for (u32 k=0; k<3; ++k)
+		{
+			const u32 p = Remap[tri[k]];
+			if (p == to)
+				toCorner = k;
+			else if (p == from)
+				fromCorner = k;
+			else
+				Stamps[p] = ring;
+		}
+
+		if (toCorner >= 0)
+		{
+			// the triangles which vanish have to agree on the vertex which remains,
+			// else the attributes of the other triangles would be ambiguous
+			if (shared && toVertex != tri[toCorner])
+				return false;
+			toVertex = tri[toCorner];
+			++shared;
+			continue;
+		}
+
+		// the remaining triangles must not flip over or turn too much
+		core::vector3df p[3];
+		for (u32 k=0; k<3; ++k)
+			p[k] = Positions[Remap[tri[k]]];
+		const core::vector3df before = (p[1]-p[0]).crossProduct(p[2]-p[0]);
+		p[fromCorner] = Positions[to];
+		const core::vector3df after = (p[1]-p[0]).crossProduct(p[2]-p[0]);
+		if (after.dotProduct(before) <= 0.2f * before.getLength() * after.getLength())
+			return false;
+	}
+
+	if (!shared)
+		return false;
+
+	// positions connected to both from and to must belong to the vanishing
+	// triangles, otherwise the collapse creates non-manifold edges
+	u32 commonCount = 0;
+	for (j=TriangleFirst[to]; j<TriangleFirst[to+1]; ++j)
+	{
+		const u32 t = Triangles[j];
+		if (Removed[t])
+			continue;
+
+		for (u32 k=0; k<3; ++k)
+		{
+			const u32 p = Remap[indices[t*3+k]];
+			if (Stamps[p] == ring)
+			{
+				Stamps[p] = common;
+				++commonCount;
+			}
+		}
+	}
+
+	return commonCount <= shared;
+}
+
+
+//! Moves position from onto position to, returns the number of removed triangles
+u32 CMeshSimplifier::collapse(core::array<u32>& indices, u32 from, u32 to, u32 toVertex)
+{
+	u32 removed = 0;
+	for (u32 j=TriangleFirst[from]; j<TriangleFirst[from+1]; ++j)
+	{
+		const u32 t = Triangles[j];
+		if (Removed[t])
+			continue;
+
+		u32* tri = &indices[t*3];
+		if (Remap[tri[0]] == to || Remap[tri[1]] == to || Remap[tri[2]] == to)
+		{
+			Removed[t] = 1;
+			++removed;
+			continue;
+		}
+
+		for (u32 k=0; k<3; ++k)
+		{
+			if (Remap[tri[k]] == from)
+				tri[k] = toVertex;
+		}
+	}
+
+	SQuadric& a = Quadrics[to];
+	const SQuadric& b = Quadrics[from];
+	a.A00 += b.A00;
+	a.A01 += b.A01;
+	a.A02 += b.A02;
+	a.A11 += b.A11;
+	a.A12 += b.A12;
+	a.A22 += b.A22;
+	a.B0 += b.B0;
+	a.B1 += b.B1;
+	a.B2 += b.B2;
+	a.C += b.C;
+	a.Weight += b.Weight;
+
+	return removed;
+}
+
+} // end namespace scene
+} // end namespace irr
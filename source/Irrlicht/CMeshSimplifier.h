@@ -0,0 +1,97 @@
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#ifndef __C_MESH_SIMPLIFIER_H_INCLUDED__
+#define __C_MESH_SIMPLIFIER_H_INCLUDED__
+
+#include "irrArray.h"
+#include "vector3d.h"
+
+namespace irr
+{
+namespace scene
+{
+
+//! Reduces the triangle count of indexed triangle lists with quadric error metrics.
+/** Each vertex gets a quadric which measures the squared distance to the
+planes of its triangles. Edges are collapsed in order of the error the
+collapse introduces, by moving one vertex onto the other one. As no new
+vertices are created, all vertex attributes stay exact and only the index
+list changes.
+Vertices sharing their position with other vertices (UV seams, hard normals)
+and vertices on open edges (mesh borders and borders to other mesh buffers,
+so to other materials) are never moved, so the simplified mesh has no cracks. */
+class CMeshSimplifier
+{
+public:
+
+	//! Simplifies a triangle list.
+	/** \param indices Indices of the triangle list, replaced by the simplified ones.
+	\param positions Positions of all vertices referenced by the indices.
+	\param targetTriangleCount Simplification stops when this number of triangles is reached.
+	\param maxError Largest distance a surface may move, in units of the positions.
+	\return Number of remaining triangles. */
+	u32 simplify(core::array<u32>& indices, const core::array<core::vector3df>& positions,
+		u32 targetTriangleCount, f32 maxError);
+
+	//! Returns the largest error of all collapses done in the last simplify() call.
+	f32 getError() const { return Error; }
+
+private:
+
+	//! Symmetric 4x4 matrix summing squared plane distances, with the weight of all planes
+	struct SQuadric
+	{
+		f64 A00, A01, A02, A11, A12, A22;
+		f64 B0, B1, B2, C;
+		f64 Weight;
+	};
+
+	struct SCollapse
+	{
+		u32 From;
+		u32 To;
+		f32 Cost;
+
+		bool operator<(const SCollapse& other) const { return Cost < other.Cost; }
+	};
+
+	//! Builds the position ids, the quadrics and finds the vertices which must not move
+	void prepare(core::array<u32>& indices, const core::array<core::vector3df>& positions);
+
+	//! Builds the list of triangles around each position
+	void buildAdjacency(const core::array<u32>& indices);
+
+	//! Returns the error of a collapse, as squared distance
+	f32 getCost(u32 from, u32 to) const;
+
+	//! Checks topology and flipped triangles, returns the vertex index from is replaced with
+	bool canCollapse(const core::array<u32>& indices, u32 from, u32 to, u32& toVertex);
+
+	//! Moves position from onto position to, returns the number of removed triangles
+	u32 collapse(core::array<u32>& indices, u32 from, u32 to, u32 toVertex);
+
+	//! position id of each vertex
+	core::array<u32> Remap;
+	//! positions of all position ids
+	core::array<core::vector3df> Positions;
+	core::array<SQuadric> Quadrics;
+	core::array<u8> Locked;
+
+	//! triangles around each position, TriangleFirst has one entry more than Positions
+	core::array<u32> TriangleFirst;
+	core::array<u32> Triangles;
+	core::array<u8> Removed;
+
+	core::array<SCollapse> Collapses;
+	//! positions whose triangles changed in the current pass
+	core::array<u8> Dirty;
+	core::array<u32> Stamps;
+	u32 Stamp;
+	f32 Error;
+};
+
+} // end namespace scene
+} // end namespace irr
+
+#endif // __C_MESH_SIMPLIFIER_H_INCLUDED__
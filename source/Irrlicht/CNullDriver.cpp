@@ -341,7 +341,9 @@ void CNullDriver::disableFeature(E_VIDEO_DRIVER_FEATURE feature, bool flag)
 //! queries the features of the driver, returns true if feature is available
 bool CNullDriver::queryFeature(E_VIDEO_DRIVER_FEATURE feature) const
 {
-	return false;
+	// shadow volume nodes are created, so their volumes can be built
+	// without a window, drawing them does nothing
+	return feature == EVDF_STENCIL_BUFFER;
 }
 
 
@@ -1752,11 +1754,83 @@ void CNullDriver::drawMeshBuffer(const scene::IMeshBuffer* mb)
 
 	if (HWBuffer)
 		drawHardwareBuffer(HWBuffer);
+	else if (isQuantizedVertexType(mb->getVertexType()))
+	{
+		VertexQuantization = mb->getVertexQuantization();
+		drawVertexPrimitiveList(mb->getVertices(), mb->getVertexCount(), mb->getIndices(), mb->getPrimitiveCount(), mb->getVertexType(), mb->getPrimitiveType(), mb->getIndexType());
+		VertexQuantization = SVertexQuantization();
+	}
 	else
 		drawVertexPrimitiveList(mb->getVertices(), mb->getVertexCount(), mb->getIndices(), mb->getPrimitiveCount(), mb->getVertexType(), mb->getPrimitiveType(), mb->getIndexType());
 }
 
 
+//! Decodes quantized vertices for drivers which can't draw them directly
+const void* CNullDriver::decodeQuantizedVertices(const void* vertices, u32 vertexCount, E_VERTEX_TYPE& vType)
+{
+	switch (vType)
+	{
+	case EVT_QUANTIZED:
+		DecodedVertices.set_used(vertexCount);
+		decodeQuantizedVertices(vertices, vertexCount, vType, VertexQuantization, DecodedVertices.pointer());
+		vType = EVT_STANDARD;
+		return DecodedVertices.const_pointer();
+	case EVT_QUANTIZED_TANGENTS:
+		DecodedTangentVertices.set_used(vertexCount);
+		decodeQuantizedVertices(vertices, vertexCount, vType, VertexQuantization, DecodedTangentVertices.pointer());
+		vType = EVT_TANGENTS;
+		return DecodedTangentVertices.const_pointer();
+	default:
+		return vertices;
+	}
+}
+
+
+//! Decodes quantized vertices into memory of the decoded vertex type
+void CNullDriver::decodeQuantizedVertices(const void* vertices, u32 vertexCount, E_VERTEX_TYPE vType,
+	const SVertexQuantization& quantization, void* decoded)
+{
+	u32 i;
+	switch (vType)
+	{
+	case EVT_QUANTIZED:
+		{
+			const S3DVertexQuantized* v = (const S3DVertexQuantized*)vertices;
+			S3DVertex* out = (S3DVertex*)decoded;
+			for (i=0; i<vertexCount; ++i)
+				out[i] = v[i].get(quantization);
+		}
+		break;
+	case EVT_QUANTIZED_TANGENTS:
+		{
+			const S3DVertexQuantizedTangents* v = (const S3DVertexQuantizedTangents*)vertices;
+			S3DVertexTangents* out = (S3DVertexTangents*)decoded;
+			for (i=0; i<vertexCount; ++i)
+				out[i] = v[i].get(quantization);
+		}
+		break;
+	default:
+		memcpy(decoded, vertices, vertexCount * getVertexPitchFromType(vType));
+		break;
+	}
+}
+
+
+//! Returns the vertex type quantized vertices are decoded to
+E_VERTEX_TYPE CNullDriver::getDecodedVertexType(E_VERTEX_TYPE vType)
+{
+	switch (vType)
+	{
+	case EVT_QUANTIZED:
+		return EVT_STANDARD;
+	case EVT_QUANTIZED_TANGENTS:
+		return EVT_TANGENTS;
+	default:
+		return vType;
+	}
+}
+
+
 //! Draws the normals of a mesh buffer
 void CNullDriver::drawMeshBufferNormals(const scene::IMeshBuffer* mb, f32 length, SColor color)
 {
@@ -1844,6 +1918,11 @@ bool CNullDriver::isHardwareBufferRecommend(const scene::IMeshBuffer* mb)
 	if (mb->getVertexCount()<MinVertexCountForVBO)
 		return false;
 
+	// drivers decode quantized vertices once when filling the vertex buffer,
+	// buffers with only hardware indices decode them on each draw instead
+	if (isQuantizedVertexType(mb->getVertexType()) && mb->getHardwareMappingHint_Vertex()==scene::EHM_NEVER)
+		return false;
+
 	return true;
 }
 
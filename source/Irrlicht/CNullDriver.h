@@ -694,6 +694,24 @@ namespace video
 		//! checks triangle count and print warning if wrong
 		bool checkPrimitiveCount(u32 prmcnt) const;
 
+		//! Decodes quantized vertices for drivers which can't draw them directly
+		/** Uses the quantization of the mesh buffer drawn at the moment.
+		\param vType Vertex type, changed to the type of the decoded vertices.
+		\return Pointer to the decoded vertices, or the vertices itself if
+		they are not quantized. */
+		const void* decodeQuantizedVertices(const void* vertices, u32 vertexCount, E_VERTEX_TYPE& vType);
+
+		//! Decodes quantized vertices into memory of the decoded vertex type
+		/** Used by drivers to decode quantized vertices once when they fill
+		their hardware buffers.
+		\param decoded Memory for vertexCount vertices of the type returned
+		by getDecodedVertexType(). */
+		static void decodeQuantizedVertices(const void* vertices, u32 vertexCount, E_VERTEX_TYPE vType,
+			const SVertexQuantization& quantization, void* decoded);
+
+		//! Returns the vertex type quantized vertices are decoded to
+		static E_VERTEX_TYPE getDecodedVertexType(E_VERTEX_TYPE vType);
+
 		bool checkImage(const core::array<IImage*>& image) const;
 
 		// adds a material renderer and drops it afterwards. To be used for internal creation
@@ -863,6 +881,11 @@ namespace video
 		core::dimension2d<u32> ScreenSize;
 		core::matrix4 TransformationMatrix;
 
+		//! quantization of the mesh buffer drawn at the moment
+		SVertexQuantization VertexQuantization;
+		core::array<S3DVertex> DecodedVertices;
+		core::array<S3DVertexTangents> DecodedTangentVertices;
+
 		CFPSCounter FPSCounter;
 
 		u32 PrimitivesDrawn;
@@ -11,6 +11,7 @@
 #include "IVideoDriver.h"
 #include "SMesh.h"
 #include "SMeshBuffer.h"
+#include "CMeshBufferHelper.h"
 #include "SAnimatedMesh.h"
 #include "IReadFile.h"
 #include "IAttributes.h"
@@ -256,7 +257,7 @@ IAnimatedMesh* COBJMeshFileLoader::createMesh(io::IReadFile* file)
 				}
 
 				int vertLocation;
-				core::map<video::S3DVertex, int>::Node* n = currMtl->VertMap.find(v);
+				SObjMtl::VertexMap::Node* n = currMtl->VertMap.find(v);
 				if (n)
 				{
 					vertLocation = n->getValue();
@@ -278,9 +279,9 @@ IAnimatedMesh* COBJMeshFileLoader::createMesh(io::IReadFile* file)
 			for ( u32 i = 1; i < faceCorners.size() - 1; ++i )
 			{
 				// Add a triangle
-				currMtl->Meshbuffer->Indices.push_back( faceCorners[i+1] );
-				currMtl->Meshbuffer->Indices.push_back( faceCorners[i] );
-				currMtl->Meshbuffer->Indices.push_back( faceCorners[0] );
+				currMtl->Indices.push_back( faceCorners[i+1] );
+				currMtl->Indices.push_back( faceCorners[i] );
+				currMtl->Indices.push_back( faceCorners[0] );
 			}
 		}
 		break;
@@ -299,21 +300,23 @@ IAnimatedMesh* COBJMeshFileLoader::createMesh(io::IReadFile* file)
 	// Combine all the groups (meshbuffers) into the mesh
 	for ( u32 m = 0; m < Materials.size(); ++m )
 	{
-		if ( Materials[m]->Meshbuffer->getIndexCount() > 0 )
+		if ( Materials[m]->Indices.size() > 0 )
 		{
 			Materials[m]->Meshbuffer->recalculateBoundingBox();
+			IMeshBuffer* mb = createIndexedMeshBuffer(Materials[m]->Meshbuffer, Materials[m]->Indices);
 			if (Materials[m]->RecalculateNormals)
-				SceneManager->getMeshManipulator()->recalculateNormals(Materials[m]->Meshbuffer);
-			if (Materials[m]->Meshbuffer->Material.MaterialType == video::EMT_PARALLAX_MAP_SOLID)
+				SceneManager->getMeshManipulator()->recalculateNormals(mb);
+			if (mb->getMaterial().MaterialType == video::EMT_PARALLAX_MAP_SOLID)
 			{
 				SMesh tmp;
-				tmp.addMeshBuffer(Materials[m]->Meshbuffer);
+				tmp.addMeshBuffer(mb);
 				IMesh* tangentMesh = SceneManager->getMeshManipulator()->createMeshWithTangents(&tmp);
 				mesh->addMeshBuffer(tangentMesh->getMeshBuffer(0));
 				tangentMesh->drop();
 			}
 			else
-				mesh->addMeshBuffer( Materials[m]->Meshbuffer );
+				mesh->addMeshBuffer(mb);
+			mb->drop();
 		}
 	}
 
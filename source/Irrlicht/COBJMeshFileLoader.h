@@ -10,7 +10,7 @@
 #include "ISceneManager.h"
 #include "irrString.h"
 #include "SMeshBuffer.h"
-#include "irrMap.h"
+#include "irrHashMap.h"
 
 namespace irr
 {
@@ -61,8 +61,13 @@ private:
 			Meshbuffer->Material = o.Meshbuffer->Material;
 		}
 
-		core::map<video::S3DVertex, int> VertMap;
+		// vertices are compared bytewise, they are all built from the same lists
+		typedef core::hashmap<video::S3DVertex, int,
+			core::hash_bytes<video::S3DVertex>, core::equal_bytes<video::S3DVertex> > VertexMap;
+		VertexMap VertMap;
 		scene::SMeshBuffer *Meshbuffer;
+		// indices are collected as u32, large buffers get 32 bit indices in the end
+		core::array<u32> Indices;
 		core::stringc Name;
 		core::stringc Group;
 		f32 Bumpiness;
@@ -0,0 +1,284 @@
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#include "COcclusionCuller.h"
+#include "IMeshBuffer.h"
+
+namespace irr
+{
+namespace scene
+{
+
+COcclusionCuller::COcclusionCuller()
+	: Near(1.f), Perspective(true), TriangleCount(0)
+{
+}
+
+
+//! Starts a new frame, removes all occluders.
+void COcclusionCuller::begin(const core::matrix4& view, const core::matrix4& projection,
+		f32 nearValue, u32 width, u32 height)
+{
+	View = view;
+	Projection = projection;
+	Near = core::max_(nearValue, core::ROUNDING_ERROR_f32);
+	Perspective = !core::iszero(projection[11]);
+	TriangleCount = 0;
+
+	width = core::max_(width, 1u);
+	height = core::max_(height, 1u);
+	if (Levels.empty() || Levels[0].Width != width || Levels[0].Height != height)
+	{
+		// each level has half the size of the one before, down to a single texel
+		Levels.set_used(0);
+		u32 offset = 0;
+		for (;;)
+		{
+			SLevel level;
+			level.Width = width;
+			level.Height = height;
+			level.Offset = offset;
+			Levels.push_back(level);
+			offset += width*height;
+			if (width == 1 && height == 1)
+				break;
+			width = (width+1)/2;
+			height = (height+1)/2;
+		}
+		Depth.set_used(offset);
+	}
+
+	const u32 count = Levels[0].Width*Levels[0].Height;
+	for (u32 i=0; i<count; ++i)
+		Depth[i] = FLT_MAX;
+}
+
+
+//! Rasterizes all triangles of a mesh into the depth buffer.
+void COcclusionCuller::addOccluder(const IMesh* mesh, const core::matrix4& world)
+{
+	if (!mesh || Levels.empty())
+		return;
+
+	const core::matrix4 worldView = View * world;
+
+	for (u32 b=0; b<mesh->getMeshBufferCount(); ++b)
+	{
+		const IMeshBuffer* mb = mesh->getMeshBuffer(b);
+		if (!mb || mb->getPrimitiveType() != EPT_TRIANGLES)
+			continue;
+
+		const u32 vertexCount = mb->getVertexCount();
+		Transformed.set_used(vertexCount);
+		for (u32 v=0; v<vertexCount; ++v)
+			worldView.transformVect(Transformed[v], mb->getPosition(v));
+
+		const u32 indexCount = mb->getIndexCount();
+		if (mb->getIndexType() == video::EIT_32BIT)
+		{
+			const u32* indices = (const u32*)mb->getIndices();
+			for (u32 i=0; i+2<indexCount; i+=3)
+				drawTriangle(Transformed[indices[i]], Transformed[indices[i+1]], Transformed[indices[i+2]]);
+		}
+		else
+		{
+			const u16* indices = mb->getIndices();
+			for (u32 i=0; i+2<indexCount; i+=3)
+				drawTriangle(Transformed[indices[i]], Transformed[indices[i+1]], Transformed[indices[i+2]]);
+		}
+	}
+}
+
+
+//! Builds the depth pyramid, must be called after adding the occluders.
+void COcclusionCuller::end()
+{
+	for (u32 l=1; l<Levels.size(); ++l)
+	{
+		const SLevel& src = Levels[l-1];
+		const SLevel& dst = Levels[l];
+		const f32* srcDepth = &Depth[src.Offset];
+		f32* dstDepth = &Depth[dst.Offset];
+
+		for (u32 y=0; y<dst.Height; ++y)
+		{
+			const u32 y0 = y*2;
+			const u32 y1 = core::min_(y0+1, src.Height-1);
+			for (u32 x=0; x<dst.Width; ++x)
+			{
+				const u32 x0 = x*2;
+				const u32 x1 = core::min_(x0+1, src.Width-1);
+
+				// farthest occluder of the covered texels
+				dstDepth[y*dst.Width+x] = core::max_(
+					core::max_(srcDepth[y0*src.Width+x0], srcDepth[y0*src.Width+x1]),
+					core::max_(srcDepth[y1*src.Width+x0], srcDepth[y1*src.Width+x1]));
+			}
+		}
+	}
+}
+
+
+//! Returns if a world space box is completely hidden by the occluders.
+bool COcclusionCuller::isOccluded(const core::aabbox3df& box) const
+{
+	if (Levels.empty())
+		return false;
+
+	core::vector3df edges[8];
+	box.getEdges(edges);
+
+	f32 minX = FLT_MAX, minY = FLT_MAX;
+	f32 maxX = -FLT_MAX, maxY = -FLT_MAX;
+	f32 minDepth = FLT_MAX;
+	for (u32 i=0; i<8; ++i)
+	{
+		core::vector3df viewPos;
+		View.transformVect(viewPos, edges[i]);
+
+		// boxes reaching through the near plane are never hidden
+		if (viewPos.Z < Near)
+			return false;
+
+		const SVertex v = project(viewPos);
+		minX = core::min_(minX, v.X);
+		maxX = core::max_(maxX, v.X);
+		minY = core::min_(minY, v.Y);
+		maxY = core::max_(maxY, v.Y);
+		minDepth = core::min_(minDepth, viewPos.Z);
+	}
+
+	const SLevel& base = Levels[0];
+	if (maxX < 0.f || maxY < 0.f || minX >= (f32)base.Width || minY >= (f32)base.Height)
+		return false;
+
+	// all pixels touched by the box
+	const u32 x0 = (u32)core::max_(minX, 0.f);
+	const u32 y0 = (u32)core::max_(minY, 0.f);
+	const u32 x1 = (u32)core::min_(maxX, (f32)(base.Width-1));
+	const u32 y1 = (u32)core::min_(maxY, (f32)(base.Height-1));
+
+	// smallest level where the box covers at most 4x4 texels
+	u32 l = 0;
+	while (l+1 < Levels.size() && ((x1>>l)-(x0>>l) > 3 || (y1>>l)-(y0>>l) > 3))
+		++l;
+
+	// small tolerance, so occluders don't hide themselves due to rounding
+	const f32 testDepth = minDepth * 0.999f;
+
+	const SLevel& level = Levels[l];
+	for (u32 y=(y0>>l); y<=(y1>>l); ++y)
+	{
+		const f32* row = &Depth[level.Offset + y*level.Width];
+		for (u32 x=(x0>>l); x<=(x1>>l); ++x)
+		{
+			if (row[x] >= testDepth)
+				return false;
+		}
+	}
+
+	return true;
+}
+
+
+//! Clips a view space triangle at the near plane and rasterizes it
+void COcclusionCuller::drawTriangle(const core::vector3df& a, const core::vector3df& b, const core::vector3df& c)
+{
+	++TriangleCount;
+
+	if (a.Z >= Near && b.Z >= Near && c.Z >= Near)
+	{
+		rasterize(project(a), project(b), project(c));
+		return;
+	}
+
+	// cutting off the part behind the near plane leaves up to 4 vertices
+	const core::vector3df* in[3] = { &a, &b, &c };
+	core::vector3df out[4];
+	u32 count = 0;
+	for (u32 i=0; i<3; ++i)
+	{
+		const core::vector3df& p = *in[i];
+		const core::vector3df& q = *in[(i+1)%3];
+		const bool pInside = p.Z >= Near;
+		const bool qInside = q.Z >= Near;
+
+		if (pInside)
+			out[count++] = p;
+		if (pInside != qInside)
+			out[count++] = p + (q - p) * ((Near - p.Z) / (q.Z - p.Z));
+	}
+
+	if (count < 3)
+		return;
+
+	const SVertex v0 = project(out[0]);
+	const SVertex v2 = project(out[2]);
+	rasterize(v0, project(out[1]), v2);
+	if (count == 4)
+		rasterize(v0, v2, project(out[3]));
+}
+
+
+//! Projects a view space position to the depth buffer
+COcclusionCuller::SVertex COcclusionCuller::project(const core::vector3df& viewPos) const
+{
+	f32 clip[4];
+	Projection.transformVect(clip, viewPos);
+
+	const f32 invW = core::reciprocal(clip[3]);
+	SVertex v;
+	v.X = (clip[0] * invW * 0.5f + 0.5f) * Levels[0].Width;
+	v.Y = (0.5f - clip[1] * invW * 0.5f) * Levels[0].Height;
+	v.Z = Perspective ? core::reciprocal(viewPos.Z) : viewPos.Z;
+	return v;
+}
+
+
+//! Rasterizes a triangle in front of the near plane
+void COcclusionCuller::rasterize(const SVertex& a, const SVertex& b, const SVertex& c)
+{
+	const f32 area = (b.X - a.X) * (c.Y - a.Y) - (b.Y - a.Y) * (c.X - a.X);
+	if (core::iszero(area))
+		return;
+	const f32 invArea = core::reciprocal(area);
+
+	const SLevel& base = Levels[0];
+	const f32 minX = core::max_(core::min_(a.X, b.X, c.X), 0.f);
+	const f32 minY = core::max_(core::min_(a.Y, b.Y, c.Y), 0.f);
+	const f32 maxX = core::min_(core::max_(a.X, b.X, c.X), (f32)base.Width);
+	const f32 maxY = core::min_(core::max_(a.Y, b.Y, c.Y), (f32)base.Height);
+	if (minX >= maxX || minY >= maxY)
+		return;
+
+	// pixels are covered when their center is inside the triangle
+	const s32 x0 = core::ceil32(minX - 0.5f);
+	const s32 y0 = core::ceil32(minY - 0.5f);
+	const s32 x1 = core::min_(core::ceil32(maxX - 0.5f), (s32)base.Width);
+	const s32 y1 = core::min_(core::ceil32(maxY - 0.5f), (s32)base.Height);
+
+	for (s32 y=y0; y<y1; ++y)
+	{
+		const f32 py = y + 0.5f;
+		f32* row = &Depth[y*base.Width];
+		for (s32 x=x0; x<x1; ++x)
+		{
+			const f32 px = x + 0.5f;
+
+			// barycentric coordinates
+			const f32 wa = ((c.X - b.X) * (py - b.Y) - (c.Y - b.Y) * (px - b.X)) * invArea;
+			const f32 wb = ((a.X - c.X) * (py - c.Y) - (a.Y - c.Y) * (px - c.X)) * invArea;
+			const f32 wc = 1.f - wa - wb;
+			if (wa < 0.f || wb < 0.f || wc < 0.f)
+				continue;
+
+			const f32 z = wa * a.Z + wb * b.Z + wc * c.Z;
+			const f32 depth = Perspective ? core::reciprocal(z) : z;
+			if (depth < row[x])
+				row[x] = depth;
+		}
+	}
+}
+
+} // end namespace scene
+} // end namespace irr
@@ -0,0 +1,95 @@
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#ifndef __C_OCCLUSION_CULLER_H_INCLUDED__
+#define __C_OCCLUSION_CULLER_H_INCLUDED__
+
+#include "IMesh.h"
+#include "matrix4.h"
+#include "irrArray.h"
+
+namespace irr
+{
+namespace scene
+{
+
+//! Software occlusion culling with a hierarchical depth buffer.
+/** Occluder meshes are rasterized into a small depth buffer which stores the
+view space depth of the nearest occluder per pixel. From that a pyramid is
+built where each texel holds the farthest depth of the four texels below it.
+A bounding box is hidden when its nearest point is behind the farthest
+occluder depth of all texels it covers. Only a few texels have to be read for
+each box, because the level is chosen by the size of the box on the screen.
+All work is done on the CPU, so it works with every driver. */
+class COcclusionCuller
+{
+public:
+
+	COcclusionCuller();
+
+	//! Starts a new frame, removes all occluders.
+	/** \param view View matrix of the camera.
+	\param projection Projection matrix of the camera.
+	\param nearValue Distance of the near plane, occluders are clipped there.
+	\param width Width of the depth buffer.
+	\param height Height of the depth buffer. */
+	void begin(const core::matrix4& view, const core::matrix4& projection,
+		f32 nearValue, u32 width, u32 height);
+
+	//! Rasterizes all triangles of a mesh into the depth buffer.
+	/** \param mesh The occluder geometry.
+	\param world Transformation of the mesh into world space. */
+	void addOccluder(const IMesh* mesh, const core::matrix4& world);
+
+	//! Builds the depth pyramid, must be called after adding the occluders.
+	void end();
+
+	//! Returns if a world space box is completely hidden by the occluders.
+	bool isOccluded(const core::aabbox3df& box) const;
+
+	//! Returns the number of occluder triangles rasterized since begin()
+	u32 getTriangleCount() const { return TriangleCount; }
+
+private:
+
+	struct SVertex
+	{
+		f32 X, Y;	// pixel coordinates
+		f32 Z;		// 1/depth for perspective projections, else depth, so it's linear in screen space
+	};
+
+	struct SLevel
+	{
+		u32 Width;
+		u32 Height;
+		u32 Offset;
+	};
+
+	//! Clips a view space triangle at the near plane and rasterizes it
+	void drawTriangle(const core::vector3df& a, const core::vector3df& b, const core::vector3df& c);
+
+	//! Projects a view space position to the depth buffer
+	SVertex project(const core::vector3df& viewPos) const;
+
+	//! Rasterizes a triangle in front of the near plane
+	void rasterize(const SVertex& a, const SVertex& b, const SVertex& c);
+
+	core::matrix4 View;
+	core::matrix4 Projection;
+	f32 Near;
+	bool Perspective;
+
+	//! all levels of the pyramid, level 0 is the full resolution buffer
+	core::array<f32> Depth;
+	core::array<SLevel> Levels;
+
+	//! view space vertices of the mesh buffer which is rasterized
+	core::array<core::vector3df> Transformed;
+
+	u32 TriangleCount;
+};
+
+} // end namespace scene
+} // end namespace irr
+
+#endif // __C_OCCLUSION_CULLER_H_INCLUDED__
@@ -56,6 +56,13 @@ COctreeSceneNode::~COctreeSceneNode()
 
 void COctreeSceneNode::OnRegisterSceneNode()
 {
+	if (IsVisible && !MeshVisible)
+	{
+		// the mesh is drawn by another node, only the children are rendered
+		ISceneNode::OnRegisterSceneNode();
+		return;
+	}
+
 	if (IsVisible)
 	{
 		// because this node supports rendering of mixed mode meshes consisting of
@@ -97,8 +104,10 @@ void COctreeSceneNode::OnRegisterSceneNode()
 }
 
 template <class VT>
-void renderMeshBuffer(video::IVideoDriver* driver, EOCTREENODE_VBO useVBO, typename Octree<VT>::SMeshChunk& meshChunk, const typename Octree<VT>::SIndexData& indexData)
+void renderMeshBuffer(video::IVideoDriver* driver, EOCTREENODE_VBO useVBO, const Octree<VT>& tree, typename Octree<VT>::SMeshChunk& meshChunk, u32 chunk)
 {
+	const typename Octree<VT>::SIndexData& indexData = tree.getIndexData()[chunk];
+
 	switch ( useVBO )
 	{
 		case EOV_NO_VBO:
@@ -108,23 +117,46 @@ void renderMeshBuffer(video::IVideoDriver* driver, EOCTREENODE_VBO useVBO, typen
 				indexData.Indices, indexData.CurrentSize / 3);
 				break;
 		case EOV_USE_VBO:
+			// the buffer may still contain only the visible indices
+			if (meshChunk.IndexDataID != 0)
+			{
+				meshChunk.Indices = tree.getTreeIndices(chunk);
+				meshChunk.setDirty(scene::EBT_INDEX);
+				meshChunk.IndexDataID = 0;
+			}
 			driver->drawMeshBuffer ( &meshChunk );
 			break;
 		case EOV_USE_VBO_WITH_VISIBITLY:
 		{
-			u16* oldPointer = meshChunk.Indices.pointer();
-			const u32 oldSize = meshChunk.Indices.size();
-			meshChunk.Indices.set_free_when_destroyed(false);
-			meshChunk.Indices.set_pointer(indexData.Indices, indexData.CurrentSize, false, false);
-			meshChunk.setDirty(scene::EBT_INDEX);
+			// the index buffer is only updated when other nodes became visible
+			if (meshChunk.IndexDataID != indexData.ChangedID)
+			{
+				meshChunk.Indices.set_used(indexData.CurrentSize);
+				memcpy(meshChunk.Indices.pointer(), indexData.Indices, indexData.CurrentSize * sizeof(u16));
+				meshChunk.setDirty(scene::EBT_INDEX);
+				meshChunk.IndexDataID = indexData.ChangedID;
+			}
 			driver->drawMeshBuffer ( &meshChunk );
-			meshChunk.Indices.set_pointer(oldPointer, oldSize);
-			meshChunk.setDirty(scene::EBT_INDEX);
 			break;
 		}
 	}
 }
 
+template <class VT>
+void setHardwareMappingHints(core::array<typename Octree<VT>::SMeshChunk>& meshes, EOCTREENODE_VBO useVBO)
+{
+	for (u32 i=0; i<meshes.size(); ++i)
+	{
+		if (useVBO == EOV_USE_VBO_WITH_VISIBITLY)
+		{
+			meshes[i].setHardwareMappingHint(scene::EHM_STATIC, scene::EBT_VERTEX);
+			meshes[i].setHardwareMappingHint(scene::EHM_DYNAMIC, scene::EBT_INDEX);
+		}
+		else
+			meshes[i].setHardwareMappingHint(scene::EHM_STATIC);
+	}
+}
+
 //! renders the node.
 void COctreeSceneNode::render()
 {
@@ -189,7 +221,7 @@ void COctreeSceneNode::render()
 				if (transparent == isTransparentPass)
 				{
 					driver->setMaterial(Materials[i]);
-					renderMeshBuffer<video::S3DVertex>(driver, UseVBOs, StdMeshes[i], d[i]);
+					renderMeshBuffer<video::S3DVertex>(driver, UseVBOs, *StdOctree, StdMeshes[i], i);
 				}
 			}
 		}
@@ -224,7 +256,7 @@ void COctreeSceneNode::render()
 				{
 					driver->setMaterial(Materials[i]);
 
-					renderMeshBuffer<video::S3DVertex2TCoords>(driver, UseVBOs, LightMapMeshes[i], d[i]);
+					renderMeshBuffer<video::S3DVertex2TCoords>(driver, UseVBOs, *LightMapOctree, LightMapMeshes[i], i);
 				}
 			}
 		}
@@ -258,11 +290,15 @@ void COctreeSceneNode::render()
 				if (transparent == isTransparentPass)
 				{
 					driver->setMaterial(Materials[i]);
-					renderMeshBuffer<video::S3DVertexTangents>(driver, UseVBOs, TangentsMeshes[i], d[i]);
+					renderMeshBuffer<video::S3DVertexTangents>(driver, UseVBOs, *TangentsOctree, TangentsMeshes[i], i);
 				}
 			}
 		}
 		break;
+	case video::EVT_QUANTIZED:
+	case video::EVT_QUANTIZED_TANGENTS:
+		// not used, quantized buffers are decoded in createTree()
+		break;
 	}
 
 	// for debug purposes only
@@ -285,6 +321,10 @@ void COctreeSceneNode::render()
 				case video::EVT_TANGENTS:
 					TangentsOctree->getBoundingBoxes(box, boxes);
 					break;
+				case video::EVT_QUANTIZED:
+				case video::EVT_QUANTIZED_TANGENTS:
+					// not used, quantized buffers are decoded in createTree()
+					break;
 			}
 
 			for (u32 b=0; b!=boxes.size(); ++b)
@@ -315,8 +355,11 @@ bool COctreeSceneNode::removeChild(ISceneNode* child)
 void COctreeSceneNode::setUseVBO(EOCTREENODE_VBO useVBO)
 {
 	UseVBOs = useVBO;
-	if ( Mesh )
-		createTree(Mesh);
+
+	// the tree stays the same, the buffers only get other hints
+	setHardwareMappingHints<video::S3DVertex>(StdMeshes, UseVBOs);
+	setHardwareMappingHints<video::S3DVertex2TCoords>(LightMapMeshes, UseVBOs);
+	setHardwareMappingHints<video::S3DVertexTangents>(TangentsMeshes, UseVBOs);
 }
 
 EOCTREENODE_VBO COctreeSceneNode::getUseVBO() const
@@ -360,10 +403,22 @@ const core::aabbox3d<f32>& COctreeSceneNode::getBoundingBox() const
 }
 
 
+template <class VT>
+Octree<VT>* createOctree(const core::array<typename Octree<VT>::SMeshChunk>& meshes,
+		s32 minimalPolysPerNode, io::IReadFile* treeFile, bool& fromFile)
+{
+	Octree<VT>* tree = treeFile ? Octree<VT>::read(meshes, treeFile) : 0;
+	fromFile = tree != 0;
+	if (!tree)
+		tree = new Octree<VT>(meshes, minimalPolysPerNode);
+	return tree;
+}
+
+
 //! creates the tree
 /* This method has a lot of duplication and overhead. Moreover, the tangents mesh conversion does not really work. I think we need a a proper mesh implementation for octrees, which handle all vertex types internally. Converting all structures to just one vertex type is always problematic.
 Thanks to Auria for fixing major parts of this method. */
-bool COctreeSceneNode::createTree(IMesh* mesh)
+bool COctreeSceneNode::createTree(IMesh* mesh, io::IReadFile* treeFile, bool* treeRead)
 {
 	if (!mesh)
 		return false;
@@ -380,9 +435,18 @@ bool COctreeSceneNode::createTree(IMesh* mesh)
 	u32 nodeCount = 0;
 	u32 polyCount = 0;
 	u32 i;
+	bool fromFile = false;
 
 	Box = mesh->getBoundingBox();
 
+	// remember the state of the mesh to find out if it changed
+	MeshChangedIDs.set_used(0);
+	for (i=0; i<mesh->getMeshBufferCount(); ++i)
+	{
+		MeshChangedIDs.push_back(mesh->getMeshBuffer(i)->getChangedID_Vertex());
+		MeshChangedIDs.push_back(mesh->getMeshBuffer(i)->getChangedID_Index());
+	}
+
 	if (mesh->getMeshBufferCount())
 	{
 		// check for "largest" buffer types
@@ -400,7 +464,8 @@ bool COctreeSceneNode::createTree(IMesh* mesh)
 				++meshReserve;
 				if (b->getVertexType() == video::EVT_2TCOORDS)
 					VertexType = video::EVT_2TCOORDS;
-				else if (b->getVertexType() == video::EVT_TANGENTS)
+				else if (b->getVertexType() == video::EVT_TANGENTS ||
+					b->getVertexType() == video::EVT_QUANTIZED_TANGENTS)
 					VertexType = video::EVT_TANGENTS;
 			}
 		}
@@ -439,6 +504,14 @@ bool COctreeSceneNode::createTree(IMesh* mesh)
 							for (v=0; v<b->getVertexCount(); ++v)
 								nchunk.Vertices.push_back(((video::S3DVertexTangents*)b->getVertices())[v]);
 							break;
+						case video::EVT_QUANTIZED:
+							for (v=0; v<b->getVertexCount(); ++v)
+								nchunk.Vertices.push_back(((const video::S3DVertexQuantized*)b->getVertices())[v].get(b->getVertexQuantization()));
+							break;
+						case video::EVT_QUANTIZED_TANGENTS:
+							for (v=0; v<b->getVertexCount(); ++v)
+								nchunk.Vertices.push_back(((const video::S3DVertexQuantizedTangents*)b->getVertices())[v].get(b->getVertexQuantization()));
+							break;
 						}
 
 						polyCount += b->getIndexCount();
@@ -449,7 +522,8 @@ bool COctreeSceneNode::createTree(IMesh* mesh)
 					}
 				}
 
-				StdOctree = new Octree<video::S3DVertex>(StdMeshes, MinimalPolysPerNode);
+				setHardwareMappingHints<video::S3DVertex>(StdMeshes, UseVBOs);
+				StdOctree = createOctree<video::S3DVertex>(StdMeshes, MinimalPolysPerNode, treeFile, fromFile);
 				nodeCount = StdOctree->getNodeCount();
 			}
 			break;
@@ -468,14 +542,6 @@ bool COctreeSceneNode::createTree(IMesh* mesh)
 						Octree<video::S3DVertex2TCoords>::SMeshChunk& nchunk = LightMapMeshes.getLast();
 						nchunk.MaterialId = Materials.size() - 1;
 
-						if (UseVBOs == EOV_USE_VBO_WITH_VISIBITLY)
-						{
-							nchunk.setHardwareMappingHint(scene::EHM_STATIC, scene::EBT_VERTEX);
-							nchunk.setHardwareMappingHint(scene::EHM_DYNAMIC, scene::EBT_INDEX);
-						}
-						else
-							nchunk.setHardwareMappingHint(scene::EHM_STATIC);
-
 						u32 v;
 						nchunk.Vertices.reallocate(b->getVertexCount());
 						switch (b->getVertexType())
@@ -492,6 +558,20 @@ bool COctreeSceneNode::createTree(IMesh* mesh)
 							for (v=0; v<b->getVertexCount(); ++v)
 								nchunk.Vertices.push_back(((video::S3DVertexTangents*)b->getVertices())[v]);
 							break;
+						case video::EVT_QUANTIZED:
+							for (v=0; v<b->getVertexCount(); ++v)
+							{
+								video::S3DVertex tmpV = ((const video::S3DVertexQuantized*)b->getVertices())[v].get(b->getVertexQuantization());
+								nchunk.Vertices.push_back(tmpV);
+							}
+							break;
+						case video::EVT_QUANTIZED_TANGENTS:
+							for (v=0; v<b->getVertexCount(); ++v)
+							{
+								video::S3DVertex tmpV = ((const video::S3DVertexQuantizedTangents*)b->getVertices())[v].get(b->getVertexQuantization());
+								nchunk.Vertices.push_back(tmpV);
+							}
+							break;
 						}
 
 						polyCount += b->getIndexCount();
@@ -501,7 +581,8 @@ bool COctreeSceneNode::createTree(IMesh* mesh)
 					}
 				}
 
-				LightMapOctree = new Octree<video::S3DVertex2TCoords>(LightMapMeshes, MinimalPolysPerNode);
+				setHardwareMappingHints<video::S3DVertex2TCoords>(LightMapMeshes, UseVBOs);
+				LightMapOctree = createOctree<video::S3DVertex2TCoords>(LightMapMeshes, MinimalPolysPerNode, treeFile, fromFile);
 				nodeCount = LightMapOctree->getNodeCount();
 			}
 			break;
@@ -542,6 +623,17 @@ bool COctreeSceneNode::createTree(IMesh* mesh)
 							for (v=0; v<b->getVertexCount(); ++v)
 								nchunk.Vertices.push_back(((video::S3DVertexTangents*)b->getVertices())[v]);
 							break;
+						case video::EVT_QUANTIZED:
+							for (v=0; v<b->getVertexCount(); ++v)
+							{
+								const video::S3DVertex tmpV = ((const video::S3DVertexQuantized*)b->getVertices())[v].get(b->getVertexQuantization());
+								nchunk.Vertices.push_back(video::S3DVertexTangents(tmpV.Pos, tmpV.Color, tmpV.TCoords));
+							}
+							break;
+						case video::EVT_QUANTIZED_TANGENTS:
+							for (v=0; v<b->getVertexCount(); ++v)
+								nchunk.Vertices.push_back(((const video::S3DVertexQuantizedTangents*)b->getVertices())[v].get(b->getVertexQuantization()));
+							break;
 						}
 
 						polyCount += b->getIndexCount();
@@ -551,19 +643,27 @@ bool COctreeSceneNode::createTree(IMesh* mesh)
 					}
 				}
 
-				TangentsOctree = new Octree<video::S3DVertexTangents>(TangentsMeshes, MinimalPolysPerNode);
+				setHardwareMappingHints<video::S3DVertexTangents>(TangentsMeshes, UseVBOs);
+				TangentsOctree = createOctree<video::S3DVertexTangents>(TangentsMeshes, MinimalPolysPerNode, treeFile, fromFile);
 				nodeCount = TangentsOctree->getNodeCount();
 			}
 			break;
+		case video::EVT_QUANTIZED:
+		case video::EVT_QUANTIZED_TANGENTS:
+			// not used, quantized buffers are decoded in createTree()
+			break;
 		}
 	}
 
 	const u32 endTime = os::Timer::getRealTime();
 	c8 tmp[255];
-	sprintf(tmp, "Needed %ums to create Octree SceneNode.(%u nodes, %u polys)",
-		endTime - beginTime, nodeCount, polyCount/3);
+	sprintf(tmp, "Needed %ums to %s Octree SceneNode.(%u nodes, %u polys)",
+		endTime - beginTime, fromFile ? "read" : "create", nodeCount, polyCount/3);
 	os::Printer::log(tmp, ELL_INFORMATION);
 
+	if (treeRead)
+		*treeRead = fromFile;
+
 	return true;
 }
 
@@ -649,9 +749,52 @@ void COctreeSceneNode::deleteTree()
 
 void COctreeSceneNode::setMesh(IMesh* mesh)
 {
+	// the tree of an unchanged mesh is kept
+	if (mesh && mesh == Mesh && MeshChangedIDs.size() == mesh->getMeshBufferCount()*2)
+	{
+		u32 i;
+		for (i=0; i<mesh->getMeshBufferCount(); ++i)
+		{
+			if (MeshChangedIDs[2*i] != mesh->getMeshBuffer(i)->getChangedID_Vertex() ||
+				MeshChangedIDs[2*i+1] != mesh->getMeshBuffer(i)->getChangedID_Index())
+				break;
+		}
+		if (i == mesh->getMeshBufferCount())
+			return;
+	}
+
 	createTree(mesh);
 }
 
+
+//! Writes the octree of the current mesh to a file.
+bool COctreeSceneNode::writeTree(io::IWriteFile* file) const
+{
+	if (!file)
+		return false;
+
+	switch (VertexType)
+	{
+	case video::EVT_STANDARD:
+		return StdOctree && StdOctree->write(StdMeshes, file);
+	case video::EVT_2TCOORDS:
+		return LightMapOctree && LightMapOctree->write(LightMapMeshes, file);
+	case video::EVT_TANGENTS:
+		return TangentsOctree && TangentsOctree->write(TangentsMeshes, file);
+	default:
+		return false;
+	}
+}
+
+
+//! Sets a new mesh and reads its octree from a file.
+bool COctreeSceneNode::readTree(IMesh* mesh, io::IReadFile* file)
+{
+	bool treeRead = false;
+	createTree(mesh, file, &treeRead);
+	return treeRead;
+}
+
 IMesh* COctreeSceneNode::getMesh(void)
 {
 	return Mesh;
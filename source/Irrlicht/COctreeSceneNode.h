@@ -35,7 +35,9 @@ namespace scene
 		virtual const core::aabbox3d<f32>& getBoundingBox() const _IRR_OVERRIDE_;
 
 		//! creates the tree
-		bool createTree(IMesh* mesh);
+		/** \param treeFile If not 0, the tree is read from this file if it fits the mesh.
+		\param treeRead Set to true if the tree was read from the file. */
+		bool createTree(IMesh* mesh, io::IReadFile* treeFile=0, bool* treeRead=0);
 
 		//! returns the material based on the zero based index i. To get the amount
 		//! of materials used by this scene node, use getMaterialCount().
@@ -56,6 +58,9 @@ namespace scene
 		//! Returns type of the scene node
 		virtual ESCENE_NODE_TYPE getType() const _IRR_OVERRIDE_ { return ESNT_OCTREE; }
 
+		//! Uses the transformation handling of ISceneNode
+		virtual bool hasPlainTransformation() const _IRR_OVERRIDE_ { return true; }
+
 		//! Sets a new mesh to display
 		virtual void setMesh(IMesh* mesh) _IRR_OVERRIDE_;
 
@@ -79,8 +84,6 @@ namespace scene
 		virtual bool removeChild(ISceneNode* child) _IRR_OVERRIDE_;
 
 		//! Set if/how vertex buffer object are used for the meshbuffers
-		/** NOTE: When there is already a mesh in the node this will rebuild
-		the octree. */
 		virtual void setUseVBO(EOCTREENODE_VBO useVBO) _IRR_OVERRIDE_;
 
 		//! Get if/how vertex buffer object are used for the meshbuffers
@@ -92,6 +95,12 @@ namespace scene
 		//! Get the kind of tests polygons do for visibility against the camera
 		virtual EOCTREE_POLYGON_CHECKS getPolygonChecks() const _IRR_OVERRIDE_;
 
+		//! Writes the octree of the current mesh to a file.
+		virtual bool writeTree(io::IWriteFile* file) const _IRR_OVERRIDE_;
+
+		//! Sets a new mesh and reads its octree from a file.
+		virtual bool readTree(IMesh* mesh, io::IReadFile* file) _IRR_OVERRIDE_;
+
 	private:
 
 		void deleteTree();
@@ -115,6 +124,8 @@ namespace scene
 		s32 PassCount;
 
 		IMesh * Mesh;
+		// change IDs of the vertices and indices of all mesh buffers when the tree was built
+		core::array<u32> MeshChangedIDs;
 		IShadowVolumeSceneNode* Shadow;
 
 		EOCTREENODE_VBO UseVBOs;
@@ -382,9 +382,19 @@ bool COpenGLDriver::updateVertexHardwareBuffer(SHWBufferLink_opengl *HWBuffer)
 	const scene::IMeshBuffer* mb = HWBuffer->MeshBuffer;
 	const void* vertices=mb->getVertices();
 	const u32 vertexCount=mb->getVertexCount();
-	const E_VERTEX_TYPE vType=mb->getVertexType();
+	const E_VERTEX_TYPE vType=getDecodedVertexType(mb->getVertexType());
 	const u32 vertexSize = getVertexPitchFromType(vType);
 
+	// the vertex arrays of the fixed function pipeline can't decode
+	// quantized vertices, so they are decoded once for the buffer
+	core::array<c8> decoded;
+	if (vType != mb->getVertexType())
+	{
+		decoded.set_used(vertexSize * vertexCount);
+		decodeQuantizedVertices(vertices, vertexCount, mb->getVertexType(), mb->getVertexQuantization(), decoded.pointer());
+		vertices = decoded.const_pointer();
+	}
+
 	const c8* vbuf = static_cast<const c8*>(vertices);
 	core::array<c8> buffer;
 	if (!FeatureAvailable[IRR_ARB_vertex_array_bgra] && !FeatureAvailable[IRR_EXT_vertex_array_bgra])
@@ -670,7 +680,9 @@ void COpenGLDriver::drawHardwareBuffer(SHWBufferLink *_HWBuffer)
 		indexList=0;
 	}
 
-	drawVertexPrimitiveList(vertices, mb->getVertexCount(), indexList, mb->getPrimitiveCount(), mb->getVertexType(), mb->getPrimitiveType(), mb->getIndexType());
+	// quantized vertices are stored decoded in the vertex buffer
+	const E_VERTEX_TYPE vType = vertices ? mb->getVertexType() : getDecodedVertexType(mb->getVertexType());
+	drawVertexPrimitiveList(vertices, mb->getVertexCount(), indexList, mb->getPrimitiveCount(), vType, mb->getPrimitiveType(), mb->getIndexType());
 
 	if (HWBuffer->Mapped_Vertex!=scene::EHM_NEVER)
 		extGlBindBuffer(GL_ARRAY_BUFFER, 0);
@@ -826,6 +838,15 @@ void COpenGLDriver::drawVertexPrimitiveList(const void* vertices, u32 vertexCoun
 
 	CNullDriver::drawVertexPrimitiveList(vertices, vertexCount, indexList, primitiveCount, vType, pType, iType);
 
+	// the vertex arrays of the fixed function pipeline can't decode quantized vertices
+	if (vertices)
+		vertices = decodeQuantizedVertices(vertices, vertexCount, vType);
+	else if (isQuantizedVertexType(vType))
+	{
+		os::Printer::log("Quantized vertices can't be drawn from hardware buffers.", ELL_ERROR);
+		return;
+	}
+
 	if (vertices && !FeatureAvailable[IRR_ARB_vertex_array_bgra] && !FeatureAvailable[IRR_EXT_vertex_array_bgra])
 		getColorBuffer(vertices, vertexCount, vType);
 
@@ -859,6 +880,10 @@ void COpenGLDriver::drawVertexPrimitiveList(const void* vertices, u32 vertexCoun
 				case EVT_TANGENTS:
 					glColorPointer(colorSize, GL_UNSIGNED_BYTE, sizeof(S3DVertexTangents), &(static_cast<const S3DVertexTangents*>(vertices))[0].Color);
 					break;
+				case EVT_QUANTIZED:
+				case EVT_QUANTIZED_TANGENTS:
+					// decoded above
+					break;
 			}
 		}
 		else
@@ -954,6 +979,10 @@ void COpenGLDriver::drawVertexPrimitiveList(const void* vertices, u32 vertexCoun
 					glTexCoordPointer(3, GL_FLOAT, sizeof(S3DVertexTangents), buffer_offset(48));
 			}
 			break;
+		case EVT_QUANTIZED:
+		case EVT_QUANTIZED_TANGENTS:
+			// decoded above
+			break;
 	}
 
 	renderArray(indexList, primitiveCount, pType, iType);
@@ -1014,6 +1043,11 @@ void COpenGLDriver::getColorBuffer(const void* vertices, u32 vertexCount, E_VERT
 			}
 		}
 		break;
+		case EVT_QUANTIZED:
+		case EVT_QUANTIZED_TANGENTS:
+			// callers decode quantized vertices first
+			_IRR_DEBUG_BREAK_IF(true);
+			break;
 	}
 }
 
@@ -1142,6 +1176,15 @@ void COpenGLDriver::draw2DVertexPrimitiveList(const void* vertices, u32 vertexCo
 
 	CNullDriver::draw2DVertexPrimitiveList(vertices, vertexCount, indexList, primitiveCount, vType, pType, iType);
 
+	// the vertex arrays of the fixed function pipeline can't decode quantized vertices
+	if (vertices)
+		vertices = decodeQuantizedVertices(vertices, vertexCount, vType);
+	else if (isQuantizedVertexType(vType))
+	{
+		os::Printer::log("Quantized vertices can't be drawn from hardware buffers.", ELL_ERROR);
+		return;
+	}
+
 	if (vertices && !FeatureAvailable[IRR_ARB_vertex_array_bgra] && !FeatureAvailable[IRR_EXT_vertex_array_bgra])
 		getColorBuffer(vertices, vertexCount, vType);
 
@@ -1186,6 +1229,10 @@ void COpenGLDriver::draw2DVertexPrimitiveList(const void* vertices, u32 vertexCo
 				case EVT_TANGENTS:
 					glColorPointer(colorSize, GL_UNSIGNED_BYTE, sizeof(S3DVertexTangents), &(static_cast<const S3DVertexTangents*>(vertices))[0].Color);
 					break;
+				case EVT_QUANTIZED:
+				case EVT_QUANTIZED_TANGENTS:
+					// decoded above
+					break;
 			}
 		}
 		else
@@ -1257,6 +1304,10 @@ void COpenGLDriver::draw2DVertexPrimitiveList(const void* vertices, u32 vertexCo
 				glVertexPointer(2, GL_FLOAT, sizeof(S3DVertexTangents), buffer_offset(0));
 			}
 
+			break;
+		case EVT_QUANTIZED:
+		case EVT_QUANTIZED_TANGENTS:
+			// decoded above
 			break;
 	}
 
@@ -97,7 +97,7 @@ bool CPLYMeshWriter::writeMesh(io::IWriteFile* file, scene::IMesh* mesh, s32 fla
 
 	for (u32 i=0; i < mesh->getMeshBufferCount(); ++i)
 	{
-		scene::IMeshBuffer* mb = mesh->getMeshBuffer(i);
+		const scene::IMeshBuffer* mb = mesh->getMeshBuffer(i);
 		for (u32 j=0; j < mb->getVertexCount(); ++j)
 		{
 			const core::vector3df& pos = mb->getPosition(j);
@@ -116,6 +116,12 @@ bool CPLYMeshWriter::writeMesh(io::IWriteFile* file, scene::IMesh* mesh, s32 fla
 			case video::EVT_TANGENTS:
 				buf += sizeof(video::S3DVertexTangents)*j;
 				break;
+			case video::EVT_QUANTIZED:
+				buf += sizeof(video::S3DVertexQuantized)*j;
+				break;
+			case video::EVT_QUANTIZED_TANGENTS:
+				buf += sizeof(video::S3DVertexQuantizedTangents)*j;
+				break;
 			}
 //			video::SColor &col = ( (video::S3DVertex*)buf )->Color;
 
@@ -0,0 +1,516 @@
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#include "CPagedTerrainSceneNode.h"
+#include "CDynamicMeshBuffer.h"
+#include "ISceneManager.h"
+#include "IVideoDriver.h"
+#include "ICameraSceneNode.h"
+#include "IReadFile.h"
+#include "CReadFile.h"
+#include "SViewFrustum.h"
+#include "os.h"
+#include <limits.h>
+
+namespace irr
+{
+namespace scene
+{
+
+//! Heights are stored as 16 bit values, 256 of them are one unit
+static const f32 HEIGHT_SCALE = 1.f / 256.f;
+
+
+CPagedTerrainSceneNode::STile::STile(CPagedTerrainSceneNode* terrain, u32 x, u32 z)
+	: Terrain(terrain), X(x), Z(z), MeshBuffer(0), Memory(0), LastUsed(0),
+	LOD(-1), IndexKey(0xffffffff), Loaded(false)
+{
+}
+
+
+CPagedTerrainSceneNode::STile::~STile()
+{
+	if (MeshBuffer)
+		MeshBuffer->drop();
+}
+
+
+//! constructor
+CPagedTerrainSceneNode::CPagedTerrainSceneNode(io::IReadFile* file, const core::dimension2du& heightmapSize,
+		u32 tileSize, s32 maxLOD, ISceneNode* parent, ISceneManager* mgr, s32 id,
+		const core::vector3df& position, const core::vector3df& rotation,
+		const core::vector3df& scale)
+	: IPagedTerrainSceneNode(parent, mgr, id, position, rotation, scale),
+	File(0), LoaderOwnsFile(false), Loader(0), HeightmapSize(heightmapSize), TileSize(4),
+	LoadedTileCount(0), PendingTileCount(0), MaxPendingTiles(8),
+	MemoryBudget(64*1024*1024), MemoryUsed(0), LoadDistance(0.f), LODDistance(0.f), Frame(0)
+{
+	#ifdef _DEBUG
+	setDebugName("CPagedTerrainSceneNode");
+	#endif
+
+	// files on disk are opened again, which gives the loading thread its own handle
+	if (file && file->getType() == io::ERFT_READ_FILE)
+		File = io::CReadFile::createReadFile(file->getFileName());
+	if (File)
+		LoaderOwnsFile = true;
+	else
+	{
+		File = file;
+		if (File)
+			File->grab();
+	}
+
+	// tiles are a power of two, for the LODs
+	while (TileSize < tileSize && TileSize < 1024)
+		TileSize <<= 1;
+
+	HeightmapSize.Width = core::max_(HeightmapSize.Width, 2u);
+	HeightmapSize.Height = core::max_(HeightmapSize.Height, 2u);
+
+	// IReadFile::seek() takes a long, which has only 32 bits on some systems
+	const u64 fileSize = (u64)HeightmapSize.Width * HeightmapSize.Height * sizeof(u16);
+	if (fileSize > (u64)LONG_MAX || HeightmapSize.Width > (u32)INT_MAX || HeightmapSize.Height > (u32)INT_MAX)
+	{
+		os::Printer::log("Heightmap of paged terrain is too large for the file functions", ELL_ERROR);
+		if (File)
+			File->drop();
+		File = 0;
+		LoaderOwnsFile = false;
+		HeightmapSize.set(2, 2);
+	}
+	TileCount.Width = (HeightmapSize.Width - 2) / TileSize + 1;
+	TileCount.Height = (HeightmapSize.Height - 2) / TileSize + 1;
+
+	BoundingBox.reset(0.f, 0.f, 0.f);
+	BoundingBox.addInternalPoint((f32)(HeightmapSize.Width - 1), 65535 * HEIGHT_SCALE, (f32)(HeightmapSize.Height - 1));
+
+	IndexTemplates.create(TileSize, TileSize + 1, maxLOD);
+	Material.NormalizeNormals = true;
+
+	Loader = new CWorkerThread();
+
+	// the node culls its tiles itself
+	setAutomaticCulling(EAC_OFF);
+}
+
+
+//! destructor
+CPagedTerrainSceneNode::~CPagedTerrainSceneNode()
+{
+	// stops loading, tiles which are still queued are dropped
+	Loader->drop();
+
+	core::map<u32, STile*>::Iterator it = Tiles.getIterator();
+	for (; !it.atEnd(); it++)
+		delete it->getValue();
+
+	if (File)
+		File->drop();
+}
+
+
+//! Job of the loading thread
+void CPagedTerrainSceneNode::loadTileJob(void* tile, u32 index)
+{
+	STile* t = (STile*)tile;
+	t->Terrain->loadTile(t);
+}
+
+
+//! Reads the heights of a tile and one more sample around it, for the
+//! normals. The index is x * (TileSize+3) + z, samples outside of the
+//! heightmap are repeated from its border.
+void CPagedTerrainSceneNode::readSamples(const STile* tile, core::array<u16>& samples)
+{
+	const s32 size = TileSize + 1;
+	const s32 width = HeightmapSize.Width;
+	const s32 height = HeightmapSize.Height;
+	const s32 firstX = tile->X * TileSize;
+	const s32 firstZ = tile->Z * TileSize;
+
+	const s32 border = size + 2;
+	samples.set_used(border * border);
+	core::array<u16> row;
+	row.set_used(border);
+
+	const s32 rowStart = core::clamp(firstX - 1, 0, width - 1);
+	const s32 rowEnd = core::clamp(firstX + size, 0, width - 1);
+	for (s32 z = 0; z < border; ++z)
+	{
+		const s32 fileZ = core::clamp(firstZ - 1 + z, 0, height - 1);
+		const s32 count = rowEnd - rowStart + 1;
+
+		bool ok = false;
+		// the constructor made sure that the offset fits into a long
+		const u64 offset = ((u64)fileZ * width + rowStart) * sizeof(u16);
+		if (File && File->seek((long)offset))
+			ok = File->read(row.pointer(), count * sizeof(u16)) == (size_t)(count * sizeof(u16));
+		if (!ok)
+			memset(row.pointer(), 0, count * sizeof(u16));
+
+		for (s32 x = 0; x < border; ++x)
+			samples[x * border + z] = row[core::clamp(firstX - 1 + x, 0, width - 1) - rowStart];
+	}
+}
+
+
+//! Creates the vertices of a tile. Runs on the loading thread, which only
+//! reads the file when it was opened for it.
+void CPagedTerrainSceneNode::loadTile(STile* tile)
+{
+	const s32 size = TileSize + 1;
+	const s32 width = HeightmapSize.Width;
+	const s32 height = HeightmapSize.Height;
+	const s32 firstX = tile->X * TileSize;
+	const s32 firstZ = tile->Z * TileSize;
+	const s32 border = size + 2;
+
+	if (LoaderOwnsFile)
+		readSamples(tile, tile->Samples);
+	const core::array<u16>& samples = tile->Samples;
+
+	CDynamicMeshBuffer* mb = new CDynamicMeshBuffer(video::EVT_STANDARD,
+		(size * size > 0x10000) ? video::EIT_32BIT : video::EIT_16BIT);
+	mb->setHardwareMappingHint(EHM_STATIC, EBT_VERTEX);
+	mb->setHardwareMappingHint(EHM_DYNAMIC, EBT_INDEX);
+	mb->getVertexBuffer().reallocate(size * size);
+	tile->Heights.reallocate(size * size);
+
+	video::S3DVertex vertex;
+	vertex.Color.set(255, 255, 255, 255);
+	const f32 tcoordX = 1.f / (width - 1);
+	const f32 tcoordZ = 1.f / (height - 1);
+
+	for (s32 x = 0; x < size; ++x)
+	{
+		for (s32 z = 0; z < size; ++z)
+		{
+			const u16* s = samples.const_pointer() + (x + 1) * border + (z + 1);
+			tile->Heights.push_back(*s);
+
+			vertex.Pos.set((f32)(firstX + x), *s * HEIGHT_SCALE, (f32)(firstZ + z));
+			vertex.Normal.set((s[-border] - s[border]) * HEIGHT_SCALE, 2.f, (s[-1] - s[1]) * HEIGHT_SCALE);
+			vertex.Normal.normalize();
+			vertex.TCoords.set(vertex.Pos.X * tcoordX, vertex.Pos.Z * tcoordZ);
+			mb->getVertexBuffer().push_back(vertex);
+		}
+	}
+	mb->recalculateBoundingBox();
+
+	tile->Samples.clear();
+	tile->BoundingBox = mb->getBoundingBox();
+	tile->MeshBuffer = mb;
+	tile->Memory = size * size * (sizeof(video::S3DVertex) + sizeof(u16));
+
+	CMutexLock lock(LoadedTilesMutex);
+	LoadedTiles.push_back(tile);
+}
+
+
+//! Takes over the tiles which were loaded since the last frame
+void CPagedTerrainSceneNode::addLoadedTiles()
+{
+	LoadedTilesMutex.lock();
+	for (u32 i = 0; i < LoadedTiles.size(); ++i)
+	{
+		STile* tile = LoadedTiles[i];
+		tile->Loaded = true;
+		tile->LastUsed = Frame;
+		MemoryUsed += tile->Memory;
+		++LoadedTileCount;
+		--PendingTileCount;
+	}
+	LoadedTiles.set_used(0);
+	LoadedTilesMutex.unlock();
+}
+
+
+//! Releases the tiles not used for the longest time until the memory budget is met
+void CPagedTerrainSceneNode::releaseTiles()
+{
+	while (MemoryUsed > MemoryBudget)
+	{
+		STile* oldest = 0;
+		core::map<u32, STile*>::Iterator it = Tiles.getIterator();
+		for (; !it.atEnd(); it++)
+		{
+			STile* tile = it->getValue();
+			if (tile->Loaded && tile->LastUsed != Frame && (!oldest || tile->LastUsed < oldest->LastUsed))
+				oldest = tile;
+		}
+
+		if (!oldest)
+			break;
+
+		MemoryUsed -= oldest->Memory;
+		--LoadedTileCount;
+		Tiles.remove(oldest->Z * TileCount.Width + oldest->X);
+		delete oldest;
+	}
+}
+
+
+//! Returns the bounding box of a tile, with the full height range if it is not loaded yet
+core::aabbox3df CPagedTerrainSceneNode::getTileBox(u32 tileX, u32 tileZ) const
+{
+	const STile* tile = findTile(tileX, tileZ);
+	if (tile && tile->Loaded)
+		return tile->BoundingBox;
+
+	const f32 firstX = (f32)(tileX * TileSize);
+	const f32 firstZ = (f32)(tileZ * TileSize);
+	return core::aabbox3df(firstX, BoundingBox.MinEdge.Y, firstZ,
+		core::min_(firstX + TileSize, BoundingBox.MaxEdge.X), BoundingBox.MaxEdge.Y,
+		core::min_(firstZ + TileSize, BoundingBox.MaxEdge.Z));
+}
+
+
+//! Returns a tile if it is loaded or being loaded
+CPagedTerrainSceneNode::STile* CPagedTerrainSceneNode::findTile(u32 tileX, u32 tileZ) const
+{
+	if (tileX >= TileCount.Width || tileZ >= TileCount.Height)
+		return 0;
+
+	core::map<u32, STile*>::Node* node = Tiles.find(tileZ * TileCount.Width + tileX);
+	return node ? node->getValue() : 0;
+}
+
+
+//! Updates the index buffer of a drawn tile to its LOD and the LODs of its
+//! neighbours. The vertices are stored in the same order as in
+//! CTerrainSceneNode, so the sides of the templates are x-1, x+1, z-1 and z+1.
+void CPagedTerrainSceneNode::updateIndices(STile* tile)
+{
+	const STile* neighbours[CTerrainIndexTemplates::ES_COUNT] =
+	{
+		tile->X > 0 ? findTile(tile->X - 1, tile->Z) : 0,
+		findTile(tile->X + 1, tile->Z),
+		tile->Z > 0 ? findTile(tile->X, tile->Z - 1) : 0,
+		findTile(tile->X, tile->Z + 1)
+	};
+
+	s32 neighbourLODs[CTerrainIndexTemplates::ES_COUNT];
+	for (s32 side = 0; side < CTerrainIndexTemplates::ES_COUNT; ++side)
+		neighbourLODs[side] = neighbours[side] ? neighbours[side]->LOD : -1;
+
+	const u32 key = IndexTemplates.getKey(tile->LOD, neighbourLODs);
+	if (key == tile->IndexKey)
+		return;
+
+	IIndexBuffer& indexBuffer = tile->MeshBuffer->getIndexBuffer();
+	const u32 oldSize = indexBuffer.allocated_size() * indexBuffer.stride();
+	indexBuffer.set_used(IndexTemplates.getIndexCount(key));
+	IndexTemplates.getIndices(key, 0, indexBuffer.getType(), indexBuffer.pointer());
+	tile->MeshBuffer->setDirty(EBT_INDEX);
+	tile->IndexKey = key;
+
+	// index buffers only grow
+	const u32 newSize = indexBuffer.allocated_size() * indexBuffer.stride();
+	tile->Memory += newSize - oldSize;
+	MemoryUsed += newSize - oldSize;
+}
+
+
+void CPagedTerrainSceneNode::OnRegisterSceneNode()
+{
+	if (!IsVisible)
+		return;
+
+	const ICameraSceneNode* camera = SceneManager->getActiveCamera();
+	if (!camera)
+		return;
+
+	++Frame;
+	addLoadedTiles();
+
+	for (u32 i = 0; i < VisibleTiles.size(); ++i)
+		VisibleTiles[i]->LOD = -1;
+	VisibleTiles.set_used(0);
+
+	// frustum in the space of the heightmap
+	SViewFrustum frust = *camera->getViewFrustum();
+	core::matrix4 invTrans(AbsoluteTransformation, core::matrix4::EM4CONST_INVERSE);
+	frust.transform(invTrans);
+	const core::vector3df cameraPosition = camera->getAbsolutePosition();
+
+	// tiles which can be visible or are near enough to be loaded
+	core::aabbox3df area = frust.getBoundingBox();
+	if (LoadDistance > 0.f)
+	{
+		core::aabbox3df near(cameraPosition - core::vector3df(LoadDistance),
+			cameraPosition + core::vector3df(LoadDistance));
+		invTrans.transformBoxEx(near);
+		area.addInternalBox(near);
+	}
+	const s32 minX = core::clamp(core::floor32(area.MinEdge.X / TileSize), 0, (s32)TileCount.Width - 1);
+	const s32 maxX = core::clamp(core::floor32(area.MaxEdge.X / TileSize), 0, (s32)TileCount.Width - 1);
+	const s32 minZ = core::clamp(core::floor32(area.MinEdge.Z / TileSize), 0, (s32)TileCount.Height - 1);
+	const s32 maxZ = core::clamp(core::floor32(area.MaxEdge.Z / TileSize), 0, (s32)TileCount.Height - 1);
+
+	const f32 lodDistance = (LODDistance > 0.f) ? LODDistance :
+		2.f * TileSize * core::max_(getAbsoluteTransformation().getScale().X, getAbsoluteTransformation().getScale().Z);
+
+	// tiles to load, sorted by distance
+	core::array<core::vector2d<f32> > requests;
+
+	for (s32 z = minZ; z <= maxZ; ++z)
+	{
+		for (s32 x = minX; x <= maxX; ++x)
+		{
+			core::aabbox3df box = getTileBox(x, z);
+
+			bool visible = true;
+			for (u32 p = 0; p < SViewFrustum::VF_PLANE_COUNT && visible; ++p)
+				visible = box.classifyPlaneRelation(frust.planes[p]) != core::ISREL3D_FRONT;
+
+			AbsoluteTransformation.transformBoxEx(box);
+			const core::vector3df closest(
+				core::clamp(cameraPosition.X, box.MinEdge.X, box.MaxEdge.X),
+				core::clamp(cameraPosition.Y, box.MinEdge.Y, box.MaxEdge.Y),
+				core::clamp(cameraPosition.Z, box.MinEdge.Z, box.MaxEdge.Z));
+			const f32 distance = closest.getDistanceFrom(cameraPosition);
+
+			if (!visible && distance >= LoadDistance)
+				continue;
+
+			STile* tile = findTile(x, z);
+			if (!tile)
+			{
+				requests.push_back(core::vector2d<f32>(distance, (f32)(z * TileCount.Width + x)));
+				continue;
+			}
+
+			tile->LastUsed = Frame;
+			if (!visible || !tile->Loaded)
+				continue;
+
+			// each LOD is used up to twice the distance of the previous one
+			s32 lod = 0;
+			for (f32 d = lodDistance; distance >= d && lod < IndexTemplates.getLODCount() - 1; d *= 2.f)
+				++lod;
+			tile->LOD = lod;
+			VisibleTiles.push_back(tile);
+		}
+	}
+
+	for (u32 i = 0; i < VisibleTiles.size(); ++i)
+		updateIndices(VisibleTiles[i]);
+
+	// request the nearest tiles first
+	requests.sort();
+	for (u32 i = 0; i < requests.size() && PendingTileCount < MaxPendingTiles; ++i)
+	{
+		const u32 key = (u32)requests[i].Y;
+		STile* tile = new STile(this, key % TileCount.Width, key / TileCount.Width);
+		tile->LastUsed = Frame;
+		Tiles.insert(key, tile);
+		++PendingTileCount;
+		if (!LoaderOwnsFile)
+			readSamples(tile, tile->Samples);
+		Loader->post(loadTileJob, tile, 0);
+	}
+
+	// without threads the tiles are loaded already
+	addLoadedTiles();
+	releaseTiles();
+
+	if (VisibleTiles.size())
+		SceneManager->registerNodeForRendering(this);
+
+	ISceneNode::OnRegisterSceneNode();
+}
+
+
+//! renders the node.
+void CPagedTerrainSceneNode::render()
+{
+	video::IVideoDriver* driver = SceneManager->getVideoDriver();
+	if (!driver)
+		return;
+
+	driver->setTransform(video::ETS_WORLD, AbsoluteTransformation);
+	driver->setMaterial(Material);
+
+	for (u32 i = 0; i < VisibleTiles.size(); ++i)
+		driver->drawMeshBuffer(VisibleTiles[i]->MeshBuffer);
+
+	// for debug purposes only:
+	if (DebugDataVisible)
+	{
+		video::SMaterial m;
+		m.Lighting = false;
+		driver->setMaterial(m);
+
+		if (DebugDataVisible & EDS_BBOX)
+			driver->draw3DBox(BoundingBox, video::SColor(255,255,255,255));
+		if (DebugDataVisible & EDS_BBOX_BUFFERS)
+		{
+			for (u32 i = 0; i < VisibleTiles.size(); ++i)
+				driver->draw3DBox(VisibleTiles[i]->BoundingBox, video::SColor(255,255,0,0));
+		}
+	}
+}
+
+
+//! Returns the height of the terrain at a position, from loaded tiles only
+f32 CPagedTerrainSceneNode::getHeight(f32 x, f32 z) const
+{
+	core::vector3df pos(x, 0.f, z);
+	core::matrix4 invTrans(AbsoluteTransformation, core::matrix4::EM4CONST_INVERSE);
+	invTrans.transformVect(pos);
+
+	if (pos.X < 0.f || pos.Z < 0.f ||
+		pos.X > HeightmapSize.Width - 1 || pos.Z > HeightmapSize.Height - 1)
+		return -FLT_MAX;
+
+	const u32 tileX = core::min_((u32)pos.X / TileSize, TileCount.Width - 1);
+	const u32 tileZ = core::min_((u32)pos.Z / TileSize, TileCount.Height - 1);
+	const STile* tile = findTile(tileX, tileZ);
+	if (!tile || !tile->Loaded)
+		return -FLT_MAX;
+
+	// quad inside the tile, the last samples belong to the tile before
+	const f32 tx = pos.X - tileX * TileSize;
+	const f32 tz = pos.Z - tileZ * TileSize;
+	const s32 X = core::min_(core::floor32(tx), (s32)TileSize - 1);
+	const s32 Z = core::min_(core::floor32(tz), (s32)TileSize - 1);
+	const s32 size = TileSize + 1;
+
+	const f32 a = tile->Heights[X * size + Z] * HEIGHT_SCALE;
+	const f32 b = tile->Heights[(X + 1) * size + Z] * HEIGHT_SCALE;
+	const f32 c = tile->Heights[X * size + Z + 1] * HEIGHT_SCALE;
+	const f32 d = tile->Heights[(X + 1) * size + Z + 1] * HEIGHT_SCALE;
+
+	// the quads are split from (X,Z) to (X+1,Z+1)
+	const f32 dx = tx - X;
+	const f32 dz = tz - Z;
+	pos.Y = (dx > dz) ? a + (d - b) * dz + (b - a) * dx : a + (d - c) * dx + (c - a) * dz;
+
+	AbsoluteTransformation.transformVect(pos);
+	return pos.Y;
+}
+
+
+bool CPagedTerrainSceneNode::isTileLoaded(u32 tileX, u32 tileZ) const
+{
+	const STile* tile = findTile(tileX, tileZ);
+	return tile && tile->Loaded;
+}
+
+
+s32 CPagedTerrainSceneNode::getTileLOD(u32 tileX, u32 tileZ) const
+{
+	const STile* tile = findTile(tileX, tileZ);
+	return tile ? tile->LOD : -1;
+}
+
+
+//! Waits until all tiles requested so far are loaded
+void CPagedTerrainSceneNode::waitForTiles()
+{
+	Loader->wait();
+}
+
+} // end namespace scene
+} // end namespace irr
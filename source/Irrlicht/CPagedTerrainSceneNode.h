@@ -0,0 +1,167 @@
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#ifndef __C_PAGED_TERRAIN_SCENE_NODE_H_INCLUDED__
+#define __C_PAGED_TERRAIN_SCENE_NODE_H_INCLUDED__
+
+#include "IPagedTerrainSceneNode.h"
+#include "irrMap.h"
+#include "CTerrainIndexTemplates.h"
+#include "CThreadPool.h"
+
+namespace irr
+{
+namespace io
+{
+	class IReadFile;
+}
+namespace scene
+{
+	class CDynamicMeshBuffer;
+
+	//! Scene node for terrains which are loaded tile by tile on a background thread
+	class CPagedTerrainSceneNode : public IPagedTerrainSceneNode
+	{
+	public:
+
+		//! constructor
+		/** \param file RAW file with 16 bit heights, rows along the x axis.
+		\param heightmapSize Number of samples in x and z direction.
+		\param tileSize Number of quads along a side of a tile, a power of two.
+		\param maxLOD Number of levels of detail. */
+		CPagedTerrainSceneNode(io::IReadFile* file, const core::dimension2du& heightmapSize,
+			u32 tileSize, s32 maxLOD, ISceneNode* parent, ISceneManager* mgr, s32 id,
+			const core::vector3df& position = core::vector3df(0,0,0),
+			const core::vector3df& rotation = core::vector3df(0,0,0),
+			const core::vector3df& scale = core::vector3df(1.0f, 1.0f, 1.0f));
+
+		//! destructor
+		virtual ~CPagedTerrainSceneNode();
+
+		virtual void OnRegisterSceneNode() _IRR_OVERRIDE_;
+
+		//! renders the node.
+		virtual void render() _IRR_OVERRIDE_;
+
+		//! returns the axis aligned bounding box of this node
+		virtual const core::aabbox3d<f32>& getBoundingBox() const _IRR_OVERRIDE_ { return BoundingBox; }
+
+		//! returns the material based on the zero based index i.
+		virtual video::SMaterial& getMaterial(u32 i) _IRR_OVERRIDE_ { return Material; }
+
+		//! returns amount of materials used by this scene node.
+		virtual u32 getMaterialCount() const _IRR_OVERRIDE_ { return 1; }
+
+		//! Returns type of the scene node
+		virtual ESCENE_NODE_TYPE getType() const _IRR_OVERRIDE_ { return ESNT_PAGED_TERRAIN; }
+
+		virtual f32 getHeight(f32 x, f32 z) const _IRR_OVERRIDE_;
+		virtual const core::dimension2du& getHeightmapSize() const _IRR_OVERRIDE_ { return HeightmapSize; }
+		virtual u32 getTileSize() const _IRR_OVERRIDE_ { return TileSize; }
+		virtual const core::dimension2du& getTileCount() const _IRR_OVERRIDE_ { return TileCount; }
+		virtual bool isTileLoaded(u32 tileX, u32 tileZ) const _IRR_OVERRIDE_;
+		virtual s32 getTileLOD(u32 tileX, u32 tileZ) const _IRR_OVERRIDE_;
+		virtual u32 getLoadedTileCount() const _IRR_OVERRIDE_ { return LoadedTileCount; }
+		virtual u32 getPendingTileCount() const _IRR_OVERRIDE_ { return PendingTileCount; }
+		virtual void waitForTiles() _IRR_OVERRIDE_;
+		virtual void setMemoryBudget(u32 bytes) _IRR_OVERRIDE_ { MemoryBudget = bytes; }
+		virtual u32 getMemoryBudget() const _IRR_OVERRIDE_ { return MemoryBudget; }
+		virtual u32 getMemoryUsed() const _IRR_OVERRIDE_ { return MemoryUsed; }
+		virtual void setLoadDistance(f32 distance) _IRR_OVERRIDE_ { LoadDistance = distance; }
+		virtual f32 getLoadDistance() const _IRR_OVERRIDE_ { return LoadDistance; }
+		virtual void setLODDistance(f32 distance) _IRR_OVERRIDE_ { LODDistance = distance; }
+		virtual f32 getLODDistance() const _IRR_OVERRIDE_ { return LODDistance; }
+
+	private:
+
+		struct STile
+		{
+			STile(CPagedTerrainSceneNode* terrain, u32 x, u32 z);
+			~STile();
+
+			//! Node which loads the tile
+			CPagedTerrainSceneNode* Terrain;
+			u32 X;
+			u32 Z;
+
+			//! Heights around the tile, read before the tile is queued
+			//! when the loading thread can't read the file itself
+			core::array<u16> Samples;
+			//! Heights of the vertices, written by the loading thread
+			core::array<u16> Heights;
+			CDynamicMeshBuffer* MeshBuffer;
+			core::aabbox3df BoundingBox;
+
+			//! Number of bytes used by the tile
+			u32 Memory;
+			//! Last frame in which the tile was needed
+			u32 LastUsed;
+			//! LOD in the current frame, -1 if not drawn
+			s32 LOD;
+			//! Index templates used for the index buffer
+			u32 IndexKey;
+			//! True after the loading thread is done with the tile
+			bool Loaded;
+		};
+
+		//! Job of the loading thread
+		static void loadTileJob(void* tile, u32 index);
+
+		//! Reads the heights of a tile and creates its vertices
+		void loadTile(STile* tile);
+
+		//! Reads the heights of a tile and one more sample around it
+		void readSamples(const STile* tile, core::array<u16>& samples);
+
+		//! Takes over the tiles which were loaded since the last frame
+		void addLoadedTiles();
+
+		//! Releases the tiles not used for the longest time until the memory budget is met
+		void releaseTiles();
+
+		//! Returns the bounding box of a tile, with the full height range if it is not loaded yet
+		core::aabbox3df getTileBox(u32 tileX, u32 tileZ) const;
+
+		//! Returns a tile if it is loaded or being loaded
+		STile* findTile(u32 tileX, u32 tileZ) const;
+
+		//! Updates the index buffer of a drawn tile to its LOD and the LODs of its neighbours
+		void updateIndices(STile* tile);
+
+		io::IReadFile* File;
+		//! True if File was opened for the loading thread. Other files may
+		//! share state with files used by the main thread, like files in
+		//! archives, so they are only read on the main thread.
+		bool LoaderOwnsFile;
+		CWorkerThread* Loader;
+		//! Protects LoadedTiles
+		CMutex LoadedTilesMutex;
+		//! Tiles done by the loading thread since the last frame
+		core::array<STile*> LoadedTiles;
+
+		//! All tiles which are loaded or being loaded, by z * TileCount.Width + x
+		core::map<u32, STile*> Tiles;
+		//! Tiles drawn in the current frame
+		core::array<STile*> VisibleTiles;
+
+		CTerrainIndexTemplates IndexTemplates;
+		video::SMaterial Material;
+		core::aabbox3df BoundingBox;
+		core::dimension2du HeightmapSize;
+		core::dimension2du TileCount;
+		u32 TileSize;
+
+		u32 LoadedTileCount;
+		u32 PendingTileCount;
+		u32 MaxPendingTiles;
+		u32 MemoryBudget;
+		u32 MemoryUsed;
+		f32 LoadDistance;
+		f32 LODDistance;
+		u32 Frame;
+	};
+
+} // end namespace scene
+} // end namespace irr
+
+#endif
@@ -18,7 +18,7 @@ CParticleAttractionAffector::CParticleAttractionAffector(
 		const core::vector3df& point, f32 speed, bool attract,
 		bool affectX, bool affectY, bool affectZ )
 	: Point(point), Speed(speed), AffectX(affectX), AffectY(affectY),
-		AffectZ(affectZ), Attract(attract), LastTime(0)
+		AffectZ(affectZ), Attract(attract), LastTime(0), TimeDelta(0.f)
 {
 	#ifdef _DEBUG
 	setDebugName("CParticleAttractionAffector");
@@ -29,22 +29,30 @@ CParticleAttractionAffector::CParticleAttractionAffector(
 //! Affects an array of particles.
 void CParticleAttractionAffector::affect(u32 now, SParticle* particlearray, u32 count)
 {
-	if( LastTime == 0 )
-	{
-		LastTime = now;
-		return;
-	}
+	beginAffect(now);
+	affectPart(now, particlearray, count);
+}
+
 
-	f32 timeDelta = ( now - LastTime ) / 1000.0f;
+//! Calculates the time since the last update.
+bool CParticleAttractionAffector::beginAffect(u32 now)
+{
+	TimeDelta = LastTime ? ( now - LastTime ) / 1000.0f : 0.f;
 	LastTime = now;
+	return true;
+}
 
-	if( !Enabled )
+
+//! Affects a part of the particles.
+void CParticleAttractionAffector::affectPart(u32 now, SParticle* particlearray, u32 count)
+{
+	if( !Enabled || TimeDelta == 0.f )
 		return;
 
 	for(u32 i=0; i<count; ++i)
 	{
 		core::vector3df direction = (Point - particlearray[i].pos).normalize();
-		direction *= Speed * timeDelta;
+		direction *= Speed * TimeDelta;
 
 		if( !Attract )
 			direction *= -1.0f;
@@ -28,6 +28,12 @@ public:
 	//! Affects a particle.
 	virtual void affect(u32 now, SParticle* particlearray, u32 count) _IRR_OVERRIDE_;
 
+	//! Calculates the time since the last update.
+	virtual bool beginAffect(u32 now) _IRR_OVERRIDE_;
+
+	//! Affects a part of the particles.
+	virtual void affectPart(u32 now, SParticle* particlearray, u32 count) _IRR_OVERRIDE_;
+
 	//! Set the point that particles will attract to
 	virtual void setPoint( const core::vector3df& point ) _IRR_OVERRIDE_ { Point = point; }
 
@@ -79,6 +85,7 @@ private:
 	bool AffectZ;
 	bool Attract;
 	u32 LastTime;
+	f32 TimeDelta;
 };
 
 } // end namespace scene
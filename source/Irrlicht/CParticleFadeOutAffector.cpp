@@ -30,6 +30,13 @@ CParticleFadeOutAffector::CParticleFadeOutAffector(
 
 //! Affects an array of particles.
 void CParticleFadeOutAffector::affect(u32 now, SParticle* particlearray, u32 count)
+{
+	affectPart(now, particlearray, count);
+}
+
+
+//! Affects a part of the particles.
+void CParticleFadeOutAffector::affectPart(u32 now, SParticle* particlearray, u32 count)
 {
 	if (!Enabled)
 		return;
@@ -26,6 +26,12 @@ public:
 	//! Affects a particle.
 	virtual void affect(u32 now, SParticle* particlearray, u32 count) _IRR_OVERRIDE_;
 
+	//! Particles can be affected in several parts
+	virtual bool beginAffect(u32 now) _IRR_OVERRIDE_ { return true; }
+
+	//! Affects a part of the particles.
+	virtual void affectPart(u32 now, SParticle* particlearray, u32 count) _IRR_OVERRIDE_;
+
 	//! Sets the targetColor, i.e. the color the particles will interpolate
 	//! to over time.
 	virtual void setTargetColor( const video::SColor& targetColor ) _IRR_OVERRIDE_ { TargetColor = targetColor; }
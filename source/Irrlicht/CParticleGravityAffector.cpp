@@ -27,6 +27,13 @@ CParticleGravityAffector::CParticleGravityAffector(
 
 //! Affects an array of particles.
 void CParticleGravityAffector::affect(u32 now, SParticle* particlearray, u32 count)
+{
+	affectPart(now, particlearray, count);
+}
+
+
+//! Affects a part of the particles.
+void CParticleGravityAffector::affectPart(u32 now, SParticle* particlearray, u32 count)
 {
 	if (!Enabled)
 		return;
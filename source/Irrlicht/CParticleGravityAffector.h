@@ -28,6 +28,12 @@ public:
 	//! Affects a particle.
 	virtual void affect(u32 now, SParticle* particlearray, u32 count) _IRR_OVERRIDE_;
 
+	//! Particles can be affected in several parts
+	virtual bool beginAffect(u32 now) _IRR_OVERRIDE_ { return true; }
+
+	//! Affects a part of the particles.
+	virtual void affectPart(u32 now, SParticle* particlearray, u32 count) _IRR_OVERRIDE_;
+
 	//! Set the time in milliseconds when the gravity force is totally
 	//! lost and the particle does not move any more.
 	virtual void setTimeForceLost( f32 timeForceLost ) _IRR_OVERRIDE_ { TimeForceLost = timeForceLost; }
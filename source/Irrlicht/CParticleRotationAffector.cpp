@@ -16,7 +16,7 @@ namespace scene
 
 //! constructor
 CParticleRotationAffector::CParticleRotationAffector( const core::vector3df& speed, const core::vector3df& pivotPoint )
-		: PivotPoint(pivotPoint), Speed(speed), LastTime(0)
+		: PivotPoint(pivotPoint), Speed(speed), LastTime(0), TimeDelta(0.f)
 {
 	#ifdef _DEBUG
 	setDebugName("CParticleRotationAffector");
@@ -27,28 +27,36 @@ CParticleRotationAffector::CParticleRotationAffector( const core::vector3df& spe
 //! Affects an array of particles.
 void CParticleRotationAffector::affect(u32 now, SParticle* particlearray, u32 count)
 {
-	if( LastTime == 0 )
-	{
-		LastTime = now;
-		return;
-	}
+	beginAffect(now);
+	affectPart(now, particlearray, count);
+}
+
 
-	f32 timeDelta = ( now - LastTime ) / 1000.0f;
+//! Calculates the time since the last update.
+bool CParticleRotationAffector::beginAffect(u32 now)
+{
+	TimeDelta = LastTime ? ( now - LastTime ) / 1000.0f : 0.f;
 	LastTime = now;
+	return true;
+}
 
-	if( !Enabled )
+
+//! Affects a part of the particles.
+void CParticleRotationAffector::affectPart(u32 now, SParticle* particlearray, u32 count)
+{
+	if( !Enabled || TimeDelta == 0.f )
 		return;
 
 	for(u32 i=0; i<count; ++i)
 	{
 		if( Speed.X != 0.0f )
-			particlearray[i].pos.rotateYZBy( timeDelta * Speed.X, PivotPoint );
+			particlearray[i].pos.rotateYZBy( TimeDelta * Speed.X, PivotPoint );
 
 		if( Speed.Y != 0.0f )
-			particlearray[i].pos.rotateXZBy( timeDelta * Speed.Y, PivotPoint );
+			particlearray[i].pos.rotateXZBy( TimeDelta * Speed.Y, PivotPoint );
 
 		if( Speed.Z != 0.0f )
-			particlearray[i].pos.rotateXYBy( timeDelta * Speed.Z, PivotPoint );
+			particlearray[i].pos.rotateXYBy( TimeDelta * Speed.Z, PivotPoint );
 	}
 }
 
@@ -26,6 +26,12 @@ public:
 	//! Affects a particle.
 	virtual void affect(u32 now, SParticle* particlearray, u32 count) _IRR_OVERRIDE_;
 
+	//! Calculates the time since the last update.
+	virtual bool beginAffect(u32 now) _IRR_OVERRIDE_;
+
+	//! Affects a part of the particles.
+	virtual void affectPart(u32 now, SParticle* particlearray, u32 count) _IRR_OVERRIDE_;
+
 	//! Set the point that particles will attract to
 	virtual void setPivotPoint( const core::vector3df& point ) _IRR_OVERRIDE_ { PivotPoint = point; }
 
@@ -49,6 +55,7 @@ private:
 	core::vector3df PivotPoint;
 	core::vector3df Speed;
 	u32 LastTime;
+	f32 TimeDelta;
 };
 
 } // end namespace scene
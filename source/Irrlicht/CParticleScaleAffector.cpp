@@ -22,6 +22,12 @@ namespace irr
 
 
 		void CParticleScaleAffector::affect (u32 now, SParticle *particlearray, u32 count)
+		{
+			affectPart(now, particlearray, count);
+		}
+
+
+		void CParticleScaleAffector::affectPart(u32 now, SParticle *particlearray, u32 count)
 		{
 			for(u32 i=0;i<count;i++)
 			{
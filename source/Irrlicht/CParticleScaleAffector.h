@@ -21,6 +21,12 @@ namespace irr
 
 			virtual void affect(u32 now, SParticle *particlearray, u32 count) _IRR_OVERRIDE_;
 
+			//! Particles can be affected in several parts
+			virtual bool beginAffect(u32 now) _IRR_OVERRIDE_ { return true; }
+
+			//! Affects a part of the particles.
+			virtual void affectPart(u32 now, SParticle *particlearray, u32 count) _IRR_OVERRIDE_;
+
 			//! Writes attributes of the object.
 			//! Implement this to expose the attributes of your scene node animator for
 			//! scripting languages, editors, debuggers or xml serialization purposes.
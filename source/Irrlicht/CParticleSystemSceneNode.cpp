@@ -24,12 +24,282 @@
 #include "CParticleRotationAffector.h"
 #include "CParticleScaleAffector.h"
 #include "SViewFrustum.h"
+#include "EProfileIDs.h"
+#include "IProfiler.h"
+
+#ifdef _IRR_COMPILE_WITH_SSE_
+#include <xmmintrin.h>
+#endif
 
 namespace irr
 {
 namespace scene
 {
 
+namespace
+{
+
+// Number of particles which are updated together, few enough to stay in the cache
+const u32 PARTICLE_BLOCK_SIZE = 256;
+
+// Data for the jobs which affect and move parts of the particles
+struct SParticleUpdate
+{
+	SParticle* Particles;
+	u32 Count;
+	u32 JobSize;
+	u32 Now;
+	f32 TimeScale;
+	bool Animate;
+	IParticleAffector* const* Affectors;
+	u32 AffectorCount;
+
+	//! bounding box of the moved particles of each job
+	core::array<core::aabbox3df> Boxes;
+	//! number of moved particles of each job, the others are dead
+	core::array<u32> Moved;
+};
+
+// Runs the affectors on a range of particles and moves the ones which are still alive
+void updateParticleRange(void* userData, u32 job)
+{
+	SParticleUpdate& data = *(SParticleUpdate*)userData;
+	const u32 end = core::min_((job+1)*data.JobSize, data.Count);
+	core::aabbox3df& box = data.Boxes[job];
+	u32 moved = 0;
+
+	for (u32 first=job*data.JobSize; first<end; first+=PARTICLE_BLOCK_SIZE)
+	{
+		SParticle* particles = data.Particles + first;
+		const u32 count = core::min_(PARTICLE_BLOCK_SIZE, end-first);
+
+		for (u32 a=0; a<data.AffectorCount; ++a)
+			data.Affectors[a]->affectPart(data.Now, particles, count);
+
+		if (!data.Animate)
+			continue;
+
+		for (u32 i=0; i<count; ++i)
+		{
+			SParticle& particle = particles[i];
+			if (data.Now > particle.endTime)
+				continue;
+
+			particle.pos += (particle.vector * data.TimeScale);
+			if (moved++)
+				box.addInternalPoint(particle.pos);
+			else
+				box.reset(particle.pos);
+		}
+	}
+	data.Moved[job] = moved;
+}
+
+// Data for the jobs which create the vertices of parts of the particles
+struct SParticleVertices
+{
+	const SParticle* Particles;
+	video::S3DVertex* Vertices;
+	u32 Count;
+	u32 JobSize;
+	//! one camera facing quad per particle, otherwise one point
+	bool Billboards;
+	//! view matrix, its rows are the camera axes
+	core::matrix4 View;
+	//! direction towards the camera
+	core::vector3df Normal;
+	//! particles before this one have the normal already
+	u32 FirstNormal;
+};
+
+#ifdef _IRR_COMPILE_WITH_SSE_
+// Stores x, y and z of a register without touching the memory behind the vector
+inline void storeVector(core::vector3df& v, __m128 value)
+{
+	_mm_storel_pi((__m64*)&v.X, value);
+	_mm_store_ss(&v.Z, _mm_movehl_ps(value, value));
+}
+#endif
+
+// Creates the vertices of a range of particles
+void createParticleVertices(void* userData, u32 job)
+{
+	const SParticleVertices& data = *(const SParticleVertices*)userData;
+	const u32 first = job*data.JobSize;
+	const u32 end = core::min_(first+data.JobSize, data.Count);
+
+	if (!data.Billboards)
+	{
+		video::S3DVertex* vertex = data.Vertices + first;
+		for (u32 i=first; i<end; ++i, ++vertex)
+		{
+			vertex->Pos = data.Particles[i].pos;
+			vertex->Color = data.Particles[i].color;
+			if (i >= data.FirstNormal)
+				vertex->Normal = data.Normal;
+		}
+		return;
+	}
+
+	const core::matrix4& m = data.View;
+#ifdef _IRR_COMPILE_WITH_SSE_
+	const __m128 right = _mm_setr_ps(m[0], m[4], m[8], 0.f);
+	const __m128 up = _mm_setr_ps(m[1], m[5], m[9], 0.f);
+#endif
+	video::S3DVertex* vertices = data.Vertices + first*4;
+
+	for (u32 i=first; i<end; ++i, vertices+=4)
+	{
+		const SParticle& particle = data.Particles[i];
+
+#ifdef _IRR_COMPILE_WITH_SSE_
+		// the fourth lane is the start of particle.vector and ignored
+		const __m128 pos = _mm_loadu_ps(&particle.pos.X);
+		const __m128 horizontal = _mm_mul_ps(right, _mm_set1_ps(0.5f * particle.size.Width));
+		const __m128 vertical = _mm_mul_ps(up, _mm_set1_ps(-0.5f * particle.size.Height));
+		const __m128 leftSide = _mm_sub_ps(pos, horizontal);
+		const __m128 rightSide = _mm_add_ps(pos, horizontal);
+
+		storeVector(vertices[0].Pos, _mm_add_ps(rightSide, vertical));
+		storeVector(vertices[1].Pos, _mm_sub_ps(rightSide, vertical));
+		storeVector(vertices[2].Pos, _mm_sub_ps(leftSide, vertical));
+		storeVector(vertices[3].Pos, _mm_add_ps(leftSide, vertical));
+#else
+		f32 f = 0.5f * particle.size.Width;
+		const core::vector3df horizontal ( m[0] * f, m[4] * f, m[8] * f );
+
+		f = -0.5f * particle.size.Height;
+		const core::vector3df vertical ( m[1] * f, m[5] * f, m[9] * f );
+
+		vertices[0].Pos = particle.pos + horizontal + vertical;
+		vertices[1].Pos = particle.pos + horizontal - vertical;
+		vertices[2].Pos = particle.pos - horizontal - vertical;
+		vertices[3].Pos = particle.pos - horizontal + vertical;
+#endif
+
+		vertices[0].Color = particle.color;
+		vertices[1].Color = particle.color;
+		vertices[2].Color = particle.color;
+		vertices[3].Color = particle.color;
+
+		if (i >= data.FirstNormal)
+		{
+			vertices[0].Normal = data.Normal;
+			vertices[1].Normal = data.Normal;
+			vertices[2].Normal = data.Normal;
+			vertices[3].Normal = data.Normal;
+		}
+	}
+}
+
+// Writes the indices of the particles from first to end
+template <class T>
+void fillParticleIndices(T* indices, u32 first, u32 end, bool billboards)
+{
+	if (!billboards)
+	{
+		for (u32 i=first; i<end; ++i)
+			indices[i] = (T)i;
+		return;
+	}
+
+	indices += first*6;
+	for (u32 i=first; i<end; ++i, indices+=6)
+	{
+		const u32 vertex = i*4;
+		indices[0] = (T)(0+vertex);
+		indices[1] = (T)(2+vertex);
+		indices[2] = (T)(1+vertex);
+		indices[3] = (T)(0+vertex);
+		indices[4] = (T)(3+vertex);
+		indices[5] = (T)(2+vertex);
+	}
+}
+
+// Key which sorts depths from large to small as unsigned integers
+inline u32 getDepthKey(f32 depth)
+{
+	const u32 bits = core::IR(depth);
+	return (bits & 0x80000000) ? bits : ~(bits | 0x80000000);
+}
+
+// Sorts keys by insertion, gives up and returns false after more than maxMoves moves
+template <class T>
+bool insertionSortKeys(T* keys, u32 count, u32 maxMoves)
+{
+	u32 moves = 0;
+	for (u32 i=1; i<count; ++i)
+	{
+		const T key = keys[i];
+		u32 j = i;
+		while (j > 0 && keys[j-1].Key > key.Key)
+		{
+			keys[j] = keys[j-1];
+			--j;
+		}
+		keys[j] = key;
+
+		moves += i-j;
+		if (moves > maxMoves)
+			return false;
+	}
+	return true;
+}
+
+// Sorts keys with a radix sort of 8 bits per pass, temp needs space for count keys
+template <class T>
+void radixSortKeys(T* keys, T* temp, u32 count)
+{
+	if (count < 2)
+		return;
+
+	T* src = keys;
+	T* dst = temp;
+	u32 offsets[256];
+	for (u32 shift=0; shift<32; shift+=8)
+	{
+		memset(offsets, 0, sizeof(offsets));
+		u32 i;
+		for (i=0; i<count; ++i)
+			++offsets[(src[i].Key >> shift) & 0xff];
+
+		// nothing to do if all keys have the same digit
+		if (offsets[(src[0].Key >> shift) & 0xff] == count)
+			continue;
+
+		u32 sum = 0;
+		for (i=0; i<256; ++i)
+		{
+			const u32 digitCount = offsets[i];
+			offsets[i] = sum;
+			sum += digitCount;
+		}
+
+		for (i=0; i<count; ++i)
+			dst[offsets[(src[i].Key >> shift) & 0xff]++] = src[i];
+		core::swap(src, dst);
+	}
+
+	if (src != keys)
+		memcpy(keys, src, count*sizeof(T));
+}
+
+// Merges two sorted ranges of keys into out
+template <class T>
+void mergeKeys(const T* a, u32 countA, const T* b, u32 countB, T* out)
+{
+	const T* endA = a + countA;
+	const T* endB = b + countB;
+	while (a != endA && b != endB)
+		*out++ = (b->Key < a->Key) ? *b++ : *a++;
+	while (a != endA)
+		*out++ = *a++;
+	while (b != endB)
+		*out++ = *b++;
+}
+
+} // end anonymous namespace
+
 //! constructor
 CParticleSystemSceneNode::CParticleSystemSceneNode(bool createDefaultEmitter,
 	ISceneNode* parent, ISceneManager* mgr, s32 id,
@@ -37,13 +307,25 @@ CParticleSystemSceneNode::CParticleSystemSceneNode(bool createDefaultEmitter,
 	const core::vector3df& scale)
 	: IParticleSystemSceneNode(parent, mgr, id, position, rotation, scale),
 	Emitter(0), ParticleSize(core::dimension2d<f32>(5.0f, 5.0f)), LastEmitTime(0),
-	Buffer(0), ParticlesAreGlobal(true)
+	Buffer(0), BufferPrimitive(EPP_BILLBOARD), NormalParticles(0),
+	UpdateThreads(0), UpdateThreadCount(1), MaxParticleCount(0xFFFFFFFF),
+	ParticlePrimitive(EPP_BILLBOARD), SortedCount(0), DepthSorting(false),
+	ParticlesAreGlobal(true)
 {
 	#ifdef _DEBUG
 	setDebugName("CParticleSystemSceneNode");
 	#endif
 
-	Buffer = new SMeshBuffer();
+	IRR_PROFILE(
+		static bool initProfile = false;
+		if (!initProfile )
+		{
+			initProfile = true;
+			getProfiler().add(EPID_PS_SORT, L"sort particles", L"Irrlicht scene");
+		}
+	)
+
+	Buffer = new CDynamicMeshBuffer(video::EVT_STANDARD, video::EIT_16BIT);
 	if (createDefaultEmitter)
 	{
 		IParticleEmitter* e = createBoxEmitter();
@@ -60,6 +342,8 @@ CParticleSystemSceneNode::~CParticleSystemSceneNode()
 		Emitter->drop();
 	if (Buffer)
 		Buffer->drop();
+	if (UpdateThreads)
+		UpdateThreads->drop();
 
 	removeAllAffectors();
 }
@@ -331,63 +615,53 @@ void CParticleSystemSceneNode::render()
 
 #endif
 
-	// reallocate arrays, if they are too small
-	reallocateBuffers();
-
-	// create particle vertex data
-	s32 idx = 0;
-	for (u32 i=0; i<Particles.size(); ++i)
-	{
-		const SParticle& particle = Particles[i];
-
-		#if 0
-			core::vector3df horizontal = camera->getUpVector().crossProduct(view);
-			horizontal.normalize();
-			horizontal *= 0.5f * particle.size.Width;
+	E_PARTICLES_PRIMITIVE primitive = ParticlePrimitive;
+	if (primitive == EPP_POINTSPRITE && !driver->queryFeature(video::EVDF_POINT_SPRITES))
+		primitive = EPP_BILLBOARD;
 
-			core::vector3df vertical = horizontal.crossProduct(view);
-			vertical.normalize();
-			vertical *= 0.5f * particle.size.Height;
-
-		#else
-			f32 f;
-
-			f = 0.5f * particle.size.Width;
-			const core::vector3df horizontal ( m[0] * f, m[4] * f, m[8] * f );
-
-			f = -0.5f * particle.size.Height;
-			const core::vector3df vertical ( m[1] * f, m[5] * f, m[9] * f );
-		#endif
-
-		Buffer->Vertices[0+idx].Pos = particle.pos + horizontal + vertical;
-		Buffer->Vertices[0+idx].Color = particle.color;
-		Buffer->Vertices[0+idx].Normal = view;
-
-		Buffer->Vertices[1+idx].Pos = particle.pos + horizontal - vertical;
-		Buffer->Vertices[1+idx].Color = particle.color;
-		Buffer->Vertices[1+idx].Normal = view;
+	// particles which are not global are only moved with the node
+	core::matrix4 mat;
+	if (!ParticlesAreGlobal)
+		mat.setTranslation(AbsoluteTransformation.getTranslation());
 
-		Buffer->Vertices[2+idx].Pos = particle.pos - horizontal - vertical;
-		Buffer->Vertices[2+idx].Color = particle.color;
-		Buffer->Vertices[2+idx].Normal = view;
+	if (DepthSorting)
+		sortParticles(m * mat);
 
-		Buffer->Vertices[3+idx].Pos = particle.pos - horizontal + vertical;
-		Buffer->Vertices[3+idx].Color = particle.color;
-		Buffer->Vertices[3+idx].Normal = view;
+	// reallocate arrays, if they are too small
+	reallocateBuffers(primitive);
 
-		idx +=4;
+	// the normals only change with the view direction
+	if (view != VertexNormal)
+	{
+		VertexNormal = view;
+		NormalParticles = 0;
 	}
 
+	// create particle vertex data
+	SParticleVertices data;
+	data.Particles = Particles.const_pointer();
+	data.Vertices = Buffer->getVertexBuffer().pointer();
+	data.Count = Particles.size();
+	data.JobSize = getJobSize(data.Count);
+	data.Billboards = primitive == EPP_BILLBOARD;
+	data.View = m;
+	data.Normal = view;
+	data.FirstNormal = NormalParticles;
+	runJobs(createParticleVertices, &data, (data.Count + data.JobSize - 1) / data.JobSize);
+	NormalParticles = core::max_(NormalParticles, data.Count);
+
 	// render all
-	core::matrix4 mat;
-	if (!ParticlesAreGlobal)
-		mat.setTranslation(AbsoluteTransformation.getTranslation());
 	driver->setTransform(video::ETS_WORLD, mat);
 
 	driver->setMaterial(Buffer->Material);
 
-	driver->drawVertexPrimitiveList(Buffer->getVertices(), Particles.size()*4,
-		Buffer->getIndices(), Particles.size()*2, video::EVT_STANDARD, EPT_TRIANGLES,Buffer->getIndexType());
+	if (primitive == EPP_BILLBOARD)
+		driver->drawVertexPrimitiveList(Buffer->getVertices(), Particles.size()*4,
+			Buffer->getIndices(), Particles.size()*2, video::EVT_STANDARD, EPT_TRIANGLES,Buffer->getIndexType());
+	else
+		driver->drawVertexPrimitiveList(Buffer->getVertices(), Particles.size(),
+			Buffer->getIndices(), Particles.size(), video::EVT_STANDARD,
+			primitive == EPP_POINT ? EPT_POINTS : EPT_POINT_SPRITES, Buffer->getIndexType());
 
 	// for debug purposes only:
 	if ( DebugDataVisible & scene::EDS_BBOX )
@@ -424,6 +698,13 @@ void CParticleSystemSceneNode::doParticleSystem(u32 time)
 
 	bool visible = isVisible();
 	int behavior = getParticleBehavior();
+
+	// nothing changes for invisible nodes which don't update their particles
+	if (!visible && !(behavior & (EPB_INVISIBLE_EMITTING|EPB_INVISIBLE_AFFECTING|EPB_INVISIBLE_ANIMATING)))
+	{
+		LastAbsoluteTransformation = AbsoluteTransformation;
+		return;
+	}
 	// run emitter
 
 	if (Emitter && (visible || behavior & EPB_INVISIBLE_EMITTING) )
@@ -434,8 +715,10 @@ void CParticleSystemSceneNode::doParticleSystem(u32 time)
 		if (newParticles && array)
 		{
 			s32 j=Particles.size();
-			if (newParticles > 16250-j)	// avoid having more than 64k vertices in the scenenode
-				newParticles=16250-j;
+			if ((u32)j >= MaxParticleCount)
+				newParticles=0;
+			else if ((u32)newParticles > MaxParticleCount-j)
+				newParticles=MaxParticleCount-j;
 			Particles.set_used(j+newParticles);
 			for (s32 i=j; i<j+newParticles; ++i)
 			{
@@ -486,12 +769,23 @@ void CParticleSystemSceneNode::doParticleSystem(u32 time)
 		}
 	}
 
-	// run affectors
+	// run affectors, the ones which support it together with the movement
+	PartAffectors.set_used(0);
 	if ( visible || behavior & EPB_INVISIBLE_AFFECTING )
 	{
 		core::list<IParticleAffector*>::Iterator ait = AffectorList.begin();
 		for (; ait != AffectorList.end(); ++ait)
-			(*ait)->affect(now, Particles.pointer(), Particles.size());
+		{
+			if ((*ait)->beginAffect(now))
+				PartAffectors.push_back(*ait);
+			else
+			{
+				// keep the order of the affectors
+				updateParticles(now, 0.f, false);
+				PartAffectors.set_used(0);
+				(*ait)->affect(now, Particles.pointer(), Particles.size());
+			}
+		}
 	}
 
 	if (ParticlesAreGlobal)
@@ -500,30 +794,7 @@ void CParticleSystemSceneNode::doParticleSystem(u32 time)
 		Buffer->BoundingBox.reset(core::vector3df(0,0,0));
 
 	// animate all particles
-	if ( visible || behavior & EPB_INVISIBLE_ANIMATING )
-	{
-		f32 scale = (f32)timediff;
-
-		for (u32 i=0; i<Particles.size();)
-		{
-			// erase is pretty expensive!
-			if (now > Particles[i].endTime)
-			{
-				// Particle order does not seem to matter.
-				// So we can delete by switching with last particle and deleting that one.
-				// This is a lot faster and speed is very important here as the erase otherwise
-				// can cause noticable freezes.
-				Particles[i] = Particles[Particles.size()-1];
-				Particles.erase( Particles.size()-1 );
-			}
-			else
-			{
-				Particles[i].pos += (Particles[i].vector * scale);
-				Buffer->BoundingBox.addInternalPoint(Particles[i].pos);
-				++i;
-			}
-		}
-	}
+	updateParticles(now, (f32)timediff, visible || behavior & EPB_INVISIBLE_ANIMATING);
 
 	const f32 m = (ParticleSize.Width > ParticleSize.Height ? ParticleSize.Width : ParticleSize.Height) * 0.5f;
 	Buffer->BoundingBox.MaxEdge.X += m;
@@ -544,6 +815,166 @@ void CParticleSystemSceneNode::doParticleSystem(u32 time)
 }
 
 
+void CParticleSystemSceneNode::updateParticles(u32 now, f32 timeScale, bool animate)
+{
+	if (!animate && PartAffectors.empty())
+		return;
+
+	SParticleUpdate data;
+	data.Particles = Particles.pointer();
+	data.Count = Particles.size();
+	data.JobSize = getJobSize(data.Count);
+	data.Now = now;
+	data.TimeScale = timeScale;
+	data.Animate = animate;
+	data.Affectors = PartAffectors.const_pointer();
+	data.AffectorCount = PartAffectors.size();
+
+	const u32 jobCount = (data.Count + data.JobSize - 1) / data.JobSize;
+	data.Boxes.set_used(jobCount);
+	data.Moved.set_used(jobCount);
+	runJobs(updateParticleRange, &data, jobCount);
+
+	if (!animate)
+		return;
+
+	u32 moved = 0;
+	for (u32 j=0; j<jobCount; ++j)
+	{
+		if (data.Moved[j])
+			Buffer->BoundingBox.addInternalBox(data.Boxes[j]);
+		moved += data.Moved[j];
+	}
+
+	if (DepthSorting && moved < Particles.size())
+	{
+		// keep the order of the living particles for sorting them again
+		u32 kept = 0;
+		u32 sortedKept = 0;
+		for (u32 i=0; i<Particles.size(); ++i)
+		{
+			if (now > Particles[i].endTime)
+				continue;
+			if (i < SortedCount)
+				++sortedKept;
+			if (kept != i)
+				Particles[kept] = Particles[i];
+			++kept;
+		}
+		Particles.set_used(kept);
+		SortedCount = sortedKept;
+	}
+
+	// erase is pretty expensive!
+	for (u32 i=0; moved < Particles.size() && i<Particles.size();)
+	{
+		if (now > Particles[i].endTime)
+		{
+			// Particle order does not seem to matter.
+			// So we can delete by switching with last particle and deleting that one.
+			// This is a lot faster and speed is very important here as the erase otherwise
+			// can cause noticable freezes.
+			Particles[i] = Particles[Particles.size()-1];
+			Particles.erase( Particles.size()-1 );
+		}
+		else
+			++i;
+	}
+}
+
+
+void CParticleSystemSceneNode::sortParticles(const core::matrix4& viewWorld)
+{
+	IRR_PROFILE(CProfileScope p(EPID_PS_SORT);)
+
+	const u32 count = Particles.size();
+	DepthKeys.set_used(count);
+	DepthKeysTemp.set_used(count);
+	for (u32 i=0; i<count; ++i)
+	{
+		const core::vector3df& pos = Particles[i].pos;
+		DepthKeys[i].Key = getDepthKey(viewWorld[2]*pos.X + viewWorld[6]*pos.Y + viewWorld[10]*pos.Z + viewWorld[14]);
+		DepthKeys[i].Index = i;
+	}
+
+	// The first particles are still in the order of the last frame and need only
+	// a few moves, unless the camera turned. New particles are sorted separately.
+	const u32 head = core::min_(SortedCount, count);
+	const u32 tail = count - head;
+	SDepthKey* keys = DepthKeys.pointer();
+	if (!insertionSortKeys(keys, head, head))
+		radixSortKeys(keys, DepthKeysTemp.pointer(), head);
+	if (tail <= 64)
+		insertionSortKeys(keys+head, tail, 0xFFFFFFFF);
+	else
+		radixSortKeys(keys+head, DepthKeysTemp.pointer(), tail);
+
+	if (head && tail)
+	{
+		mergeKeys(keys, head, keys+head, tail, DepthKeysTemp.pointer());
+		DepthKeys.swap(DepthKeysTemp);
+	}
+	SortedCount = count;
+
+	u32 i = 0;
+	while (i<count && DepthKeys[i].Index == i)
+		++i;
+	if (i == count)
+		return;
+
+	// the sorted order is the start for the next frame
+	SortedParticles.set_used(count);
+	for (i=0; i<count; ++i)
+		SortedParticles[i] = Particles[DepthKeys[i].Index];
+	Particles.swap(SortedParticles);
+}
+
+
+//! Sets if the particles are drawn from back to front.
+void CParticleSystemSceneNode::setDepthSorting(bool sort)
+{
+	DepthSorting = sort;
+	SortedCount = 0;
+}
+
+
+u32 CParticleSystemSceneNode::getJobSize(u32 count) const
+{
+	if (UpdateThreadCount < 2)
+		return core::max_(count, 1u);
+
+	// a few jobs per thread balance the work
+	return core::max_(count / (UpdateThreadCount*4) + 1, 4096u);
+}
+
+
+void CParticleSystemSceneNode::runJobs(CThreadPool::JobFunction job, void* userData, u32 jobCount)
+{
+	if (UpdateThreads && jobCount > 1)
+		UpdateThreads->run(job, userData, jobCount);
+	else
+	{
+		for (u32 i=0; i<jobCount; ++i)
+			job(userData, i);
+	}
+}
+
+
+//! Sets the number of threads which update the particles and create their vertices.
+void CParticleSystemSceneNode::setUpdateThreadCount(u32 threadCount)
+{
+	if (threadCount == 0)
+		threadCount = CThreadPool::getProcessorCount();
+	if (threadCount == UpdateThreadCount)
+		return;
+
+	UpdateThreadCount = threadCount;
+	if (UpdateThreads)
+		UpdateThreads->drop();
+	UpdateThreads = threadCount > 1 ? new CThreadPool(threadCount-1) : 0;
+}
+
+
 //! Sets if the particles should be global. If it is, the particles are affected by
 //! the movement of the particle system scene node too, otherwise they completely
 //! ignore it. Default is true.
@@ -556,6 +987,7 @@ void CParticleSystemSceneNode::setParticlesAreGlobal(bool global)
 void CParticleSystemSceneNode::clearParticles()
 {
 	Particles.set_used(0);
+	SortedCount = 0;
 }
 
 //! Sets if the node should be visible or not.
@@ -583,41 +1015,51 @@ void CParticleSystemSceneNode::setParticleSize(const core::dimension2d<f32> &siz
 }
 
 
-void CParticleSystemSceneNode::reallocateBuffers()
+void CParticleSystemSceneNode::reallocateBuffers(E_PARTICLES_PRIMITIVE primitive)
 {
-	if (Particles.size() * 4 > Buffer->getVertexCount() ||
-			Particles.size() * 6 > Buffer->getIndexCount())
+	IVertexBuffer& vertexBuffer = Buffer->getVertexBuffer();
+	IIndexBuffer& indexBuffer = Buffer->getIndexBuffer();
+	const bool billboards = primitive == EPP_BILLBOARD;
+	const u32 verticesPerParticle = billboards ? 4 : 1;
+
+	if (billboards != (BufferPrimitive == EPP_BILLBOARD))
 	{
-		u32 oldSize = Buffer->getVertexCount();
-		Buffer->Vertices.set_used(Particles.size() * 4);
+		// other layout, fill the buffers again
+		vertexBuffer.set_used(0);
+		indexBuffer.set_used(0);
+		NormalParticles = 0;
+	}
+	BufferPrimitive = primitive;
 
-		u32 i;
+	const u32 oldCount = vertexBuffer.size() / verticesPerParticle;
+	if (Particles.size() <= oldCount)
+		return;
 
-		// fill remaining vertices
-		for (i=oldSize; i<Buffer->Vertices.size(); i+=4)
-		{
-			Buffer->Vertices[0+i].TCoords.set(0.0f, 0.0f);
-			Buffer->Vertices[1+i].TCoords.set(0.0f, 1.0f);
-			Buffer->Vertices[2+i].TCoords.set(1.0f, 1.0f);
-			Buffer->Vertices[3+i].TCoords.set(1.0f, 0.0f);
-		}
+	// grow by half at least, so slowly growing particle systems don't reallocate each frame
+	const u32 count = core::max_(Particles.size(), oldCount + oldCount/2);
 
-		// fill remaining indices
-		u32 oldIdxSize = Buffer->getIndexCount();
-		u32 oldvertices = oldSize;
-		Buffer->Indices.set_used(Particles.size() * 6);
+	// 16 bit indices can only address 65536 vertices
+	if (count * verticesPerParticle > 65536 && indexBuffer.getType() == video::EIT_16BIT)
+		indexBuffer.setType(video::EIT_32BIT);
 
-		for (i=oldIdxSize; i<Buffer->Indices.size(); i+=6)
+	vertexBuffer.set_used(count * verticesPerParticle);
+	if (billboards)
+	{
+		video::S3DVertex* vertices = vertexBuffer.pointer();
+		for (u32 i=oldCount*4; i<count*4; i+=4)
 		{
-			Buffer->Indices[0+i] = (u16)0+oldvertices;
-			Buffer->Indices[1+i] = (u16)2+oldvertices;
-			Buffer->Indices[2+i] = (u16)1+oldvertices;
-			Buffer->Indices[3+i] = (u16)0+oldvertices;
-			Buffer->Indices[4+i] = (u16)3+oldvertices;
-			Buffer->Indices[5+i] = (u16)2+oldvertices;
-			oldvertices += 4;
+			vertices[0+i].TCoords.set(0.0f, 0.0f);
+			vertices[1+i].TCoords.set(0.0f, 1.0f);
+			vertices[2+i].TCoords.set(1.0f, 1.0f);
+			vertices[3+i].TCoords.set(1.0f, 0.0f);
 		}
 	}
+
+	indexBuffer.set_used(count * (billboards ? 6 : 1));
+	if (indexBuffer.getType() == video::EIT_32BIT)
+		fillParticleIndices((u32*)indexBuffer.pointer(), oldCount, count, billboards);
+	else
+		fillParticleIndices((u16*)indexBuffer.pointer(), oldCount, count, billboards);
 }
 
 
@@ -629,6 +1071,8 @@ void CParticleSystemSceneNode::serializeAttributes(io::IAttributes* out, io::SAt
 	out->addBool("GlobalParticles", ParticlesAreGlobal);
 	out->addFloat("ParticleWidth", ParticleSize.Width);
 	out->addFloat("ParticleHeight", ParticleSize.Height);
+	out->addEnum("ParticlePrimitive", (s32)ParticlePrimitive, ParticlePrimitiveNames);
+	out->addBool("DepthSorting", DepthSorting);
 
 	// write emitter
 
@@ -670,6 +1114,10 @@ void CParticleSystemSceneNode::deserializeAttributes(io::IAttributes* in, io::SA
 	ParticlesAreGlobal = in->getAttributeAsBool("GlobalParticles");
 	ParticleSize.Width = in->getAttributeAsFloat("ParticleWidth");
 	ParticleSize.Height = in->getAttributeAsFloat("ParticleHeight");
+	if (in->existsAttribute("ParticlePrimitive"))
+		ParticlePrimitive = (E_PARTICLES_PRIMITIVE)in->getAttributeAsEnumeration("ParticlePrimitive", ParticlePrimitiveNames);
+	if (in->existsAttribute("DepthSorting"))
+		setDepthSorting(in->getAttributeAsBool("DepthSorting"));
 
 	// read emitter
 
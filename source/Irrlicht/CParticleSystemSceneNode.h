@@ -11,7 +11,8 @@
 #include "IParticleSystemSceneNode.h"
 #include "irrArray.h"
 #include "irrList.h"
-#include "SMeshBuffer.h"
+#include "CDynamicMeshBuffer.h"
+#include "CThreadPool.h"
 
 namespace irr
 {
@@ -205,6 +206,33 @@ public:
 	//! as the node will care about this otherwise automatically.
 	virtual void doParticleSystem(u32 time) _IRR_OVERRIDE_;
 
+	//! Sets the primitives used to draw the particles.
+	virtual void setParticlePrimitive(E_PARTICLES_PRIMITIVE primitive) _IRR_OVERRIDE_ { ParticlePrimitive = primitive; }
+
+	//! Returns the primitives used to draw the particles.
+	virtual E_PARTICLES_PRIMITIVE getParticlePrimitive() const _IRR_OVERRIDE_ { return ParticlePrimitive; }
+
+	//! Sets if the particles are drawn from back to front.
+	virtual void setDepthSorting(bool sort) _IRR_OVERRIDE_;
+
+	//! Returns if the particles are drawn from back to front.
+	virtual bool getDepthSorting() const _IRR_OVERRIDE_ { return DepthSorting; }
+
+	//! Returns the number of particles which are currently alive.
+	virtual u32 getParticleCount() const _IRR_OVERRIDE_ { return Particles.size(); }
+
+	//! Sets the largest number of particles which are alive at the same time.
+	virtual void setMaxParticleCount(u32 count) _IRR_OVERRIDE_ { MaxParticleCount = count; }
+
+	//! Returns the largest number of particles which are alive at the same time.
+	virtual u32 getMaxParticleCount() const _IRR_OVERRIDE_ { return MaxParticleCount; }
+
+	//! Sets the number of threads which update the particles and create their vertices.
+	virtual void setUpdateThreadCount(u32 threadCount) _IRR_OVERRIDE_;
+
+	//! Returns the number of threads which update the particles.
+	virtual u32 getUpdateThreadCount() const _IRR_OVERRIDE_ { return UpdateThreadCount; }
+
 	//! Writes attributes of the scene node.
 	virtual void serializeAttributes(io::IAttributes* out, io::SAttributeReadWriteOptions* options=0) const _IRR_OVERRIDE_;
 
@@ -214,28 +242,66 @@ public:
 	//! Returns type of the scene node
 	virtual ESCENE_NODE_TYPE getType() const _IRR_OVERRIDE_ { return ESNT_PARTICLE_SYSTEM; }
 
+	//! Uses the transformation handling of ISceneNode
+	virtual bool hasPlainTransformation() const _IRR_OVERRIDE_ { return true; }
+
 private:
 
-	void reallocateBuffers();
+	//! Makes the buffers large enough for all particles drawn as primitive
+	/** The buffers only grow, so their indices and texture coordinates are
+	written once. */
+	void reallocateBuffers(E_PARTICLES_PRIMITIVE primitive);
+
+	//! Runs PartAffectors on all particles and moves them when animate is set.
+	/** Works on small blocks of particles, which stay in the cache while
+	all affectors and the movement are applied. */
+	void updateParticles(u32 now, f32 timeScale, bool animate);
+
+	//! Orders the particles from back to front for the view matrix times the world matrix of the particles
+	void sortParticles(const core::matrix4& viewWorld);
+
+	//! Number of particles handled by one job of the update threads
+	u32 getJobSize(u32 count) const;
+
+	//! Calls job for all job indices, with the update threads if there are some
+	void runJobs(CThreadPool::JobFunction job, void* userData, u32 jobCount);
 
 	core::list<IParticleAffector*> AffectorList;
+	//! affectors which are applied together to parts of the particles
+	core::array<IParticleAffector*> PartAffectors;
 	IParticleEmitter* Emitter;
 	core::array<SParticle> Particles;
 	core::dimension2d<f32> ParticleSize;
 	u32 LastEmitTime;
 	core::matrix4 LastAbsoluteTransformation;
 
-	SMeshBuffer* Buffer;
-
-// TODO: That was obviously planned by someone at some point and sounds like a good idea.
-// But seems it was never implemented.
-//	enum E_PARTICLES_PRIMITIVE
-//	{
-//		EPP_POINT=0,
-//		EPP_BILLBOARD,
-//		EPP_POINTSPRITE
-//	};
-//	E_PARTICLES_PRIMITIVE ParticlePrimitive;
+	CDynamicMeshBuffer* Buffer;
+	//! primitive the buffers are filled for
+	E_PARTICLES_PRIMITIVE BufferPrimitive;
+	//! normal of the vertices of the first NormalParticles particles
+	core::vector3df VertexNormal;
+	u32 NormalParticles;
+	CThreadPool* UpdateThreads;
+	u32 UpdateThreadCount;
+	u32 MaxParticleCount;
+
+	E_PARTICLES_PRIMITIVE ParticlePrimitive;
+
+	//! Sort key of a particle, smaller keys are farther away
+	struct SDepthKey
+	{
+		u32 Key;
+		u32 Index;
+	};
+
+	//! keys of the particles while they are sorted, and space for merging
+	core::array<SDepthKey> DepthKeys;
+	core::array<SDepthKey> DepthKeysTemp;
+	//! particles in sorted order before they replace Particles
+	core::array<SParticle> SortedParticles;
+	//! first particles which are still in the order of the last sort
+	u32 SortedCount;
+	bool DepthSorting;
 
 	bool ParticlesAreGlobal;
 };
@@ -13,6 +13,7 @@
 #include "ILightSceneNode.h"
 #include "IQ3Shader.h"
 #include "IFileList.h"
+#include "irrMap.h"
 
 //#define TJUNCTION_SOLVER_ROUND
 //#define TJUNCTION_SOLVER_0125
@@ -24,6 +25,19 @@ namespace scene
 
 	using namespace quake3;
 
+namespace
+{
+	//! Checks a child of a BSP node, which is a later node or a leaf
+	/** q3map stores the nodes in pre-order, so children pointing back
+	to earlier nodes are broken files and would make the tree a loop. */
+	bool isValidBSPChild(s32 child, s32 node, s32 nodeCount, s32 leafCount)
+	{
+		if (child >= 0)
+			return child > node && child < nodeCount;
+		return -1 - child < leafCount;
+	}
+}
+
 //! constructor
 CQ3LevelMesh::CQ3LevelMesh(io::IFileSystem* fs, scene::ISceneManager* smgr,
 				const Q3LevelLoadParameter &loadParam)
@@ -162,6 +176,7 @@ bool CQ3LevelMesh::loadFile(io::IReadFile* file)
 
 	cleanMeshes();
 	calcBoundingBoxes();
+	buildVisibility();
 	cleanLoader();
 
 	return true;
@@ -183,6 +198,7 @@ void CQ3LevelMesh::cleanLoader ()
 	delete [] MeshVerts; MeshVerts = 0;
 	delete [] Brushes; Brushes = 0;
 
+	FaceMeshBuffers.clear();
 	Lightmap.clear();
 	Tex.clear();
 }
@@ -314,7 +330,24 @@ void CQ3LevelMesh::loadFaces(tBSPLump* l, io::IReadFile* file)
 */
 void CQ3LevelMesh::loadPlanes(tBSPLump* l, io::IReadFile* file)
 {
-	// ignore
+	NumPlanes = l->length / sizeof(tBSPPlane);
+	if ( !NumPlanes )
+		return;
+	Planes = new tBSPPlane[NumPlanes];
+
+	file->seek(l->offset);
+	file->read(Planes, l->length);
+
+	if ( LoadParam.swapHeader )
+	{
+		for ( s32 i=0;i<NumPlanes;i++)
+		{
+			Planes[i].vNormal[0] = os::Byteswap::byteswap(Planes[i].vNormal[0]);
+			Planes[i].vNormal[1] = os::Byteswap::byteswap(Planes[i].vNormal[1]);
+			Planes[i].vNormal[2] = os::Byteswap::byteswap(Planes[i].vNormal[2]);
+			Planes[i].d = os::Byteswap::byteswap(Planes[i].d);
+		}
+	}
 }
 
 
@@ -322,7 +355,29 @@ void CQ3LevelMesh::loadPlanes(tBSPLump* l, io::IReadFile* file)
 */
 void CQ3LevelMesh::loadNodes(tBSPLump* l, io::IReadFile* file)
 {
-	// ignore
+	NumNodes = l->length / sizeof(tBSPNode);
+	if ( !NumNodes )
+		return;
+	Nodes = new tBSPNode[NumNodes];
+
+	file->seek(l->offset);
+	file->read(Nodes, l->length);
+
+	if ( LoadParam.swapHeader )
+	{
+		for ( s32 i=0;i<NumNodes;i++)
+		{
+			Nodes[i].plane = os::Byteswap::byteswap(Nodes[i].plane);
+			Nodes[i].front = os::Byteswap::byteswap(Nodes[i].front);
+			Nodes[i].back = os::Byteswap::byteswap(Nodes[i].back);
+			Nodes[i].mins[0] = os::Byteswap::byteswap(Nodes[i].mins[0]);
+			Nodes[i].mins[1] = os::Byteswap::byteswap(Nodes[i].mins[1]);
+			Nodes[i].mins[2] = os::Byteswap::byteswap(Nodes[i].mins[2]);
+			Nodes[i].maxs[0] = os::Byteswap::byteswap(Nodes[i].maxs[0]);
+			Nodes[i].maxs[1] = os::Byteswap::byteswap(Nodes[i].maxs[1]);
+			Nodes[i].maxs[2] = os::Byteswap::byteswap(Nodes[i].maxs[2]);
+		}
+	}
 }
 
 
@@ -330,7 +385,32 @@ void CQ3LevelMesh::loadNodes(tBSPLump* l, io::IReadFile* file)
 */
 void CQ3LevelMesh::loadLeafs(tBSPLump* l, io::IReadFile* file)
 {
-	// ignore
+	NumLeafs = l->length / sizeof(tBSPLeaf);
+	if ( !NumLeafs )
+		return;
+	Leafs = new tBSPLeaf[NumLeafs];
+
+	file->seek(l->offset);
+	file->read(Leafs, l->length);
+
+	if ( LoadParam.swapHeader )
+	{
+		for ( s32 i=0;i<NumLeafs;i++)
+		{
+			Leafs[i].cluster = os::Byteswap::byteswap(Leafs[i].cluster);
+			Leafs[i].area = os::Byteswap::byteswap(Leafs[i].area);
+			Leafs[i].mins[0] = os::Byteswap::byteswap(Leafs[i].mins[0]);
+			Leafs[i].mins[1] = os::Byteswap::byteswap(Leafs[i].mins[1]);
+			Leafs[i].mins[2] = os::Byteswap::byteswap(Leafs[i].mins[2]);
+			Leafs[i].maxs[0] = os::Byteswap::byteswap(Leafs[i].maxs[0]);
+			Leafs[i].maxs[1] = os::Byteswap::byteswap(Leafs[i].maxs[1]);
+			Leafs[i].maxs[2] = os::Byteswap::byteswap(Leafs[i].maxs[2]);
+			Leafs[i].leafface = os::Byteswap::byteswap(Leafs[i].leafface);
+			Leafs[i].numOfLeafFaces = os::Byteswap::byteswap(Leafs[i].numOfLeafFaces);
+			Leafs[i].leafBrush = os::Byteswap::byteswap(Leafs[i].leafBrush);
+			Leafs[i].numOfLeafBrushes = os::Byteswap::byteswap(Leafs[i].numOfLeafBrushes);
+		}
+	}
 }
 
 
@@ -338,7 +418,21 @@ void CQ3LevelMesh::loadLeafs(tBSPLump* l, io::IReadFile* file)
 */
 void CQ3LevelMesh::loadLeafFaces(tBSPLump* l, io::IReadFile* file)
 {
-	// ignore
+	NumLeafFaces = l->length / sizeof(s32);
+	if ( !NumLeafFaces )
+		return;
+	LeafFaces = new s32[NumLeafFaces];
+
+	file->seek(l->offset);
+	file->read(LeafFaces, l->length);
+
+	if ( LoadParam.swapHeader )
+	{
+		for ( s32 i=0;i<NumLeafFaces;i++)
+		{
+			LeafFaces[i] = os::Byteswap::byteswap(LeafFaces[i]);
+		}
+	}
 }
 
 
@@ -346,7 +440,33 @@ void CQ3LevelMesh::loadLeafFaces(tBSPLump* l, io::IReadFile* file)
 */
 void CQ3LevelMesh::loadVisData(tBSPLump* l, io::IReadFile* file)
 {
-	// ignore
+	Visibility.ClusterCount = 0;
+	Visibility.BytesPerCluster = 0;
+	Visibility.ClusterVisibility.clear();
+
+	if ( l->length < (s32) (2*sizeof(s32)) )
+		return;
+
+	s32 header[2];
+	file->seek(l->offset);
+	file->read(header, sizeof(header));
+
+	if ( LoadParam.swapHeader )
+	{
+		header[0] = os::Byteswap::byteswap(header[0]);
+		header[1] = os::Byteswap::byteswap(header[1]);
+	}
+
+	// the bit sets follow the number of clusters and their size
+	const s32 size = header[0] * header[1];
+	if ( header[0] <= 0 || header[1] <= 0 || header[1] < (header[0]+7)/8 ||
+		size > l->length - (s32) sizeof(header) )
+		return;
+
+	Visibility.ClusterVisibility.set_used(size);
+	file->read(Visibility.ClusterVisibility.pointer(), size);
+	Visibility.ClusterCount = header[0];
+	Visibility.BytesPerCluster = header[1];
 }
 
 
@@ -965,6 +1085,8 @@ scene::SMesh** CQ3LevelMesh::buildMesh(s32 num)
 			}
 
 
+			const u32 firstIndex = buffer->getIndexCount();
+
 			switch(Faces[i].type)
 			{
 				case 4: // billboards
@@ -1018,6 +1140,14 @@ scene::SMesh** CQ3LevelMesh::buildMesh(s32 num)
 					break;
 
 			} // end switch
+
+			// remember where the faces of the level are, for visibility tests
+			if ( num == 0 && item[g].index == E_Q3_MESH_GEOMETRY && (u32) i < FaceMeshBuffers.size() )
+			{
+				FaceMeshBuffers[i] = buffer;
+				Visibility.Faces[i].FirstIndex = firstIndex;
+				Visibility.Faces[i].IndexCount = buffer->getIndexCount() - firstIndex;
+			}
 		}
 	}
 
@@ -1054,6 +1184,21 @@ void CQ3LevelMesh::constructMesh()
 
 	s32 i, j;
 
+	// no face is part of the geometry until buildMesh adds it
+	quake3::SLevelVisibility::SFace noFace;
+	noFace.MeshBuffer = 0;
+	noFace.FirstIndex = 0;
+	noFace.IndexCount = 0;
+	Visibility.Faces.set_used(0);
+	Visibility.Faces.reallocate(NumFaces);
+	FaceMeshBuffers.set_used(0);
+	FaceMeshBuffers.reallocate(NumFaces);
+	for (i = 0; i < NumFaces; i++)
+	{
+		Visibility.Faces.push_back(noFace);
+		FaceMeshBuffers.push_back(0);
+	}
+
 	// First the main level
 	SMesh **tmp = buildMesh(0);
 
@@ -1491,6 +1636,13 @@ IMesh* CQ3LevelMesh::getBrushEntityMesh(quake3::IEntity &ent) const
 }
 
 
+//! returns the BSP tree and the visibility information of the level
+const quake3::SLevelVisibility& CQ3LevelMesh::getVisibility() const
+{
+	return Visibility;
+}
+
+
 /*!
 */
 const IShader * CQ3LevelMesh::getShader(u32 index) const
@@ -1762,6 +1914,92 @@ void CQ3LevelMesh::scriptcallback_shader( SVarGroupList *& grouplist,eToken toke
 }
 
 
+/*!
+	converts the BSP tree and the leafs to the coordinate system of the mesh
+	and finds the mesh buffers of the faces.
+*/
+void CQ3LevelMesh::buildVisibility()
+{
+	Visibility.Nodes.set_used(0);
+	Visibility.Leafs.set_used(0);
+	Visibility.LeafFaces.set_used(0);
+
+	s32 i;
+
+	// mesh buffers which were not removed by cleanMeshes
+	core::map<IMeshBuffer*, u32> bufferIndex;
+	const SMesh* geometry = Mesh[E_Q3_MESH_GEOMETRY];
+	for (i = 0; i < (s32) geometry->MeshBuffers.size(); ++i)
+		bufferIndex.insert(geometry->MeshBuffers[i], i);
+
+	for (i = 0; i < (s32) Visibility.Faces.size(); ++i)
+	{
+		quake3::SLevelVisibility::SFace& face = Visibility.Faces[i];
+		core::map<IMeshBuffer*, u32>::Node* n = FaceMeshBuffers[i] ? bufferIndex.find(FaceMeshBuffers[i]) : 0;
+		if ( n )
+		{
+			face.MeshBuffer = n->getValue();
+		}
+		else
+		{
+			face.MeshBuffer = 0;
+			face.IndexCount = 0;
+		}
+	}
+
+	for (i = 0; i < NumLeafFaces; ++i)
+	{
+		if ( LeafFaces[i] < 0 || LeafFaces[i] >= NumFaces )
+			return;
+		Visibility.LeafFaces.push_back(LeafFaces[i]);
+	}
+
+	Visibility.Leafs.reallocate(NumLeafs);
+	for (i = 0; i < NumLeafs; ++i)
+	{
+		const tBSPLeaf& source = Leafs[i];
+		if ( source.leafface < 0 || source.numOfLeafFaces < 0 ||
+			source.leafface + source.numOfLeafFaces > NumLeafFaces )
+		{
+			Visibility.Leafs.clear();
+			return;
+		}
+
+		// Y and Z are swapped, just like for the vertices
+		quake3::SLevelVisibility::SLeaf leaf;
+		leaf.Cluster = source.cluster;
+		leaf.Box.MinEdge.set((f32) source.mins[0], (f32) source.mins[2], (f32) source.mins[1]);
+		leaf.Box.MaxEdge.set((f32) source.maxs[0], (f32) source.maxs[2], (f32) source.maxs[1]);
+		leaf.Box.repair();
+		leaf.FirstFace = source.leafface;
+		leaf.FaceCount = source.numOfLeafFaces;
+		Visibility.Leafs.push_back(leaf);
+	}
+
+	Visibility.Nodes.reallocate(NumNodes);
+	for (i = 0; i < NumNodes; ++i)
+	{
+		const tBSPNode& source = Nodes[i];
+		if ( source.plane < 0 || source.plane >= NumPlanes ||
+			!isValidBSPChild(source.front, i, NumNodes, NumLeafs) ||
+			!isValidBSPChild(source.back, i, NumNodes, NumLeafs) )
+		{
+			Visibility.Nodes.clear();
+			return;
+		}
+
+		// quake planes are n*p = d, front is n*p - d >= 0
+		const tBSPPlane& plane = Planes[source.plane];
+		quake3::SLevelVisibility::SNode node;
+		node.Plane.Normal.set(plane.vNormal[0], plane.vNormal[2], plane.vNormal[1]);
+		node.Plane.D = -plane.d;
+		node.Children[0] = source.front;
+		node.Children[1] = source.back;
+		Visibility.Nodes.push_back(node);
+	}
+}
+
+
 /*!
 	delete all buffers without geometry in it.
 */
@@ -89,6 +89,9 @@ namespace scene
 		//! returns the requested brush entity
 		virtual IMesh* getBrushEntityMesh(quake3::IEntity &ent) const _IRR_OVERRIDE_;
 
+		//! returns the BSP tree and the visibility information of the level
+		virtual const quake3::SLevelVisibility& getVisibility() const _IRR_OVERRIDE_;
+
 		//Link to held meshes? ...
 
 
@@ -413,6 +416,9 @@ namespace scene
 		scene::SMesh** BrushEntities;
 
 		scene::SMesh* Mesh[quake3::E_Q3_MESH_SIZE];
+
+		quake3::SLevelVisibility Visibility;
+		core::array<IMeshBuffer*> FaceMeshBuffers; // mesh buffer of each face while loading
 		video::IVideoDriver* Driver;
 		core::stringc LevelName;
 		io::IFileSystem* FileSystem; // needs because there are no file extenstions stored in .bsp files.
@@ -477,6 +483,7 @@ namespace scene
 		void cleanMesh(SMesh *m, const bool texture0important = false);
 		void cleanLoader ();
 		void calcBoundingBoxes();
+		void buildVisibility();
 		c8 buf[128];
 		f32 FramesPerSecond;
 	};
@@ -0,0 +1,318 @@
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#include "IrrCompileConfig.h"
+
+#ifdef _IRR_COMPILE_WITH_BSP_LOADER_
+
+#include "CQ3LevelSceneNode.h"
+#include "ISceneManager.h"
+#include "IVideoDriver.h"
+#include "ICameraSceneNode.h"
+#include "IMaterialRenderer.h"
+
+namespace irr
+{
+namespace scene
+{
+
+//! constructor
+CQ3LevelSceneNode::CQ3LevelSceneNode(IQ3LevelMesh* mesh, ISceneNode* parent, ISceneManager* mgr, s32 id)
+	: IQ3LevelSceneNode(parent, mgr, id), LevelMesh(mesh), Update(0),
+	NeedsUpdate(true), VisibilityCulling(true), FrameStarted(false),
+	CameraCluster(-1), DrawnFaceCount(0), FaceCount(0)
+{
+#ifdef _DEBUG
+	setDebugName("CQ3LevelSceneNode");
+#endif
+
+	LevelMesh->grab();
+
+	IMesh* geometry = LevelMesh->getMesh(quake3::E_Q3_MESH_GEOMETRY);
+	const u32 count = geometry ? geometry->getMeshBufferCount() : 0;
+	for (u32 i=0; i<count; ++i)
+	{
+		IMeshBuffer* mb = geometry->getMeshBuffer(i);
+		Materials.push_back(mb->getMaterial());
+
+		if (mb->getVertexType() != video::EVT_2TCOORDS || mb->getIndexType() != video::EIT_16BIT ||
+			mb->getPrimitiveType() != EPT_TRIANGLES)
+		{
+			Buffers.push_back(0);
+			LevelIndices.push_back(0);
+			continue;
+		}
+
+		// the vertices stay in the level mesh, which is grabbed as long as this node exists
+		SMeshBufferLightMap* buffer = new SMeshBufferLightMap();
+		buffer->Vertices.set_pointer((video::S3DVertex2TCoords*)mb->getVertices(), mb->getVertexCount(), false, false);
+		buffer->Indices.reallocate(mb->getIndexCount());
+		buffer->BoundingBox = mb->getBoundingBox();
+		buffer->setHardwareMappingHint(EHM_STATIC, EBT_VERTEX);
+		buffer->setHardwareMappingHint(EHM_DYNAMIC, EBT_INDEX);
+		Buffers.push_back(buffer);
+		LevelIndices.push_back(mb->getIndices());
+	}
+
+	if (geometry)
+		Box = geometry->getBoundingBox();
+
+	const quake3::SLevelVisibility& visibility = LevelMesh->getVisibility();
+	for (u32 f=0; f<visibility.Faces.size(); ++f)
+	{
+		const quake3::SLevelVisibility::SFace& face = visibility.Faces[f];
+		if (face.IndexCount && face.MeshBuffer < Buffers.size() && Buffers[face.MeshBuffer])
+			++FaceCount;
+	}
+	FaceUpdates.set_used(visibility.Faces.size());
+	for (u32 f=0; f<FaceUpdates.size(); ++f)
+		FaceUpdates[f] = 0;
+
+	LeafCullingPlanes.set_used(visibility.Leafs.size());
+	for (u32 l=0; l<LeafCullingPlanes.size(); ++l)
+		LeafCullingPlanes[l] = CFrustumCuller::NO_PLANE;
+}
+
+
+//! destructor
+CQ3LevelSceneNode::~CQ3LevelSceneNode()
+{
+	for (u32 i=0; i<Buffers.size(); ++i)
+	{
+		if (Buffers[i])
+			Buffers[i]->drop();
+	}
+
+	LevelMesh->drop();
+}
+
+
+void CQ3LevelSceneNode::OnRegisterSceneNode()
+{
+	if (IsVisible)
+	{
+		video::IVideoDriver* driver = SceneManager->getVideoDriver();
+
+		u32 transparentCount = 0;
+		u32 solidCount = 0;
+
+		// count transparent and solid materials in this scene node
+		for (u32 i=0; i<Materials.size(); ++i)
+		{
+			const video::IMaterialRenderer* const rnd =
+				driver->getMaterialRenderer(Materials[i].MaterialType);
+
+			if ((rnd && rnd->isTransparent()) || Materials[i].isTransparent())
+				++transparentCount;
+			else
+				++solidCount;
+
+			if (solidCount && transparentCount)
+				break;
+		}
+
+		if (solidCount)
+			SceneManager->registerNodeForRendering(this, scene::ESNRP_SOLID);
+
+		if (transparentCount)
+			SceneManager->registerNodeForRendering(this, scene::ESNRP_TRANSPARENT);
+
+		// the visible faces are collected in the first render pass of the frame
+		FrameStarted = true;
+
+		ISceneNode::OnRegisterSceneNode();
+	}
+}
+
+
+//! renders the node.
+void CQ3LevelSceneNode::render()
+{
+	video::IVideoDriver* driver = SceneManager->getVideoDriver();
+	ICameraSceneNode* camera = SceneManager->getActiveCamera();
+
+	if (!driver || !camera)
+		return;
+
+	if (FrameStarted)
+	{
+		updateVisibleFaces(camera);
+		FrameStarted = false;
+	}
+
+	const bool isTransparentPass =
+		SceneManager->getSceneNodeRenderPass() == scene::ESNRP_TRANSPARENT;
+
+	driver->setTransform(video::ETS_WORLD, AbsoluteTransformation);
+
+	for (u32 i=0; i<Buffers.size(); ++i)
+	{
+		if (!Buffers[i] || Buffers[i]->Indices.empty())
+			continue;
+
+		const video::IMaterialRenderer* const rnd = driver->getMaterialRenderer(Materials[i].MaterialType);
+		const bool transparent = (rnd && rnd->isTransparent()) || Materials[i].isTransparent();
+
+		// only render transparent buffer if this is the transparent render pass
+		// and solid only in solid pass
+		if (transparent == isTransparentPass)
+		{
+			driver->setMaterial(Materials[i]);
+			driver->drawMeshBuffer(Buffers[i]);
+		}
+	}
+
+	if (DebugDataVisible & scene::EDS_BBOX)
+	{
+		video::SMaterial m;
+		m.Lighting = false;
+		driver->setMaterial(m);
+		driver->draw3DBox(Box, video::SColor(255,255,255,255));
+	}
+}
+
+
+//! Collects the indices of all faces which can be seen from the camera
+void CQ3LevelSceneNode::updateVisibleFaces(const ICameraSceneNode* camera)
+{
+	// nothing to do while neither the camera nor the level moves
+	if (!NeedsUpdate && LastView == camera->getViewMatrix() &&
+		LastProjection == camera->getProjectionMatrix() &&
+		LastTransformation == AbsoluteTransformation)
+		return;
+
+	NeedsUpdate = false;
+	LastView = camera->getViewMatrix();
+	LastProjection = camera->getProjectionMatrix();
+	LastTransformation = AbsoluteTransformation;
+
+	u32 i;
+	for (i=0; i<Buffers.size(); ++i)
+	{
+		if (Buffers[i])
+			Buffers[i]->Indices.set_used(0);
+	}
+
+	// faces can be part of several leafs, they are added only once per update
+	++Update;
+	if (!Update)
+	{
+		for (i=0; i<FaceUpdates.size(); ++i)
+			FaceUpdates[i] = 0;
+		Update = 1;
+	}
+
+	DrawnFaceCount = 0;
+	const quake3::SLevelVisibility& visibility = LevelMesh->getVisibility();
+
+	if (!VisibilityCulling)
+	{
+		CameraCluster = -1;
+		for (i=0; i<visibility.Faces.size(); ++i)
+			addFace(i);
+	}
+	else
+	{
+		// camera and frustum in the coordinate system of the level
+		core::matrix4 invTrans(AbsoluteTransformation, core::matrix4::EM4CONST_INVERSE);
+		core::vector3df cameraPosition = camera->getAbsolutePosition();
+		invTrans.transformVect(cameraPosition);
+		SViewFrustum frustum = *camera->getViewFrustum();
+		frustum.transform(invTrans);
+
+		CameraCluster = visibility.getCluster(cameraPosition);
+
+		// leafs of all clusters which can be seen from the camera cluster
+		LeafCuller.clear();
+		CandidateLeafs.set_used(0);
+		for (i=0; i<visibility.Leafs.size(); ++i)
+		{
+			const quake3::SLevelVisibility::SLeaf& leaf = visibility.Leafs[i];
+			if (leaf.FaceCount && visibility.isClusterVisible(CameraCluster, leaf.Cluster))
+			{
+				CandidateLeafs.push_back(i);
+				LeafCuller.addBox(leaf.Box, LeafCullingPlanes[i]);
+			}
+		}
+
+		// and of those only the leafs inside the view frustum
+		LeafCuller.cull(frustum);
+
+		for (i=0; i<CandidateLeafs.size(); ++i)
+		{
+			const u32 l = CandidateLeafs[i];
+			LeafCullingPlanes[l] = LeafCuller.getCullingPlane(i);
+			if (LeafCullingPlanes[l] != CFrustumCuller::NO_PLANE)
+				continue;
+
+			const quake3::SLevelVisibility::SLeaf& leaf = visibility.Leafs[l];
+			for (u32 f=0; f<leaf.FaceCount; ++f)
+				addFace(visibility.LeafFaces[leaf.FirstFace+f]);
+		}
+	}
+
+	for (i=0; i<Buffers.size(); ++i)
+	{
+		if (Buffers[i])
+			Buffers[i]->setDirty(EBT_INDEX);
+	}
+}
+
+
+//! Adds the indices of a face to its mesh buffer, once per update
+void CQ3LevelSceneNode::addFace(u32 face)
+{
+	if (FaceUpdates[face] == Update)
+		return;
+	FaceUpdates[face] = Update;
+
+	const quake3::SLevelVisibility::SFace& f = LevelMesh->getVisibility().Faces[face];
+	if (!f.IndexCount || f.MeshBuffer >= Buffers.size() || !Buffers[f.MeshBuffer])
+		return;
+
+	SMeshBufferLightMap* buffer = Buffers[f.MeshBuffer];
+	const u16* indices = LevelIndices[f.MeshBuffer] + f.FirstIndex;
+	for (u32 i=0; i<f.IndexCount; ++i)
+		buffer->Indices.push_back(indices[i]);
+
+	++DrawnFaceCount;
+}
+
+
+//! returns the axis aligned bounding box of this node
+const core::aabbox3d<f32>& CQ3LevelSceneNode::getBoundingBox() const
+{
+	return Box;
+}
+
+
+//! returns the material based on the zero based index i.
+video::SMaterial& CQ3LevelSceneNode::getMaterial(u32 i)
+{
+	if (i >= Materials.size())
+		return ISceneNode::getMaterial(i);
+
+	return Materials[i];
+}
+
+
+//! returns amount of materials used by this scene node.
+u32 CQ3LevelSceneNode::getMaterialCount() const
+{
+	return Materials.size();
+}
+
+
+//! Sets if only the potentially visible faces are drawn
+void CQ3LevelSceneNode::setVisibilityCulling(bool enable)
+{
+	VisibilityCulling = enable;
+	NeedsUpdate = true;
+}
+
+
+} // end namespace scene
+} // end namespace irr
+
+#endif // _IRR_COMPILE_WITH_BSP_LOADER_
+
@@ -0,0 +1,107 @@
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#ifndef __C_Q3_LEVEL_SCENE_NODE_H_INCLUDED__
+#define __C_Q3_LEVEL_SCENE_NODE_H_INCLUDED__
+
+#include "IQ3LevelSceneNode.h"
+#include "IQ3LevelMesh.h"
+#include "SMeshBufferLightMap.h"
+#include "CFrustumCuller.h"
+
+namespace irr
+{
+namespace scene
+{
+	class ICameraSceneNode;
+
+	//! Scene node drawing the potentially visible faces of a Quake 3 level
+	class CQ3LevelSceneNode : public IQ3LevelSceneNode
+	{
+	public:
+
+		//! constructor
+		CQ3LevelSceneNode(IQ3LevelMesh* mesh, ISceneNode* parent, ISceneManager* mgr, s32 id);
+
+		//! destructor
+		virtual ~CQ3LevelSceneNode();
+
+		virtual void OnRegisterSceneNode() _IRR_OVERRIDE_;
+
+		//! renders the node.
+		virtual void render() _IRR_OVERRIDE_;
+
+		//! returns the axis aligned bounding box of this node
+		virtual const core::aabbox3d<f32>& getBoundingBox() const _IRR_OVERRIDE_;
+
+		//! returns the material based on the zero based index i.
+		virtual video::SMaterial& getMaterial(u32 i) _IRR_OVERRIDE_;
+
+		//! returns amount of materials used by this scene node.
+		virtual u32 getMaterialCount() const _IRR_OVERRIDE_;
+
+		//! Returns type of the scene node
+		virtual ESCENE_NODE_TYPE getType() const _IRR_OVERRIDE_ { return ESNT_Q3LEVEL_SCENE_NODE; }
+
+		//! Returns the level which is drawn
+		virtual IQ3LevelMesh* getLevelMesh() const _IRR_OVERRIDE_ { return LevelMesh; }
+
+		//! Sets if only the potentially visible faces are drawn
+		virtual void setVisibilityCulling(bool enable) _IRR_OVERRIDE_;
+
+		//! Returns if only the potentially visible faces are drawn
+		virtual bool getVisibilityCulling() const _IRR_OVERRIDE_ { return VisibilityCulling; }
+
+		//! Returns the cluster the camera was in when the node was drawn the last time
+		virtual s32 getCameraCluster() const _IRR_OVERRIDE_ { return CameraCluster; }
+
+		//! Returns the number of faces drawn the last time
+		virtual u32 getDrawnFaceCount() const _IRR_OVERRIDE_ { return DrawnFaceCount; }
+
+		//! Returns the number of faces of the level geometry
+		virtual u32 getFaceCount() const _IRR_OVERRIDE_ { return FaceCount; }
+
+	private:
+
+		//! Collects the indices of all faces which can be seen from the camera
+		void updateVisibleFaces(const ICameraSceneNode* camera);
+
+		//! Adds the indices of a face to its mesh buffer, once per update
+		void addFace(u32 face);
+
+		IQ3LevelMesh* LevelMesh;
+
+		//! Share the vertices with the level geometry, the indices are those of the visible faces.
+		//! 0 for mesh buffers which can't be drawn by this node.
+		core::array<SMeshBufferLightMap*> Buffers;
+		core::array<const u16*> LevelIndices;
+		core::array<video::SMaterial> Materials;
+		core::aabbox3df Box;
+
+		//! last update in which each face was added
+		core::array<u32> FaceUpdates;
+		u32 Update;
+
+		//! leafs in potentially visible clusters and the planes which culled them the last time
+		CFrustumCuller LeafCuller;
+		core::array<u32> CandidateLeafs;
+		core::array<u8> LeafCullingPlanes;
+
+		//! camera and transformation of the last update
+		core::matrix4 LastView;
+		core::matrix4 LastProjection;
+		core::matrix4 LastTransformation;
+		bool NeedsUpdate;
+
+		bool VisibilityCulling;
+		bool FrameStarted;
+		s32 CameraCluster;
+		u32 DrawnFaceCount;
+		u32 FaceCount;
+	};
+
+} // end namespace scene
+} // end namespace irr
+
+#endif
+
@@ -344,6 +344,8 @@ bool CSceneCollisionManager::getCollisionPoint(SCollisionHit& hitResult, const c
 		return false;
 	}
 
+	CMutexLock lock(TrianglesMutex);
+
 	s32 totalcnt = selector->getTriangleCount();
 	if ( totalcnt <= 0 )
 		return false;
@@ -434,6 +436,7 @@ core::vector3df CSceneCollisionManager::getCollisionResultPosition(
 		f32 slidingSpeed,
 		const core::vector3df& gravity)
 {
+	CMutexLock lock(TrianglesMutex);
 	return collideEllipsoidWithWorld(selector, position,
 		radius, direction, slidingSpeed, gravity, triout, hitPosition, outFalling, outNode);
 }
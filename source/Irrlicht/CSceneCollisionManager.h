@@ -8,6 +8,7 @@
 #include "ISceneCollisionManager.h"
 #include "ISceneManager.h"
 #include "IVideoDriver.h"
+#include "CThreadPool.h"
 
 namespace irr
 {
@@ -143,6 +144,9 @@ namespace scene
 		ISceneManager* SceneManager;
 		video::IVideoDriver* Driver;
 		core::array<core::triangle3df> Triangles; // triangle buffer
+		// held while Triangles is used, collision response animators
+		// of different nodes can run on several animation threads
+		CMutex TrianglesMutex;
 	};
 
 
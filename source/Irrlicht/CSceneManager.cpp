@@ -30,6 +30,10 @@
 #include "CIrrMeshFileLoader.h"
 #endif
 
+#ifdef _IRR_COMPILE_WITH_IRR_BINARY_MESH_LOADER_
+#include "CIrrBinaryMeshFileLoader.h"
+#endif
+
 #ifdef _IRR_COMPILE_WITH_BSP_LOADER_
 #include "CBSPMeshFileLoader.h"
 #endif
@@ -122,6 +126,10 @@
 #include "CIrrMeshWriter.h"
 #endif
 
+#ifdef _IRR_COMPILE_WITH_IRR_BINARY_WRITER_
+#include "CIrrBinaryMeshWriter.h"
+#endif
+
 #ifdef _IRR_COMPILE_WITH_STL_WRITER_
 #include "CSTLMeshWriter.h"
 #endif
@@ -156,9 +164,14 @@
 #include "CDummyTransformationSceneNode.h"
 #include "CWaterSurfaceSceneNode.h"
 #include "CTerrainSceneNode.h"
+#include "CPagedTerrainSceneNode.h"
 #include "CEmptySceneNode.h"
 #include "CTextSceneNode.h"
 #include "CQuake3ShaderSceneNode.h"
+#include "CQ3LevelSceneNode.h"
+#include "CLODSceneNode.h"
+#include "CBatchedMeshSceneNode.h"
+#include "CClusteredMeshSceneNode.h"
 #include "CVolumeLightSceneNode.h"
 
 #include "CDefaultSceneNodeFactory.h"
@@ -196,9 +209,10 @@ CSceneManager::CSceneManager(video::IVideoDriver* driver, io::IFileSystem* fs,
 		gui::IGUIEnvironment* gui)
 : ISceneNode(0, 0), Driver(driver), FileSystem(fs), GUIEnvironment(gui),
 	CursorControl(cursorControl), CollisionManager(0),
-	ActiveCamera(0), ShadowColor(150,0,0,0), AmbientLight(0,0,0,0), Parameters(0),
+	VisibleNodeCount(0), CulledNodeCount(0), OcclusionCulling(false), ActiveCamera(0), ShadowColor(150,0,0,0), AmbientLight(0,0,0,0), Parameters(0),
 	MeshCache(cache), CurrentRenderPass(ESNRP_NONE), LightManager(0),
-	IRR_XML_FORMAT_SCENE(L"irr_scene"), IRR_XML_FORMAT_NODE(L"node"), IRR_XML_FORMAT_NODE_ATTR_TYPE(L"type")
+	IRR_XML_FORMAT_SCENE(L"irr_scene"), IRR_XML_FORMAT_NODE(L"node"), IRR_XML_FORMAT_NODE_ATTR_TYPE(L"type"),
+	AnimationThreads(0), AnimationGroups(0), AnimationTime(0)
 {
 	#ifdef _DEBUG
 	ISceneManager::setDebugName("CSceneManager ISceneManager");
@@ -285,6 +299,9 @@ CSceneManager::CSceneManager(video::IVideoDriver* driver, io::IFileSystem* fs,
 	#ifdef _IRR_COMPILE_WITH_IRR_MESH_LOADER_
 	MeshLoaderList.push_back(new CIrrMeshFileLoader(this, FileSystem));
 	#endif
+	#ifdef _IRR_COMPILE_WITH_IRR_BINARY_MESH_LOADER_
+	MeshLoaderList.push_back(new CIrrBinaryMeshFileLoader(this));
+	#endif
 	#ifdef _IRR_COMPILE_WITH_BSP_LOADER_
 	MeshLoaderList.push_back(new CBSPMeshFileLoader(this, FileSystem));
 	#endif
@@ -336,6 +353,8 @@ CSceneManager::CSceneManager(video::IVideoDriver* driver, io::IFileSystem* fs,
 			getProfiler().add(EPID_SM_RENDER_TRANSPARENT, L"transp.nodes", L"Irrlicht scene");
 			getProfiler().add(EPID_SM_RENDER_EFFECT, L"effectnodes", L"Irrlicht scene");
 			getProfiler().add(EPID_SM_REGISTER, L"reg.render.node", L"Irrlicht scene");
+			getProfiler().add(EPID_SM_CULL, L"cull.nodes", L"Irrlicht scene");
+			getProfiler().add(EPID_SM_OCCLUDERS, L"occluders", L"Irrlicht scene");
 		}
  	)
 }
@@ -393,6 +412,12 @@ CSceneManager::~CSceneManager()
 	if (LightManager)
 		LightManager->drop();
 
+	if (AnimationThreads)
+		AnimationThreads->drop();
+
+	destroyAnimationGroups();
+	destroyTransformHierarchy();
+
 	// remove all nodes and animators before dropping the driver
 	// as render targets may be destroyed twice
 
@@ -564,6 +589,27 @@ IMeshSceneNode* CSceneManager::addQuake3SceneNode(const IMeshBuffer* meshBuffer,
 }
 
 
+//! Adds a scene node drawing the geometry of a quake3 level to the scene graph.
+IQ3LevelSceneNode* CSceneManager::addQuake3LevelSceneNode(IQ3LevelMesh* mesh,
+					ISceneNode* parent, s32 id)
+{
+#ifdef _IRR_COMPILE_WITH_BSP_LOADER_
+	if (!mesh)
+		return 0;
+
+	if (!parent)
+		parent = this;
+
+	CQ3LevelSceneNode* node = new CQ3LevelSceneNode(mesh, parent, this, id);
+	node->drop();
+
+	return node;
+#else
+	return 0;
+#endif
+}
+
+
 //! adds Volume Lighting Scene Node.
 //! the returned pointer must not be dropped.
 IVolumeLightSceneNode* CSceneManager::addVolumeLightSceneNode(
@@ -707,6 +753,72 @@ IOctreeSceneNode* CSceneManager::addOctreeSceneNode(IMesh* mesh, ISceneNode* par
 }
 
 
+//! Adds a scene node which draws simplified versions of a mesh when it gets small on the screen.
+ILODSceneNode* CSceneManager::addLODSceneNode(IMesh* mesh, u32 levelCount, f32 reduction,
+		ISceneNode* parent, s32 id, const core::vector3df& position,
+		const core::vector3df& rotation, const core::vector3df& scale)
+{
+	if (!mesh)
+		return 0;
+
+	if (!parent)
+		parent = this;
+
+	CLODSceneNode* node = new CLODSceneNode(parent, this, id, position, rotation, scale);
+
+	const u32 triangleCount = getMeshManipulator()->getPolyCount(mesh);
+	f32 screenSize = 0.5f;
+	f32 triangles = (f32)triangleCount;
+	node->addLevel(mesh, screenSize);
+	for (u32 i=1; i<levelCount; ++i)
+	{
+		screenSize *= 0.5f;
+		triangles *= reduction;
+		IMesh* level = getMeshManipulator()->createMeshSimplified(mesh, (u32)triangles);
+		node->addLevel(level, screenSize);
+		level->drop();
+	}
+
+	node->drop();
+	return node;
+}
+
+
+//! Merges many static mesh scene nodes into one node with few draw calls.
+IBatchedMeshSceneNode* CSceneManager::addBatchedMeshSceneNode(const core::array<ISceneNode*>& nodes,
+		ISceneNode* parent, s32 id, u32 maxChunkVertices)
+{
+	if (!parent)
+		parent = this;
+
+	CBatchedMeshSceneNode* node = new CBatchedMeshSceneNode(nodes, maxChunkVertices, parent, this, id);
+	node->drop();
+	return node;
+}
+
+
+//! Adds a scene node which culls small clusters of triangles of a mesh separately.
+IClusteredMeshSceneNode* CSceneManager::addClusteredMeshSceneNode(IMesh* mesh, ISceneNode* parent, s32 id,
+		const core::vector3df& position, const core::vector3df& rotation,
+		const core::vector3df& scale, u32 maxVertices, u32 maxTriangles)
+{
+	if (!mesh)
+		return 0;
+
+	if (!parent)
+		parent = this;
+
+	core::array<SMeshCluster> clusters;
+	IMesh* clustered = getMeshManipulator()->createClusteredMesh(mesh, clusters, maxVertices, maxTriangles);
+
+	CClusteredMeshSceneNode* node = new CClusteredMeshSceneNode(clustered, clusters, parent, this, id,
+		position, rotation, scale);
+	clustered->drop();
+	node->drop();
+	return node;
+}
+
+
 //! Adds a camera scene node to the tree and sets it as active camera.
 //! \param position: Position of the space relative to its parent where the camera will be placed.
 //! \param lookat: Position where the camera will look at. Also known as target.
@@ -936,6 +1048,59 @@ ITerrainSceneNode* CSceneManager::addTerrainSceneNode(
 }
 
 
+//! Adds a scene node for a terrain which is loaded tile by tile while it is drawn.
+IPagedTerrainSceneNode* CSceneManager::addPagedTerrainSceneNode(
+	const io::path& heightMapFileName, const core::dimension2du& heightmapSize,
+	ISceneNode* parent, s32 id,
+	const core::vector3df& position,
+	const core::vector3df& rotation,
+	const core::vector3df& scale,
+	u32 tileSize, s32 maxLOD)
+{
+	io::IReadFile* file = FileSystem->createAndOpenFile(heightMapFileName);
+
+	if (!file)
+	{
+		os::Printer::log("Could not load terrain, because file could not be opened.",
+		heightMapFileName, ELL_ERROR);
+		return 0;
+	}
+
+	IPagedTerrainSceneNode* terrain = addPagedTerrainSceneNode(file, heightmapSize,
+		parent, id, position, rotation, scale, tileSize, maxLOD);
+
+	file->drop();
+
+	return terrain;
+}
+
+
+//! Adds a scene node for a terrain which is loaded tile by tile while it is drawn.
+IPagedTerrainSceneNode* CSceneManager::addPagedTerrainSceneNode(
+	io::IReadFile* heightMapFile, const core::dimension2du& heightmapSize,
+	ISceneNode* parent, s32 id,
+	const core::vector3df& position,
+	const core::vector3df& rotation,
+	const core::vector3df& scale,
+	u32 tileSize, s32 maxLOD)
+{
+	if (!heightMapFile)
+	{
+		os::Printer::log("Could not load terrain, because file could not be opened.", ELL_ERROR);
+		return 0;
+	}
+
+	if (!parent)
+		parent = this;
+
+	CPagedTerrainSceneNode* node = new CPagedTerrainSceneNode(heightMapFile, heightmapSize,
+		tileSize, maxLOD, parent, this, id, position, rotation, scale);
+
+	node->drop();
+	return node;
+}
+
+
 //! Adds an empty scene node.
 ISceneNode* CSceneManager::addEmptySceneNode(ISceneNode* parent, s32 id)
 {
@@ -1182,6 +1347,13 @@ const core::aabbox3d<f32>& CSceneManager::getBoundingBox() const
 
 //! returns if node is culled
 bool CSceneManager::isCulled(const ISceneNode* node) const
+{
+	return isCulledBy(node, node->getAutomaticCulling());
+}
+
+
+//! returns if node is culled by one of the given E_CULLING_TYPE tests
+bool CSceneManager::isCulledBy(const ISceneNode* node, u32 cullingTypes) const
 {
 	const ICameraSceneNode* cam = getActiveCamera();
 	if (!cam)
@@ -1191,13 +1363,13 @@ bool CSceneManager::isCulled(const ISceneNode* node) const
 	bool result = false;
 
 	// has occlusion query information
-	if (node->getAutomaticCulling() & scene::EAC_OCC_QUERY)
+	if (cullingTypes & scene::EAC_OCC_QUERY)
 	{
 		result = (Driver->getOcclusionQueryResult(const_cast<ISceneNode*>(node))==0);
 	}
 
 	// can be seen by a bounding box ?
-	if (!result && (node->getAutomaticCulling() & scene::EAC_BOX))
+	if (!result && (cullingTypes & scene::EAC_BOX))
 	{
 		core::aabbox3d<f32> tbox = node->getBoundingBox();
 		node->getAbsoluteTransformation().transformBoxEx(tbox);
@@ -1205,7 +1377,7 @@ bool CSceneManager::isCulled(const ISceneNode* node) const
 	}
 
 	// can be seen by a bounding sphere
-	if (!result && (node->getAutomaticCulling() & scene::EAC_FRUSTUM_SPHERE))
+	if (!result && (cullingTypes & scene::EAC_FRUSTUM_SPHERE))
 	{
 		const core::aabbox3df nbox = node->getTransformedBoundingBox();
 		const float rad = nbox.getRadius();
@@ -1221,7 +1393,7 @@ bool CSceneManager::isCulled(const ISceneNode* node) const
 	}
 
 	// can be seen by cam pyramid planes ?
-	if (!result && (node->getAutomaticCulling() & scene::EAC_FRUSTUM_BOX))
+	if (!result && (cullingTypes & scene::EAC_FRUSTUM_BOX))
 	{
 		SViewFrustum frust = *cam->getViewFrustum();
 
@@ -1299,32 +1471,69 @@ u32 CSceneManager::registerNodeForRendering(ISceneNode* node, E_SCENE_NODE_RENDE
 		taken = 1;
 		break;
 	case ESNRP_SOLID:
-		if (!isCulled(node))
+	case ESNRP_TRANSPARENT:
+	case ESNRP_TRANSPARENT_EFFECT:
+	case ESNRP_AUTOMATIC:
+	case ESNRP_SHADOW:
 		{
-			SolidNodeList.push_back(node);
-			taken = 1;
+			const u32 culling = node->getAutomaticCulling();
+			if (isCulledBy(node, culling & ~EAC_FRUSTUM_BOX))
+			{
+				++CulledNodeCount;
+			}
+			else if (((culling & EAC_FRUSTUM_BOX) || (OcclusionCulling && culling != EAC_OFF)) && getActiveCamera())
+			{
+				// tested together with all other nodes in cullRegisteredNodes()
+				FrustumCullingNodes.push_back(node);
+				FrustumCullingPasses.push_back(pass);
+				FrustumCuller.addBox(node->getTransformedBoundingBox(), node->FrustumCullingPlane);
+				taken = 1;
+			}
+			else
+			{
+				taken = addToRenderList(node, pass);
+				++VisibleNodeCount;
+			}
 		}
 		break;
+
+	case ESNRP_NONE: // ignore this one
+		break;
+	}
+
+#ifdef _IRR_SCENEMANAGER_DEBUG
+	s32 index = Parameters->findAttribute("calls");
+	Parameters->setAttribute(index, Parameters->getAttributeAsInt(index)+1);
+
+	if (!taken)
+	{
+		index = Parameters->findAttribute("culled");
+		Parameters->setAttribute(index, Parameters->getAttributeAsInt(index)+1);
+	}
+#endif
+
+	return taken;
+}
+
+
+//! adds a node which passed culling to the render list of a pass
+u32 CSceneManager::addToRenderList(ISceneNode* node, E_SCENE_NODE_RENDER_PASS pass)
+{
+	switch(pass)
+	{
+	case ESNRP_SOLID:
+		SolidNodeList.push_back(node);
+		break;
 	case ESNRP_TRANSPARENT:
-		if (!isCulled(node))
-		{
-			TransparentNodeList.push_back(TransparentNodeEntry(node, camWorldPos));
-			taken = 1;
-		}
+		TransparentNodeList.push_back(TransparentNodeEntry(node, camWorldPos));
 		break;
 	case ESNRP_TRANSPARENT_EFFECT:
-		if (!isCulled(node))
-		{
-			TransparentEffectNodeList.push_back(TransparentNodeEntry(node, camWorldPos));
-			taken = 1;
-		}
+		TransparentEffectNodeList.push_back(TransparentNodeEntry(node, camWorldPos));
 		break;
 	case ESNRP_AUTOMATIC:
-		if (!isCulled(node))
 		{
 			const u32 count = node->getMaterialCount();
 
-			taken = 0;
 			for (u32 i=0; i<count; ++i)
 			{
 				video::IMaterialRenderer* rnd =
@@ -1334,43 +1543,178 @@ u32 CSceneManager::registerNodeForRendering(ISceneNode* node, E_SCENE_NODE_RENDE
 					// register as transparent node
 					TransparentNodeEntry e(node, camWorldPos);
 					TransparentNodeList.push_back(e);
-					taken = 1;
-					break;
+					return 1;
 				}
 			}
 
 			// not transparent, register as solid
-			if (!taken)
-			{
-				SolidNodeList.push_back(node);
-				taken = 1;
-			}
+			SolidNodeList.push_back(node);
 		}
 		break;
 	case ESNRP_SHADOW:
-		if (!isCulled(node))
+		ShadowNodeList.push_back(node);
+		break;
+	default:
+		return 0;
+	}
+
+	return 1;
+}
+
+
+//! tests all nodes waiting for the frustum test and adds the visible ones to the render lists
+void CSceneManager::cullRegisteredNodes()
+{
+	IRR_PROFILE(CProfileScope p1(EPID_SM_CULL);)
+
+	const ICameraSceneNode* cam = getActiveCamera();
+	if (cam && FrustumCullingNodes.size())
+		FrustumCuller.cull(*cam->getViewFrustum());
+
+	for (u32 i=0; i<FrustumCullingNodes.size(); ++i)
+	{
+		ISceneNode* node = FrustumCullingNodes[i];
+		bool culled = false;
+
+		// nodes might only be here for the occlusion test
+		if (cam && (node->getAutomaticCulling() & EAC_FRUSTUM_BOX))
 		{
-			ShadowNodeList.push_back(node);
-			taken = 1;
+			node->FrustumCullingPlane = FrustumCuller.getCullingPlane(i);
+			culled = node->FrustumCullingPlane != CFrustumCuller::NO_PLANE;
 		}
-		break;
 
-	case ESNRP_NONE: // ignore this one
-		break;
-	}
+		if (!culled && OcclusionCulling)
+			culled = OcclusionCuller.isOccluded(node->getTransformedBoundingBox());
 
+		if (!culled)
+		{
+			addToRenderList(node, FrustumCullingPasses[i]);
+			++VisibleNodeCount;
+		}
+		else
+		{
+			++CulledNodeCount;
 #ifdef _IRR_SCENEMANAGER_DEBUG
-	s32 index = Parameters->findAttribute("calls");
-	Parameters->setAttribute(index, Parameters->getAttributeAsInt(index)+1);
+			s32 index = Parameters->findAttribute("culled");
+			Parameters->setAttribute(index, Parameters->getAttributeAsInt(index)+1);
+#endif
+		}
+	}
 
-	if (!taken)
+	FrustumCullingNodes.set_used(0);
+	FrustumCullingPasses.set_used(0);
+	FrustumCuller.clear();
+	OcclusionCulling = false;
+}
+
+
+//! rasterizes the occluders for this frame, if software occlusion culling is enabled
+void CSceneManager::prepareOcclusionCulling()
+{
+	OcclusionCulling = false;
+
+	const s32 width = Parameters->getAttributeAsInt(SOFTWARE_OCCLUSION_CULLING);
+	if (width <= 0 || !ActiveCamera || Occluders.empty())
+		return;
+
+	IRR_PROFILE(CProfileScope p1(EPID_SM_OCCLUDERS);)
+
+	const f32 aspect = ActiveCamera->getAspectRatio();
+	const u32 height = core::max_(core::round32(width / (aspect > 0.f ? aspect : 1.f)), 1);
+	OcclusionCuller.begin(ActiveCamera->getViewMatrix(), ActiveCamera->getProjectionMatrix(),
+		ActiveCamera->getNearValue(), (u32)width, height);
+
+	for (u32 i=0; i<Occluders.size(); ++i)
 	{
-		index = Parameters->findAttribute("culled");
-		Parameters->setAttribute(index, Parameters->getAttributeAsInt(index)+1);
+		ISceneNode* node = Occluders[i].Node;
+
+		// removed nodes only occlude again when they are added back to the scene
+		const ISceneNode* root = node;
+		while (root->getParent())
+			root = root->getParent();
+		if (root != this)
+		{
+			// nobody else knows the node anymore, so it can't come back
+			if (node->getReferenceCount() == 1)
+			{
+				removeOccluder(node);
+				--i;
+			}
+			continue;
+		}
+
+		if (node->isTrulyVisible())
+			OcclusionCuller.addOccluder(Occluders[i].Mesh, node->getAbsoluteTransformation());
 	}
-#endif
 
-	return taken;
+	OcclusionCuller.end();
+	OcclusionCulling = true;
+}
+
+
+//! Adds a scene node which hides the nodes behind it in the software occlusion culling.
+void CSceneManager::addOccluder(ISceneNode* node, IMesh* mesh)
+{
+	if (!node)
+		return;
+
+	if (!mesh)
+	{
+		switch (node->getType())
+		{
+		case ESNT_MESH:
+		case ESNT_CUBE:
+		case ESNT_SPHERE:
+		case ESNT_OCTREE:
+			mesh = static_cast<IMeshSceneNode*>(node)->getMesh();
+			break;
+		default:
+			break;
+		}
+	}
+
+	if (!mesh)
+	{
+		os::Printer::log("Could not add occluder, scene node has no mesh", ELL_WARNING);
+		return;
+	}
+
+	removeOccluder(node);
+
+	SOccluder occluder;
+	occluder.Node = node;
+	occluder.Mesh = mesh;
+	node->grab();
+	mesh->grab();
+	Occluders.push_back(occluder);
+}
+
+
+//! Removes a node added with addOccluder().
+void CSceneManager::removeOccluder(ISceneNode* node)
+{
+	for (u32 i=0; i<Occluders.size(); ++i)
+	{
+		if (Occluders[i].Node == node)
+		{
+			Occluders[i].Node->drop();
+			Occluders[i].Mesh->drop();
+			Occluders.erase(i);
+			return;
+		}
+	}
+}
+
+
+//! drops all occluders
+void CSceneManager::removeAllOccluders()
+{
+	for (u32 i=0; i<Occluders.size(); ++i)
+	{
+		Occluders[i].Node->drop();
+		Occluders[i].Mesh->drop();
+	}
+	Occluders.clear();
 }
 
 void CSceneManager::clearAllRegisteredNodesForRendering()
@@ -1382,8 +1726,411 @@ void CSceneManager::clearAllRegisteredNodesForRendering()
 	TransparentNodeList.clear();
 	TransparentEffectNodeList.clear();
 	ShadowNodeList.clear();
+	FrustumCullingNodes.clear();
+	FrustumCullingPasses.clear();
+	FrustumCuller.clear();
+}
+
+namespace
+{
+	//! An animated mesh used in a top-level hierarchy
+	//! Use of an animated mesh by a node of a top-level hierarchy
+	struct SAnimatedMeshUse
+	{
+		IAnimatedMesh* Mesh;
+		u32 TopLevelNode;
+
+		bool operator<(const SAnimatedMeshUse& other) const
+		{
+			return Mesh < other.Mesh;
+		}
+	};
+
+	//! Returns the representative of a set of top-level nodes animated together
+	u32 findAnimationGroup(core::array<u32>& groups, u32 i)
+	{
+		while (groups[i] != i)
+		{
+			groups[i] = groups[groups[i]];
+			i = groups[i];
+		}
+		return i;
+	}
+}
+
+
+//! Animates all scene nodes, optionally using several threads
+void CSceneManager::OnAnimate(u32 timeMs)
+{
+	if (Parameters->getAttributeAsBool(FLAT_TRANSFORM_HIERARCHY))
+	{
+		destroyAnimationGroups();
+		animateTransformHierarchy(timeMs);
+		return;
+	}
+	destroyTransformHierarchy();
+
+#ifdef _IRR_COMPILE_WITH_THREADS_
+	const s32 threadCount = Parameters->getAttributeAsInt(PARALLEL_ANIMATION_THREADS);
+	if (threadCount < 2 || Children.getSize() < 2 || !IsVisible)
+	{
+		ISceneNode::OnAnimate(timeMs);
+		return;
+	}
+
+	if (!AnimationThreads || AnimationThreads->getThreadCount() != (u32)(threadCount-1))
+	{
+		if (AnimationThreads)
+			AnimationThreads->drop();
+		AnimationThreads = new CThreadPool(threadCount-1);
+	}
+
+	// the root node itself is animated first, like in ISceneNode::OnAnimate
+	ISceneNodeAnimatorList::Iterator ait = Animators.begin();
+	while (ait != Animators.end())
+	{
+		ISceneNodeAnimator* anim = *ait;
+		++ait;
+		if (anim->isEnabled())
+			anim->animateNode(this, timeMs);
+	}
+	updateAbsolutePosition();
+
+	if (!AnimationGroups || AnimationGroups->HierarchyChanged)
+		rebuildAnimationGroups();
+
+	AnimationTime = timeMs;
+	AnimationThreads->run(animateTopLevelNode, this, AnimationJobs.size()-1);
+#else
+	ISceneNode::OnAnimate(timeMs);
+#endif
+}
+
+
+//! Groups the top-level nodes into jobs for the animation threads
+/** Each top-level hierarchy is one job, unless it shares animated meshes
+with other hierarchies. Animating a node writes into its mesh, e.g. the
+joints of a skinned mesh, so nodes sharing a mesh must not be animated at
+the same time. The nodes are stored in AnimationGroups, so adding, removing
+or moving nodes and changing the mesh of an animated mesh scene node mark
+the groups for a rebuild. */
+void CSceneManager::rebuildAnimationGroups()
+{
+	if (!AnimationGroups)
+		AnimationGroups = new STransformHierarchy();
+	STransformHierarchy& h = *AnimationGroups;
+	releaseTransformHierarchyNodes(h);
+	h.Nodes.set_used(0);
+	TransformHierarchy = &h;
+	TransformHierarchyIndex = -1;
+
+	core::array<ISceneNode*> topLevelNodes;
+	core::array<SAnimatedMeshUse> meshUses;
+	ISceneNodeList::ConstIterator it = Children.begin();
+	for (; it != Children.end(); ++it)
+	{
+		const u32 first = h.Nodes.size();
+		appendAnimationGroupNodes(*it);
+		for (u32 n=first; n<h.Nodes.size(); ++n)
+		{
+			if (h.Nodes[n]->getType() == ESNT_ANIMATED_MESH)
+			{
+				SAnimatedMeshUse use;
+				use.Mesh = ((IAnimatedMeshSceneNode*)h.Nodes[n])->getMesh();
+				use.TopLevelNode = topLevelNodes.size();
+				if (use.Mesh)
+					meshUses.push_back(use);
+			}
+		}
+		topLevelNodes.push_back(*it);
+	}
+
+	core::array<u32> groups;
+	groups.set_used(topLevelNodes.size());
+	u32 i;
+	for (i=0; i<groups.size(); ++i)
+		groups[i] = i;
+	meshUses.sort();
+	for (i=1; i<meshUses.size(); ++i)
+	{
+		if (meshUses[i].Mesh == meshUses[i-1].Mesh)
+			groups[findAnimationGroup(groups, meshUses[i].TopLevelNode)] =
+				findAnimationGroup(groups, meshUses[i-1].TopLevelNode);
+	}
+
+	// sort the top-level nodes by group, AnimationJobs has the first node of each job
+	core::array<u32> jobOfGroup;
+	jobOfGroup.set_used(groups.size());
+	AnimationJobs.set_used(0);
+	for (i=0; i<groups.size(); ++i)
+	{
+		if (findAnimationGroup(groups, i) == i)
+		{
+			jobOfGroup[i] = AnimationJobs.size();
+			AnimationJobs.push_back(0);
+		}
+	}
+	AnimationJobs.push_back(0);
+	for (i=0; i<groups.size(); ++i)
+		++AnimationJobs[jobOfGroup[findAnimationGroup(groups, i)]+1];
+	for (i=1; i<AnimationJobs.size(); ++i)
+		AnimationJobs[i] += AnimationJobs[i-1];
+
+	AnimatedNodes.set_used(topLevelNodes.size());
+	core::array<u32> nextNode(AnimationJobs);
+	for (i=0; i<topLevelNodes.size(); ++i)
+		AnimatedNodes[nextNode[jobOfGroup[findAnimationGroup(groups, i)]]++] = topLevelNodes[i];
+
+	h.HierarchyChanged = false;
 }
 
+
+//! Stores a node and all its children in the animation groups
+void CSceneManager::appendAnimationGroupNodes(ISceneNode* node)
+{
+	STransformHierarchy& h = *AnimationGroups;
+	node->TransformHierarchy = &h;
+	node->TransformHierarchyIndex = h.Nodes.size();
+	h.Nodes.push_back(node);
+
+	ISceneNodeList::ConstIterator it = node->Children.begin();
+	for (; it != node->Children.end(); ++it)
+		appendAnimationGroupNodes(*it);
+}
+
+
+//! Removes the animation groups, changes of the scene are not tracked anymore
+void CSceneManager::destroyAnimationGroups()
+{
+	if (!AnimationGroups)
+		return;
+
+	releaseTransformHierarchyNodes(*AnimationGroups);
+	if (TransformHierarchy == AnimationGroups)
+		TransformHierarchy = 0;
+	AnimatedNodes.set_used(0);
+	AnimationJobs.set_used(0);
+	delete AnimationGroups;
+	AnimationGroups = 0;
+}
+
+
+//! Detaches the still existing nodes stored in a hierarchy from it
+void CSceneManager::releaseTransformHierarchyNodes(STransformHierarchy& h)
+{
+	for (u32 i=0; i<h.Nodes.size(); ++i)
+	{
+		if (h.Nodes[i] && h.Nodes[i]->TransformHierarchy == &h)
+		{
+			h.Nodes[i]->TransformHierarchy = 0;
+			h.Nodes[i]->TransformHierarchyIndex = -1;
+		}
+	}
+}
+
+
+//! animates the top-level nodes of one job, called by the worker threads
+void CSceneManager::animateTopLevelNode(void* sceneManager, u32 index)
+{
+	CSceneManager* smgr = (CSceneManager*)sceneManager;
+	for (u32 i=smgr->AnimationJobs[index]; i<smgr->AnimationJobs[index+1]; ++i)
+		smgr->AnimatedNodes[i]->OnAnimate(smgr->AnimationTime);
+}
+
+
+namespace
+{
+	//! States of the nodes in STransformHierarchy::States
+	enum E_TRANSFORM_HIERARCHY_STATE
+	{
+		//! The node and all its parents are visible
+		ETHS_ACTIVE = 1,
+
+		//! The absolute transformation changed in this update
+		ETHS_MOVED = 2
+	};
+}
+
+
+//! Animates the scene using the flat transform hierarchy
+void CSceneManager::animateTransformHierarchy(u32 timeMs)
+{
+	if (!IsVisible)
+		return;
+
+	if (!TransformHierarchy)
+	{
+		TransformHierarchy = new STransformHierarchy();
+		TransformHierarchyIndex = -1;
+	}
+	STransformHierarchy& h = *TransformHierarchy;
+
+	// the root node itself is animated first, like in ISceneNode::OnAnimate
+	ISceneNodeAnimatorList::Iterator ait = Animators.begin();
+	while (ait != Animators.end())
+	{
+		ISceneNodeAnimator* anim = *ait;
+		++ait;
+		if (anim->isEnabled())
+			anim->animateNode(this, timeMs);
+	}
+	updateAbsolutePosition();
+
+	if (h.HierarchyChanged)
+		rebuildTransformHierarchy();
+
+	const bool rootMoved = h.RootChangeCount != AbsoluteTransformationChangeCount;
+	h.RootChangeCount = AbsoluteTransformationChangeCount;
+
+	// Animators might move nodes to other parents while we are iterating.
+	// Only in that case the stored parents have to be checked against the real ones.
+	bool verifyParents = false;
+
+	const u32 count = h.Nodes.size();
+	for (u32 i=0; i<count; ++i)
+	{
+		h.States[i] = 0;
+
+		ISceneNode* node = h.Nodes[i];
+		if (!node || !(h.Flags[i] & ETHF_VISIBLE))
+			continue;
+
+		const s32 parent = h.Parents[i];
+		bool parentMoved = rootMoved;
+		if (parent >= 0)
+		{
+			if (!h.States[parent])
+				continue;
+			parentMoved = (h.States[parent] & ETHS_MOVED) != 0;
+		}
+
+		verifyParents |= h.HierarchyChanged;
+		if (verifyParents && node->Parent != (parent >= 0 ? h.Nodes[parent] : this))
+			continue;
+
+		if (h.Flags[i] & ETHF_CUSTOM)
+		{
+			// the node takes care of itself and its children
+			node->OnAnimate(timeMs);
+			h.States[i] = ETHS_ACTIVE;
+			h.clearFlags(i, ETHF_RELATIVE_CHANGED|ETHF_ABSOLUTE_CHANGED);
+			continue;
+		}
+
+		if (h.Flags[i] & ETHF_ANIMATED)
+		{
+			ait = node->Animators.begin();
+			while (ait != node->Animators.end())
+			{
+				// continue to the next node before calling animateNode()
+				// so that the animator may remove itself from the scene
+				// node without the iterator becoming invalid
+				ISceneNodeAnimator* anim = *ait;
+				++ait;
+				if (anim->isEnabled())
+					anim->animateNode(node, timeMs);
+			}
+			if (node->Animators.empty())
+				h.clearFlags(i, ETHF_ANIMATED);
+		}
+
+		if (parentMoved || (h.Flags[i] & ETHF_RELATIVE_CHANGED))
+		{
+			const ISceneNode* parentNode = parent >= 0 ? h.Nodes[parent] : this;
+			const core::matrix4& parentWorld = parent >= 0 ? h.AbsoluteTransformations[parent] : AbsoluteTransformation;
+			h.AbsoluteTransformations[i].setbyproduct_nocheck(parentWorld, node->getRelativeTransformation());
+			node->AbsoluteTransformation = h.AbsoluteTransformations[i];
+			node->ParentTransformationChangeCount = parentNode->AbsoluteTransformationChangeCount;
+			node->RelativeTransformationChanged = false;
+			++node->AbsoluteTransformationChangeCount;
+			h.States[i] = ETHS_ACTIVE|ETHS_MOVED;
+		}
+		else if (h.Flags[i] & ETHF_ABSOLUTE_CHANGED)
+		{
+			// updated outside of this loop, e.g. by an animator
+			h.AbsoluteTransformations[i] = node->AbsoluteTransformation;
+			h.States[i] = ETHS_ACTIVE|ETHS_MOVED;
+		}
+		else
+			h.States[i] = ETHS_ACTIVE;
+
+		h.clearFlags(i, ETHF_RELATIVE_CHANGED|ETHF_ABSOLUTE_CHANGED);
+	}
+}
+
+
+//! Stores the children of a node in the flat transform hierarchy
+void CSceneManager::appendTransformHierarchyChildren(ISceneNode* node, s32 index)
+{
+	STransformHierarchy& h = *TransformHierarchy;
+
+	ISceneNodeList::ConstIterator it = node->Children.begin();
+	for (; it != node->Children.end(); ++it)
+	{
+		ISceneNode* child = *it;
+
+		u8 flags = 0;
+		if (child->IsVisible)
+			flags |= ETHF_VISIBLE;
+		if (!child->Animators.empty())
+			flags |= ETHF_ANIMATED;
+		if (!child->hasPlainTransformation())
+			flags |= ETHF_CUSTOM;
+		if (child->RelativeTransformationChanged ||
+			child->ParentTransformationChangeCount != node->AbsoluteTransformationChangeCount)
+			flags |= ETHF_RELATIVE_CHANGED;
+
+		child->TransformHierarchy = &h;
+		child->TransformHierarchyIndex = h.Nodes.size();
+		h.Nodes.push_back(child);
+		h.Parents.push_back(index);
+		h.Flags.push_back(flags);
+		h.AbsoluteTransformations.push_back(child->AbsoluteTransformation);
+	}
+}
+
+
+//! Sorts all nodes of the scene into the flat transform hierarchy
+void CSceneManager::rebuildTransformHierarchy()
+{
+	STransformHierarchy& h = *TransformHierarchy;
+
+	// nodes might have been moved into another scene manager meanwhile
+	releaseTransformHierarchyNodes(h);
+
+	h.Nodes.set_used(0);
+	h.Parents.set_used(0);
+	h.Flags.set_used(0);
+	h.AbsoluteTransformations.set_used(0);
+
+	// breadth first, so parents are always stored before their children
+	appendTransformHierarchyChildren(this, -1);
+	for (u32 i=0; i<h.Nodes.size(); ++i)
+	{
+		if (!(h.Flags[i] & ETHF_CUSTOM))
+			appendTransformHierarchyChildren(h.Nodes[i], (s32)i);
+	}
+
+	h.States.set_used(h.Nodes.size());
+	h.HierarchyChanged = false;
+}
+
+
+//! Removes the flat transform hierarchy, nodes are animated recursively again
+void CSceneManager::destroyTransformHierarchy()
+{
+	// the root node is also stored in the animation groups while they exist
+	if (!TransformHierarchy || TransformHierarchy == AnimationGroups)
+		return;
+
+	STransformHierarchy* h = TransformHierarchy;
+	releaseTransformHierarchyNodes(*h);
+
+	TransformHierarchy = 0;
+	delete h;
+}
+
+
 //! This method is called just before the rendering process of the whole scene.
 //! draws all scene nodes
 void CSceneManager::drawAll()
@@ -1433,7 +2180,11 @@ void CSceneManager::drawAll()
 	IRR_PROFILE(getProfiler().stop(EPID_SM_RENDER_CAMERAS));
 
 	// let all nodes register themselves
+	VisibleNodeCount = 0;
+	CulledNodeCount = 0;
+	prepareOcclusionCulling();
 	OnRegisterSceneNode();
+	cullRegisteredNodes();
 
 	if (LightManager)
 		LightManager->OnPreRender(LightList);
@@ -1932,6 +2683,9 @@ void CSceneManager::addToDeletionQueue(ISceneNode* node)
 		return;
 
 	node->grab();
+
+	// deletion animators might run on animation threads
+	CMutexLock lock(DeletionListMutex);
 	DeletionList.push_back(node);
 }
 
@@ -2059,6 +2813,7 @@ bool CSceneManager::postEventFromUser(const SEvent& event)
 //! Removes all children of this scene node
 void CSceneManager::removeAll()
 {
+	removeAllOccluders();
 	ISceneNode::removeAll();
 	setActiveCamera(0);
 	// Make sure the driver is reset, might need a more complex method at some point
@@ -2508,6 +3263,7 @@ void CSceneManager::deserializeAttributes(io::IAttributes* in, io::SAttributeRea
 	RelativeTranslation.set(0,0,0);
 	RelativeRotation.set(0,0,0);
 	RelativeScale.set(1,1,1);
+	setTransformationDirty();
 	IsVisible = true;
 	AutomaticCullingState = scene::EAC_BOX;
 	DebugDataVisible = scene::EDS_OFF;
@@ -2583,6 +3339,12 @@ IMeshWriter* CSceneManager::createMeshWriter(EMESH_WRITER_TYPE type)
 		return new CB3DMeshWriter();
 #else
 		return 0;
+#endif
+	case EMWT_IRR_BINARY_MESH:
+#ifdef _IRR_COMPILE_WITH_IRR_BINARY_WRITER_
+		return new CIrrBinaryMeshWriter(Driver, FileSystem);
+#else
+		return 0;
 #endif
 	}
 
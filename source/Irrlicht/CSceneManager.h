@@ -13,6 +13,9 @@
 #include "IMeshLoader.h"
 #include "CAttributes.h"
 #include "ILightManager.h"
+#include "CThreadPool.h"
+#include "CFrustumCuller.h"
+#include "COcclusionCuller.h"
 
 namespace irr
 {
@@ -130,6 +133,24 @@ namespace scene
 		virtual IOctreeSceneNode* addOctreeSceneNode(IMesh* mesh, ISceneNode* parent=0,
 			s32 id=-1, s32 minimalPolysPerNode=128, bool alsoAddIfMeshPointerZero=false) _IRR_OVERRIDE_;
 
+		//! Adds a scene node which draws simplified versions of a mesh when it gets small on the screen.
+		virtual ILODSceneNode* addLODSceneNode(IMesh* mesh, u32 levelCount=4, f32 reduction=0.25f,
+			ISceneNode* parent=0, s32 id=-1,
+			const core::vector3df& position = core::vector3df(0,0,0),
+			const core::vector3df& rotation = core::vector3df(0,0,0),
+			const core::vector3df& scale = core::vector3df(1.0f, 1.0f, 1.0f)) _IRR_OVERRIDE_;
+
+		//! Merges many static mesh scene nodes into one node with few draw calls.
+		virtual IBatchedMeshSceneNode* addBatchedMeshSceneNode(const core::array<ISceneNode*>& nodes,
+			ISceneNode* parent=0, s32 id=-1, u32 maxChunkVertices=0x10000) _IRR_OVERRIDE_;
+
+		//! Adds a scene node which culls small clusters of triangles of a mesh separately.
+		virtual IClusteredMeshSceneNode* addClusteredMeshSceneNode(IMesh* mesh, ISceneNode* parent=0, s32 id=-1,
+			const core::vector3df& position = core::vector3df(0,0,0),
+			const core::vector3df& rotation = core::vector3df(0,0,0),
+			const core::vector3df& scale = core::vector3df(1.0f, 1.0f, 1.0f),
+			u32 maxVertices=64, u32 maxTriangles=124) _IRR_OVERRIDE_;
+
 		//! Adds a camera scene node to the tree and sets it as active camera.
 		//! \param position: Position of the space relative to its parent where the camera will be placed.
 		//! \param lookat: Position where the camera will look at. Also known as target.
@@ -200,6 +221,10 @@ namespace scene
 			const core::vector3df& position = core::vector3df(0,0,0), s32 id=-1,
 			video::SColor colorTop = 0xFFFFFFFF, video::SColor colorBottom = 0xFFFFFFFF) _IRR_OVERRIDE_;
 
+		//! Adds a scene node drawing the geometry of a quake3 level to the scene graph.
+		virtual IQ3LevelSceneNode* addQuake3LevelSceneNode(IQ3LevelMesh* mesh,
+			ISceneNode* parent=0, s32 id=-1) _IRR_OVERRIDE_;
+
 		//! Adds a scene node, which can render a quake3 shader
 		virtual IMeshSceneNode* addQuake3SceneNode(const IMeshBuffer* meshBuffer, const quake3::IShader * shader,
 			ISceneNode* parent=0, s32 id=-1) _IRR_OVERRIDE_;
@@ -270,6 +295,24 @@ namespace scene
 			s32 maxLOD=4, E_TERRAIN_PATCH_SIZE patchSize=ETPS_17,s32 smoothFactor=0,
 			bool addAlsoIfHeightmapEmpty=false) _IRR_OVERRIDE_;
 
+		//! Adds a scene node for a terrain which is loaded tile by tile while it is drawn.
+		virtual IPagedTerrainSceneNode* addPagedTerrainSceneNode(
+			const io::path& heightMapFileName, const core::dimension2du& heightmapSize,
+			ISceneNode* parent=0, s32 id=-1,
+			const core::vector3df& position = core::vector3df(0.0f,0.0f,0.0f),
+			const core::vector3df& rotation = core::vector3df(0.0f,0.0f,0.0f),
+			const core::vector3df& scale = core::vector3df(1.0f,1.0f,1.0f),
+			u32 tileSize=64, s32 maxLOD=5) _IRR_OVERRIDE_;
+
+		//! Adds a scene node for a terrain which is loaded tile by tile while it is drawn.
+		virtual IPagedTerrainSceneNode* addPagedTerrainSceneNode(
+			io::IReadFile* heightMapFile, const core::dimension2du& heightmapSize,
+			ISceneNode* parent=0, s32 id=-1,
+			const core::vector3df& position = core::vector3df(0.0f,0.0f,0.0f),
+			const core::vector3df& rotation = core::vector3df(0.0f,0.0f,0.0f),
+			const core::vector3df& scale = core::vector3df(1.0f,1.0f,1.0f),
+			u32 tileSize=64, s32 maxLOD=5) _IRR_OVERRIDE_;
+
 		//! Adds a dummy transformation scene node to the scene graph.
 		virtual IDummyTransformationSceneNode* addDummyTransformationSceneNode(
 			ISceneNode* parent=0, s32 id=-1) _IRR_OVERRIDE_;
@@ -532,8 +575,65 @@ namespace scene
 		//! returns if node is culled
 		virtual bool isCulled(const ISceneNode* node) const _IRR_OVERRIDE_;
 
+		//! Get the number of scene nodes which passed the culling tests in the last drawAll() call.
+		virtual u32 getVisibleNodeCount() const _IRR_OVERRIDE_ { return VisibleNodeCount; }
+
+		//! Get the number of scene nodes which were culled in the last drawAll() call.
+		virtual u32 getCulledNodeCount() const _IRR_OVERRIDE_ { return CulledNodeCount; }
+
+		//! Adds a scene node which hides the nodes behind it in the software occlusion culling.
+		virtual void addOccluder(ISceneNode* node, IMesh* mesh=0) _IRR_OVERRIDE_;
+
+		//! Removes a node added with addOccluder().
+		virtual void removeOccluder(ISceneNode* node) _IRR_OVERRIDE_;
+
+		//! Animates all scene nodes, optionally using several threads
+		virtual void OnAnimate(u32 timeMs) _IRR_OVERRIDE_;
+
 	private:
 
+		//! animates the top-level nodes of one job, called by the worker threads
+		static void animateTopLevelNode(void* sceneManager, u32 index);
+
+		//! Groups the top-level nodes into jobs for the animation threads
+		void rebuildAnimationGroups();
+
+		//! Stores a node and all its children in the animation groups
+		void appendAnimationGroupNodes(ISceneNode* node);
+
+		//! Removes the animation groups, changes of the scene are not tracked anymore
+		void destroyAnimationGroups();
+
+		//! Detaches the still existing nodes stored in a hierarchy from it
+		void releaseTransformHierarchyNodes(STransformHierarchy& h);
+
+		//! Animates the scene using the flat transform hierarchy
+		void animateTransformHierarchy(u32 timeMs);
+
+		//! Stores the children of a node in the flat transform hierarchy
+		void appendTransformHierarchyChildren(ISceneNode* node, s32 index);
+
+		//! Sorts all nodes of the scene into the flat transform hierarchy
+		void rebuildTransformHierarchy();
+
+		//! Removes the flat transform hierarchy, nodes are animated recursively again
+		void destroyTransformHierarchy();
+
+		//! returns if node is culled by one of the given E_CULLING_TYPE tests
+		bool isCulledBy(const ISceneNode* node, u32 cullingTypes) const;
+
+		//! adds a node which passed culling to the render list of a pass
+		u32 addToRenderList(ISceneNode* node, E_SCENE_NODE_RENDER_PASS pass);
+
+		//! tests all nodes waiting for the frustum test and adds the visible ones to the render lists
+		void cullRegisteredNodes();
+
+		//! rasterizes the occluders for this frame, if software occlusion culling is enabled
+		void prepareOcclusionCulling();
+
+		//! drops all occluders
+		void removeAllOccluders();
+
 		// load and create a mesh which we know already isn't in the cache and put it in there
 		IAnimatedMesh* getUncachedMesh(io::IReadFile* file, const io::path& filename, const io::path& cachename);
 
@@ -631,9 +731,30 @@ namespace scene
 		core::array<TransparentNodeEntry> TransparentNodeList;
 		core::array<TransparentNodeEntry> TransparentEffectNodeList;
 
+		//! nodes waiting for the frustum test in cullRegisteredNodes(), and their render pass
+		core::array<ISceneNode*> FrustumCullingNodes;
+		core::array<E_SCENE_NODE_RENDER_PASS> FrustumCullingPasses;
+		CFrustumCuller FrustumCuller;
+
+		//! culling results of the current frame
+		u32 VisibleNodeCount;
+		u32 CulledNodeCount;
+
+		struct SOccluder
+		{
+			ISceneNode* Node;
+			IMesh* Mesh;
+		};
+
+		//! nodes added with addOccluder() and the depth buffer they are drawn into
+		core::array<SOccluder> Occluders;
+		COcclusionCuller OcclusionCuller;
+		bool OcclusionCulling;
+
 		core::array<IMeshLoader*> MeshLoaderList;
 		core::array<ISceneLoader*> SceneLoaderList;
 		core::array<ISceneNode*> DeletionList;
+		CMutex DeletionListMutex;
 		core::array<ISceneNodeFactory*> SceneNodeFactoryList;
 		core::array<ISceneNodeAnimatorFactory*> SceneNodeAnimatorFactoryList;
 
@@ -664,6 +785,21 @@ namespace scene
 		const core::stringw IRR_XML_FORMAT_NODE_ATTR_TYPE;
 
 		IGeometryCreator* GeometryCreator;
+
+		//! Worker threads for animating the scene, created on demand
+		CThreadPool* AnimationThreads;
+
+		//! All nodes of the scene while animating with several threads
+		/** Only the Nodes and HierarchyChanged members are used, to rebuild
+		the jobs when the scene changed. */
+		STransformHierarchy* AnimationGroups;
+
+		//! Top-level nodes animated by the worker threads and the current time
+		/** Hierarchies sharing an animated mesh are animated by the same job. */
+		core::array<ISceneNode*> AnimatedNodes;
+		//! First index in AnimatedNodes of each job, with one entry more than jobs
+		core::array<u32> AnimationJobs;
+		u32 AnimationTime;
 	};
 
 } // end namespace video
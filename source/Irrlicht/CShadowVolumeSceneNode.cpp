@@ -10,6 +10,12 @@
 #include "SViewFrustum.h"
 #include "SLight.h"
 #include "os.h"
+#include "EProfileIDs.h"
+#include "IProfiler.h"
+
+#ifdef _IRR_COMPILE_WITH_SSE_
+#include <xmmintrin.h>
+#endif
 
 namespace irr
 {
@@ -22,11 +28,22 @@ CShadowVolumeSceneNode::CShadowVolumeSceneNode(const IMesh* shadowMesh, ISceneNo
 		ISceneManager* mgr, s32 id, bool zfailmethod, f32 infinity)
 : IShadowVolumeSceneNode(parent, mgr, id),
 	ShadowMesh(0), IndexCount(0), VertexCount(0), ShadowVolumesUsed(0),
+	RebuiltVolumeCount(0), UpdateThreads(0), UpdateThreadCount(1),
 	Infinity(infinity), UseZFailMethod(zfailmethod)
 {
 	#ifdef _DEBUG
 	setDebugName("CShadowVolumeSceneNode");
 	#endif
+
+	IRR_PROFILE(
+		static bool initProfile = false;
+		if (!initProfile )
+		{
+			initProfile = true;
+			getProfiler().add(EPID_SV_UPDATE, L"shadow volumes", L"Irrlicht scene");
+		}
+	)
+
 	setShadowMesh(shadowMesh);
 	setAutomaticCulling(scene::EAC_OFF);
 }
@@ -37,167 +54,149 @@ CShadowVolumeSceneNode::~CShadowVolumeSceneNode()
 {
 	if (ShadowMesh)
 		ShadowMesh->drop();
-}
-
-
-void CShadowVolumeSceneNode::createShadowVolume(const core::vector3df& light, bool isDirectional)
-{
-	SShadowVolume* svp = 0;
-	core::aabbox3d<f32>* bb = 0;
-
-	// builds the shadow volume and adds it to the shadow volume list.
-
-	if (ShadowVolumes.size() > ShadowVolumesUsed)
-	{
-		// get the next unused buffer
-
-		svp = &ShadowVolumes[ShadowVolumesUsed];
-		svp->set_used(0);
-
-		bb = &ShadowBBox[ShadowVolumesUsed];
-	}
-	else
-	{
-		ShadowVolumes.push_back(SShadowVolume());
-		svp = &ShadowVolumes.getLast();
-
-		ShadowBBox.push_back(core::aabbox3d<f32>());
-		bb = &ShadowBBox.getLast();
-	}
-	svp->reallocate(IndexCount*5);
-	++ShadowVolumesUsed;
-
-	// We use triangle lists
-	Edges.set_used(IndexCount*2);
-	u32 numEdges = 0;
-
-	numEdges=createEdgesAndCaps(light, svp, bb);
-
-	// for all edges add the near->far quads
-	for (u32 i=0; i<numEdges; ++i)
-	{
-		const core::vector3df &v1 = Vertices[Edges[2*i+0]];
-		const core::vector3df &v2 = Vertices[Edges[2*i+1]];
-		const core::vector3df v3(v1+(v1 - light).normalize()*Infinity);
-		const core::vector3df v4(v2+(v2 - light).normalize()*Infinity);
-
-		// Add a quad (two triangles) to the vertex list
-#ifdef _DEBUG
-		if (svp->size() >= svp->allocated_size()-5)
-			os::Printer::log("Allocation too small.", ELL_DEBUG);
-#endif
-		svp->push_back(v1);
-		svp->push_back(v2);
-		svp->push_back(v3);
-
-		svp->push_back(v2);
-		svp->push_back(v4);
-		svp->push_back(v3);
-	}
+	if (UpdateThreads)
+		UpdateThreads->drop();
 }
 
 
 #define IRR_USE_ADJACENCY
 #define IRR_USE_REVERSE_EXTRUDED
 
-u32 CShadowVolumeSceneNode::createEdgesAndCaps(const core::vector3df& light,
-					SShadowVolume* svp, core::aabbox3d<f32>* bb)
+void CShadowVolumeSceneNode::createShadowVolume(SShadowVolume& volume) const
 {
-	u32 numEdges=0;
+	// builds the shadow volume of the light stored in the volume
+	const core::vector3df& light = volume.Light;
+	core::array<core::vector3df>& svp = volume.Triangles;
+	core::array<bool>& faceData = volume.FaceData;
+
+	svp.set_used(0);
+	svp.reallocate(IndexCount*5);
+	volume.Valid = true;
+
 	const u32 faceCount = IndexCount / 3;
 
 	if(faceCount >= 1)
-		bb->reset(Vertices[Indices[0]]);
+		volume.BBox.reset(Vertices[Indices[0]]);
 	else
-		bb->reset(0,0,0);
+		volume.BBox.reset(0,0,0);
 
 	// Check every face if it is front or back facing the light.
-	for (u32 i=0; i<faceCount; ++i)
+	classifyFaces(light, faceData);
+
+	if (UseZFailMethod)
 	{
-		const core::vector3df v0 = Vertices[Indices[3*i+0]];
-		const core::vector3df v1 = Vertices[Indices[3*i+1]];
-		const core::vector3df v2 = Vertices[Indices[3*i+2]];
+		for (u32 i=0; i<faceCount; ++i)
+		{
+			if (!faceData[i])
+				continue;
 
-#ifdef IRR_USE_REVERSE_EXTRUDED
-		FaceData[i]=core::triangle3df(v0,v1,v2).isFrontFacing(light);
-#else
-		FaceData[i]=core::triangle3df(v2,v1,v0).isFrontFacing(light);
-#endif
+			const core::vector3df& v0 = Vertices[Indices[3*i+0]];
+			const core::vector3df& v1 = Vertices[Indices[3*i+1]];
+			const core::vector3df& v2 = Vertices[Indices[3*i+2]];
 
-		if (UseZFailMethod && FaceData[i])
-		{
 #ifdef _DEBUG
-			if (svp->size() >= svp->allocated_size()-5)
+			if (svp.size() >= svp.allocated_size()-5)
 				os::Printer::log("Allocation too small.", ELL_DEBUG);
 #endif
 			// add front cap from light-facing faces
-			svp->push_back(v2);
-			svp->push_back(v1);
-			svp->push_back(v0);
+			svp.push_back(v2);
+			svp.push_back(v1);
+			svp.push_back(v0);
 
 			// add back cap
 			const core::vector3df i0 = v0+(v0-light).normalize()*Infinity;
 			const core::vector3df i1 = v1+(v1-light).normalize()*Infinity;
 			const core::vector3df i2 = v2+(v2-light).normalize()*Infinity;
 
-			svp->push_back(i0);
-			svp->push_back(i1);
-			svp->push_back(i2);
+			svp.push_back(i0);
+			svp.push_back(i1);
+			svp.push_back(i2);
 
-			bb->addInternalPoint(i0);
-			bb->addInternalPoint(i1);
-			bb->addInternalPoint(i2);
+			volume.BBox.addInternalPoint(i0);
+			volume.BBox.addInternalPoint(i1);
+			volume.BBox.addInternalPoint(i2);
 		}
 	}
 
-	// Create edges
+	// Add the near->far quads for all silhouette edges
 	for (u32 i=0; i<faceCount; ++i)
 	{
 		// check all front facing faces
-		if (FaceData[i] == true)
-		{
-			const u16 wFace0 = Indices[3*i+0];
-			const u16 wFace1 = Indices[3*i+1];
-			const u16 wFace2 = Indices[3*i+2];
-
-			const u16 adj0 = Adjacency[3*i+0];
-			const u16 adj1 = Adjacency[3*i+1];
-			const u16 adj2 = Adjacency[3*i+2];
+		if (!faceData[i])
+			continue;
 
+		for (u32 edge=0; edge<3; ++edge)
+		{
 			// add edges if face is adjacent to back-facing face
 			// or if no adjacent face was found
+			const u16 adj = Adjacency[3*i+edge];
 #ifdef IRR_USE_ADJACENCY
-			if (adj0 == i || FaceData[adj0] == false)
+			if (adj != i && faceData[adj])
+				continue;
 #endif
-			{
-				// add edge v0-v1
-				Edges[2*numEdges+0] = wFace0;
-				Edges[2*numEdges+1] = wFace1;
-				++numEdges;
-			}
 
-#ifdef IRR_USE_ADJACENCY
-			if (adj1 == i || FaceData[adj1] == false)
-#endif
-			{
-				// add edge v1-v2
-				Edges[2*numEdges+0] = wFace1;
-				Edges[2*numEdges+1] = wFace2;
-				++numEdges;
-			}
+			const core::vector3df& v1 = Vertices[Indices[3*i+edge]];
+			const core::vector3df& v2 = Vertices[Indices[3*i+(edge+1)%3]];
+			const core::vector3df v3(v1+(v1 - light).normalize()*Infinity);
+			const core::vector3df v4(v2+(v2 - light).normalize()*Infinity);
 
-#ifdef IRR_USE_ADJACENCY
-			if (adj2 == i || FaceData[adj2] == false)
+			// Add a quad (two triangles) to the vertex list
+#ifdef _DEBUG
+			if (svp.size() >= svp.allocated_size()-5)
+				os::Printer::log("Allocation too small.", ELL_DEBUG);
 #endif
-			{
-				// add edge v2-v0
-				Edges[2*numEdges+0] = wFace2;
-				Edges[2*numEdges+1] = wFace0;
-				++numEdges;
-			}
+			svp.push_back(v1);
+			svp.push_back(v2);
+			svp.push_back(v3);
+
+			svp.push_back(v2);
+			svp.push_back(v4);
+			svp.push_back(v3);
 		}
 	}
-	return numEdges;
+}
+
+
+//! Sets a flag for each face which is front facing the light
+void CShadowVolumeSceneNode::classifyFaces(const core::vector3df& light, core::array<bool>& faceData) const
+{
+	const u32 faceCount = IndexCount / 3;
+	faceData.set_used(faceCount);
+
+	u32 i = 0;
+#ifdef _IRR_COMPILE_WITH_SSE_
+	const f32* n = FaceNormals.const_pointer();
+	const __m128 lx = _mm_set1_ps(light.X);
+	const __m128 ly = _mm_set1_ps(light.Y);
+	const __m128 lz = _mm_set1_ps(light.Z);
+	const __m128 zero = _mm_setzero_ps();
+	for (; i+4<=faceCount; i+=4, n+=12)
+	{
+		const __m128 d = _mm_add_ps(_mm_add_ps(
+			_mm_mul_ps(_mm_loadu_ps(n), lx),
+			_mm_mul_ps(_mm_loadu_ps(n+4), ly)),
+			_mm_mul_ps(_mm_loadu_ps(n+8), lz));
+		const int mask = _mm_movemask_ps(_mm_cmple_ps(d, zero));
+		faceData[i+0] = (mask & 1) != 0;
+		faceData[i+1] = (mask & 2) != 0;
+		faceData[i+2] = (mask & 4) != 0;
+		faceData[i+3] = (mask & 8) != 0;
+	}
+#endif
+	for (; i<faceCount; ++i)
+	{
+		const u32 block = (i & ~3u)*3 + (i & 3);
+		const f32 d = FaceNormals[block]*light.X + FaceNormals[block+4]*light.Y + FaceNormals[block+8]*light.Z;
+		// same float compare as _mm_cmple_ps, so every face is classified alike
+		faceData[i] = d <= 0.f;
+	}
+}
+
+
+void CShadowVolumeSceneNode::createShadowVolumeJob(void* userData, u32 index)
+{
+	const CShadowVolumeSceneNode* node = (const CShadowVolumeSceneNode*)userData;
+	node->createShadowVolume(*node->RebuiltVolumes[index]);
 }
 
 
@@ -213,83 +212,229 @@ void CShadowVolumeSceneNode::setShadowMesh(const IMesh* mesh)
 		ShadowMesh->grab();
 		Box = ShadowMesh->getBoundingBox();
 	}
+
+	// copy the new mesh with the next update
+	BufferStates.clear();
+	IndexCount = 0;
+	VertexCount = 0;
+	for (u32 i=0; i<ShadowVolumes.size(); ++i)
+		ShadowVolumes[i].Valid = false;
 }
 
 
-void CShadowVolumeSceneNode::updateShadowVolumes()
+void CShadowVolumeSceneNode::updateMeshData()
 {
-	const u32 oldIndexCount = IndexCount;
-	const u32 oldVertexCount = VertexCount;
-
 	const IMesh* const mesh = ShadowMesh;
-	if (!mesh)
-		return;
-
-	// create as much shadow volumes as there are lights but
-	// do not ignore the max light settings.
-	const u32 lightCount = SceneManager->getVideoDriver()->getDynamicLightCount();
-	if (!lightCount)
-		return;
-
-	// calculate total amount of vertices and indices
+	const u32 bufcnt = mesh->getMeshBufferCount();
 
-	VertexCount = 0;
-	IndexCount = 0;
-	ShadowVolumesUsed = 0;
+	bool verticesChanged = BufferStates.size() != bufcnt;
+	bool indicesChanged = verticesChanged;
+	BufferStates.set_used(bufcnt);
 
 	u32 i;
 	u32 totalVertices = 0;
 	u32 totalIndices = 0;
-	const u32 bufcnt = mesh->getMeshBufferCount();
 
 	for (i=0; i<bufcnt; ++i)
 	{
 		const IMeshBuffer* buf = mesh->getMeshBuffer(i);
-		totalIndices += buf->getIndexCount();
-		totalVertices += buf->getVertexCount();
+		SBufferState& state = BufferStates[i];
+
+		if (indicesChanged || state.Buffer != buf ||
+			state.VertexCount != buf->getVertexCount() ||
+			state.IndexCount != buf->getIndexCount() ||
+			state.ChangedID_Index != buf->getChangedID_Index())
+		{
+			indicesChanged = true;
+			verticesChanged = true;
+		}
+		else if (state.ChangedID_Vertex != buf->getChangedID_Vertex())
+			verticesChanged = true;
+
+		state.Buffer = buf;
+		state.VertexCount = buf->getVertexCount();
+		state.IndexCount = buf->getIndexCount();
+		state.ChangedID_Vertex = buf->getChangedID_Vertex();
+		state.ChangedID_Index = buf->getChangedID_Index();
+
+		totalIndices += state.IndexCount;
+		totalVertices += state.VertexCount;
 	}
 
+	if (!verticesChanged)
+		return;
+
+	// all volumes were built from the old mesh
+	for (i=0; i<ShadowVolumes.size(); ++i)
+		ShadowVolumes[i].Valid = false;
+
 	// allocate memory if necessary
 
 	Vertices.set_used(totalVertices);
-	Indices.set_used(totalIndices);
-	FaceData.set_used(totalIndices / 3);
+	VertexCount = 0;
+
+	// some meshes mark their indices as changed with each animation frame,
+	// so the adjacency is only recalculated if the indices really differ
+	bool adjacencyChanged = false;
+	if (indicesChanged)
+	{
+		adjacencyChanged = IndexCount != totalIndices;
+		Indices.set_used(totalIndices);
+	}
+	IndexCount = 0;
 
 	// copy mesh
 	for (i=0; i<bufcnt; ++i)
 	{
 		const IMeshBuffer* buf = mesh->getMeshBuffer(i);
 
-		const u16* idxp = buf->getIndices();
-		const u16* idxpend = idxp + buf->getIndexCount();
-		for (; idxp!=idxpend; ++idxp)
-			Indices[IndexCount++] = *idxp + VertexCount;
+		if (indicesChanged)
+		{
+			const u16* idxp = buf->getIndices();
+			const u16* idxpend = idxp + buf->getIndexCount();
+			for (; idxp!=idxpend; ++idxp, ++IndexCount)
+			{
+				const u16 index = *idxp + VertexCount;
+				adjacencyChanged |= Indices[IndexCount] != index;
+				Indices[IndexCount] = index;
+			}
+		}
+		else
+			IndexCount += buf->getIndexCount();
 
 		const u32 vtxcnt = buf->getVertexCount();
-		for (u32 j=0; j<vtxcnt; ++j)
-			Vertices[VertexCount++] = buf->getPosition(j);
+		if (video::isQuantizedVertexType(buf->getVertexType()))
+		{
+			// decoded directly, the accessors of quantized buffers are not
+			// safe when shadows of the same mesh update in parallel
+			const u8* v = (const u8*)buf->getVertices();
+			const u32 pitch = video::getVertexPitchFromType(buf->getVertexType());
+			const video::SVertexQuantization quantization = buf->getVertexQuantization();
+			for (u32 j=0; j<vtxcnt; ++j)
+				Vertices[VertexCount++] = ((const video::S3DVertexQuantized*)(v+j*pitch))->getPosition(quantization);
+		}
+		else
+		{
+			for (u32 j=0; j<vtxcnt; ++j)
+				Vertices[VertexCount++] = buf->getPosition(j);
+		}
 	}
 
 	// recalculate adjacency if necessary
-	if (oldVertexCount != VertexCount || oldIndexCount != IndexCount)
+	if (adjacencyChanged)
 		calculateAdjacency();
 
+	// face normals for the light classification, padded to whole blocks
+	const u32 faceCount = IndexCount / 3;
+	FaceNormals.set_used(((faceCount+3)/4)*12);
+	for (i=0; i<FaceNormals.size(); ++i)
+		FaceNormals[i] = 0.f;
+	for (i=0; i<faceCount; ++i)
+	{
+		const core::vector3df& v0 = Vertices[Indices[3*i+0]];
+		const core::vector3df& v1 = Vertices[Indices[3*i+1]];
+		const core::vector3df& v2 = Vertices[Indices[3*i+2]];
+
+#ifdef IRR_USE_REVERSE_EXTRUDED
+		const core::vector3df n = core::triangle3df(v0,v1,v2).getNormal();
+#else
+		const core::vector3df n = core::triangle3df(v2,v1,v0).getNormal();
+#endif
+		const u32 block = (i & ~3u)*3 + (i & 3);
+		FaceNormals[block] = n.X;
+		FaceNormals[block+4] = n.Y;
+		FaceNormals[block+8] = n.Z;
+	}
+}
+
+
+void CShadowVolumeSceneNode::updateShadowVolumes()
+{
+	IRR_PROFILE(CProfileScope p(EPID_SV_UPDATE);)
+
+	ShadowVolumesUsed = 0;
+	RebuiltVolumeCount = 0;
+
+	if (!ShadowMesh)
+		return;
+
+	// create as much shadow volumes as there are lights but
+	// do not ignore the max light settings.
+	const u32 lightCount = SceneManager->getVideoDriver()->getDynamicLightCount();
+	if (!lightCount)
+		return;
+
+	updateMeshData();
+
 	core::matrix4 mat = Parent->getAbsoluteTransformation();
 	mat.makeInverse();
 	const core::vector3df parentpos = Parent->getAbsolutePosition();
 
+	RebuiltVolumes.set_used(0);
+
 	// TODO: Only correct for point lights.
-	for (i=0; i<lightCount; ++i)
+	for (u32 i=0; i<lightCount; ++i)
 	{
 		const video::SLight& dl = SceneManager->getVideoDriver()->getDynamicLight(i);
 		core::vector3df lpos = dl.Position;
-		if (dl.CastShadows &&
-			fabs((lpos - parentpos).getLengthSQ()) <= (dl.Radius*dl.Radius*4.0f))
+		if (!dl.CastShadows ||
+			fabs((lpos - parentpos).getLengthSQ()) > (dl.Radius*dl.Radius*4.0f))
+			continue;
+
+		mat.transformVect(lpos);
+
+		// reuse a volume built for the same light position in object space
+		u32 v;
+		for (v=ShadowVolumesUsed; v<ShadowVolumes.size(); ++v)
 		{
-			mat.transformVect(lpos);
-			createShadowVolume(lpos);
+			if (ShadowVolumes[v].Valid && ShadowVolumes[v].Light.equals(lpos))
+				break;
 		}
+
+		if (v == ShadowVolumes.size())
+		{
+			if (ShadowVolumes.size() == ShadowVolumesUsed)
+				ShadowVolumes.push_back(SShadowVolume());
+			v = ShadowVolumesUsed;
+			ShadowVolumes[v].Light = lpos;
+			ShadowVolumes[v].Valid = false;
+		}
+
+		if (v != ShadowVolumesUsed)
+			ShadowVolumes[ShadowVolumesUsed].swap(ShadowVolumes[v]);
+		++ShadowVolumesUsed;
 	}
+
+	// pointers are taken after all volumes were added
+	for (u32 i=0; i<ShadowVolumesUsed; ++i)
+	{
+		if (!ShadowVolumes[i].Valid)
+			RebuiltVolumes.push_back(&ShadowVolumes[i]);
+	}
+	RebuiltVolumeCount = RebuiltVolumes.size();
+
+	if (UpdateThreads && RebuiltVolumeCount > 1)
+		UpdateThreads->run(createShadowVolumeJob, this, RebuiltVolumeCount);
+	else
+	{
+		for (u32 i=0; i<RebuiltVolumeCount; ++i)
+			createShadowVolume(*RebuiltVolumes[i]);
+	}
+}
+
+
+//! Sets the number of threads which build the shadow volumes of different lights.
+void CShadowVolumeSceneNode::setUpdateThreadCount(u32 threadCount)
+{
+	if (threadCount == 0)
+		threadCount = CThreadPool::getProcessorCount();
+	if (threadCount == UpdateThreadCount)
+		return;
+
+	UpdateThreadCount = threadCount;
+	if (UpdateThreads)
+		UpdateThreads->drop();
+	UpdateThreads = threadCount > 1 ? new CThreadPool(threadCount-1) : 0;
 }
 
 
@@ -327,7 +472,7 @@ void CShadowVolumeSceneNode::render()
 			frust.transform(invTrans);
 
 			core::vector3df edges[8];
-			ShadowBBox[i].getEdges(edges);
+			ShadowVolumes[i].BBox.getEdges(edges);
 
 			core::vector3df largestEdge = edges[0];
 			f32 maxDistance = core::vector3df(SceneManager->getActiveCamera()->getPosition() - edges[0]).getLength();
@@ -349,7 +494,7 @@ void CShadowVolumeSceneNode::render()
 		}
 
 		if(drawShadow)
-			driver->drawStencilShadowVolume(ShadowVolumes[i], UseZFailMethod, DebugDataVisible);
+			driver->drawStencilShadowVolume(ShadowVolumes[i].Triangles, UseZFailMethod, DebugDataVisible);
 		else
 		{
 			core::array<core::vector3df> triangles;
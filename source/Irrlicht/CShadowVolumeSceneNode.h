@@ -6,11 +6,13 @@
 #define __C_SHADOW_VOLUME_SCENE_NODE_H_INCLUDED__
 
 #include "IShadowVolumeSceneNode.h"
+#include "CThreadPool.h"
 
 namespace irr
 {
 namespace scene
 {
+	class IMeshBuffer;
 
 	//! Scene node for rendering a shadow volume into a stencil buffer.
 	class CShadowVolumeSceneNode : public IShadowVolumeSceneNode
@@ -33,6 +35,15 @@ namespace scene
 		/** Called each render cycle from Animated Mesh SceneNode render method. */
 		virtual void updateShadowVolumes() _IRR_OVERRIDE_;
 
+		//! Sets the number of threads which build the shadow volumes of different lights.
+		virtual void setUpdateThreadCount(u32 threadCount) _IRR_OVERRIDE_;
+
+		//! Returns the number of threads which build the shadow volumes.
+		virtual u32 getUpdateThreadCount() const _IRR_OVERRIDE_ { return UpdateThreadCount; }
+
+		//! Returns the number of shadow volumes which were rebuilt by the last update.
+		virtual u32 getRebuiltVolumeCount() const _IRR_OVERRIDE_ { return RebuiltVolumeCount; }
+
 		//! pre render method
 		virtual void OnRegisterSceneNode() _IRR_OVERRIDE_;
 
@@ -45,36 +56,79 @@ namespace scene
 		//! Returns type of the scene node
 		virtual ESCENE_NODE_TYPE getType() const _IRR_OVERRIDE_ { return ESNT_SHADOW_VOLUME; }
 
-	private:
+		//! Uses the transformation handling of ISceneNode
+		virtual bool hasPlainTransformation() const _IRR_OVERRIDE_ { return true; }
 
-		typedef core::array<core::vector3df> SShadowVolume;
+	private:
 
-		void createShadowVolume(const core::vector3df& pos, bool isDirectional=false);
-		u32 createEdgesAndCaps(const core::vector3df& light, SShadowVolume* svp, core::aabbox3d<f32>* bb);
+		//! A shadow volume for one light, kept until the light or the mesh changes
+		struct SShadowVolume
+		{
+			SShadowVolume() : Valid(false) {}
+
+			void swap(SShadowVolume& other)
+			{
+				Triangles.swap(other.Triangles);
+				FaceData.swap(other.FaceData);
+				core::swap(BBox, other.BBox);
+				core::swap(Light, other.Light);
+				core::swap(Valid, other.Valid);
+			}
+
+			core::array<core::vector3df> Triangles;
+			// tells if face is front facing
+			core::array<bool> FaceData;
+			// back cap bounding box
+			core::aabbox3d<f32> BBox;
+			// light position in object space
+			core::vector3df Light;
+			bool Valid;
+		};
+
+		//! Mesh buffer state the copied mesh data was taken from
+		struct SBufferState
+		{
+			const IMeshBuffer* Buffer;
+			u32 VertexCount;
+			u32 IndexCount;
+			u32 ChangedID_Vertex;
+			u32 ChangedID_Index;
+		};
+
+		//! Copies the shadow mesh if it changed since the last update
+		void updateMeshData();
+		void createShadowVolume(SShadowVolume& volume) const;
+		void classifyFaces(const core::vector3df& light, core::array<bool>& faceData) const;
 
 		//! Generates adjacency information based on mesh indices.
 		void calculateAdjacency();
 
+		//! Job building the volume of one light
+		static void createShadowVolumeJob(void* userData, u32 index);
+
 		core::aabbox3d<f32> Box;
 
-		// a shadow volume for every light
+		// a shadow volume for every light, the used ones first
 		core::array<SShadowVolume> ShadowVolumes;
-
-		// a back cap bounding box for every light
-		core::array<core::aabbox3d<f32> > ShadowBBox;
+		// volumes rebuilt in the current update
+		core::array<SShadowVolume*> RebuiltVolumes;
+		core::array<SBufferState> BufferStates;
 
 		core::array<core::vector3df> Vertices;
 		core::array<u16> Indices;
 		core::array<u16> Adjacency;
-		core::array<u16> Edges;
-		// tells if face is front facing
-		core::array<bool> FaceData;
+		// face normals in blocks of 4 faces, all x then all y then all z
+		core::array<f32> FaceNormals;
 
 		const scene::IMesh* ShadowMesh;
 
 		u32 IndexCount;
 		u32 VertexCount;
 		u32 ShadowVolumesUsed;
+		u32 RebuiltVolumeCount;
+
+		CThreadPool* UpdateThreads;
+		u32 UpdateThreadCount;
 
 		f32 Infinity;
 
@@ -1423,7 +1423,10 @@ void CSkinnedMesh::convertMeshToTangents()
 
 			const s32 idxCnt = LocalBuffers[b]->getIndexCount();
 
-			u16* idx = LocalBuffers[b]->getIndices();
+			// copied to work with both index types
+			core::array<u32> idx(idxCnt);
+			for (s32 i=0; i<idxCnt; ++i)
+				idx.push_back(LocalBuffers[b]->getIndex(i));
 			video::S3DVertexTangents* v =
 				(video::S3DVertexTangents*)LocalBuffers[b]->getVertices();
 
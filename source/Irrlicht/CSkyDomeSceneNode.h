@@ -27,6 +27,7 @@ class CSkyDomeSceneNode : public ISceneNode
 		virtual video::SMaterial& getMaterial(u32 i) _IRR_OVERRIDE_;
 		virtual u32 getMaterialCount() const _IRR_OVERRIDE_;
 		virtual ESCENE_NODE_TYPE getType() const _IRR_OVERRIDE_ { return ESNT_SKY_DOME; }
+		virtual bool hasPlainTransformation() const _IRR_OVERRIDE_ { return true; }
 
 		virtual void serializeAttributes(io::IAttributes* out, io::SAttributeReadWriteOptions* options) const _IRR_OVERRIDE_;
 		virtual void deserializeAttributes(io::IAttributes* in, io::SAttributeReadWriteOptions* options) _IRR_OVERRIDE_;
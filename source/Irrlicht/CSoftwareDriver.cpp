@@ -331,6 +331,8 @@ void CSoftwareDriver::drawVertexPrimitiveList(const void* vertices, u32 vertexCo
 				E_VERTEX_TYPE vType, scene::E_PRIMITIVE_TYPE pType, E_INDEX_TYPE iType)
 
 {
+	vertices = decodeQuantizedVertices(vertices, vertexCount, vType);
+
 	switch (iType)
 	{
 		case (EIT_16BIT):
@@ -382,6 +384,10 @@ void CSoftwareDriver::drawVertexPrimitiveList16(const void* vertices, u32 vertex
 									((S3DVertexTangents*)vertices)[indexList[i]].Color);
 						}
 						break;
+					case EVT_QUANTIZED:
+					case EVT_QUANTIZED_TANGENTS:
+						// decoded by drawVertexPrimitiveList
+						break;
 				}
 			}
 			return;
@@ -404,6 +410,10 @@ void CSoftwareDriver::drawVertexPrimitiveList16(const void* vertices, u32 vertex
 						((S3DVertexTangents*)vertices)[indexList[0]].Pos,
 						((S3DVertexTangents*)vertices)[indexList[primitiveCount-1]].Color);
 					break;
+				case EVT_QUANTIZED:
+				case EVT_QUANTIZED_TANGENTS:
+					// decoded by drawVertexPrimitiveList
+					break;
 			}
 			return;
 		case scene::EPT_LINES:
@@ -434,6 +444,10 @@ void CSoftwareDriver::drawVertexPrimitiveList16(const void* vertices, u32 vertex
 									((S3DVertexTangents*)vertices)[indexList[i]].Color);
 						}
 						break;
+					case EVT_QUANTIZED:
+					case EVT_QUANTIZED_TANGENTS:
+						// decoded by drawVertexPrimitiveList
+						break;
 				}
 			}
 			return;
@@ -468,6 +482,10 @@ void CSoftwareDriver::drawVertexPrimitiveList16(const void* vertices, u32 vertex
 		case EVT_TANGENTS:
 			drawClippedIndexedTriangleListT((S3DVertexTangents*)vertices, vertexCount, indexPointer, primitiveCount);
 			break;
+		case EVT_QUANTIZED:
+		case EVT_QUANTIZED_TANGENTS:
+			// decoded by drawVertexPrimitiveList
+			break;
 	}
 }
 
@@ -865,6 +865,8 @@ const SVSize CBurningVideoDriver::vSize[] =
 	{ VERTEX4D_FORMAT_TEXTURE_1 | VERTEX4D_FORMAT_COLOR_1, sizeof(S3DVertex), 1 },
 	{ VERTEX4D_FORMAT_TEXTURE_2 | VERTEX4D_FORMAT_COLOR_1, sizeof(S3DVertex2TCoords),2 },
 	{ VERTEX4D_FORMAT_TEXTURE_2 | VERTEX4D_FORMAT_COLOR_1 | VERTEX4D_FORMAT_BUMP_DOT3, sizeof(S3DVertexTangents),2 },
+	{ VERTEX4D_FORMAT_TEXTURE_1 | VERTEX4D_FORMAT_COLOR_1, sizeof(S3DVertexQuantized), 1 },
+	{ VERTEX4D_FORMAT_TEXTURE_2 | VERTEX4D_FORMAT_COLOR_1 | VERTEX4D_FORMAT_BUMP_DOT3, sizeof(S3DVertexQuantizedTangents),2 },
 	{ VERTEX4D_FORMAT_TEXTURE_2 | VERTEX4D_FORMAT_COLOR_1, sizeof(S3DVertex), 2 },	// reflection map
 	{ 0, sizeof(f32) * 3, 0 },	// core::vector3df*
 };
@@ -881,6 +883,20 @@ void CBurningVideoDriver::VertexCache_fill(const u32 sourceIndex, const u32 dest
 
 	source = (u8*) VertexCache.vertices + ( sourceIndex * vSize[VertexCache.vType].Pitch );
 
+	// quantized vertices are decoded first, everything else works on the floats
+	S3DVertexTangents decoded;
+	switch ( VertexCache.vType )
+	{
+		case EVT_QUANTIZED:
+			(S3DVertex&) decoded = ((const S3DVertexQuantized*) source)->get ( VertexQuantization );
+			source = (u8*) &decoded;
+			break;
+		case EVT_QUANTIZED_TANGENTS:
+			decoded = ((const S3DVertexQuantizedTangents*) source)->get ( VertexQuantization );
+			source = (u8*) &decoded;
+			break;
+	}
+
 	// it's a look ahead so we never hit it..
 	// but give priority...
 	//VertexCache.info[ destIndex ].hit = hitCount;
@@ -897,7 +913,7 @@ void CBurningVideoDriver::VertexCache_fill(const u32 sourceIndex, const u32 dest
 	Transformation [ ETS_CURRENT].transformVect ( &dest->Pos.x, base->Pos );
 
 	//mhm ;-) maybe no goto
-	if ( VertexCache.vType == 4 ) goto clipandproject;
+	if ( VertexCache.vType == VERTEXCACHE_SHADOW ) goto clipandproject;
 
 
 #if defined (SOFTWARE_DRIVER_2_LIGHTING) || defined ( SOFTWARE_DRIVER_2_TEXTURE_TRANSFORM )
@@ -1366,8 +1382,8 @@ void CBurningVideoDriver::VertexCache_reset ( const void* vertices, u32 vertexCo
 	VertexCache.indicesIndex = 0;
 	VertexCache.indicesRun = 0;
 
-	if ( Material.org.MaterialType == video::EMT_REFLECTION_2_LAYER )
-		VertexCache.vType = 3;
+	if ( Material.org.MaterialType == video::EMT_REFLECTION_2_LAYER && !isQuantizedVertexType ( vType ) )
+		VertexCache.vType = VERTEXCACHE_REFLECTION_2_LAYER;
 	else
 		VertexCache.vType = vType;
 	VertexCache.pType = pType;
@@ -2301,7 +2317,7 @@ void CBurningVideoDriver::drawStencilShadowVolume(const core::array<core::vector
 		shader->setParam ( 0, 0 );
 		shader->setParam ( 1, 1 );
 		shader->setParam ( 2, 0 );
-		drawVertexPrimitiveList (triangles.const_pointer(), count, 0, count/3, (video::E_VERTEX_TYPE) 4, scene::EPT_TRIANGLES, (video::E_INDEX_TYPE) 4 );
+		drawVertexPrimitiveList (triangles.const_pointer(), count, 0, count/3, (video::E_VERTEX_TYPE) VERTEXCACHE_SHADOW, scene::EPT_TRIANGLES, (video::E_INDEX_TYPE) 4 );
 		//glStencilOp(GL_KEEP, incr, GL_KEEP);
 		//glDrawArrays(GL_TRIANGLES,0,count);
 
@@ -2310,7 +2326,7 @@ void CBurningVideoDriver::drawStencilShadowVolume(const core::array<core::vector
 		shader->setParam ( 0, 0 );
 		shader->setParam ( 1, 2 );
 		shader->setParam ( 2, 0 );
-		drawVertexPrimitiveList (triangles.const_pointer(), count, 0, count/3, (video::E_VERTEX_TYPE) 4, scene::EPT_TRIANGLES, (video::E_INDEX_TYPE) 4 );
+		drawVertexPrimitiveList (triangles.const_pointer(), count, 0, count/3, (video::E_VERTEX_TYPE) VERTEXCACHE_SHADOW, scene::EPT_TRIANGLES, (video::E_INDEX_TYPE) 4 );
 		//glStencilOp(GL_KEEP, decr, GL_KEEP);
 		//glDrawArrays(GL_TRIANGLES,0,count);
 	}
@@ -0,0 +1,225 @@
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#include "CTerrainIndexTemplates.h"
+#include "irrMath.h"
+
+namespace irr
+{
+namespace scene
+{
+
+//! constructor
+CTerrainIndexTemplates::CTerrainIndexTemplates()
+	: PatchSize(1), RowSize(2), LODCount(0)
+{
+}
+
+
+//! Creates the templates. The inner quads are triangulated the same for
+//! all LODs, a patch of only one quad has no border strips.
+void CTerrainIndexTemplates::create(s32 patchSize, s32 rowSize, s32 lodCount)
+{
+	PatchSize = core::max_(patchSize, 1);
+	RowSize = rowSize;
+	LODCount = core::clamp(lodCount, 1, 64);
+
+	Indices.clear();
+	Ranges.clear();
+	Ranges.reallocate(LODCount + LODCount * ES_COUNT * LODCount);
+	SRange range;
+
+	for (s32 lod = 0; lod < LODCount; ++lod)
+	{
+		const s32 step = getLODStep(lod);
+		const s32 border = (step < PatchSize) ? step : 0;
+
+		range.First = Indices.size();
+		for (s32 z = border; z < PatchSize - border; z += step)
+		{
+			for (s32 x = border; x < PatchSize - border; x += step)
+			{
+				addTriangle(x, z + step, x, z, x + step, z + step);
+				addTriangle(x + step, z + step, x, z, x + step, z);
+			}
+		}
+		range.Count = Indices.size() - range.First;
+		Ranges.push_back(range);
+	}
+
+	for (s32 lod = 0; lod < LODCount; ++lod)
+	{
+		const s32 step = getLODStep(lod);
+		for (s32 side = 0; side < ES_COUNT; ++side)
+		{
+			for (s32 neighbourLOD = 0; neighbourLOD < LODCount; ++neighbourLOD)
+			{
+				range.First = Indices.size();
+				if (neighbourLOD >= lod && step < PatchSize)
+					addBorder(side, step, getLODStep(neighbourLOD));
+				range.Count = Indices.size() - range.First;
+				Ranges.push_back(range);
+			}
+		}
+	}
+}
+
+
+//! Returns the distance between the vertices of a LOD
+s32 CTerrainIndexTemplates::getLODStep(s32 LOD) const
+{
+	s32 step = 1;
+	for (s32 i = 0; i < LOD && step < PatchSize; ++i)
+		step <<= 1;
+	return core::min_(step, PatchSize);
+}
+
+
+//! Returns the key of the templates used for a patch, as the LOD of the
+//! patch and the LODs of the border strips, 6 bits each.
+u32 CTerrainIndexTemplates::getKey(s32 LOD, const s32* neighbourLODs) const
+{
+	LOD = core::clamp(LOD, 0, LODCount - 1);
+
+	u32 key = LOD;
+	for (s32 side = 0; side < ES_COUNT; ++side)
+	{
+		const s32 borderLOD = core::clamp(neighbourLODs[side], LOD, LODCount - 1);
+		key |= borderLOD << (6 * (side + 1));
+	}
+	return key;
+}
+
+
+//! Returns the key of a patch whose neighbours have the same LOD
+u32 CTerrainIndexTemplates::getKey(s32 LOD) const
+{
+	const s32 neighbourLODs[ES_COUNT] = { LOD, LOD, LOD, LOD };
+	return getKey(LOD, neighbourLODs);
+}
+
+
+//! Returns the number of indices of a patch
+u32 CTerrainIndexTemplates::getIndexCount(u32 key) const
+{
+	const s32 LOD = key & 63;
+
+	u32 count = Ranges[LOD].Count;
+	for (s32 side = 0; side < ES_COUNT; ++side)
+		count += getBorder(LOD, side, (key >> (6 * (side + 1))) & 63).Count;
+	return count;
+}
+
+
+//! Writes the indices of a patch, by adding the first vertex of the patch
+//! to the templates. Drivers have no base vertex, so this can't be a plain copy.
+u32 CTerrainIndexTemplates::getIndices(u32 key, u32 firstVertex,
+		video::E_INDEX_TYPE type, void* target) const
+{
+	const s32 LOD = key & 63;
+
+	u32 count = 0;
+	for (s32 part = 0; part <= ES_COUNT; ++part)
+	{
+		const SRange& range = (part == 0) ? Ranges[LOD] :
+			getBorder(LOD, part - 1, (key >> (6 * part)) & 63);
+		const u32* source = Indices.const_pointer() + range.First;
+
+		if (type == video::EIT_32BIT)
+		{
+			u32* indices = (u32*)target + count;
+			for (u32 i = 0; i < range.Count; ++i)
+				indices[i] = source[i] + firstVertex;
+		}
+		else
+		{
+			u16* indices = (u16*)target + count;
+			for (u32 i = 0; i < range.Count; ++i)
+				indices[i] = (u16)(source[i] + firstVertex);
+		}
+		count += range.Count;
+	}
+	return count;
+}
+
+
+//! Adds a triangle of patch vertex coordinates, with the same winding as
+//! all other triangles of the terrain.
+void CTerrainIndexTemplates::addTriangle(s32 x0, s32 z0, s32 x1, s32 z1, s32 x2, s32 z2)
+{
+	if ((x1 - x0) * (z2 - z0) - (z1 - z0) * (x2 - x0) < 0)
+	{
+		core::swap(x1, x2);
+		core::swap(z1, z2);
+	}
+
+	Indices.push_back(z0 * RowSize + x0);
+	Indices.push_back(z1 * RowSize + x1);
+	Indices.push_back(z2 * RowSize + x2);
+}
+
+
+//! Adds the triangles between the vertices of a border, which are
+//! borderStep apart, and the vertices one step inside the patch.
+void CTerrainIndexTemplates::addBorder(s32 side, s32 step, s32 borderStep)
+{
+	// positions along the border and the inner line
+	s32 border = 0;
+	s32 inner = step;
+
+	while (border < PatchSize || inner < PatchSize - step)
+	{
+		// three vertices as position along the side and distance from the border
+		s32 along[3];
+		s32 depth[3];
+		along[0] = border;
+		depth[0] = 0;
+
+		// advance on the inner line as long as it is not ahead of the border
+		if (inner < PatchSize - step && (border >= PatchSize || inner + step <= border + borderStep))
+		{
+			along[1] = inner;
+			depth[1] = step;
+			along[2] = inner + step;
+			depth[2] = step;
+			inner += step;
+		}
+		else
+		{
+			along[1] = border + borderStep;
+			depth[1] = 0;
+			along[2] = inner;
+			depth[2] = step;
+			border += borderStep;
+		}
+
+		s32 x[3];
+		s32 z[3];
+		for (s32 i = 0; i < 3; ++i)
+		{
+			switch (side)
+			{
+			case ES_TOP:
+				x[i] = along[i];
+				z[i] = depth[i];
+				break;
+			case ES_BOTTOM:
+				x[i] = along[i];
+				z[i] = PatchSize - depth[i];
+				break;
+			case ES_LEFT:
+				x[i] = depth[i];
+				z[i] = along[i];
+				break;
+			default:
+				x[i] = PatchSize - depth[i];
+				z[i] = along[i];
+				break;
+			}
+		}
+		addTriangle(x[0], z[0], x[1], z[1], x[2], z[2]);
+	}
+}
+
+} // end namespace scene
+} // end namespace irr
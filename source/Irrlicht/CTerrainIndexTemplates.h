@@ -0,0 +1,101 @@
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#ifndef __C_TERRAIN_INDEX_TEMPLATES_H_INCLUDED__
+#define __C_TERRAIN_INDEX_TEMPLATES_H_INCLUDED__
+
+#include "irrArray.h"
+#include "SVertexIndex.h"
+
+namespace irr
+{
+namespace scene
+{
+
+	//! Indices of square terrain patches at all LODs, relative to the first vertex of a patch.
+	/** For each LOD there is a part with the inner quads of a patch, and for
+	each LOD, side and coarser or equal neighbour LOD a border strip. The
+	border strips connect the vertices one step inside the patch with the
+	vertices shared by the neighbour, so patches of different LODs have
+	neither cracks nor degenerated triangles. The parts used by a patch are
+	described by a key, see getKey(). */
+	class CTerrainIndexTemplates
+	{
+	public:
+
+		//! Sides of a patch, top is the row of the first vertex
+		enum E_SIDE
+		{
+			ES_TOP = 0,
+			ES_BOTTOM,
+			ES_LEFT,
+			ES_RIGHT,
+			ES_COUNT
+		};
+
+		//! constructor
+		CTerrainIndexTemplates();
+
+		//! Creates the templates
+		/** \param patchSize Number of quads along a side of a patch, a power of two.
+		\param rowSize Number of vertices in a row of the vertex buffer.
+		\param lodCount Number of LODs. */
+		void create(s32 patchSize, s32 rowSize, s32 lodCount);
+
+		//! Returns the distance between the vertices of a LOD, at most a whole patch
+		s32 getLODStep(s32 LOD) const;
+
+		//! Returns the number of LODs
+		s32 getLODCount() const { return LODCount; }
+
+		//! Returns the key of the templates used for a patch
+		/** \param LOD LOD of the patch.
+		\param neighbourLODs LODs of the neighbours at each E_SIDE, -1 if there is none.
+		The border is stitched to coarser neighbours. */
+		u32 getKey(s32 LOD, const s32* neighbourLODs) const;
+
+		//! Returns the key of a patch whose neighbours have the same LOD
+		u32 getKey(s32 LOD) const;
+
+		//! Returns the number of indices of a patch
+		u32 getIndexCount(u32 key) const;
+
+		//! Writes the indices of a patch into a 16 or 32 bit index array
+		/** \param key Key of the patch.
+		\param firstVertex Vertex of the patch in the first row and column.
+		\param type Type of the index array.
+		\param target Index array, with at least getIndexCount(key) elements.
+		\return Number of indices written. */
+		u32 getIndices(u32 key, u32 firstVertex, video::E_INDEX_TYPE type, void* target) const;
+
+	private:
+
+		struct SRange
+		{
+			u32 First;
+			u32 Count;
+		};
+
+		//! Returns the range of the border strip of a side
+		const SRange& getBorder(s32 LOD, s32 side, s32 neighbourLOD) const
+		{
+			return Ranges[LODCount + (LOD * ES_COUNT + side) * LODCount + neighbourLOD];
+		}
+
+		//! Adds a triangle of patch vertex coordinates
+		void addTriangle(s32 x0, s32 z0, s32 x1, s32 z1, s32 x2, s32 z2);
+
+		//! Adds the border strip of a side
+		void addBorder(s32 side, s32 step, s32 borderStep);
+
+		core::array<u32> Indices;
+		core::array<SRange> Ranges;
+		s32 PatchSize;
+		s32 RowSize;
+		s32 LODCount;
+	};
+
+} // end namespace scene
+} // end namespace irr
+
+#endif
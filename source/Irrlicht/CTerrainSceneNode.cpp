@@ -36,7 +36,8 @@ namespace scene
 			const core::vector3df& scale)
 	: ITerrainSceneNode(parent, mgr, id, position, rotation, scale),
 	TerrainData(patchSize, maxLOD, position, rotation, scale), RenderBuffer(0),
-	VerticesToRender(0), IndicesToRender(0), DynamicSelectorUpdate(false),
+	CompactStorage(false), HeightMin(0.f), HeightStep(0.f), SlotCount(0),
+	MaxScreenSpaceError(2.f), VerticesToRender(0), IndicesToRender(0), DynamicSelectorUpdate(false),
 	OverrideDistanceThreshold(false), UseDefaultRotationPivot(true), ForceRecalculation(true),
 	CameraMovementDelta(10.0f), CameraRotationDelta(1.0f),CameraFOVDelta(0.1f),
 	TCoordScale1(1.0f), TCoordScale2(1.0f), SmoothFactor(0), FileSystem(fs)
@@ -82,6 +83,8 @@ namespace scene
 
 		Mesh->MeshBuffers.clear();
 		const u32 startTime = os::Timer::getRealTime();
+		CompactStorage = SceneManager->getParameters()->getAttributeAsBool(TERRAIN_COMPACT_STORAGE);
+		RenderBuffer->setHardwareMappingHint(CompactStorage ? scene::EHM_DYNAMIC : scene::EHM_STATIC, scene::EBT_VERTEX);
 		video::IImage* heightMap = SceneManager->getVideoDriver()->createImageFromFile(file);
 
 		if (!heightMap)
@@ -184,20 +187,29 @@ namespace scene
 
 		smoothTerrain(mb, smoothFactor);
 
-		// calculate smooth normals for the vertices
-		calculateNormals(mb);
+		if (CompactStorage)
+		{
+			createCompactHeights(mb);
+		}
+		else
+		{
+			Heights.clear();
 
-		// add the MeshBuffer to the mesh
-		Mesh->addMeshBuffer(mb);
+			// calculate smooth normals for the vertices
+			calculateNormals(mb);
 
-		// We copy the data to the renderBuffer, after the normals have been calculated.
-		RenderBuffer->getVertexBuffer().set_used(numVertices);
+			// add the MeshBuffer to the mesh
+			Mesh->addMeshBuffer(mb);
 
-		for (u32 i = 0; i < numVertices; ++i)
-		{
-			RenderBuffer->getVertexBuffer()[i] = mb->getVertexBuffer()[i];
-			RenderBuffer->getVertexBuffer()[i].Pos *= TerrainData.Scale;
-			RenderBuffer->getVertexBuffer()[i].Pos += TerrainData.Position;
+			// We copy the data to the renderBuffer, after the normals have been calculated.
+			RenderBuffer->getVertexBuffer().set_used(numVertices);
+
+			for (u32 i = 0; i < numVertices; ++i)
+			{
+				RenderBuffer->getVertexBuffer()[i] = mb->getVertexBuffer()[i];
+				RenderBuffer->getVertexBuffer()[i].Pos *= TerrainData.Scale;
+				RenderBuffer->getVertexBuffer()[i].Pos += TerrainData.Position;
+			}
 		}
 
 		// We no longer need the mb
@@ -206,6 +218,10 @@ namespace scene
 		// calculate all the necessary data for the patches and the terrain
 		calculateDistanceThresholds();
 		createPatches();
+		IndexTemplates.create(TerrainData.CalcPatchSize, TerrainData.Size, TerrainData.MaxLOD);
+		if (CompactStorage)
+			PatchTemplates.create(TerrainData.CalcPatchSize, TerrainData.PatchSize, TerrainData.MaxLOD);
+		calculatePatchErrors();
 		calculatePatchData();
 
 		// set the default rotation pivot point to the terrain nodes center
@@ -216,11 +232,12 @@ namespace scene
 		// so we know what the current center of the terrain is.
 		setRotation(TerrainData.Rotation);
 
-		// Pre-allocate memory for indices
-
-		RenderBuffer->getIndexBuffer().set_used(
-				TerrainData.PatchCount * TerrainData.PatchCount *
-				TerrainData.CalcPatchSize * TerrainData.CalcPatchSize * 6);
+		// Pre-allocate memory for indices, with compact storage they grow
+		// with the visible patches
+		if (!CompactStorage)
+			RenderBuffer->getIndexBuffer().set_used(
+					TerrainData.PatchCount * TerrainData.PatchCount *
+					TerrainData.CalcPatchSize * TerrainData.CalcPatchSize * 6);
 
 		RenderBuffer->setDirty();
 
@@ -249,6 +266,8 @@ namespace scene
 		const u32 startTime = os::Timer::getTime();
 
 		Mesh->MeshBuffers.clear();
+		CompactStorage = SceneManager->getParameters()->getAttributeAsBool(TERRAIN_COMPACT_STORAGE);
+		RenderBuffer->setHardwareMappingHint(CompactStorage ? scene::EHM_DYNAMIC : scene::EHM_STATIC, scene::EBT_VERTEX);
 
 		const size_t bytesPerPixel = (size_t)bitsPerPixel / 8;
 
@@ -422,21 +441,30 @@ namespace scene
 
 		smoothTerrain(mb, smoothFactor);
 
-		// calculate smooth normals for the vertices
-		calculateNormals(mb);
+		if (CompactStorage)
+		{
+			createCompactHeights(mb);
+		}
+		else
+		{
+			Heights.clear();
 
-		// add the MeshBuffer to the mesh
-		Mesh->addMeshBuffer(mb);
-		const u32 vertexCount = mb->getVertexCount();
+			// calculate smooth normals for the vertices
+			calculateNormals(mb);
 
-		// We copy the data to the renderBuffer, after the normals have been calculated.
-		RenderBuffer->getVertexBuffer().set_used(vertexCount);
+			// add the MeshBuffer to the mesh
+			Mesh->addMeshBuffer(mb);
+			const u32 vertexCount = mb->getVertexCount();
 
-		for (u32 i = 0; i < vertexCount; i++)
-		{
-			RenderBuffer->getVertexBuffer()[i] = mb->getVertexBuffer()[i];
-			RenderBuffer->getVertexBuffer()[i].Pos *= TerrainData.Scale;
-			RenderBuffer->getVertexBuffer()[i].Pos += TerrainData.Position;
+			// We copy the data to the renderBuffer, after the normals have been calculated.
+			RenderBuffer->getVertexBuffer().set_used(vertexCount);
+
+			for (u32 i = 0; i < vertexCount; i++)
+			{
+				RenderBuffer->getVertexBuffer()[i] = mb->getVertexBuffer()[i];
+				RenderBuffer->getVertexBuffer()[i].Pos *= TerrainData.Scale;
+				RenderBuffer->getVertexBuffer()[i].Pos += TerrainData.Position;
+			}
 		}
 
 		// We no longer need the mb
@@ -445,6 +473,10 @@ namespace scene
 		// calculate all the necessary data for the patches and the terrain
 		calculateDistanceThresholds();
 		createPatches();
+		IndexTemplates.create(TerrainData.CalcPatchSize, TerrainData.Size, TerrainData.MaxLOD);
+		if (CompactStorage)
+			PatchTemplates.create(TerrainData.CalcPatchSize, TerrainData.PatchSize, TerrainData.MaxLOD);
+		calculatePatchErrors();
 		calculatePatchData();
 
 		// set the default rotation pivot point to the terrain nodes center
@@ -455,10 +487,12 @@ namespace scene
 		// terrain is.
 		setRotation(TerrainData.Rotation);
 
-		// Pre-allocate memory for indices
-		RenderBuffer->getIndexBuffer().set_used(
-				TerrainData.PatchCount*TerrainData.PatchCount*
-				TerrainData.CalcPatchSize*TerrainData.CalcPatchSize*6);
+		// Pre-allocate memory for indices, with compact storage they grow
+		// with the visible patches
+		if (!CompactStorage)
+			RenderBuffer->getIndexBuffer().set_used(
+					TerrainData.PatchCount*TerrainData.PatchCount*
+					TerrainData.CalcPatchSize*TerrainData.CalcPatchSize*6);
 
 		const u32 endTime = os::Timer::getTime();
 
@@ -495,7 +529,8 @@ namespace scene
 	{
 		TerrainData.Scale = scale;
 		applyTransformation();
-		calculateNormals(RenderBuffer);
+		if (!CompactStorage)
+			calculateNormals(RenderBuffer);
 		ForceRecalculation = true;
 	}
 
@@ -540,14 +575,24 @@ namespace scene
 		core::matrix4 rotMatrix;
 		rotMatrix.setRotationDegrees(TerrainData.Rotation);
 
-		const s32 vtxCount = Mesh->getMeshBuffer(0)->getVertexCount();
-		for (s32 i = 0; i < vtxCount; ++i)
+		if (CompactStorage)
+		{
+			// vertices are transformed when they are rebuilt
+			CompactRotation = rotMatrix;
+			CompactPivot = TerrainData.RotationPivot;
+			invalidateCompactVertices();
+		}
+		else
 		{
-			RenderBuffer->getVertexBuffer()[i].Pos = Mesh->getMeshBuffer(0)->getPosition(i) * TerrainData.Scale + TerrainData.Position;
+			const s32 vtxCount = Mesh->getMeshBuffer(0)->getVertexCount();
+			for (s32 i = 0; i < vtxCount; ++i)
+			{
+				RenderBuffer->getVertexBuffer()[i].Pos = Mesh->getMeshBuffer(0)->getPosition(i) * TerrainData.Scale + TerrainData.Position;
 
-			RenderBuffer->getVertexBuffer()[i].Pos -= TerrainData.RotationPivot;
-			rotMatrix.inverseRotateVect(RenderBuffer->getVertexBuffer()[i].Pos);
-			RenderBuffer->getVertexBuffer()[i].Pos += TerrainData.RotationPivot;
+				RenderBuffer->getVertexBuffer()[i].Pos -= TerrainData.RotationPivot;
+				rotMatrix.inverseRotateVect(RenderBuffer->getVertexBuffer()[i].Pos);
+				RenderBuffer->getVertexBuffer()[i].Pos += TerrainData.RotationPivot;
+			}
 		}
 
 		calculateDistanceThresholds(true);
@@ -631,28 +676,85 @@ namespace scene
 
 		const SViewFrustum* frustum = camera->getViewFrustum();
 
-		// Determine each patches LOD based on distance from camera (and whether or not they are in
-		// the view frustum).
-		const s32 count = TerrainData.PatchCount * TerrainData.PatchCount;
-		for (s32 j = 0; j < count; ++j)
+		// pixels covered by one unit in a distance of one unit
+		const f32 projection = SceneManager->getVideoDriver()->getViewPort().getHeight() /
+			(2.f * tanf(camera->getFOV() * 0.5f));
+
+		// Determine each patches LOD based on its error on the screen or on the distance from
+		// the camera, and whether or not it is in the view frustum. Whole parts of the patch
+		// tree outside of the frustum are skipped.
+		if (!PatchTree.empty())
+			selectPatchLODs(0, *frustum, cameraPosition, projection, (1 << SViewFrustum::VF_PLANE_COUNT) - 1);
+	}
+
+
+	//! Tests a node of the patch tree against the frustum planes which cut its
+	//! parent, and selects the LODs of the patches of visible leaves.
+	void CTerrainSceneNode::selectPatchLODs(s32 node, const SViewFrustum& frustum,
+			const core::vector3df& cameraPosition, f32 projection, u32 planeMask)
+	{
+		const SPatchTreeNode& treeNode = PatchTree[node];
+
+		for (u32 i = 0; i < SViewFrustum::VF_PLANE_COUNT; ++i)
 		{
-			if (frustum->getBoundingBox().intersectsWithBox(TerrainData.Patches[j].BoundingBox))
+			if (!(planeMask & (1 << i)))
+				continue;
+
+			const core::EIntersectionRelation3D relation = treeNode.BoundingBox.classifyPlaneRelation(frustum.planes[i]);
+			if (relation == core::ISREL3D_FRONT)
 			{
-				const f32 distance = cameraPosition.getDistanceFromSQ(TerrainData.Patches[j].Center);
+				for (s32 x = treeNode.X0; x < treeNode.X1; ++x)
+					for (s32 z = treeNode.Z0; z < treeNode.Z1; ++z)
+						TerrainData.Patches[x * TerrainData.PatchCount + z].CurrentLOD = -1;
+				return;
+			}
+			// the children are completely behind this plane as well
+			if (relation == core::ISREL3D_BACK)
+				planeMask &= ~(1 << i);
+		}
 
-				TerrainData.Patches[j].CurrentLOD = 0;
-				for (s32 i = TerrainData.MaxLOD - 1; i>0; --i)
+		if (treeNode.ChildCount)
+		{
+			for (s32 c = 0; c < treeNode.ChildCount; ++c)
+				selectPatchLODs(treeNode.FirstChild + c, frustum, cameraPosition, projection, planeMask);
+			return;
+		}
+
+		const s32 index = treeNode.X0 * TerrainData.PatchCount + treeNode.Z0;
+		SPatch& patch = TerrainData.Patches[index];
+		patch.CurrentLOD = 0;
+
+		if (MaxScreenSpaceError > 0.f)
+		{
+			// the nearest point of the patch has the largest error on the screen
+			const core::aabbox3df& box = patch.BoundingBox;
+			const core::vector3df nearest(
+				core::clamp(cameraPosition.X, box.MinEdge.X, box.MaxEdge.X),
+				core::clamp(cameraPosition.Y, box.MinEdge.Y, box.MaxEdge.Y),
+				core::clamp(cameraPosition.Z, box.MinEdge.Z, box.MaxEdge.Z));
+			const f32 maxError = MaxScreenSpaceError * cameraPosition.getDistanceFrom(nearest) /
+				(projection * fabsf(TerrainData.Scale.Y));
+
+			const f32* errors = PatchErrors.const_pointer() + index * TerrainData.MaxLOD;
+			for (s32 i = TerrainData.MaxLOD - 1; i > 0; --i)
+			{
+				if (errors[i] <= maxError)
 				{
-					if (distance >= TerrainData.LODDistanceThreshold[i])
-					{
-						TerrainData.Patches[j].CurrentLOD = i;
-						break;
-					}
+					patch.CurrentLOD = i;
+					break;
 				}
 			}
-			else
+		}
+		else
+		{
+			const f32 distance = cameraPosition.getDistanceFromSQ(patch.Center);
+			for (s32 i = TerrainData.MaxLOD - 1; i > 0; --i)
 			{
-				TerrainData.Patches[j].CurrentLOD = -1;
+				if (distance >= TerrainData.LODDistanceThreshold[i])
+				{
+					patch.CurrentLOD = i;
+					break;
+				}
 			}
 		}
 	}
@@ -661,54 +763,58 @@ namespace scene
 	void CTerrainSceneNode::preRenderIndicesCalculations()
 	{
 		scene::IIndexBuffer& indexBuffer = RenderBuffer->getIndexBuffer();
-		IndicesToRender = 0;
-		indexBuffer.set_used(0);
+		const s32 count = TerrainData.PatchCount * TerrainData.PatchCount;
+		const u32 indexSize = (indexBuffer.getType() == video::EIT_32BIT) ? sizeof(u32) : sizeof(u16);
+		u32 indexCount = 0;
+		bool changed = false;
 
-		s32 index = 0;
-		// Then generate the indices for all patches that are visible.
-		for (s32 i = 0; i < TerrainData.PatchCount; ++i)
+		if (CompactStorage)
+			updateCompactVertices();
+
+		DrawnPatchCounts.set_used(TerrainData.MaxLOD);
+		for (s32 i = 0; i < TerrainData.MaxLOD; ++i)
+			DrawnPatchCounts[i] = 0;
+
+		// Generate the indices for all patches that are visible. A patch keeps
+		// its indices as long as the templates and the position don't change.
+		for (s32 index = 0; index < count; ++index)
 		{
-			for (s32 j = 0; j < TerrainData.PatchCount; ++j)
+			SPatch& patch = TerrainData.Patches[index];
+			if (patch.CurrentLOD < 0)
 			{
-				if (TerrainData.Patches[index].CurrentLOD >= 0)
-				{
-					s32 x = 0;
-					s32 z = 0;
+				patch.IndexKey = 0xffffffff;
+				continue;
+			}
+			++DrawnPatchCounts[core::min_(patch.CurrentLOD, TerrainData.MaxLOD - 1)];
 
-					// calculate the step we take this patch, based on the patches current LOD
-					const s32 step = 1 << TerrainData.Patches[index].CurrentLOD;
+			const u32 key = getPatchKey(index, patch.CurrentLOD, true);
+			if (key != patch.IndexKey || patch.FirstIndex != indexCount)
+			{
+				patch.IndexKey = key;
+				patch.FirstIndex = indexCount;
+				patch.IndexCount = IndexTemplates.getIndexCount(key);
 
-					// Loop through patch and generate indices
-					while (z < TerrainData.CalcPatchSize)
-					{
-						const s32 index11 = getIndex(j, i, index, x, z);
-						const s32 index21 = getIndex(j, i, index, x + step, z);
-						const s32 index12 = getIndex(j, i, index, x, z + step);
-						const s32 index22 = getIndex(j, i, index, x + step, z + step);
-
-						indexBuffer.push_back(index12);
-						indexBuffer.push_back(index11);
-						indexBuffer.push_back(index22);
-						indexBuffer.push_back(index22);
-						indexBuffer.push_back(index11);
-						indexBuffer.push_back(index21);
-						IndicesToRender+=6;
-
-						// increment index position horizontally
-						x += step;
-
-						// we've hit an edge
-						if (x >= TerrainData.CalcPatchSize)
-						{
-							x = 0;
-							z += step;
-						}
-					}
-				}
-				++index;
+				if (indexBuffer.size() < indexCount + patch.IndexCount)
+					indexBuffer.set_used(indexCount + patch.IndexCount);
+
+				void* target = (u8*)indexBuffer.pointer() + indexCount * indexSize;
+				if (CompactStorage)
+					PatchTemplates.getIndices(key, patch.VertexSlot * TerrainData.PatchSize * TerrainData.PatchSize,
+						indexBuffer.getType(), target);
+				else
+					getPatchIndices(key, index, indexBuffer.getType(), target);
+				changed = true;
 			}
+			indexCount += patch.IndexCount;
 		}
 
+		if (indexCount != IndicesToRender)
+			changed = true;
+		IndicesToRender = indexCount;
+
+		if (!changed)
+			return;
+
 		RenderBuffer->setDirty(EBT_INDEX);
 
 		if (DynamicSelectorUpdate && TriangleSelector)
@@ -809,54 +915,48 @@ namespace scene
 
 		LOD = core::clamp(LOD, 0, TerrainData.MaxLOD - 1);
 
-		const u32 numVertices = Mesh->getMeshBuffer(0)->getVertexCount();
-		mb.getVertexBuffer().reallocate(numVertices);
-		video::S3DVertex2TCoords* vertices = (video::S3DVertex2TCoords*)Mesh->getMeshBuffer(0)->getVertices();
-
-		for (u32 n=0; n<numVertices; ++n)
-			mb.getVertexBuffer().push_back(vertices[n]);
-
-		mb.getIndexBuffer().setType(RenderBuffer->getIndexBuffer().getType());
-
-		// calculate the step we take for all patches, since LOD is the same
-		const s32 step = 1 << LOD;
-
-		// Generate the indices for all patches at the specified LOD
-		s32 index = 0;
-		for (s32 i=0; i<TerrainData.PatchCount; ++i)
+		if (CompactStorage)
 		{
-			for (s32 j=0; j<TerrainData.PatchCount; ++j)
+			mb.getVertexBuffer().reallocate(TerrainData.Size * TerrainData.Size);
+			video::S3DVertex2TCoords vertex;
+			for (s32 x=0; x<TerrainData.Size; ++x)
 			{
-				s32 x = 0;
-				s32 z = 0;
-
-				// Loop through patch and generate indices
-				while (z < TerrainData.CalcPatchSize)
+				for (s32 z=0; z<TerrainData.Size; ++z)
 				{
-					const s32 index11 = getIndex(j, i, index, x, z);
-					const s32 index21 = getIndex(j, i, index, x + step, z);
-					const s32 index12 = getIndex(j, i, index, x, z + step);
-					const s32 index22 = getIndex(j, i, index, x + step, z + step);
-
-					mb.getIndexBuffer().push_back(index12);
-					mb.getIndexBuffer().push_back(index11);
-					mb.getIndexBuffer().push_back(index22);
-					mb.getIndexBuffer().push_back(index22);
-					mb.getIndexBuffer().push_back(index11);
-					mb.getIndexBuffer().push_back(index21);
-
-					// increment index position horizontally
-					x += step;
-
-					if (x >= TerrainData.CalcPatchSize) // we've hit an edge
-					{
-						x = 0;
-						z += step;
-					}
+					getCompactVertex(x, z, false, vertex);
+					mb.getVertexBuffer().push_back(vertex);
 				}
-				++index;
 			}
 		}
+		else
+		{
+			const u32 numVertices = Mesh->getMeshBuffer(0)->getVertexCount();
+			mb.getVertexBuffer().reallocate(numVertices);
+			video::S3DVertex2TCoords* vertices = (video::S3DVertex2TCoords*)Mesh->getMeshBuffer(0)->getVertices();
+
+			for (u32 n=0; n<numVertices; ++n)
+				mb.getVertexBuffer().push_back(vertices[n]);
+		}
+
+		scene::IIndexBuffer& indexBuffer = mb.getIndexBuffer();
+		indexBuffer.setType(RenderBuffer->getIndexBuffer().getType());
+
+		// Generate the indices for all patches at the specified LOD, since
+		// the LOD is the same no borders need to be stitched
+		const s32 count = TerrainData.PatchCount * TerrainData.PatchCount;
+		const u32 key = getPatchKey(0, LOD, false);
+		const u32 patchIndexCount = IndexTemplates.getIndexCount(key);
+		u32 indexCount = indexBuffer.size();
+		indexBuffer.set_used(indexCount + count * patchIndexCount);
+
+		for (s32 index=0; index<count; ++index)
+		{
+			if (indexBuffer.getType() == video::EIT_32BIT)
+				getPatchIndices(key, index, video::EIT_32BIT, (u32*)indexBuffer.pointer() + indexCount);
+			else
+				getPatchIndices(key, index, video::EIT_16BIT, (u16*)indexBuffer.pointer() + indexCount);
+			indexCount += patchIndexCount;
+		}
 	}
 
 
@@ -877,65 +977,22 @@ namespace scene
 		if (LOD < -1 || LOD > TerrainData.MaxLOD - 1)
 			return -1;
 
-		core::array<s32> cLODs;
-		bool setLODs = false;
+		const s32 index = patchX * TerrainData.PatchCount + patchZ;
 
 		// If LOD of -1 was passed in, use the CurrentLOD of the patch specified
-		if (LOD == -1)
-		{
-			LOD = TerrainData.Patches[patchX * TerrainData.PatchCount + patchZ].CurrentLOD;
-		}
-		else
-		{
-			getCurrentLODOfPatches(cLODs);
-			setCurrentLODOfPatches(LOD);
-			setLODs = true;
-		}
+		// and stitch it to its neighbours. Otherwise all patches are treated as
+		// having the same LOD.
+		const bool stitch = (LOD == -1);
+		if (stitch)
+			LOD = TerrainData.Patches[index].CurrentLOD;
 
 		if (LOD < 0)
 			return -2; // Patch not visible, don't generate indices.
 
-		// calculate the step we take for this LOD
-		const s32 step = 1 << LOD;
-
-		// Generate the indices for the specified patch at the specified LOD
-		const s32 index = patchX * TerrainData.PatchCount + patchZ;
-
-		s32 x = 0;
-		s32 z = 0;
+		const u32 key = getPatchKey(index, LOD, stitch);
+		indices.set_used(IndexTemplates.getIndexCount(key));
 
-		indices.set_used(TerrainData.PatchSize * TerrainData.PatchSize * 6);
-
-		// Loop through patch and generate indices
-		s32 rv=0;
-		while (z<TerrainData.CalcPatchSize)
-		{
-			const s32 index11 = getIndex(patchZ, patchX, index, x, z);
-			const s32 index21 = getIndex(patchZ, patchX, index, x + step, z);
-			const s32 index12 = getIndex(patchZ, patchX, index, x, z + step);
-			const s32 index22 = getIndex(patchZ, patchX, index, x + step, z + step);
-
-			indices[rv++] = index12;
-			indices[rv++] = index11;
-			indices[rv++] = index22;
-			indices[rv++] = index22;
-			indices[rv++] = index11;
-			indices[rv++] = index21;
-
-			// increment index position horizontally
-			x += step;
-
-			if (x >= TerrainData.CalcPatchSize) // we've hit an edge
-			{
-				x = 0;
-				z += step;
-			}
-		}
-
-		if (setLODs)
-			setCurrentLODOfPatches(cLODs);
-
-		return rv;
+		return getPatchIndices(key, index, video::EIT_32BIT, indices.pointer());
 	}
 
 
@@ -970,6 +1027,7 @@ namespace scene
 	bool CTerrainSceneNode::overrideLODDistance(s32 LOD, f64 newDistance)
 	{
 		OverrideDistanceThreshold = true;
+		MaxScreenSpaceError = 0.f;
 
 		if (LOD < 0 || LOD > TerrainData.MaxLOD - 1)
 			return false;
@@ -980,6 +1038,21 @@ namespace scene
 	}
 
 
+	//! Returns the number of patches drawn with a LOD, or all drawn patches for -1
+	u32 CTerrainSceneNode::getDrawnPatchCount(s32 LOD) const
+	{
+		if (LOD >= (s32)DrawnPatchCounts.size())
+			return 0;
+		if (LOD >= 0)
+			return DrawnPatchCounts[LOD];
+
+		u32 count = 0;
+		for (u32 i = 0; i < DrawnPatchCounts.size(); ++i)
+			count += DrawnPatchCounts[i];
+		return count;
+	}
+
+
 	//! Creates a planar texture mapping on the terrain
 	//! \param resolution: resolution of the planar mapping. This is the value
 	//! specifying the relation between world space and texture coordinate space.
@@ -988,6 +1061,13 @@ namespace scene
 		TCoordScale1 = resolution;
 		TCoordScale2 = resolution2;
 
+		// texture coordinates are calculated when the vertices are rebuilt
+		if (CompactStorage)
+		{
+			invalidateCompactVertices();
+			return;
+		}
+
 		const f32 resBySize = resolution / (f32)(TerrainData.Size-1);
 		const f32 res2BySize = resolution2 / (f32)(TerrainData.Size-1);
 		u32 index = 0;
@@ -1027,60 +1107,192 @@ namespace scene
 	}
 
 
-	//! used to get the indices when generating index data for patches at varying levels of detail.
-	u32 CTerrainSceneNode::getIndex(const s32 PatchX, const s32 PatchZ,
-					const s32 PatchIndex, u32 vX, u32 vZ) const
+	//! Gets the index templates used for a patch, stitched to the LODs of its
+	//! visible neighbours or not.
+	u32 CTerrainSceneNode::getPatchKey(s32 patchIndex, s32 LOD, bool stitch) const
+	{
+		const SPatch& patch = TerrainData.Patches[patchIndex];
+		const SPatch* neighbours[CTerrainIndexTemplates::ES_COUNT] =
+			{ patch.Top, patch.Bottom, patch.Left, patch.Right };
+
+		s32 neighbourLODs[CTerrainIndexTemplates::ES_COUNT];
+		for (s32 side = 0; side < CTerrainIndexTemplates::ES_COUNT; ++side)
+			neighbourLODs[side] = (stitch && neighbours[side]) ? neighbours[side]->CurrentLOD : LOD;
+
+		return IndexTemplates.getKey(LOD, neighbourLODs);
+	}
+
+
+	//! Writes the indices of a patch into a 16 or 32 bit index array.
+	u32 CTerrainSceneNode::getPatchIndices(u32 key, s32 patchIndex,
+			video::E_INDEX_TYPE type, void* target) const
 	{
-		// top border
-		if (vZ == 0)
+		const s32 patchZ = patchIndex / TerrainData.PatchCount;
+		const s32 patchX = patchIndex % TerrainData.PatchCount;
+		const u32 firstVertex = TerrainData.CalcPatchSize *
+			(patchZ * TerrainData.Size + patchX);
+
+		return IndexTemplates.getIndices(key, firstVertex, type, target);
+	}
+
+
+	//! Returns the position of a vertex, which is index = x * Size + z
+	core::vector3df CTerrainSceneNode::getVertexPosition(u32 index) const
+	{
+		if (!CompactStorage)
+			return RenderBuffer->getPosition(index);
+
+		const s32 x = index / TerrainData.Size;
+		const s32 z = index % TerrainData.Size;
+		core::vector3df pos((f32)x, getCompactHeight(x, z), (f32)z);
+		pos = pos * TerrainData.Scale + TerrainData.Position - CompactPivot;
+		CompactRotation.inverseRotateVect(pos);
+		return pos + CompactPivot;
+	}
+
+
+	//! Rebuilds a vertex from the compact storage. The normal follows the
+	//! slopes to the neighbours, which are the vertex itself at the borders.
+	void CTerrainSceneNode::getCompactVertex(s32 x, s32 z, bool transformed,
+			video::S3DVertex2TCoords& vertex) const
+	{
+		const s32 x0 = core::max_(x - 1, 0);
+		const s32 x1 = core::min_(x + 1, TerrainData.Size - 1);
+		const s32 z0 = core::max_(z - 1, 0);
+		const s32 z1 = core::min_(z + 1, TerrainData.Size - 1);
+		const core::vector3df scale = transformed ? TerrainData.Scale : core::vector3df(1.f, 1.f, 1.f);
+
+		vertex.Normal.set(
+			(getCompactHeight(x0, z) - getCompactHeight(x1, z)) * scale.Y / ((x1 - x0) * scale.X),
+			1.f,
+			(getCompactHeight(x, z0) - getCompactHeight(x, z1)) * scale.Y / ((z1 - z0) * scale.Z));
+		vertex.Normal.normalize();
+
+		if (transformed)
 		{
-			if (TerrainData.Patches[PatchIndex].Top &&
-				TerrainData.Patches[PatchIndex].CurrentLOD < TerrainData.Patches[PatchIndex].Top->CurrentLOD &&
-				(vX % (1 << TerrainData.Patches[PatchIndex].Top->CurrentLOD)) != 0 )
-			{
-				vX -= vX % (1 << TerrainData.Patches[PatchIndex].Top->CurrentLOD);
-			}
+			vertex.Pos = getVertexPosition(x * TerrainData.Size + z);
+			CompactRotation.inverseRotateVect(vertex.Normal);
 		}
 		else
-		if (vZ == (u32)TerrainData.CalcPatchSize) // bottom border
+			vertex.Pos.set((f32)x, getCompactHeight(x, z), (f32)z);
+
+		vertex.Color = VertexColor;
+
+		const f32 size = (f32)(TerrainData.Size - 1);
+		vertex.TCoords.set(1.f - x * TCoordScale1 / size, z * TCoordScale1 / size);
+		if (TCoordScale2 == 0.f)
+			vertex.TCoords2 = vertex.TCoords;
+		else
+			vertex.TCoords2.set(1.f - x * TCoordScale2 / size, z * TCoordScale2 / size);
+	}
+
+
+	//! Stores the heights of a mesh buffer with 16 bits between the lowest
+	//! and the highest height. The mesh only keeps the material.
+	void CTerrainSceneNode::createCompactHeights(IDynamicMeshBuffer* mb)
+	{
+		const u32 vertexCount = mb->getVertexCount();
+		f32 maxHeight = 0.f;
+		HeightMin = 0.f;
+		for (u32 i = 0; i < vertexCount; ++i)
 		{
-			if (TerrainData.Patches[PatchIndex].Bottom &&
-				TerrainData.Patches[PatchIndex].CurrentLOD < TerrainData.Patches[PatchIndex].Bottom->CurrentLOD &&
-				(vX % (1 << TerrainData.Patches[PatchIndex].Bottom->CurrentLOD)) != 0)
-			{
-				vX -= vX % (1 << TerrainData.Patches[PatchIndex].Bottom->CurrentLOD);
-			}
+			const f32 height = mb->getPosition(i).Y;
+			if (i == 0 || height < HeightMin)
+				HeightMin = height;
+			if (i == 0 || height > maxHeight)
+				maxHeight = height;
 		}
+		HeightStep = (maxHeight - HeightMin) / 65535.f;
+		const f32 invStep = (HeightStep > 0.f) ? 1.f / HeightStep : 0.f;
+
+		Heights.reallocate(vertexCount);
+		Heights.set_used(vertexCount);
+		for (u32 i = 0; i < vertexCount; ++i)
+			Heights[i] = (u16)core::clamp(core::round32((mb->getPosition(i).Y - HeightMin) * invStep), 0, 65535);
+
+		VertexColor = vertexCount ? mb->getVertexBuffer()[0].Color : video::SColor(255,255,255,255);
+
+		CDynamicMeshBuffer* materialBuffer = new CDynamicMeshBuffer(video::EVT_2TCOORDS, video::EIT_16BIT);
+		Mesh->addMeshBuffer(materialBuffer);
+		materialBuffer->drop();
+
+		// the render buffer holds the vertices of all patches at most
+		const s32 patchCount = (TerrainData.Size - 1) / TerrainData.CalcPatchSize;
+		const u32 maxVertices = patchCount * patchCount * TerrainData.PatchSize * TerrainData.PatchSize;
+		RenderBuffer->getVertexBuffer().set_used(0);
+		RenderBuffer->getIndexBuffer().setType(maxVertices <= 65536 ? video::EIT_16BIT : video::EIT_32BIT);
+	}
 
-		// left border
-		if (vX == 0)
+
+	//! Writes the vertices of patches which became visible into free slots of
+	//! the render buffer. Patches which became hidden free their slots first.
+	void CTerrainSceneNode::updateCompactVertices()
+	{
+		const s32 count = TerrainData.PatchCount * TerrainData.PatchCount;
+		const u32 patchVertices = TerrainData.PatchSize * TerrainData.PatchSize;
+
+		s32 index;
+		for (index = 0; index < count; ++index)
 		{
-			if (TerrainData.Patches[PatchIndex].Left &&
-				TerrainData.Patches[PatchIndex].CurrentLOD < TerrainData.Patches[PatchIndex].Left->CurrentLOD &&
-				(vZ % (1 << TerrainData.Patches[PatchIndex].Left->CurrentLOD)) != 0)
+			SPatch& patch = TerrainData.Patches[index];
+			if (patch.CurrentLOD < 0 && patch.VertexSlot >= 0)
 			{
-				vZ -= vZ % (1 << TerrainData.Patches[PatchIndex].Left->CurrentLOD);
+				FreeSlots.push_back(patch.VertexSlot);
+				patch.VertexSlot = -1;
 			}
 		}
-		else
-		if (vX == (u32)TerrainData.CalcPatchSize) // right border
+
+		bool changed = false;
+		for (index = 0; index < count; ++index)
 		{
-			if (TerrainData.Patches[PatchIndex].Right &&
-				TerrainData.Patches[PatchIndex].CurrentLOD < TerrainData.Patches[PatchIndex].Right->CurrentLOD &&
-				(vZ % (1 << TerrainData.Patches[PatchIndex].Right->CurrentLOD)) != 0)
+			SPatch& patch = TerrainData.Patches[index];
+			if (patch.CurrentLOD < 0 || patch.VertexSlot >= 0)
+				continue;
+
+			if (FreeSlots.empty())
 			{
-				vZ -= vZ % (1 << TerrainData.Patches[PatchIndex].Right->CurrentLOD);
+				patch.VertexSlot = SlotCount++;
+				RenderBuffer->getVertexBuffer().set_used(SlotCount * patchVertices);
 			}
+			else
+			{
+				patch.VertexSlot = FreeSlots.getLast();
+				FreeSlots.erase(FreeSlots.size() - 1);
+			}
+			// the indices of the patch point to the old slot
+			patch.IndexKey = 0xffffffff;
+
+			video::S3DVertex2TCoords* vertices = (video::S3DVertex2TCoords*)RenderBuffer->getVertexBuffer().pointer() +
+				patch.VertexSlot * patchVertices;
+			const s32 xstart = (index / TerrainData.PatchCount) * TerrainData.CalcPatchSize;
+			const s32 zstart = (index % TerrainData.PatchCount) * TerrainData.CalcPatchSize;
+			for (s32 x = 0; x < TerrainData.PatchSize; ++x)
+				for (s32 z = 0; z < TerrainData.PatchSize; ++z)
+					getCompactVertex(xstart + x, zstart + z, true, *vertices++);
+
+			changed = true;
 		}
 
-		if (vZ >= (u32)TerrainData.PatchSize)
-			vZ = TerrainData.CalcPatchSize;
+		if (changed)
+			RenderBuffer->setDirty(EBT_VERTEX);
+	}
 
-		if (vX >= (u32)TerrainData.PatchSize)
-			vX = TerrainData.CalcPatchSize;
 
-		return (vZ + ((TerrainData.CalcPatchSize) * PatchZ)) * TerrainData.Size +
-			(vX + ((TerrainData.CalcPatchSize) * PatchX));
+	//! Frees the vertices of all patches, they are rebuilt when the patches
+	//! are visible the next time.
+	void CTerrainSceneNode::invalidateCompactVertices()
+	{
+		const s32 count = TerrainData.PatchCount * TerrainData.PatchCount;
+		for (s32 index = 0; index < count; ++index)
+		{
+			TerrainData.Patches[index].VertexSlot = -1;
+			TerrainData.Patches[index].IndexKey = 0xffffffff;
+		}
+		FreeSlots.clear();
+		SlotCount = 0;
+		RenderBuffer->getVertexBuffer().set_used(0);
+		IndicesToRender = 0;
+		ForceRecalculation = true;
 	}
 
 
@@ -1239,6 +1451,116 @@ namespace scene
 			delete [] TerrainData.Patches;
 
 		TerrainData.Patches = new SPatch[TerrainData.PatchCount * TerrainData.PatchCount];
+
+		PatchTree.clear();
+		if (TerrainData.PatchCount > 0)
+		{
+			PatchTree.push_back(SPatchTreeNode());
+			createPatchTree(0, 0, 0, TerrainData.PatchCount, TerrainData.PatchCount);
+		}
+	}
+
+
+	//! Splits a rectangle of patches into up to four children, until single
+	//! patches are left. The bounding boxes are set in calculatePatchData().
+	void CTerrainSceneNode::createPatchTree(s32 node, s32 x0, s32 z0, s32 x1, s32 z1)
+	{
+		SPatchTreeNode& treeNode = PatchTree[node];
+		treeNode.X0 = x0;
+		treeNode.Z0 = z0;
+		treeNode.X1 = x1;
+		treeNode.Z1 = z1;
+		treeNode.FirstChild = 0;
+		treeNode.ChildCount = 0;
+
+		if (x1 - x0 == 1 && z1 - z0 == 1)
+			return;
+
+		const s32 xm = (x1 - x0 > 1) ? (x0 + x1) / 2 : x1;
+		const s32 zm = (z1 - z0 > 1) ? (z0 + z1) / 2 : z1;
+		const s32 rects[4][4] = {
+			{ x0, z0, xm, zm }, { xm, z0, x1, zm },
+			{ x0, zm, xm, z1 }, { xm, zm, x1, z1 } };
+
+		// reserve the children first, so they are stored next to each other
+		const s32 firstChild = PatchTree.size();
+		s32 childCount = 0;
+		s32 i;
+		for (i = 0; i < 4; ++i)
+		{
+			if (rects[i][0] < rects[i][2] && rects[i][1] < rects[i][3])
+			{
+				PatchTree.push_back(SPatchTreeNode());
+				++childCount;
+			}
+		}
+		PatchTree[node].FirstChild = firstChild;
+		PatchTree[node].ChildCount = childCount;
+
+		s32 child = firstChild;
+		for (i = 0; i < 4; ++i)
+		{
+			if (rects[i][0] < rects[i][2] && rects[i][1] < rects[i][3])
+				createPatchTree(child++, rects[i][0], rects[i][1], rects[i][2], rects[i][3]);
+		}
+	}
+
+
+	//! Calculates the largest difference between the heights of a patch and
+	//! the triangles of each LOD. The error of a LOD is at least the error
+	//! of the finer LODs.
+	void CTerrainSceneNode::calculatePatchErrors()
+	{
+		const s32 count = TerrainData.PatchCount * TerrainData.PatchCount;
+		PatchErrors.set_used(count * TerrainData.MaxLOD);
+
+		for (s32 index = 0; index < count; ++index)
+		{
+			const s32 xstart = (index / TerrainData.PatchCount) * TerrainData.CalcPatchSize;
+			const s32 zstart = (index % TerrainData.PatchCount) * TerrainData.CalcPatchSize;
+			f32* errors = PatchErrors.pointer() + index * TerrainData.MaxLOD;
+			errors[0] = 0.f;
+
+			for (s32 lod = 1; lod < TerrainData.MaxLOD; ++lod)
+			{
+				const s32 step = IndexTemplates.getLODStep(lod);
+				const f32 invStep = 1.f / step;
+				f32 error = errors[lod-1];
+
+				// quads are split from their first to their last vertex
+				for (s32 x = xstart; x < xstart + TerrainData.CalcPatchSize; x += step)
+				{
+					for (s32 z = zstart; z < zstart + TerrainData.CalcPatchSize; z += step)
+					{
+						const f32 h00 = getLocalHeight(x, z);
+						const f32 h10 = getLocalHeight(x + step, z);
+						const f32 h01 = getLocalHeight(x, z + step);
+						const f32 h11 = getLocalHeight(x + step, z + step);
+
+						for (s32 u = 0; u <= step; ++u)
+						{
+							for (s32 v = 0; v <= step; ++v)
+							{
+								const f32 height = (u >= v) ?
+									h00 + (h10 - h00) * u * invStep + (h11 - h10) * v * invStep :
+									h00 + (h01 - h00) * v * invStep + (h11 - h01) * u * invStep;
+								error = core::max_(error, fabsf(getLocalHeight(x + u, z + v) - height));
+							}
+						}
+					}
+				}
+				errors[lod] = error;
+			}
+		}
+	}
+
+
+	//! Returns a height of the heightmap, before scaling
+	f32 CTerrainSceneNode::getLocalHeight(s32 x, s32 z) const
+	{
+		if (CompactStorage)
+			return getCompactHeight(x, z);
+		return Mesh->getMeshBuffer(0)->getPosition(x * TerrainData.Size + z).Y;
 	}
 
 
@@ -1246,7 +1568,7 @@ namespace scene
 	void CTerrainSceneNode::calculatePatchData()
 	{
 		// Reset the Terrains Bounding Box for re-calculation
-		TerrainData.BoundingBox.reset(RenderBuffer->getPosition(0));
+		TerrainData.BoundingBox.reset(getVertexPosition(0));
 
 		for (s32 x = 0; x < TerrainData.PatchCount; ++x)
 		{
@@ -1261,11 +1583,11 @@ namespace scene
 				const s32 zstart = z*TerrainData.CalcPatchSize;
 				const s32 zend = zstart+TerrainData.CalcPatchSize;
 				// For each patch, calculate the bounding box (mins and maxes)
-				patch.BoundingBox.reset(RenderBuffer->getPosition(xstart*TerrainData.Size + zstart));
+				patch.BoundingBox.reset(getVertexPosition(xstart*TerrainData.Size + zstart));
 
 				for (s32 xx = xstart; xx <= xend; ++xx)
 					for (s32 zz = zstart; zz <= zend; ++zz)
-						patch.BoundingBox.addInternalPoint(RenderBuffer->getVertexBuffer()[xx * TerrainData.Size + zz].Pos);
+						patch.BoundingBox.addInternalPoint(getVertexPosition(xx * TerrainData.Size + zz));
 
 				// Reconfigure the bounding box of the terrain as a whole
 				TerrainData.BoundingBox.addInternalBox(patch.BoundingBox);
@@ -1300,6 +1622,20 @@ namespace scene
 			}
 		}
 
+		// bounding boxes of the patch tree, the children are stored after their parents
+		for (s32 n = (s32)PatchTree.size() - 1; n >= 0; --n)
+		{
+			SPatchTreeNode& treeNode = PatchTree[n];
+			if (!treeNode.ChildCount)
+			{
+				treeNode.BoundingBox = TerrainData.Patches[treeNode.X0 * TerrainData.PatchCount + treeNode.Z0].BoundingBox;
+				continue;
+			}
+			treeNode.BoundingBox = PatchTree[treeNode.FirstChild].BoundingBox;
+			for (s32 c = 1; c < treeNode.ChildCount; ++c)
+				treeNode.BoundingBox.addInternalBox(PatchTree[treeNode.FirstChild + c].BoundingBox);
+		}
+
 		// get center of Terrain
 		TerrainData.Center = TerrainData.BoundingBox.getCenter();
 
@@ -1367,20 +1703,31 @@ namespace scene
 		if (X >= 0 && X < TerrainData.Size-1 &&
 				Z >= 0 && Z < TerrainData.Size-1)
 		{
-			const video::S3DVertex2TCoords* Vertices = (const video::S3DVertex2TCoords*)Mesh->getMeshBuffer(0)->getVertices();
-			const core::vector3df& a = Vertices[X * TerrainData.Size + Z].Pos;
-			const core::vector3df& b = Vertices[(X + 1) * TerrainData.Size + Z].Pos;
-			const core::vector3df& c = Vertices[X * TerrainData.Size + (Z + 1)].Pos;
-			const core::vector3df& d = Vertices[(X + 1) * TerrainData.Size + (Z + 1)].Pos;
+			f32 a, b, c, d;
+			if (CompactStorage)
+			{
+				a = getCompactHeight(X, Z);
+				b = getCompactHeight(X + 1, Z);
+				c = getCompactHeight(X, Z + 1);
+				d = getCompactHeight(X + 1, Z + 1);
+			}
+			else
+			{
+				const video::S3DVertex2TCoords* Vertices = (const video::S3DVertex2TCoords*)Mesh->getMeshBuffer(0)->getVertices();
+				a = Vertices[X * TerrainData.Size + Z].Pos.Y;
+				b = Vertices[(X + 1) * TerrainData.Size + Z].Pos.Y;
+				c = Vertices[X * TerrainData.Size + (Z + 1)].Pos.Y;
+				d = Vertices[(X + 1) * TerrainData.Size + (Z + 1)].Pos.Y;
+			}
 
 			// offset from integer position
 			const f32 dx = pos.X - X;
 			const f32 dz = pos.Z - Z;
 
 			if (dx > dz)
-				height = a.Y + (d.Y - b.Y)*dz + (b.Y - a.Y)*dx;
+				height = a + (d - b)*dz + (b - a)*dx;
 			else
-				height = a.Y + (d.Y - c.Y)*dx + (c.Y - a.Y)*dz;
+				height = a + (d - c)*dx + (c - a)*dz;
 
 			height *= TerrainData.Scale.Y;
 			height += TerrainData.Position.Y;
@@ -11,6 +11,7 @@
 
 #include "ITerrainSceneNode.h"
 #include "IDynamicMeshBuffer.h"
+#include "CTerrainIndexTemplates.h"
 #include "path.h"
 
 namespace irr
@@ -23,6 +24,7 @@ namespace io
 namespace scene
 {
 	struct SMesh;
+	struct SViewFrustum;
 	class ITextSceneNode;
 
 	//! A scene node for displaying terrain using the geo mip map algorithm.
@@ -199,12 +201,28 @@ namespace scene
 		//! work best with your new terrain size.
 		virtual bool overrideLODDistance( s32 LOD, f64 newDistance ) _IRR_OVERRIDE_;
 
+		//! Sets the largest height error of a patch on the screen.
+		virtual void setMaxScreenSpaceError(f32 pixels) _IRR_OVERRIDE_
+		{
+			MaxScreenSpaceError = core::max_(pixels, 0.f);
+			ForceRecalculation = true;
+		}
+
+		//! Get the largest height error of a patch on the screen.
+		virtual f32 getMaxScreenSpaceError() const _IRR_OVERRIDE_ { return MaxScreenSpaceError; }
+
+		//! Get the number of patches drawn with a LOD.
+		virtual u32 getDrawnPatchCount(s32 LOD=-1) const _IRR_OVERRIDE_;
+
 		//! Scales the two textures
 		virtual void scaleTexture(f32 scale = 1.0f, f32 scale2 = 0.0f) _IRR_OVERRIDE_;
 
 		//! Returns type of the scene node
 		virtual ESCENE_NODE_TYPE getType() const _IRR_OVERRIDE_ {return ESNT_TERRAIN;}
 
+		//! Uses the transformation handling of ISceneNode
+		virtual bool hasPlainTransformation() const _IRR_OVERRIDE_ { return true; }
+
 		//! Writes attributes of the scene node.
 		virtual void serializeAttributes(io::IAttributes* out,
 				io::SAttributeReadWriteOptions* options=0) const _IRR_OVERRIDE_;
@@ -223,7 +241,8 @@ namespace scene
 		struct SPatch
 		{
 			SPatch()
-			: Top(0), Bottom(0), Right(0), Left(0), CurrentLOD(-1)
+			: Top(0), Bottom(0), Right(0), Left(0), CurrentLOD(-1),
+				IndexKey(0xffffffff), FirstIndex(0), IndexCount(0), VertexSlot(-1)
 			{
 			}
 
@@ -234,6 +253,25 @@ namespace scene
 			s32 CurrentLOD;
 			core::aabbox3df BoundingBox;
 			core::vector3df Center;
+
+			//! Templates of the indices in the render buffer, 0xffffffff if they are not valid
+			u32 IndexKey;
+			//! Position of the indices in the render buffer
+			u32 FirstIndex;
+			u32 IndexCount;
+			//! Vertices of the patch in the render buffer with compact storage, -1 if there are none
+			s32 VertexSlot;
+		};
+
+		//! Node of a quadtree over rectangles of patches
+		struct SPatchTreeNode
+		{
+			core::aabbox3df BoundingBox;
+			//! Patches from X0, Z0 up to X1, Z1 exclusive
+			s32 X0, Z0, X1, Z1;
+			//! Children are stored next to each other
+			s32 FirstChild;
+			s32 ChildCount;
 		};
 
 		struct STerrainData
@@ -264,8 +302,49 @@ namespace scene
 		void preRenderLODCalculations();
 		void preRenderIndicesCalculations();
 
-		//! get indices when generating index data for patches at varying levels of detail.
-		u32 getIndex(const s32 PatchX, const s32 PatchZ, const s32 PatchIndex, u32 vX, u32 vZ) const;
+		//! cull a node of the patch tree and select the LODs of its visible patches
+		//! \param planeMask: Frustum planes which still cut the parent node.
+		void selectPatchLODs(s32 node, const SViewFrustum& frustum,
+			const core::vector3df& cameraPosition, f32 projection, u32 planeMask);
+
+		//! create the patch tree node for a rectangle of patches and its children
+		void createPatchTree(s32 node, s32 x0, s32 z0, s32 x1, s32 z1);
+
+		//! calculate the largest height errors of the patches at each LOD
+		void calculatePatchErrors();
+
+		//! get a height in the space of the heightmap
+		f32 getLocalHeight(s32 x, s32 z) const;
+
+		//! get the index templates used for a patch
+		//! \param stitch: Stitch the borders to the vertices of coarser neighbours.
+		u32 getPatchKey(s32 patchIndex, s32 LOD, bool stitch) const;
+
+		//! write the indices of a patch into a 16 or 32 bit index array
+		//! \return Number of indices written.
+		u32 getPatchIndices(u32 key, s32 patchIndex, video::E_INDEX_TYPE type, void* target) const;
+
+		//! get the position of a vertex of the whole terrain in the render buffer space
+		core::vector3df getVertexPosition(u32 index) const;
+
+		//! get a height with compact storage
+		f32 getCompactHeight(s32 x, s32 z) const
+		{
+			return HeightMin + Heights[x * TerrainData.Size + z] * HeightStep;
+		}
+
+		//! rebuild a vertex from the compact storage
+		//! \param transformed: Transform it into the render buffer space, or keep it in the space of the heightmap.
+		void getCompactVertex(s32 x, s32 z, bool transformed, video::S3DVertex2TCoords& vertex) const;
+
+		//! store the heights of a mesh buffer with 16 bits
+		void createCompactHeights(IDynamicMeshBuffer* mb);
+
+		//! write the vertices of newly visible patches into the render buffer
+		void updateCompactVertices();
+
+		//! free the vertices of all patches in the render buffer
+		void invalidateCompactVertices();
 
 		//! smooth the terrain
 		void smoothTerrain(IDynamicMeshBuffer* mb, s32 smoothFactor);
@@ -296,6 +375,29 @@ namespace scene
 
 		IDynamicMeshBuffer *RenderBuffer;
 
+		//! Indices of a patch for all LODs and neighbour LODs
+		CTerrainIndexTemplates IndexTemplates;
+
+		//! Compact storage, heights and the same templates for the vertices of a single patch
+		bool CompactStorage;
+		core::array<u16> Heights;
+		f32 HeightMin;
+		f32 HeightStep;
+		video::SColor VertexColor;
+		CTerrainIndexTemplates PatchTemplates;
+		core::array<s32> FreeSlots;
+		s32 SlotCount;
+		//! Transformation of the vertices at the last applyTransformation()
+		core::matrix4 CompactRotation;
+		core::vector3df CompactPivot;
+
+		//! Quadtree over the patches, the root is the first node
+		core::array<SPatchTreeNode> PatchTree;
+		//! Largest height errors in the space of the heightmap, MaxLOD values per patch
+		core::array<f32> PatchErrors;
+		core::array<u32> DrawnPatchCounts;
+		f32 MaxScreenSpaceError;
+
 		u32 VerticesToRender;
 		u32 IndicesToRender;
 
@@ -34,11 +34,11 @@ CTerrainTriangleSelector::~CTerrainTriangleSelector()
 //! Clears and sets triangle data
 void CTerrainTriangleSelector::setTriangleData(ITerrainSceneNode* node, s32 LOD)
 {
-	// Get pointer to the GeoMipMaps vertices
-	const video::S3DVertex2TCoords* vertices = static_cast<const video::S3DVertex2TCoords*>(node->getRenderBuffer()->getVertices());
+	// The terrain knows the positions of its vertices, even with compact storage
+	const CTerrainSceneNode* terrain = static_cast<CTerrainSceneNode*>(node);
 
 	// Clear current data
-	const s32 count = (static_cast<CTerrainSceneNode*>(node))->TerrainData.PatchCount;
+	const s32 count = terrain->TerrainData.PatchCount;
 	TrianglePatches.TotalTriangles = 0;
 	TrianglePatches.NumPatches = count*count;
 
@@ -60,9 +60,9 @@ void CTerrainTriangleSelector::setTriangleData(ITerrainSceneNode* node, s32 LOD)
 			TrianglePatches.TrianglePatchArray[tIndex].Triangles.reallocate(indexCount/3);
 			for(u32 i = 0; i < indexCount; i += 3 )
 			{
-				tri.pointA = vertices[indices[i+0]].Pos;
-				tri.pointB = vertices[indices[i+1]].Pos;
-				tri.pointC = vertices[indices[i+2]].Pos;
+				tri.pointA = terrain->getVertexPosition(indices[i+0]);
+				tri.pointB = terrain->getVertexPosition(indices[i+1]);
+				tri.pointC = terrain->getVertexPosition(indices[i+2]);
 				TrianglePatches.TrianglePatchArray[tIndex].Triangles.push_back(tri);
 				++TrianglePatches.TrianglePatchArray[tIndex].NumTriangles;
 			}
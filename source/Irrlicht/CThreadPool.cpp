@@ -0,0 +1,477 @@
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#include "CThreadPool.h"
+
+#ifdef _IRR_COMPILE_WITH_THREADS_
+#if defined(_IRR_WINDOWS_API_)
+	#if !defined(_WIN32_WINNT) || (_WIN32_WINNT < 0x0600)
+		#undef _WIN32_WINNT
+		#define _WIN32_WINNT 0x0600 // condition variables need Vista
+	#endif
+	#define WIN32_LEAN_AND_MEAN
+	#include <windows.h>
+#else
+	#include <pthread.h>
+	#include <unistd.h>
+#endif
+#endif
+
+namespace irr
+{
+
+#ifdef _IRR_COMPILE_WITH_THREADS_
+#if defined(_IRR_WINDOWS_API_)
+
+typedef CRITICAL_SECTION SMutexHandle;
+typedef CONDITION_VARIABLE SConditionHandle;
+typedef HANDLE SThreadHandle;
+
+static void initMutex(SMutexHandle& m) { InitializeCriticalSection(&m); }
+static void destroyMutex(SMutexHandle& m) { DeleteCriticalSection(&m); }
+static void lockMutex(SMutexHandle& m) { EnterCriticalSection(&m); }
+static void unlockMutex(SMutexHandle& m) { LeaveCriticalSection(&m); }
+
+static void initCondition(SConditionHandle& c) { InitializeConditionVariable(&c); }
+static void destroyCondition(SConditionHandle&) {}
+static void waitCondition(SConditionHandle& c, SMutexHandle& m) { SleepConditionVariableCS(&c, &m, INFINITE); }
+static void signalAll(SConditionHandle& c) { WakeAllConditionVariable(&c); }
+
+#else
+
+typedef pthread_mutex_t SMutexHandle;
+typedef pthread_cond_t SConditionHandle;
+typedef pthread_t SThreadHandle;
+
+static void initMutex(SMutexHandle& m) { pthread_mutex_init(&m, 0); }
+static void destroyMutex(SMutexHandle& m) { pthread_mutex_destroy(&m); }
+static void lockMutex(SMutexHandle& m) { pthread_mutex_lock(&m); }
+static void unlockMutex(SMutexHandle& m) { pthread_mutex_unlock(&m); }
+
+static void initCondition(SConditionHandle& c) { pthread_cond_init(&c, 0); }
+static void destroyCondition(SConditionHandle& c) { pthread_cond_destroy(&c); }
+static void waitCondition(SConditionHandle& c, SMutexHandle& m) { pthread_cond_wait(&c, &m); }
+static void signalAll(SConditionHandle& c) { pthread_cond_broadcast(&c); }
+
+#endif
+#endif // _IRR_COMPILE_WITH_THREADS_
+
+
+CMutex::CMutex() : Handle(0)
+{
+#ifdef _IRR_COMPILE_WITH_THREADS_
+	SMutexHandle* m = new SMutexHandle;
+	initMutex(*m);
+	Handle = m;
+#endif
+}
+
+
+CMutex::~CMutex()
+{
+#ifdef _IRR_COMPILE_WITH_THREADS_
+	SMutexHandle* m = (SMutexHandle*)Handle;
+	destroyMutex(*m);
+	delete m;
+#endif
+}
+
+
+void CMutex::lock()
+{
+#ifdef _IRR_COMPILE_WITH_THREADS_
+	lockMutex(*(SMutexHandle*)Handle);
+#endif
+}
+
+
+void CMutex::unlock()
+{
+#ifdef _IRR_COMPILE_WITH_THREADS_
+	unlockMutex(*(SMutexHandle*)Handle);
+#endif
+}
+
+
+struct CThreadPool::SData
+{
+	SData() : Job(0), JobData(0), JobCount(0), NextJob(0),
+		Busy(0), Generation(0), Quit(false)
+	{
+#ifdef _IRR_COMPILE_WITH_THREADS_
+		initMutex(Mutex);
+		initCondition(Wake);
+		initCondition(Done);
+#endif
+	}
+
+	~SData()
+	{
+#ifdef _IRR_COMPILE_WITH_THREADS_
+		destroyCondition(Done);
+		destroyCondition(Wake);
+		destroyMutex(Mutex);
+#endif
+	}
+
+#ifdef _IRR_COMPILE_WITH_THREADS_
+#if defined(_IRR_WINDOWS_API_)
+	static DWORD WINAPI threadMain(LPVOID pool)
+	{
+		CThreadPool::workerLoop((CThreadPool*)pool);
+		return 0;
+	}
+#else
+	static void* threadMain(void* pool)
+	{
+		CThreadPool::workerLoop((CThreadPool*)pool);
+		return 0;
+	}
+#endif
+
+	core::array<SThreadHandle> Threads;
+	SMutexHandle Mutex;
+	SConditionHandle Wake;
+	SConditionHandle Done;
+#endif
+
+	JobFunction Job;
+	void* JobData;
+	u32 JobCount;
+	u32 NextJob;
+	u32 Busy;
+	u32 Generation;
+	bool Quit;
+};
+
+
+CThreadPool::CThreadPool(u32 threadCount)
+	: Data(new SData())
+{
+	#ifdef _DEBUG
+	setDebugName("CThreadPool");
+	#endif
+
+#ifdef _IRR_COMPILE_WITH_THREADS_
+	Data->Threads.reallocate(threadCount);
+	for (u32 i=0; i<threadCount; ++i)
+	{
+		SThreadHandle thread;
+#if defined(_IRR_WINDOWS_API_)
+		thread = CreateThread(0, 0, SData::threadMain, this, 0, 0);
+		if (!thread)
+			break;
+#else
+		if (pthread_create(&thread, 0, SData::threadMain, this) != 0)
+			break;
+#endif
+		Data->Threads.push_back(thread);
+	}
+#endif
+}
+
+
+CThreadPool::~CThreadPool()
+{
+#ifdef _IRR_COMPILE_WITH_THREADS_
+	lockMutex(Data->Mutex);
+	Data->Quit = true;
+	signalAll(Data->Wake);
+	unlockMutex(Data->Mutex);
+
+	for (u32 i=0; i<Data->Threads.size(); ++i)
+	{
+#if defined(_IRR_WINDOWS_API_)
+		WaitForSingleObject(Data->Threads[i], INFINITE);
+		CloseHandle(Data->Threads[i]);
+#else
+		pthread_join(Data->Threads[i], 0);
+#endif
+	}
+#endif
+	delete Data;
+}
+
+
+void CThreadPool::run(JobFunction job, void* userData, u32 jobCount)
+{
+#ifdef _IRR_COMPILE_WITH_THREADS_
+	if (Data->Threads.size() && jobCount > 1)
+	{
+		lockMutex(Data->Mutex);
+		Data->Job = job;
+		Data->JobData = userData;
+		Data->JobCount = jobCount;
+		Data->NextJob = 0;
+		Data->Busy = Data->Threads.size();
+		++Data->Generation;
+		signalAll(Data->Wake);
+		unlockMutex(Data->Mutex);
+
+		work();
+
+		lockMutex(Data->Mutex);
+		while (Data->Busy)
+			waitCondition(Data->Done, Data->Mutex);
+		Data->Job = 0;
+		Data->JobData = 0;
+		unlockMutex(Data->Mutex);
+		return;
+	}
+#endif
+
+	for (u32 i=0; i<jobCount; ++i)
+		job(userData, i);
+}
+
+
+u32 CThreadPool::getThreadCount() const
+{
+#ifdef _IRR_COMPILE_WITH_THREADS_
+	return Data->Threads.size();
+#else
+	return 0;
+#endif
+}
+
+
+u32 CThreadPool::getProcessorCount()
+{
+#ifdef _IRR_COMPILE_WITH_THREADS_
+#if defined(_IRR_WINDOWS_API_)
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	if (info.dwNumberOfProcessors > 0)
+		return info.dwNumberOfProcessors;
+#elif defined(_SC_NPROCESSORS_ONLN)
+	const long count = sysconf(_SC_NPROCESSORS_ONLN);
+	if (count > 0)
+		return (u32)count;
+#endif
+#endif
+	return 1;
+}
+
+
+//! Grabs jobs until all are handed out.
+void CThreadPool::work()
+{
+#ifdef _IRR_COMPILE_WITH_THREADS_
+	for (;;)
+	{
+		lockMutex(Data->Mutex);
+		if (Data->NextJob >= Data->JobCount)
+		{
+			unlockMutex(Data->Mutex);
+			return;
+		}
+		const u32 index = Data->NextJob++;
+		JobFunction job = Data->Job;
+		void* userData = Data->JobData;
+		unlockMutex(Data->Mutex);
+
+		job(userData, index);
+	}
+#endif
+}
+
+
+#ifdef _IRR_COMPILE_WITH_THREADS_
+void CThreadPool::workerLoop(CThreadPool* pool)
+{
+	SData* data = pool->Data;
+
+	// threads are started before the first run(), which increases the generation
+	u32 generation = 0;
+	lockMutex(data->Mutex);
+	for (;;)
+	{
+		while (!data->Quit && data->Generation == generation)
+			waitCondition(data->Wake, data->Mutex);
+		if (data->Quit)
+			break;
+		generation = data->Generation;
+		unlockMutex(data->Mutex);
+
+		pool->work();
+
+		lockMutex(data->Mutex);
+		if (--data->Busy == 0)
+			signalAll(data->Done);
+	}
+	unlockMutex(data->Mutex);
+}
+#endif
+
+
+struct CWorkerThread::SData
+{
+	struct SJob
+	{
+		CThreadPool::JobFunction Job;
+		void* UserData;
+		u32 Index;
+	};
+
+	SData() : Pending(0), Quit(false), Running(false)
+	{
+#ifdef _IRR_COMPILE_WITH_THREADS_
+		initMutex(Mutex);
+		initCondition(Wake);
+		initCondition(Done);
+#endif
+	}
+
+	~SData()
+	{
+#ifdef _IRR_COMPILE_WITH_THREADS_
+		destroyCondition(Done);
+		destroyCondition(Wake);
+		destroyMutex(Mutex);
+#endif
+	}
+
+#ifdef _IRR_COMPILE_WITH_THREADS_
+#if defined(_IRR_WINDOWS_API_)
+	static DWORD WINAPI threadMain(LPVOID worker)
+	{
+		CWorkerThread::workerLoop((CWorkerThread*)worker);
+		return 0;
+	}
+#else
+	static void* threadMain(void* worker)
+	{
+		CWorkerThread::workerLoop((CWorkerThread*)worker);
+		return 0;
+	}
+#endif
+
+	SThreadHandle Thread;
+	mutable SMutexHandle Mutex;
+	SConditionHandle Wake;
+	SConditionHandle Done;
+#endif
+
+	//! jobs in order, the first one is executed next
+	core::array<SJob> Jobs;
+	u32 Pending;
+	bool Quit;
+	bool Running;
+};
+
+
+CWorkerThread::CWorkerThread()
+	: Data(new SData())
+{
+	#ifdef _DEBUG
+	setDebugName("CWorkerThread");
+	#endif
+
+#ifdef _IRR_COMPILE_WITH_THREADS_
+#if defined(_IRR_WINDOWS_API_)
+	Data->Thread = CreateThread(0, 0, SData::threadMain, this, 0, 0);
+	Data->Running = (Data->Thread != 0);
+#else
+	Data->Running = (pthread_create(&Data->Thread, 0, SData::threadMain, this) == 0);
+#endif
+#endif
+}
+
+
+CWorkerThread::~CWorkerThread()
+{
+#ifdef _IRR_COMPILE_WITH_THREADS_
+	if (Data->Running)
+	{
+		lockMutex(Data->Mutex);
+		Data->Quit = true;
+		signalAll(Data->Wake);
+		unlockMutex(Data->Mutex);
+
+#if defined(_IRR_WINDOWS_API_)
+		WaitForSingleObject(Data->Thread, INFINITE);
+		CloseHandle(Data->Thread);
+#else
+		pthread_join(Data->Thread, 0);
+#endif
+	}
+#endif
+	delete Data;
+}
+
+
+void CWorkerThread::post(CThreadPool::JobFunction job, void* userData, u32 index)
+{
+#ifdef _IRR_COMPILE_WITH_THREADS_
+	if (Data->Running)
+	{
+		SData::SJob j;
+		j.Job = job;
+		j.UserData = userData;
+		j.Index = index;
+
+		lockMutex(Data->Mutex);
+		Data->Jobs.push_back(j);
+		++Data->Pending;
+		signalAll(Data->Wake);
+		unlockMutex(Data->Mutex);
+		return;
+	}
+#endif
+
+	job(userData, index);
+}
+
+
+void CWorkerThread::wait()
+{
+#ifdef _IRR_COMPILE_WITH_THREADS_
+	lockMutex(Data->Mutex);
+	while (Data->Pending)
+		waitCondition(Data->Done, Data->Mutex);
+	unlockMutex(Data->Mutex);
+#endif
+}
+
+
+u32 CWorkerThread::getJobCount() const
+{
+#ifdef _IRR_COMPILE_WITH_THREADS_
+	lockMutex(Data->Mutex);
+	const u32 count = Data->Pending;
+	unlockMutex(Data->Mutex);
+	return count;
+#else
+	return 0;
+#endif
+}
+
+
+#ifdef _IRR_COMPILE_WITH_THREADS_
+void CWorkerThread::workerLoop(CWorkerThread* worker)
+{
+	SData* data = worker->Data;
+
+	lockMutex(data->Mutex);
+	for (;;)
+	{
+		while (!data->Quit && data->Jobs.empty())
+			waitCondition(data->Wake, data->Mutex);
+		if (data->Quit)
+			break;
+
+		const SData::SJob job = data->Jobs[0];
+		data->Jobs.erase(0);
+		unlockMutex(data->Mutex);
+
+		job.Job(job.UserData, job.Index);
+
+		lockMutex(data->Mutex);
+		if (--data->Pending == 0)
+			signalAll(data->Done);
+	}
+	unlockMutex(data->Mutex);
+}
+#endif
+
+} // end namespace irr
@@ -0,0 +1,125 @@
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#ifndef __C_THREAD_POOL_H_INCLUDED__
+#define __C_THREAD_POOL_H_INCLUDED__
+
+#include "IrrCompileConfig.h"
+#include "IReferenceCounted.h"
+#include "irrArray.h"
+
+namespace irr
+{
+
+//! Simple mutex used to protect engine data touched from worker threads.
+/** Without _IRR_COMPILE_WITH_THREADS_ all calls do nothing. */
+class CMutex
+{
+public:
+	CMutex();
+	~CMutex();
+
+	void lock();
+	void unlock();
+
+private:
+	// not copyable
+	CMutex(const CMutex&);
+	CMutex& operator=(const CMutex&);
+
+	void* Handle;
+};
+
+//! Locks a mutex for the lifetime of the object.
+class CMutexLock
+{
+public:
+	CMutexLock(CMutex& mutex) : Mutex(mutex) { Mutex.lock(); }
+	~CMutexLock() { Mutex.unlock(); }
+
+private:
+	CMutexLock& operator=(const CMutexLock&);
+
+	CMutex& Mutex;
+};
+
+//! Pool of worker threads which split up loops inside the engine.
+/** The pool is used for work which can be expressed as a number of independent
+jobs, like animating several scene node hierarchies. The calling thread takes
+part in the work, so a pool with 3 threads uses 4 cores.
+Without _IRR_COMPILE_WITH_THREADS_ the pool has no threads and all jobs are
+executed by the calling thread. */
+class CThreadPool : public virtual IReferenceCounted
+{
+public:
+
+	//! Function called for each job index
+	typedef void (*JobFunction)(void* userData, u32 index);
+
+	//! Constructor
+	/** \param threadCount Number of worker threads created additionally to the calling thread. */
+	CThreadPool(u32 threadCount);
+
+	//! Destructor, waits for all threads to finish.
+	virtual ~CThreadPool();
+
+	//! Calls job(userData, i) for all i in [0, jobCount) and waits until all are done.
+	/** Jobs are handed out one by one, so jobs of different size are
+	balanced between the threads. Must not be called from inside a job. */
+	void run(JobFunction job, void* userData, u32 jobCount);
+
+	//! Number of worker threads (not counting the calling thread)
+	u32 getThreadCount() const;
+
+	//! Number of hardware threads of the system, at least 1.
+	static u32 getProcessorCount();
+
+private:
+
+	struct SData;
+
+	void work();
+#ifdef _IRR_COMPILE_WITH_THREADS_
+	static void workerLoop(CThreadPool* pool);
+#endif
+
+	SData* Data;
+};
+
+//! Thread which executes jobs one after another in the background.
+/** Used for work the caller doesn't wait for, like loading data for
+the next frames. Jobs are executed in the order they were posted.
+Without _IRR_COMPILE_WITH_THREADS_ jobs are executed when they are posted. */
+class CWorkerThread : public virtual IReferenceCounted
+{
+public:
+
+	//! Constructor, starts the thread
+	CWorkerThread();
+
+	//! Destructor, finishes the current job and drops all others
+	virtual ~CWorkerThread();
+
+	//! Adds a job, which calls job(userData, index) on the worker thread
+	void post(CThreadPool::JobFunction job, void* userData, u32 index);
+
+	//! Waits until all posted jobs are done
+	void wait();
+
+	//! Number of posted jobs which are not done yet
+	u32 getJobCount() const;
+
+private:
+
+	struct SData;
+
+#ifdef _IRR_COMPILE_WITH_THREADS_
+	static void workerLoop(CWorkerThread* worker);
+#endif
+
+	SData* Data;
+};
+
+} // end namespace irr
+
+#endif // __C_THREAD_POOL_H_INCLUDED__
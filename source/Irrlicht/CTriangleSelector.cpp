@@ -147,6 +147,23 @@ static void updateTriangles(u32& triangleCount, core::array<core::triangle3df>&
 	}
 }
 
+// Returns the vertices with the position as first member, quantized positions are decoded
+static const u8* getPositions(const IMeshBuffer* buffer, core::array<core::vector3df>& decoded, u32& vertexPitch)
+{
+	if (!video::isQuantizedVertexType(buffer->getVertexType()))
+	{
+		vertexPitch = getVertexPitchFromType(buffer->getVertexType());
+		return (const u8*)buffer->getVertices();
+	}
+
+	const u32 vertexCount = buffer->getVertexCount();
+	decoded.set_used(vertexCount);
+	for (u32 i=0; i<vertexCount; ++i)
+		decoded[i] = buffer->getPosition(i);
+	vertexPitch = sizeof(core::vector3df);
+	return (const u8*)decoded.const_pointer();
+}
+
 void CTriangleSelector::updateFromMesh(const IMesh* mesh) const
 {
 	if (!mesh)
@@ -155,13 +172,14 @@ void CTriangleSelector::updateFromMesh(const IMesh* mesh) const
 	bool skinnnedMesh = mesh->getMeshType() == EAMT_SKINNED;
 	u32 meshBuffers = mesh->getMeshBufferCount();
 	u32 triangleCount = 0;
+	core::array<core::vector3df> decoded;
 
 	for (u32 i = 0; i < meshBuffers; ++i)
 	{
 		IMeshBuffer* buf = mesh->getMeshBuffer(i);
 		u32 idxCnt = buf->getIndexCount();
-		u32 vertexPitch = getVertexPitchFromType(buf->getVertexType());
-		u8* vertices = (u8*)buf->getVertices();
+		u32 vertexPitch;
+		const u8* vertices = getPositions(buf, decoded, vertexPitch);
 
 		const core::matrix4* bufferTransform = 0;
 		if ( skinnnedMesh )
@@ -198,8 +216,9 @@ void CTriangleSelector::updateFromMeshBuffer(const IMeshBuffer* meshBuffer) cons
 		return;
 
 	u32 idxCnt = meshBuffer->getIndexCount();
-	u32 vertexPitch = getVertexPitchFromType(meshBuffer->getVertexType());
-	u8* vertices = (u8*)meshBuffer->getVertices();
+	core::array<core::vector3df> decoded;
+	u32 vertexPitch;
+	const u8* vertices = getPositions(meshBuffer, decoded, vertexPitch);
 	u32 triangleCount = 0;
 	switch ( meshBuffer->getIndexType() )
 	{
@@ -314,7 +333,7 @@ void CTriangleSelector::getTriangles(core::triangle3df* triangles,
 				triRange.RangeStart = BufferRanges[rangeIndex].RangeStart;
 				triRange.RangeSize = core::min_( cnt-BufferRanges[rangeIndex].RangeStart, BufferRanges[rangeIndex].RangeSize);
 				triRange.Selector = const_cast<CTriangleSelector*>(this);
-				triRange.SceneNode = SceneNode;
+				triRange.SceneNode = BufferRanges[rangeIndex].SceneNode ? BufferRanges[rangeIndex].SceneNode : SceneNode;
 				outTriangleInfo->push_back(triRange);
 
 				i += triRange.RangeSize;
@@ -371,8 +390,8 @@ void CTriangleSelector::getTriangles(core::triangle3df* triangles,
 		irr::u32 activeRange = 0;
 		SCollisionTriangleRange triRange;
 		triRange.Selector = const_cast<CTriangleSelector*>(this);
-		triRange.SceneNode = SceneNode;
 		triRange.RangeStart = triangleCount;
+		triRange.SceneNode = BufferRanges[activeRange].SceneNode ? BufferRanges[activeRange].SceneNode : SceneNode;
 		triRange.MeshBuffer = BufferRanges[activeRange].MeshBuffer;
 		triRange.MaterialIndex = BufferRanges[activeRange].MaterialIndex;
 
@@ -389,8 +408,11 @@ void CTriangleSelector::getTriangles(core::triangle3df* triangles,
 				if ( triRange.RangeSize > 0 )
 					outTriangleInfo->push_back(triRange);
 
-				++activeRange;
+				// skip ranges without triangles in the box
+				while ( i >= BufferRanges[activeRange].RangeStart + BufferRanges[activeRange].RangeSize )
+					++activeRange;
 				triRange.RangeStart = triangleCount;
+				triRange.SceneNode = BufferRanges[activeRange].SceneNode ? BufferRanges[activeRange].SceneNode : SceneNode;
 				triRange.MeshBuffer = BufferRanges[activeRange].MeshBuffer;
 				triRange.MaterialIndex = BufferRanges[activeRange].MaterialIndex;
 			}
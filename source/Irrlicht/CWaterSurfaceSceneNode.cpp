@@ -10,11 +10,24 @@
 #include "SMesh.h"
 #include "os.h"
 
+#ifdef _IRR_COMPILE_WITH_SSE_
+#include <xmmintrin.h>
+#endif
+
 namespace irr
 {
 namespace scene
 {
 
+namespace
+{
+	//! Returns the vertex i of a mesh buffer with float positions
+	inline video::S3DVertex& getVertex(IMeshBuffer* mb, u32 pitch, u32 i)
+	{
+		return *(video::S3DVertex*)((u8*)mb->getVertices() + i*pitch);
+	}
+}
+
 //! constructor
 CWaterSurfaceSceneNode::CWaterSurfaceSceneNode(f32 waveHeight, f32 waveSpeed, f32 waveLength,
 		IMesh* mesh, ISceneNode* parent, ISceneManager* mgr, s32 id,
@@ -22,7 +35,8 @@ CWaterSurfaceSceneNode::CWaterSurfaceSceneNode(f32 waveHeight, f32 waveSpeed, f3
 		const core::vector3df& scale)
 	: CMeshSceneNode(mesh, parent, mgr, id, position, rotation, scale),
 	WaveLength(waveLength), WaveSpeed(waveSpeed), WaveHeight(waveHeight),
-	OriginalMesh(0)
+	OriginalMesh(0), KeyTime(0), KeysValid(false), UpdateInterval(0),
+	AnimationTime(0), WavesChanged(true)
 {
 	#ifdef _DEBUG
 	setDebugName("CWaterSurfaceSceneNode");
@@ -50,25 +64,227 @@ void CWaterSurfaceSceneNode::OnRegisterSceneNode()
 
 void CWaterSurfaceSceneNode::OnAnimate(u32 timeMs)
 {
-	if (Mesh && IsVisible)
+	// the waves are calculated when the node is drawn, so culled water costs nothing
+	if (timeMs != AnimationTime)
+	{
+		AnimationTime = timeMs;
+		WavesChanged = true;
+	}
+	CMeshSceneNode::OnAnimate(timeMs);
+}
+
+
+//! renders the node.
+void CWaterSurfaceSceneNode::render()
+{
+	// the transparent pass uses the waves of the solid pass
+	if (WavesChanged && Mesh && OriginalMesh)
 	{
-		const u32 meshBufferCount = Mesh->getMeshBufferCount();
-		const f32 time = timeMs / WaveSpeed;
+		updateWaves();
+		WavesChanged = false;
+	}
+	CMeshSceneNode::render();
+}
 
-		for (u32 b=0; b<meshBufferCount; ++b)
-		{
-			const u32 vtxCnt = Mesh->getMeshBuffer(b)->getVertexCount();
 
-			for (u32 i=0; i<vtxCnt; ++i)
-				Mesh->getMeshBuffer(b)->getPosition(i).Y = addWave(
-					OriginalMesh->getMeshBuffer(b)->getPosition(i),
-					time);
-		}// end for all mesh buffers
-		Mesh->setDirty(scene::EBT_VERTEX);
+void CWaterSurfaceSceneNode::updateWaves()
+{
+	// the original mesh was changed
+	bool changed = OriginalChangedIDs.size() != OriginalMesh->getMeshBufferCount();
+	for (u32 b=0; !changed && b<OriginalChangedIDs.size(); ++b)
+		changed = OriginalChangedIDs[b] != OriginalMesh->getMeshBuffer(b)->getChangedID_Vertex();
+	if (changed)
+		createWaveTable();
 
+	if (UpdateInterval == 0)
+	{
+		setWaveHeights(AnimationTime);
 		SceneManager->getMeshManipulator()->recalculateNormals(Mesh);
 	}
-	CMeshSceneNode::OnAnimate(timeMs);
+	else
+	{
+		// the waves are calculated at the start and end of each interval and interpolated between
+		const u32 keyTime = AnimationTime - AnimationTime % UpdateInterval;
+		if (!KeysValid || keyTime != KeyTime)
+		{
+			if (KeysValid && keyTime == KeyTime + UpdateInterval)
+			{
+				KeyHeights[0].swap(KeyHeights[1]);
+				KeyNormals[0].swap(KeyNormals[1]);
+			}
+			else
+				storeKey(keyTime, 0);
+			storeKey(keyTime + UpdateInterval, 1);
+
+			KeyTime = keyTime;
+			KeysValid = true;
+		}
+		interpolateKeys((AnimationTime - keyTime) / (f32)UpdateInterval);
+	}
+	Mesh->setDirty(scene::EBT_VERTEX);
+}
+
+
+void CWaterSurfaceSceneNode::createWaveTable()
+{
+	const u32 meshBufferCount = Mesh->getMeshBufferCount();
+	const f32 boxGrowth = 2.f*core::abs_(WaveHeight);
+	u32 b;
+
+	BufferStarts.set_used(meshBufferCount+1);
+	OriginalChangedIDs.set_used(meshBufferCount);
+	u32 vertexCount = 0;
+	for (b=0; b<meshBufferCount; ++b)
+	{
+		BufferStarts[b] = vertexCount;
+		vertexCount += (Mesh->getMeshBuffer(b)->getVertexCount() + 3) & ~3u;
+		OriginalChangedIDs[b] = OriginalMesh->getMeshBuffer(b)->getChangedID_Vertex();
+	}
+	BufferStarts[meshBufferCount] = vertexCount;
+
+	// sin(x+t) = sin(x)cos(t) + cos(x)sin(t), so only sin(t) and cos(t)
+	// have to be calculated for each update
+	WaveTable.set_used(vertexCount*5);
+	core::aabbox3df meshBox;
+	for (b=0; b<meshBufferCount; ++b)
+	{
+		IMeshBuffer* mb = Mesh->getMeshBuffer(b);
+		const IMeshBuffer* original = OriginalMesh->getMeshBuffer(b);
+		const u32 vtxCnt = mb->getVertexCount();
+		f32* table = WaveTable.pointer() + BufferStarts[b]*5;
+		const u32 padded = BufferStarts[b+1] - BufferStarts[b];
+
+		for (u32 i=0; i<padded; ++i)
+		{
+			f32* block = table + (i & ~3u)*5 + (i & 3);
+			if (i < vtxCnt)
+			{
+				const core::vector3df& pos = original->getPosition(i);
+				block[0] = pos.Y;
+				block[4] = sinf(pos.X/WaveLength);
+				block[8] = cosf(pos.X/WaveLength);
+				block[12] = sinf(pos.Z/WaveLength);
+				block[16] = cosf(pos.Z/WaveLength);
+			}
+			else
+			{
+				for (u32 j=0; j<20; j+=4)
+					block[j] = 0.f;
+			}
+		}
+
+		// the waves move the vertices up and down
+		core::aabbox3df box = original->getBoundingBox();
+		box.MinEdge.Y -= boxGrowth;
+		box.MaxEdge.Y += boxGrowth;
+		mb->setBoundingBox(box);
+		if (b == 0)
+			meshBox = box;
+		else
+			meshBox.addInternalBox(box);
+	}
+	if (meshBufferCount)
+		Mesh->setBoundingBox(meshBox);
+
+	KeyHeights[0].set_used(vertexCount);
+	KeyHeights[1].set_used(vertexCount);
+	KeyNormals[0].set_used(vertexCount);
+	KeyNormals[1].set_used(vertexCount);
+	KeysValid = false;
+}
+
+
+void CWaterSurfaceSceneNode::setWaveHeights(u32 timeMs)
+{
+	const f32 time = timeMs / WaveSpeed;
+	const f32 sinTime = sinf(time) * WaveHeight;
+	const f32 cosTime = cosf(time) * WaveHeight;
+
+	for (u32 b=0; b<Mesh->getMeshBufferCount(); ++b)
+	{
+		IMeshBuffer* mb = Mesh->getMeshBuffer(b);
+		if (video::isQuantizedVertexType(mb->getVertexType()))
+			continue;
+
+		const u32 pitch = video::getVertexPitchFromType(mb->getVertexType());
+		const u32 vtxCnt = mb->getVertexCount();
+		const f32* table = WaveTable.const_pointer() + BufferStarts[b]*5;
+		u32 i = 0;
+
+#ifdef _IRR_COMPILE_WITH_SSE_
+		const __m128 st = _mm_set1_ps(sinTime);
+		const __m128 ct = _mm_set1_ps(cosTime);
+		for (; i+4<=vtxCnt; i+=4, table+=20)
+		{
+			const __m128 waveX = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(table+4), ct), _mm_mul_ps(_mm_loadu_ps(table+8), st));
+			const __m128 waveZ = _mm_sub_ps(_mm_mul_ps(_mm_loadu_ps(table+16), ct), _mm_mul_ps(_mm_loadu_ps(table+12), st));
+			f32 heights[4];
+			_mm_storeu_ps(heights, _mm_add_ps(_mm_loadu_ps(table), _mm_add_ps(waveX, waveZ)));
+
+			getVertex(mb, pitch, i).Pos.Y = heights[0];
+			getVertex(mb, pitch, i+1).Pos.Y = heights[1];
+			getVertex(mb, pitch, i+2).Pos.Y = heights[2];
+			getVertex(mb, pitch, i+3).Pos.Y = heights[3];
+		}
+#endif
+		for (; i<vtxCnt; ++i)
+		{
+			const f32* block = WaveTable.const_pointer() + BufferStarts[b]*5 + (i & ~3u)*5 + (i & 3);
+			getVertex(mb, pitch, i).Pos.Y = block[0] +
+				(block[4]*cosTime + block[8]*sinTime) +
+				(block[16]*cosTime - block[12]*sinTime);
+		}
+	}
+}
+
+
+void CWaterSurfaceSceneNode::storeKey(u32 timeMs, u32 key)
+{
+	setWaveHeights(timeMs);
+	SceneManager->getMeshManipulator()->recalculateNormals(Mesh);
+
+	f32* heights = KeyHeights[key].pointer();
+	core::vector3df* normals = KeyNormals[key].pointer();
+	for (u32 b=0; b<Mesh->getMeshBufferCount(); ++b)
+	{
+		IMeshBuffer* mb = Mesh->getMeshBuffer(b);
+		if (video::isQuantizedVertexType(mb->getVertexType()))
+			continue;
+
+		const u32 pitch = video::getVertexPitchFromType(mb->getVertexType());
+		const u32 start = BufferStarts[b];
+		for (u32 i=0; i<mb->getVertexCount(); ++i)
+		{
+			const video::S3DVertex& v = getVertex(mb, pitch, i);
+			heights[start+i] = v.Pos.Y;
+			normals[start+i] = v.Normal;
+		}
+	}
+}
+
+
+void CWaterSurfaceSceneNode::interpolateKeys(f32 t)
+{
+	const f32* heights0 = KeyHeights[0].const_pointer();
+	const f32* heights1 = KeyHeights[1].const_pointer();
+	const core::vector3df* normals0 = KeyNormals[0].const_pointer();
+	const core::vector3df* normals1 = KeyNormals[1].const_pointer();
+
+	for (u32 b=0; b<Mesh->getMeshBufferCount(); ++b)
+	{
+		IMeshBuffer* mb = Mesh->getMeshBuffer(b);
+		if (video::isQuantizedVertexType(mb->getVertexType()))
+			continue;
+
+		const u32 pitch = video::getVertexPitchFromType(mb->getVertexType());
+		const u32 start = BufferStarts[b];
+		for (u32 i=0; i<mb->getVertexCount(); ++i)
+		{
+			video::S3DVertex& v = getVertex(mb, pitch, i);
+			v.Pos.Y = heights0[start+i] + (heights1[start+i] - heights0[start+i])*t;
+			v.Normal = normals0[start+i] + (normals1[start+i] - normals0[start+i])*t;
+		}
+	}
 }
 
 
@@ -84,6 +300,8 @@ void CWaterSurfaceSceneNode::setMesh(IMesh* mesh)
 	Mesh = clone;
 	Mesh->setHardwareMappingHint(scene::EHM_STATIC, scene::EBT_INDEX);
 //	Mesh->setHardwareMappingHint(scene::EHM_STREAM, scene::EBT_VERTEX);
+	createWaveTable();
+	WavesChanged = true;
 }
 
 
@@ -93,6 +311,7 @@ void CWaterSurfaceSceneNode::serializeAttributes(io::IAttributes* out, io::SAttr
 	out->addFloat("WaveLength", WaveLength);
 	out->addFloat("WaveSpeed",  WaveSpeed);
 	out->addFloat("WaveHeight", WaveHeight);
+	out->addInt("UpdateInterval", UpdateInterval);
 
 	CMeshSceneNode::serializeAttributes(out, options);
 	// serialize original mesh
@@ -106,6 +325,7 @@ void CWaterSurfaceSceneNode::deserializeAttributes(io::IAttributes* in, io::SAtt
 	WaveLength = in->getAttributeAsFloat("WaveLength");
 	WaveSpeed  = in->getAttributeAsFloat("WaveSpeed");
 	WaveHeight = in->getAttributeAsFloat("WaveHeight");
+	UpdateInterval = core::max_(in->getAttributeAsInt("UpdateInterval"), 0);
 
 	if (Mesh)
 	{
@@ -121,17 +341,10 @@ void CWaterSurfaceSceneNode::deserializeAttributes(io::IAttributes* in, io::SAtt
 		IMesh* clone = SceneManager->getMeshManipulator()->createMeshCopy(Mesh);
 		OriginalMesh = Mesh;
 		Mesh = clone;
+		createWaveTable();
 	}
-}
-
-
-f32 CWaterSurfaceSceneNode::addWave(const core::vector3df &source, f32 time) const
-{
-	return source.Y +
-		(sinf(((source.X/WaveLength) + time)) * WaveHeight) +
-		(cosf(((source.Z/WaveLength) + time)) * WaveHeight);
+	WavesChanged = true;
 }
 
 } // end namespace scene
 } // end namespace irr
-
@@ -32,12 +32,18 @@ namespace scene
 		//! animated update
 		virtual void OnAnimate(u32 timeMs) _IRR_OVERRIDE_;
 
+		//! renders the node.
+		virtual void render() _IRR_OVERRIDE_;
+
 		//! Update mesh
 		virtual void setMesh(IMesh* mesh) _IRR_OVERRIDE_;
 
 		//! Returns type of the scene node
 		virtual ESCENE_NODE_TYPE getType() const _IRR_OVERRIDE_ { return ESNT_WATER_SURFACE; }
 
+		//! OnAnimate() is overridden, unlike in CMeshSceneNode
+		virtual bool hasPlainTransformation() const _IRR_OVERRIDE_ { return false; }
+
 		//! Writes attributes of the scene node.
 		virtual void serializeAttributes(io::IAttributes* out, io::SAttributeReadWriteOptions* options) const _IRR_OVERRIDE_;
 
@@ -46,12 +52,42 @@ namespace scene
 
 	private:
 
-		inline f32 addWave(const core::vector3df &source, f32 time) const;
+		//! Calculates the wave table and bounding boxes of the original mesh
+		void createWaveTable();
+
+		//! Sets the vertex heights of the mesh to the waves at a time
+		void setWaveHeights(u32 timeMs);
+
+		//! Calculates the waves of the current animation time
+		void updateWaves();
+
+		//! Stores the heights and normals of the waves at a time
+		void storeKey(u32 timeMs, u32 key);
+
+		//! Interpolates heights and normals between the two keys
+		void interpolateKeys(f32 t);
 
 		f32 WaveLength;
 		f32 WaveSpeed;
 		f32 WaveHeight;
 		IMesh* OriginalMesh;
+
+		// for blocks of 4 vertices the original heights, then sin and cos of x, then of z
+		core::array<f32> WaveTable;
+		// first vertex of each mesh buffer in the table, in multiples of 4
+		core::array<u32> BufferStarts;
+		// change IDs of the original vertices the table was created from
+		core::array<u32> OriginalChangedIDs;
+
+		// heights and normals at the start and the end of the current update interval
+		core::array<f32> KeyHeights[2];
+		core::array<core::vector3df> KeyNormals[2];
+		u32 KeyTime;
+		bool KeysValid;
+
+		u32 UpdateInterval;
+		u32 AnimationTime;
+		bool WavesChanged;
 	};
 
 } // end namespace scene
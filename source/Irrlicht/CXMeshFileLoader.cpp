@@ -234,7 +234,7 @@ bool CXMeshFileLoader::load(io::IReadFile* file)
 					for (u32 j=0;j< Array.size() ;++j)
 					{
 						if ( Array[j]== mesh->FaceMaterialIndices[i] )
-							buffer->Indices.push_back( verticesLinkIndex[ mesh->Indices[id] ][j] );
+							buffer->addIndex( verticesLinkIndex[ mesh->Indices[id] ][j] );
 					}
 				}
 			}
@@ -360,7 +360,16 @@ bool CXMeshFileLoader::load(io::IReadFile* file)
 				for (i=0; i<mesh->FaceMaterialIndices.size(); ++i)
 					++vCountArray[ mesh->FaceMaterialIndices[i] ];
 				for (i=0; i!=mesh->Buffers.size(); ++i)
-					mesh->Buffers[i]->Indices.reallocate(vCountArray[i]);
+				{
+					// large buffers get 32 bit indices instead of being split
+					if (mesh->Buffers[i]->getVertexCount() > 65536)
+					{
+						mesh->Buffers[i]->convertTo32BitIndices();
+						mesh->Buffers[i]->Indices32.reallocate(vCountArray[i]);
+					}
+					else
+						mesh->Buffers[i]->Indices.reallocate(vCountArray[i]);
+				}
 				delete [] vCountArray;
 				// create indices per buffer
 				for (i=0; i<mesh->FaceMaterialIndices.size(); ++i)
@@ -368,7 +377,7 @@ bool CXMeshFileLoader::load(io::IReadFile* file)
 					scene::SSkinMeshBuffer *buffer = mesh->Buffers[ mesh->FaceMaterialIndices[i] ];
 					for (u32 id=i*3+0; id!=i*3+3; ++id)
 					{
-						buffer->Indices.push_back( verticesLinkIndex[ mesh->Indices[id] ] );
+						buffer->addIndex( verticesLinkIndex[ mesh->Indices[id] ] );
 					}
 				}
 			}
@@ -26,10 +26,18 @@ namespace irr
 		EPID_SM_RENDER_TRANSPARENT,
 		EPID_SM_RENDER_EFFECT,
 		EPID_SM_REGISTER,
+		EPID_SM_CULL,
+		EPID_SM_OCCLUDERS,
 
 		//! octrees
 		EPID_OC_RENDER,
-		EPID_OC_CALCPOLYS
+		EPID_OC_CALCPOLYS,
+
+		//! particle systems
+		EPID_PS_SORT,
+
+		//! shadow volumes
+		EPID_SV_UPDATE
     };
 #endif
 } // end namespace irr
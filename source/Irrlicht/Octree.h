@@ -10,6 +10,8 @@
 #include "aabbox3d.h"
 #include "irrArray.h"
 #include "CMeshBuffer.h"
+#include "IReadFile.h"
+#include "IWriteFile.h"
 
 /**
 	Flags for Octree
@@ -31,7 +33,7 @@ public:
 	struct SMeshChunk : public scene::CMeshBuffer<T>
 	{
 		SMeshChunk ()
-			: scene::CMeshBuffer<T>(), MaterialId(0)
+			: scene::CMeshBuffer<T>(), MaterialId(0), IndexDataID(0)
 		{
 			scene::CMeshBuffer<T>::grab();
 		}
@@ -42,6 +44,8 @@ public:
 		}
 
 		s32 MaterialId;
+		//! SIndexData::ChangedID of the indices in the buffer, 0 if it has all indices
+		u32 IndexDataID;
 	};
 
 	struct SIndexChunk
@@ -55,14 +59,16 @@ public:
 		u16* Indices;
 		s32 CurrentSize;
 		s32 MaxSize;
+		//! Incremented each time the indices change, starts with 0
+		u32 ChangedID;
 	};
 
 
-	//! Constructor
+	//! Constructor, builds the tree
 	Octree(const core::array<SMeshChunk>& meshes, s32 minimalPolysPerNode=128) :
-		IndexData(0), IndexDataCount(meshes.size()), NodeCount(0)
+		Root(0), IndexData(0), IndexDataCount(meshes.size()), NodeCount(0)
 	{
-		IndexData = new SIndexData[IndexDataCount];
+		init(meshes);
 
 		// construct array of all indices
 
@@ -70,10 +76,6 @@ public:
 		indexChunks->reallocate(meshes.size());
 		for (u32 i=0; i!=meshes.size(); ++i)
 		{
-			IndexData[i].CurrentSize = 0;
-			IndexData[i].MaxSize = meshes[i].Indices.size();
-			IndexData[i].Indices = new u16[IndexData[i].MaxSize];
-
 			indexChunks->push_back(SIndexChunk());
 			SIndexChunk& tic = indexChunks->getLast();
 
@@ -83,26 +85,119 @@ public:
 
 		// create tree
 		Root = new OctreeNode(NodeCount, 0, meshes, indexChunks, minimalPolysPerNode);
+
+		// store the indices of each node and its children one after another
+		Root->sortIndices(TreeIndices);
+	}
+
+	//! Reads a tree written by write()
+	/** \return The tree, or 0 if the file was not written for these meshes. */
+	static Octree* read(const core::array<SMeshChunk>& meshes, io::IReadFile* file)
+	{
+		SFileHeader header;
+		if (file->read(&header, sizeof(header)) != sizeof(header) ||
+			header.Magic != FILE_MAGIC || header.Version != FILE_VERSION ||
+			header.ChunkCount != meshes.size() || header.NodeCount == 0)
+			return 0;
+
+		Octree* tree = new Octree(meshes.size());
+		tree->init(meshes);
+		bool valid = true;
+		for (u32 i=0; valid && i!=meshes.size(); ++i)
+		{
+			u32 chunkHeader[2];
+			valid = file->read(chunkHeader, sizeof(chunkHeader)) == sizeof(chunkHeader) &&
+				chunkHeader[0] == meshes[i].Indices.size() && chunkHeader[1] == getHash(meshes[i], meshes[i].Indices);
+			if (!valid)
+				break;
+
+			core::array<u16>& indices = tree->TreeIndices[i];
+			indices.set_used(chunkHeader[0]);
+			const size_t size = indices.size()*sizeof(u16);
+			valid = file->read(indices.pointer(), size) == size &&
+				getHash(meshes[i], indices) == chunkHeader[1];
+			for (u32 j=0; valid && j<indices.size(); ++j)
+				valid = indices[j] < meshes[i].Vertices.size();
+		}
+
+		if (valid)
+		{
+			tree->Root = new OctreeNode(tree->NodeCount, 0, file, tree->TreeIndices, header.NodeCount, valid);
+			valid &= tree->NodeCount == header.NodeCount;
+		}
+
+		if (!valid)
+		{
+			delete tree;
+			return 0;
+		}
+		return tree;
+	}
+
+	//! Writes the tree to a file, so it doesn't have to be built again
+	bool write(const core::array<SMeshChunk>& meshes, io::IWriteFile* file) const
+	{
+		if (meshes.size() != IndexDataCount)
+			return false;
+
+		SFileHeader header;
+		header.Magic = FILE_MAGIC;
+		header.Version = FILE_VERSION;
+		header.ChunkCount = IndexDataCount;
+		header.NodeCount = NodeCount;
+		bool success = file->write(&header, sizeof(header)) == sizeof(header);
+
+		for (u32 i=0; success && i!=IndexDataCount; ++i)
+		{
+			const u32 chunkHeader[2] = { TreeIndices[i].size(), getHash(meshes[i], TreeIndices[i]) };
+			const size_t size = TreeIndices[i].size()*sizeof(u16);
+			success = file->write(chunkHeader, sizeof(chunkHeader)) == sizeof(chunkHeader) &&
+				file->write(TreeIndices[i].const_pointer(), size) == size;
+		}
+
+		return success && Root->write(file);
 	}
 
 	//! returns all ids of polygons partially or fully enclosed
 	//! by this bounding box.
 	void calculatePolys(const core::aabbox3d<f32>& box)
 	{
+		// the visible nodes only change when the box changes
+		if (LastQuery == EQ_BOX && box == LastBox)
+			return;
+		LastQuery = EQ_BOX;
+		LastBox = box;
+
 		for (u32 i=0; i!=IndexDataCount; ++i)
-			IndexData[i].CurrentSize = 0;
+			NewRanges[i].set_used(0);
 
-		Root->getPolys(box, IndexData, 0);
+		Root->getRanges(box, NewRanges, 0);
+		updateIndexData();
 	}
 
 	//! returns all ids of polygons partially or fully enclosed
 	//! by a view frustum.
 	void calculatePolys(const scene::SViewFrustum& frustum)
 	{
+		// the visible nodes only change when the planes change
+		if (LastQuery == EQ_FRUSTUM)
+		{
+			u32 i;
+			for (i=0; i!=scene::SViewFrustum::VF_PLANE_COUNT; ++i)
+				if (!(frustum.planes[i] == LastPlanes[i]))
+					break;
+			if (i == scene::SViewFrustum::VF_PLANE_COUNT)
+				return;
+		}
+		LastQuery = EQ_FRUSTUM;
+		for (u32 p=0; p!=scene::SViewFrustum::VF_PLANE_COUNT; ++p)
+			LastPlanes[p] = frustum.planes[p];
+
 		for (u32 i=0; i!=IndexDataCount; ++i)
-			IndexData[i].CurrentSize = 0;
+			NewRanges[i].set_used(0);
 
-		Root->getPolys(frustum, IndexData, 0);
+		Root->getRanges(frustum, NewRanges, 0);
+		updateIndexData();
 	}
 
 	const SIndexData* getIndexData() const
@@ -115,6 +210,13 @@ public:
 		return IndexDataCount;
 	}
 
+	//! Returns the indices of a mesh chunk sorted by tree node
+	/** The indices of each node and its children form one range. */
+	const core::array<u16>& getTreeIndices(u32 chunk) const
+	{
+		return TreeIndices[chunk];
+	}
+
 	u32 getNodeCount() const
 	{
 		return NodeCount;
@@ -138,6 +240,133 @@ public:
 	}
 
 private:
+
+	enum
+	{
+		FILE_MAGIC = MAKE_IRR_ID('O','C','T','R'),
+		FILE_VERSION = 1
+	};
+
+	struct SFileHeader
+	{
+		u32 Magic;
+		u32 Version;
+		u32 ChunkCount;
+		u32 NodeCount;
+	};
+
+	//! Indices of a mesh chunk drawn together
+	struct SIndexRange
+	{
+		SIndexRange(u32 first, u32 count) : First(first), Count(count) {}
+
+		bool operator==(const SIndexRange& other) const
+		{
+			return First == other.First && Count == other.Count;
+		}
+
+		u32 First;
+		u32 Count;
+	};
+
+	//! Indices of one mesh chunk in a tree node
+	struct SNodeRange
+	{
+		//! first index of the node in the sorted indices
+		u32 First;
+		//! number of indices of the node itself
+		u32 Count;
+		//! number of indices of the node and all its children
+		u32 TotalCount;
+	};
+
+	//! Kind of the last visibility query
+	enum E_QUERY
+	{
+		EQ_NONE,
+		EQ_BOX,
+		EQ_FRUSTUM
+	};
+
+	//! Constructor for read()
+	Octree(u32 chunkCount) :
+		Root(0), IndexData(0), IndexDataCount(chunkCount), NodeCount(0)
+	{
+	}
+
+	//! Allocates the index data for the meshes
+	void init(const core::array<SMeshChunk>& meshes)
+	{
+		IndexData = new SIndexData[IndexDataCount];
+		TreeIndices.reallocate(IndexDataCount);
+		VisibleRanges.reallocate(IndexDataCount);
+		NewRanges.reallocate(IndexDataCount);
+		for (u32 i=0; i!=IndexDataCount; ++i)
+		{
+			IndexData[i].CurrentSize = 0;
+			IndexData[i].MaxSize = meshes[i].Indices.size();
+			IndexData[i].Indices = new u16[IndexData[i].MaxSize];
+			IndexData[i].ChangedID = 0;
+
+			TreeIndices.push_back(core::array<u16>());
+			TreeIndices.getLast().reallocate(meshes[i].Indices.size());
+			VisibleRanges.push_back(core::array<SIndexRange>());
+			NewRanges.push_back(core::array<SIndexRange>());
+		}
+		LastQuery = EQ_NONE;
+	}
+
+	//! Copies the indices of the visible nodes, if they changed since the last query
+	/** The ranges could be drawn from TreeIndices directly, but that would
+	need one draw call per range. The copy keeps one draw call per chunk, and
+	only the ranges after the first changed one are copied. */
+	void updateIndexData()
+	{
+		for (u32 i=0; i!=IndexDataCount; ++i)
+		{
+			const core::array<SIndexRange>& ranges = NewRanges[i];
+			core::array<SIndexRange>& visible = VisibleRanges[i];
+
+			// the indices of the ranges which didn't change are kept
+			const u32 common = core::min_(ranges.size(), visible.size());
+			u32 r = 0;
+			s32 size = 0;
+			while (r < common && ranges[r] == visible[r])
+				size += ranges[r++].Count;
+			if (r == ranges.size() && r == visible.size())
+				continue;
+
+			SIndexData& data = IndexData[i];
+			for (; r<ranges.size(); ++r)
+			{
+				memcpy(data.Indices + size, TreeIndices[i].const_pointer() + ranges[r].First,
+					ranges[r].Count * sizeof(u16));
+				size += ranges[r].Count;
+			}
+			data.CurrentSize = size;
+			++data.ChangedID;
+			visible.swap(NewRanges[i]);
+		}
+	}
+
+	//! Checksum of the vertex positions and triangles of a mesh chunk
+	/** The order of the triangles doesn't change the checksum. */
+	static u32 getHash(const SMeshChunk& mesh, const core::array<u16>& indices)
+	{
+		u32 hash = 0;
+		for (u32 i=0; i+2<indices.size(); i+=3)
+		{
+			const u32 t = indices[i]*0x9E3779B1u ^ indices[i+1]*0x85EBCA77u ^ indices[i+2]*0xC2B2AE3Du;
+			hash += t ^ (t >> 15);
+		}
+		for (u32 v=0; v<mesh.Vertices.size(); ++v)
+		{
+			core::vector3df pos = mesh.Vertices[v].Pos;
+			hash = ((hash*31 + IR(pos.X))*31 + IR(pos.Y))*31 + IR(pos.Z);
+		}
+		return hash;
+	}
+
 	// private inner class
 	class OctreeNode
 	{
@@ -253,6 +482,60 @@ private:
 			IndexData = indices;
 		}
 
+		// constructor, reads a node written by write()
+		OctreeNode(u32& nodeCount, u32 currentdepth, io::IReadFile* file,
+			const core::array< core::array<u16> >& treeIndices,
+			u32 maxNodeCount, bool& valid) : IndexData(0),
+			Depth(currentdepth+1)
+		{
+			++nodeCount;
+
+			u32 i;
+			for (i=0; i!=8; ++i)
+				Children[i] = 0;
+
+			f32 box[6];
+			u32 childMask = 0;
+			Ranges.set_used(treeIndices.size());
+			const size_t size = Ranges.size()*sizeof(SNodeRange);
+			valid = file->read(box, sizeof(box)) == sizeof(box) &&
+				file->read(&childMask, sizeof(childMask)) == sizeof(childMask) &&
+				file->read(Ranges.pointer(), size) == size;
+			if (!valid)
+				return;
+
+			Box.MinEdge.set(box[0], box[1], box[2]);
+			Box.MaxEdge.set(box[3], box[4], box[5]);
+
+			for (i=0; valid && i<Ranges.size(); ++i)
+			{
+				const SNodeRange& r = Ranges[i];
+				valid = r.Count <= r.TotalCount && r.First <= treeIndices[i].size() &&
+					r.TotalCount <= treeIndices[i].size() - r.First;
+			}
+
+			for (u32 ch=0; valid && ch!=8; ++ch)
+			{
+				if (!(childMask & (1<<ch)))
+					continue;
+				if (nodeCount >= maxNodeCount)
+				{
+					valid = false;
+					break;
+				}
+
+				Children[ch] = new OctreeNode(nodeCount, Depth, file, treeIndices, maxNodeCount, valid);
+
+				// the indices of the children must be inside the range of this node
+				for (i=0; valid && i<Ranges.size(); ++i)
+				{
+					const SNodeRange& r = Children[ch]->Ranges[i];
+					valid = r.First >= Ranges[i].First &&
+						r.First + r.TotalCount <= Ranges[i].First + Ranges[i].TotalCount;
+				}
+			}
+		}
+
 		// destructor
 		~OctreeNode()
 		{
@@ -262,9 +545,64 @@ private:
 				delete Children[i];
 		}
 
-		// returns all ids of polygons partially or full enclosed
+		// stores the indices of this node followed by those of all children
+		void sortIndices(core::array< core::array<u16> >& treeIndices)
+		{
+			const u32 cnt = treeIndices.size();
+			u32 i;
+
+			Ranges.set_used(cnt);
+			for (i=0; i!=cnt; ++i)
+			{
+				core::array<u16>& target = treeIndices[i];
+				Ranges[i].First = target.size();
+				Ranges[i].Count = IndexData ? (*IndexData)[i].Indices.size() : 0;
+				if (Ranges[i].Count)
+				{
+					target.set_used(Ranges[i].First + Ranges[i].Count);
+					memcpy(&target[Ranges[i].First], (*IndexData)[i].Indices.const_pointer(),
+						Ranges[i].Count * sizeof(u16));
+				}
+			}
+
+			for (i=0; i!=8; ++i)
+				if (Children[i])
+					Children[i]->sortIndices(treeIndices);
+
+			for (i=0; i!=cnt; ++i)
+				Ranges[i].TotalCount = treeIndices[i].size() - Ranges[i].First;
+
+			// only the ranges are needed from now on
+			delete IndexData;
+			IndexData = 0;
+		}
+
+		// writes this node and all children
+		bool write(io::IWriteFile* file) const
+		{
+			const f32 box[6] = { Box.MinEdge.X, Box.MinEdge.Y, Box.MinEdge.Z,
+				Box.MaxEdge.X, Box.MaxEdge.Y, Box.MaxEdge.Z };
+			u32 childMask = 0;
+			u32 i;
+			for (i=0; i!=8; ++i)
+				if (Children[i])
+					childMask |= 1<<i;
+
+			const size_t size = Ranges.size()*sizeof(SNodeRange);
+			if (file->write(box, sizeof(box)) != sizeof(box) ||
+				file->write(&childMask, sizeof(childMask)) != sizeof(childMask) ||
+				file->write(Ranges.const_pointer(), size) != size)
+				return false;
+
+			for (i=0; i!=8; ++i)
+				if (Children[i] && !Children[i]->write(file))
+					return false;
+			return true;
+		}
+
+		// collects the index ranges of polygons partially or full enclosed
 		// by this bounding box.
-		void getPolys(const core::aabbox3d<f32>& box, SIndexData* idxdata, u32 parentTest ) const
+		void getRanges(const core::aabbox3d<f32>& box, core::array< core::array<SIndexRange> >& ranges, u32 parentTest) const
 		{
 #if defined (OCTREE_PARENTTEST )
 			// if not full inside
@@ -277,34 +615,27 @@ private:
 				// fully inside ?
 				parentTest = Box.isFullInside(box)?2:1;
 			}
+
+			// all children are inside, too
+			if ( parentTest == 2 )
+			{
+				addRanges(ranges, true);
+				return;
+			}
 #else
-			if (Box.intersectsWithBox(box))
+			if (!Box.intersectsWithBox(box))
+				return;
 #endif
-			{
-				const u32 cnt = IndexData->size();
-				u32 i; // new ISO for scoping problem in some compilers
-
-				for (i=0; i<cnt; ++i)
-				{
-					const s32 idxcnt = (*IndexData)[i].Indices.size();
-
-					if (idxcnt)
-					{
-						memcpy(&idxdata[i].Indices[idxdata[i].CurrentSize],
-							&(*IndexData)[i].Indices[0], idxcnt * sizeof(s16));
-						idxdata[i].CurrentSize += idxcnt;
-					}
-				}
+			addRanges(ranges, false);
 
-				for (i=0; i!=8; ++i)
-					if (Children[i])
-						Children[i]->getPolys(box, idxdata,parentTest);
-			}
+			for (u32 i=0; i!=8; ++i)
+				if (Children[i])
+					Children[i]->getRanges(box, ranges, parentTest);
 		}
 
-		// returns all ids of polygons partially or full enclosed
+		// collects the index ranges of polygons partially or full enclosed
 		// by the view frustum.
-		void getPolys(const scene::SViewFrustum& frustum, SIndexData* idxdata,u32 parentTest) const
+		void getRanges(const scene::SViewFrustum& frustum, core::array< core::array<SIndexRange> >& ranges, u32 parentTest) const
 		{
 			u32 i; // new ISO for scoping problem in some compilers
 
@@ -328,24 +659,19 @@ private:
 				}
 			}
 
-
-			const u32 cnt = IndexData->size();
-
-			for (i=0; i!=cnt; ++i)
+#if defined (OCTREE_PARENTTEST )
+			// all children are inside, too
+			if ( parentTest == 2 )
 			{
-				s32 idxcnt = (*IndexData)[i].Indices.size();
-
-				if (idxcnt)
-				{
-					memcpy(&idxdata[i].Indices[idxdata[i].CurrentSize],
-						&(*IndexData)[i].Indices[0], idxcnt * sizeof(s16));
-					idxdata[i].CurrentSize += idxcnt;
-				}
+				addRanges(ranges, true);
+				return;
 			}
+#endif
+			addRanges(ranges, false);
 
 			for (i=0; i!=8; ++i)
 				if (Children[i])
-					Children[i]->getPolys(frustum, idxdata,parentTest);
+					Children[i]->getRanges(frustum, ranges, parentTest);
 		}
 
 		//! for debug purposes only, collects the bounding boxes of the node
@@ -364,8 +690,28 @@ private:
 
 	private:
 
+		// adds the indices of this node, or of this node and all children
+		void addRanges(core::array< core::array<SIndexRange> >& ranges, bool withChildren) const
+		{
+			for (u32 i=0; i!=Ranges.size(); ++i)
+			{
+				const u32 count = withChildren ? Ranges[i].TotalCount : Ranges[i].Count;
+				if (!count)
+					continue;
+
+				// neighboring nodes are drawn as one range
+				core::array<SIndexRange>& r = ranges[i];
+				if (!r.empty() && r.getLast().First + r.getLast().Count == Ranges[i].First)
+					r.getLast().Count += count;
+				else
+					r.push_back(SIndexRange(Ranges[i].First, count));
+			}
+		}
+
 		core::aabbox3df Box;
+		// own indices while the tree is built
 		core::array<SIndexChunk>* IndexData;
+		core::array<SNodeRange> Ranges;
 		OctreeNode* Children[8];
 		u32 Depth;
 	};
@@ -374,6 +720,16 @@ private:
 	SIndexData* IndexData;
 	u32 IndexDataCount;
 	u32 NodeCount;
+
+	// indices of each chunk sorted by node
+	core::array< core::array<u16> > TreeIndices;
+	// index ranges of the last query, and of the current one
+	core::array< core::array<SIndexRange> > VisibleRanges;
+	core::array< core::array<SIndexRange> > NewRanges;
+
+	E_QUERY LastQuery;
+	core::aabbox3df LastBox;
+	core::plane3df LastPlanes[scene::SViewFrustum::VF_PLANE_COUNT];
 };
 
 } // end namespace
@@ -532,6 +532,10 @@ struct SCacheInfo
 
 #define VERTEXCACHE_ELEMENT	16
 #define VERTEXCACHE_MISS 0xFFFFFFFF
+
+// internal vertex types of the vertex cache, following the E_VERTEX_TYPE values
+#define VERTEXCACHE_REFLECTION_2_LAYER	5
+#define VERTEXCACHE_SHADOW	6
 struct SVertexCache
 {
 	SVertexCache (): mem ( VERTEXCACHE_ELEMENT * 2, 128 ) {}
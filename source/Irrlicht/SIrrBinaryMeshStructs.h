@@ -0,0 +1,125 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+// Binary Irrlicht mesh format (.irrbmesh)
+// All values are stored little endian. The file starts with a
+// SIrrBinaryMeshHeader, followed by the material table, the buffer table
+// (one SIrrBinaryMeshBuffer per mesh buffer), the optional joints of
+// skinned meshes and finally the vertex and index blobs. Blobs are stored
+// in the memory layout of the engine's vertex structures and start at
+// offsets aligned to IRR_BINARY_MESH_ALIGNMENT, so they can be used in
+// place when the file is mapped into memory.
+//
+// Strings are stored as u32 length followed by the characters.
+// Material: string material renderer name, u32 ambient, diffuse, emissive
+// and specular color, f32 shininess, material parameter, material
+// parameter 2, thickness and blend factor, u8 zbuffer, anti aliasing,
+// color mask, color material, blend operation, polygon offset factor,
+// polygon offset direction and zwrite fine control, u16 E_IRR_BINARY_MATERIAL_FLAGS,
+// u8 number of texture layers and for each layer string texture name
+// (relative to the mesh file), u8 wrap u, wrap v, wrap w,
+// E_IRR_BINARY_LAYER_FLAGS, anisotropic filter and s8 lod bias, followed
+// by 16 f32 texture matrix values if EIBLF_TEXTURE_MATRIX is set.
+// Joint: string name, 16 f32 local matrix, 16 f32 global inversed matrix,
+// u32 child count and indices, u32 attached mesh count and indices,
+// u32 position key count and keys (f32 frame, 3 f32 position), u32 scale
+// key count and keys (f32 frame, 3 f32 scale), u32 rotation key count and
+// keys (f32 frame, 4 f32 quaternion), u32 weight count and weights (u16
+// buffer, u16 unused, u32 vertex, f32 strength).
+
+#ifndef __S_IRR_BINARY_MESH_STRUCTS_H_INCLUDED__
+#define __S_IRR_BINARY_MESH_STRUCTS_H_INCLUDED__
+
+#include "irrTypes.h"
+
+namespace irr
+{
+namespace scene
+{
+
+	//! First four bytes of each .irrbmesh file
+	const u32 IRR_BINARY_MESH_MAGIC = MAKE_IRR_ID('I','R','B','M');
+
+	//! Version of the file layout, changes whenever the layout changes
+	const u16 IRR_BINARY_MESH_VERSION = 1;
+
+	//! Alignment of vertex and index blobs relative to the file start
+	const u32 IRR_BINARY_MESH_ALIGNMENT = 16;
+
+	//! Flags of SIrrBinaryMeshHeader
+	enum E_IRR_BINARY_MESH_FLAGS
+	{
+		//! File contains joints, mesh is loaded as skinned mesh
+		EIBMF_SKINNED = 0x1
+	};
+
+	//! Flags of the boolean material values
+	enum E_IRR_BINARY_MATERIAL_FLAGS
+	{
+		EIBMTF_WIREFRAME = 0x1,
+		EIBMTF_POINTCLOUD = 0x2,
+		EIBMTF_GOURAUD_SHADING = 0x4,
+		EIBMTF_LIGHTING = 0x8,
+		EIBMTF_ZWRITE_ENABLE = 0x10,
+		EIBMTF_BACK_FACE_CULLING = 0x20,
+		EIBMTF_FRONT_FACE_CULLING = 0x40,
+		EIBMTF_FOG_ENABLE = 0x80,
+		EIBMTF_NORMALIZE_NORMALS = 0x100,
+		EIBMTF_USE_MIP_MAPS = 0x200
+	};
+
+	//! Flags of the texture layers
+	enum E_IRR_BINARY_LAYER_FLAGS
+	{
+		EIBLF_BILINEAR_FILTER = 0x1,
+		EIBLF_TRILINEAR_FILTER = 0x2,
+		EIBLF_TEXTURE_MATRIX = 0x4
+	};
+
+// byte-align structures
+#include "irrpack.h"
+
+	//! File header
+	struct SIrrBinaryMeshHeader
+	{
+		u32 Magic;
+		u16 Version;
+		u16 Flags;
+		u32 MaterialCount;
+		u32 MaterialOffset;
+		u32 BufferCount;
+		u32 BufferOffset;
+		u32 JointCount;
+		u32 JointOffset;
+		f32 AnimationSpeed;
+		f32 BoundingBox[6];
+		u32 Reserved;
+	} PACK_STRUCT;
+
+	//! Entry of the buffer table
+	struct SIrrBinaryMeshBuffer
+	{
+		u32 MaterialIndex;
+		u8 VertexType;
+		u8 IndexType;
+		u8 PrimitiveType;
+		//! vertex hint in the lower, index hint in the upper four bits
+		u8 HardwareMappingHints;
+		u32 VertexCount;
+		u32 VertexOffset;
+		u32 IndexCount;
+		u32 IndexOffset;
+		f32 BoundingBox[6];
+		f32 QuantizationOffset[3];
+		f32 QuantizationScale[3];
+	} PACK_STRUCT;
+
+// Default alignment
+#include "irrunpack.h"
+
+} // end namespace scene
+} // end namespace irr
+
+#endif
+
@@ -0,0 +1,81 @@
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#include "testUtils.h"
+
+using namespace irr;
+using namespace core;
+using namespace scene;
+
+namespace
+{
+
+// Mesh buffers whose vertices move between two frames need a new vertex
+// change id, shadow volumes and hardware buffers are only updated then.
+bool frameChangesVertices(ISceneManager* smgr, const char* filename, s32 frameA, s32 frameB)
+{
+	IAnimatedMesh* mesh = smgr->getMesh(filename);
+	if (!mesh)
+	{
+		logTestString("Could not load %s.\n", filename);
+		return false;
+	}
+
+	IMesh* frame = mesh->getMesh(frameA);
+	array<u32> changedIDs;
+	array<vector3df> positions;
+	u32 i;
+	for (i=0; i<frame->getMeshBufferCount(); ++i)
+	{
+		const IMeshBuffer* buffer = frame->getMeshBuffer(i);
+		changedIDs.push_back(buffer->getChangedID_Vertex());
+		for (u32 j=0; j<buffer->getVertexCount(); ++j)
+			positions.push_back(buffer->getPosition(j));
+	}
+
+	frame = mesh->getMesh(frameB);
+	bool result = frame->getMeshBufferCount() == changedIDs.size();
+	u32 movedBuffers = 0;
+	u32 v = 0;
+	for (i=0; result && i<changedIDs.size(); ++i)
+	{
+		const IMeshBuffer* buffer = frame->getMeshBuffer(i);
+		bool moved = false;
+		for (u32 j=0; j<buffer->getVertexCount() && v<positions.size(); ++j, ++v)
+			moved |= !buffer->getPosition(j).equals(positions[v]);
+		if (moved)
+		{
+			++movedBuffers;
+			result &= buffer->getChangedID_Vertex() != changedIDs[i];
+		}
+	}
+	result &= v == positions.size();
+	result &= movedBuffers > 0;
+
+	logTestString("%s: %u of %u buffers moved.\n", filename, movedBuffers, changedIDs.size());
+	if (!result)
+		logTestString("Vertices of %s changed without a new change id.\n", filename);
+	return result;
+}
+
+}
+
+bool animatedMeshUpdates(void)
+{
+	IrrlichtDevice* device = createDevice(video::EDT_NULL, dimension2d<u32>(160, 120));
+	assert_log(device);
+	if (!device)
+		return false;
+
+	ISceneManager* smgr = device->getSceneManager();
+
+	bool result = frameChangesVertices(smgr, "../media/yodan.mdl", 0, 10);
+	result &= frameChangesVertices(smgr, "./media/sydney.md2", 0, 2000);
+
+	device->closeDevice();
+	device->run();
+	device->drop();
+
+	assert_log(result);
+	return result;
+}
@@ -0,0 +1,183 @@
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#include "testUtils.h"
+
+using namespace irr;
+using namespace core;
+using namespace scene;
+using namespace video;
+
+namespace
+{
+
+// Returns an index of a mesh buffer with 16 or 32 bit indices
+u32 getIndex(const IMeshBuffer* mb, u32 i)
+{
+	if (mb->getIndexType() == EIT_32BIT)
+		return ((const u32*)mb->getIndices())[i];
+	return mb->getIndices()[i];
+}
+
+// Sums up the area and the area weighted centers of the triangles of a mesh buffer
+void getTriangleSums(const IMeshBuffer* mb, f32& area, vector3df& center)
+{
+	area = 0.f;
+	center.set(0.f, 0.f, 0.f);
+	for (u32 i=0; i+2<mb->getIndexCount(); i+=3)
+	{
+		const triangle3df t(mb->getPosition(getIndex(mb, i)),
+			mb->getPosition(getIndex(mb, i+1)), mb->getPosition(getIndex(mb, i+2)));
+		const f32 a = t.getArea();
+		area += a;
+		center += (t.pointA + t.pointB + t.pointC) * (a / 3.f);
+	}
+}
+
+// Clusters cover all triangles, respect the limits and bound their triangles
+bool clusterSphere(IrrlichtDevice* device)
+{
+	ISceneManager* smgr = device->getSceneManager();
+	IMesh* sphere = smgr->getGeometryCreator()->createSphereMesh(10.f, 48, 48);
+	array<SMeshCluster> clusters;
+	IMesh* mesh = smgr->getMeshManipulator()->createClusteredMesh(sphere, clusters, 64, 124);
+
+	const IMeshBuffer* original = sphere->getMeshBuffer(0);
+	const IMeshBuffer* mb = mesh->getMeshBuffer(0);
+	bool result = mesh->getMeshBufferCount() == 1;
+	result &= mb->getIndexCount() == original->getIndexCount();
+	result &= clusters.size() >= mb->getIndexCount()/3/124;
+
+	f32 areaA, areaB;
+	vector3df centerA, centerB;
+	getTriangleSums(original, areaA, centerA);
+	getTriangleSums(mb, areaB, centerB);
+	result &= equals(areaA, areaB, areaA*0.0001f) && (centerA/areaA).equals(centerB/areaB, 0.001f);
+
+	u32 nextIndex = 0;
+	u32 cones = 0;
+	array<u32> vertices;
+	for (u32 c=0; result && c<clusters.size(); ++c)
+	{
+		const SMeshCluster& cluster = clusters[c];
+		result &= cluster.MeshBuffer == 0 && cluster.FirstIndex == nextIndex;
+		result &= cluster.TriangleCount > 0 && cluster.TriangleCount <= 124;
+		nextIndex += cluster.TriangleCount*3;
+
+		vertices.set_used(0);
+		for (u32 i=cluster.FirstIndex; i<nextIndex; ++i)
+		{
+			const u32 index = getIndex(mb, i);
+			if (vertices.linear_search(index) == -1)
+				vertices.push_back(index);
+			result &= mb->getPosition(index).getDistanceFrom(cluster.Center) <= cluster.Radius + 0.001f;
+		}
+		result &= vertices.size() == cluster.VertexCount && vertices.size() <= 64;
+
+		// all normals are inside the cone
+		if (cluster.ConeCutoff < 1.f)
+		{
+			++cones;
+			const f32 minDot = sqrtf(1.f - cluster.ConeCutoff*cluster.ConeCutoff);
+			for (u32 i=cluster.FirstIndex; i<nextIndex; i+=3)
+			{
+				const triangle3df t(mb->getPosition(getIndex(mb, i)),
+					mb->getPosition(getIndex(mb, i+1)), mb->getPosition(getIndex(mb, i+2)));
+				// the poles have degenerated triangles
+				if (t.getArea() > 0.0001f)
+					result &= t.getNormal().normalize().dotProduct(cluster.ConeAxis) >= minDot - 0.001f;
+			}
+		}
+	}
+	result &= nextIndex == mb->getIndexCount();
+	logTestString("%u clusters, %u with normal cones.\n", clusters.size(), cones);
+	result &= cones > clusters.size()/2;
+
+	mesh->drop();
+	sphere->drop();
+
+	assert_log(result);
+	return result;
+}
+
+// Draws the scene and returns the number of triangles drawn
+u32 drawScene(IrrlichtDevice* device)
+{
+	device->getVideoDriver()->beginScene(true, true, SColor(255,0,0,0));
+	device->getSceneManager()->drawAll();
+	device->getVideoDriver()->endScene();
+	return device->getVideoDriver()->getPrimitiveCountDrawn();
+}
+
+// Clusters facing away from the camera and outside of the frustum are skipped
+bool cullClusters(IrrlichtDevice* device)
+{
+	ISceneManager* smgr = device->getSceneManager();
+
+	IMesh* sphere = smgr->getGeometryCreator()->createSphereMesh(10.f, 48, 48);
+	IClusteredMeshSceneNode* node = smgr->addClusteredMeshSceneNode(sphere, 0, -1, vector3df(0.f, 0.f, 0.f));
+	sphere->drop();
+	const u32 triangleCount = node->getMesh()->getMeshBuffer(0)->getIndexCount()/3;
+
+	// the back of the sphere is not drawn
+	ICameraSceneNode* camera = smgr->addCameraSceneNode(0, vector3df(0.f, 0.f, -40.f), vector3df(0.f, 0.f, 0.f));
+	u32 drawn = drawScene(device);
+	logTestString("Sphere: %u of %u triangles drawn.\n", drawn, triangleCount);
+	bool result = drawn == node->getVisibleTriangleCount();
+	result &= drawn > triangleCount/3 && drawn < triangleCount*3/4;
+
+	// unless backface culling is disabled
+	node->getMaterial(0).BackfaceCulling = false;
+	result &= drawScene(device) == triangleCount;
+	result &= node->getVisibleClusterCount() == node->getClusters().size();
+	node->remove();
+
+	// a scaled plane seen from above with a short far plane, and from below
+	IMesh* plane = smgr->getGeometryCreator()->createPlaneMesh(dimension2df(1.f, 1.f), dimension2du(64, 64));
+	node = smgr->addClusteredMeshSceneNode(plane, 0, -1, vector3df(0.f, 0.f, 0.f),
+		vector3df(0.f, 0.f, 0.f), vector3df(2.f, 1.f, 2.f));
+	plane->drop();
+	camera->setPosition(vector3df(-60.f, 5.f, -60.f));
+	camera->setTarget(vector3df(-50.f, 0.f, -50.f));
+	camera->setFarValue(30.f);
+
+	drawn = drawScene(device);
+	logTestString("Plane corner: %u of %u triangles drawn.\n", drawn, 64*64*2);
+	result &= drawn > 0 && drawn < 64*64*2/4;
+	result &= drawn == node->getVisibleTriangleCount();
+
+	camera->setPosition(vector3df(-60.f, -5.f, -60.f));
+	drawn = drawScene(device);
+	result &= drawn == 0;
+
+	// a clone shares the clusters
+	ISceneNode* clone = node->clone();
+	result &= clone->getType() == ESNT_CLUSTERED_MESH;
+	result &= ((IClusteredMeshSceneNode*)clone)->getClusters().size() == node->getClusters().size();
+	clone->remove();
+
+	camera->remove();
+	node->remove();
+
+	assert_log(result);
+	return result;
+}
+
+} // end anonymous namespace
+
+bool clusteredMesh(void)
+{
+	IrrlichtDevice * device = irr::createDevice(video::EDT_NULL, dimension2d<u32>(160, 120));
+	assert_log(device);
+	if (!device)
+		return false;
+
+	bool result = clusterSphere(device);
+	result &= cullClusters(device);
+
+	device->closeDevice();
+	device->run();
+	device->drop();
+
+	return result;
+}
@@ -0,0 +1,270 @@
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#include "testUtils.h"
+#include <stdio.h>
+
+using namespace irr;
+using namespace core;
+using namespace scene;
+using namespace video;
+
+namespace
+{
+
+const s32 MaxFileSize = 8*1024*1024;
+
+// Quantized vertices with 32 bit indices, which the engine only creates when loading
+class CQuantizedMeshBuffer32 : public SMeshBufferQuantized
+{
+public:
+	virtual E_INDEX_TYPE getIndexType() const { return EIT_32BIT; }
+	virtual const u16* getIndices() const { return (const u16*)Indices32.const_pointer(); }
+	virtual u16* getIndices() { return (u16*)Indices32.pointer(); }
+	virtual u32 getIndexCount() const { return Indices32.size(); }
+
+	array<u32> Indices32;
+};
+
+// Writes a mesh into memory and loads it again
+IAnimatedMesh* writeAndLoad(IrrlichtDevice* device, IMesh* mesh, const io::path& filename, array<c8>& memory)
+{
+	memory.set_used(MaxFileSize);
+	io::IWriteFile* writeFile = device->getFileSystem()->createMemoryWriteFile(memory.pointer(), memory.size(), filename);
+	IMeshWriter* writer = device->getSceneManager()->createMeshWriter(EMWT_IRR_BINARY_MESH);
+	const bool written = writer && writer->writeMesh(writeFile, mesh);
+	const long size = writeFile->getPos();
+	if (writer)
+		writer->drop();
+	writeFile->drop();
+	if (!written)
+		return 0;
+
+	io::IReadFile* readFile = device->getFileSystem()->createMemoryReadFile(memory.const_pointer(), size, filename);
+	IAnimatedMesh* result = device->getSceneManager()->getMesh(readFile);
+	readFile->drop();
+	return result;
+}
+
+// Compares the geometry of two buffers byte by byte
+bool equalBuffers(const IMeshBuffer* a, const IMeshBuffer* b)
+{
+	if (a->getVertexType() != b->getVertexType() ||
+		a->getIndexType() != b->getIndexType() ||
+		a->getVertexCount() != b->getVertexCount() ||
+		a->getIndexCount() != b->getIndexCount() ||
+		a->getPrimitiveType() != b->getPrimitiveType() ||
+		!(a->getMaterial() == b->getMaterial()))
+		return false;
+
+	const u32 vertexSize = a->getVertexCount() * getVertexPitchFromType(a->getVertexType());
+	const u32 indexSize = a->getIndexCount() * (a->getIndexType() == EIT_32BIT ? 4 : 2);
+	if (memcmp(a->getVertices(), b->getVertices(), vertexSize) ||
+		memcmp(a->getIndices(), b->getIndices(), indexSize))
+		return false;
+
+	const SVertexQuantization qa = a->getVertexQuantization();
+	const SVertexQuantization qb = b->getVertexQuantization();
+	return qa.Offset == qb.Offset && qa.Scale == qb.Scale &&
+		a->getBoundingBox() == b->getBoundingBox();
+}
+
+// Creates a mesh with standard, quantized and 32 bit indexed buffers, and with both
+SMesh* createTestMesh(IrrlichtDevice* device)
+{
+	ISceneManager* smgr = device->getSceneManager();
+	IMesh* sphere = smgr->getGeometryCreator()->createSphereMesh(5.f, 24, 24);
+	IMesh* quantized = smgr->getMeshManipulator()->createMeshQuantized(sphere);
+
+	SMesh* mesh = new SMesh();
+	IMeshBuffer* buffer = sphere->getMeshBuffer(0);
+	SMaterial& material = buffer->getMaterial();
+	material.setTexture(0, device->getVideoDriver()->getTexture("../media/wall.bmp"));
+	material.DiffuseColor.set(255, 10, 20, 30);
+	material.MaterialType = EMT_TRANSPARENT_ALPHA_CHANNEL;
+	material.Wireframe = true;
+	material.Shininess = 12.f;
+	material.TextureLayer[0].TextureWrapU = ETC_MIRROR;
+	material.TextureLayer[0].LODBias = -3;
+	material.getTextureMatrix(0).setTextureScale(2.f, 3.f);
+	mesh->addMeshBuffer(buffer);
+	mesh->addMeshBuffer(quantized->getMeshBuffer(0));
+
+	CDynamicMeshBuffer* large = new CDynamicMeshBuffer(EVT_TANGENTS, EIT_32BIT);
+	for (u32 i=0; i<300; ++i)
+	{
+		S3DVertexTangents v;
+		v.Pos.set((f32)i, (f32)(i%7), 0.f);
+		v.Normal.set(0.f, 1.f, 0.f);
+		v.Tangent.set(1.f, 0.f, 0.f);
+		large->getVertexBuffer().push_back(v);
+		large->getIndexBuffer().push_back(299-i);
+	}
+	large->getMaterial().Lighting = false;
+	large->recalculateBoundingBox();
+	mesh->addMeshBuffer(large);
+	large->drop();
+
+	const IMeshBuffer* source = quantized->getMeshBuffer(0);
+	CQuantizedMeshBuffer32* quantized32 = new CQuantizedMeshBuffer32();
+	quantized32->Quantization = source->getVertexQuantization();
+	quantized32->append(source->getVertices(), source->getVertexCount(), 0, 0);
+	for (u32 i=0; i<source->getIndexCount(); ++i)
+		quantized32->Indices32.push_back(source->getIndices()[i]);
+	quantized32->recalculateBoundingBox();
+	mesh->addMeshBuffer(quantized32);
+	quantized32->drop();
+
+	mesh->recalculateBoundingBox();
+	sphere->drop();
+	quantized->drop();
+	return mesh;
+}
+
+// Static meshes are restored exactly from memory files
+bool staticMesh(IrrlichtDevice* device)
+{
+	SMesh* mesh = createTestMesh(device);
+	array<c8> memory;
+	IAnimatedMesh* loaded = writeAndLoad(device, mesh, "binaryMeshStatic.irrbmesh", memory);
+
+	bool result = loaded && loaded->getMeshBufferCount() == mesh->getMeshBufferCount();
+	for (u32 i=0; result && i<mesh->getMeshBufferCount(); ++i)
+		result &= equalBuffers(mesh->getMeshBuffer(i), loaded->getMeshBuffer(i));
+	result &= loaded && loaded->getBoundingBox() == mesh->getBoundingBox();
+	result &= loaded && loaded->getMeshBuffer(0)->getMaterial().getTexture(0) != 0;
+	result &= loaded && loaded->getMeshBuffer(0)->getMaterial().getTextureMatrix(0) ==
+		mesh->getMeshBuffer(0)->getMaterial().getTextureMatrix(0);
+
+	mesh->drop();
+	assert_log(result);
+	return result;
+}
+
+// Static meshes loaded from disk use the memory mapped file
+bool mappedMesh(IrrlichtDevice* device)
+{
+	const io::path filename = "binaryMeshMapped.irrbmesh";
+	SMesh* mesh = createTestMesh(device);
+	IMeshWriter* writer = device->getSceneManager()->createMeshWriter(EMWT_IRR_BINARY_MESH);
+	io::IWriteFile* file = device->getFileSystem()->createAndWriteFile(filename);
+	bool result = file && writer->writeMesh(file, mesh);
+	if (file)
+		file->drop();
+	writer->drop();
+
+	IAnimatedMesh* loaded = result ? device->getSceneManager()->getMesh(filename) : 0;
+	result &= loaded && loaded->getMeshBufferCount() == mesh->getMeshBufferCount();
+	for (u32 i=0; result && i<mesh->getMeshBufferCount(); ++i)
+		result &= equalBuffers(mesh->getMeshBuffer(i), loaded->getMeshBuffer(i));
+
+	if (result)
+	{
+		// indices follow the vertices in the file, aligned to 16 bytes
+		IMeshBuffer* buffer = loaded->getMeshBuffer(0);
+		const u32 vertexSize = buffer->getVertexCount() * sizeof(S3DVertex);
+		const u8* vertices = (const u8*)buffer->getVertices();
+		const u8* indices = (const u8*)buffer->getIndices();
+		result &= ((size_t)vertices % 16) == 0;
+		result &= indices == vertices + ((vertexSize + 15) & ~15);
+
+		// changes only affect the memory, not the file
+		buffer->getPosition(0).X += 100.f;
+		result &= buffer->getPosition(0).X == mesh->getMeshBuffer(0)->getPosition(0).X + 100.f;
+	}
+
+	if (loaded)
+		device->getSceneManager()->getMeshCache()->removeMesh(loaded);
+	remove(filename.c_str());
+
+	mesh->drop();
+	assert_log(result);
+	return result;
+}
+
+// Joints, weights and keys of skinned meshes are kept
+bool skinnedMesh(IrrlichtDevice* device)
+{
+	IAnimatedMesh* ninja = device->getSceneManager()->getMesh("../media/ninja.b3d");
+	array<c8> memory;
+	IAnimatedMesh* loaded = ninja ? writeAndLoad(device, ninja, "binaryMeshSkinned.irrbmesh", memory) : 0;
+
+	bool result = loaded && loaded->getMeshType() == EAMT_SKINNED;
+	if (!result)
+	{
+		assert_log(result);
+		return false;
+	}
+
+	ISkinnedMesh* original = (ISkinnedMesh*)ninja;
+	ISkinnedMesh* copy = (ISkinnedMesh*)loaded;
+	result &= copy->getJointCount() == original->getJointCount();
+	result &= copy->getFrameCount() == original->getFrameCount();
+	result &= copy->getAnimationSpeed() == original->getAnimationSpeed();
+	for (u32 i=0; result && i<copy->getJointCount(); ++i)
+		result &= core::stringc(copy->getJointName(i)) == original->getJointName(i);
+
+	// both meshes animate to the same positions
+	IMesh* a = ninja->getMesh(25);
+	IMesh* b = loaded->getMesh(25);
+	result &= a->getMeshBufferCount() == b->getMeshBufferCount();
+	for (u32 i=0; result && i<a->getMeshBufferCount(); ++i)
+	{
+		IMeshBuffer* ba = a->getMeshBuffer(i);
+		IMeshBuffer* bb = b->getMeshBuffer(i);
+		result &= ba->getVertexCount() == bb->getVertexCount();
+		for (u32 v=0; result && v<ba->getVertexCount(); ++v)
+			result &= ba->getPosition(v).equals(bb->getPosition(v), 0.001f);
+	}
+
+	assert_log(result);
+	return result;
+}
+
+// Files with indices out of range are rejected
+bool invalidIndices(IrrlichtDevice* device)
+{
+	SMesh* mesh = createTestMesh(device);
+	IMeshBuffer* buffer = mesh->getMeshBuffer(0);
+	buffer->getIndices()[0] = (u16)buffer->getVertexCount();
+	array<c8> memory;
+	IAnimatedMesh* loaded = writeAndLoad(device, mesh, "binaryMeshInvalidIndices.irrbmesh", memory);
+	bool result = loaded == 0;
+	mesh->drop();
+
+	// joints attached to a mesh buffer which does not exist
+	ISkinnedMesh* ninja = (ISkinnedMesh*)device->getSceneManager()->getMesh("../media/ninja.b3d");
+	result &= ninja && ninja->getJointCount() > 0;
+	if (result)
+	{
+		array<u32>& attached = ninja->getAllJoints()[0]->AttachedMeshes;
+		attached.push_back(ninja->getMeshBufferCount());
+		loaded = writeAndLoad(device, ninja, "binaryMeshInvalidJoint.irrbmesh", memory);
+		attached.erase(attached.size()-1);
+		result &= loaded == 0;
+	}
+
+	assert_log(result);
+	return result;
+}
+
+} // end anonymous namespace
+
+bool irrBinaryMesh(void)
+{
+	IrrlichtDevice * device = irr::createDevice(video::EDT_NULL, dimension2d<u32>(160, 120));
+	assert_log(device);
+	if (!device)
+		return false;
+
+	bool result = staticMesh(device);
+	result &= mappedMesh(device);
+	result &= skinnedMesh(device);
+	result &= invalidIndices(device);
+
+	device->closeDevice();
+	device->run();
+	device->drop();
+
+	return result;
+}
@@ -0,0 +1,133 @@
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#include "testUtils.h"
+#include <irrlicht.h>
+
+using namespace irr;
+using namespace core;
+
+static bool testInsertFindRemove()
+{
+	bool result = true;
+
+	hashmap<s32, s32> map;
+	result &= map.empty();
+	result &= map.find(5) == 0;
+	result &= !map.remove(5);
+
+	// enough keys to grow the table several times
+	const s32 count = 5000;
+	for (s32 i=0; i<count; ++i)
+		result &= map.insert(i*7, i);
+	result &= map.size() == (u32)count;
+	result &= !map.insert(7, 100);
+	result &= map.find(7)->getValue() == 1;
+
+	for (s32 i=0; i<count*7; ++i)
+	{
+		hashmap<s32, s32>::Node* node = map.find(i);
+		if ((i % 7) == 0)
+			result &= node && node->getKey() == i && node->getValue() == i/7;
+		else
+			result &= node == 0;
+	}
+
+	// remove every other key, the others have to be found still
+	for (s32 i=0; i<count; i+=2)
+		result &= map.remove(i*7);
+	result &= !map.remove(0);
+	result &= map.size() == (u32)count/2;
+	for (s32 i=0; i<count; ++i)
+	{
+		hashmap<s32, s32>::Node* node = map.find(i*7);
+		if (i & 1)
+			result &= node && node->getValue() == i;
+		else
+			result &= node == 0;
+	}
+
+	// all remaining entries can be reached by index
+	s32 sum = 0;
+	for (u32 i=0; i<map.size(); ++i)
+		sum += map.getNode(i).getValue();
+	result &= sum == (count/2)*(count/2);
+
+	map.set(7, 42);
+	map.set(14, 43);
+	result &= map.find(7)->getValue() == 42;
+	result &= map.find(14)->getValue() == 43;
+
+	map.clear();
+	result &= map.empty() && map.find(7) == 0;
+	result &= map.insert(7, 1) && map.size() == 1;
+
+	assert_log(result);
+	return result;
+}
+
+static bool testKeys()
+{
+	bool result = true;
+
+	hashmap<stringc, u32> strings;
+	strings.reserve(100);
+	result &= strings.insert("foo", 1);
+	result &= strings.insert("bar", 2);
+	result &= !strings.insert(stringc("foo"), 3);
+	result &= strings.find("foo") && strings.find("foo")->getValue() == 1;
+	result &= strings.find("bar") && strings.find("bar")->getValue() == 2;
+	result &= strings.find("baz") == 0;
+
+	// vertices are compared by their bytes, not with the tolerance of operator==
+	typedef hashmap<video::S3DVertex, u32, hash_bytes<video::S3DVertex>, equal_bytes<video::S3DVertex> > VertexMap;
+	VertexMap vertices;
+	const video::S3DVertex a(1.f, 2.f, 3.f, 0.f, 1.f, 0.f, video::SColor(255,255,255,255), 0.f, 1.f);
+	video::S3DVertex b(a);
+	b.Pos.X += 0.0000001f;
+	result &= vertices.insert(a, 0);
+	result &= vertices.insert(b, 1);
+	result &= vertices.find(a)->getValue() == 0;
+	result &= vertices.find(b)->getValue() == 1;
+
+	assert_log(result);
+	return result;
+}
+
+static bool testSwap()
+{
+	bool result = true;
+
+	hashmap<s32, s32> map1, map2;
+	for (s32 i=0; i<99; ++i)
+	{
+		map1.insert(i, i);
+		if (i < 10)
+			map2.insert(i, 99-i);
+	}
+	map1.swap(map2);
+
+	result &= map1.size() == 10 && map2.size() == 99;
+	result &= map1.find(3)->getValue() == 96;
+	result &= map2.find(50)->getValue() == 50;
+	result &= map1.find(50) == 0;
+
+	assert_log(result);
+	return result;
+}
+
+// Test the functionality of core::hashmap
+bool testIrrHashMap(void)
+{
+	bool success = true;
+
+	success &= testInsertFindRemove();
+	success &= testKeys();
+	success &= testSwap();
+
+	if(success)
+		logTestString("\nAll tests passed\n");
+	else
+		logTestString("\nFAIL!!!\n");
+	return success;
+}
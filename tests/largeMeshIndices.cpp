@@ -0,0 +1,189 @@
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#include "testUtils.h"
+
+using namespace irr;
+using namespace core;
+using namespace scene;
+using namespace video;
+
+namespace
+{
+
+// Vertices along each side of the grid, more than 65536 in total
+const u32 GridSize = 260;
+
+void appendLine(array<c8>& text, const c8* line)
+{
+	while (*line)
+		text.push_back(*line++);
+}
+
+// Loads a grid from an obj file in memory
+IMesh* loadGrid(IrrlichtDevice* device, const io::path& filename, u32 gridSize)
+{
+	array<c8> text;
+	c8 line[128];
+	u32 x, z;
+	for (z=0; z<gridSize; ++z)
+	{
+		for (x=0; x<gridSize; ++x)
+		{
+			snprintf_irr(line, 128, "v %u %u %u\nvt %f %f\n", x, (x*z)%7, z, x/(f32)gridSize, z/(f32)gridSize);
+			appendLine(text, line);
+		}
+	}
+	for (z=0; z+1<gridSize; ++z)
+	{
+		for (x=0; x+1<gridSize; ++x)
+		{
+			// obj indices start at 1
+			const u32 i = z*gridSize + x + 1;
+			snprintf_irr(line, 128, "f %u/%u %u/%u %u/%u %u/%u\n",
+				i, i, i+gridSize, i+gridSize, i+gridSize+1, i+gridSize+1, i+1, i+1);
+			appendLine(text, line);
+		}
+	}
+
+	io::IReadFile* file = device->getFileSystem()->createMemoryReadFile(text.const_pointer(), text.size(), filename);
+	IMesh* mesh = device->getSceneManager()->getMesh(file);
+	file->drop();
+	return mesh;
+}
+
+// Checks that all triangles of a buffer are valid grid cells
+bool checkTriangles(IMeshBuffer* mb, u32 gridSize)
+{
+	bool result = mb->getIndexCount() == (gridSize-1)*(gridSize-1)*6;
+	for (u32 i=0; result && i<mb->getIndexCount(); i+=3)
+	{
+		u32 idx[3];
+		for (u32 k=0; k<3; ++k)
+		{
+			idx[k] = mb->getIndexType() == EIT_32BIT ? ((const u32*)mb->getIndices())[i+k] : mb->getIndices()[i+k];
+			result &= idx[k] < mb->getVertexCount();
+		}
+		if (!result)
+			break;
+		const triangle3df triangle(mb->getPosition(idx[0]), mb->getPosition(idx[1]), mb->getPosition(idx[2]));
+		result &= fabsf(triangle.pointA.X - triangle.pointB.X) <= 1.f && fabsf(triangle.pointA.Z - triangle.pointB.Z) <= 1.f;
+		result &= fabsf(triangle.pointA.X - triangle.pointC.X) <= 1.f && fabsf(triangle.pointA.Z - triangle.pointC.Z) <= 1.f;
+		result &= triangle.getArea() > 0.f;
+	}
+	return result;
+}
+
+// Large obj files are loaded into a single buffer with 32 bit indices
+bool loadLargeObj(IrrlichtDevice* device)
+{
+	IMesh* mesh = loadGrid(device, "largeGrid.obj", GridSize);
+	bool result = mesh && mesh->getMeshBufferCount() == 1;
+	if (result)
+	{
+		IMeshBuffer* mb = mesh->getMeshBuffer(0);
+		logTestString("Large obj: %u vertices, %u indices with %u bits.\n", mb->getVertexCount(),
+			mb->getIndexCount(), mb->getIndexType() == EIT_32BIT ? 32 : 16);
+		result &= mb->getVertexCount() == GridSize*GridSize;
+		result &= mb->getIndexType() == EIT_32BIT;
+		result &= checkTriangles(mb, GridSize);
+	}
+
+	// small files keep 16 bit indices
+	IMesh* small = loadGrid(device, "smallGrid.obj", 16);
+	result &= small && small->getMeshBufferCount() == 1;
+	if (result)
+	{
+		result &= small->getMeshBuffer(0)->getIndexType() == EIT_16BIT;
+		result &= checkTriangles(small->getMeshBuffer(0), 16);
+	}
+
+	assert_log(result);
+	return result;
+}
+
+// Mesh manipulations keep 32 bit indices where they are needed
+bool manipulateLargeMesh(IrrlichtDevice* device)
+{
+	IMeshManipulator* manipulator = device->getSceneManager()->getMeshManipulator();
+	IMesh* mesh = device->getSceneManager()->getMeshCache()->getMeshByName("largeGrid.obj");
+	if (!mesh)
+		return false;
+
+	bool result = true;
+
+	SMesh* copy = manipulator->createMeshCopy(mesh);
+	result &= copy->getMeshBuffer(0)->getIndexType() == EIT_32BIT;
+	result &= checkTriangles(copy->getMeshBuffer(0), GridSize);
+	copy->drop();
+
+	IMesh* converted = manipulator->createMeshWithTangents(mesh);
+	result &= converted->getMeshBuffer(0)->getVertexType() == EVT_TANGENTS;
+	result &= converted->getMeshBuffer(0)->getIndexType() == EIT_32BIT;
+	result &= checkTriangles(converted->getMeshBuffer(0), GridSize);
+	converted->drop();
+
+	converted = manipulator->createMeshWith2TCoords(mesh);
+	result &= converted->getMeshBuffer(0)->getVertexType() == EVT_2TCOORDS;
+	result &= checkTriangles(converted->getMeshBuffer(0), GridSize);
+	converted->drop();
+
+	converted = manipulator->createMeshUniquePrimitives(mesh);
+	result &= converted->getMeshBuffer(0)->getVertexCount() == mesh->getMeshBuffer(0)->getIndexCount();
+	result &= checkTriangles(converted->getMeshBuffer(0), GridSize);
+	converted->drop();
+
+	converted = manipulator->createForsythOptimizedMesh(mesh);
+	result &= converted && converted->getMeshBufferCount() == 1;
+	if (result)
+	{
+		result &= checkTriangles(converted->getMeshBuffer(0), GridSize);
+		const SVertexCacheStatistics before = manipulator->getVertexCacheStatistics(mesh);
+		const SVertexCacheStatistics after = manipulator->getVertexCacheStatistics(converted);
+		logTestString("Forsyth with 32 bit indices: ACMR %.3f -> %.3f\n", before.ACMR, after.ACMR);
+		result &= after.ACMR <= before.ACMR;
+		converted->drop();
+	}
+
+	assert_log(result);
+	return result;
+}
+
+// Skinned mesh buffers switch to 32 bit indices on demand
+bool skinnedIndices()
+{
+	SSkinMeshBuffer buffer;
+	buffer.Vertices_Standard.set_used(70000);
+	buffer.addIndex(0);
+	buffer.addIndex(1);
+	buffer.addIndex(2);
+	bool result = buffer.getIndexType() == EIT_16BIT && buffer.getIndexCount() == 3;
+	buffer.addIndex(69999);
+	result &= buffer.getIndexType() == EIT_32BIT && buffer.getIndexCount() == 4;
+	result &= buffer.Indices.empty();
+	result &= ((const u32*)buffer.getIndices())[3] == 69999;
+	result &= buffer.getIndex(2) == 2;
+
+	assert_log(result);
+	return result;
+}
+
+} // end anonymous namespace
+
+bool largeMeshIndices(void)
+{
+	IrrlichtDevice * device = irr::createDevice(video::EDT_NULL, dimension2d<u32>(160, 120));
+	assert_log(device);
+	if (!device)
+		return false;
+
+	bool result = loadLargeObj(device);
+	result &= manipulateLargeMesh(device);
+	result &= skinnedIndices();
+
+	device->closeDevice();
+	device->run();
+	device->drop();
+
+	return result;
+}
@@ -54,6 +54,7 @@ int main(int argumentCount, char * arguments[])
 	// Now the simple tests without device
 	TEST(testIrrArray);
 	TEST(testIrrMap);
+	TEST(testIrrHashMap);
 	TEST(testIrrList);
 	TEST(exports);
 	TEST(irrCoreEquals);
@@ -82,6 +83,8 @@ int main(int argumentCount, char * arguments[])
 	TEST(removeCustomAnimator);
 	TEST(sceneCollisionManager);
 	TEST(sceneNodeAnimator);
+	TEST(sceneNodeAnimate);
+	TEST(sceneNodeCulling);
 	TEST(meshLoaders);
 	TEST(testTimer);
 	TEST(testCoreutil);
@@ -96,7 +99,22 @@ int main(int argumentCount, char * arguments[])
 	TEST(guiDisabledMenu);
 	TEST(makeColorKeyTexture);
 	TEST(md2Animation);
+	TEST(animatedMeshUpdates);
 	TEST(meshTransform);
+	TEST(meshWelding);
+	TEST(meshSimplification);
+	TEST(meshOptimization);
+	TEST(quantizedVertices);
+	TEST(staticBatching);
+	TEST(weldedNormals);
+	TEST(largeMeshIndices);
+	TEST(irrBinaryMesh);
+	TEST(clusteredMesh);
+	TEST(pagedTerrain);
+	TEST(particleSystem);
+	TEST(octreeSceneNode);
+	TEST(waterSurface);
+	TEST(shadowVolumeCache);
 	TEST(skinnedMesh);
 	TEST(testGeometryCreator);
 	TEST(writeImageToFile);
@@ -0,0 +1,254 @@
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#include "testUtils.h"
+
+using namespace irr;
+using namespace core;
+using namespace scene;
+using namespace video;
+
+namespace
+{
+
+u32 getIndex(IMeshBuffer* mb, u32 i)
+{
+	if (mb->getIndexType() == EIT_32BIT)
+		return ((const u32*)mb->getIndices())[i];
+	return mb->getIndices()[i];
+}
+
+// Triangle with its positions, compared independent of the first vertex
+struct STriangle
+{
+	STriangle(const vector3df& a, const vector3df& b, const vector3df& c)
+	{
+		// rotate the vertices so the smallest position comes first, this keeps the winding
+		const vector3df* p[3] = { &a, &b, &c };
+		u32 first = 0;
+		for (u32 i=1; i<3; ++i)
+		{
+			if (less(*p[i], *p[first]))
+				first = i;
+		}
+		for (u32 i=0; i<3; ++i)
+			Pos[i] = *p[(first+i)%3];
+	}
+
+	static bool less(const vector3df& a, const vector3df& b)
+	{
+		if (a.X != b.X)
+			return a.X < b.X;
+		if (a.Y != b.Y)
+			return a.Y < b.Y;
+		return a.Z < b.Z;
+	}
+
+	bool operator<(const STriangle& other) const
+	{
+		for (u32 i=0; i<3; ++i)
+		{
+			if (less(Pos[i], other.Pos[i]))
+				return true;
+			if (less(other.Pos[i], Pos[i]))
+				return false;
+		}
+		return false;
+	}
+
+	vector3df Pos[3];
+};
+
+void getTriangles(IMesh* mesh, array<STriangle>& triangles)
+{
+	for (u32 b=0; b<mesh->getMeshBufferCount(); ++b)
+	{
+		IMeshBuffer* mb = mesh->getMeshBuffer(b);
+		for (u32 i=0; i+2<mb->getIndexCount(); i+=3)
+		{
+			triangles.push_back(STriangle(mb->getPosition(getIndex(mb, i)),
+				mb->getPosition(getIndex(mb, i+1)), mb->getPosition(getIndex(mb, i+2))));
+		}
+	}
+	triangles.sort();
+}
+
+// Returns if both meshes consist of the same triangles
+bool sameTriangles(IMesh* a, IMesh* b)
+{
+	array<STriangle> ta, tb;
+	getTriangles(a, ta);
+	getTriangles(b, tb);
+	if (ta.size() != tb.size())
+		return false;
+	for (u32 i=0; i<ta.size(); ++i)
+	{
+		if (ta[i] < tb[i] || tb[i] < ta[i])
+			return false;
+	}
+	return true;
+}
+
+// Returns if the vertices are in the order in which the indices use them first
+bool isFetchOrdered(IMeshBuffer* mb)
+{
+	u32 next = 0;
+	for (u32 i=0; i<mb->getIndexCount(); ++i)
+	{
+		const u32 index = getIndex(mb, i);
+		if (index > next)
+			return false;
+		if (index == next)
+			++next;
+	}
+	return next == mb->getVertexCount();
+}
+
+// Creates a grid of quads with the triangles in random order, stored with 32 bit indices
+IMesh* createShuffledGrid(u32 size)
+{
+	CDynamicMeshBuffer* mb = new CDynamicMeshBuffer(EVT_STANDARD, EIT_32BIT);
+	for (u32 y=0; y<=size; ++y)
+	{
+		for (u32 x=0; x<=size; ++x)
+			mb->getVertexBuffer().push_back(S3DVertex((f32)x, 0, (f32)y, 0, 1, 0, SColor(255,255,255,255), 0, 0));
+	}
+
+	array<u32> triangles;
+	for (u32 y=0; y<size; ++y)
+	{
+		for (u32 x=0; x<size; ++x)
+		{
+			const u32 i = y*(size+1)+x;
+			triangles.push_back(i);
+			triangles.push_back(i+size+1);
+			triangles.push_back(i+1);
+			triangles.push_back(i+1);
+			triangles.push_back(i+size+1);
+			triangles.push_back(i+size+2);
+		}
+	}
+
+	// fixed seed, so each run tests the same order
+	u32 seed = 12345;
+	const u32 count = triangles.size()/3;
+	for (u32 t=count-1; t>0; --t)
+	{
+		seed = seed*1103515245 + 12345;
+		const u32 other = (seed>>8) % (t+1);
+		for (u32 k=0; k<3; ++k)
+			core::swap(triangles[t*3+k], triangles[other*3+k]);
+	}
+
+	for (u32 i=0; i<triangles.size(); ++i)
+		mb->getIndexBuffer().push_back(triangles[i]);
+	mb->recalculateBoundingBox();
+
+	SMesh* mesh = new SMesh();
+	mesh->addMeshBuffer(mb);
+	mb->drop();
+	mesh->recalculateBoundingBox();
+	return mesh;
+}
+
+// Random triangle orders are sorted for the vertex cache without losing triangles
+bool optimizeGrid(IrrlichtDevice* device)
+{
+	IMeshManipulator* manipulator = device->getSceneManager()->getMeshManipulator();
+	ITimer* timer = device->getTimer();
+
+	IMesh* grid = createShuffledGrid(64);
+	const SVertexCacheStatistics before = manipulator->getVertexCacheStatistics(grid);
+
+	u32 time = timer->getRealTime();
+	IMesh* optimized = manipulator->createOptimizedMesh(grid, 0.f);
+	time = timer->getRealTime() - time;
+	const SVertexCacheStatistics after = manipulator->getVertexCacheStatistics(optimized);
+	logTestString("Shuffled grid: ACMR %.3f -> %.3f, ATVR %.3f -> %.3f in %u ms.\n",
+		before.ACMR, after.ACMR, before.ATVR, after.ATVR, time);
+
+	bool result = before.Triangles == 64*64*2 && after.Triangles == before.Triangles;
+	result &= before.Vertices == 65*65 && after.Vertices == before.Vertices;
+	result &= after.ACMR < before.ACMR*0.5f;
+	result &= after.ACMR < 0.9f;
+	result &= sameTriangles(grid, optimized);
+
+	// few enough vertices for 16 bit indices
+	IMeshBuffer* mb = optimized->getMeshBuffer(0);
+	result &= optimized->getMeshBufferCount() == 1;
+	result &= mb->getIndexType() == EIT_16BIT;
+	result &= isFetchOrdered(mb);
+	result &= mb->getBoundingBox().MaxEdge == vector3df(64,0,64);
+
+	// sorting for overdraw only costs a little vertex cache efficiency
+	time = timer->getRealTime();
+	IMesh* overdraw = manipulator->createOptimizedMesh(grid, 1.05f);
+	time = timer->getRealTime() - time;
+	const SVertexCacheStatistics sorted = manipulator->getVertexCacheStatistics(overdraw);
+	logTestString("With overdraw sorting: ACMR %.3f in %u ms.\n", sorted.ACMR, time);
+	result &= sorted.ACMR <= after.ACMR*1.15f;
+	result &= sameTriangles(grid, overdraw);
+	result &= isFetchOrdered(overdraw->getMeshBuffer(0));
+
+	overdraw->drop();
+	optimized->drop();
+	grid->drop();
+
+	assert_log(result);
+	return result;
+}
+
+// Closed meshes keep their triangles and materials
+bool optimizeSphere(IrrlichtDevice* device)
+{
+	IMeshManipulator* manipulator = device->getSceneManager()->getMeshManipulator();
+
+	IMesh* sphere = device->getSceneManager()->getGeometryCreator()->createSphereMesh(10.f, 48, 48);
+	sphere->getMeshBuffer(0)->getMaterial().Wireframe = true;
+	const SVertexCacheStatistics before = manipulator->getVertexCacheStatistics(sphere);
+
+	IMesh* optimized = manipulator->createOptimizedMesh(sphere);
+	const SVertexCacheStatistics after = manipulator->getVertexCacheStatistics(optimized);
+	logTestString("Sphere: ACMR %.3f -> %.3f.\n", before.ACMR, after.ACMR);
+
+	bool result = after.ACMR <= before.ACMR;
+	result &= sameTriangles(sphere, optimized);
+	result &= optimized->getMeshBuffer(0)->getMaterial().Wireframe;
+	result &= isFetchOrdered(optimized->getMeshBuffer(0));
+
+	// a bigger cache never misses more often
+	result &= manipulator->getVertexCacheStatistics(optimized, 32).TransformedVertices <= after.TransformedVertices;
+
+	optimized->drop();
+	sphere->drop();
+
+	// empty meshes are no problem
+	SMesh empty;
+	result &= manipulator->getVertexCacheStatistics(&empty).ACMR == 0.f;
+	optimized = manipulator->createOptimizedMesh(&empty);
+	result &= optimized && optimized->getMeshBufferCount() == 0;
+	if (optimized)
+		optimized->drop();
+
+	assert_log(result);
+	return result;
+}
+
+} // end anonymous namespace
+
+bool meshOptimization(void)
+{
+	IrrlichtDevice * device = irr::createDevice(video::EDT_NULL, dimension2d<u32>(160, 120));
+	assert_log(device);
+	if (!device)
+		return false;
+
+	bool result = optimizeGrid(device);
+	result &= optimizeSphere(device);
+
+	device->closeDevice();
+	device->run();
+	device->drop();
+
+	return result;
+}
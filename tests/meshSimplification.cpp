@@ -0,0 +1,272 @@
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#include "testUtils.h"
+
+using namespace irr;
+using namespace core;
+using namespace scene;
+using namespace video;
+
+namespace
+{
+
+u32 getTriangleCount(IMesh* mesh)
+{
+	u32 count = 0;
+	for (u32 b=0; b<mesh->getMeshBufferCount(); ++b)
+		count += mesh->getMeshBuffer(b)->getIndexCount()/3;
+	return count;
+}
+
+// Returns if all positions used by the simplified mesh are positions of the original mesh
+bool usesOriginalVertices(IMesh* original, IMesh* simplified)
+{
+	for (u32 b=0; b<simplified->getMeshBufferCount(); ++b)
+	{
+		IMeshBuffer* mb = simplified->getMeshBuffer(b);
+		IMeshBuffer* orig = original->getMeshBuffer(b);
+		for (u32 i=0; i<mb->getVertexCount(); ++i)
+		{
+			bool found = false;
+			for (u32 j=0; j<orig->getVertexCount() && !found; ++j)
+				found = mb->getPosition(i) == orig->getPosition(j);
+			if (!found)
+				return false;
+		}
+	}
+	return true;
+}
+
+// Returns if a position is used by the triangles of a mesh buffer
+bool hasPosition(IMeshBuffer* mb, const vector3df& pos)
+{
+	for (u32 i=0; i<mb->getIndexCount(); ++i)
+	{
+		if (mb->getPosition(mb->getIndices()[i]).equals(pos, 0.0001f))
+			return true;
+	}
+	return false;
+}
+
+// A flat grid can be reduced a lot without any error, but the border must stay.
+bool simplifyPlane(IrrlichtDevice* device)
+{
+	IMeshManipulator* manipulator = device->getSceneManager()->getMeshManipulator();
+	const IGeometryCreator* geometry = device->getSceneManager()->getGeometryCreator();
+
+	IMesh* plane = geometry->createHillPlaneMesh(dimension2df(1,1), dimension2du(32,32), 0, 0.f,
+		dimension2df(0,0), dimension2df(1,1));
+	const u32 original = getTriangleCount(plane);
+
+	IMesh* simplified = manipulator->createMeshSimplified(plane, original/10, 0.f);
+	const u32 count = getTriangleCount(simplified);
+	logTestString("Flat plane: %u of %u triangles.\n", count, original);
+
+	bool result = count <= original/10 && count > 0;
+	result &= simplified->getMeshBufferCount() == plane->getMeshBufferCount();
+	result &= simplified->getBoundingBox().MinEdge.equals(plane->getBoundingBox().MinEdge);
+	result &= simplified->getBoundingBox().MaxEdge.equals(plane->getBoundingBox().MaxEdge);
+	result &= usesOriginalVertices(plane, simplified);
+
+	// all border vertices are kept, so the plane still fits to its neighbors
+	for (s32 i=0; i<=32; ++i)
+	{
+		result &= hasPosition(simplified->getMeshBuffer(0), vector3df(i-16.f, 0, -16.f));
+		result &= hasPosition(simplified->getMeshBuffer(0), vector3df(-16.f, 0, i-16.f));
+	}
+
+	// the surface must not flip over
+	IMeshBuffer* mb = simplified->getMeshBuffer(0);
+	for (u32 i=0; i<mb->getIndexCount(); i+=3)
+	{
+		const triangle3df tri(mb->getPosition(mb->getIndices()[i]), mb->getPosition(mb->getIndices()[i+1]),
+			mb->getPosition(mb->getIndices()[i+2]));
+		result &= tri.getNormal().Y > 0.f;
+	}
+
+	simplified->drop();
+	plane->drop();
+
+	assert_log(result);
+	return result;
+}
+
+// Curved surfaces are reduced until the error limit, seams are kept
+bool simplifySphere(IrrlichtDevice* device)
+{
+	IMeshManipulator* manipulator = device->getSceneManager()->getMeshManipulator();
+	const IGeometryCreator* geometry = device->getSceneManager()->getGeometryCreator();
+	ITimer* timer = device->getTimer();
+
+	IMesh* sphere = geometry->createSphereMesh(10.f, 64, 64);
+	const u32 original = getTriangleCount(sphere);
+
+	// without any error allowed only the slivers at the poles are collapsed
+	IMesh* simplified = manipulator->createMeshSimplified(sphere, 0, 0.f);
+	bool result = getTriangleCount(simplified) > original*98/100;
+	simplified->drop();
+
+	u32 time = timer->getRealTime();
+	simplified = manipulator->createMeshSimplified(sphere, original/10, 0.05f);
+	time = timer->getRealTime() - time;
+	const u32 count = getTriangleCount(simplified);
+	logTestString("Sphere: %u of %u triangles in %u ms.\n", count, original, time);
+	result &= count <= original/10+2 && count > 0;
+	result &= usesOriginalVertices(sphere, simplified);
+
+	// all triangles still face outwards, except for the slivers at the poles
+	IMeshBuffer* mb = simplified->getMeshBuffer(0);
+	for (u32 i=0; i<mb->getIndexCount(); i+=3)
+	{
+		const triangle3df tri(mb->getPosition(mb->getIndices()[i]), mb->getPosition(mb->getIndices()[i+1]),
+			mb->getPosition(mb->getIndices()[i+2]));
+		const vector3df center = (tri.pointA + tri.pointB + tri.pointC) / 3.f;
+		if (tri.getArea() > 0.001f)
+			result &= tri.getNormal().dotProduct(center) > 0.f;
+	}
+
+	// vertices at the same position, as on the texture seam, are never removed
+	IMeshBuffer* orig = sphere->getMeshBuffer(0);
+	for (u32 i=0; i<orig->getVertexCount(); ++i)
+	{
+		for (u32 j=i+1; j<orig->getVertexCount(); ++j)
+		{
+			if (orig->getPosition(i) == orig->getPosition(j))
+			{
+				result &= hasPosition(mb, orig->getPosition(i));
+				break;
+			}
+		}
+	}
+
+	// a smaller error limit stops earlier
+	IMesh* accurate = manipulator->createMeshSimplified(sphere, original/10, 0.001f);
+	result &= getTriangleCount(accurate) > count;
+	accurate->drop();
+
+	simplified->drop();
+	sphere->drop();
+
+	assert_log(result);
+	return result;
+}
+
+// Two mesh buffers with different materials keep their common border
+bool simplifyMaterialBorder(IrrlichtDevice* device)
+{
+	IMeshManipulator* manipulator = device->getSceneManager()->getMeshManipulator();
+	const IGeometryCreator* geometry = device->getSceneManager()->getGeometryCreator();
+
+	IMesh* left = geometry->createHillPlaneMesh(dimension2df(1,1), dimension2du(16,16), 0, 0.f,
+		dimension2df(0,0), dimension2df(1,1));
+	IMesh* right = geometry->createHillPlaneMesh(dimension2df(1,1), dimension2du(16,16), 0, 0.f,
+		dimension2df(0,0), dimension2df(1,1));
+	manipulator->transform(right, matrix4().setTranslation(vector3df(16,0,0)));
+
+	SMesh mesh;
+	mesh.addMeshBuffer(left->getMeshBuffer(0));
+	mesh.addMeshBuffer(right->getMeshBuffer(0));
+	mesh.getMeshBuffer(1)->getMaterial().Wireframe = true;
+	mesh.recalculateBoundingBox();
+
+	IMesh* simplified = manipulator->createMeshSimplified(&mesh, 50);
+	bool result = simplified->getMeshBufferCount() == 2;
+	result &= getTriangleCount(simplified) < getTriangleCount(&mesh);
+	result &= simplified->getMeshBuffer(1)->getMaterial().Wireframe;
+	for (s32 i=0; i<=16; ++i)
+	{
+		result &= hasPosition(simplified->getMeshBuffer(0), vector3df(8.f, 0, i-8.f));
+		result &= hasPosition(simplified->getMeshBuffer(1), vector3df(8.f, 0, i-8.f));
+	}
+
+	simplified->drop();
+	left->drop();
+	right->drop();
+
+	assert_log(result);
+	return result;
+}
+
+// The level is chosen by the size of the node on the screen
+bool lodSceneNode(IrrlichtDevice* device)
+{
+	ISceneManager* smgr = device->getSceneManager();
+
+	IMesh* sphere = smgr->getGeometryCreator()->createSphereMesh(10.f, 64, 64);
+	ILODSceneNode* node = smgr->addLODSceneNode(sphere);
+	sphere->drop();
+	assert_log(node);
+	if (!node)
+		return false;
+
+	ICameraSceneNode* cam = smgr->addCameraSceneNode(0, vector3df(0,0,-30), vector3df(0,0,0));
+
+	bool result = node->getLevelCount() == 4;
+	result &= node->getLevelMesh(0) == sphere;
+	for (u32 i=1; i<node->getLevelCount(); ++i)
+	{
+		result &= getTriangleCount(node->getLevelMesh(i)) < getTriangleCount(node->getLevelMesh(i-1));
+		result &= node->getLevelScreenSize(i) < node->getLevelScreenSize(i-1);
+	}
+	logTestString("LOD triangles: %u %u %u %u\n", getTriangleCount(node->getLevelMesh(0)),
+		getTriangleCount(node->getLevelMesh(1)), getTriangleCount(node->getLevelMesh(2)),
+		getTriangleCount(node->getLevelMesh(3)));
+
+	// the level gets coarser with the distance
+	s32 lastLevel = 0;
+	for (u32 distance=30; distance<2000; distance*=2)
+	{
+		cam->setPosition(vector3df(0,0,-(f32)distance));
+		smgr->drawAll();
+		result &= node->getCurrentLevel() >= lastLevel;
+		lastLevel = node->getCurrentLevel();
+	}
+	result &= lastLevel == 3;
+
+	cam->setPosition(vector3df(0,0,-30));
+	smgr->drawAll();
+	result &= node->getCurrentLevel() == 0;
+	result &= node->getScreenSize() > 0.5f;
+
+	// a zoomed camera shows more details
+	cam->setPosition(vector3df(0,0,-200));
+	smgr->drawAll();
+	const s32 level = node->getCurrentLevel();
+	cam->setFOV(cam->getFOV()*0.2f);
+	smgr->drawAll();
+	result &= node->getCurrentLevel() < level;
+
+	// levels without mesh hide the node
+	node->addLevel(0, 0.f);
+	cam->setPosition(vector3df(0,0,-5000));
+	smgr->drawAll();
+	result &= node->getCurrentLevel() == 4 && node->getLevelMesh(4) == 0;
+	result &= node->getMaterialCount() == 1;
+
+	smgr->clear();
+
+	assert_log(result);
+	return result;
+}
+
+} // end anonymous namespace
+
+bool meshSimplification(void)
+{
+	IrrlichtDevice * device = irr::createDevice(video::EDT_NULL, dimension2d<u32>(160, 120));
+	assert_log(device);
+	if (!device)
+		return false;
+
+	bool result = simplifyPlane(device);
+	result &= simplifySphere(device);
+	result &= simplifyMaterialBorder(device);
+	result &= lodSceneNode(device);
+
+	device->closeDevice();
+	device->run();
+	device->drop();
+
+	return result;
+}
@@ -0,0 +1,169 @@
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#include "testUtils.h"
+
+using namespace irr;
+using namespace core;
+using namespace scene;
+using namespace video;
+
+namespace
+{
+
+// A grid of quads which don't share their corners, the corners are moved a bit.
+IMeshBuffer* createQuadGrid(u32 quads, f32 tolerance)
+{
+	const u32 vertexCount = quads*quads*4;
+	CDynamicMeshBuffer* buffer = new CDynamicMeshBuffer(EVT_STANDARD,
+		vertexCount > 65536 ? EIT_32BIT : EIT_16BIT);
+	buffer->getVertexBuffer().reallocate(vertexCount);
+	buffer->getIndexBuffer().reallocate(quads*quads*6);
+
+	u32 seed = 1;
+	for (u32 y=0; y<quads; ++y)
+	{
+		for (u32 x=0; x<quads; ++x)
+		{
+			const u32 first = buffer->getVertexBuffer().size();
+			for (u32 corner=0; corner<4; ++corner)
+			{
+				const u32 cx = x + (corner & 1);
+				const u32 cy = y + (corner >> 1);
+				seed = seed * 1103515245 + 12345;
+				const f32 jitter = (((seed >> 16) & 0xff) / 255.f - 0.5f) * 0.8f * tolerance;
+				buffer->getVertexBuffer().push_back(S3DVertex(cx + jitter, 0.f, cy - jitter,
+					0.f, 1.f, 0.f, SColor(255,255,255,255), cx / (f32)quads, cy / (f32)quads));
+			}
+			buffer->getIndexBuffer().push_back(first);
+			buffer->getIndexBuffer().push_back(first+2);
+			buffer->getIndexBuffer().push_back(first+1);
+			buffer->getIndexBuffer().push_back(first+1);
+			buffer->getIndexBuffer().push_back(first+2);
+			buffer->getIndexBuffer().push_back(first+3);
+		}
+	}
+	buffer->recalculateBoundingBox();
+	return buffer;
+}
+
+// The way vertices were welded before, comparing with all previous vertices
+void weldReference(const IMeshBuffer* mb, f32 tolerance, array<S3DVertex>& vertices, array<u32>& indices)
+{
+	const S3DVertex* v = (const S3DVertex*)mb->getVertices();
+	array<u32> redirects;
+	redirects.set_used(mb->getVertexCount());
+	for (u32 i=0; i<mb->getVertexCount(); ++i)
+	{
+		bool found = false;
+		for (u32 j=0; j<i; ++j)
+		{
+			if (v[i].Pos.equals(v[j].Pos, tolerance) &&
+				v[i].Normal.equals(v[j].Normal, tolerance) &&
+				v[i].TCoords.equals(v[j].TCoords) &&
+				v[i].Color == v[j].Color)
+			{
+				redirects[i] = redirects[j];
+				found = true;
+				break;
+			}
+		}
+		if (!found)
+		{
+			redirects[i] = vertices.size();
+			vertices.push_back(v[i]);
+		}
+	}
+
+	for (u32 i=0; i<mb->getIndexCount(); i+=3)
+	{
+		const u32 a = redirects[mb->getIndexType() == EIT_32BIT ? ((const u32*)mb->getIndices())[i] : mb->getIndices()[i]];
+		const u32 b = redirects[mb->getIndexType() == EIT_32BIT ? ((const u32*)mb->getIndices())[i+1] : mb->getIndices()[i+1]];
+		const u32 c = redirects[mb->getIndexType() == EIT_32BIT ? ((const u32*)mb->getIndices())[i+2] : mb->getIndices()[i+2]];
+		if (a != b && b != c && a != c)
+		{
+			indices.push_back(a);
+			indices.push_back(b);
+			indices.push_back(c);
+		}
+	}
+}
+
+u32 getIndex(const IMeshBuffer* mb, u32 i)
+{
+	return mb->getIndexType() == EIT_32BIT ? ((const u32*)mb->getIndices())[i] : mb->getIndices()[i];
+}
+
+} // end anonymous namespace
+
+// Welding has to give the same results as comparing all vertices, and be fast for large meshes.
+bool meshWelding(void)
+{
+	IrrlichtDevice* device = createDevice(EDT_NULL, dimension2d<u32>(160, 120));
+	assert_log(device);
+	if (!device)
+		return false;
+
+	IMeshManipulator* manipulator = device->getSceneManager()->getMeshManipulator();
+	ITimer* timer = device->getTimer();
+
+	const f32 tolerance = 0.01f;
+	const u32 sizes[] = { 16, 50, 158, 500 };
+	bool result = true;
+
+	for (u32 s=0; s<sizeof(sizes)/sizeof(sizes[0]); ++s)
+	{
+		const u32 quads = sizes[s];
+		IMeshBuffer* mb = createQuadGrid(quads, tolerance);
+		SMesh mesh;
+		mesh.addMeshBuffer(mb);
+		mb->drop();
+
+		u32 time = timer->getRealTime();
+		IMesh* welded = manipulator->createMeshWelded(&mesh, tolerance);
+		const u32 weldTime = timer->getRealTime() - time;
+
+		const IMeshBuffer* wb = welded->getMeshBuffer(0);
+		bool ok = wb->getVertexCount() == (quads+1)*(quads+1);
+		ok &= wb->getIndexCount() == mb->getIndexCount();
+		ok &= (wb->getIndexType() == EIT_32BIT) == (wb->getVertexCount() > 65536);
+
+		// the old way is too slow for the large meshes
+		if (quads <= 50)
+		{
+			array<S3DVertex> vertices;
+			array<u32> indices;
+			time = timer->getRealTime();
+			weldReference(mb, tolerance, vertices, indices);
+			logTestString("Comparing all vertices: %u ms\n", timer->getRealTime() - time);
+
+			ok &= vertices.size() == wb->getVertexCount() && indices.size() == wb->getIndexCount();
+			for (u32 i=0; ok && i<vertices.size(); ++i)
+				ok &= vertices[i] == ((const S3DVertex*)wb->getVertices())[i];
+			for (u32 i=0; ok && i<indices.size(); ++i)
+				ok &= indices[i] == getIndex(wb, i);
+		}
+
+		logTestString("Welded %u of %u vertices in %u ms.\n", wb->getVertexCount(), mb->getVertexCount(), weldTime);
+		if (!ok)
+			logTestString("Welding a grid of %u quads failed.\n", quads*quads);
+		result &= ok;
+
+		welded->drop();
+	}
+
+	// nothing is welded with a tolerance which is too small
+	IMeshBuffer* mb = createQuadGrid(4, tolerance);
+	SMesh mesh;
+	mesh.addMeshBuffer(mb);
+	mb->drop();
+	IMesh* welded = manipulator->createMeshWelded(&mesh, 0.f);
+	result &= welded->getMeshBuffer(0)->getVertexCount() == mb->getVertexCount();
+	welded->drop();
+
+	device->closeDevice();
+	device->run();
+	device->drop();
+
+	return result;
+}
@@ -0,0 +1,180 @@
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#include "testUtils.h"
+
+using namespace irr;
+using namespace core;
+using namespace scene;
+using namespace video;
+
+namespace
+{
+
+// Draws the scene and returns the number of triangles drawn
+u32 drawScene(IrrlichtDevice* device)
+{
+	device->getVideoDriver()->beginScene(true, true, SColor(255,0,0,0));
+	device->getSceneManager()->drawAll();
+	device->getVideoDriver()->endScene();
+	return device->getVideoDriver()->getPrimitiveCountDrawn();
+}
+
+// Returns the number of triangles with all corners inside the view frustum
+u32 getTrianglesInside(const IMesh* mesh, const ICameraSceneNode* camera)
+{
+	const SViewFrustum* frustum = camera->getViewFrustum();
+	u32 count = 0;
+	for (u32 b=0; b<mesh->getMeshBufferCount(); ++b)
+	{
+		const IMeshBuffer* mb = mesh->getMeshBuffer(b);
+		for (u32 i=0; i+2<mb->getIndexCount(); i+=3)
+		{
+			u32 c;
+			for (c=0; c<3; ++c)
+			{
+				const vector3df& pos = mb->getPosition(mb->getIndices()[i+c]);
+				u32 p;
+				for (p=0; p<SViewFrustum::VF_PLANE_COUNT; ++p)
+				{
+					if (frustum->planes[p].classifyPointRelation(pos) == ISREL3D_FRONT)
+						break;
+				}
+				if (p != SViewFrustum::VF_PLANE_COUNT)
+					break;
+			}
+			if (c == 3)
+				++count;
+		}
+	}
+	return count;
+}
+
+// All modes draw the visible nodes, and moving the camera back gives the same nodes again
+bool visibleNodes(IrrlichtDevice* device)
+{
+	ISceneManager* smgr = device->getSceneManager();
+	IMesh* plane = smgr->getGeometryCreator()->createPlaneMesh(dimension2df(1.f, 1.f), dimension2du(100, 100));
+	const u32 triangleCount = plane->getMeshBuffer(0)->getIndexCount()/3;
+	IOctreeSceneNode* node = smgr->addOctreeSceneNode(plane, 0, -1, 128);
+
+	ICameraSceneNode* camera = smgr->addCameraSceneNode(0, vector3df(-50.f, 5.f, -50.f), vector3df(-40.f, 0.f, -40.f));
+	camera->setFarValue(40.f);
+	drawScene(device);
+	const u32 inside = getTrianglesInside(plane, camera);
+
+	bool result = true;
+	u32 drawn[2][3];
+	for (u32 checks=0; checks<2; ++checks)
+	{
+		node->setPolygonChecks(checks ? EOPC_FRUSTUM : EOPC_BOX);
+		for (u32 vbo=0; vbo<3; ++vbo)
+		{
+			node->setUseVBO((EOCTREENODE_VBO)vbo);
+			drawn[checks][vbo] = drawScene(device);
+			// nothing changed, the same nodes are drawn again
+			result &= drawScene(device) == drawn[checks][vbo];
+		}
+		logTestString("%s: %u of %u triangles drawn, %u inside.\n", checks ? "Frustum" : "Box",
+			drawn[checks][EOV_NO_VBO], triangleCount, inside);
+		result &= drawn[checks][EOV_USE_VBO] == triangleCount;
+		result &= drawn[checks][EOV_NO_VBO] == drawn[checks][EOV_USE_VBO_WITH_VISIBITLY];
+		result &= drawn[checks][EOV_NO_VBO] >= inside && drawn[checks][EOV_NO_VBO] < triangleCount/2;
+	}
+	result &= drawn[1][EOV_NO_VBO] <= drawn[0][EOV_NO_VBO];
+
+	// other nodes get visible and invisible again
+	camera->setPosition(vector3df(0.f, 5.f, 0.f));
+	camera->setTarget(vector3df(10.f, 0.f, 5.f));
+	camera->updateAbsolutePosition();
+	const u32 drawnMoved = drawScene(device);
+	result &= drawnMoved >= getTrianglesInside(plane, camera) && drawnMoved != drawn[1][EOV_NO_VBO];
+
+	camera->setPosition(vector3df(-50.f, 5.f, -50.f));
+	camera->setTarget(vector3df(-40.f, 0.f, -40.f));
+	result &= drawScene(device) == drawn[1][EOV_USE_VBO_WITH_VISIBITLY];
+
+	node->setUseVBO(EOV_NO_VBO);
+	result &= drawScene(device) == drawn[1][EOV_NO_VBO];
+
+	camera->remove();
+	node->remove();
+	plane->drop();
+
+	assert_log(result);
+	return result;
+}
+
+// A tree read from a file draws the same triangles, files of other meshes are not used
+bool treeFile(IrrlichtDevice* device)
+{
+	ISceneManager* smgr = device->getSceneManager();
+	io::IFileSystem* fs = device->getFileSystem();
+
+	IMesh* plane = smgr->getGeometryCreator()->createPlaneMesh(dimension2df(1.f, 1.f), dimension2du(64, 64));
+	IOctreeSceneNode* node = smgr->addOctreeSceneNode(plane, 0, -1, 128);
+
+	ICameraSceneNode* camera = smgr->addCameraSceneNode(0, vector3df(-30.f, 5.f, -30.f), vector3df(-20.f, 0.f, -20.f));
+	camera->setFarValue(30.f);
+	const u32 drawn = drawScene(device);
+
+	array<u8> memory;
+	memory.set_used(1024*1024);
+	io::IWriteFile* writeFile = fs->createMemoryWriteFile(memory.pointer(), memory.size(), "tree.oct");
+	bool result = node->writeTree(writeFile);
+	const u32 fileSize = writeFile->getPos();
+	writeFile->drop();
+	logTestString("Tree file of %u bytes.\n", fileSize);
+	node->remove();
+
+	// the tree is read instead of built
+	node = smgr->addOctreeSceneNode((IMesh*)0, 0, -1, 128, true);
+	io::IReadFile* readFile = fs->createMemoryReadFile(memory.pointer(), fileSize, "tree.oct");
+	result &= node->readTree(plane, readFile);
+	readFile->drop();
+	result &= drawScene(device) == drawn;
+	node->remove();
+
+	// a truncated file is not used
+	node = smgr->addOctreeSceneNode((IMesh*)0, 0, -1, 128, true);
+	readFile = fs->createMemoryReadFile(memory.pointer(), fileSize-4, "tree.oct");
+	result &= !node->readTree(plane, readFile);
+	readFile->drop();
+	result &= drawScene(device) == drawn;
+	node->remove();
+
+	// neither is the file of another mesh
+	IMesh* otherPlane = smgr->getGeometryCreator()->createPlaneMesh(dimension2df(1.1f, 1.f), dimension2du(64, 64));
+	node = smgr->addOctreeSceneNode((IMesh*)0, 0, -1, 128, true);
+	readFile = fs->createMemoryReadFile(memory.pointer(), fileSize, "tree.oct");
+	result &= !node->readTree(otherPlane, readFile);
+	readFile->drop();
+	result &= drawScene(device) > 0;
+	node->remove();
+	otherPlane->drop();
+
+	camera->remove();
+	plane->drop();
+
+	assert_log(result);
+	return result;
+}
+
+} // end anonymous namespace
+
+bool octreeSceneNode(void)
+{
+	IrrlichtDevice * device = irr::createDevice(video::EDT_NULL, dimension2d<u32>(160, 120));
+	assert_log(device);
+	if (!device)
+		return false;
+
+	bool result = visibleNodes(device);
+	result &= treeFile(device);
+
+	device->closeDevice();
+	device->run();
+	device->drop();
+
+	return result;
+}
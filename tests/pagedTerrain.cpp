@@ -0,0 +1,226 @@
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#include "testUtils.h"
+#include <stdio.h>
+
+using namespace irr;
+using namespace core;
+using namespace scene;
+using namespace video;
+
+namespace
+{
+
+const u32 Width = 257;
+const u32 Depth = 129;
+
+// Height of a sample in units
+f32 sampleHeight(f32 x, f32 z)
+{
+	return (x * 64.f + z * 32.f) / 256.f;
+}
+
+// Draws the scene until all tiles around the camera are loaded
+void drawScene(IrrlichtDevice* device, IPagedTerrainSceneNode* terrain)
+{
+	for (u32 i=0; i<20; ++i)
+	{
+		device->getVideoDriver()->beginScene(true, true, SColor(255,0,0,0));
+		device->getSceneManager()->drawAll();
+		device->getVideoDriver()->endScene();
+		if (!terrain->getPendingTileCount())
+			break;
+		terrain->waitForTiles();
+	}
+}
+
+// Creates a heightmap with rows along the x axis
+u16* createHeights()
+{
+	u16* heights = new u16[Width*Depth];
+	for (u32 z=0; z<Depth; ++z)
+		for (u32 x=0; x<Width; ++x)
+			heights[z*Width + x] = (u16)(x*64 + z*32);
+	return heights;
+}
+
+bool loadTiles(IrrlichtDevice* device)
+{
+	ISceneManager* smgr = device->getSceneManager();
+
+	u16* heights = createHeights();
+	io::IReadFile* file = device->getFileSystem()->createMemoryReadFile(heights,
+		Width*Depth*sizeof(u16), "heights.raw", true);
+
+	IPagedTerrainSceneNode* terrain = smgr->addPagedTerrainSceneNode(file, dimension2du(Width, Depth),
+		0, -1, vector3df(100.f, 0.f, 0.f), vector3df(0.f, 0.f, 0.f), vector3df(2.f, 1.f, 2.f), 32);
+	file->drop();
+
+	bool result = terrain && terrain->getType() == ESNT_PAGED_TERRAIN;
+	if (!result)
+	{
+		assert_log(result);
+		return false;
+	}
+	result &= terrain->getTileCount() == dimension2du(8, 4);
+	result &= terrain->getTileSize() == 32;
+
+	// a camera at the start of the terrain, which can't see its end
+	ICameraSceneNode* camera = smgr->addCameraSceneNode(0, vector3df(110.f, 40.f, 96.f), vector3df(200.f, 0.f, 96.f));
+	camera->setFarValue(250.f);
+	terrain->setLODDistance(40.f);
+	drawScene(device, terrain);
+
+	const u32 loaded = terrain->getLoadedTileCount();
+	logTestString("%u tiles loaded, %u bytes.\n", loaded, terrain->getMemoryUsed());
+	result &= loaded > 0 && loaded < 32;
+	result &= terrain->getPendingTileCount() == 0;
+	result &= device->getVideoDriver()->getPrimitiveCountDrawn() > 0;
+	result &= terrain->isTileLoaded(0, 1) && terrain->getTileLOD(0, 1) >= 0;
+	result &= !terrain->isTileLoaded(7, 0) && terrain->getTileLOD(7, 0) == -1;
+
+	// heights from loaded tiles, the heightmap is linear so the interpolation is exact
+	const f32 positions[][2] = { {0.f, 0.f}, {10.f, 40.f}, {31.5f, 32.f}, {32.f, 64.25f}, {63.75f, 12.5f} };
+	for (u32 i=0; i<sizeof(positions)/sizeof(positions[0]); ++i)
+	{
+		const f32 x = positions[i][0];
+		const f32 z = positions[i][1];
+		if (terrain->isTileLoaded((u32)x/32, (u32)z/32))
+			result &= equals(terrain->getHeight(100.f + x*2.f, z*2.f), sampleHeight(x, z), 0.001f);
+		else
+			result &= terrain->getHeight(100.f + x*2.f, z*2.f) == -FLT_MAX;
+	}
+	result &= equals(terrain->getHeight(100.f + 20.f, 40.f), sampleHeight(10.f, 20.f), 0.001f);
+	result &= terrain->getHeight(100.f + 250.f*2.f, 10.f) == -FLT_MAX;
+	result &= terrain->getHeight(90.f, 10.f) == -FLT_MAX;
+
+	// tiles near the camera have a higher detail
+	result &= terrain->getTileLOD(0, 1) < terrain->getTileLOD(3, 1);
+
+	// with a small budget the tiles behind the camera are released
+	terrain->setMemoryBudget(terrain->getMemoryUsed() / 2);
+	camera->setPosition(vector3df(550.f, 120.f, 96.f));
+	camera->setTarget(vector3df(600.f, 0.f, 96.f));
+	camera->setFarValue(150.f);
+	drawScene(device, terrain);
+
+	logTestString("%u tiles loaded, %u bytes.\n", terrain->getLoadedTileCount(), terrain->getMemoryUsed());
+	result &= terrain->isTileLoaded(7, 1) && terrain->getTileLOD(7, 1) >= 0;
+	result &= !terrain->isTileLoaded(0, 1);
+	result &= terrain->getMemoryUsed() <= terrain->getMemoryBudget();
+	result &= equals(terrain->getHeight(100.f + 250.f*2.f, 80.f), sampleHeight(250.f, 40.f), 0.001f);
+
+	terrain->remove();
+	camera->remove();
+
+	// missing files don't create a node
+	result &= smgr->addPagedTerrainSceneNode("media/missing.raw", dimension2du(Width, Depth)) == 0;
+
+	assert_log(result);
+	return result;
+}
+
+// Files on disk are read by the loading thread with its own handle, so
+// the file passed in can still be used
+bool diskFile(IrrlichtDevice* device)
+{
+	ISceneManager* smgr = device->getSceneManager();
+	const io::path filename = "pagedTerrainHeights.raw";
+	u16* heights = createHeights();
+	io::IWriteFile* writeFile = device->getFileSystem()->createAndWriteFile(filename);
+	bool result = writeFile && writeFile->write(heights, Width*Depth*sizeof(u16)) == Width*Depth*sizeof(u16);
+	if (writeFile)
+		writeFile->drop();
+	delete [] heights;
+
+	io::IReadFile* file = device->getFileSystem()->createAndOpenFile(filename);
+	IPagedTerrainSceneNode* terrain = file ? smgr->addPagedTerrainSceneNode(file, dimension2du(Width, Depth),
+		0, -1, vector3df(0.f, 0.f, 0.f), vector3df(0.f, 0.f, 0.f), vector3df(1.f, 1.f, 1.f), 32) : 0;
+	result &= terrain != 0;
+	if (!result)
+	{
+		if (file)
+			file->drop();
+		remove(filename.c_str());
+		assert_log(result);
+		return false;
+	}
+
+	ICameraSceneNode* camera = smgr->addCameraSceneNode(0, vector3df(128.f, 200.f, 64.f), vector3df(129.f, 0.f, 64.f));
+	for (u32 i=0; i<20; ++i)
+	{
+		device->getVideoDriver()->beginScene(true, true, SColor(255,0,0,0));
+		smgr->drawAll();
+		device->getVideoDriver()->endScene();
+
+		// move the file position while tiles are loading
+		u16 value;
+		file->seek(((i*13) % Depth) * Width * sizeof(u16));
+		file->read(&value, sizeof(u16));
+
+		if (!terrain->getPendingTileCount())
+			break;
+		terrain->waitForTiles();
+	}
+	file->drop();
+
+	result &= terrain->getLoadedTileCount() == 32;
+	for (u32 z=0; z<Depth; z+=9)
+		for (u32 x=0; x<Width; x+=11)
+			result &= equals(terrain->getHeight((f32)x, (f32)z), sampleHeight((f32)x, (f32)z), 0.001f);
+
+	terrain->remove();
+	camera->remove();
+	remove(filename.c_str());
+
+	assert_log(result);
+	return result;
+}
+
+// Heightmaps which can't be read with the long offsets of IReadFile::seek() are rejected
+bool oversizedHeightmap(IrrlichtDevice* device)
+{
+	ISceneManager* smgr = device->getSceneManager();
+	u16* heights = createHeights();
+	io::IReadFile* file = device->getFileSystem()->createMemoryReadFile(heights,
+		Width*Depth*sizeof(u16), "heights.raw", true);
+
+	// 3.2 GB only fit where long has 64 bits
+	IPagedTerrainSceneNode* large = smgr->addPagedTerrainSceneNode(file, dimension2du(40000, 40000));
+	IPagedTerrainSceneNode* wide = smgr->addPagedTerrainSceneNode(file, dimension2du(0x80000000, 4));
+	file->drop();
+
+	bool result = large && wide;
+	if (result)
+	{
+		const dimension2du largeSize = sizeof(long) > 4 ? dimension2du(40000, 40000) : dimension2du(2, 2);
+		result &= large->getHeightmapSize() == largeSize;
+		result &= wide->getHeightmapSize() == dimension2du(2, 2);
+		large->remove();
+		wide->remove();
+	}
+
+	assert_log(result);
+	return result;
+}
+
+} // end anonymous namespace
+
+bool pagedTerrain(void)
+{
+	IrrlichtDevice * device = irr::createDevice(video::EDT_NULL, dimension2d<u32>(160, 120));
+	assert_log(device);
+	if (!device)
+		return false;
+
+	bool result = loadTiles(device);
+	result &= diskFile(device);
+	result &= oversizedHeightmap(device);
+
+	device->closeDevice();
+	device->run();
+	device->drop();
+
+	return result;
+}
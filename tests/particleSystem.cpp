@@ -0,0 +1,328 @@
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#include "testUtils.h"
+
+using namespace irr;
+using namespace core;
+using namespace scene;
+using namespace video;
+
+namespace
+{
+
+// Affector which can only work on all particles at once
+class CCountingAffector : public IParticleAffector
+{
+public:
+	CCountingAffector() : Calls(0), Particles(0) {}
+
+	virtual void affect(u32 now, SParticle* particlearray, u32 count)
+	{
+		++Calls;
+		Particles += count;
+		for (u32 i=0; i<count; ++i)
+			particlearray[i].vector.Y += 0.0001f;
+	}
+
+	virtual E_PARTICLE_AFFECTOR_TYPE getType() const { return EPAT_NONE; }
+
+	u32 Calls;
+	u32 Particles;
+};
+
+// Affector which remembers the positions of the particles
+class CRecordingAffector : public IParticleAffector
+{
+public:
+	virtual void affect(u32 now, SParticle* particlearray, u32 count)
+	{
+		Positions.set_used(count);
+		for (u32 i=0; i<count; ++i)
+			Positions[i] = particlearray[i].pos;
+	}
+
+	virtual E_PARTICLE_AFFECTOR_TYPE getType() const { return EPAT_NONE; }
+
+	// Returns the number of particles which are closer to the camera than the next one
+	u32 getUnsortedCount(const ICameraSceneNode* camera) const
+	{
+		const vector3df view = (camera->getTarget() - camera->getAbsolutePosition()).normalize();
+		u32 unsorted = 0;
+		for (u32 i=1; i<Positions.size(); ++i)
+		{
+			if (Positions[i-1].dotProduct(view) < Positions[i].dotProduct(view) - 0.001f)
+				++unsorted;
+		}
+		return unsorted;
+	}
+
+	array<vector3df> Positions;
+};
+
+// Creates a particle system with all built-in affectors and the counting affector
+IParticleSystemSceneNode* createParticleSystem(ISceneManager* smgr, IParticleAffector* counter)
+{
+	IParticleSystemSceneNode* node = smgr->addParticleSystemSceneNode(false);
+	IParticleEmitter* emitter = node->createBoxEmitter(aabbox3df(-10.f, 0.f, -10.f, 10.f, 10.f, 10.f),
+		vector3df(0.f, 0.01f, 0.f), 400000, 400000, SColor(255,255,255,255), SColor(255,255,255,255),
+		300, 900, 20, dimension2df(1.f, 1.f), dimension2df(2.f, 2.f));
+	node->setEmitter(emitter);
+	emitter->drop();
+
+	IParticleAffector* affectors[] = {
+		node->createGravityAffector(vector3df(0.f, -0.01f, 0.f), 500),
+		node->createFadeOutParticleAffector(SColor(0,0,0,0), 400),
+		counter,
+		node->createRotationAffector(vector3df(0.f, 30.f, 0.f)),
+		node->createScaleParticleAffector(dimension2df(2.f, 2.f)),
+		node->createAttractionAffector(vector3df(0.f, 20.f, 0.f), 5.f)
+	};
+	for (u32 i=0; i<sizeof(affectors)/sizeof(affectors[0]); ++i)
+	{
+		node->addAffector(affectors[i]);
+		if (affectors[i] != counter)
+			affectors[i]->drop();
+	}
+	return node;
+}
+
+// Emits and updates the particles of a system with the given number of threads
+void runParticleSystem(IrrlichtDevice* device, IParticleSystemSceneNode* node, u32 threadCount)
+{
+	node->setUpdateThreadCount(threadCount);
+	device->getRandomizer()->reset(7);
+	node->doParticleSystem(1000);
+	node->doParticleSystem(1500);
+	node->doParticleSystem(1700);
+	node->doParticleSystem(2000);
+}
+
+// Particle systems are not limited to 16 bit indices and give the same results with several threads
+bool manyParticles(IrrlichtDevice* device)
+{
+	ISceneManager* smgr = device->getSceneManager();
+
+	CCountingAffector* counterA = new CCountingAffector();
+	IParticleSystemSceneNode* single = createParticleSystem(smgr, counterA);
+	runParticleSystem(device, single, 1);
+
+	CCountingAffector* counterB = new CCountingAffector();
+	IParticleSystemSceneNode* threaded = createParticleSystem(smgr, counterB);
+	runParticleSystem(device, threaded, 4);
+
+	const u32 count = single->getParticleCount();
+	logTestString("%u particles.\n", count);
+	bool result = count > 16250 && count < 400000;
+	result &= threaded->getUpdateThreadCount() == 4;
+	result &= threaded->getParticleCount() == count;
+	result &= threaded->getBoundingBox().MinEdge == single->getBoundingBox().MinEdge;
+	result &= threaded->getBoundingBox().MaxEdge == single->getBoundingBox().MaxEdge;
+
+	// the counting affector was called once per update, after the first one
+	result &= counterA->Calls == 3 && counterB->Calls == 3;
+	result &= counterA->Particles == counterB->Particles;
+	counterA->drop();
+	counterB->drop();
+
+	// all particles are drawn with one call
+	ICameraSceneNode* camera = smgr->addCameraSceneNode(0, vector3df(0.f, 10.f, -60.f), vector3df(0.f, 10.f, 0.f));
+	single->setVisible(false);
+	ITimer* timer = device->getTimer();
+	timer->setTime(2000);
+	device->getVideoDriver()->beginScene(true, true, SColor(255,0,0,0));
+	smgr->drawAll();
+	device->getVideoDriver()->endScene();
+	result &= device->getVideoDriver()->getPrimitiveCountDrawn() == threaded->getParticleCount()*2;
+
+	single->remove();
+	threaded->remove();
+	camera->remove();
+
+	assert_log(result);
+	return result;
+}
+
+// No more than the largest number of particles are emitted
+bool maxParticleCount(IrrlichtDevice* device)
+{
+	ISceneManager* smgr = device->getSceneManager();
+	IParticleSystemSceneNode* node = smgr->addParticleSystemSceneNode(false);
+	IParticleEmitter* emitter = node->createPointEmitter(vector3df(0.f, 0.01f, 0.f), 1000, 1000);
+	node->setEmitter(emitter);
+	emitter->drop();
+
+	bool result = node->getMaxParticleCount() == 0xFFFFFFFF;
+	node->setMaxParticleCount(3);
+	result &= node->getMaxParticleCount() == 3;
+
+	node->doParticleSystem(1000);
+	for (u32 t=1010; t<=1100; t+=10)
+		node->doParticleSystem(t);
+	result &= node->getParticleCount() == 3;
+
+	node->setMaxParticleCount(10);
+	for (u32 t=1110; t<=1200; t+=10)
+		node->doParticleSystem(t);
+	result &= node->getParticleCount() == 10;
+
+	node->setUpdateThreadCount(0);
+	result &= node->getUpdateThreadCount() >= 1;
+
+	node->remove();
+
+	assert_log(result);
+	return result;
+}
+
+// Draws the scene at the given time and returns the number of primitives drawn
+u32 drawScene(IrrlichtDevice* device, u32 time)
+{
+	device->getTimer()->setTime(time);
+	device->getVideoDriver()->beginScene(true, true, SColor(255,0,0,0));
+	device->getSceneManager()->drawAll();
+	device->getVideoDriver()->endScene();
+	return device->getVideoDriver()->getPrimitiveCountDrawn();
+}
+
+// Particles can be drawn as points, and invisible nodes are not updated
+bool particlePrimitives(IrrlichtDevice* device)
+{
+	ISceneManager* smgr = device->getSceneManager();
+	ICameraSceneNode* camera = smgr->addCameraSceneNode(0, vector3df(0.f, 10.f, -60.f), vector3df(0.f, 10.f, 0.f));
+	IParticleSystemSceneNode* node = smgr->addParticleSystemSceneNode(false);
+	IParticleEmitter* emitter = node->createBoxEmitter(aabbox3df(-10.f, 0.f, -10.f, 10.f, 10.f, 10.f),
+		vector3df(0.f, 0.01f, 0.f), 20000, 20000, SColor(255,255,255,255), SColor(255,255,255,255), 3000, 3000);
+	node->setEmitter(emitter);
+	emitter->drop();
+
+	bool result = node->getParticlePrimitive() == EPP_BILLBOARD;
+	drawScene(device, 3000);
+	u32 time = 3000;
+	for (u32 i=0; i<20; ++i)
+	{
+		time += 50;
+		result &= drawScene(device, time) == node->getParticleCount()*2;
+	}
+
+	node->setParticlePrimitive(EPP_POINT);
+	node->getMaterial(0).Thickness = 4.f;
+	time += 50;
+	result &= drawScene(device, time) == node->getParticleCount();
+
+	// the null driver has no point sprites and draws billboards
+	node->setParticlePrimitive(EPP_POINTSPRITE);
+	time += 50;
+	result &= drawScene(device, time) == node->getParticleCount()*2;
+	logTestString("%u particles.\n", node->getParticleCount());
+	result &= node->getParticleCount() > 16384;
+
+	// invisible nodes keep their particles
+	const u32 count = node->getParticleCount();
+	const aabbox3df box = node->getBoundingBox();
+	node->setVisible(false);
+	time += 500;
+	result &= drawScene(device, time) == 0;
+	result &= node->getParticleCount() == count;
+	result &= node->getBoundingBox().MinEdge == box.MinEdge && node->getBoundingBox().MaxEdge == box.MaxEdge;
+
+	// unless they should be updated
+	node->setParticleBehavior(EPB_INVISIBLE_EMITTING);
+	time += 50;
+	drawScene(device, time);
+	result &= node->getParticleCount() > count;
+
+	node->remove();
+	camera->remove();
+
+	assert_log(result);
+	return result;
+}
+
+// Particles can be drawn from back to front
+bool depthSorting(IrrlichtDevice* device)
+{
+	ISceneManager* smgr = device->getSceneManager();
+	ICameraSceneNode* camera = smgr->addCameraSceneNode(0, vector3df(0.f, 10.f, -60.f), vector3df(0.f, 10.f, 0.f));
+	IParticleSystemSceneNode* node = smgr->addParticleSystemSceneNode(false);
+	IParticleEmitter* emitter = node->createBoxEmitter(aabbox3df(-10.f, 0.f, -10.f, 10.f, 10.f, 10.f),
+		vector3df(0.f, 0.f, 0.01f), 5000, 5000, SColor(255,255,255,255), SColor(255,255,255,255), 10000, 10000, 90);
+	node->setEmitter(emitter);
+	CRecordingAffector* recorder = new CRecordingAffector();
+	node->addAffector(recorder);
+	recorder->drop();
+
+	// the affector sees the order of the last frame
+	u32 time = 5000;
+	drawScene(device, time);
+	for (u32 i=0; i<4; ++i)
+		drawScene(device, time += 100);
+	bool result = !node->getDepthSorting();
+	result &= recorder->getUnsortedCount(camera) > recorder->Positions.size()/4;
+
+	node->setDepthSorting(true);
+	result &= node->getDepthSorting();
+	drawScene(device, time += 100);
+	for (u32 i=0; i<4; ++i)
+	{
+		// the particles emitted in this frame are at the end
+		drawScene(device, time += 100);
+		result &= recorder->Positions.size() == node->getParticleCount();
+		recorder->Positions.set_used(recorder->Positions.size() - 500);
+		result &= recorder->getUnsortedCount(camera) == 0;
+	}
+
+	// the camera turns around and no more particles are emitted
+	node->setEmitter(0);
+	camera->setPosition(vector3df(20.f, 30.f, 80.f));
+	drawScene(device, time += 100);
+	drawScene(device, time += 100);
+	logTestString("%u sorted particles.\n", recorder->Positions.size());
+	result &= recorder->getUnsortedCount(camera) == 0;
+	result &= recorder->Positions.size() == node->getParticleCount();
+
+	// particles which are not global move and turn with the node
+	node->setEmitter(emitter);
+	node->setParticlesAreGlobal(false);
+	node->setPosition(vector3df(-40.f, 0.f, 30.f));
+	node->setRotation(vector3df(0.f, 70.f, 20.f));
+	camera->setPosition(vector3df(-10.f, 40.f, -50.f));
+	camera->setTarget(vector3df(-40.f, 0.f, 30.f));
+	drawScene(device, time += 100);
+	for (u32 i=0; i<4; ++i)
+	{
+		drawScene(device, time += 100);
+		recorder->Positions.set_used(recorder->Positions.size() - 500);
+		result &= recorder->getUnsortedCount(camera) == 0;
+	}
+
+	emitter->drop();
+	node->remove();
+	camera->remove();
+
+	assert_log(result);
+	return result;
+}
+
+} // end anonymous namespace
+
+bool particleSystem(void)
+{
+	IrrlichtDevice * device = irr::createDevice(video::EDT_NULL, dimension2d<u32>(160, 120));
+	assert_log(device);
+	if (!device)
+		return false;
+
+	device->getTimer()->stop();
+
+	bool result = manyParticles(device);
+	result &= maxParticleCount(device);
+	result &= particlePrimitives(device);
+	result &= depthSorting(device);
+
+	device->closeDevice();
+	device->run();
+	device->drop();
+
+	return result;
+}
@@ -0,0 +1,200 @@
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#include "testUtils.h"
+
+using namespace irr;
+using namespace core;
+using namespace scene;
+using namespace video;
+
+namespace
+{
+
+// Half floats and octahedral normals keep their values within their precision
+bool encodings()
+{
+	bool result = true;
+
+	const f32 values[] = { 0.f, 1.f, -2.5f, 0.333f, 1024.f, 65504.f, 0.0001f };
+	for (u32 i=0; i<sizeof(values)/sizeof(values[0]); ++i)
+	{
+		const f32 decoded = f16_to_f32(f32_to_f16(values[i]));
+		result &= fabsf(decoded - values[i]) <= fabsf(values[i]) * 0.001f;
+	}
+	// out of range values become infinite
+	result &= f16_to_f32(f32_to_f16(70000.f)) > 65504.f;
+
+	for (u32 i=0; i<200; ++i)
+	{
+		vector3df dir(sinf(i*0.37f), cosf(i*1.13f), sinf(i*2.71f) - 0.5f);
+		dir.normalize();
+		s16 encoded[2];
+		encodeOctahedral(dir, encoded);
+		const vector3df decoded = decodeOctahedral(encoded);
+		result &= decoded.equals(dir, 0.001f);
+	}
+
+	assert_log(result);
+	return result;
+}
+
+// Converted meshes use less memory and decode to nearly the original vertices
+bool convertSphere(IrrlichtDevice* device)
+{
+	IMeshManipulator* manipulator = device->getSceneManager()->getMeshManipulator();
+	IMesh* sphere = device->getSceneManager()->getGeometryCreator()->createSphereMesh(10.f, 16, 16);
+	sphere->getMeshBuffer(0)->getMaterial().Wireframe = true;
+
+	IMesh* quantized = manipulator->createMeshQuantized(sphere);
+	IMeshBuffer* source = sphere->getMeshBuffer(0);
+	const IMeshBuffer* mb = quantized->getMeshBuffer(0);
+
+	bool result = mb->getVertexType() == EVT_QUANTIZED;
+	result &= mb->getVertexCount() == source->getVertexCount();
+	result &= mb->getIndexCount() == source->getIndexCount();
+	result &= mb->getMaterial().Wireframe;
+	result &= getVertexPitchFromType(EVT_QUANTIZED) * 5 <= getVertexPitchFromType(EVT_STANDARD) * 3;
+	logTestString("Sphere vertices: %u bytes -> %u bytes.\n",
+		source->getVertexCount() * getVertexPitchFromType(EVT_STANDARD),
+		mb->getVertexCount() * getVertexPitchFromType(mb->getVertexType()));
+
+	// positions are exact to the step size of the quantization
+	const SVertexQuantization quantization = mb->getVertexQuantization();
+	const f32 tolerance = quantization.Scale.getLength();
+	for (u32 i=0; i<mb->getVertexCount(); ++i)
+	{
+		result &= mb->getPosition(i).equals(source->getPosition(i), tolerance);
+		result &= mb->getNormal(i).equals(source->getNormal(i), 0.001f);
+		result &= mb->getTCoords(i).equals(source->getTCoords(i), 0.001f);
+	}
+	// references to the last 16 decoded values stay valid
+	const vector3df* positions[16];
+	for (u32 i=0; i<16; ++i)
+		positions[i] = &mb->getPosition(i);
+	for (u32 i=0; i<16; ++i)
+		result &= positions[i]->equals(source->getPosition(i), tolerance);
+	result &= mb->getBoundingBox().getExtent().equals(source->getBoundingBox().getExtent(), tolerance*2.f);
+
+	// triangle selectors see the decoded positions
+	ITriangleSelector* selector = device->getSceneManager()->createTriangleSelector(quantized, 0);
+	array<triangle3df> triangles;
+	triangles.set_used(selector->getTriangleCount());
+	s32 count = 0;
+	selector->getTriangles(triangles.pointer(), triangles.size(), count);
+	result &= count == (s32)(source->getIndexCount()/3);
+	if (count)
+	{
+		const u16* indices = source->getIndices();
+		result &= triangles[0].pointA.equals(source->getPosition(indices[0]), tolerance);
+		result &= triangles[0].pointC.equals(source->getPosition(indices[2]), tolerance);
+	}
+	selector->drop();
+
+	// and converting back gives standard vertices again
+	IMesh* restored = manipulator->createMeshWith1TCoords(quantized);
+	result &= restored->getMeshBuffer(0)->getVertexType() == EVT_STANDARD;
+	result &= restored->getMeshBuffer(0)->getIndexCount() == source->getIndexCount();
+	for (u32 i=0; i<source->getIndexCount(); i+=7)
+	{
+		const u16 index = restored->getMeshBuffer(0)->getIndices()[i];
+		result &= restored->getMeshBuffer(0)->getPosition(index).equals(source->getPosition(source->getIndices()[i]), tolerance);
+	}
+	restored->drop();
+
+	// copies keep the vertex format and quantization
+	IMesh* copy = manipulator->createMeshCopy(quantized);
+	IMesh* unique = manipulator->createMeshUniquePrimitives(quantized);
+	result &= copy->getMeshBufferCount() == 1 && unique->getMeshBufferCount() == 1;
+	if (result)
+	{
+		const IMeshBuffer* copied = copy->getMeshBuffer(0);
+		const IMeshBuffer* split = unique->getMeshBuffer(0);
+		result &= copied->getVertexType() == EVT_QUANTIZED && split->getVertexType() == EVT_QUANTIZED;
+		result &= copied->getVertexCount() == mb->getVertexCount();
+		result &= split->getVertexCount() == mb->getIndexCount();
+		for (u32 i=0; i<mb->getIndexCount(); i+=7)
+		{
+			result &= copied->getPosition(i%mb->getVertexCount()) == mb->getPosition(i%mb->getVertexCount());
+			result &= split->getPosition(i) == mb->getPosition(mb->getIndices()[i]);
+		}
+	}
+	unique->drop();
+	copy->drop();
+
+	// drawing only needs the driver to decode
+	device->getVideoDriver()->beginScene(true, true, SColor(255,0,0,0));
+	device->getVideoDriver()->drawMeshBuffer(mb);
+	device->getVideoDriver()->endScene();
+
+	quantized->drop();
+	sphere->drop();
+
+	assert_log(result);
+	return result;
+}
+
+// Tangent vertices get compressed as well, other buffers are shared
+bool convertTangents(IrrlichtDevice* device)
+{
+	IMeshManipulator* manipulator = device->getSceneManager()->getMeshManipulator();
+	IMesh* cube = device->getSceneManager()->getGeometryCreator()->createCubeMesh(vector3df(4.f, 2.f, 1.f));
+	IMesh* tangents = manipulator->createMeshWithTangents(cube);
+	IMesh* twoCoords = manipulator->createMeshWith2TCoords(cube);
+
+	SMesh mixed;
+	mixed.addMeshBuffer(tangents->getMeshBuffer(0));
+	mixed.addMeshBuffer(twoCoords->getMeshBuffer(0));
+	mixed.recalculateBoundingBox();
+
+	IMesh* quantized = manipulator->createMeshQuantized(&mixed);
+	IMeshBuffer* source = tangents->getMeshBuffer(0);
+	const IMeshBuffer* mb = quantized->getMeshBuffer(0);
+
+	bool result = mb->getVertexType() == EVT_QUANTIZED_TANGENTS;
+	result &= quantized->getMeshBuffer(1) == twoCoords->getMeshBuffer(0);
+
+	const S3DVertexTangents* v = (const S3DVertexTangents*)source->getVertices();
+	const S3DVertexQuantizedTangents* q = (const S3DVertexQuantizedTangents*)mb->getVertices();
+	const SVertexQuantization quantization = mb->getVertexQuantization();
+	for (u32 i=0; i<mb->getVertexCount(); ++i)
+	{
+		const S3DVertexTangents decoded = q[i].get(quantization);
+		result &= decoded.Pos.equals(v[i].Pos, 0.001f);
+		result &= decoded.Tangent.equals(v[i].Tangent, 0.001f);
+		result &= decoded.Binormal.equals(v[i].Binormal, 0.001f);
+		result &= decoded.Color == v[i].Color;
+	}
+
+	// mesh manipulations work on the decoded values
+	manipulator->scale(quantized, vector3df(0.5f, 0.5f, 0.5f));
+	result &= mb->getPosition(0).equals(source->getPosition(0)*0.5f, 0.001f);
+
+	quantized->drop();
+	twoCoords->drop();
+	tangents->drop();
+	cube->drop();
+
+	assert_log(result);
+	return result;
+}
+
+} // end anonymous namespace
+
+bool quantizedVertices(void)
+{
+	IrrlichtDevice * device = irr::createDevice(video::EDT_NULL, dimension2d<u32>(160, 120));
+	assert_log(device);
+	if (!device)
+		return false;
+
+	bool result = encodings();
+	result &= convertSphere(device);
+	result &= convertTangents(device);
+
+	device->closeDevice();
+	device->run();
+	device->drop();
+
+	return result;
+}
@@ -0,0 +1,457 @@
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#include "testUtils.h"
+
+using namespace irr;
+using namespace core;
+using namespace scene;
+
+namespace
+{
+
+// Node which reports how often its absolute transformation was recalculated
+class CUpdateCountingSceneNode : public ISceneNode
+{
+public:
+	CUpdateCountingSceneNode(ISceneNode* parent, ISceneManager* mgr)
+		: ISceneNode(parent, mgr) {}
+
+	virtual void render() {}
+	virtual const aabbox3df& getBoundingBox() const { return Box; }
+
+	u32 getUpdateCount() const { return AbsoluteTransformationChangeCount; }
+
+private:
+	aabbox3df Box;
+};
+
+// Node which reports a built-in type, but has its own animation
+class COwnAnimationSceneNode : public ISceneNode
+{
+public:
+	COwnAnimationSceneNode(ISceneNode* parent, ISceneManager* mgr)
+		: ISceneNode(parent, mgr), AnimationTime(0) {}
+
+	virtual void OnAnimate(u32 timeMs)
+	{
+		AnimationTime = timeMs;
+		ISceneNode::OnAnimate(timeMs);
+	}
+
+	virtual void render() {}
+	virtual const aabbox3df& getBoundingBox() const { return Box; }
+	virtual ESCENE_NODE_TYPE getType() const { return ESNT_MESH; }
+
+	u32 AnimationTime;
+
+private:
+	aabbox3df Box;
+};
+
+// Only the moving hierarchies (every 10th) recalculate absolute transformations
+bool checkUpdateCounts(const array<CUpdateCountingSceneNode*>& counters, array<u32>& counts, u32 frames)
+{
+	bool result = true;
+	for (u32 i=0; i<counters.size(); ++i)
+	{
+		const u32 updates = counters[i]->getUpdateCount() - counts[i];
+		result &= updates == ((i % 10 == 0) ? frames : 0);
+		counts[i] = counters[i]->getUpdateCount();
+	}
+	return result;
+}
+
+// Stores the update counts as starting point for checkUpdateCounts
+void resetUpdateCounts(const array<CUpdateCountingSceneNode*>& counters, array<u32>& counts)
+{
+	counts.set_used(counters.size());
+	for (u32 i=0; i<counters.size(); ++i)
+		counts[i] = counters[i]->getUpdateCount();
+}
+
+// Draws frames with a time of 16 ms per frame and logs the time the scene
+// manager spent in animating them, as measured by its "animate" profile entry
+void drawFrames(IrrlichtDevice* device, u32 firstFrame, u32 frames, const char* name)
+{
+	u32 index = 0;
+	const bool profiled = getProfiler().findDataIndex(index, L"animate");
+	if (profiled)
+		getProfiler().resetDataByIndex(index);
+
+	for (u32 frame=firstFrame; frame<firstFrame+frames; ++frame)
+	{
+		device->getTimer()->setTime(frame*16);
+		device->getVideoDriver()->beginScene(true, true, video::SColor(255,0,0,0));
+		device->getSceneManager()->drawAll();
+		device->getVideoDriver()->endScene();
+	}
+
+	if (profiled)
+		logTestString("%s: %.2f ms per frame.\n", name,
+			getProfiler().getProfileDataByIndex(index).getTimeSum()/(f32)frames);
+	else
+		logTestString("%s: not measured, the engine is compiled without _IRR_COMPILE_WITH_PROFILING_.\n", name);
+}
+
+// Absolute transformations have to follow changes of the relative ones and of parents.
+bool transformationUpdates(ISceneManager* smgr)
+{
+	bool result = true;
+
+	ISceneNode* parent = smgr->addEmptySceneNode();
+	ISceneNode* child = smgr->addEmptySceneNode(parent);
+	ISceneNode* grandChild = smgr->addEmptySceneNode(child);
+	child->setPosition(vector3df(1,0,0));
+	grandChild->setPosition(vector3df(0,1,0));
+
+	smgr->getRootSceneNode()->OnAnimate(0);
+	result &= grandChild->getAbsolutePosition().equals(vector3df(1,1,0));
+
+	// only the parent changes, children must follow
+	parent->setPosition(vector3df(0,0,10));
+	smgr->getRootSceneNode()->OnAnimate(10);
+	result &= grandChild->getAbsolutePosition().equals(vector3df(1,1,10));
+
+	parent->setScale(vector3df(2,2,2));
+	smgr->getRootSceneNode()->OnAnimate(20);
+	result &= grandChild->getAbsolutePosition().equals(vector3df(2,2,10));
+
+	// new parent with a different transformation
+	ISceneNode* otherParent = smgr->addEmptySceneNode(0, -1);
+	otherParent->setPosition(vector3df(-5,0,0));
+	smgr->getRootSceneNode()->OnAnimate(30);
+	child->setParent(otherParent);
+	smgr->getRootSceneNode()->OnAnimate(40);
+	result &= grandChild->getAbsolutePosition().equals(vector3df(-4,1,0));
+
+	// without a parent the relative transformation is the absolute one
+	child->grab();
+	child->remove();
+	child->updateAbsolutePosition();
+	grandChild->updateAbsolutePosition();
+	result &= grandChild->getAbsolutePosition().equals(vector3df(1,1,0));
+	child->drop();
+
+	// matrices of dummy transformation nodes can be changed directly
+	IDummyTransformationSceneNode* dummy = smgr->addDummyTransformationSceneNode();
+	ISceneNode* dummyChild = smgr->addEmptySceneNode(dummy);
+	smgr->getRootSceneNode()->OnAnimate(50);
+	dummy->getRelativeTransformationMatrix().setTranslation(vector3df(3,3,3));
+	smgr->getRootSceneNode()->OnAnimate(60);
+	result &= dummyChild->getAbsolutePosition().equals(vector3df(3,3,3));
+
+	// hidden nodes are updated when they become visible again
+	ISceneNode* hidden = smgr->addEmptySceneNode(dummyChild);
+	dummyChild->setVisible(false);
+	smgr->getRootSceneNode()->OnAnimate(70);
+	dummy->getRelativeTransformationMatrix().setTranslation(vector3df(4,4,4));
+	smgr->getRootSceneNode()->OnAnimate(80);
+	dummyChild->setVisible(true);
+	smgr->getRootSceneNode()->OnAnimate(90);
+	result &= hidden->getAbsolutePosition().equals(vector3df(4,4,4));
+
+	// removed nodes don't follow their old parent anymore
+	ISceneNode* removed = smgr->addEmptySceneNode(parent);
+	ISceneNode* removedChild = smgr->addEmptySceneNode(removed);
+	smgr->getRootSceneNode()->OnAnimate(100);
+	removed->grab();
+	removed->remove();
+	parent->setPosition(vector3df(0,0,20));
+	smgr->getRootSceneNode()->OnAnimate(110);
+	result &= removedChild->getAbsolutePosition().equals(vector3df(0,0,10));
+	removed->drop();
+	smgr->getRootSceneNode()->OnAnimate(120);
+
+	// overridden OnAnimate() functions are called
+	COwnAnimationSceneNode* own = new COwnAnimationSceneNode(parent, smgr);
+	smgr->getRootSceneNode()->OnAnimate(130);
+	result &= own->AnimationTime == 130;
+	own->drop();
+
+	smgr->clear();
+
+	if (!result)
+		logTestString("Absolute transformations not updated correctly.\n");
+	return result;
+}
+
+// Builds many mostly static hierarchies and compares sequential and parallel animation.
+bool largeScene(IrrlichtDevice* device)
+{
+	ISceneManager* smgr = device->getSceneManager();
+
+	const u32 topLevelCount = 100;
+	const u32 childCount = 10;
+	const u32 grandChildCount = 99;
+
+	array<ISceneNode*> movingNodes;
+	array<CUpdateCountingSceneNode*> counters;
+	for (u32 i=0; i<topLevelCount; ++i)
+	{
+		ISceneNode* top = smgr->addEmptySceneNode();
+		top->setPosition(vector3df((f32)i, 0, 0));
+		counters.push_back(new CUpdateCountingSceneNode(top, smgr));
+		counters.getLast()->drop();
+		ISceneNode* leaf = 0;
+		for (u32 j=0; j<childCount; ++j)
+		{
+			ISceneNode* child = smgr->addEmptySceneNode(top);
+			child->setPosition(vector3df(0, (f32)j, 0));
+			for (u32 k=0; k<grandChildCount; ++k)
+			{
+				leaf = smgr->addEmptySceneNode(child);
+				leaf->setPosition(vector3df(0, 0, (f32)k));
+			}
+		}
+
+		// some hierarchies are moving
+		if (i % 10 == 0)
+		{
+			ISceneNodeAnimator* anim = smgr->createFlyCircleAnimator(top->getPosition(), 5.f);
+			top->addAnimator(anim);
+			anim->drop();
+			movingNodes.push_back(leaf);
+		}
+	}
+
+	logTestString("Animating %u nodes.\n", topLevelCount*childCount*(grandChildCount+1)+topLevelCount);
+	drawFrames(device, 0, 1, "Initial animation");
+
+	array<u32> counts;
+	resetUpdateCounts(counters, counts);
+	const u32 frames = 20;
+	drawFrames(device, 1, frames, "Sequential animation");
+	bool skipResult = checkUpdateCounts(counters, counts, frames);
+
+	array<vector3df> expected;
+	for (u32 i=0; i<movingNodes.size(); ++i)
+		expected.push_back(movingNodes[i]->getAbsolutePosition());
+
+	// animate the same frames again in parallel
+	smgr->getParameters()->setAttribute(PARALLEL_ANIMATION_THREADS, 4);
+	smgr->getRootSceneNode()->OnAnimate(0);
+	resetUpdateCounts(counters, counts);
+	drawFrames(device, 1, frames, "Parallel animation");
+	skipResult &= checkUpdateCounts(counters, counts, frames);
+	smgr->getParameters()->setAttribute(PARALLEL_ANIMATION_THREADS, 0);
+
+	bool result = true;
+	for (u32 i=0; i<movingNodes.size(); ++i)
+		result &= expected[i].equals(movingNodes[i]->getAbsolutePosition());
+	if (!result)
+		logTestString("Parallel animation gave different results.\n");
+
+	// and with the flat transform hierarchy
+	smgr->getParameters()->setAttribute(FLAT_TRANSFORM_HIERARCHY, true);
+	drawFrames(device, 0, 1, "Building the flat transform hierarchy");
+	resetUpdateCounts(counters, counts);
+	drawFrames(device, 1, frames, "Flat transform hierarchy");
+	skipResult &= checkUpdateCounts(counters, counts, frames);
+	if (!skipResult)
+		logTestString("Absolute transformations of static nodes were recalculated.\n");
+	smgr->getParameters()->setAttribute(FLAT_TRANSFORM_HIERARCHY, false);
+
+	bool flatResult = true;
+	for (u32 i=0; i<movingNodes.size(); ++i)
+		flatResult &= expected[i].equals(movingNodes[i]->getAbsolutePosition());
+	if (!flatResult)
+		logTestString("Flat transform hierarchy gave different results.\n");
+
+	// switching back to recursive updates
+	smgr->getRootSceneNode()->OnAnimate(frames*16);
+	for (u32 i=0; i<movingNodes.size(); ++i)
+		flatResult &= expected[i].equals(movingNodes[i]->getAbsolutePosition());
+
+	smgr->clear();
+
+	return result && flatResult && skipResult;
+}
+
+// The jobs of the animation threads follow changes of the scene.
+bool changingScene(ISceneManager* smgr)
+{
+	smgr->getParameters()->setAttribute(PARALLEL_ANIMATION_THREADS, 4);
+
+	array<ISceneNode*> nodes;
+	for (u32 i=0; i<8; ++i)
+		nodes.push_back(smgr->addEmptySceneNode());
+	smgr->getRootSceneNode()->OnAnimate(0);
+
+	// new nodes are animated
+	ISceneNode* added = smgr->addEmptySceneNode();
+	ISceneNode* child = smgr->addEmptySceneNode(nodes[3]);
+	added->setPosition(vector3df(1,2,3));
+	child->setPosition(vector3df(4,5,6));
+	smgr->getRootSceneNode()->OnAnimate(10);
+	bool result = added->getAbsolutePosition().equals(vector3df(1,2,3));
+	result &= child->getAbsolutePosition().equals(vector3df(4,5,6));
+
+	// deleted nodes are not animated anymore
+	nodes[5]->remove();
+	nodes[6]->remove();
+	smgr->getRootSceneNode()->OnAnimate(20);
+
+	// moved nodes follow their new parent
+	child->setParent(nodes[7]);
+	nodes[7]->setPosition(vector3df(10,0,0));
+	added->setPosition(vector3df(3,2,1));
+	smgr->getRootSceneNode()->OnAnimate(30);
+	result &= child->getAbsolutePosition().equals(vector3df(14,5,6));
+	result &= added->getAbsolutePosition().equals(vector3df(3,2,1));
+
+	// all nodes are gone
+	smgr->clear();
+	smgr->getRootSceneNode()->OnAnimate(40);
+	added = smgr->addEmptySceneNode();
+	smgr->addEmptySceneNode();
+	added->setPosition(vector3df(7,7,7));
+	smgr->getRootSceneNode()->OnAnimate(50);
+	result &= added->getAbsolutePosition().equals(vector3df(7,7,7));
+
+	smgr->getParameters()->setAttribute(PARALLEL_ANIMATION_THREADS, 0);
+	smgr->clear();
+
+	if (!result)
+		logTestString("Parallel animation missed changes of the scene.\n");
+	return result;
+}
+
+// Lets nodes fall onto a hilly plane with collision response animators and returns their positions
+void fallOntoPlane(ISceneManager* smgr, ITriangleSelector* world, s32 threads, array<vector3df>& positions)
+{
+	smgr->getParameters()->setAttribute(PARALLEL_ANIMATION_THREADS, threads);
+
+	array<ISceneNode*> nodes;
+	for (u32 i=0; i<32; ++i)
+	{
+		ISceneNode* node = smgr->addEmptySceneNode(0, -1);
+		node->setPosition(vector3df((f32)(i%8)*20.f - 70.f, 50.f, (f32)(i/8)*20.f - 30.f));
+		ISceneNodeAnimator* anim = smgr->createCollisionResponseAnimator(world, node,
+			vector3df(2,4,2), vector3df(0,-200.f,0));
+		node->addAnimator(anim);
+		anim->drop();
+		nodes.push_back(node);
+	}
+
+	for (u32 frame=1; frame<=50; ++frame)
+	{
+		for (u32 i=0; i<nodes.size(); ++i)
+			nodes[i]->setPosition(nodes[i]->getPosition() + vector3df(0.5f, 0, 0.25f));
+		smgr->getRootSceneNode()->OnAnimate(frame*20);
+	}
+
+	positions.set_used(0);
+	for (u32 i=0; i<nodes.size(); ++i)
+	{
+		positions.push_back(nodes[i]->getAbsolutePosition());
+		nodes[i]->remove();
+	}
+	smgr->getParameters()->setAttribute(PARALLEL_ANIMATION_THREADS, 0);
+}
+
+// Collision response animators can share a world in parallel.
+bool collisionResponse(ISceneManager* smgr)
+{
+	IAnimatedMesh* plane = smgr->addHillPlaneMesh("hills", dimension2df(8,8), dimension2du(32,32), 0, 10.f, dimension2df(4,4));
+	IMeshSceneNode* ground = smgr->addMeshSceneNode(plane->getMesh(0));
+	ITriangleSelector* world = smgr->createTriangleSelector(plane->getMesh(0), ground);
+
+	array<vector3df> expected;
+	fallOntoPlane(smgr, world, 0, expected);
+	array<vector3df> positions;
+	fallOntoPlane(smgr, world, 4, positions);
+
+	bool result = true;
+	for (u32 i=0; i<expected.size(); ++i)
+		result &= expected[i].equals(positions[i]) && expected[i].Y < 20.f;
+	if (!result)
+		logTestString("Collision response animators gave different results in parallel.\n");
+
+	world->drop();
+	smgr->clear();
+	smgr->getMeshCache()->removeMesh(plane);
+	return result;
+}
+
+// Nodes sharing a skinned mesh get the same animation in parallel as sequentially.
+bool sharedMeshes(IrrlichtDevice* device)
+{
+	ISceneManager* smgr = device->getSceneManager();
+	IAnimatedMesh* mesh = smgr->getMesh("../media/ninja.b3d");
+	if (!mesh)
+	{
+		logTestString("Could not load ninja.b3d.\n");
+		return false;
+	}
+
+	const u32 nodeCount = 16;
+	array<IAnimatedMeshSceneNode*> nodes;
+	for (u32 i=0; i<nodeCount; ++i)
+	{
+		// some of them below another top-level node
+		ISceneNode* parent = (i % 4 == 0) ? smgr->addEmptySceneNode() : 0;
+		IAnimatedMeshSceneNode* node = smgr->addAnimatedMeshSceneNode(mesh, parent);
+		node->setAnimationSpeed(0.f);
+		nodes.push_back(node);
+	}
+
+	const u32 frames = 10;
+	const s32 frameCount = mesh->getFrameCount();
+	array<aabbox3df> boxes;
+	bool result = true;
+	for (u32 threads=0; threads<=4; threads+=4)
+	{
+		smgr->getParameters()->setAttribute(PARALLEL_ANIMATION_THREADS, (s32)threads);
+		for (u32 frame=0; frame<frames; ++frame)
+		{
+			for (u32 i=0; i<nodeCount; ++i)
+				nodes[i]->setCurrentFrame((f32)((i*37 + frame*11) % frameCount));
+			smgr->getRootSceneNode()->OnAnimate(frame*16);
+			for (u32 i=0; i<nodeCount; ++i)
+			{
+				if (threads == 0)
+					boxes.push_back(nodes[i]->getBoundingBox());
+				else
+					result &= boxes[frame*nodeCount+i] == nodes[i]->getBoundingBox();
+			}
+		}
+	}
+	smgr->getParameters()->setAttribute(PARALLEL_ANIMATION_THREADS, 0);
+	if (!result)
+		logTestString("Nodes sharing a mesh got different animations in parallel.\n");
+
+	smgr->clear();
+	smgr->getMeshCache()->removeMesh(mesh);
+
+	return result;
+}
+
+} // end anonymous namespace
+
+bool sceneNodeAnimate(void)
+{
+	IrrlichtDevice * device = irr::createDevice(video::EDT_NULL, dimension2d<u32>(160, 120));
+	assert_log(device);
+	if (!device)
+		return false;
+
+	// the frames are drawn at fixed times
+	device->getTimer()->stop();
+
+	ISceneManager* smgr = device->getSceneManager();
+	bool result = transformationUpdates(smgr);
+	smgr->getParameters()->setAttribute(FLAT_TRANSFORM_HIERARCHY, true);
+	result &= transformationUpdates(smgr);
+	smgr->getParameters()->setAttribute(FLAT_TRANSFORM_HIERARCHY, false);
+	result &= largeScene(device);
+	result &= changingScene(smgr);
+	result &= collisionResponse(smgr);
+	result &= sharedMeshes(device);
+
+	device->closeDevice();
+	device->run();
+	device->drop();
+
+	return result;
+}
@@ -0,0 +1,372 @@
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#include "testUtils.h"
+#include <string.h>
+#include <limits.h>
+
+using namespace irr;
+using namespace core;
+using namespace scene;
+
+namespace
+{
+
+// Compares the culling results of drawAll() with single isCulled() checks.
+bool compareWithIsCulled(ISceneManager* smgr, const array<ISceneNode*>& nodes)
+{
+	smgr->drawAll();
+
+	u32 expectedVisible = 0;
+	for (u32 i=0; i<nodes.size(); ++i)
+	{
+		if (!smgr->isCulled(nodes[i]))
+			++expectedVisible;
+	}
+
+	if (smgr->getVisibleNodeCount() != expectedVisible ||
+		smgr->getCulledNodeCount() != nodes.size()-expectedVisible)
+	{
+		logTestString("Culled %u of %u nodes, visible %u, expected %u visible.\n",
+			smgr->getCulledNodeCount(), nodes.size(), smgr->getVisibleNodeCount(), expectedVisible);
+		return false;
+	}
+	return true;
+}
+
+// Batched frustum culling has to give the same results as isCulled()
+bool frustumCulling(IrrlichtDevice* device)
+{
+	ISceneManager* smgr = device->getSceneManager();
+	ITimer* timer = device->getTimer();
+
+	ICameraSceneNode* cam = smgr->addCameraSceneNode(0, vector3df(0,0,0), vector3df(0,0,100));
+	cam->setFarValue(1000.f);
+
+	// boxes are not rotated, so the world space boxes are exact
+	array<ISceneNode*> nodes;
+	const s32 gridSize = 20;
+	for (s32 x=0; x<gridSize; ++x)
+	{
+		for (s32 y=0; y<gridSize; ++y)
+		{
+			for (s32 z=0; z<gridSize; ++z)
+			{
+				const vector3df pos(x*61.3f-600.f, y*59.7f-590.f, z*63.1f-610.f);
+				ISceneNode* node = smgr->addCubeSceneNode(5.f+(x+y+z)%7, 0, -1, pos);
+				node->setAutomaticCulling(EAC_FRUSTUM_BOX);
+				nodes.push_back(node);
+			}
+		}
+	}
+
+	bool result = compareWithIsCulled(smgr, nodes);
+
+	// the culling planes of the last frame are tested first now
+	result &= compareWithIsCulled(smgr, nodes);
+
+	cam->setTarget(vector3df(100,30,0));
+	result &= compareWithIsCulled(smgr, nodes);
+	cam->setPosition(vector3df(200,-100,50));
+	result &= compareWithIsCulled(smgr, nodes);
+
+	// no culling at all without camera
+	smgr->setActiveCamera(0);
+	smgr->drawAll();
+	result &= smgr->getVisibleNodeCount() == nodes.size();
+	result &= smgr->getCulledNodeCount() == 0;
+	smgr->setActiveCamera(cam);
+
+	// compare the time needed for culling
+	const u32 frames = 10;
+	u32 visible = 0;
+	u32 time = timer->getRealTime();
+	for (u32 frame=0; frame<frames; ++frame)
+	{
+		for (u32 i=0; i<nodes.size(); ++i)
+		{
+			if (!smgr->isCulled(nodes[i]))
+				++visible;
+		}
+	}
+	logTestString("isCulled() for %u nodes: %.2f ms per frame, %u visible.\n",
+		nodes.size(), (timer->getRealTime()-time)/(f32)frames, visible/frames);
+
+	time = timer->getRealTime();
+	for (u32 frame=0; frame<frames; ++frame)
+		smgr->drawAll();
+	logTestString("drawAll() with batched culling: %.2f ms per frame, %u visible.\n",
+		(timer->getRealTime()-time)/(f32)frames, smgr->getVisibleNodeCount());
+
+	smgr->clear();
+
+	return result;
+}
+
+// Nodes hidden behind occluders are culled by the software occlusion culling
+bool occlusionCulling(IrrlichtDevice* device)
+{
+	ISceneManager* smgr = device->getSceneManager();
+	ITimer* timer = device->getTimer();
+
+	ICameraSceneNode* cam = smgr->addCameraSceneNode(0, vector3df(0,0,0), vector3df(0,0,100));
+	cam->setFarValue(1000.f);
+
+	ISceneNode* wall = smgr->addCubeSceneNode(1.f, 0, -1, vector3df(0,0,50), vector3df(0,0,0), vector3df(40,40,1));
+	ISceneNode* hidden = smgr->addCubeSceneNode(10.f, 0, -1, vector3df(0,0,200));
+	smgr->addCubeSceneNode(10.f, 0, -1, vector3df(300,0,400));
+	smgr->addCubeSceneNode(5.f, 0, -1, vector3df(0,0,20));
+
+	bool result = true;
+
+	// nothing changes without occluders
+	smgr->getParameters()->setAttribute(SOFTWARE_OCCLUSION_CULLING, 256);
+	smgr->drawAll();
+	result &= smgr->getVisibleNodeCount() == 4;
+
+	smgr->addOccluder(wall);
+	smgr->drawAll();
+	result &= smgr->getVisibleNodeCount() == 3;
+	result &= smgr->getCulledNodeCount() == 1;
+
+	// the occluder only hides what is completely behind it
+	hidden->setPosition(vector3df(0,0,48));
+	smgr->drawAll();
+	result &= smgr->getVisibleNodeCount() == 4;
+	hidden->setPosition(vector3df(0,0,200));
+
+	// occluders of invisible nodes are not used
+	wall->setVisible(false);
+	smgr->drawAll();
+	result &= smgr->getVisibleNodeCount() == 3;
+	result &= smgr->getCulledNodeCount() == 0;
+	wall->setVisible(true);
+
+	// nodes without automatic culling are always drawn
+	hidden->setAutomaticCulling(EAC_OFF);
+	smgr->drawAll();
+	result &= smgr->getVisibleNodeCount() == 4;
+	hidden->setAutomaticCulling(EAC_BOX);
+
+	// removed occluders hide nothing until they are added back
+	wall->grab();
+	wall->remove();
+	smgr->drawAll();
+	result &= smgr->getVisibleNodeCount() == 3;
+	result &= smgr->getCulledNodeCount() == 0;
+	smgr->getRootSceneNode()->addChild(wall);
+	wall->drop();
+	smgr->drawAll();
+	result &= smgr->getVisibleNodeCount() == 3;
+	result &= smgr->getCulledNodeCount() == 1;
+
+	smgr->removeOccluder(wall);
+	smgr->drawAll();
+	result &= smgr->getVisibleNodeCount() == 4;
+
+	if (!result)
+		logTestString("Software occlusion culling failed.\n");
+
+	// a city block: many nodes behind a few large occluders
+	smgr->addOccluder(wall);
+	for (s32 x=0; x<40; ++x)
+	{
+		for (s32 z=0; z<40; ++z)
+			smgr->addCubeSceneNode(4.f, 0, -1, vector3df(x*20.f-400.f, 0, z*20.f+60.f));
+	}
+
+	const u32 frames = 10;
+	smgr->getParameters()->setAttribute(SOFTWARE_OCCLUSION_CULLING, 0);
+	u32 time = timer->getRealTime();
+	for (u32 frame=0; frame<frames; ++frame)
+		smgr->drawAll();
+	logTestString("Without occlusion culling: %.2f ms per frame, %u visible.\n",
+		(timer->getRealTime()-time)/(f32)frames, smgr->getVisibleNodeCount());
+
+	smgr->getParameters()->setAttribute(SOFTWARE_OCCLUSION_CULLING, 256);
+	time = timer->getRealTime();
+	for (u32 frame=0; frame<frames; ++frame)
+		smgr->drawAll();
+	logTestString("With occlusion culling: %.2f ms per frame, %u visible.\n",
+		(timer->getRealTime()-time)/(f32)frames, smgr->getVisibleNodeCount());
+	smgr->getParameters()->setAttribute(SOFTWARE_OCCLUSION_CULLING, 0);
+
+	smgr->clear();
+
+	return result;
+}
+
+// Only the potentially visible faces of a quake3 level are drawn
+bool levelVisibility(IrrlichtDevice* device)
+{
+	ISceneManager* smgr = device->getSceneManager();
+	ITimer* timer = device->getTimer();
+
+	bool result = device->getFileSystem()->addFileArchive("../media/map-20kdm2.pk3");
+	assert_log(result);
+	if (!result)
+		return false;
+
+	IAnimatedMesh* mesh = smgr->getMesh("20kdm2.bsp");
+	assert_log(mesh && mesh->getMeshType() == EAMT_BSP);
+	if (!mesh || mesh->getMeshType() != EAMT_BSP)
+		return false;
+
+	IQ3LevelMesh* level = (IQ3LevelMesh*)mesh;
+	const quake3::SLevelVisibility& visibility = level->getVisibility();
+	result &= visibility.ClusterCount > 0;
+	result &= !visibility.Nodes.empty() && !visibility.Leafs.empty();
+
+	// start at the first spawn point
+	quake3::IEntity search;
+	search.name = "info_player_deathmatch";
+	const s32 index = level->getEntityList().binary_search(search);
+	assert_log(index >= 0);
+	if (index < 0)
+		return false;
+
+	const quake3::SVarGroup* group = level->getEntityList()[index].getGroup(1);
+	u32 parsepos = 0;
+	const vector3df start = quake3::getAsVector3df(group->get("origin"), parsepos);
+
+	ICameraSceneNode* cam = smgr->addCameraSceneNode(0, start, start + vector3df(0,0,100));
+	cam->setFarValue(10000.f);
+
+	IQ3LevelSceneNode* node = smgr->addQuake3LevelSceneNode(level);
+	assert_log(node);
+	if (!node)
+		return false;
+
+	smgr->drawAll();
+	const u32 drawn = node->getDrawnFaceCount();
+	result &= node->getCameraCluster() >= 0;
+	result &= drawn > 0 && drawn < node->getFaceCount();
+	logTestString("Camera cluster %d of %u, %u of %u faces drawn.\n", node->getCameraCluster(),
+		visibility.ClusterCount, drawn, node->getFaceCount());
+
+	// looking into the other direction shows other faces
+	cam->setTarget(start - vector3df(0,0,100));
+	smgr->drawAll();
+	result &= node->getDrawnFaceCount() > 0 && node->getDrawnFaceCount() < node->getFaceCount();
+
+	// the transformation of the node is used for the camera, which is above the level now
+	node->setPosition(vector3df(0,-5000,0));
+	cam->setTarget(start + vector3df(0,-5000,1000));
+	smgr->drawAll();
+	result &= node->getCameraCluster() == -1;
+	result &= node->getDrawnFaceCount() > 0;
+	node->setPosition(vector3df(0,0,0));
+
+	// all faces without visibility culling
+	node->setVisibilityCulling(false);
+	smgr->drawAll();
+	result &= node->getDrawnFaceCount() == node->getFaceCount();
+	node->setVisibilityCulling(true);
+
+	if (!result)
+		logTestString("Visibility culling of the quake3 level failed.\n");
+
+	const u32 frames = 20;
+	u32 time = timer->getRealTime();
+	for (u32 frame=0; frame<frames; ++frame)
+	{
+		cam->setTarget(start + vector3df(sinf(frame*0.3f), 0, cosf(frame*0.3f)) * 100.f);
+		smgr->drawAll();
+	}
+	logTestString("With visibility culling: %.2f ms per frame, %u faces drawn.\n",
+		(timer->getRealTime()-time)/(f32)frames, node->getDrawnFaceCount());
+
+	node->setVisibilityCulling(false);
+	time = timer->getRealTime();
+	for (u32 frame=0; frame<frames; ++frame)
+	{
+		cam->setTarget(start + vector3df(sinf(frame*0.3f), 0, cosf(frame*0.3f)) * 100.f);
+		smgr->drawAll();
+	}
+	logTestString("Without visibility culling: %.2f ms per frame, %u faces drawn.\n",
+		(timer->getRealTime()-time)/(f32)frames, node->getDrawnFaceCount());
+
+	smgr->clear();
+	device->getFileSystem()->removeFileArchive(device->getFileSystem()->getFileArchiveCount()-1);
+
+	return result;
+}
+
+// Loads a copy of a quake3 level whose second BSP node has another front child
+bool loadBrokenTree(IrrlichtDevice* device, const c8* name, const c8* level, u32 levelSize, s32 front)
+{
+	c8* data = new c8[levelSize];
+	memcpy(data, level, levelSize);
+
+	// the nodes are the fourth lump after the magic and version,
+	// each node starts with the plane and the front child
+	s32 nodesOffset;
+	memcpy(&nodesOffset, data + 8 + 3*8, 4);
+	memcpy(data + nodesOffset + 36 + 4, &front, 4);
+
+	io::IReadFile* file = device->getFileSystem()->createMemoryReadFile(data, levelSize, name, true);
+	IAnimatedMesh* mesh = device->getSceneManager()->getMesh(file);
+	file->drop();
+	if (!mesh || mesh->getMeshType() != EAMT_BSP)
+		return false;
+
+	// a valid tree would end in a leaf, the broken one is not used
+	const quake3::SLevelVisibility& visibility = ((IQ3LevelMesh*)mesh)->getVisibility();
+	bool result = visibility.Nodes.empty();
+	if (result)
+		result &= visibility.getCluster(vector3df(0,0,0)) == -1;
+	device->getSceneManager()->getMeshCache()->removeMesh(mesh);
+	return result;
+}
+
+// Levels with broken BSP trees are loaded without visibility information
+bool brokenLevelVisibility(IrrlichtDevice* device)
+{
+	bool result = device->getFileSystem()->addFileArchive("../media/map-20kdm2.pk3");
+	assert_log(result);
+	if (!result)
+		return false;
+
+	io::IReadFile* file = device->getFileSystem()->createAndOpenFile("20kdm2.bsp");
+	assert_log(file);
+	if (!file)
+		return false;
+	const u32 size = (u32)file->getSize();
+	c8* level = new c8[size];
+	result = file->read(level, size) == (s32)size;
+	file->drop();
+
+	// the child is the node itself, an earlier node or out of range
+	result &= loadBrokenTree(device, "brokenSelf.bsp", level, size, 1);
+	result &= loadBrokenTree(device, "brokenLoop.bsp", level, size, 0);
+	result &= loadBrokenTree(device, "brokenMax.bsp", level, size, INT_MAX);
+	result &= loadBrokenTree(device, "brokenMin.bsp", level, size, INT_MIN);
+	delete [] level;
+
+	device->getFileSystem()->removeFileArchive(device->getFileSystem()->getFileArchiveCount()-1);
+
+	if (!result)
+		logTestString("Broken BSP trees of quake3 levels were used.\n");
+	return result;
+}
+
+} // end anonymous namespace
+
+bool sceneNodeCulling(void)
+{
+	IrrlichtDevice * device = irr::createDevice(video::EDT_NULL, dimension2d<u32>(160, 120));
+	assert_log(device);
+	if (!device)
+		return false;
+
+	bool result = frustumCulling(device);
+	result &= occlusionCulling(device);
+	result &= levelVisibility(device);
+	result &= brokenLevelVisibility(device);
+
+	device->closeDevice();
+	device->run();
+	device->drop();
+
+	return result;
+}
@@ -0,0 +1,117 @@
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#include "testUtils.h"
+
+using namespace irr;
+using namespace core;
+using namespace scene;
+using namespace video;
+
+namespace
+{
+
+// Replaces the dynamic lights by lights at the positions
+void setLights(IVideoDriver* driver, const vector3df* positions, u32 count)
+{
+	driver->deleteAllDynamicLights();
+	SLight light;
+	light.Radius = 100.f;
+	for (u32 i=0; i<count; ++i)
+	{
+		light.Position = positions[i];
+		driver->addDynamicLight(light);
+	}
+}
+
+// Counts the shadow volumes rebuilt by a sequence of updates
+void countRebuiltVolumes(u32 threadCount, array<u32>& counts)
+{
+	IrrlichtDevice* device = createDevice(EDT_NULL, dimension2d<u32>(160, 120));
+	if (!device)
+		return;
+	ISceneManager* smgr = device->getSceneManager();
+	IVideoDriver* driver = device->getVideoDriver();
+
+	IMesh* mesh = smgr->getGeometryCreator()->createSphereMesh(5.f, 16, 16);
+	IMeshSceneNode* node = smgr->addMeshSceneNode(mesh);
+	node->updateAbsolutePosition();
+	IShadowVolumeSceneNode* shadow = node->addShadowVolumeSceneNode();
+	shadow->setUpdateThreadCount(threadCount);
+
+	vector3df lights[4];
+	for (u32 i=0; i<4; ++i)
+		lights[i].set(20.f*i - 30.f, 40.f, 10.f);
+	setLights(driver, lights, 4);
+	shadow->updateShadowVolumes();
+	counts.push_back(shadow->getRebuiltVolumeCount());
+
+	// nothing changed
+	shadow->updateShadowVolumes();
+	counts.push_back(shadow->getRebuiltVolumeCount());
+
+	// one light moved
+	lights[2].Y = 50.f;
+	setLights(driver, lights, 4);
+	shadow->updateShadowVolumes();
+	counts.push_back(shadow->getRebuiltVolumeCount());
+
+	// the node moved relative to all lights
+	node->setPosition(vector3df(0.f, 5.f, 0.f));
+	node->updateAbsolutePosition();
+	shadow->updateShadowVolumes();
+	counts.push_back(shadow->getRebuiltVolumeCount());
+
+	// the mesh changed
+	mesh->getMeshBuffer(0)->setDirty(EBT_VERTEX);
+	shadow->updateShadowVolumes();
+	counts.push_back(shadow->getRebuiltVolumeCount());
+
+	// a single light keeps its volume, then moves, then the node moves
+	setLights(driver, lights, 1);
+	shadow->updateShadowVolumes();
+	counts.push_back(shadow->getRebuiltVolumeCount());
+	lights[0].Y = 30.f;
+	setLights(driver, lights, 1);
+	shadow->updateShadowVolumes();
+	counts.push_back(shadow->getRebuiltVolumeCount());
+	node->setPosition(vector3df(0.f, 0.f, 0.f));
+	node->updateAbsolutePosition();
+	shadow->updateShadowVolumes();
+	counts.push_back(shadow->getRebuiltVolumeCount());
+
+	mesh->drop();
+	device->closeDevice();
+	device->run();
+	device->drop();
+}
+
+} // end anonymous namespace
+
+// Shadow volumes are only rebuilt for changed lights, nodes and meshes
+bool shadowVolumeCache(void)
+{
+	array<u32> counts;
+	countRebuiltVolumes(1, counts);
+	array<u32> threadedCounts;
+	countRebuiltVolumes(4, threadedCounts);
+
+	const u32 expected[] = {4, 0, 1, 4, 4, 0, 1, 1};
+	bool result = counts.size() == sizeof(expected)/sizeof(expected[0]);
+	for (u32 i=0; result && i<counts.size(); ++i)
+	{
+		if (counts[i] != expected[i])
+		{
+			logTestString("Update %u rebuilt %u shadow volumes instead of %u.\n", i, counts[i], expected[i]);
+			result = false;
+		}
+	}
+
+	// threads only change who builds the volumes
+	result &= threadedCounts.size() == counts.size();
+	for (u32 i=0; result && i<counts.size(); ++i)
+		result &= threadedCounts[i] == counts[i];
+
+	assert_log(result);
+	return result;
+}
@@ -0,0 +1,253 @@
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#include "testUtils.h"
+
+using namespace irr;
+using namespace core;
+using namespace scene;
+using namespace video;
+
+namespace
+{
+
+// Counts how often it is rendered
+class CRenderCountingSceneNode : public ISceneNode
+{
+public:
+	CRenderCountingSceneNode(ISceneNode* parent, ISceneManager* mgr)
+		: ISceneNode(parent, mgr), Renders(0)
+	{
+		Box.reset(0.f, 0.f, 0.f);
+	}
+
+	virtual void OnRegisterSceneNode()
+	{
+		if (IsVisible)
+			SceneManager->registerNodeForRendering(this);
+		ISceneNode::OnRegisterSceneNode();
+	}
+
+	virtual void render()
+	{
+		++Renders;
+	}
+
+	virtual const aabbox3df& getBoundingBox() const
+	{
+		return Box;
+	}
+
+	aabbox3df Box;
+	u32 Renders;
+};
+
+// Adds a grid of cubes with two different materials and triangle selectors
+void addCubes(ISceneManager* smgr, array<ISceneNode*>& nodes, u32 size)
+{
+	for (u32 z=0; z<size; ++z)
+	{
+		for (u32 x=0; x<size; ++x)
+		{
+			IMeshSceneNode* cube = smgr->addCubeSceneNode(2.f, 0, -1,
+				vector3df(x*10.f, 0.f, z*10.f), vector3df(0, x*30.f, 0));
+			cube->getMaterial(0).Lighting = false;
+			cube->getMaterial(0).Wireframe = ((x+z) & 1) != 0;
+			ITriangleSelector* selector = smgr->createTriangleSelector(cube->getMesh(), cube);
+			cube->setTriangleSelector(selector);
+			selector->drop();
+			nodes.push_back(cube);
+		}
+	}
+}
+
+// Returns an index of a mesh buffer with 16 or 32 bit indices
+u32 getIndex(IMeshBuffer* mb, u32 i)
+{
+	if (mb->getIndexType() == EIT_32BIT)
+		return ((const u32*)mb->getIndices())[i];
+	return mb->getIndices()[i];
+}
+
+// Cubes are merged by material, still drawn and still picked
+bool batchCubes(IrrlichtDevice* device)
+{
+	ISceneManager* smgr = device->getSceneManager();
+	array<ISceneNode*> nodes;
+	addCubes(smgr, nodes, 10);
+	CRenderCountingSceneNode* child = new CRenderCountingSceneNode(nodes[0], smgr);
+
+	IBatchedMeshSceneNode* batch = smgr->addBatchedMeshSceneNode(nodes);
+	IMesh* mesh = batch->getMesh();
+
+	bool result = batch->getSourceNodeCount() == 100;
+	result &= mesh->getMeshBufferCount() == 2;
+	result &= batch->getMaterialCount() == 2;
+	result &= batch->getMaterial(0).Wireframe != batch->getMaterial(1).Wireframe;
+	for (u32 i=0; i<nodes.size(); ++i)
+		result &= nodes[i]->isVisible() && !((IMeshSceneNode*)nodes[i])->isMeshVisible();
+
+	// batching the nodes again adds nothing
+	IBatchedMeshSceneNode* again = smgr->addBatchedMeshSceneNode(nodes);
+	result &= again->getSourceNodeCount() == 0;
+	again->remove();
+
+	u32 indexCount = 0;
+	for (u32 b=0; b<mesh->getMeshBufferCount(); ++b)
+	{
+		IMeshBuffer* mb = mesh->getMeshBuffer(b);
+		indexCount += mb->getIndexCount();
+		result &= mb->getIndexType() == EIT_16BIT;
+
+		// each triangle is inside the node it was created from
+		for (u32 t=0; t<mb->getIndexCount()/3; ++t)
+		{
+			ISceneNode* source = batch->getSourceNode(b, t);
+			result &= source && source->getMaterial(0).Wireframe == mb->getMaterial().Wireframe;
+			if (!source)
+				continue;
+			aabbox3df box = source->getTransformedBoundingBox();
+			box.MinEdge -= vector3df(0.01f);
+			box.MaxEdge += vector3df(0.01f);
+			for (u32 k=0; k<3; ++k)
+				result &= box.isPointInside(mb->getPosition(getIndex(mb, t*3+k)));
+		}
+		result &= batch->getSourceNode(b, mb->getIndexCount()/3) == 0;
+	}
+	result &= indexCount == 100*36;
+	result &= batch->getBoundingBox().isPointInside(vector3df(90.f, 0.f, 90.f));
+
+	// the camera sees all chunks, the cubes are only drawn by the batch,
+	// but their children are still rendered
+	ICameraSceneNode* camera = smgr->addCameraSceneNode(0, vector3df(45.f, 100.f, -60.f), vector3df(45.f, 0.f, 45.f));
+	device->getVideoDriver()->beginScene(true, true, SColor(255,0,0,0));
+	smgr->drawAll();
+	device->getVideoDriver()->endScene();
+	result &= batch->getVisibleChunkCount() == 2;
+	result &= device->getVideoDriver()->getPrimitiveCountDrawn() == 100*12;
+	result &= child->Renders == 1;
+	child->drop();
+
+	// picking reports the original cube
+	SCollisionHit hit;
+	const line3df ray(vector3df(30.f, 50.f, 40.f), vector3df(30.f, -50.f, 40.f));
+	ISceneNode* picked = smgr->getSceneCollisionManager()->getSceneNodeAndCollisionPointFromRay(hit, ray);
+	result &= picked == nodes[4*10+3];
+	result &= equals(hit.Intersection.Y, 1.f, 0.01f);
+
+	camera->remove();
+	batch->remove();
+	for (u32 i=0; i<nodes.size(); ++i)
+		nodes[i]->remove();
+
+	assert_log(result);
+	return result;
+}
+
+// Small chunks are culled on their own
+bool cullChunks(IrrlichtDevice* device)
+{
+	ISceneManager* smgr = device->getSceneManager();
+	array<ISceneNode*> nodes;
+	addCubes(smgr, nodes, 16);
+
+	// four cubes with 12 vertices per chunk
+	IBatchedMeshSceneNode* batch = smgr->addBatchedMeshSceneNode(nodes, 0, -1, 12*4);
+	const u32 chunkCount = batch->getMesh()->getMeshBufferCount();
+	bool result = chunkCount == 64;
+
+	// chunks are built from cubes close to each other
+	for (u32 b=0; b<chunkCount; ++b)
+	{
+		const aabbox3df& box = batch->getMesh()->getMeshBuffer(b)->getBoundingBox();
+		result &= box.getExtent().X + box.getExtent().Z < 50.f;
+	}
+
+	// looking at one corner of the grid
+	ICameraSceneNode* camera = smgr->addCameraSceneNode(0, vector3df(-10.f, 5.f, -10.f), vector3df(0.f, 0.f, 0.f));
+	camera->setFarValue(40.f);
+	device->getVideoDriver()->beginScene(true, true, SColor(255,0,0,0));
+	smgr->drawAll();
+	device->getVideoDriver()->endScene();
+	logTestString("%u of %u chunks visible.\n", batch->getVisibleChunkCount(), chunkCount);
+	result &= batch->getVisibleChunkCount() > 0;
+	result &= batch->getVisibleChunkCount() < chunkCount/4;
+
+	camera->remove();
+	batch->remove();
+	for (u32 i=0; i<nodes.size(); ++i)
+		nodes[i]->remove();
+
+	assert_log(result);
+	return result;
+}
+
+// Large chunks get 32 bit indices, mirrored nodes keep their winding
+// and transparent nodes are left alone
+bool batchSpecialNodes(IrrlichtDevice* device)
+{
+	ISceneManager* smgr = device->getSceneManager();
+	array<ISceneNode*> nodes;
+	for (u32 i=0; i<3; ++i)
+	{
+		// the second one is mirrored
+		nodes.push_back(smgr->addSphereSceneNode(5.f, 180, 0, -1, vector3df(i*20.f, 0.f, 0.f),
+			vector3df(0,0,0), vector3df(i==1 ? -1.f : 1.f, 1.f, 1.f)));
+	}
+	IMeshSceneNode* transparent = smgr->addCubeSceneNode();
+	transparent->setMaterialType(EMT_TRANSPARENT_ADD_COLOR);
+	nodes.push_back(transparent);
+
+	IBatchedMeshSceneNode* batch = smgr->addBatchedMeshSceneNode(nodes, 0, -1, 200000);
+	IMeshBuffer* mb = batch->getMesh()->getMeshBuffer(0);
+
+	bool result = batch->getSourceNodeCount() == 3;
+	result &= transparent->isVisible();
+	result &= batch->getMesh()->getMeshBufferCount() == 1;
+	result &= mb->getVertexCount() > 0x10000;
+	result &= mb->getIndexType() == EIT_32BIT;
+	result &= batch->getTriangleSelector() == 0;
+
+	// all triangles face away from their sphere center
+	for (u32 i=0; i<mb->getIndexCount(); i+=3)
+	{
+		const triangle3df triangle(mb->getPosition(getIndex(mb, i)), mb->getPosition(getIndex(mb, i+1)), mb->getPosition(getIndex(mb, i+2)));
+		const vector3df normal = triangle.getNormal();
+		if (normal.getLengthSQ() < 0.0001f)
+			continue;
+		const vector3df center = batch->getSourceNode(0, i/3)->getAbsolutePosition();
+		if (normal.dotProduct(triangle.pointA - center) <= 0.f)
+		{
+			result = false;
+			break;
+		}
+		result &= mb->getNormal(getIndex(mb, i)).dotProduct(triangle.pointA - center) > 0.f;
+	}
+
+	batch->remove();
+	for (u32 i=0; i<nodes.size(); ++i)
+		nodes[i]->remove();
+
+	assert_log(result);
+	return result;
+}
+
+} // end anonymous namespace
+
+bool staticBatching(void)
+{
+	IrrlichtDevice * device = irr::createDevice(video::EDT_NULL, dimension2d<u32>(160, 120));
+	assert_log(device);
+	if (!device)
+		return false;
+
+	bool result = batchCubes(device);
+	result &= cullChunks(device);
+	result &= batchSpecialNodes(device);
+
+	device->closeDevice();
+	device->run();
+	device->drop();
+
+	return result;
+}
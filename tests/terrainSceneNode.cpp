@@ -117,12 +117,366 @@ bool terrainGaps()
 	return result;
 }
 
+// Collects the vertices of a patch on one line of the terrain grid, sorted
+void getLineVertices(const array<u32>& indices, u32 size, bool alongX, u32 line, array<u32>& vertices)
+{
+	vertices.set_used(0);
+	for (u32 i=0; i<indices.size(); ++i)
+	{
+		const u32 x = indices[i] % size;
+		const u32 z = indices[i] / size;
+		if ((alongX ? z : x) == line && vertices.linear_search(indices[i]) == -1)
+			vertices.push_back(indices[i]);
+	}
+	vertices.sort();
+}
+
+// Patches cover their area without degenerated triangles and share the border vertices of their neighbours
+bool checkPatches(scene::ITerrainSceneNode* terrain, u32 size, u32 patchSize, array<u32>& allIndices)
+{
+	const s32 patchCount = (size-1) / patchSize;
+	allIndices.set_used(0);
+
+	bool result = true;
+	array<u32> indices;
+	array<u32> neighbourIndices;
+	array<u32> vertices;
+	array<u32> neighbourVertices;
+	for (s32 x=0; x<patchCount; ++x)
+	{
+		for (s32 z=0; z<patchCount; ++z)
+		{
+			if (terrain->getIndicesForPatch(indices, x, z, -1) < 0)
+				continue;
+			for (u32 i=0; i<indices.size(); ++i)
+				allIndices.push_back(indices[i]);
+
+			// twice the area in grid coordinates, the same winding for all triangles
+			s32 area = 0;
+			for (u32 i=0; i+2<indices.size(); i+=3)
+			{
+				const s32 x0 = indices[i] % size, z0 = indices[i] / size;
+				const s32 x1 = indices[i+1] % size, z1 = indices[i+1] / size;
+				const s32 x2 = indices[i+2] % size, z2 = indices[i+2] / size;
+				const s32 a = (x1-x0)*(z2-z0) - (z1-z0)*(x2-x0);
+				result &= a > 0;
+				area += a;
+			}
+			result &= area == (s32)(patchSize*patchSize*2);
+
+			// bottom and right neighbour, if visible
+			if (x+1 < patchCount && terrain->getIndicesForPatch(neighbourIndices, x+1, z, -1) >= 0)
+			{
+				getLineVertices(indices, size, true, (x+1)*patchSize, vertices);
+				getLineVertices(neighbourIndices, size, true, (x+1)*patchSize, neighbourVertices);
+				result &= vertices == neighbourVertices;
+			}
+			if (z+1 < patchCount && terrain->getIndicesForPatch(neighbourIndices, x, z+1, -1) >= 0)
+			{
+				getLineVertices(indices, size, false, (z+1)*patchSize, vertices);
+				getLineVertices(neighbourIndices, size, false, (z+1)*patchSize, neighbourVertices);
+				result &= vertices == neighbourVertices;
+			}
+		}
+	}
+	return result;
+}
+
+// Index generation from the templates, stitching of different LODs and updates of changed patches
+bool terrainStitching()
+{
+	IrrlichtDevice* device = createDevice(video::EDT_NULL, dimension2d<u32>(160, 120));
+	if (!device)
+		return true;
+
+	video::IVideoDriver* driver = device->getVideoDriver();
+	scene::ISceneManager* smgr = device->getSceneManager();
+
+	scene::ITerrainSceneNode* terrain = smgr->addTerrainSceneNode("../media/terrain-heightmap.bmp");
+	terrain->setScale(core::vector3df(40.f, .1f, 40.f));
+	// a mix of LODs from the distance thresholds
+	terrain->setMaxScreenSpaceError(0.f);
+	const u32 size = (u32)sqrtf((f32)terrain->getMesh()->getMeshBuffer(0)->getVertexCount());
+
+	scene::ICameraSceneNode* camera = smgr->addCameraSceneNode(0, vector3df(100.f, 100.f, 100.f),
+		terrain->getTerrainCenter());
+	camera->setFarValue(20000.f);
+
+	driver->beginScene();
+	smgr->drawAll();
+	driver->endScene();
+
+	// the render buffer contains the indices of all visible patches
+	array<u32> allIndices;
+	bool result = checkPatches(terrain, size, 16, allIndices);
+	array<s32> lods;
+	terrain->getCurrentLODOfPatches(lods);
+	lods.sort();
+	result &= lods[0] == 0 && lods.getLast() > 1;
+	result &= allIndices.size() == terrain->getIndexCount();
+	result &= driver->getPrimitiveCountDrawn() == allIndices.size()/3;
+	const scene::IMeshBuffer* mb = terrain->getRenderBuffer();
+	for (u32 i=0; result && i<allIndices.size(); ++i)
+		result &= mb->getIndices()[i] == allIndices[i];
+
+	// neighbours which differ by several LODs
+	for (s32 x=0; x<15; ++x)
+		for (s32 z=0; z<15; ++z)
+			terrain->setLODOfPatch(x, z, (x*3+z) % 5);
+	result &= checkPatches(terrain, size, 16, allIndices);
+
+	// only some patches change when the camera moves
+	camera->setPosition(vector3df(3000.f, 100.f, 3000.f));
+	driver->beginScene();
+	smgr->drawAll();
+	driver->endScene();
+
+	result &= checkPatches(terrain, size, 16, allIndices);
+	result &= allIndices.size() == terrain->getIndexCount();
+	result &= driver->getPrimitiveCountDrawn() == allIndices.size()/3;
+	for (u32 i=0; result && i<allIndices.size(); ++i)
+		result &= mb->getIndices()[i] == allIndices[i];
+
+	if (!result)
+		logTestString("Terrain patches are not stitched correctly.\n");
+
+	device->closeDevice();
+	device->run();
+	device->drop();
+	return result;
+}
+
+// Returns a vertex of the indices drawn by a terrain
+const video::S3DVertex2TCoords& getDrawnVertex(scene::ITerrainSceneNode* terrain, u32 i)
+{
+	const scene::IMeshBuffer* mb = terrain->getRenderBuffer();
+	const u32 index = (mb->getIndexType() == video::EIT_32BIT) ? ((const u32*)mb->getIndices())[i] : mb->getIndices()[i];
+	return ((const video::S3DVertex2TCoords*)mb->getVertices())[index];
+}
+
+// Both terrains draw the same triangles
+bool compareDrawnVertices(scene::ITerrainSceneNode* terrain, scene::ITerrainSceneNode* compact, f32 tolerance)
+{
+	bool result = terrain->getIndexCount() == compact->getIndexCount();
+	f32 normalDots = 0.f;
+	for (u32 i=0; result && i<terrain->getIndexCount(); ++i)
+	{
+		const video::S3DVertex2TCoords& a = getDrawnVertex(terrain, i);
+		const video::S3DVertex2TCoords& b = getDrawnVertex(compact, i);
+		result &= a.Pos.equals(b.Pos, tolerance);
+		result &= a.TCoords.equals(b.TCoords) && a.TCoords2.equals(b.TCoords2);
+		result &= a.Color == b.Color;
+		normalDots += a.Normal.dotProduct(b.Normal);
+	}
+	// the normals are calculated differently, but similar
+	if (terrain->getIndexCount())
+		result &= normalDots / terrain->getIndexCount() > 0.99f;
+	return result;
+}
+
+// Compact storage keeps only the heights and rebuilds the vertices of visible patches
+bool terrainCompactStorage()
+{
+	IrrlichtDevice* device = createDevice(video::EDT_NULL, dimension2d<u32>(160, 120));
+	if (!device)
+		return true;
+
+	video::IVideoDriver* driver = device->getVideoDriver();
+	scene::ISceneManager* smgr = device->getSceneManager();
+
+	scene::ITerrainSceneNode* terrain = smgr->addTerrainSceneNode("../media/terrain-heightmap.bmp");
+	smgr->getParameters()->setAttribute(scene::TERRAIN_COMPACT_STORAGE, true);
+	scene::ITerrainSceneNode* compact = smgr->addTerrainSceneNode("../media/terrain-heightmap.bmp");
+	smgr->getParameters()->setAttribute(scene::TERRAIN_COMPACT_STORAGE, false);
+	terrain->setScale(core::vector3df(40.f, .1f, 40.f));
+	compact->setScale(core::vector3df(40.f, .1f, 40.f));
+	const u32 size = (u32)sqrtf((f32)terrain->getMesh()->getMeshBuffer(0)->getVertexCount());
+	// heights are stored with 16 bits
+	const f32 tolerance = 256.f/65535.f * .1f;
+
+	bool result = compact->getMesh()->getMeshBuffer(0)->getVertexCount() == 0;
+	result &= compact->getBoundingBox().MinEdge.equals(terrain->getBoundingBox().MinEdge, tolerance);
+	result &= compact->getBoundingBox().MaxEdge.equals(terrain->getBoundingBox().MaxEdge, tolerance);
+
+	scene::ICameraSceneNode* camera = smgr->addCameraSceneNode(0, vector3df(100.f, 100.f, 100.f),
+		terrain->getTerrainCenter());
+	camera->setFarValue(4000.f);
+
+	compact->setVisible(false);
+	driver->beginScene();
+	smgr->drawAll();
+	driver->endScene();
+	const u32 drawn = driver->getPrimitiveCountDrawn();
+
+	terrain->setVisible(false);
+	compact->setVisible(true);
+	driver->beginScene();
+	smgr->drawAll();
+	driver->endScene();
+	result &= drawn == driver->getPrimitiveCountDrawn();
+	terrain->setVisible(true);
+
+	// only the visible patches have vertices
+	array<s32> lods;
+	array<s32> compactLods;
+	terrain->getCurrentLODOfPatches(lods);
+	compact->getCurrentLODOfPatches(compactLods);
+	result &= lods == compactLods;
+	u32 visible = 0;
+	for (u32 i=0; i<compactLods.size(); ++i)
+		visible += compactLods[i] >= 0;
+	logTestString("%u of %u patches visible, %u of %u vertices in the render buffer.\n", visible, compactLods.size(),
+		compact->getRenderBuffer()->getVertexCount(), size*size);
+	result &= compact->getRenderBuffer()->getVertexCount() == visible*17*17;
+	result &= visible < compactLods.size();
+
+	// the indices of the patches still refer to the whole terrain
+	array<u32> allIndices;
+	result &= checkPatches(compact, size, 16, allIndices);
+
+	compact->scaleTexture(4.f, 2.f);
+	terrain->scaleTexture(4.f, 2.f);
+	driver->beginScene();
+	smgr->drawAll();
+	driver->endScene();
+	result &= compareDrawnVertices(terrain, compact, tolerance);
+
+	// patches which get visible reuse the vertices of hidden patches
+	camera->setPosition(vector3df(9000.f, 100.f, 9000.f));
+	camera->setTarget(vector3df(5000.f, 0.f, 6000.f));
+	driver->beginScene();
+	smgr->drawAll();
+	driver->endScene();
+	result &= compareDrawnVertices(terrain, compact, tolerance);
+
+	const f32 positions[][2] = { {10.f, 10.f}, {5000.f, 3000.f}, {1234.5f, 8765.4f}, {9000.f, 100.f} };
+	for (u32 i=0; i<sizeof(positions)/sizeof(positions[0]); ++i)
+		result &= equals(terrain->getHeight(positions[i][0], positions[i][1]),
+			compact->getHeight(positions[i][0], positions[i][1]), tolerance);
+	result &= compact->getHeight(-10.f, 10.f) == -FLT_MAX;
+
+	// collision triangles are rebuilt from the heights as well
+	scene::ITriangleSelector* selector = smgr->createTerrainTriangleSelector(terrain, 2);
+	scene::ITriangleSelector* compactSelector = smgr->createTerrainTriangleSelector(compact, 2);
+	result &= selector->getTriangleCount() == compactSelector->getTriangleCount();
+	array<triangle3df> triangles;
+	array<triangle3df> compactTriangles;
+	triangles.set_used(selector->getTriangleCount());
+	compactTriangles.set_used(selector->getTriangleCount());
+	s32 count = 0;
+	s32 compactCount = 0;
+	selector->getTriangles(triangles.pointer(), triangles.size(), count);
+	compactSelector->getTriangles(compactTriangles.pointer(), compactTriangles.size(), compactCount);
+	result &= count > 0 && count == compactCount;
+	for (s32 i=0; result && i<count; ++i)
+		result &= triangles[i].pointA.equals(compactTriangles[i].pointA, tolerance) &&
+			triangles[i].pointB.equals(compactTriangles[i].pointB, tolerance) &&
+			triangles[i].pointC.equals(compactTriangles[i].pointC, tolerance);
+	selector->drop();
+	compactSelector->drop();
+
+	if (!result)
+		logTestString("Compact terrain differs from the terrain.\n");
+
+	device->closeDevice();
+	device->run();
+	device->drop();
+	return result;
+}
+
+
+// Returns the sum of the LODs of the drawn patches
+u32 getDrawnLODSum(scene::ITerrainSceneNode* terrain)
+{
+	u32 sum = 0;
+	for (s32 lod=0; lod<4; ++lod)
+		sum += terrain->getDrawnPatchCount(lod) * lod;
+	return sum;
+}
+
+// LODs follow the error on the screen, patches outside of the frustum planes are not drawn
+bool terrainLODSelection()
+{
+	IrrlichtDevice* device = createDevice(video::EDT_NULL, dimension2d<u32>(160, 120));
+	if (!device)
+		return true;
+
+	video::IVideoDriver* driver = device->getVideoDriver();
+	scene::ISceneManager* smgr = device->getSceneManager();
+
+	scene::ITerrainSceneNode* terrain = smgr->addTerrainSceneNode("../media/terrain-heightmap.bmp");
+	terrain->setScale(core::vector3df(40.f, 4.f, 40.f));
+	bool result = terrain->getMaxScreenSpaceError() == 2.f;
+
+	scene::ICameraSceneNode* camera = smgr->addCameraSceneNode(0, vector3df(100.f, 1500.f, 100.f),
+		terrain->getTerrainCenter());
+	camera->setFarValue(20000.f);
+
+	driver->beginScene();
+	smgr->drawAll();
+	driver->endScene();
+
+	array<s32> lods;
+	terrain->getCurrentLODOfPatches(lods);
+	u32 visible = 0;
+	for (u32 i=0; i<lods.size(); ++i)
+		visible += lods[i] >= 0;
+	logTestString("LODs 0-3: %u %u %u %u\n", terrain->getDrawnPatchCount(0), terrain->getDrawnPatchCount(1),
+		terrain->getDrawnPatchCount(2), terrain->getDrawnPatchCount(3));
+	result &= visible > 0 && terrain->getDrawnPatchCount() == visible;
+	result &= terrain->getDrawnPatchCount(0) + terrain->getDrawnPatchCount(1) +
+		terrain->getDrawnPatchCount(2) + terrain->getDrawnPatchCount(3) == visible;
+	result &= terrain->getDrawnPatchCount(0) < visible && terrain->getDrawnPatchCount(3) < visible;
+	result &= terrain->getDrawnPatchCount(4) == 0;
+	const u32 lodSum = getDrawnLODSum(terrain);
+
+	// a smaller error needs finer LODs
+	terrain->setMaxScreenSpaceError(.5f);
+	driver->beginScene();
+	smgr->drawAll();
+	driver->endScene();
+	result &= terrain->getDrawnPatchCount() == visible;
+	result &= getDrawnLODSum(terrain) < lodSum;
+
+	// flat patches get the coarsest LOD
+	terrain->setScale(core::vector3df(40.f, .0001f, 40.f));
+	driver->beginScene();
+	smgr->drawAll();
+	driver->endScene();
+	result &= terrain->getDrawnPatchCount(3) == terrain->getDrawnPatchCount();
+
+	// the box around the frustum contains the terrain, but the frustum doesn't
+	camera->setPosition(vector3df(-10.f, 100.f, -10.f));
+	camera->setTarget(vector3df(-1000.f, 100.f, -1000.f));
+	camera->setFOV(2.5f);
+	driver->beginScene();
+	smgr->drawAll();
+	driver->endScene();
+	result &= camera->getViewFrustum()->getBoundingBox().intersectsWithBox(terrain->getBoundingBox(0, 0));
+	result &= terrain->getDrawnPatchCount() == 0 && terrain->getIndexCount() == 0;
+
+	// distance thresholds replace the error on the screen
+	terrain->overrideLODDistance(1, 1000.);
+	result &= terrain->getMaxScreenSpaceError() == 0.f;
+
+	if (!result)
+		logTestString("Terrain LODs are not selected correctly.\n");
+
+	device->closeDevice();
+	device->run();
+	device->drop();
+	return result;
+}
+
 }
 
 bool terrainSceneNode()
 {
 	bool result = terrainRecalc();
 	result &= terrainGaps();
+	result &= terrainStitching();
+	result &= terrainCompactStorage();
+	result &= terrainLODSelection();
 	return result;
 }
 
@@ -0,0 +1,148 @@
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#include "testUtils.h"
+
+using namespace irr;
+using namespace core;
+using namespace scene;
+using namespace video;
+
+namespace
+{
+
+const f32 WaveHeight = 0.5f;
+const f32 WaveSpeed = 300.f;
+const f32 WaveLength = 4.f;
+
+// Returns the height of the waves on the original position at the given time
+f32 getWaveHeight(const vector3df& pos, u32 timeMs)
+{
+	const f32 time = timeMs / WaveSpeed;
+	return pos.Y + sinf(pos.X/WaveLength + time)*WaveHeight + cosf(pos.Z/WaveLength + time)*WaveHeight;
+}
+
+// Returns the largest difference between the heights of the node and the given heights
+f32 getHeightError(const IMesh* mesh, const array<f32>& heights)
+{
+	const IMeshBuffer* mb = mesh->getMeshBuffer(0);
+	f32 error = 0.f;
+	for (u32 i=0; i<mb->getVertexCount(); ++i)
+		error = max_(error, fabsf(mb->getPosition(i).Y - heights[i]));
+	return error;
+}
+
+// Draws the scene at the given time
+void drawScene(IrrlichtDevice* device, u32 timeMs)
+{
+	device->getTimer()->setTime(timeMs);
+	device->getVideoDriver()->beginScene(true, true, SColor(255,0,0,0));
+	device->getSceneManager()->drawAll();
+	device->getVideoDriver()->endScene();
+}
+
+// The waves are calculated for visible water only
+bool visibleWaves(IrrlichtDevice* device)
+{
+	ISceneManager* smgr = device->getSceneManager();
+	// 33*33 vertices, which is not a multiple of 4
+	IMesh* plane = smgr->getGeometryCreator()->createPlaneMesh(dimension2df(1.f, 1.f), dimension2du(32, 32));
+	IMeshSceneNode* node = (IMeshSceneNode*)smgr->addWaterSurfaceSceneNode(plane, WaveHeight, WaveSpeed, WaveLength);
+	const IMeshBuffer* original = plane->getMeshBuffer(0);
+	const IMesh* mesh = node->getMesh();
+
+	ICameraSceneNode* camera = smgr->addCameraSceneNode(0, vector3df(0.f, 10.f, -20.f), vector3df(0.f, 0.f, 0.f));
+	array<f32> heights;
+	bool result = true;
+	const u32 times[] = {0, 1234, 5000, 77777};
+	for (u32 t=0; t<sizeof(times)/sizeof(times[0]); ++t)
+	{
+		drawScene(device, times[t]);
+		heights.set_used(0);
+		for (u32 i=0; i<original->getVertexCount(); ++i)
+			heights.push_back(getWaveHeight(original->getPosition(i), times[t]));
+		const f32 error = getHeightError(mesh, heights);
+		logTestString("Time %u: height error %f.\n", times[t], error);
+		result &= error < 0.001f;
+	}
+	result &= mesh->getBoundingBox().MaxEdge.Y >= 2.f*WaveHeight;
+	result &= mesh->getBoundingBox().MinEdge.Y <= -2.f*WaveHeight;
+
+	// the camera looks away, so the waves stay as they were
+	for (u32 i=0; i<heights.size(); ++i)
+		heights[i] = mesh->getMeshBuffer(0)->getPosition(i).Y;
+	camera->setPosition(vector3df(0.f, 10.f, -40.f));
+	camera->setTarget(vector3df(0.f, 10.f, -80.f));
+	drawScene(device, 3000);
+	result &= getHeightError(mesh, heights) == 0.f;
+
+	camera->remove();
+	node->remove();
+	plane->drop();
+
+	assert_log(result);
+	return result;
+}
+
+// The waves are interpolated between the update intervals
+bool updateInterval(IrrlichtDevice* device)
+{
+	ISceneManager* smgr = device->getSceneManager();
+	IMesh* plane = smgr->getGeometryCreator()->createPlaneMesh(dimension2df(1.f, 1.f), dimension2du(16, 16));
+	ISceneNode* node = smgr->addWaterSurfaceSceneNode(plane, WaveHeight, WaveSpeed, WaveLength);
+	io::IAttributes* attributes = device->getFileSystem()->createEmptyAttributes();
+	node->serializeAttributes(attributes);
+	bool result = attributes->getAttributeAsInt("UpdateInterval") == 0;
+	attributes->setAttribute("UpdateInterval", 100);
+	node->deserializeAttributes(attributes);
+	attributes->drop();
+
+	const IMeshBuffer* original = plane->getMeshBuffer(0);
+	const IMesh* mesh = ((IMeshSceneNode*)node)->getMesh();
+	ICameraSceneNode* camera = smgr->addCameraSceneNode(0, vector3df(0.f, 10.f, -20.f), vector3df(0.f, 0.f, 0.f));
+
+	array<f32> heights;
+	const u32 times[] = {1000, 1025, 1099, 1100, 1150, 4321};
+	for (u32 t=0; t<sizeof(times)/sizeof(times[0]); ++t)
+	{
+		drawScene(device, times[t]);
+		const u32 keyTime = times[t] - times[t] % 100;
+		const f32 f = (times[t] - keyTime) / 100.f;
+		heights.set_used(0);
+		for (u32 i=0; i<original->getVertexCount(); ++i)
+		{
+			const vector3df& pos = original->getPosition(i);
+			heights.push_back(lerp(getWaveHeight(pos, keyTime), getWaveHeight(pos, keyTime+100), f));
+		}
+		const f32 error = getHeightError(mesh, heights);
+		logTestString("Interval time %u: height error %f.\n", times[t], error);
+		result &= error < 0.001f;
+	}
+
+	camera->remove();
+	node->remove();
+	plane->drop();
+
+	assert_log(result);
+	return result;
+}
+
+} // end anonymous namespace
+
+bool waterSurface(void)
+{
+	IrrlichtDevice * device = irr::createDevice(video::EDT_NULL, dimension2d<u32>(160, 120));
+	assert_log(device);
+	if (!device)
+		return false;
+
+	device->getTimer()->stop();
+	bool result = visibleWaves(device);
+	result &= updateInterval(device);
+
+	device->closeDevice();
+	device->run();
+	device->drop();
+
+	return result;
+}
@@ -0,0 +1,155 @@
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#include "testUtils.h"
+
+using namespace irr;
+using namespace core;
+using namespace scene;
+using namespace video;
+
+namespace
+{
+
+// Largest angle between the normals of a sphere around the origin and the exact ones
+f32 getSphereNormalError(IMeshBuffer* mb)
+{
+	f32 error = 0.f;
+	for (u32 i=0; i<mb->getVertexCount(); ++i)
+	{
+		const vector3df exact = mb->getPosition(i).normalize();
+		error = max_(error, acosf(clamp(mb->getNormal(i).dotProduct(exact), -1.f, 1.f)) * RADTODEG);
+	}
+	return error;
+}
+
+// Seams where vertices are split for texture coordinates get smooth normals
+bool smoothSeams(IrrlichtDevice* device)
+{
+	IMeshManipulator* manipulator = device->getSceneManager()->getMeshManipulator();
+	IMesh* sphere = device->getSceneManager()->getGeometryCreator()->createSphereMesh(10.f, 32, 32);
+	IMeshBuffer* mb = sphere->getMeshBuffer(0);
+
+	manipulator->recalculateNormals(mb, true, true);
+	const f32 indexed = getSphereNormalError(mb);
+	manipulator->recalculateNormalsWelded(mb);
+	const f32 welded = getSphereNormalError(mb);
+	logTestString("Sphere normal error: %.2f degrees with shared indices, %.2f welded.\n", indexed, welded);
+
+	bool result = welded < 3.f;
+	result &= welded < indexed;
+
+	// vertices at the same position got the same normal
+	for (u32 i=0; i<mb->getVertexCount(); ++i)
+	{
+		for (u32 j=i+1; j<mb->getVertexCount(); ++j)
+		{
+			if (mb->getPosition(i).equals(mb->getPosition(j)))
+				result &= mb->getNormal(i).equals(mb->getNormal(j), 0.0001f);
+		}
+	}
+
+	sphere->drop();
+
+	assert_log(result);
+	return result;
+}
+
+// Edges sharper than the angle limit stay hard
+bool keepHardEdges(IrrlichtDevice* device)
+{
+	IMeshManipulator* manipulator = device->getSceneManager()->getMeshManipulator();
+	IMesh* cube = device->getSceneManager()->getGeometryCreator()->createCubeMesh(vector3df(2.f, 2.f, 2.f));
+	IMesh* split = manipulator->createMeshUniquePrimitives(cube);
+	IMeshBuffer* mb = split->getMeshBuffer(0);
+
+	bool result = true;
+
+	// every corner gets the average of the three sides, each side meets it at 90 degrees
+	manipulator->recalculateNormalsWelded(mb, 180.f);
+	for (u32 i=0; i<mb->getVertexCount(); ++i)
+	{
+		const vector3df& pos = mb->getPosition(i);
+		const vector3df diagonal = vector3df(pos.X > 0.f ? 1.f : -1.f, pos.Y > 0.f ? 1.f : -1.f, pos.Z > 0.f ? 1.f : -1.f).normalize();
+		result &= mb->getNormal(i).equals(diagonal, 0.0001f);
+	}
+
+	// with a limit below 90 degrees each side keeps its own normal
+	manipulator->recalculateNormalsWelded(mb, 45.f);
+	for (u32 i=0; i<mb->getIndexCount(); i+=3)
+	{
+		const u16* idx = mb->getIndices();
+		const vector3df normal = triangle3df(mb->getPosition(idx[i]), mb->getPosition(idx[i+1]), mb->getPosition(idx[i+2])).getNormal().normalize();
+		for (u32 k=0; k<3; ++k)
+			result &= mb->getNormal(idx[i+k]).equals(normal, 0.0001f);
+	}
+
+	split->drop();
+	cube->drop();
+
+	assert_log(result);
+	return result;
+}
+
+// Threads give the same result, tangents stay perpendicular to the normals
+bool parallelTangents(IrrlichtDevice* device)
+{
+	IMeshManipulator* manipulator = device->getSceneManager()->getMeshManipulator();
+	IMesh* hill = device->getSceneManager()->getGeometryCreator()->createHillPlaneMesh(
+		dimension2df(1.f, 1.f), dimension2du(250, 250), 0, 5.f, dimension2df(4.f, 4.f), dimension2df(8.f, 8.f));
+	IMesh* tangents = manipulator->createMeshWithTangents(hill);
+	IMesh* copy = manipulator->createMeshCopy(tangents);
+	IMeshBuffer* single = tangents->getMeshBuffer(0);
+	IMeshBuffer* parallel = copy->getMeshBuffer(0);
+
+	ITimer* timer = device->getTimer();
+	u32 time = timer->getRealTime();
+	manipulator->recalculateNormalsWelded(single, 60.f);
+	const u32 singleTime = timer->getRealTime() - time;
+	time = timer->getRealTime();
+	manipulator->recalculateNormalsWelded(parallel, 60.f, true, ROUNDING_ERROR_f32, 4);
+	const u32 parallelTime = timer->getRealTime() - time;
+	logTestString("%u vertices in %u ms with one thread, %u ms with four.\n",
+		single->getVertexCount(), singleTime, parallelTime);
+
+	bool result = single->getVertexCount() == parallel->getVertexCount();
+	const S3DVertexTangents* a = (const S3DVertexTangents*)single->getVertices();
+	const S3DVertexTangents* b = (const S3DVertexTangents*)parallel->getVertices();
+	for (u32 i=0; i<single->getVertexCount(); ++i)
+	{
+		result &= a[i].Normal == b[i].Normal && a[i].Tangent == b[i].Tangent && a[i].Binormal == b[i].Binormal;
+		result &= equals(a[i].Normal.getLength(), 1.f, 0.001f);
+		result &= equals(a[i].Tangent.getLength(), 1.f, 0.001f);
+		result &= fabsf(a[i].Normal.dotProduct(a[i].Tangent)) < 0.001f;
+		result &= fabsf(a[i].Normal.dotProduct(a[i].Binormal)) < 0.001f;
+		// the hills are not steep, so the normals point up
+		result &= a[i].Normal.Y > 0.5f;
+	}
+
+	copy->drop();
+	tangents->drop();
+	hill->drop();
+
+	assert_log(result);
+	return result;
+}
+
+} // end anonymous namespace
+
+bool weldedNormals(void)
+{
+	IrrlichtDevice * device = irr::createDevice(video::EDT_NULL, dimension2d<u32>(160, 120));
+	assert_log(device);
+	if (!device)
+		return false;
+
+	bool result = smoothSeams(device);
+	result &= keepHardEdges(device);
+	result &= parallelTangents(device);
+
+	device->closeDevice();
+	device->run();
+	device->drop();
+
+	return result;
+}
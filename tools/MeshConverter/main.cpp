@@ -18,7 +18,8 @@ void usage(const char* name)
 	std::cerr << "Usage: " << name << " [options] <srcFile> <destFile>" << std::endl;
 	std::cerr << "  where options are" << std::endl;
 	std::cerr << " --createTangents: convert to tangents mesh is possible." << std::endl;
-	std::cerr << " --format=[irrmesh|collada|stl|obj|ply]: Choose target format" << std::endl;
+	std::cerr << " --optimize: reorder triangles and vertices for faster rendering." << std::endl;
+	std::cerr << " --format=[irrmesh|irrbmesh|collada|stl|obj|ply]: Choose target format" << std::endl;
 }
 
 int main(int argc, char* argv[])
@@ -38,6 +39,7 @@ int main(int argc, char* argv[])
 	scene::EMESH_WRITER_TYPE type = EMWT_IRR_MESH;
 	u32 i=1;
 	bool createTangents=false;
+	bool optimize=false;
 	while (argv[i][0]=='-')
 	{
 		core::stringc format = argv[i];
@@ -46,7 +48,9 @@ int main(int argc, char* argv[])
 			if (format.equalsn("--format=",9))
 			{
 				format = format.subString(9,format.size());
-				if (format=="collada")
+				if (format=="irrbmesh")
+					type = EMWT_IRR_BINARY_MESH;
+				else if (format=="collada")
 					type = EMWT_COLLADA;
 				else if (format=="stl")
 					type = EMWT_STL;
@@ -60,6 +64,9 @@ int main(int argc, char* argv[])
 			else
 			if (format =="--createTangents")
 				createTangents=true;
+			else
+			if (format =="--optimize")
+				optimize=true;
 		}
 		else
 		if (format=="--")
@@ -81,7 +88,7 @@ int main(int argc, char* argv[])
 		return 1;
 	}
 
-	createTangents = createTangents && (type==EMWT_IRR_MESH);
+	createTangents = createTangents && (type==EMWT_IRR_MESH || type==EMWT_IRR_BINARY_MESH);
 	std::cout << "Converting " << argv[srcmesh] << " to " << argv[destmesh] << std::endl;
 	IMesh* mesh = device->getSceneManager()->getMesh(argv[srcmesh])->getMesh(0);
 	if (!mesh)
@@ -89,11 +96,24 @@ int main(int argc, char* argv[])
 		std::cerr << "Could not load " << argv[srcmesh] << std::endl;
 		return 1;
 	}
+	// the mesh is owned by the mesh cache, but replaced meshes are dropped below
+	mesh->grab();
+	IMeshManipulator* manipulator = device->getSceneManager()->getMeshManipulator();
 	if (createTangents)
 	{
-		IMesh* tmp = device->getSceneManager()->getMeshManipulator()->createMeshWithTangents(mesh);
+		IMesh* tmp = manipulator->createMeshWithTangents(mesh);
+		mesh->drop();
+		mesh=tmp;
+	}
+	if (optimize)
+	{
+		const SVertexCacheStatistics before = manipulator->getVertexCacheStatistics(mesh);
+		IMesh* tmp = manipulator->createOptimizedMesh(mesh);
 		mesh->drop();
 		mesh=tmp;
+		const SVertexCacheStatistics after = manipulator->getVertexCacheStatistics(mesh);
+		std::cout << "ACMR " << before.ACMR << " -> " << after.ACMR
+			<< ", ATVR " << before.ATVR << " -> " << after.ATVR << std::endl;
 	}
 	IMeshWriter* mw = device->getSceneManager()->createMeshWriter(type);
 	IWriteFile* file = device->getFileSystem()->createAndWriteFile(argv[destmesh]);
@@ -101,6 +121,7 @@ int main(int argc, char* argv[])
 
 	file->drop();
 	mw->drop();
+	mesh->drop();
 	device->drop();
 
 	return 0;